@@ -34,9 +34,10 @@ using namespace  KKJobManagment;
 KKJob::KKJob (const KKJob&  j):
 
   log                  (j.log),
-  manager              (j.manager),
+  cpuTimeUsed          (j.cpuTimeUsed),
   jobId                (j.jobId),
   parentId             (j.parentId),
+  manager              (j.manager),
   numProcessors        (j.numProcessors),
   numPorcessesAllowed  (j.numPorcessesAllowed),
   prerequisites        (j.prerequisites),
@@ -55,14 +56,15 @@ KKJob::KKJob (JobManagerPtr  _manager,
               RunLog&        _log
              ):
 
-  manager              (_manager),
+  log                  (_log),
+  cpuTimeUsed          (0.0),
   jobId                (_jobId),
   parentId             (_parentId),
+  manager              (_manager),
   numProcessors        (0),
   numPorcessesAllowed  (_numPorcessesAllowed),
   prerequisites        (),
-  status               (jsOpen),
-  log                  (_log)
+  status               (jsOpen)
 
 {
 }
@@ -70,14 +72,15 @@ KKJob::KKJob (JobManagerPtr  _manager,
 
 
 KKJob::KKJob (JobManagerPtr  _manager):
-  manager              (_manager),
+  log                  (_manager->Log ()),
+  cpuTimeUsed          (0.0),
   jobId                (-1),
   parentId             (-1),
+  manager              (_manager),
   numProcessors        (0),
   numPorcessesAllowed  (1),
   prerequisites        (),
-  status               (jsNULL),
-  log                  (_manager->Log ())
+  status               (jsNULL)
 {
 }
 
@@ -154,6 +157,7 @@ void    KKJob::ReFresh (KKJob&  j)
   numPorcessesAllowed  = j.numPorcessesAllowed;
   prerequisites        = j.prerequisites;
   status               = j.status;
+  cpuTimeUsed          = j.cpuTimeUsed;
 }  /* ReFresh */
 
 
@@ -203,6 +207,34 @@ KKStr  KKJob::StatusStr () const
 
 
 
+void  KKJob::AddPrerequisites (kkint32  _prerequisite)
+{
+  if  (!InPrerequisites (_prerequisite))
+    prerequisites.push_back (_prerequisite);
+}
+
+
+
+void  KKJob::AddPrerequisites (VectorInt  _prerequisites)
+{
+  for  (auto  p: _prerequisites)
+    AddPrerequisites (p);
+}
+
+
+
+bool  KKJob::InPrerequisites (kkint32 _jobId)
+{
+  for  (auto  p: prerequisites)
+  {
+    if  (p == _jobId)
+      return  true;
+  }
+  return  false;
+}  /* InPrerequisites */
+
+
+
 KKStr  KKJob::PrerequisitesToStr ()  const
 {
   if  (prerequisites.size () < 1)
@@ -246,7 +278,8 @@ KKStr  KKJob::ToStatusStr ()
             << "Status"               << "\t" << StatusStr ()         << "\t"
             << "NumProcessors"        << "\t" << numProcessors        << "\t"
             << "NumPorcessesAllowed"  << "\t" << numPorcessesAllowed  << "\t"
-            << "Prerequisites"        << "\t" << PrerequisitesToStr ();
+            << "Prerequisites"        << "\t" << PrerequisitesToStr ()   << "\t"
+            << "CpuTimeUsed"          << "\t" << cpuTimeUsed;
 
   return  statusStr;
 }  /* ToStatusStr */
@@ -297,6 +330,9 @@ void  KKJob::ProcessStatusStr (const KKStr&  statusStr)
 
     else  if  (fieldName.CompareIgnoreCase ("Prerequisites") == 0)
       PrerequisitesFromStr (fieldValue);
+
+    else  if  (fieldName.CompareIgnoreCase ("CpuTimeUsed") == 0)
+      cpuTimeUsed = fieldValue.ToDouble ();
       
     else
     {
@@ -334,10 +370,10 @@ void  KKJob::CompletedJobDataRead (istream& i)
 KKJobList::KKJobList (JobManagerPtr  _manager):
 
    KKQueue<KKJob> (true),
-   jobIdLookUpTable    (),
-   jobIdLookUpTableIdx (),
    log                 (_manager->Log ()),
-   manager             (_manager)
+   manager             (_manager),
+   jobIdLookUpTable    (),
+   jobIdLookUpTableIdx ()
 {
 }
 
@@ -345,10 +381,10 @@ KKJobList::KKJobList (JobManagerPtr  _manager):
 
 KKJobList::KKJobList (const KKJobList&  jobs):
      KKQueue<KKJob>      (jobs.Owner ()),
-     jobIdLookUpTable    (),
-     jobIdLookUpTableIdx (),
      log                 (jobs.log),
-     manager             (jobs.manager)
+     manager             (jobs.manager),
+     jobIdLookUpTable    (),
+     jobIdLookUpTableIdx ()
 {
   KKJobList::const_iterator  idx;
   for  (idx = jobs.begin ();  idx != jobs.end ();  idx++)
@@ -82,7 +82,8 @@ namespace  KKJobManagment
     KKJob (JobManagerPtr  _manager);
 
 
-    ~KKJob ();
+    /** @brief  Virtual;  jobs created by 'Duplicate' and the factory are deleted through a 'KKJobPtr'. */
+    virtual  ~KKJob ();
 
 
     /**************************************************************************/
@@ -115,6 +116,7 @@ namespace  KKJobManagment
 
 
     //***************************************** Access Methods **********************************************
+    double             CpuTimeUsed   () const  {return cpuTimeUsed;}  /**< Seconds of CPU spent in 'ProcessNode';  only tracked by 'KKJobManager::RunInProcess'. */
     kkint32            JobId         () const  {return jobId;}
     kkint32            ParentId      () const  {return parentId;}
     JobManagerPtr      Manager       () const  {return manager;}
@@ -123,6 +125,7 @@ namespace  KKJobManagment
     JobStatus          Status        () const  {return status;}
     KKStr              StatusStr     () const;
 
+    void   CpuTimeUsed (double   _cpuTimeUsed)  {cpuTimeUsed = _cpuTimeUsed;}
     void   JobId     (kkint32    _jobId)   {jobId   = _jobId;}
     void   Status    (JobStatus  _status)  {status  = _status;}
 
@@ -203,6 +206,7 @@ namespace  KKJobManagment
 
     void   ProcessStatusStr (const KKStr&  statusStr);
 
+    double          cpuTimeUsed;
     kkint32         jobId;
     kkint32         parentId;
     JobManagerPtr   manager;
@@ -0,0 +1,485 @@
+#include "FirstIncludes.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <iostream>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include <sys/types.h>
+#ifdef  WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "KKBaseTypes.h"
+#include "KKException.h"
+#include "OSservices.h"
+#include "RunLog.h"
+#include "KKStr.h"
+using namespace  KKB;
+
+#include "KKJobCoordinator.h"
+using namespace  KKJobManagment;
+
+
+
+namespace
+{
+  /**
+   * The original scheme;  the lock is held by whoever managed to create 'lockFileName' exclusively.
+   */
+  class  LockFileCoordinator:  public  KKJobCoordinator
+  {
+  public:
+    LockFileCoordinator (const KKStr&  _lockFileName,
+                         kkint32       _procId,
+                         RunLog&       _log
+                        ):
+        KKJobCoordinator (_log),
+        lockFile       (-1),
+        lockFileName   (_lockFileName),
+        lockFileOpened (false),
+        procId         (_procId)
+    {}
+
+    ~LockFileCoordinator ()
+    {
+      if  (lockFileOpened)
+        Unlock ();
+    }
+
+    Backend  BackendUsed ()  const  {return  Backend::LockFile;}
+
+    void  Lock ();
+
+    void  Unlock ();
+
+    void  NotifyChange ()  {}
+
+    void  WaitForChange (float  maxWaitSecs)  {osSleep (maxWaitSecs);}
+
+  private:
+    kkint32  lockFile;
+    KKStr    lockFileName;
+    bool     lockFileOpened;
+    kkint32  procId;
+  };  /* LockFileCoordinator */
+
+
+
+  void  LockFileCoordinator::Lock ()
+  {
+    if  (lockFileOpened)
+    {
+      // We have out Lock and EndLock calls out of order.
+      log.Level (-1)  << endl << endl
+                      << "LockFileCoordinator::Lock      *** WE ALREADY HAVE A BLOCK ESTABLISHED ***." << endl
+                      << endl;
+      return;
+    }
+
+    kkint32  count = 0;
+
+    do  {
+      #ifdef  WIN32
+      lockFile = _open (lockFileName.Str (), O_WRONLY | O_CREAT | O_EXCL);
+      #else
+      lockFile = open (lockFileName.Str (), O_WRONLY | O_CREAT | O_EXCL, 0644);
+      #endif
+      if  (lockFile < 0)
+      {
+        count++;
+        float  zed = (float)((procId + rand ()) % 10) + 2.0f;
+        log.Level (10) << "LockFileCoordinator::Lock - We are locked out[" << count << "]  for [" << zed << "] secs."  << endl;
+        osSleep (zed);
+      }
+    }  while  (lockFile < 0);
+
+    if  (count > 0)
+      log.Level (10) << "LockFileCoordinator::Lock   Lock has been established." << endl;
+
+    lockFileOpened = true;
+  }  /* Lock */
+
+
+
+  void  LockFileCoordinator::Unlock ()
+  {
+    if  (!lockFileOpened)
+    {
+      log.Level (-1) << endl << endl << endl
+                     << "LockFileCoordinator::Unlock          *** Lock file is not opened ***" << endl;
+      return;
+    }
+
+    close (lockFile);
+    lockFileOpened = false;
+
+    #ifdef  WIN32
+    if  (!DeleteFile (lockFileName.Str ()))
+    {
+       DWORD fileAttributes = GetFileAttributes (lockFileName.Str ());
+       fileAttributes = FILE_ATTRIBUTE_NORMAL;
+       if  (!SetFileAttributes (lockFileName.Str (), fileAttributes))
+       {
+         DWORD  lastErrorNum = GetLastError ();
+         log.Level (-1) << "LockFileCoordinator::Unlock - *** ERROR *** Could not set Lock File  to  Normal  lastErrorNum: " << (kkuint64)lastErrorNum << endl;
+       }
+       else
+       {
+         if  (!DeleteFile (lockFileName.Str ()))
+         {
+           DWORD  lastErrorNum = GetLastError ();
+           log.Level (-1) << "LockFileCoordinator::Unlock - Error["  << (kkuint32)lastErrorNum << "] deleting Lock File." << endl;
+         }
+       }
+    }
+    #else
+    if  (unlink (lockFileName.Str ()) != 0)
+      log.Level (-1) << "LockFileCoordinator::Unlock - Error[" << errno << "] deleting Lock File." << endl;
+    #endif
+  }  /* Unlock */
+
+
+
+#if  !defined(WIN32)
+  /**
+   * Lock and change notification through a POSIX shared memory segment that every process working on the same
+   * status file maps.  The mutex is robust so a process that dies while holding it does not leave the others
+   * blocked forever.
+   */
+  class  SharedMemoryCoordinator:  public  KKJobCoordinator
+  {
+  public:
+    SharedMemoryCoordinator (const KKStr&  _statusFileName,
+                             RunLog&       _log
+                            );
+
+    ~SharedMemoryCoordinator ();
+
+    Backend  BackendUsed ()  const  {return  Backend::SharedMemory;}
+
+    void  Lock ();
+
+    void  Unlock ();
+
+    void  NotifyChange ();
+
+    void  WaitForChange (float  maxWaitSecs);
+
+  private:
+    static  const kkuint32  readyMark       = 0x4B4B4A4D;
+    static  const kkint32   maxWaitMiliSecs = 5000;   /**< How long to wait for the creator to size and initialize the segment. */
+
+    struct  SharedState
+    {
+      std::atomic<kkuint32>  ready;          /**< 'readyMark' once the creator has initialized the rest. */
+      pthread_mutex_t        mutex;
+      pthread_cond_t         changed;
+      kkuint64               changeCount;
+    };
+
+    /**
+     *@brief  Opens or creates the segment and maps it.
+     *@returns  false if an existing segment was not sized or initialized within 'maxWaitMiliSecs'.
+     */
+    bool  OpenSegment (bool&  created);
+
+    void  LockMutex ();
+
+    int           fd;
+    KKStr         segmentName;
+    SharedState*  state;
+  };  /* SharedMemoryCoordinator */
+
+
+
+  SharedMemoryCoordinator::SharedMemoryCoordinator (const KKStr&  _statusFileName,
+                                                    RunLog&       _log
+                                                   ):
+      KKJobCoordinator (_log),
+      fd          (-1),
+      segmentName (KKJobCoordinator::SharedMemorySegmentName (_statusFileName)),
+      state       (NULL)
+  {
+    // A process that died between creating the segment and marking it ready leaves one behind that nobody
+    // will ever initialize;  it is removed and created again, but only once.
+    bool  created = false;
+    if  (!OpenSegment (created))
+    {
+      log.Level (-1) << "SharedMemoryCoordinator   ***WARNING***   Segment[" << segmentName << "] was never initialized;  recreating it." << endl;
+      shm_unlink (segmentName.Str ());
+      if  (!OpenSegment (created))
+        throw KKException ("SharedMemoryCoordinator   Segment[" + segmentName + "] was never initialized.");
+    }
+
+    log.Level (10) << "SharedMemoryCoordinator   Segment[" << segmentName << "]  " << (created ? "Created" : "Opened") << endl;
+  }
+
+
+
+  bool  SharedMemoryCoordinator::OpenSegment (bool&  created)
+  {
+    created = true;
+    fd = shm_open (segmentName.Str (), O_RDWR | O_CREAT | O_EXCL, 0666);
+    if  ((fd < 0)  &&  (errno == EEXIST))
+    {
+      created = false;
+      fd = shm_open (segmentName.Str (), O_RDWR, 0666);
+    }
+
+    if  (fd < 0)
+      throw KKException ("SharedMemoryCoordinator   shm_open of[" + segmentName + "] failed;  errno: " + StrFromInt32 (errno));
+
+    if  (created)
+    {
+      if  (ftruncate (fd, sizeof (SharedState)) != 0)
+      {
+        close (fd);  fd = -1;
+        shm_unlink (segmentName.Str ());
+        throw KKException ("SharedMemoryCoordinator   ftruncate of[" + segmentName + "] failed.");
+      }
+    }
+    else
+    {
+      // The creator may still be sizing it;  touching the mapping of a segment that is too small raises SIGBUS.
+      struct stat  st;
+      kkint32  attempts = 0;
+      while  ((fstat (fd, &st) == 0)  &&  ((size_t)st.st_size < sizeof (SharedState))  &&  (attempts < maxWaitMiliSecs))
+      {
+        osSleepMiliSecs (1);
+        ++attempts;
+      }
+      if  ((fstat (fd, &st) != 0)  ||  ((size_t)st.st_size < sizeof (SharedState)))
+      {
+        close (fd);  fd = -1;
+        return  false;
+      }
+    }
+
+    void*  addr = mmap (NULL, sizeof (SharedState), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if  (addr == MAP_FAILED)
+    {
+      close (fd);  fd = -1;
+      throw KKException ("SharedMemoryCoordinator   mmap of[" + segmentName + "] failed;  errno: " + StrFromInt32 (errno));
+    }
+    state = (SharedState*)addr;
+
+    if  (created)
+    {
+      pthread_mutexattr_t  mutexAttr;
+      pthread_mutexattr_init (&mutexAttr);
+      pthread_mutexattr_setpshared (&mutexAttr, PTHREAD_PROCESS_SHARED);
+      pthread_mutexattr_setrobust  (&mutexAttr, PTHREAD_MUTEX_ROBUST);
+      pthread_mutex_init (&state->mutex, &mutexAttr);
+      pthread_mutexattr_destroy (&mutexAttr);
+
+      pthread_condattr_t  condAttr;
+      pthread_condattr_init (&condAttr);
+      pthread_condattr_setpshared (&condAttr, PTHREAD_PROCESS_SHARED);
+      pthread_condattr_setclock   (&condAttr, CLOCK_MONOTONIC);
+      pthread_cond_init (&state->changed, &condAttr);
+      pthread_condattr_destroy (&condAttr);
+
+      state->changeCount = 0;
+      state->ready.store (readyMark, std::memory_order_release);
+    }
+    else
+    {
+      kkint32  attempts = 0;
+      while  ((state->ready.load (std::memory_order_acquire) != readyMark)  &&  (attempts < maxWaitMiliSecs))
+      {
+        osSleepMiliSecs (1);
+        ++attempts;
+      }
+      if  (state->ready.load (std::memory_order_acquire) != readyMark)
+      {
+        munmap (state, sizeof (SharedState));  state = NULL;
+        close (fd);  fd = -1;
+        return  false;
+      }
+    }
+
+    return  true;
+  }  /* OpenSegment */
+
+
+
+  SharedMemoryCoordinator::~SharedMemoryCoordinator ()
+  {
+    // The segment is left in place;  other processes may still be using it and it is tiny.
+    if  (state)
+    {
+      munmap (state, sizeof (SharedState));
+      state = NULL;
+    }
+    if  (fd >= 0)
+    {
+      close (fd);
+      fd = -1;
+    }
+  }
+
+
+
+  void  SharedMemoryCoordinator::LockMutex ()
+  {
+    int  returnCd = pthread_mutex_lock (&state->mutex);
+    if  (returnCd == EOWNERDEAD)
+    {
+      log.Level (-1) << "SharedMemoryCoordinator::Lock   ***WARNING***   Previous holder of the lock died while holding it." << endl;
+      pthread_mutex_consistent (&state->mutex);
+    }
+    else if  (returnCd != 0)
+    {
+      throw KKException ("SharedMemoryCoordinator::Lock   pthread_mutex_lock failed;  returnCd: " + StrFromInt32 (returnCd));
+    }
+  }
+
+
+
+  void  SharedMemoryCoordinator::Lock ()
+  {
+    LockMutex ();
+  }
+
+
+
+  void  SharedMemoryCoordinator::Unlock ()
+  {
+    pthread_mutex_unlock (&state->mutex);
+  }
+
+
+
+  void  SharedMemoryCoordinator::NotifyChange ()
+  {
+    // Caller holds the lock.
+    state->changeCount++;
+    pthread_cond_broadcast (&state->changed);
+  }
+
+
+
+  void  SharedMemoryCoordinator::WaitForChange (float  maxWaitSecs)
+  {
+    struct timespec  deadline;
+    clock_gettime (CLOCK_MONOTONIC, &deadline);
+    kkint64  nanoSecs = deadline.tv_nsec;
+    nanoSecs += (kkint64)((double)maxWaitSecs * 1.0e9);
+    deadline.tv_sec  += (time_t)(nanoSecs / 1000000000LL);
+    deadline.tv_nsec  = (long)(nanoSecs % 1000000000LL);
+
+    LockMutex ();
+    kkuint64  changeCountAtStart = state->changeCount;
+    while  (state->changeCount == changeCountAtStart)
+    {
+      int  returnCd = pthread_cond_timedwait (&state->changed, &state->mutex, &deadline);
+      if  (returnCd == EOWNERDEAD)
+      {
+        pthread_mutex_consistent (&state->mutex);
+        break;
+      }
+      if  (returnCd != 0)
+        break;
+    }
+    pthread_mutex_unlock (&state->mutex);
+  }
+#endif
+}  /* namespace */
+
+
+
+KKJobCoordinator::KKJobCoordinator (RunLog&  _log):
+  log (_log)
+{
+}
+
+
+
+KKJobCoordinator::~KKJobCoordinator ()
+{
+}
+
+
+
+KKStr  KKJobCoordinator::BackendToStr (Backend  backend)
+{
+  if  (backend == Backend::SharedMemory)
+    return  "SharedMemory";
+  else
+    return  "LockFile";
+}
+
+
+
+KKJobCoordinator::Backend  KKJobCoordinator::BackendFromStr (const KKStr&  s)
+{
+  if  (s.EqualIgnoreCase ("SharedMemory")  ||  s.EqualIgnoreCase ("Shm"))
+    return  Backend::SharedMemory;
+  else
+    return  Backend::LockFile;
+}
+
+
+
+KKStr  KKJobCoordinator::SharedMemorySegmentName (const KKStr&  statusFileName)
+{
+  KKStr  fullName = statusFileName;
+  if  (fullName.FirstChar () != '/')
+    fullName = osAddSlash (osGetCurrentDirectory ()) + statusFileName;
+
+  kkuint64  hash = 14695981039346656037ULL;
+  for  (kkuint32 x = 0;  x < fullName.Len ();  ++x)
+  {
+    hash ^= (uchar)fullName[x];
+    hash *= 1099511628211ULL;
+  }
+
+  KKStr  name (48);
+  name << "/KKJobManager." << hash;
+  return  name;
+}  /* SharedMemorySegmentName */
+
+
+
+KKJobCoordinatorPtr  KKJobCoordinator::Create (Backend       backend,
+                                               const KKStr&  lockFileName,
+                                               const KKStr&  statusFileName,
+                                               kkint32       procId,
+                                               RunLog&       log
+                                              )
+{
+  if  (backend == Backend::SharedMemory)
+  {
+#if  defined(WIN32)
+    KKStr  errMsg = "KKJobCoordinator::Create   SharedMemory backend is not supported on this platform;  StatusFile[" + statusFileName + "].";
+    log.Level (-1) << endl << errMsg << endl << endl;
+    throw KKException (errMsg);
+#else
+    try
+    {
+      return  new SharedMemoryCoordinator (statusFileName, log);
+    }
+    catch  (const KKException&  e)
+    {
+      log.Level (-1) << endl
+                     << "KKJobCoordinator::Create   ***ERROR***   " << e.ToString () << endl
+                     << endl;
+      throw KKException ("KKJobCoordinator::Create   SharedMemory backend could not be set up;  " + e.ToString ());
+    }
+#endif
+  }
+
+  return  new LockFileCoordinator (lockFileName, procId, log);
+}  /* Create */
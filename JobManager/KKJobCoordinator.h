@@ -0,0 +1,96 @@
+#ifndef  _KKJOBCOORDINATOR_
+#define  _KKJOBCOORDINATOR_
+
+#include "KKBaseTypes.h"
+#include "RunLog.h"
+#include "KKStr.h"
+
+
+namespace  KKJobManagment
+{
+  /**
+   *@class  KKJobCoordinator
+   *@brief  Mutual exclusion and change notification between the processes that share one 'KKJobManager' job set.
+   *@details  'KKJobManager::Block' and 'KKJobManager::EndBlock' call 'Lock' and 'Unlock';  the status journal
+   * is only appended to while the lock is held.  A process that appended to the journal calls 'NotifyChange'
+   * and a process that has nothing to do calls 'WaitForChange' rather than polling the journal.
+   *
+   * Two backends are provided:
+   *@code
+   *   LockFile      -  The original scheme;  an exclusively created lock file that is retried every 2 to 12
+   *                    seconds, and 'WaitForChange' just sleeps.  Works on any file system, including one shared
+   *                    by several machines.
+   *   SharedMemory  -  A POSIX shared memory segment, named after the status file, holding a process shared
+   *                    robust mutex and condition variable;  waits block until another process releases the
+   *                    lock or reports a change.  Only for processes on the same machine.
+   *@endcode
+   * All processes working on the same job set must use the same backend.  'Create' never substitutes one
+   * backend for another;  a process that quietly fell back to 'LockFile' would not be excluding the processes
+   * holding the shared memory lock.
+   */
+  class  KKJobCoordinator
+  {
+  public:
+    typedef  KKJobCoordinator*  KKJobCoordinatorPtr;
+
+    enum  class  Backend
+    {
+      LockFile,
+      SharedMemory
+    };
+
+    static  KKStr    BackendToStr   (Backend  backend);
+
+    /** @brief  Returns 'Backend::LockFile' for anything it does not recognize. */
+    static  Backend  BackendFromStr (const KKStr&  s);
+
+    /**
+     *@brief  Name of the POSIX shared memory segment the 'SharedMemory' backend uses for 'statusFileName'.
+     *@details  A segment whose creator died before initializing it is removed and created again by the next
+     * process to open it;  one left by a job set that is finished can be removed with 'shm_unlink'.
+     */
+    static  KKStr    SharedMemorySegmentName (const KKStr&  statusFileName);
+
+    /**
+     *@brief  Creates the coordinator for the job set whose status file is 'statusFileName'.
+     *@param[in]  backend         Requested backend;  throws a KKException if 'SharedMemory' can not be set up.
+     *@param[in]  lockFileName    Used by the 'LockFile' backend.
+     *@param[in]  statusFileName  The shared memory segment is named after it.
+     *@param[in]  procId          Process id;  used to stagger lock file retries.
+     */
+    static  KKJobCoordinatorPtr  Create (Backend       backend,
+                                         const KKStr&  lockFileName,
+                                         const KKStr&  statusFileName,
+                                         kkint32       procId,
+                                         RunLog&       log
+                                        );
+
+    virtual  ~KKJobCoordinator ();
+
+    virtual  Backend  BackendUsed ()  const = 0;
+
+    /** @brief  Blocks until this process holds the lock. */
+    virtual  void  Lock () = 0;
+
+    virtual  void  Unlock () = 0;
+
+    /** @brief  Called while holding the lock after appending to the status journal;  wakes up 'WaitForChange'. */
+    virtual  void  NotifyChange () = 0;
+
+    /**
+     *@brief  Called without holding the lock;  returns when another process calls 'NotifyChange' or after
+     * 'maxWaitSecs' seconds, whichever comes first.
+     */
+    virtual  void  WaitForChange (float  maxWaitSecs) = 0;
+
+  protected:
+    KKJobCoordinator (RunLog&  _log);
+
+    RunLog&  log;
+  };  /* KKJobCoordinator */
+
+  typedef  KKJobCoordinator::KKJobCoordinatorPtr  KKJobCoordinatorPtr;
+
+}  /* KKJobManagment */
+
+#endif
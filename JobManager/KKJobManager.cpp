@@ -4,12 +4,17 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 #include <cmath>
+#include <condition_variable>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include "MemoryDebug.h"
 using namespace std;
@@ -24,7 +29,9 @@ using namespace std;
 #endif
 
 #include "KKBaseTypes.h"
+#include "KKException.h"
 #include "KKQueue.h"
+#include "KKWorkStealingPool.h"
 #include "OSservices.h"
 #include "RunLog.h"
 #include "KKStr.h"
@@ -35,6 +42,136 @@ using namespace  KKJobManagment;
 
 
 
+namespace
+{
+  /** CPU seconds used so far by the calling thread. */
+  double  ThreadCpuTimeUsed ()
+  {
+  #ifdef  WIN32
+    FILETIME  creationTime, exitTime, kernelTime, userTime;
+    if  (!GetThreadTimes (GetCurrentThread (), &creationTime, &exitTime, &kernelTime, &userTime))
+      return  0.0;
+    kkuint64  kernel = ((kkuint64)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+    kkuint64  user   = ((kkuint64)userTime.dwHighDateTime   << 32) | userTime.dwLowDateTime;
+    return  (double)(kernel + user) / 1.0e7;
+  #else
+    struct timespec  ts;
+    if  (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+      return  0.0;
+    return  (double)ts.tv_sec + (double)ts.tv_nsec / 1.0e9;
+  #endif
+  }
+
+
+
+  /**
+   * Appends to the status file on a thread of its own;  text passed to 'Add' is written out in batches, at the
+   * latest 'maxDelayMiliSecs' after it was added, so that the caller never waits on the file.
+   */
+  class  AsyncStatusJournal
+  {
+  public:
+    AsyncStatusJournal (const KKStr&  _statusFileName,
+                        RunLog&       _log
+                       ):
+        closing        (false),
+        log            (_log),
+        pending        (),
+        statusFile     (_statusFileName.Str (), ios::app),
+        statusFileName (_statusFileName),
+        writer         (),
+        writeFailed    (false)
+    {
+      if  (!statusFile.is_open ())
+        throw KKException ("AsyncStatusJournal   Can not open Status File[" + statusFileName + "] for append.");
+      writer = std::thread (&AsyncStatusJournal::WriterLoop, this);
+    }
+
+    ~AsyncStatusJournal ()
+    {
+      Close ();
+    }
+
+    void  Add (const string&  text)
+    {
+      if  (text.empty ())
+        return;
+      bool  wakeWriter = false;
+      {
+        lock_guard<std::mutex>  lock (mutex);
+        pending += text;
+        wakeWriter = (pending.size () >= maxPendingBytes);
+      }
+      if  (wakeWriter)
+        pendingAvailable.notify_one ();
+    }
+
+    /** @brief  Writes whatever is still pending and stops the writer thread. */
+    void  Close ()
+    {
+      {
+        lock_guard<std::mutex>  lock (mutex);
+        if  (closing)
+          return;
+        closing = true;
+      }
+      pendingAvailable.notify_one ();
+      if  (writer.joinable ())
+        writer.join ();
+      statusFile.close ();
+
+      if  (writeFailed)
+        log.Level (-1) << "AsyncStatusJournal   ***ERROR***   Writing to Status File[" << statusFileName << "]." << endl;
+    }
+
+  private:
+    static  const size_t    maxPendingBytes  = 64 * 1024;
+    static  const kkuint32  maxDelayMiliSecs = 250;
+
+    void  WriterLoop ()
+    {
+      string  batch;
+      bool    done = false;
+      while  (!done)
+      {
+        {
+          unique_lock<std::mutex>  lock (mutex);
+          pendingAvailable.wait_for (lock, std::chrono::milliseconds (maxDelayMiliSecs),
+                                     [this] {return closing  ||  (pending.size () >= maxPendingBytes);}
+                                    );
+          batch.swap (pending);
+          done = closing;
+        }
+
+        if  (!batch.empty ())
+        {
+          statusFile.write (batch.data (), (std::streamsize)batch.size ());
+          statusFile.flush ();
+          if  (!statusFile.good ())
+            writeFailed = true;
+          batch.clear ();
+        }
+      }
+    }
+
+    bool                     closing;
+    RunLog&                  log;
+    std::mutex               mutex;
+    string                   pending;
+    std::condition_variable  pendingAvailable;
+    ofstream                 statusFile;
+    KKStr                    statusFileName;
+    std::thread              writer;
+    bool                     writeFailed;   /**< Only touched by the writer thread until it has been joined. */
+  };  /* AsyncStatusJournal */
+
+
+  const size_t    AsyncStatusJournal::maxPendingBytes;
+  const kkuint32  AsyncStatusJournal::maxDelayMiliSecs;
+}  /* namespace */
+
+
+
 KKJobManager::KKJobManager (const KKJobManager& j):
   KKJob (j),
 
@@ -45,11 +182,12 @@ KKJobManager::KKJobManager (const KKJobManager& j):
   dateTimeFirstOneFound (j.dateTimeFirstOneFound),
   jobs                  (NULL),
   
-  blockLevel              (j.blockLevel),
-  lockFile                (j.lockFile),
+  blockLevel              (0),
+  coordinationBackend     (j.coordinationBackend),
+  coordinator             (NULL),
   lockFileName            (j.lockFileName),
-  lockFileOpened          (j.lockFileOpened),
   managerName             (j.managerName),
+  supportCompletedJobData (j.supportCompletedJobData),
   expansionCount          (j.expansionCount),
   expansionFirstJobId     (j.expansionFirstJobId),
   nextJobId               (j.nextJobId),
@@ -59,7 +197,8 @@ KKJobManager::KKJobManager (const KKJobManager& j):
   restart                 (j.restart),
   statusFileName          (j.statusFileName),
   statusFileNextByte      (j.statusFileNextByte),
-  supportCompletedJobData (j.supportCompletedJobData)
+  statusJournal           (NULL),
+  statusJournalWritten    (false)
 
 {
   jobs = new KKJobList (*j.jobs);
@@ -78,19 +217,20 @@ KKJobManager::KKJobManager (JobManagerPtr _manager,                   // Ptr to
                            ):
   KKJob (_manager, _jobId, _parentId, _numPorcessesAllowed, _log),
 
-  blockLevel                (0),
   cpuTimeLastReported       (0.0),
   cpuTimeTotalUsed          (0.0),
   dateTimeStarted           (),
   dateTimeEnded             (),
   dateTimeFirstOneFound     (false),
-  expansionCount            (0),
-  expansionFirstJobId       (0),
   jobs                      (NULL),
-  lockFile                  (-1),
+  blockLevel                (0),
+  coordinationBackend       (KKJobCoordinator::Backend::LockFile),
+  coordinator               (NULL),
   lockFileName              (),
-  lockFileOpened            (false),
   managerName               (_managerName),
+  supportCompletedJobData   (false),
+  expansionCount            (0),
+  expansionFirstJobId       (0),
   nextJobId                 (0),
   numJobsAtATime            (_numJobsAtATime),
   procId                    (-1), 
@@ -98,7 +238,8 @@ KKJobManager::KKJobManager (JobManagerPtr _manager,                   // Ptr to
   restart                   (false),
   statusFileName            (),
   statusFileNextByte        (0),
-  supportCompletedJobData   (false)
+  statusJournal             (NULL),
+  statusJournalWritten      (false)
 
 {
   log.Level (10) << "KKJobManager::KKJobManager   ManagerId[" << JobId () << "]" << endl;
@@ -120,6 +261,14 @@ KKJobManager::~KKJobManager ()
 {
   delete  jobs;
   //EndBlock ();
+  if  (statusJournal)
+  {
+    statusJournal->close ();
+    delete  statusJournal;
+    statusJournal = NULL;
+  }
+  delete  coordinator;
+  coordinator = NULL;
 }
 
 
@@ -191,33 +340,21 @@ void    KKJobManager::Block ()
     return;
   }
 
-
-  if  (lockFileOpened)
+  if  (!coordinator)
   {
-    // We have out Lock and EndLock calls out of order.
-    log.Level (-1)  << endl << endl 
-                    << "KKJobManager::Block      *** WE ALREADY HAVE A BLOCK ESTABLISHED ***." << endl
-                    << endl;
-    return;
-  }
-  
-  kkint32  count = 0;
-
-  do  {
-    lockFile = _open (lockFileName.Str (), O_WRONLY | O_CREAT | O_EXCL);
-    if  (lockFile < 0)
+    try
     {
-      count++;
-      float  zed = (float)((procId + rand ()) % 10) + 2.0f;
-      log.Level (10) << "KKJobManager::Block - We are locked out[" << count << "]  for [" << zed << "] secs."  << endl;
-      osSleep (zed);
+      coordinator = KKJobCoordinator::Create (coordinationBackend, lockFileName, statusFileName, procId, log);
     }
-  }  while  (lockFile < 0);
-
-  if  (count > 0)
-    log.Level (10) << "KKJobManager::Block   Lock has been established." << endl;
+    catch  (const KKException&)
+    {
+      blockLevel--;
+      throw;
+    }
+    log.Level (10) << "KKJobManager::Block   Coordination Backend[" << KKJobCoordinator::BackendToStr (coordinator->BackendUsed ()) << "]" << endl;
+  }
 
-  lockFileOpened = true;
+  coordinator->Lock ();
 
   log.Level (20) << "KKJobManager::Block - Lock is Established." << endl;
 }  /* Block */
@@ -228,10 +365,6 @@ void   KKJobManager::EndBlock ()
 {
   blockLevel--;
 
-  #ifndef  WIN32
-  kkint32  returnCd;
-  #endif
-  
    log.Level (20) << "KKJobManager::EndBlock - Ending Block    blockLevel[" << blockLevel << "]" << endl;
 
   if  (blockLevel > 0)
@@ -240,38 +373,24 @@ void   KKJobManager::EndBlock ()
     return;
   }
 
-  if  (!lockFileOpened)
+  if  (!coordinator)
   {
     log.Level (-1) << endl << endl << endl
-                   << "KKJobManager::EndBlock          *** Lock file is not opened ***" << endl;
+                   << "KKJobManager::EndBlock          *** No Block was established ***" << endl;
     return;
   }
 
-  close (lockFile);
-  lockFileOpened = false;
+  // Everything we appended has to be in the file before the other processes are allowed to read it.
+  if  (statusJournal)
+    statusJournal->flush ();
 
-  #ifdef  WIN32
-  if  (!DeleteFile (lockFileName.Str ()))
-  {
-     DWORD fileAttributes = GetFileAttributes (lockFileName.Str ());
-     fileAttributes = FILE_ATTRIBUTE_NORMAL;
-     if  (!SetFileAttributes (lockFileName.Str (), fileAttributes))
-     {
-       DWORD  lastErrorNum = GetLastError ();
-       log.Level (-1) << "KKJobManager::EndBlock - *** ERROR *** Could not set Lock File  to  Normal  lastErrorNum: " << (kkuint64)lastErrorNum << endl;
-     }
-     else
-     {
-       if  (!DeleteFile (lockFileName.Str ()))
-       {
-         DWORD  lastErrorNum = GetLastError ();
-         log.Level (-1) << "KKJobManager::EndBlock - Error["  << (kkuint32)lastErrorNum << "] deleting Lock File." << endl;
-       }
-     }
+  if  (statusJournalWritten)
+  {
+    coordinator->NotifyChange ();
+    statusJournalWritten = false;
   }
-  #else
-  returnCd = unlink (lockFileName.Str ());
-  #endif  
+
+  coordinator->Unlock ();
 
   log.Level (20) << "EndBlock - Unlocking" << endl;
   return;
@@ -330,6 +449,8 @@ void  KKJobManager::StatusFileProcessLine (const KKStr&  ln,
                                            istream&      statusFile
                                           )
 {
+  (void)statusFile;  // Only derived classes that read multi line entries need it.
+
   if  (ln.StartsWith ("//"))
   {
     // A coment line;  we can ignore it.
@@ -347,12 +468,18 @@ void  KKJobManager::StatusFileProcessLine (const KKStr&  ln,
   statusStr.TrimLeft ("\n\r\t ");
   statusStr.TrimRight ("\n\r\t ");
 
-  if  (fieldName.CompareIgnoreCase ("JOB") == 0)
+  if  (fieldName.EqualIgnoreCase ("KKJob")  ||  fieldName.EqualIgnoreCase ("JOB"))
   {
     // We have a KKJob entr line;  the next field determines JobType fllowed by parameters for that JobType constructor.
     KKStr  jobTypeName = fieldName = statusStr.ExtractToken2 ("\t");
 
     KKJobPtr  j = KKJob::CallAppropriateConstructor (this, jobTypeName, statusStr);
+    if  (!j)
+    {
+      log.Level (-1) << "KKJobManager::StatusFileProcessLine   ***ERROR***   No constructor registered for JobType[" << jobTypeName << "]." << endl;
+      return;
+    }
+
     KKJobPtr  existingJob = jobs->LookUpByJobId (j->JobId ());
     if  (existingJob)
     {
@@ -367,8 +494,8 @@ void  KKJobManager::StatusFileProcessLine (const KKStr&  ln,
 
   else if  (fieldName.EqualIgnoreCase ("CPUTIMEUSED"))
   {
-    double  cpuTimeUsed = statusStr.ExtractTokenDouble ("\t");
-    cpuTimeTotalUsed += cpuTimeUsed;
+    double  cpuTimeReported = statusStr.ExtractTokenDouble ("\t");
+    cpuTimeTotalUsed += cpuTimeReported;
   }
 
   else if  (fieldName.EqualIgnoreCase ("CURRENTDATETIME"))
@@ -581,48 +708,61 @@ ofstream*   KKJobManager::StatusFileOpen (ios::openmode  openMode)
 
 
 
+ostream&  KKJobManager::StatusJournal ()
+{
+  if  (!statusJournal)
+    statusJournal = StatusFileOpen (ios::app);
+
+  statusJournalWritten = true;
+  return  *statusJournal;
+}  /* StatusJournal */
+
+
+
 void  KKJobManager::StatusFileWrite ()
 {
   log.Level (10) << "KKJobManager::StatusFileWrite" << endl;
 
-  ofstream*  statusFile = StatusFileOpen (ios::out);
+  // Replaying the journal applies these lines on top of what came before, which leaves every job in the
+  // state written here;  no need to rewrite the file.
+  Block ();
 
-  *statusFile << "// Date/Time [" << osGetLocalDateTime () << "]." << endl
-              << "//" << endl
-              << endl;
+  ostream&  statusFile = StatusJournal ();
 
-  *statusFile << "Status"              << "\t" << KKJob::JobStatusToStr (status)  << endl
-              << "NextJobId"           << "\t" << nextJobId                     << endl
-              << "CurrentDateTime"     << "\t" << osGetLocalDateTime ()         << endl
-              << "ExpansionCount"      << "\t" << expansionCount                << endl
-              << "ExpansionFirstJobId" << "\t" << expansionFirstJobId           << endl
-              << endl;
+  statusFile << "// Date/Time [" << osGetLocalDateTime () << "]." << endl
+             << "//" << endl
+             << endl;
+
+  statusFile << "Status"              << "\t" << KKJob::JobStatusToStr (status)  << endl
+             << "NextJobId"           << "\t" << nextJobId                     << endl
+             << "CurrentDateTime"     << "\t" << osGetLocalDateTime ()         << endl
+             << "ExpansionCount"      << "\t" << expansionCount                << endl
+             << "ExpansionFirstJobId" << "\t" << expansionFirstJobId           << endl
+             << endl;
 
   for  (kkuint32 x = 0;  x < jobs->QueueSize ();  x++)
   {
     KKJobPtr  j = jobs->IdxToPtr (x);
-    *statusFile << "KKJob" << "\t" << j->JobType () << "\t" << j->ToStatusStr () << endl;
+    statusFile << "KKJob" << "\t" << j->JobType () << "\t" << j->ToStatusStr () << endl;
   }
 
-  statusFile->flush ();
-  statusFile->close ();
-  delete  statusFile;
+  EndBlock ();
 
   log.Level (10) << "KKJobManager::StatusFileWrite    Exiting" << endl;
 }  /* StatusFileWrite */
 
 
 
-void  KKJobManager::ReportCpuTimeUsed (ofstream* statusFile)
+void  KKJobManager::ReportCpuTimeUsed (ostream&  statusFile)
 {
   // While we have the status file open lets report CPU time used so far
   double  currentCpuTime = osGetSystemTimeUsed ();
-  double  cpuTimeUsed = currentCpuTime - cpuTimeLastReported;
+  double  cpuTimeSinceReported = currentCpuTime - cpuTimeLastReported;
   cpuTimeLastReported = currentCpuTime;
-  *statusFile << "CpuTimeUsed"     << "\t" << cpuTimeUsed   << "\t"
-              << "ProcId"          << "\t" << procId        << "\t"
-              << endl
-              << "CurrentDateTime" << "\t" << osGetLocalDateTime () << endl;
+  statusFile << "CpuTimeUsed"     << "\t" << cpuTimeSinceReported << "\t"
+             << "ProcId"          << "\t" << procId        << "\t"
+             << endl
+             << "CurrentDateTime" << "\t" << osGetLocalDateTime () << endl;
 }  /* ReportCpuTimeUsed */
 
 
@@ -667,7 +807,12 @@ void  KKJobManager::StatusFileInitialize ()
     jobs = new KKJobList (this);
   }
 
+  // 'JobsCreateInitialSet' allocated job ids;  without this a reload would hand them out again.
+  *statusFile << "NextJobId" << "\t" << nextJobId << endl;
+
   statusFile->flush ();
+  // Everything in the file is already in memory;  'StatusFileRefresh' only needs what other processes add.
+  statusFileNextByte = statusFile->tellp ();
   statusFile->close ();
   delete  statusFile;
 
@@ -717,11 +862,11 @@ void  KKJobManager::ProcessRestart ()
 
   if  (this->Status () != jsDone)
   {
-    ofstream* statusFile = StatusFileOpen (ios::app);
+    ostream&  statusFile = StatusJournal ();
 
     status = KKJob::jsOpen;
-    *statusFile << "ReStart" << endl;
-    *statusFile << "Status"  << "\t" << StatusStr () << endl;
+    statusFile << "ReStart" << endl;
+    statusFile << "Status"  << "\t" << StatusStr () << endl;
 
     KKJobList::iterator  idx;
     for  (idx = jobs->begin ();  idx != jobs->end ();   idx++)
@@ -730,13 +875,9 @@ void  KKJobManager::ProcessRestart ()
       if  (j->Status () == jsStarted)
       {
         j->Status (jsOpen);
-        *statusFile << "JobStatusChange" << "\t" << j->JobId () << "\t" << j->StatusStr () << endl;
+        statusFile << "JobStatusChange" << "\t" << j->JobId () << "\t" << j->StatusStr () << endl;
       }
     }
-
-    statusFile->flush ();
-    statusFile->close ();
-    delete  statusFile;
   }
  
   EndBlock ();
@@ -747,15 +888,11 @@ void  KKJobManager::ProcessRestart ()
 void  KKJobManager::SetQuitRunningFlag ()
 {
   Block ();
-  ofstream* statusFile = StatusFileOpen (ios::app);
+  ostream&  statusFile = StatusJournal ();
 
-  *statusFile << "QuitRunning" << endl;
+  statusFile << "QuitRunning" << endl;
   quitRunning = true;
 
-  statusFile->flush ();
-  statusFile->close ();
-  delete  statusFile;  statusFile = NULL;
-
   EndBlock ();
 }  /* SetQuitRunningFlag */
 
@@ -819,19 +956,19 @@ KKJobListPtr  KKJobManager::GetNextSetOfJobs (KKJobListPtr  completedJobs)
   if  (completedJobs)
   {
     // We will first write out results of jobs that have been completed,
-    ofstream* statusFile = StatusFileOpen (ios::app);
+    ostream&  statusFile = StatusJournal ();
 
     KKJobList::iterator  idx;
     for  (idx = completedJobs->begin ();  idx != completedJobs->end ();  idx++)
     {
       KKJobPtr  j = *idx;
 
-      *statusFile << "KKJob" << "\t" << j->JobType () << "\t" << j->ToStatusStr () << endl;
+      statusFile << "KKJob" << "\t" << j->JobType () << "\t" << j->ToStatusStr () << endl;
       if  (supportCompletedJobData)
       {
-        *statusFile << "<KKJob JobType=" << j->JobType () << ", " << "JobId=" << j->JobId () << ">" << endl;
-        j->CompletedJobDataWrite (*statusFile);
-        *statusFile << "</job>" << endl;
+        statusFile << "<KKJob JobType=" << j->JobType () << ", " << "JobId=" << j->JobId () << ">" << endl;
+        j->CompletedJobDataWrite (statusFile);
+        statusFile << "</job>" << endl;
       }
 
       KKJobPtr  existingJob = jobs->LookUpByJobId (j->JobId ());
@@ -849,9 +986,6 @@ KKJobListPtr  KKJobManager::GetNextSetOfJobs (KKJobListPtr  completedJobs)
         return  NULL;
       }
     }
-
-    statusFile->close ();
-    delete  statusFile;  statusFile = NULL;
   }
   
   KKJobListPtr  jobsToExecute = new KKJobList (this);
@@ -859,8 +993,8 @@ KKJobListPtr  KKJobManager::GetNextSetOfJobs (KKJobListPtr  completedJobs)
 
   if  (!quitRunning)
   {
-    ofstream* statusFile = StatusFileOpen (ios::app);
-
+    // The journal is only touched when there is something to record so that an idle pass does not wake up
+    // the other processes.
     KKJobPtr  nextJob = jobs->LocateOpenJob ();
 
     if  (!nextJob)
@@ -868,7 +1002,7 @@ KKJobListPtr  KKJobManager::GetNextSetOfJobs (KKJobListPtr  completedJobs)
       if  (jobs->AreAllJobsDone ())
       {
         // There are no jobs to do;  we will have to expand some existing jobs then
-        ProcessNextExpansion (*statusFile);
+        ProcessNextExpansion (StatusJournal ());
         nextJob = jobs->LocateOpenJob ();
       }
       else
@@ -887,11 +1021,9 @@ KKJobListPtr  KKJobManager::GetNextSetOfJobs (KKJobListPtr  completedJobs)
     {
       jobsToExecute->PushOnBack (nextJob);
       nextJob->Status (jsStarted);
-      *statusFile << "JobStatusChange" << "\t" << nextJob->JobId () << "\t" << nextJob->StatusStr () << endl;
+      StatusJournal () << "JobStatusChange" << "\t" << nextJob->JobId () << "\t" << nextJob->StatusStr () << endl;
       nextJob = jobs->LocateOpenJob ();
     }
-
-    statusFile->close ();
   }
 
   if  (jobsToExecute->QueueSize () < 1)
@@ -959,9 +1091,10 @@ void   KKJobManager::Run ()
       }
       else
       {
-        // We will sleep for a bit until there are more jobs to run
+        // We will wait for a bit until there are more jobs to run;  another process reporting completed
+        // jobs or expanding the job set will wake us up sooner.
         log.Level (10) << "KKJobManager::Run     No jobs avaialble to run; will sleep a bit." << endl;
-        osSleep ((float)(30 + rand () % 10)); 
+        coordinator->WaitForChange ((float)(30 + rand () % 10));
       }
     }
 
@@ -981,17 +1114,266 @@ void   KKJobManager::Run ()
       
       status = KKJob::jsDone;
     
-      ofstream*  statusFile = StatusFileOpen (ios::app);
+      ostream&  statusFile = StatusJournal ();
 
-      *statusFile << "Status" << "\t" << StatusStr () << endl;
+      statusFile << "Status" << "\t" << StatusStr () << endl;
 
       ReportCpuTimeUsed (statusFile);
-
-      statusFile->close ();
-      delete  statusFile;
     }
   }
   EndBlock ();
 
   log.Level (10) << "KKJobManager::Run    Exiting." << endl;
 }  /* Run */
+
+
+
+void   KKJobManager::RunInProcess (kkuint32  numThreads)
+{
+  log.Level (10) << "KKJobManager::RunInProcess   numThreads[" << numThreads << "]." << endl;
+
+  // Pick up where a previous run left off;  with no other process working on this job set anything still
+  // marked 'Started' belongs to a run that did not finish.
+  Block ();
+  StatusFileRefresh ();
+  for  (auto  j: *jobs)
+  {
+    if  (j->Status () == jsStarted)
+    {
+      j->Status (jsOpen);
+      StatusJournal () << "JobStatusChange" << "\t" << j->JobId () << "\t" << j->StatusStr () << endl;
+    }
+  }
+  EndBlock ();
+
+  struct  CompletedJob
+  {
+    KKJobPtr  job;          /**< Duplicate that 'ProcessNode' was called on. */
+    KKStr     errorText;
+  };
+
+  std::mutex               completedMutex;
+  std::condition_variable  jobCompleted;
+  vector<CompletedJob>     completed;
+  kkuint32                 numRunning = 0;
+  KKStr                    firstError;
+
+  AsyncStatusJournal  journal (statusFileName, log);
+  KKWorkStealingPool  pool ("KKJobManager", numThreads);
+
+  // Each open job is tracked by the number of its prerequisites that are not done yet and moves to 'readyJobs'
+  // when that count reaches zero;  a completed job only touches the jobs that wait on it rather than the whole list.
+  vector<KKJobPtr>         readyJobs;
+  map<kkint32, kkuint32>   pendingPrerequisites;   /**< Keyed by JobId of open jobs still waiting on prerequisites. */
+  map<kkint32, VectorInt>  dependents;             /**< Keyed by JobId of a prerequisite;  the open jobs waiting on it. */
+
+  auto  isDone = [] (KKJobPtr  j) {return  (j->Status () == jsDone)  ||  (j->Status () == jsExpanded);};
+
+  auto  registerOpenJob = [&] (KKJobPtr  j)
+    {
+      kkuint32  numPending = 0;
+      for  (auto  prerequisiteId: j->Prerequisites ())
+      {
+        KKJobPtr  pj = jobs->LookUpByJobId (prerequisiteId);
+        if  (pj  &&  isDone (pj))
+          continue;
+        dependents[prerequisiteId].push_back (j->JobId ());
+        ++numPending;
+      }
+
+      if  (numPending == 0)
+        readyJobs.push_back (j);
+      else
+        pendingPrerequisites[j->JobId ()] = numPending;
+    };
+
+  auto  registerOpenJobs = [&] (kkuint32  firstIdx)
+    {
+      for  (kkuint32 x = firstIdx;  x < jobs->QueueSize ();  ++x)
+      {
+        KKJobPtr  j = jobs->IdxToPtr (x);
+        if  (j->Status () == jsOpen)
+          registerOpenJob (j);
+      }
+    };
+
+  auto  releaseDependents = [&] (kkint32  completedJobId)
+    {
+      auto  idx = dependents.find (completedJobId);
+      if  (idx == dependents.end ())
+        return;
+
+      for  (auto  dependentId: idx->second)
+      {
+        auto  pendingIdx = pendingPrerequisites.find (dependentId);
+        if  ((pendingIdx == pendingPrerequisites.end ())  ||  (--(pendingIdx->second) > 0))
+          continue;
+
+        pendingPrerequisites.erase (pendingIdx);
+        KKJobPtr  dependent = jobs->LookUpByJobId (dependentId);
+        if  (dependent  &&  (dependent->Status () == jsOpen))
+          readyJobs.push_back (dependent);
+      }
+      dependents.erase (idx);
+    };
+
+  auto  startEligibleJobs = [&] ()
+    {
+      vector<KKJobPtr>  toStart;
+      toStart.swap (readyJobs);
+
+      ostringstream  o;
+      for  (auto  j: toStart)
+      {
+        if  (j->Status () != jsOpen)
+          continue;
+
+        j->Status (jsStarted);
+        o << "JobStatusChange" << "\t" << j->JobId () << "\t" << j->StatusStr () << endl;
+
+        KKJobPtr  dup = j->Duplicate ();
+        ++numRunning;
+        pool.AddTask ([dup, &completedMutex, &jobCompleted, &completed] ()
+          {
+            KKStr   errorText;
+            double  cpuTimeAtStart = ThreadCpuTimeUsed ();
+            try
+            {
+              dup->ProcessNode ();
+            }
+            catch  (const KKException&  e)
+            {
+              errorText = e.ToString ();
+            }
+            catch  (const std::exception&  e)
+            {
+              errorText = e.what ();
+            }
+            catch  (...)
+            {
+              errorText = "exception(...) trapped.";
+            }
+            dup->CpuTimeUsed (ThreadCpuTimeUsed () - cpuTimeAtStart);
+
+            CompletedJob  c = {dup, errorText};
+            {
+              lock_guard<std::mutex>  lock (completedMutex);
+              completed.push_back (c);
+            }
+            jobCompleted.notify_one ();
+          }
+        );
+      }
+      journal.Add (o.str ());
+    };
+
+  // Waits for at least one running job to finish and brings the results of all that have into 'jobs'.
+  auto  collectCompletedJobs = [&] ()
+    {
+      vector<CompletedJob>  batch;
+      {
+        unique_lock<std::mutex>  lock (completedMutex);
+        jobCompleted.wait (lock, [&completed] {return !completed.empty ();});
+        batch.swap (completed);
+      }
+
+      ostringstream  o;
+      double  batchCpuTimeUsed = 0.0;
+      for  (auto&  c: batch)
+      {
+        --numRunning;
+        KKJobPtr  existingJob = jobs->LookUpByJobId (c.job->JobId ());
+        if  (!c.errorText.Empty ())
+        {
+          log.Level (-1) << endl
+                         << "KKJobManager::RunInProcess   ***ERROR***   JobId[" << c.job->JobId () << "]  " << c.errorText << endl
+                         << endl;
+          if  (firstError.Empty ())
+            firstError = "JobId[" + StrFromInt32 (c.job->JobId ()) + "]  " + c.errorText;
+        }
+        else if  (existingJob)
+        {
+          // 'ProcessNode' returning normally means the job is done even if it did not say so itself.
+          if  (c.job->Status () == jsStarted)
+            c.job->Status (jsDone);
+
+          existingJob->ReFresh (*c.job);
+          batchCpuTimeUsed += c.job->CpuTimeUsed ();
+
+          if  (isDone (existingJob))
+            releaseDependents (existingJob->JobId ());
+          else if  (existingJob->Status () == jsOpen)
+            registerOpenJob (existingJob);
+
+          o << "KKJob" << "\t" << c.job->JobType () << "\t" << c.job->ToStatusStr () << endl;
+          if  (supportCompletedJobData)
+          {
+            o << "<KKJob JobType=" << c.job->JobType () << ", " << "JobId=" << c.job->JobId () << ">" << endl;
+            c.job->CompletedJobDataWrite (o);
+            o << "</job>" << endl;
+          }
+        }
+        delete  c.job;
+        c.job = NULL;
+      }
+
+      cpuTimeTotalUsed += batchCpuTimeUsed;
+      o << "CpuTimeUsed"     << "\t" << batchCpuTimeUsed << "\t"
+        << "ProcId"          << "\t" << procId           << "\t"
+        << endl
+        << "CurrentDateTime" << "\t" << osGetLocalDateTime () << endl;
+      journal.Add (o.str ());
+    };
+
+  registerOpenJobs (0);
+
+  while  ((!quitRunning)  &&  firstError.Empty ())
+  {
+    startEligibleJobs ();
+
+    if  (numRunning > 0)
+    {
+      collectCompletedJobs ();
+      continue;
+    }
+
+    if  (!jobs->AreAllJobsDone ())
+    {
+      log.Level (-1) << endl
+                     << "KKJobManager::RunInProcess   ***ERROR***   Open jobs remain whose prerequisites can not complete." << endl
+                     << endl;
+      break;
+    }
+
+    // Everything so far is done;  have the derived class expand the next set right away.
+    kkuint32  numJobsBefore = jobs->QueueSize ();
+    ostringstream  o;
+    ProcessNextExpansion (o);
+    journal.Add (o.str ());
+    if  (jobs->QueueSize () == numJobsBefore)
+      break;
+
+    registerOpenJobs (numJobsBefore);
+  }
+
+  while  (numRunning > 0)
+    collectCompletedJobs ();
+
+  pool.WaitForAllTasks ();
+
+  if  ((!quitRunning)  &&  firstError.Empty ()  &&  (status != KKJob::jsDone)  &&  jobs->AreAllJobsDone ())
+  {
+    GenerateFinalResultsReport ();
+    status = KKJob::jsDone;
+    ostringstream  o;
+    o << "Status" << "\t" << StatusStr () << endl;
+    journal.Add (o.str ());
+  }
+
+  journal.Close ();
+
+  log.Level (10) << "KKJobManager::RunInProcess    Exiting   CpuTimeTotalUsed[" << cpuTimeTotalUsed << "]  Steals[" << pool.NumSteals () << "]." << endl;
+
+  if  (!firstError.Empty ())
+    throw KKException ("KKJobManager::RunInProcess   " + firstError);
+}  /* RunInProcess */
@@ -7,6 +7,7 @@ namespace  KKJobManagment
 
 
 #include "KKJob.h"
+#include "KKJobCoordinator.h"
 
 
 #include "RunLog.h"
@@ -25,6 +26,9 @@ namespace  KKJobManagment
    *@details See the application called RandomSplitsJobManager. It is the first application to use 
    *         this library; any class that is derived from this class are required to implement these
    *        method  "StatusFileProcessLine",  "StatusFileProcessLineJobStatusChange", "ToStatusStr"
+   *
+   * The processes sharing a job set coordinate through a 'KKJobCoordinator';  see 'CoordinationBackend'.  The
+   * status file is an append only journal that each process replays from where it last left off.
    */
   class  KKJobManager: public  KKJob
   {
@@ -57,6 +61,16 @@ namespace  KKJobManagment
     virtual  const char*   JobType ()  const;   /**< Allows us to know which specific implementation of 'KKJob'  an instance really is. */
 
 
+    /**
+     *@brief  How the processes working on this job set are coordinated;  defaults to 'LockFile'.
+     *@details  Must be set before 'InitilizeJobManager' and be the same for every process of the job set.
+     * 'SharedMemory' is opt in;  only select it when every process runs on the same machine, never when the
+     * status file is shared by several machines.
+     */
+    KKJobCoordinator::Backend  CoordinationBackend () const  {return  coordinationBackend;}
+
+    void          CoordinationBackend (KKJobCoordinator::Backend  _coordinationBackend)  {coordinationBackend = _coordinationBackend;}
+
     bool          SupportCompletedJobData () const  {return  supportCompletedJobData;}
 
     void          SupportCompletedJobData (bool  _supportCompletedJobData)  {supportCompletedJobData = _supportCompletedJobData;}
@@ -83,6 +97,22 @@ namespace  KKJobManagment
     void          Restart ();
   
     void          Run ();
+
+    /**
+     *@brief  Alternative to 'Run' that executes the jobs on a pool of threads within this process.
+     *@details  Meant for a single many core machine and many short jobs, where the start up, status file and
+     * locking overhead of running each job through its own process dominates.  Jobs whose prerequisites are
+     * done are handed to a 'KKWorkStealingPool' as soon as they become eligible and the next set of jobs is
+     * expanded as soon as the last running one finishes.  'ProcessNode' is called on a duplicate of each job;
+     * the result is brought back into 'Jobs' through 'ReFresh' on this thread, so derived classes see the same
+     * sequence of calls as with 'Run'.  The CPU time of each job is recorded in 'KKJob::CpuTimeUsed'.
+     *
+     * Status file updates are batched and written by a background thread so that a crashed run can be
+     * restarted from where it left off;  jobs left 'Started' by such a run are reopened.  No other process may
+     * work on the same job set while this is running.
+     *@param[in]  numThreads  Number of worker threads;  zero indicates one per processor.
+     */
+    void          RunInProcess (kkuint32  numThreads);
   
     void          SetQuitRunningFlag ();
 
@@ -126,7 +156,7 @@ namespace  KKJobManagment
     //****************************************************************************************
     //*   Status File Routines.
 
-    void    ReportCpuTimeUsed (ofstream* statusFile);
+    void    ReportCpuTimeUsed (ostream&  statusFile);
 
     void    StatusFileInitialize ();
 
@@ -140,7 +170,14 @@ namespace  KKJobManagment
   
     void       StatusFileRefresh ();  /**< Will read in any changes from status file since last call.  */
 
-    void       StatusFileWrite   ();  /**< Will rewrite the status file from scratch;  the old one will be deleted.  */
+    void       StatusFileWrite   ();  /**< Appends the current state of every job to the status journal.  */
+
+    /**
+     *@brief  Stream that appends to the status file;  only to be used inside a 'Block' - 'EndBlock' pair.
+     *@details  It is kept open between blocks;  'EndBlock' flushes it and tells the other processes about the
+     * change before giving up the lock.
+     */
+    ostream&   StatusJournal ();
 
 
   protected:
@@ -191,9 +228,9 @@ namespace  KKJobManagment
                                            */
   
     kkint32         blockLevel;           /**< Starts at 0; increments with each Call to 'Block'  and  decrements with 'EndBlock'  */
-    kkint32         lockFile;
+    KKJobCoordinator::Backend  coordinationBackend;
+    KKJobCoordinatorPtr        coordinator;   /**< Created by the first 'Block'. */
     KKStr           lockFileName;
-    bool            lockFileOpened;
 
     KKStr           managerName;
     bool            supportCompletedJobData;  /**< If set to 'true' will call 'WriteCompletedJobData' after each job is completed. */
@@ -209,6 +246,8 @@ namespace  KKJobManagment
   
     KKStr           statusFileName;
     kkint64         statusFileNextByte;       /**< Byte offset of next byte to read from status file.  */
+    ofstream*       statusJournal;            /**< Status file opened for append;  see 'StatusJournal'. */
+    bool            statusJournalWritten;     /**< Something was appended since the last 'EndBlock'. */
   
   };  /* KKJobManager */
   
@@ -72,64 +72,56 @@ union  BmpImage::LongParts
 
 
 
-void  RotateWORD (WORD&  w)
-{
-  BmpImage::WordParts& wp = reinterpret_cast<BmpImage::WordParts&>(w);
-
-  BmpImage::WordParts  temp = wp;
-
-  wp.parts.c1 = temp.parts.c2;
-  wp.parts.c2 = temp.parts.c1;
-}  /* RotateWORD */
-
+// BMP files are little-endian whatever the host is, and the structures in "BMPheader.h" are not packed, so
+// outside of Windows each field is written and read a byte at a time.
 
-
-void  RotateDWORD (DWORD&  w)
+void  WriteWORD (FILE*  outFile, WORD w)
 {
-  BmpImage::DWordParts& wp = reinterpret_cast<BmpImage::DWordParts&>(w);
+  uchar  bytes[2] = {(uchar)(w & 0xFF), (uchar)((w >> 8) & 0xFF)};
+  std::fwrite (bytes, 1, sizeof (bytes), outFile);
+}
 
-  BmpImage::DWordParts  temp = wp;
 
-  wp.parts.c1 = temp.parts.c4;
-  wp.parts.c2 = temp.parts.c3;
-  wp.parts.c3 = temp.parts.c2;
-  wp.parts.c4 = temp.parts.c1;
-}  /* RotateDWORD */
+void  WriteDWORD (FILE*  outFile,  DWORD dw)
+{
+  uchar  bytes[4] = {(uchar)(dw & 0xFF), (uchar)((dw >> 8) & 0xFF), (uchar)((dw >> 16) & 0xFF), (uchar)((dw >> 24) & 0xFF)};
+  std::fwrite (bytes, 1, sizeof (bytes), outFile);
+}
 
 
 
-void  RotateLONG (LONG&  l)
+void  WriteLONG (FILE*  outFile, LONG l)
 {
-  BmpImage::LongParts& lp = reinterpret_cast<BmpImage::LongParts&>(l);
-
-  BmpImage::LongParts  temp = lp;
-
-  lp.parts.c1 = temp.parts.c4;
-  lp.parts.c2 = temp.parts.c3;
-  lp.parts.c3 = temp.parts.c2;
-  lp.parts.c4 = temp.parts.c1;
-}  /* RotateLONG */
+  WriteDWORD (outFile, (DWORD)l);
+}
 
 
-void  WriteWORD (FILE*  outFile, WORD w)
+bool  ReadDWORD (FILE*  inFile, DWORD&  dw)
 {
-  RotateWORD (w);
-  std::fwrite (&w,  sizeof (w), 1ul, outFile);
+  uchar  bytes[4];
+  if  (std::fread (bytes, 1, sizeof (bytes), inFile) < sizeof (bytes))
+    return false;
+  dw = (DWORD)bytes[0]  |  ((DWORD)bytes[1] << 8)  |  ((DWORD)bytes[2] << 16)  |  ((DWORD)bytes[3] << 24);
+  return true;
 }
 
 
-void  WriteDWORD (FILE*  outFile,  DWORD dw)
+bool  ReadWORD (FILE*  inFile, WORD&  w)
 {
-  RotateDWORD (dw);
-  std::fwrite (&dw,  sizeof (dw), 1, outFile);
+  uchar  bytes[2];
+  if  (std::fread (bytes, 1, sizeof (bytes), inFile) < sizeof (bytes))
+    return false;
+  w = (WORD)(bytes[0]  |  (bytes[1] << 8));
+  return true;
 }
 
 
-
-void  WriteLONG (FILE*  outFile, LONG l)
+bool  ReadLONG (FILE*  inFile, LONG&  l)
 {
-  RotateLONG (l);
-  std::fwrite (&l,  sizeof (l), 1, outFile);
+  DWORD  dw = 0;
+  bool  ok = ReadDWORD (inFile, dw);
+  l = (LONG)dw;
+  return ok;
 }
 
 
@@ -470,7 +462,16 @@ BmpImage::BmpImage (const KKStr&  _fileName,
 
   kkint32  y;
 
-  if (std::fread (&hdr, sizeof (hdr), 1, inFile) <= 0)
+  #ifndef  WIN32
+  bool  hdrRead = ReadWORD  (inFile, hdr.bfType)       &&
+                  ReadDWORD (inFile, hdr.bfSize)       &&
+                  ReadWORD  (inFile, hdr.bfReserved1)  &&
+                  ReadWORD  (inFile, hdr.bfReserved2)  &&
+                  ReadDWORD (inFile, hdr.bfOffBits);
+  #else
+  bool  hdrRead = (std::fread (&hdr, sizeof (hdr), 1, inFile) > 0);
+  #endif
+  if  (!hdrRead)
   {
     successfull = false;
     std::fclose (inFile);
@@ -479,6 +480,10 @@ BmpImage::BmpImage (const KKStr&  _fileName,
 
   uchar  buff[4];
   memcpy (buff, &hdr, sizeof (buff));
+  #ifndef  WIN32
+  buff[0] = (uchar)(hdr.bfType & 0xFF);
+  buff[1] = (uchar)(hdr.bfType >> 8);
+  #endif
   if  ((buff[0] == 'B')  &&  (buff[1] == 'M'))
   {
     // We have a Bit Map file.
@@ -503,7 +508,22 @@ BmpImage::BmpImage (const KKStr&  _fileName,
     return;
   }
   
-  if  (std::fread (&bmh, sizeof (bmh), 1, inFile) <= 0)
+  #ifndef  WIN32
+  bool  bmhRead = ReadDWORD (inFile, bmh.biSize)           &&
+                  ReadLONG  (inFile, bmh.biWidth)          &&
+                  ReadLONG  (inFile, bmh.biHeight)         &&
+                  ReadWORD  (inFile, bmh.biPlanes)         &&
+                  ReadWORD  (inFile, bmh.biBitCount)       &&
+                  ReadDWORD (inFile, bmh.biCompression)    &&
+                  ReadDWORD (inFile, bmh.biSizeImage)      &&
+                  ReadLONG  (inFile, bmh.biXPelsPerMeter)  &&
+                  ReadLONG  (inFile, bmh.biYPelsPerMeter)  &&
+                  ReadDWORD (inFile, bmh.biClrUsed)        &&
+                  ReadDWORD (inFile, bmh.biClrImportant);
+  #else
+  bool  bmhRead = (std::fread (&bmh, sizeof (bmh), 1, inFile) > 0);
+  #endif
+  if  (!bmhRead)
   {
     successfull = false;
     std::fclose (inFile);
@@ -1424,7 +1444,7 @@ void  BmpImage::Load8BitColor (FILE*  inFile,
   paletteEntries = numOfColors;
   AllocateRaster ();
 
-  std::fseek (inFile, sizeof (hdr) + sizeof (bmh), SEEK_SET);
+  std::fseek (inFile, 14 + 40, SEEK_SET);   // Size of the file and information headers as stored in the file.
   std::fread (palette, sizeof (RGBQUAD), tosize_t (paletteEntries), inFile);
 
   kkint32 height = toint32_t (bmh.biHeight);
@@ -0,0 +1,294 @@
+/* BinaryContainer.cpp -- Versioned binary file of named, aligned arrays that is read through a memory mapping.
+ * Copyright (C) 1994-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#include "FirstIncludes.h"
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string.h>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#include "BinaryContainer.h"
+#include "KKException.h"
+#include "MemoryMappedFile.h"
+using namespace KKB;
+
+
+
+const char  BinaryContainer::Magic[8] = {'K', 'K', 'B', 'I', 'N', 'C', 'N', 0};
+
+
+
+BinaryContainer::BinaryContainer (const KKStr&  _fileName):
+    data          (NULL),
+    fileName      (_fileName),
+    fileSize      (0),
+    mapping       (NULL),
+    references    (1),
+    sectionIndex  ()
+{
+  MapFile ();
+  try
+  {
+    Validate ();
+  }
+  catch  (...)
+  {
+    UnMapFile ();
+    throw;
+  }
+}
+
+
+
+BinaryContainer::~BinaryContainer ()
+{
+  UnMapFile ();
+}
+
+
+
+void  BinaryContainer::Reference ()  const
+{
+  ++references;
+}
+
+
+
+void  BinaryContainer::Release (const BinaryContainer*&  container)
+{
+  if  (!container)
+    return;
+
+  if  (--(container->references) == 0)
+    delete  container;
+  container = NULL;
+}  /* Release */
+
+
+
+void  BinaryContainer::Release (BinaryContainerPtr&  container)
+{
+  const BinaryContainer*  c = container;
+  Release (c);
+  container = NULL;
+}
+
+
+
+void  BinaryContainer::MapFile ()
+{
+  mapping = new MemoryMappedFile (fileName);
+  if  (mapping->Size () < sizeof (FileHeader))
+  {
+    UnMapFile ();
+    KKCheck (false, "BinaryContainer::MapFile   File too small: " << fileName)
+  }
+  data     = (const char*)mapping->Data ();
+  fileSize = mapping->Size ();
+}  /* MapFile */
+
+
+
+void  BinaryContainer::UnMapFile ()
+{
+  delete  mapping;
+  mapping = NULL;
+  data    = NULL;
+}  /* UnMapFile */
+
+
+
+void  BinaryContainer::Validate ()
+{
+  const FileHeader*  header = (const FileHeader*)data;
+
+  KKCheck (memcmp (header->magic, Magic, sizeof (Magic)) == 0,
+           "BinaryContainer::Validate   Not a binary container: " << fileName)
+
+  KKCheck (header->byteOrderMark == ByteOrderMark,
+           "BinaryContainer::Validate   Written on a machine with a different byte order: " << fileName)
+
+  KKCheck (header->version == CurrentVersion,
+           "BinaryContainer::Validate   Unsupported version: " << header->version << "  File: " << fileName)
+
+  KKCheck (header->fileSize == fileSize,
+           "BinaryContainer::Validate   File is truncated or incomplete: " << fileName)
+
+  kkuint64  tableOffset = header->sectionTableOffset;
+  kkuint64  numSections = header->numSections;
+  KKCheck ((tableOffset % SectionAlignment) == 0  &&  tableOffset <= fileSize  &&
+           numSections <= (fileSize - tableOffset) / sizeof (SectionEntry),
+           "BinaryContainer::Validate   Invalid section table: " << fileName)
+
+  const SectionEntry*  table = (const SectionEntry*)(data + tableOffset);
+  for  (kkuint64 x = 0;  x < numSections;  ++x)
+  {
+    const SectionEntry&  s = table[x];
+    KKCheck (s.name[sizeof (s.name) - 1] == 0  &&  s.typeName[sizeof (s.typeName) - 1] == 0,
+             "BinaryContainer::Validate   Invalid section name: " << fileName)
+
+    bool  inFile = ((s.offset % SectionAlignment) == 0)  &&
+                   (s.offset <= tableOffset)             &&
+                   ((s.elementSize == 0)  ||  (s.count <= (tableOffset - s.offset) / s.elementSize));
+    KKCheck (inFile, "BinaryContainer::Validate   Section[" << s.name << "] extends past end of data: " << fileName)
+
+    sectionIndex[s.name] = &s;
+  }
+}  /* Validate */
+
+
+
+const BinaryContainer::SectionEntry*  BinaryContainer::LookUp (const KKStr&  name)  const
+{
+  auto  idx = sectionIndex.find (name);
+  if  (idx == sectionIndex.end ())
+    return NULL;
+  else
+    return idx->second;
+}
+
+
+
+BinaryContainerWriter::BinaryContainerWriter (const KKStr&  _fileName):
+    closed       (false),
+    f            (),
+    fileName     (_fileName),
+    nextArrayNum (0),
+    sections     ()
+{
+  f.open (fileName.Str (), ios_base::out | ios_base::binary | ios_base::trunc);
+  KKCheck (f.is_open (), "BinaryContainerWriter   Could not create: " << fileName)
+
+  // Header is rewritten with its final contents by 'Close'.
+  BinaryContainer::FileHeader  header;
+  memset (&header, 0, sizeof (header));
+  f.write ((const char*)&header, sizeof (header));
+  PadToAlignment ();
+}
+
+
+
+BinaryContainerWriter::~BinaryContainerWriter ()
+{
+  if  (!closed)
+  {
+    try  {Close ();}  catch  (const KKException&)  {}
+  }
+}
+
+
+
+void  BinaryContainerWriter::PadToAlignment ()
+{
+  static const char  zeros[BinaryContainer::SectionAlignment] = {0};
+  kkuint64  pos = (kkuint64)f.tellp ();
+  kkuint64  padding = (BinaryContainer::SectionAlignment - (pos % BinaryContainer::SectionAlignment)) % BinaryContainer::SectionAlignment;
+  if  (padding > 0)
+    f.write (zeros, (streamsize)padding);
+}
+
+
+
+KKStr  BinaryContainerWriter::AddArray (const KKStr&  typeName,
+                                        kkuint32      elementSize,
+                                        kkuint64      count,
+                                        const void*   elements
+                                       )
+{
+  KKStr  name (typeName.Len () + 12);
+  name << typeName << "_" << nextArrayNum;
+  ++nextArrayNum;
+  AddSection (name, typeName, elementSize, count, elements);
+  return  name;
+}
+
+
+
+void  BinaryContainerWriter::AddSection (const KKStr&  name,
+                                         const KKStr&  typeName,
+                                         kkuint32      elementSize,
+                                         kkuint64      count,
+                                         const void*   elements
+                                        )
+{
+  KKCheck (!closed, "BinaryContainerWriter::AddSection   Already closed: " << fileName)
+
+  BinaryContainer::SectionEntry  s;
+  memset (&s, 0, sizeof (s));
+
+  KKCheck (name.Len () < sizeof (s.name)  &&  typeName.Len () < sizeof (s.typeName),
+           "BinaryContainerWriter::AddSection   Name too long: " << name << "  " << typeName)
+
+  for  (auto& existing: sections)
+    KKCheck (name != existing.name, "BinaryContainerWriter::AddSection   Duplicate section: " << name)
+
+  memcpy (s.name,     name.Str (),     name.Len ());
+  memcpy (s.typeName, typeName.Str (), typeName.Len ());
+  s.elementSize = elementSize;
+  s.count       = count;
+  s.offset      = (kkuint64)f.tellp ();
+
+  if  (count > 0)
+    f.write ((const char*)elements, (streamsize)(count * elementSize));
+  PadToAlignment ();
+
+  KKCheck (f.good (), "BinaryContainerWriter::AddSection   Error writing: " << fileName)
+  sections.push_back (s);
+}  /* AddSection */
+
+
+
+void  BinaryContainerWriter::Close ()
+{
+  if  (closed)
+    return;
+  closed = true;
+
+  BinaryContainer::FileHeader  header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, BinaryContainer::Magic, sizeof (header.magic));
+  header.version            = BinaryContainer::CurrentVersion;
+  header.byteOrderMark      = BinaryContainer::ByteOrderMark;
+  header.numSections        = sections.size ();
+  header.sectionTableOffset = (kkuint64)f.tellp ();
+
+  if  (!sections.empty ())
+    f.write ((const char*)sections.data (), (streamsize)(sections.size () * sizeof (BinaryContainer::SectionEntry)));
+  header.fileSize = (kkuint64)f.tellp ();
+
+  f.seekp (0);
+  f.write ((const char*)&header, sizeof (header));
+  bool  ok = f.good ();
+  f.close ();
+
+  KKCheck (ok, "BinaryContainerWriter::Close   Error writing: " << fileName)
+}  /* Close */
+
+
+
+int  BinaryContainerWriter::StreamIndex ()
+{
+  static const int  streamIndex = ios_base::xalloc ();
+  return streamIndex;
+}
+
+
+
+void  BinaryContainerWriter::Attach (ostream&                  o,
+                                     BinaryContainerWriterPtr  writer
+                                    )
+{
+  o.pword (StreamIndex ()) = writer;
+}
+
+
+
+BinaryContainerWriterPtr  BinaryContainerWriter::AttachedTo (ostream&  o)
+{
+  return  (BinaryContainerWriterPtr)o.pword (StreamIndex ());
+}
@@ -0,0 +1,188 @@
+/* BinaryContainer.h -- Versioned binary file of named, aligned arrays that is read through a memory mapping.
+ * Copyright (C) 1994-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#if  !defined(_KKB_BINARYCONTAINER_)
+#define  _KKB_BINARYCONTAINER_
+
+WarningsLowered()
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <vector>
+WarningsRestored()
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "MemoryMappedFile.h"
+
+
+namespace KKB
+{
+  /**
+   *@class  BinaryContainer
+   *@brief  Read only access to a file written by 'BinaryContainerWriter';  the file is memory mapped and its
+   * sections are used in place.
+   *@details  The file consists of a 'FileHeader', the section data and a table of 'SectionEntry' records.  Every
+   * section starts on a 'SectionAlignment' byte boundary so a pointer to its data can be used directly as an array
+   * of the type it was written from.  A section is identified by name and carries the name and size of its element
+   * type so that the reader can verify that it is interpreting it the same way it was written.
+   *
+   * The file is only usable by a build with the same byte order as the one that wrote it;  the constructor
+   * checks for this along with the magic number and version.
+   *
+   * Objects that keep pointers into the mapping beyond the life of whoever opened it call 'Reference' and later
+   * 'Release';  the mapping is removed when the last reference is released.
+   */
+  class  BinaryContainer
+  {
+  public:
+    typedef  BinaryContainer*  BinaryContainerPtr;
+
+    static  const kkuint32  CurrentVersion   = 1;
+    static  const kkuint32  ByteOrderMark    = 0x01020304;
+    static  const kkuint32  SectionAlignment = 64;
+    static  const char      Magic[8];
+
+    struct  FileHeader
+    {
+      char      magic[8];
+      kkuint32  version;
+      kkuint32  byteOrderMark;
+      kkuint64  numSections;
+      kkuint64  sectionTableOffset;
+      kkuint64  fileSize;
+    };
+
+    struct  SectionEntry
+    {
+      char      name[48];
+      char      typeName[32];
+      kkuint32  elementSize;
+      kkuint32  reserved;
+      kkuint64  count;
+      kkuint64  offset;        /**< From start of file;  multiple of 'SectionAlignment'. */
+    };
+
+    /**
+     *@brief  Maps 'fileName' and validates its header and section table;  throws 'KKException' if the file can
+     * not be mapped or was not written by a compatible 'BinaryContainerWriter'.
+     *@details  The new instance has one reference;  dispose of it with 'Release' rather than delete.
+     */
+    BinaryContainer (const KKStr&  _fileName);
+
+    void  Reference ()  const;
+
+    /** @brief  Removes one reference to 'container' and deletes it when there are none left;  'container' is set to NULL. */
+    static  void  Release (const BinaryContainer*&  container);
+
+    static  void  Release (BinaryContainerPtr&  container);
+
+    const KKStr&  FileName    ()  const  {return fileName;}
+    kkuint64      FileSize    ()  const  {return fileSize;}
+    kkuint32      NumSections ()  const  {return (kkuint32)sectionIndex.size ();}
+
+    /** @brief  Returns the section named 'name' or NULL if there is none. */
+    const SectionEntry*  LookUp (const KKStr&  name)  const;
+
+    /** @brief  Returns the first byte of 'section';  valid as long as this instance is. */
+    const void*  SectionData (const SectionEntry&  section)  const  {return data + section.offset;}
+
+  private:
+    ~BinaryContainer ();
+
+    BinaryContainer (const BinaryContainer&);
+    BinaryContainer&  operator= (const BinaryContainer&);
+
+    void  MapFile ();
+    void  UnMapFile ();
+    void  Validate ();
+
+    const char*                                data;
+    KKStr                                      fileName;
+    kkuint64                                   fileSize;
+    MemoryMappedFilePtr                        mapping;
+    mutable std::atomic<kkint32>               references;
+    std::map<KKStr, const SectionEntry*>       sectionIndex;
+  };  /* BinaryContainer */
+
+  typedef  BinaryContainer::BinaryContainerPtr  BinaryContainerPtr;
+  typedef  const BinaryContainer*  BinaryContainerConstPtr;
+
+
+
+  /**
+   *@class  BinaryContainerWriter
+   *@brief  Writes the file read by 'BinaryContainer'.
+   *@details  Sections are streamed to the file as they are added;  'Close' writes the section table and completes
+   * the header.  A writer can be attached to a 'std::ostream' with 'Attach';  array types that support it, such as
+   * 'XmlElementArray', then write their data to a section of the attached writer and only a reference to it to the
+   * stream.
+   */
+  class  BinaryContainerWriter
+  {
+  public:
+    typedef  BinaryContainerWriter*  BinaryContainerWriterPtr;
+
+    /** @brief  Creates 'fileName';  throws 'KKException' if it can not be. */
+    BinaryContainerWriter (const KKStr&  _fileName);
+
+    ~BinaryContainerWriter ();
+
+    /**
+     *@brief  Adds a section with a name generated from 'typeName' and returns the name.
+     *@param[in]  typeName     Identifies the element type;  checked by whoever reads the section back.
+     *@param[in]  elementSize  sizeof of one element.
+     *@param[in]  count        Number of elements.
+     *@param[in]  elements     'count' elements;  may be NULL when 'count' is zero.
+     */
+    KKStr  AddArray (const KKStr&  typeName,
+                     kkuint32      elementSize,
+                     kkuint64      count,
+                     const void*   elements
+                    );
+
+    /** @brief  Adds a section named 'name';  throws 'KKException' if the name is already in use. */
+    void  AddSection (const KKStr&  name,
+                      const KKStr&  typeName,
+                      kkuint32      elementSize,
+                      kkuint64      count,
+                      const void*   elements
+                     );
+
+    /** @brief  Writes the section table and header;  throws 'KKException' if the file could not be written. */
+    void  Close ();
+
+    const KKStr&  FileName ()  const  {return fileName;}
+
+    /** @brief  Attaches 'writer' to 'o';  pass NULL to detach. */
+    static  void  Attach (std::ostream&             o,
+                          BinaryContainerWriterPtr  writer
+                         );
+
+    /** @brief  Returns the writer attached to 'o' or NULL if there is none. */
+    static  BinaryContainerWriterPtr  AttachedTo (std::ostream&  o);
+
+  private:
+    BinaryContainerWriter (const BinaryContainerWriter&);
+    BinaryContainerWriter&  operator= (const BinaryContainerWriter&);
+
+    void  PadToAlignment ();
+
+    static  int  StreamIndex ();
+
+    bool                                        closed;
+    std::ofstream                               f;
+    KKStr                                       fileName;
+    kkuint32                                    nextArrayNum;
+    std::vector<BinaryContainer::SectionEntry>  sections;
+  };  /* BinaryContainerWriter */
+
+  typedef  BinaryContainerWriter::BinaryContainerWriterPtr  BinaryContainerWriterPtr;
+
+#define  _BinaryContainer_Defined_
+
+}  /* KKB */
+
+#endif
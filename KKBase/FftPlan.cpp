@@ -0,0 +1,65 @@
+/* FftPlan.cpp -- Mixed radix Fast Fourier Transform of any length.
+ * Copyright (C) 2012-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#include "FirstIncludes.h"
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#include "FftPlan.h"
+#include "KKThreadPool.h"
+using namespace KKB;
+
+
+namespace
+{
+  std::atomic<kkuint32>  fftNumThreads (1);
+
+  /** Rows or columns times their length below which starting threads costs more than it saves. */
+  const kkuint64  fftMinParallelWork = 64 * 1024;
+}
+
+
+
+kkuint32  KKB::FftNumThreads ()
+{
+  return  fftNumThreads;
+}
+
+
+
+void  KKB::FftSetNumThreads (kkuint32  numThreads)
+{
+  fftNumThreads = numThreads;
+}
+
+
+
+void  KKB::FftParallelFor (kkuint32                                  count,
+                           kkuint32                                  size,
+                           std::function<void (kkuint32, kkuint32)>  body
+                          )
+{
+  kkuint32  numThreads = KKThreadPool::ResolveNumThreads (fftNumThreads);
+  if  ((numThreads <= 1)  ||  (count < 2)  ||  (((kkuint64)count * (kkuint64)size) < fftMinParallelWork))
+  {
+    body (0, count);
+    return;
+  }
+
+  // A few ranges per thread so that threads that finish early pick up more.
+  kkuint32  numRanges = Min (count, 4 * numThreads);
+  KKThreadPool::ParallelFor (numThreads, numRanges,
+    [count, numRanges, &body] (kkuint32 rangeIdx)
+    {
+      kkuint32  first = (kkuint32)(((kkuint64)count * rangeIdx)       / numRanges);
+      kkuint32  last  = (kkuint32)(((kkuint64)count * (rangeIdx + 1)) / numRanges);
+      if  (first < last)
+        body (first, last);
+    }
+  );
+}  /* FftParallelFor */
@@ -0,0 +1,585 @@
+/* FftPlan.h -- Mixed radix Fast Fourier Transform of any length.
+ * Copyright (C) 2012-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#if  !defined(_KKB_FFTPLAN_)
+#define  _KKB_FFTPLAN_
+
+WarningsLowered()
+#include <complex>
+#include <functional>
+#include <map>
+#include <math.h>
+#include <mutex>
+#include <vector>
+WarningsRestored()
+
+#include "KKBaseTypes.h"
+
+
+namespace KKB
+{
+  /**
+   *@brief  Calls 'body' with sub ranges [first, last) that together cover [0, 'count') spreading them across threads.
+   *@details  Used by the two dimensional transforms to do their rows and columns in parallel.  When 'count' * 'size'
+   * is too small to be worth starting threads for, 'body' is called once on the callers thread with the whole range.
+   *@param[in]  count  Number of rows or columns to transform.
+   *@param[in]  size   Length of each row or column.
+   *@param[in]  body   Transforms rows or columns [first, last);  must not touch the rows or columns of other ranges.
+   */
+  void  FftParallelFor (kkuint32                                   count,
+                        kkuint32                                   size,
+                        std::function<void (kkuint32, kkuint32)>  body
+                       );
+
+  /** @brief  Number of threads 'FftParallelFor' will use;  defaults to 1,  zero indicates one per processor. */
+  kkuint32  FftNumThreads ();
+
+  /**
+   *@brief  Sets the number of threads 'FftParallelFor' will use.
+   *@details  Transforms run on the callers thread unless an application asks for more;  one that transforms
+   * a few large images at a time can set this to 0.  Applications that already extract features from several
+   * images at the same time should leave it at 1 so that each image is transformed on the thread processing it.
+   */
+  void  FftSetNumThreads (kkuint32  numThreads);
+
+
+
+  /**
+   *@class  FftPlan
+   *@brief  Precomputed tables to perform an unnormalized Discrete Fourier Transform of a fixed length in O(N log N).
+   *@details  Lengths whose only prime factors are 2, 3 and 5 are transformed directly by a Stockham auto-sort
+   * algorithm using radix 4, 2, 3 and 5 butterflies;  the output comes out in natural order so no bit reversal
+   * pass is needed.  Any other length is transformed using Bluestein's algorithm which expresses the transform as
+   * a circular convolution that is performed with a power of 2 transform.
+   *
+   * Same conventions as FFTW:  the forward transform uses exp(-2 pi i j k / N), the reverse transform
+   * exp(+2 pi i j k / N) and neither is scaled by 1 / N.
+   *
+   * A plan is not changed by 'Transform' so one instance can be used by several threads at the same time as
+   * long as each thread supplies its own work area.  'GetPlan' returns a plan from a process wide cache keyed by
+   * length and direction so that the tables are only computed once for each image dimension;  cached plans
+   * belong to the cache and live until the process exits.
+   */
+  template<typename DftType>
+  class  FftPlan
+  {
+  public:
+    typedef  FftPlan*  FftPlanPtr;
+    typedef  const FftPlan*  FftPlanConstPtr;
+
+    typedef  std::complex<DftType>  DftComplexType;
+
+    FftPlan (kkuint32  _size,
+             bool      _forwardTransform
+            );
+
+    ~FftPlan ();
+
+    /** @brief  Returns the cached plan for 'size' and direction building it the first time it is asked for;  do not delete it. */
+    static  FftPlanConstPtr  GetPlan (kkuint32  size,
+                                      bool      forwardTransform
+                                     );
+
+    bool       ForwardTransform ()  const  {return forwardTransform;}
+    kkuint32   Size             ()  const  {return size;}
+    bool       UsesBluestein    ()  const  {return bluesteinPlan != NULL;}
+
+    /** @brief  Number of 'DftComplexType' elements the work area passed to 'Transform' has to have. */
+    kkuint32   WorkSize         ()  const;
+
+    kkMemSize  MemoryConsumedEstimated ()  const;
+
+    /**
+     *@brief  Transforms 'src' into 'dest';  both have 'Size' elements and may be the same array.
+     *@param[in]  work  Scratch area of at least 'WorkSize' elements;  each thread needs its own.
+     */
+    void  Transform (const DftComplexType*  src,
+                     DftComplexType*        dest,
+                     DftComplexType*        work
+                    )  const;
+
+    /**
+     *@brief  Transforms two real sequences with one complex transform.
+     *@details  'srcA' + i 'srcB' is transformed and the two spectra are separated using the symmetry of the
+     * transform of a real sequence;  this halves the work of transforming the rows of an image.
+     *@param[in]  srcA   First real sequence of 'Size' elements.
+     *@param[in]  srcB   Second real sequence or NULL if there is only one.
+     *@param[out] destA  Transform of 'srcA'.
+     *@param[out] destB  Transform of 'srcB';  ignored when 'srcB' is NULL.
+     *@param[in]  work   Scratch area of at least 'WorkSize' + 'Size' elements.
+     */
+    template<typename RealType>
+    void  TransformReal (const RealType*  srcA,
+                         const RealType*  srcB,
+                         DftComplexType*  destA,
+                         DftComplexType*  destB,
+                         DftComplexType*  work
+                        )  const;
+
+  private:
+    FftPlan (const FftPlan&);
+    FftPlan&  operator= (const FftPlan&);
+
+    class  PlanCache
+    {
+    public:
+      PlanCache (): mutex (), plans ()  {}
+
+      ~PlanCache ()
+      {
+        for  (auto idx: plans)
+          delete  idx.second;
+        plans.clear ();
+      }
+
+      std::mutex                       mutex;
+      std::map<kkuint64, FftPlanPtr>   plans;
+    };
+
+    static  DftComplexType  Mul (const DftComplexType&  a,
+                                 const DftComplexType&  b
+                                )
+    {
+      return  DftComplexType (a.real () * b.real () - a.imag () * b.imag (),
+                              a.real () * b.imag () + a.imag () * b.real ()
+                             );
+    }
+
+    /** @brief  Multiplies by i when 'sign' is 1 and by -i when it is -1. */
+    static  DftComplexType  MulI (const DftComplexType&  a,
+                                  DftType                sign
+                                 )
+    {
+      return  DftComplexType (-sign * a.imag (), sign * a.real ());
+    }
+
+    void  BuildBluestein ();
+
+    void  Factor ();
+
+    /** @brief  One Stockham pass;  'n' is the length of the sub transforms and 's' the number of them. */
+    void  Pass (kkuint32               radix,
+                kkuint32               n,
+                kkuint32               s,
+                const DftComplexType*  x,
+                DftComplexType*        y
+               )  const;
+
+    void  TransformBluestein (const DftComplexType*  src,
+                              DftComplexType*        dest,
+                              DftComplexType*        work
+                             )  const;
+
+    void  TransformStockham (const DftComplexType*  src,
+                             DftComplexType*        dest,
+                             DftComplexType*        work
+                            )  const;
+
+    FftPlanConstPtr              bluesteinPlan;     /**< Cached power of 2 forward plan used to perform the convolution.  */
+    FftPlanConstPtr              bluesteinInverse;  /**< Cached power of 2 reverse plan.                                   */
+    std::vector<DftComplexType>  chirp;             /**< exp(sign pi i k^2 / size).                                        */
+    std::vector<DftComplexType>  chirpFilter;       /**< Forward transform of the conjugate chirp divided by its length.   */
+    bool                         forwardTransform;
+    std::vector<kkuint32>        radices;
+    kkuint32                     size;
+    std::vector<DftComplexType>  twiddles;          /**< exp(sign 2 pi i k / size) for k = 0 .. size - 1.                  */
+  };  /* FftPlan */
+
+
+
+  template<typename DftType>
+  FftPlan<DftType>::FftPlan (kkuint32  _size,
+                             bool      _forwardTransform
+                            ):
+      bluesteinPlan    (NULL),
+      bluesteinInverse (NULL),
+      chirp            (),
+      chirpFilter      (),
+      forwardTransform (_forwardTransform),
+      radices          (),
+      size             (_size),
+      twiddles         ()
+  {
+    Factor ();
+    if  (radices.empty ()  &&  (size > 1))
+    {
+      BuildBluestein ();
+      return;
+    }
+
+    // Computed in double precision so that 'float' plans are as accurate as they can be.
+    double  sign = forwardTransform ? -1.0 : 1.0;
+    twiddles.resize (size);
+    for  (kkuint32 k = 0;  k < size;  ++k)
+    {
+      double  theta = sign * 2.0 * PIE * (double)k / (double)size;
+      twiddles[k] = DftComplexType ((DftType)cos (theta), (DftType)sin (theta));
+    }
+  }
+
+
+
+  template<typename DftType>
+  FftPlan<DftType>::~FftPlan ()
+  {
+    // 'bluesteinPlan' and 'bluesteinInverse' belong to the plan cache.
+  }
+
+
+
+  template<typename DftType>
+  typename FftPlan<DftType>::FftPlanConstPtr  FftPlan<DftType>::GetPlan (kkuint32  size,
+                                                                         bool      forwardTransform
+                                                                        )
+  {
+    static  PlanCache  cache;
+
+    kkuint64  key = ((kkuint64)size << 1) | (forwardTransform ? 1 : 0);
+    {
+      std::lock_guard<std::mutex>  lock (cache.mutex);
+      auto  idx = cache.plans.find (key);
+      if  (idx != cache.plans.end ())
+        return  idx->second;
+    }
+
+    // Built outside of the lock;  a Bluestein plan asks the cache for its power of 2 plans.
+    FftPlanPtr  plan = new FftPlan (size, forwardTransform);
+
+    std::lock_guard<std::mutex>  lock (cache.mutex);
+    auto  idx = cache.plans.find (key);
+    if  (idx != cache.plans.end ())
+    {
+      // Another thread built it at the same time.
+      delete  plan;
+      return  idx->second;
+    }
+    cache.plans[key] = plan;
+    return  plan;
+  }  /* GetPlan */
+
+
+
+  template<typename DftType>
+  void  FftPlan<DftType>::Factor ()
+  {
+    radices.clear ();
+    if  (size < 2)
+      return;
+
+    kkuint32  n = size;
+    while  ((n % 4) == 0)  {radices.push_back (4);  n /= 4;}
+    while  ((n % 2) == 0)  {radices.push_back (2);  n /= 2;}
+    while  ((n % 3) == 0)  {radices.push_back (3);  n /= 3;}
+    while  ((n % 5) == 0)  {radices.push_back (5);  n /= 5;}
+    if  (n > 1)
+      radices.clear ();
+  }  /* Factor */
+
+
+
+  template<typename DftType>
+  void  FftPlan<DftType>::BuildBluestein ()
+  {
+    kkuint32  m = 1;
+    while  (m < (2 * size - 1))
+      m *= 2;
+
+    bluesteinPlan    = GetPlan (m, true);
+    bluesteinInverse = GetPlan (m, false);
+
+    // k^2 is reduced modulo 2 * size before converting to an angle so that large 'k' do not lose precision.
+    double    sign = forwardTransform ? -1.0 : 1.0;
+    kkuint64  twoN = 2 * (kkuint64)size;
+    chirp.resize (size);
+    for  (kkuint32 k = 0;  k < size;  ++k)
+    {
+      kkuint64  kSquared = ((kkuint64)k * (kkuint64)k) % twoN;
+      double    theta = sign * PIE * (double)kSquared / (double)size;
+      chirp[k] = DftComplexType ((DftType)cos (theta), (DftType)sin (theta));
+    }
+
+    std::vector<DftComplexType>  filter (m, DftComplexType (0, 0));
+    filter[0] = std::conj (chirp[0]);
+    for  (kkuint32 k = 1;  k < size;  ++k)
+    {
+      filter[k]     = std::conj (chirp[k]);
+      filter[m - k] = std::conj (chirp[k]);
+    }
+
+    std::vector<DftComplexType>  work (bluesteinPlan->WorkSize ());
+    chirpFilter.resize (m);
+    bluesteinPlan->Transform (filter.data (), chirpFilter.data (), work.data ());
+    DftType  scale = (DftType)1 / (DftType)m;
+    for  (auto& c: chirpFilter)
+      c *= scale;
+  }  /* BuildBluestein */
+
+
+
+  template<typename DftType>
+  kkuint32  FftPlan<DftType>::WorkSize ()  const
+  {
+    if  (bluesteinPlan)
+      return  (kkuint32)chirpFilter.size () + bluesteinPlan->WorkSize ();
+    return  size;
+  }
+
+
+
+  template<typename DftType>
+  kkMemSize  FftPlan<DftType>::MemoryConsumedEstimated ()  const
+  {
+    return  sizeof (*this) +
+            (chirp.size () + chirpFilter.size () + twiddles.size ()) * sizeof (DftComplexType) +
+            radices.size () * sizeof (kkuint32);
+  }
+
+
+
+  template<typename DftType>
+  void  FftPlan<DftType>::Transform (const DftComplexType*  src,
+                                     DftComplexType*        dest,
+                                     DftComplexType*        work
+                                    )  const
+  {
+    if  (bluesteinPlan)
+      TransformBluestein (src, dest, work);
+    else
+      TransformStockham (src, dest, work);
+  }
+
+
+
+  template<typename DftType>
+  void  FftPlan<DftType>::TransformStockham (const DftComplexType*  src,
+                                             DftComplexType*        dest,
+                                             DftComplexType*        work
+                                            )  const
+  {
+    kkuint32  numPasses = (kkuint32)radices.size ();
+    if  (numPasses == 0)
+    {
+      if  ((size == 1)  &&  (src != dest))
+        dest[0] = src[0];
+      return;
+    }
+
+    // Each pass reads one buffer and writes the other;  pick the first output so that the last pass ends up in 'dest'.
+    if  ((src == dest)  &&  ((numPasses % 2) == 1))
+    {
+      for  (kkuint32 x = 0;  x < size;  ++x)
+        work[x] = src[x];
+      src = work;
+    }
+
+    DftComplexType*  out = ((numPasses % 2) == 0) ? work : dest;
+    const DftComplexType*  in = src;
+    kkuint32  n = size;
+    kkuint32  s = 1;
+    for  (auto radix: radices)
+    {
+      Pass (radix, n, s, in, out);
+      n /= radix;
+      s *= radix;
+      in = out;
+      out = (out == dest) ? work : dest;
+    }
+  }  /* TransformStockham */
+
+
+
+  template<typename DftType>
+  void  FftPlan<DftType>::Pass (kkuint32               radix,
+                                kkuint32               n,
+                                kkuint32               s,
+                                const DftComplexType*  x,
+                                DftComplexType*        y
+                               )  const
+  {
+    // Decimation in frequency:  for each of the 's' sub transforms of length 'n' the 'radix' inputs spaced 'm'
+    // apart are combined and twiddled by exp(sign 2 pi i p k / n);  the results are stored interleaved so that
+    // the next pass sees 's' * 'radix' sub transforms of length 'm'.
+    const kkuint32  m = n / radix;
+    const kkuint32  twiddleStep = size / n;
+    const DftType   sign = forwardTransform ? (DftType)-1 : (DftType)1;
+    const DftComplexType*  tw = twiddles.data ();
+
+    if  (radix == 2)
+    {
+      for  (kkuint32 p = 0;  p < m;  ++p)
+      {
+        const DftComplexType  w1 = tw[p * twiddleStep];
+        const DftComplexType*  x0 = x + s * p;
+        const DftComplexType*  x1 = x + s * (p + m);
+        DftComplexType*  y0 = y + s * (2 * p);
+        DftComplexType*  y1 = y + s * (2 * p + 1);
+        for  (kkuint32 q = 0;  q < s;  ++q)
+        {
+          const DftComplexType  a0 = x0[q];
+          const DftComplexType  a1 = x1[q];
+          y0[q] = a0 + a1;
+          y1[q] = Mul (a0 - a1, w1);
+        }
+      }
+    }
+
+    else if  (radix == 4)
+    {
+      for  (kkuint32 p = 0;  p < m;  ++p)
+      {
+        const DftComplexType  w1 = tw[1 * p * twiddleStep];
+        const DftComplexType  w2 = tw[2 * p * twiddleStep];
+        const DftComplexType  w3 = tw[3 * p * twiddleStep];
+        const DftComplexType*  x0 = x + s * p;
+        DftComplexType*  y0 = y + s * (4 * p);
+        for  (kkuint32 q = 0;  q < s;  ++q)
+        {
+          const DftComplexType  a0 = x0[q];
+          const DftComplexType  a1 = x0[q + s * m];
+          const DftComplexType  a2 = x0[q + s * 2 * m];
+          const DftComplexType  a3 = x0[q + s * 3 * m];
+          const DftComplexType  t0 = a0 + a2;
+          const DftComplexType  t1 = a0 - a2;
+          const DftComplexType  t2 = a1 + a3;
+          const DftComplexType  t3 = MulI (a1 - a3, sign);
+          y0[q]         = t0 + t2;
+          y0[q + s]     = Mul (t1 + t3, w1);
+          y0[q + 2 * s] = Mul (t0 - t2, w2);
+          y0[q + 3 * s] = Mul (t1 - t3, w3);
+        }
+      }
+    }
+
+    else if  (radix == 3)
+    {
+      const DftType  c1 = (DftType)-0.5;
+      const DftType  s1 = sign * (DftType)0.86602540378443864676;   // sin (2 pi / 3)
+      for  (kkuint32 p = 0;  p < m;  ++p)
+      {
+        const DftComplexType  w1 = tw[1 * p * twiddleStep];
+        const DftComplexType  w2 = tw[2 * p * twiddleStep];
+        const DftComplexType*  x0 = x + s * p;
+        DftComplexType*  y0 = y + s * (3 * p);
+        for  (kkuint32 q = 0;  q < s;  ++q)
+        {
+          const DftComplexType  a0 = x0[q];
+          const DftComplexType  a1 = x0[q + s * m];
+          const DftComplexType  a2 = x0[q + s * 2 * m];
+          const DftComplexType  t1 = a1 + a2;
+          const DftComplexType  t2 = a0 + c1 * t1;
+          const DftComplexType  t3 = MulI (s1 * (a1 - a2), (DftType)1);
+          y0[q]         = a0 + t1;
+          y0[q + s]     = Mul (t2 + t3, w1);
+          y0[q + 2 * s] = Mul (t2 - t3, w2);
+        }
+      }
+    }
+
+    else if  (radix == 5)
+    {
+      const DftType  c1 = (DftType)0.30901699437494742410;           // cos (2 pi / 5)
+      const DftType  c2 = (DftType)-0.80901699437494742410;          // cos (4 pi / 5)
+      const DftType  s1 = sign * (DftType)0.95105651629515357212;    // sin (2 pi / 5)
+      const DftType  s2 = sign * (DftType)0.58778525229247312917;    // sin (4 pi / 5)
+      for  (kkuint32 p = 0;  p < m;  ++p)
+      {
+        const DftComplexType  w1 = tw[1 * p * twiddleStep];
+        const DftComplexType  w2 = tw[2 * p * twiddleStep];
+        const DftComplexType  w3 = tw[3 * p * twiddleStep];
+        const DftComplexType  w4 = tw[4 * p * twiddleStep];
+        const DftComplexType*  x0 = x + s * p;
+        DftComplexType*  y0 = y + s * (5 * p);
+        for  (kkuint32 q = 0;  q < s;  ++q)
+        {
+          const DftComplexType  a0 = x0[q];
+          const DftComplexType  a1 = x0[q + s * m];
+          const DftComplexType  a2 = x0[q + s * 2 * m];
+          const DftComplexType  a3 = x0[q + s * 3 * m];
+          const DftComplexType  a4 = x0[q + s * 4 * m];
+          const DftComplexType  sum14  = a1 + a4;
+          const DftComplexType  sum23  = a2 + a3;
+          const DftComplexType  diff14 = a1 - a4;
+          const DftComplexType  diff23 = a2 - a3;
+          const DftComplexType  r1 = a0 + c1 * sum14 + c2 * sum23;
+          const DftComplexType  r2 = a0 + c2 * sum14 + c1 * sum23;
+          const DftComplexType  i1 = MulI (s1 * diff14 + s2 * diff23, (DftType)1);
+          const DftComplexType  i2 = MulI (s2 * diff14 - s1 * diff23, (DftType)1);
+          y0[q]         = a0 + sum14 + sum23;
+          y0[q + s]     = Mul (r1 + i1, w1);
+          y0[q + 2 * s] = Mul (r2 + i2, w2);
+          y0[q + 3 * s] = Mul (r2 - i2, w3);
+          y0[q + 4 * s] = Mul (r1 - i1, w4);
+        }
+      }
+    }
+  }  /* Pass */
+
+
+
+  template<typename DftType>
+  void  FftPlan<DftType>::TransformBluestein (const DftComplexType*  src,
+                                              DftComplexType*        dest,
+                                              DftComplexType*        work
+                                             )  const
+  {
+    // X[k] = chirp[k] * sum (src[j] * chirp[j]) * conj (chirp[k - j]);  the sum is a convolution done in the frequency domain.
+    kkuint32  m = (kkuint32)chirpFilter.size ();
+    DftComplexType*  a = work;
+    DftComplexType*  innerWork = work + m;
+
+    kkuint32  k = 0;
+    for  (k = 0;  k < size;  ++k)
+      a[k] = Mul (src[k], chirp[k]);
+    for  (;  k < m;  ++k)
+      a[k] = DftComplexType (0, 0);
+
+    bluesteinPlan->Transform (a, a, innerWork);
+    for  (k = 0;  k < m;  ++k)
+      a[k] = Mul (a[k], chirpFilter[k]);
+    bluesteinInverse->Transform (a, a, innerWork);
+
+    for  (k = 0;  k < size;  ++k)
+      dest[k] = Mul (a[k], chirp[k]);
+  }  /* TransformBluestein */
+
+
+
+  template<typename DftType>
+  template<typename RealType>
+  void  FftPlan<DftType>::TransformReal (const RealType*  srcA,
+                                         const RealType*  srcB,
+                                         DftComplexType*  destA,
+                                         DftComplexType*  destB,
+                                         DftComplexType*  work
+                                        )  const
+  {
+    DftComplexType*  z = work;
+    DftComplexType*  transformWork = work + size;
+
+    if  (srcB == NULL)
+    {
+      for  (kkuint32 k = 0;  k < size;  ++k)
+        z[k] = DftComplexType ((DftType)srcA[k], (DftType)0);
+      Transform (z, destA, transformWork);
+      return;
+    }
+
+    for  (kkuint32 k = 0;  k < size;  ++k)
+      z[k] = DftComplexType ((DftType)srcA[k], (DftType)srcB[k]);
+    Transform (z, z, transformWork);
+
+    // A[k] = (Z[k] + conj (Z[-k])) / 2  and  B[k] = (Z[k] - conj (Z[-k])) / 2i;  holds in both directions.
+    const DftType  half = (DftType)0.5;
+    for  (kkuint32 k = 0;  k < size;  ++k)
+    {
+      const DftComplexType  zk  = z[k];
+      const DftComplexType  zmk = std::conj (z[(k == 0) ? 0 : (size - k)]);
+      destA[k] = half * (zk + zmk);
+      destB[k] = MulI (half * (zk - zmk), (DftType)-1);
+    }
+  }  /* TransformReal */
+
+}  /* KKB */
+
+#endif
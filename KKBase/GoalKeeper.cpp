@@ -4,7 +4,9 @@
  */
 #include "FirstIncludes.h"
 
+#include <chrono>
 #include <errno.h>
+#include <iomanip>
 #include <istream>
 #include <iostream>
 #include <fstream>
@@ -67,19 +69,38 @@ public:
 
 GoalKeeperListPtr  GoalKeeper::existingGoalKeepers = NULL;
 
+volatile bool  GoalKeeper::collectContentionStats = false;
+
+
+
+/** @brief  Micro-seconds from an arbitrary fixed point;  only meant for measuring intervals. */
+static  kkuint64  ElapsedMicroSecs ()
+{
+  return  (kkuint64)std::chrono::duration_cast<std::chrono::microseconds>
+                      (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
 
 
 GoalKeeper::GoalKeeper (const KKStr&  _name):
-   blocked           (false),
-   blockerDepth      (0),
-   blockerThreadId   (-1),
-   name              (_name),
-   numBlockedThreads (0)
+   blocked               (false),
+   blockerDepth          (0),
+   blockerThreadId       (-1),
+   name                  (_name),
+   numBlockedThreads     (0),
+   acquisitions          (0),
+   contendedAcquisitions (0),
+   blockStartMicroSecs   (0),
+   holdMicroSecs         (0),
+   maxWaitMicroSecs      (0),
+   waitMicroSecs         (0)
 {
 #if  defined(WIN32)
   InitializeCriticalSection (&cs);
+  InitializeConditionVariable (&blockReleased);
 #else
   pthread_mutex_init (&mutex, NULL);
+  pthread_cond_init (&blockReleased, NULL);
 #endif
 
 #if  defined(GOALKEEPER_DEBUG)
@@ -95,11 +116,12 @@ GoalKeeper::~GoalKeeper ()
   if  (blocked)
     CriticalSectionEnd ();
 #else
+  pthread_cond_destroy (&blockReleased);
   pthread_mutex_destroy (&mutex);
 #endif
 
 #if  defined(GOALKEEPER_DEBUG)
-  ReportBlockedStats ();
+  SaveBlockedStats ();
   delete  blockedStats;
   blockedStats = NULL;
 #endif
@@ -109,7 +131,7 @@ GoalKeeper::~GoalKeeper ()
 
 
 #if  defined(GOALKEEPER_DEBUG)
-void  GoalKeeper::ReportBlockedStats ()
+void  GoalKeeper::SaveBlockedStats ()
 {
   HANDLE  mutexCreateHandle = CreateMutex (NULL,                 /**< default security attributes. */
                                            false,                /**< initially not owned.         */
@@ -154,7 +176,7 @@ void  GoalKeeper::ReportBlockedStats ()
 
   ReleaseMutex (mutexCreateHandle);
   CloseHandle(mutexCreateHandle);
-}  /* ReportBlockedStats */
+}  /* SaveBlockedStats */
 #endif
 
 
@@ -209,79 +231,77 @@ void  GoalKeeper::CriticalSectionEnd ()
 void  GoalKeeper::StartBlock ()
 {
   kkint32  curThreadId = KKB::osGetThreadId ();
-  
-  bool    firstPassThruLoop = true;
-  bool    weAreBlocked      = true;
-  kkuint32  milliSecsBlocked  = 0;
 
-  while  (weAreBlocked)
+  CriticalSectionStart ();
+
+  if  (blocked  &&  (curThreadId == blockerThreadId))
   {
-    CriticalSectionStart ();
+    // We are the thread that already holds the block;  so okay for us 
+    // to process.
+    blockerDepth++;
+    CriticalSectionEnd ();
+    return;
+  }
 
-    if  (firstPassThruLoop)
-      numBlockedThreads++;
+  bool      timeIt            = collectContentionStats;
+  bool      hadToWait         = blocked;
+  kkuint64  waitStartMicroSecs = (timeIt  &&  hadToWait) ? ElapsedMicroSecs () : 0;
 
-    if  (blocked)
-    {
-      if  (curThreadId == blockerThreadId)
-      {
-        // We are the thread that already holds the block;  so okay for us 
-        // to process.
-        blockerDepth++;
-        weAreBlocked = false;
-        numBlockedThreads--;
-      }
-      else
-      {
-        weAreBlocked = true;
 #if  defined(GOALKEEPER_DEBUG)
-        blockedStats->PushOnBack (new BlockedStat (curThreadId, blockerThreadId, milliSecsBlocked, numBlockedThreads));
+  kkint32  firstBlockerThreadId = blockerThreadId;
 #endif
-      }
-    }
-    else
+
+  if  (blocked)
+  {
+    numBlockedThreads++;
+    // Spurious wake ups are possible and another thread may have taken the block between the
+    // signal and us re-acquiring the mutex;  so keep checking.
+    while  (blocked)
     {
-      // No one holds the lock;  so we can take it.
-      blocked = true;
-      blockerDepth = 1;
-      blockerThreadId = curThreadId;
-      weAreBlocked = false;
-      numBlockedThreads--;
+#if  defined(WIN32)
+      SleepConditionVariableCS (&blockReleased, &cs, INFINITE);
+#else
+      pthread_cond_wait (&blockReleased, &mutex);
+#endif
     }
+    numBlockedThreads--;
+  }
 
-    CriticalSectionEnd ();
+  // No one holds the lock;  so we can take it.
+  blocked = true;
+  blockerDepth = 1;
+  blockerThreadId = curThreadId;
 
-    if  (weAreBlocked)
+  if  (timeIt)
+  {
+    kkuint64  now = ElapsedMicroSecs ();
+    ++acquisitions;
+    if  (hadToWait)
     {
-      if  (milliSecsBlocked < 10)
-      {
-        osSleepMiliSecs (1);
-        milliSecsBlocked++;
-      }
-
-      else if  (milliSecsBlocked < 200)
-      {
-        osSleepMiliSecs (10);
-        milliSecsBlocked += 10;
-      }
-
-      else if  (milliSecsBlocked < 10000)
-      {
-        osSleepMiliSecs (100);
-        milliSecsBlocked += 100;
-      }
-
-      else
-      {
-        osSleepMiliSecs (400);
-        milliSecsBlocked += 400;
-      }
+      kkuint64  waited = now - waitStartMicroSecs;
+      ++contendedAcquisitions;
+      waitMicroSecs += waited;
+      if  (waited > maxWaitMicroSecs)
+        maxWaitMicroSecs = waited;
     }
+    blockStartMicroSecs = now;
+  }
+  else
+  {
+    blockStartMicroSecs = 0;
+  }
 
-    firstPassThruLoop = false;
+#if  defined(GOALKEEPER_DEBUG)
+  if  (hadToWait)
+  {
+    kkuint32  milliSecsBlocked = 0;
+    if  (timeIt)
+      milliSecsBlocked = (kkuint32)((blockStartMicroSecs - waitStartMicroSecs) / 1000);
+    blockedStats->PushOnBack (new BlockedStat (curThreadId, firstBlockerThreadId, milliSecsBlocked, numBlockedThreads));
   }
+#endif
 
-  return;
+  CriticalSectionEnd ();
 }   /* StartBlock */
 
 
@@ -289,6 +309,7 @@ void  GoalKeeper::StartBlock ()
 void   GoalKeeper::EndBlock ()
 {
   kkint32  curProcessorId = KKB::osGetThreadId ();
+  kkint32  holderThreadId = -1;
 
   kkint32 errorCode = 0; // 0=No Error;  
                          // 1=There is no Block
@@ -306,6 +327,7 @@ void   GoalKeeper::EndBlock ()
     else if  (curProcessorId != blockerThreadId)
     {
       errorCode = 2;
+      holderThreadId = blockerThreadId;
     }
 
     else
@@ -316,6 +338,21 @@ void   GoalKeeper::EndBlock ()
         blocked = false;
         blockerThreadId = -1;
         blockerDepth = 0;
+
+        if  (blockStartMicroSecs != 0)
+        {
+          holdMicroSecs += ElapsedMicroSecs () - blockStartMicroSecs;
+          blockStartMicroSecs = 0;
+        }
+
+        if  (numBlockedThreads > 0)
+        {
+#if  defined(WIN32)
+          WakeConditionVariable (&blockReleased);
+#else
+          pthread_cond_signal (&blockReleased);
+#endif
+        }
       }
     }
 
@@ -329,13 +366,75 @@ void   GoalKeeper::EndBlock ()
     throw KKException ("GoalKeeper::EndBlock    Name[" + name + "]  There was no block established.");
 
   else if  (errorCode == 2)
-    throw KKException ("GoalKeeper::EndBlock    Name[" + name + "]  ThreadId[" + curProcessorId + "] Currently holds Block;  our ThreadId[" + curProcessorId + "]");
+    throw KKException ("GoalKeeper::EndBlock    Name[" + name + "]  ThreadId[" + holderThreadId + "] Currently holds Block;  our ThreadId[" + curProcessorId + "]");
 
   return;
 }  /* EndBlock */
 
 
 
+void  GoalKeeper::CollectContentionStats (bool  _collectContentionStats)
+{
+  collectContentionStats = _collectContentionStats;
+}
+
+
+
+void  GoalKeeper::ResetContentionStats ()
+{
+  CriticalSectionStart ();
+  acquisitions          = 0;
+  contendedAcquisitions = 0;
+  blockStartMicroSecs   = 0;
+  holdMicroSecs         = 0;
+  maxWaitMicroSecs      = 0;
+  waitMicroSecs         = 0;
+  CriticalSectionEnd ();
+}  /* ResetContentionStats */
+
+
+
+void  GoalKeeper::ReportBlockedStatsHeader (std::ostream&  o)
+{
+  o << "Name"
+    << "\t" << "Acquisitions"
+    << "\t" << "ContendedAcquisitions"
+    << "\t" << "WaitMilliSecs"
+    << "\t" << "MaxWaitMilliSecs"
+    << "\t" << "HoldMilliSecs"
+    << endl;
+}  /* ReportBlockedStatsHeader */
+
+
+
+void  GoalKeeper::ReportBlockedStats (std::ostream&  o)
+{
+  CriticalSectionStart ();
+  kkuint64  acquisitionsCopy          = acquisitions;
+  kkuint64  contendedAcquisitionsCopy = contendedAcquisitions;
+  kkuint64  holdMicroSecsCopy         = holdMicroSecs;
+  kkuint64  maxWaitMicroSecsCopy      = maxWaitMicroSecs;
+  kkuint64  waitMicroSecsCopy         = waitMicroSecs;
+  CriticalSectionEnd ();
+
+  std::ios_base::fmtflags  origFlags = o.flags ();
+  std::streamsize          origPrec  = o.precision ();
+
+  o << name
+    << "\t" << acquisitionsCopy
+    << "\t" << contendedAcquisitionsCopy
+    << std::fixed << std::setprecision (3)
+    << "\t" << (waitMicroSecsCopy    / 1000.0)
+    << "\t" << (maxWaitMicroSecsCopy / 1000.0)
+    << "\t" << (holdMicroSecsCopy    / 1000.0)
+    << endl;
+
+  o.flags (origFlags);
+  o.precision (origPrec);
+}  /* ReportBlockedStats */
+
+
+
 void  GoalKeeper::Create (const KKStr&             _name,
                           volatile GoalKeeperPtr&  _newGoalKeeper
                          )
@@ -564,6 +663,46 @@ void   GoalKeeper::FinalCleanUp ()
 
 
 
+void  GoalKeeper::ReportAllBlockedStats (std::ostream&  o)
+{
+#if  defined(WIN32)
+  HANDLE  mutexCreateHandle = CreateMutex (NULL,                 /**< default security attributes */
+                                           false,                /**< initially not owned */
+                                           "GoalKeeperClass"
+                                          ); 
+  if (mutexCreateHandle == NULL)
+    throw KKException("GoalKeeper::ReportAllBlockedStats  failed to get handle to Mutex Object 'GoalKeeperClass'.");
+
+  WaitForSingleObject (mutexCreateHandle, INFINITE);
+#else
+  sem_t*  semHandle = sem_open ("GoalKeeperClass", O_CREAT, 0644, 1);
+  if  (semHandle == SEM_FAILED)
+  {
+    std::perror("GoalKeeper::ReportAllBlockedStats   Error Opening Semaphore  'GoalKeeper'");
+    throw KKException ("GoalKeeper::ReportAllBlockedStats    Error opening 'GoalKeeper'.");
+  }
+
+  sem_wait (semHandle);
+#endif
+
+  ReportBlockedStatsHeader (o);
+  if  (existingGoalKeepers)
+  {
+    for  (auto  idx: *existingGoalKeepers)
+      idx->ReportBlockedStats (o);
+  }
+
+#if  defined(WIN32)
+  ReleaseMutex (mutexCreateHandle);
+  CloseHandle(mutexCreateHandle);
+#else
+  sem_post (semHandle);
+  sem_close (semHandle);
+#endif
+}  /* ReportAllBlockedStats */
+
+
+
 kkint32  GoalKeeper::NumBlockedThreads ()
 {
   kkint32  x = 0;
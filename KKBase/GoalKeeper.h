@@ -8,10 +8,13 @@
 //#define  GOALKEEPER_DEBUG
 
 
+#include  <ostream>
+
 #if  defined(WIN32)
 #include  <windows.h>
 #else
 #include  <fcntl.h>
+#include  <pthread.h>
 #include  <semaphore.h>
 #endif
 
@@ -33,6 +36,14 @@ namespace  KKB
   /// of times to actually release the block. Imagine that you have a function that Starts and Ends a Block but can
   /// be called from the middle of another function that also Starts and Ends a block on the same GoalKeeper object.<p/>
   ///
+  /// Threads waiting in StartBlock sleep on a condition variable that EndBlock signals when the block
+  /// is released; they do not poll.<p/>
+  ///
+  /// Contention statistics (acquisitions, time spent waiting and time the block was held) can be collected
+  /// by calling GoalKeeper::CollectContentionStats; they are off by default as they require reading the
+  /// clock twice per acquisition. Use ReportBlockedStats or ReportAllBlockedStats to see which GoalKeepers
+  /// are hot.<p/>
+  ///
   /// This class is meant to function the same under Windows or Linux
   ///</remarks>
   class GoalKeeper
@@ -118,6 +129,14 @@ namespace  KKB
 
     kkint32  BlockerThreadId ();  /**< @brief  ThreadId of thread that currently holds the Block  -1 indicates no Block */
 
+    /**
+     *@brief  Turns the collection of contention statistics on or off for all GoalKeeper instances.
+     *@details  Statistics gathered while turned on are retained until 'ResetContentionStats' is called.
+     */
+    static  void  CollectContentionStats (bool  _collectContentionStats);
+
+    static  bool  CollectingContentionStats ()  {return collectContentionStats;}
+
     /**
      *@brief Ends the block and allows other threads to pass through StatBlock.
      *@details Decrements the variable 'blockerDepth' by one.  Once 'blockerDepth' is equal zero
@@ -135,11 +154,28 @@ namespace  KKB
     kkint32  NumBlockedThreads ();
 
 
+    /**
+     *@brief  Writes one tab delimited line with the contention statistics of this instance.
+     *@details  Columns: Name, Acquisitions, ContendedAcquisitions, WaitMilliSecs, MaxWaitMilliSecs and HoldMilliSecs;
+     *  'ReportBlockedStatsHeader' writes the matching header line.
+     */
+    void  ReportBlockedStats (std::ostream&  o);
+
+    static  void  ReportBlockedStatsHeader (std::ostream&  o);
+
+    /** @brief  Writes the header followed by the contention statistics of every existing GoalKeeper instance. */
+    static  void  ReportAllBlockedStats (std::ostream&  o);
+
+    /** @brief  Zeros the contention statistics of this instance. */
+    void  ResetContentionStats ();
+
+
     /**
      *@brief Initiates a Block as long as another thread has not already locked this object.  
-     *@details If it is already blocked processor will sleep and then try again. As long as the variable 
-     *  'blockerDepth'is greater than zero this instance will be considered blocked.  Once a thread has the 
-     *  instance blocked it will increment 'blockerDepth' and return to caller.
+     *@details If another thread holds the block the calling thread waits on a condition variable until
+     *  'EndBlock' releases it. As long as the variable 'blockerDepth' is greater than zero this instance
+     *  will be considered blocked.  Once a thread has the instance blocked it will increment 'blockerDepth'
+     *  and return to caller.
      */
     void   StartBlock ();
 
@@ -170,6 +206,16 @@ namespace  KKB
 
     static  GoalKeeperListPtr  existingGoalKeepers;
 
+    static  volatile bool  collectContentionStats;
+
+    // Contention statistics;  only updated while 'collectContentionStats' is true.  Times are in micro-seconds.
+    kkuint64  acquisitions;           /**< Number of times the block went from released to held.                */
+    kkuint64  contendedAcquisitions;  /**< Number of those acquisitions that had to wait for another thread.     */
+    kkuint64  blockStartMicroSecs;    /**< When the current block was acquired;  0 = not being timed.           */
+    kkuint64  holdMicroSecs;          /**< Total time the block was held.                                       */
+    kkuint64  maxWaitMicroSecs;
+    kkuint64  waitMicroSecs;          /**< Total time threads spent waiting in 'StartBlock'.                     */
+
 #if  defined(GOALKEEPER_DEBUG)
     class  BlockedStat;
     typedef  BlockedStat*  BlockedStatPtr;
@@ -177,13 +223,15 @@ namespace  KKB
     typedef  BlockedStatList*      BlockedStatListPtr;
 
     BlockedStatListPtr  blockedStats;
-    void  ReportBlockedStats ();
+    void  SaveBlockedStats ();
 #endif
 
 #if defined(WIN32)
-    CRITICAL_SECTION cs;
+    CRITICAL_SECTION    cs;
+    CONDITION_VARIABLE  blockReleased;  /**< Signaled by 'EndBlock' when the block is released. */
 #else 
     pthread_mutex_t  mutex;
+    pthread_cond_t   blockReleased;     /**< Signaled by 'EndBlock' when the block is released. */
 #endif
 
   };  /* GoalKeeper */
@@ -4848,7 +4848,7 @@ KKStr  KKB::StrFromUint16 (kkuint16 ui)
 KKStr  KKB::StrFromInt32 (kkint32 i)
 {
   char  buff[50];
-  SPRINTF (buff, sizeof (buff), "%ld", i);
+  SPRINTF (buff, sizeof (buff), "%ld", (long)i);
   KKStr s (buff);
   return  s;
 }  /* StrFromInt32 */
@@ -4858,7 +4858,7 @@ KKStr  KKB::StrFromInt32 (kkint32 i)
 KKStr  KKB::StrFromUint32 (kkuint32 ui)
 {
   char  buff[50];
-  SPRINTF (buff, sizeof (buff), "%lu", ui);
+  SPRINTF (buff, sizeof (buff), "%lu", (unsigned long)ui);
   KKStr s (buff);
   return  s;
 }  /* StrFromUint32 */
@@ -0,0 +1,232 @@
+/* KKThreadPool.cpp -- Fixed size pool of worker threads that execute queued tasks.
+ * Copyright (C) 2012-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#include "FirstIncludes.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKException.h"
+#include "OSservices.h"
+#include "KKThreadPool.h"
+using namespace KKB;
+
+
+
+KKThreadPool::KKThreadPool (const KKStr&  _name,
+                            kkuint32      _numThreads
+                           ):
+  busyCount      (0),
+  exceptionText  (),
+  mutex          (),
+  name           (_name),
+  numThreads     (ResolveNumThreads (_numThreads)),
+  shutdown       (false),
+  tasks          (),
+  tasksAvailable (),
+  tasksCompleted (),
+  workers        ()
+{
+  if  (numThreads > 1)
+  {
+    workers.reserve (numThreads);
+    for  (kkuint32 x = 0;  x < numThreads;  ++x)
+      workers.push_back (std::thread (&KKThreadPool::WorkerLoop, this));
+  }
+}
+
+
+
+KKThreadPool::~KKThreadPool ()
+{
+  {
+    unique_lock<std::mutex>  lock (mutex);
+    tasksCompleted.wait (lock, [this] {return tasks.empty ()  &&  (busyCount == 0);});
+    shutdown = true;
+  }
+  tasksAvailable.notify_all ();
+
+  for  (auto&  w: workers)
+  {
+    if  (w.joinable ())
+      w.join ();
+  }
+  workers.clear ();
+}
+
+
+
+kkMemSize  KKThreadPool::MemoryConsumedEstimated ()  const
+{
+  return  sizeof (KKThreadPool) +
+          name.MemoryConsumedEstimated () +
+          exceptionText.MemoryConsumedEstimated () +
+          workers.size () * sizeof (std::thread) +
+          tasks.size () * sizeof (TaskFunc);
+}
+
+
+
+kkuint32  KKThreadPool::ResolveNumThreads (kkuint32  requested)
+{
+  if  (requested > 0)
+    return  requested;
+
+  kkint32  numProcessors = osGetNumberOfProcessors ();
+  if  (numProcessors < 1)
+    return 1;
+  return  (kkuint32)numProcessors;
+}  /* ResolveNumThreads */
+
+
+
+void  KKThreadPool::RunTask (TaskFunc&  task)
+{
+  KKStr  errMsg;
+  try
+  {
+    task ();
+  }
+  catch  (const KKException&  e)
+  {
+    errMsg = "KKThreadPool[" + name + "]  KKException: " + e.ToString ();
+  }
+  catch  (const std::exception&  e)
+  {
+    errMsg = "KKThreadPool[" + name + "]  std::exception: " + e.what ();
+  }
+  catch  (...)
+  {
+    errMsg = "KKThreadPool[" + name + "]  exception(...) trapped.";
+  }
+
+  if  (!errMsg.Empty ())
+  {
+    lock_guard<std::mutex>  lock (mutex);
+    if  (exceptionText.Empty ())
+      exceptionText = errMsg;
+  }
+}  /* RunTask */
+
+
+
+void  KKThreadPool::AddTask (TaskFunc  task)
+{
+  if  (workers.empty ())
+  {
+    // Serial mode;  execute on the callers thread.
+    RunTask (task);
+    return;
+  }
+
+  {
+    lock_guard<std::mutex>  lock (mutex);
+    tasks.push_back (std::move (task));
+  }
+  tasksAvailable.notify_one ();
+}  /* AddTask */
+
+
+
+void  KKThreadPool::WorkerLoop ()
+{
+  while  (true)
+  {
+    TaskFunc  task;
+    {
+      unique_lock<std::mutex>  lock (mutex);
+      tasksAvailable.wait (lock, [this] {return shutdown  ||  !tasks.empty ();});
+      if  (tasks.empty ())
+        return;   // 'shutdown' must be set.
+
+      task = std::move (tasks.front ());
+      tasks.pop_front ();
+      ++busyCount;
+    }
+
+    RunTask (task);
+
+    {
+      lock_guard<std::mutex>  lock (mutex);
+      --busyCount;
+    }
+    tasksCompleted.notify_all ();
+  }
+}  /* WorkerLoop */
+
+
+
+void  KKThreadPool::WaitForAllTasks ()
+{
+  KKStr  errMsg;
+  {
+    unique_lock<std::mutex>  lock (mutex);
+    tasksCompleted.wait (lock, [this] {return tasks.empty ()  &&  (busyCount == 0);});
+    errMsg = exceptionText;
+    exceptionText = "";
+  }
+
+  if  (!errMsg.Empty ())
+    throw KKException (errMsg);
+}  /* WaitForAllTasks */
+
+
+
+void  KKThreadPool::ParallelFor (kkuint32                        numThreads,
+                                 kkuint32                        count,
+                                 std::function<void (kkuint32)>  body
+                                )
+{
+  numThreads = ResolveNumThreads (numThreads);
+  if  (numThreads > count)
+    numThreads = count;
+
+  if  (numThreads <= 1)
+  {
+    for  (kkuint32 idx = 0;  idx < count;  ++idx)
+      body (idx);
+    return;
+  }
+
+  KKThreadPool  pool ("ParallelFor", numThreads);
+  pool.ParallelFor (count, body);
+}  /* ParallelFor */
+
+
+
+void  KKThreadPool::ParallelFor (kkuint32                        count,
+                                 std::function<void (kkuint32)>  body
+                                )
+{
+  kkuint32  numTasks = Min (numThreads, count);
+  if  (workers.empty ()  ||  (numTasks <= 1))
+  {
+    for  (kkuint32 idx = 0;  idx < count;  ++idx)
+      body (idx);
+    return;
+  }
+
+  // Each worker pulls the next index; this keeps the threads busy when the cost per index varies.
+  std::atomic<kkuint32>  nextIdx (0);
+
+  for  (kkuint32 x = 0;  x < numTasks;  ++x)
+  {
+    AddTask ([&nextIdx, count, &body] ()
+      {
+        for  (kkuint32 idx = nextIdx++;  idx < count;  idx = nextIdx++)
+          body (idx);
+      }
+    );
+  }
+  WaitForAllTasks ();
+}  /* ParallelFor */
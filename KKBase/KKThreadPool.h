@@ -0,0 +1,112 @@
+/* KKThreadPool.h -- Fixed size pool of worker threads that execute queued tasks.
+ * Copyright (C) 2012-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#if  !defined(_KKTHREADPOOL_)
+#define  _KKTHREADPOOL_
+
+WarningsLowered()
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+WarningsRestored()
+
+#include "KKStr.h"
+
+
+namespace KKB
+{
+  /**
+   *@class  KKThreadPool
+   *@brief  A fixed number of worker threads that execute tasks in the order they were added.
+   *@details Meant for data parallel work such as training the folds of a cross validation or
+   * classifying a large list of examples; each task should only update data that no other task
+   * touches. When the pool was constructed with one thread or less no worker threads are created
+   * and 'AddTask' will run the task immediately on the callers thread; this way callers can
+   * support a serial and parallel mode with the same code path.
+   *
+   * If a task throws an exception the text is retained and 'WaitForAllTasks' will throw a
+   * KKException after all remaining tasks have completed.
+   */
+  class  KKThreadPool
+  {
+  public:
+    typedef  KKThreadPool*  KKThreadPoolPtr;
+
+    typedef  std::function<void ()>  TaskFunc;
+
+    /**
+     *@param[in]  _name        Name used in error messages.
+     *@param[in]  _numThreads  Number of worker threads; zero indicates to use one per processor.
+     */
+    KKThreadPool (const KKStr&  _name,
+                  kkuint32      _numThreads
+                 );
+
+    /** @brief  Waits for all queued tasks to complete and then stops the worker threads. */
+    ~KKThreadPool ();
+
+    kkMemSize  MemoryConsumedEstimated ()  const;
+
+    const KKStr&  Name       ()  const  {return name;}
+    kkuint32      NumThreads ()  const  {return numThreads;}
+
+    /** @brief  Queues 'task' for execution by the next available worker thread. */
+    void  AddTask (TaskFunc  task);
+
+    /**
+     *@brief  Blocks until every task added so far has completed.
+     *@details  If any of the tasks threw an exception, a KKException describing the first one
+     * will be thrown once all tasks have completed.
+     */
+    void  WaitForAllTasks ();
+
+    /**
+     *@brief  Calls 'body' for every index in the range [0, count) spreading them across 'numThreads' threads.
+     *@details  Indexes are handed out in ascending order; returns after all of them have been processed.
+     */
+    static  void  ParallelFor (kkuint32                         numThreads,
+                               kkuint32                         count,
+                               std::function<void (kkuint32)>   body
+                              );
+
+    /**
+     *@brief  Same as the static 'ParallelFor' but using the worker threads of this pool;  for callers that make many
+     * passes and should not start new threads for each one.
+     *@details  Runs serially on the callers thread when the pool has no worker threads.  Waits for every task
+     * in the pool to complete, not just the ones it added.
+     */
+    void  ParallelFor (kkuint32                         count,
+                       std::function<void (kkuint32)>   body
+                      );
+
+    /** @brief  Converts the requested number of threads to the number that will actually be used; 0 = one per processor. */
+    static  kkuint32  ResolveNumThreads (kkuint32  requested);
+
+  private:
+    void  RunTask (TaskFunc&  task);
+
+    void  WorkerLoop ();
+
+    kkuint32                  busyCount;     /**< Number of tasks currently being executed by worker threads. */
+    KKStr                     exceptionText; /**< Text of first exception thrown by a task; cleared by 'WaitForAllTasks'. */
+    std::mutex                mutex;
+    KKStr                     name;
+    kkuint32                  numThreads;
+    bool                      shutdown;
+    std::deque<TaskFunc>      tasks;
+    std::condition_variable   tasksAvailable;
+    std::condition_variable   tasksCompleted;
+    std::vector<std::thread>  workers;
+  };  /* KKThreadPool */
+
+  typedef  KKThreadPool::KKThreadPoolPtr  KKThreadPoolPtr;
+
+#define  _KKThreadPool_Defined_
+
+}  /* KKB */
+
+#endif
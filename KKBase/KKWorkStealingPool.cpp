@@ -0,0 +1,238 @@
+/* KKWorkStealingPool.cpp -- Worker threads with a task queue each that take work from one another when idle.
+ * Copyright (C) 2012-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#include "FirstIncludes.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKException.h"
+#include "KKThreadPool.h"
+#include "KKWorkStealingPool.h"
+using namespace KKB;
+
+
+namespace
+{
+  // Identifies the pool and queue of the worker thread that is running;  lets 'AddTask' put tasks added by a
+  // worker on its own queue.
+  thread_local  const KKWorkStealingPool*  currentPool   = NULL;
+  thread_local  kkuint32                   currentWorker = 0;
+}
+
+
+
+KKWorkStealingPool::KKWorkStealingPool (const KKStr&  _name,
+                                        kkuint32      _numThreads
+                                       ):
+  exceptionText  (),
+  mutex          (),
+  name           (_name),
+  nextQueue      (0),
+  numThreads     (KKThreadPool::ResolveNumThreads (_numThreads)),
+  numSteals      (0),
+  outstanding    (0),
+  queued         (0),
+  queues         (),
+  shutdown       (false),
+  tasksAvailable (),
+  tasksCompleted (),
+  workers        ()
+{
+  if  (numThreads > 1)
+  {
+    queues.reserve (numThreads);
+    for  (kkuint32 x = 0;  x < numThreads;  ++x)
+      queues.push_back (unique_ptr<WorkerQueue> (new WorkerQueue ()));
+
+    workers.reserve (numThreads);
+    for  (kkuint32 x = 0;  x < numThreads;  ++x)
+      workers.push_back (std::thread (&KKWorkStealingPool::WorkerLoop, this, x));
+  }
+}
+
+
+
+KKWorkStealingPool::~KKWorkStealingPool ()
+{
+  {
+    unique_lock<std::mutex>  lock (mutex);
+    tasksCompleted.wait (lock, [this] {return outstanding.load () == 0;});
+    shutdown = true;
+  }
+  tasksAvailable.notify_all ();
+
+  for  (auto&  w: workers)
+  {
+    if  (w.joinable ())
+      w.join ();
+  }
+  workers.clear ();
+}
+
+
+
+kkMemSize  KKWorkStealingPool::MemoryConsumedEstimated ()  const
+{
+  return  (kkMemSize)(sizeof (KKWorkStealingPool) +
+                      name.MemoryConsumedEstimated () +
+                      exceptionText.MemoryConsumedEstimated () +
+                      workers.size () * sizeof (std::thread) +
+                      queues.size () * sizeof (WorkerQueue) +
+                      (kkMemSize)queued.load () * sizeof (TaskFunc)
+                     );
+}
+
+
+
+void  KKWorkStealingPool::RunTask (TaskFunc&  task)
+{
+  KKStr  errMsg;
+  try
+  {
+    task ();
+  }
+  catch  (const KKException&  e)
+  {
+    errMsg = "KKWorkStealingPool[" + name + "]  KKException: " + e.ToString ();
+  }
+  catch  (const std::exception&  e)
+  {
+    errMsg = "KKWorkStealingPool[" + name + "]  std::exception: " + e.what ();
+  }
+  catch  (...)
+  {
+    errMsg = "KKWorkStealingPool[" + name + "]  exception(...) trapped.";
+  }
+
+  if  (!errMsg.Empty ())
+  {
+    lock_guard<std::mutex>  lock (mutex);
+    if  (exceptionText.Empty ())
+      exceptionText = errMsg;
+  }
+}  /* RunTask */
+
+
+
+void  KKWorkStealingPool::AddTask (TaskFunc  task)
+{
+  if  (workers.empty ())
+  {
+    // Serial mode;  execute on the callers thread.
+    RunTask (task);
+    return;
+  }
+
+  kkuint32  queueIdx = (currentPool == this) ? currentWorker : (nextQueue++ % numThreads);
+
+  outstanding++;
+  {
+    WorkerQueue&  q = *(queues[queueIdx]);
+    lock_guard<std::mutex>  lock (q.mutex);
+    q.tasks.push_back (std::move (task));
+  }
+  queued++;
+
+  // Taking 'mutex' makes sure that a worker that just found nothing to do is either still ahead of its check
+  // of 'queued' or already waiting for this notification.
+  {
+    lock_guard<std::mutex>  lock (mutex);
+  }
+  tasksAvailable.notify_one ();
+}  /* AddTask */
+
+
+
+bool  KKWorkStealingPool::TakeTask (kkuint32   workerIdx,
+                                    TaskFunc&  task
+                                   )
+{
+  {
+    // Own queue;  newest first.
+    WorkerQueue&  q = *(queues[workerIdx]);
+    lock_guard<std::mutex>  lock (q.mutex);
+    if  (!q.tasks.empty ())
+    {
+      task = std::move (q.tasks.back ());
+      q.tasks.pop_back ();
+      queued--;
+      return  true;
+    }
+  }
+
+  // Someone else's queue;  oldest first.
+  for  (kkuint32 offset = 1;  offset < numThreads;  ++offset)
+  {
+    WorkerQueue&  q = *(queues[(workerIdx + offset) % numThreads]);
+    lock_guard<std::mutex>  lock (q.mutex);
+    if  (!q.tasks.empty ())
+    {
+      task = std::move (q.tasks.front ());
+      q.tasks.pop_front ();
+      queued--;
+      numSteals++;
+      return  true;
+    }
+  }
+
+  return  false;
+}  /* TakeTask */
+
+
+
+void  KKWorkStealingPool::WorkerLoop (kkuint32  workerIdx)
+{
+  currentPool   = this;
+  currentWorker = workerIdx;
+
+  while  (true)
+  {
+    TaskFunc  task;
+    if  (!TakeTask (workerIdx, task))
+    {
+      unique_lock<std::mutex>  lock (mutex);
+      tasksAvailable.wait (lock, [this] {return shutdown  ||  (queued.load () > 0);});
+      if  (shutdown  &&  (queued.load () == 0))
+        break;
+      continue;
+    }
+
+    RunTask (task);
+
+    if  (--outstanding == 0)
+    {
+      lock_guard<std::mutex>  lock (mutex);
+      tasksCompleted.notify_all ();
+    }
+  }
+
+  currentPool = NULL;
+}  /* WorkerLoop */
+
+
+
+void  KKWorkStealingPool::WaitForAllTasks ()
+{
+  KKStr  errMsg;
+  {
+    unique_lock<std::mutex>  lock (mutex);
+    tasksCompleted.wait (lock, [this] {return outstanding.load () == 0;});
+    errMsg = exceptionText;
+    exceptionText = "";
+  }
+
+  if  (!errMsg.Empty ())
+    throw KKException (errMsg);
+}  /* WaitForAllTasks */
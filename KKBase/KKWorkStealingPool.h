@@ -0,0 +1,107 @@
+/* KKWorkStealingPool.h -- Worker threads with a task queue each that take work from one another when idle.
+ * Copyright (C) 2012-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#if  !defined(_KKWORKSTEALINGPOOL_)
+#define  _KKWORKSTEALINGPOOL_
+
+WarningsLowered()
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+WarningsRestored()
+
+#include "KKStr.h"
+
+
+namespace KKB
+{
+  /**
+   *@class  KKWorkStealingPool
+   *@brief  A fixed number of worker threads, each with a queue of its own, that steal from each other when idle.
+   *@details Suited to a large number of short tasks of uneven length, or to tasks that add further tasks, where
+   * one shared queue such as that of 'KKThreadPool' becomes the bottle neck.  A task added by one of the
+   * workers goes on that worker's own queue and is taken from the back, newest first;  a task added from any
+   * other thread is dealt out to the queues in turn.  A worker that runs out of work takes the oldest task
+   * from the front of another worker's queue.  There is no ordering between tasks.
+   *
+   * As with 'KKThreadPool' a pool of one thread or less creates no threads and runs each task on the callers
+   * thread as it is added, and an exception thrown by a task is retained and rethrown as a KKException by
+   * 'WaitForAllTasks'.
+   */
+  class  KKWorkStealingPool
+  {
+  public:
+    typedef  KKWorkStealingPool*  KKWorkStealingPoolPtr;
+
+    typedef  std::function<void ()>  TaskFunc;
+
+    /**
+     *@param[in]  _name        Name used in error messages.
+     *@param[in]  _numThreads  Number of worker threads; zero indicates to use one per processor.
+     */
+    KKWorkStealingPool (const KKStr&  _name,
+                        kkuint32      _numThreads
+                       );
+
+    /** @brief  Waits for all queued tasks to complete and then stops the worker threads. */
+    ~KKWorkStealingPool ();
+
+    kkMemSize  MemoryConsumedEstimated ()  const;
+
+    const KKStr&  Name       ()  const  {return name;}
+    kkuint32      NumThreads ()  const  {return numThreads;}
+    kkuint64      NumSteals  ()  const  {return numSteals.load ();}  /**< Tasks run by a worker other than the one they were queued on. */
+
+    /** @brief  Queues 'task';  may be called from any thread including the pool's own workers. */
+    void  AddTask (TaskFunc  task);
+
+    /**
+     *@brief  Blocks until every task added so far has completed.
+     *@details  If any of the tasks threw an exception, a KKException describing the first one
+     * will be thrown once all tasks have completed.
+     */
+    void  WaitForAllTasks ();
+
+  private:
+    struct  WorkerQueue
+    {
+      std::mutex            mutex;
+      std::deque<TaskFunc>  tasks;
+    };
+
+    void  RunTask (TaskFunc&  task);
+
+    bool  TakeTask (kkuint32   workerIdx,
+                    TaskFunc&  task
+                   );
+
+    void  WorkerLoop (kkuint32  workerIdx);
+
+    KKStr                                        exceptionText;  /**< Text of first exception thrown by a task; cleared by 'WaitForAllTasks'. */
+    std::mutex                                   mutex;          /**< Guards 'exceptionText' and the waits on the condition variables. */
+    KKStr                                        name;
+    std::atomic<kkuint32>                        nextQueue;      /**< Queue that the next task added from outside the pool goes on. */
+    kkuint32                                     numThreads;
+    std::atomic<kkuint64>                        numSteals;
+    std::atomic<kkint64>                         outstanding;    /**< Tasks added but not yet completed. */
+    std::atomic<kkint64>                         queued;         /**< Tasks sitting in one of the queues. */
+    std::vector<std::unique_ptr<WorkerQueue> >   queues;
+    bool                                         shutdown;
+    std::condition_variable                      tasksAvailable;
+    std::condition_variable                      tasksCompleted;
+    std::vector<std::thread>                     workers;
+  };  /* KKWorkStealingPool */
+
+  typedef  KKWorkStealingPool::KKWorkStealingPoolPtr  KKWorkStealingPoolPtr;
+
+#define  _KKWorkStealingPool_Defined_
+
+}  /* KKB */
+
+#endif
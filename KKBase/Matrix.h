@@ -141,6 +141,8 @@ namespace  KKB
 
     Matrix<T>       Inverse ();
 
+    kkMemSize       MemoryConsumedEstimated ()  const;
+
     kkuint32        NumOfCols () const  {return numOfCols;}
 
     kkuint32        NumOfRows () const  {return numOfRows;}
@@ -299,9 +301,9 @@ namespace  KKB
   template<typename T>
   Matrix<T>::Matrix ():
 
-    alignment   (64),
     data        (NULL),
     dataArea    (NULL),
+    alignment   (64),
     numOfCols   (0),
     numOfRows   (0),
     rows        (NULL),
@@ -1049,6 +1051,14 @@ namespace  KKB
   }  /* GetCol */
 
 
+
+  template<typename T>
+  kkMemSize  Matrix<T>::MemoryConsumedEstimated ()  const
+  {
+    return  sizeof (*this) + totNumCells * sizeof (T) + numOfRows * (sizeof (T*) + sizeof (Row<T>));
+  }
+
+
 #if  !defined(DBL_EPSILON)
 #define DBL_EPSILON    2.2204460492503131e-016
 #endif
@@ -1393,10 +1403,11 @@ namespace  KKB
                             T**       z
                            ) const
   {
-    kkuint32  m, l, iter, i, k;
+    kkuint32  m, l, iter, k;
+    kkint32   i;   // Signed;  the inner loop below counts down to 'l' which can be 0.
     T  s, r, p, g, f, dd, c, b;
 
-    for (i = 1; i < n; ++i)
+    for (i = 1; i < (kkint32)n; ++i)
       e[i - 1] = e[i];
 
     e[n - 1] = 0.0;
@@ -1433,7 +1444,7 @@ namespace  KKB
           s = c = 1.0;
           p = 0.0;
 
-          for (i = m - 1; i >= l; i--)
+          for (i = (kkint32)m - 1; i >= (kkint32)l; i--)
           {
             f = s * e[i];
             b = c * e[i];
@@ -1463,7 +1474,7 @@ namespace  KKB
 
           }  /* for (i) */
 
-          if ((r == 0.0) && (i >= l))
+          if ((r == 0.0) && (i >= (kkint32)l))
             continue;
 
           d[l] -= p;
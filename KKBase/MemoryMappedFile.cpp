@@ -0,0 +1,182 @@
+/* MemoryMappedFile.cpp -- Read only memory mapping of an entire file.
+ * Copyright (C) 1994-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#include "FirstIncludes.h"
+#include <iostream>
+#if  defined(WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#include "MemoryMappedFile.h"
+#include "KKException.h"
+using namespace KKB;
+
+
+
+#if  defined(WIN32)
+
+MemoryMappedFile::MemoryMappedFile (const KKStr&  _fileName):
+    data          (NULL),
+    fileHandle    (NULL),
+    fileName      (_fileName),
+    mappingHandle (NULL),
+    size          (0)
+{
+  HANDLE  h = CreateFileA (fileName.Str (), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  KKCheck (h != INVALID_HANDLE_VALUE, "MemoryMappedFile   Could not open: " << fileName)
+  fileHandle = h;
+
+  LARGE_INTEGER  fileSize;
+  if  (!GetFileSizeEx (h, &fileSize))
+  {
+    UnMap ();
+    KKCheck (false, "MemoryMappedFile   Could not determine size of: " << fileName)
+  }
+  size = (kkuint64)fileSize.QuadPart;
+  if  (size == 0)
+    return;
+
+  mappingHandle = CreateFileMapping (h, NULL, PAGE_READONLY, 0, 0, NULL);
+  if  (mappingHandle)
+    data = (const uchar*)MapViewOfFile (mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+  if  (!data)
+  {
+    UnMap ();
+    KKCheck (false, "MemoryMappedFile   Could not map: " << fileName)
+  }
+}
+
+
+
+void  MemoryMappedFile::UnMap ()
+{
+  if  (data)
+    UnmapViewOfFile (data);
+  if  (mappingHandle)
+    CloseHandle ((HANDLE)mappingHandle);
+  if  (fileHandle)
+    CloseHandle ((HANDLE)fileHandle);
+  data          = NULL;
+  mappingHandle = NULL;
+  fileHandle    = NULL;
+}  /* UnMap */
+
+
+
+void  MemoryMappedFile::Advise (AccessPattern  pattern)
+{
+  // Windows has no equivalent of 'madvise' for mapped views.
+  (void)pattern;
+}
+
+
+
+void  MemoryMappedFile::WillNeed (kkuint64  offset,
+                                  kkuint64  len
+                                 )
+{
+  (void)offset;
+  (void)len;
+}
+
+#else
+
+MemoryMappedFile::MemoryMappedFile (const KKStr&  _fileName):
+    data          (NULL),
+    fileHandle    (NULL),
+    fileName      (_fileName),
+    mappingHandle (NULL),
+    size          (0)
+{
+  int  fd = open (fileName.Str (), O_RDONLY);
+  KKCheck (fd >= 0, "MemoryMappedFile   Could not open: " << fileName)
+
+  struct stat  st;
+  if  (fstat (fd, &st) != 0)
+  {
+    close (fd);
+    KKCheck (false, "MemoryMappedFile   Could not determine size of: " << fileName)
+  }
+  size = (kkuint64)st.st_size;
+  if  (size == 0)
+  {
+    close (fd);
+    return;
+  }
+
+  void*  m = mmap (NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the descriptor is closed.
+  close (fd);
+  KKCheck (m != MAP_FAILED, "MemoryMappedFile   Could not map: " << fileName)
+  data = (const uchar*)m;
+}
+
+
+
+void  MemoryMappedFile::UnMap ()
+{
+  if  (data)
+    munmap ((void*)data, (size_t)size);
+  data = NULL;
+}  /* UnMap */
+
+
+
+void  MemoryMappedFile::Advise (AccessPattern  pattern)
+{
+  if  (!data)
+    return;
+
+  int  advice = MADV_NORMAL;
+  if  (pattern == AccessPattern::Sequential)
+    advice = MADV_SEQUENTIAL;
+  else if  (pattern == AccessPattern::Random)
+    advice = MADV_RANDOM;
+
+  madvise ((void*)data, (size_t)size, advice);
+}  /* Advise */
+
+
+
+void  MemoryMappedFile::WillNeed (kkuint64  offset,
+                                  kkuint64  len
+                                 )
+{
+  if  ((!data)  ||  (offset >= size))
+    return;
+
+  if  (len > (size - offset))
+    len = size - offset;
+
+  // 'madvise' requires a page aligned address.
+  kkuint64  pageSize = (kkuint64)sysconf (_SC_PAGESIZE);
+  kkuint64  start = offset - (offset % pageSize);
+  madvise ((void*)(data + start), (size_t)(len + (offset - start)), MADV_WILLNEED);
+}  /* WillNeed */
+
+#endif
+
+
+
+MemoryMappedFile::~MemoryMappedFile ()
+{
+  UnMap ();
+}
+
+
+
+kkMemSize  MemoryMappedFile::MemoryConsumedEstimated ()  const
+{
+  // The mapped pages belong to the operating system's file cache.
+  return  sizeof (*this) + fileName.MemoryConsumedEstimated ();
+}
@@ -0,0 +1,75 @@
+/* MemoryMappedFile.h -- Read only memory mapping of an entire file.
+ * Copyright (C) 1994-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#if  !defined(_KKB_MEMORYMAPPEDFILE_)
+#define  _KKB_MEMORYMAPPEDFILE_
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+
+
+namespace KKB
+{
+  /**
+   *@class  MemoryMappedFile
+   *@brief  Maps an entire file read only into the address space of the process.
+   *@details  The contents are accessed through 'Data' and are valid for the life of the instance.  Pages are
+   * brought in by the operating system as they are touched so opening a large file is cheap;  'Advise' and
+   * 'WillNeed' let the caller tell the operating system how the pages are going to be used.  The hints are
+   * ignored on platforms that do not support them.
+   */
+  class  MemoryMappedFile
+  {
+  public:
+    typedef  MemoryMappedFile*  MemoryMappedFilePtr;
+
+    enum  class  AccessPattern
+    {
+      Normal,
+      Sequential,   /**< Pages will be read in order;  read ahead aggressively and release them soon after. */
+      Random        /**< Pages will be read in no particular order;  do not read ahead.                     */
+    };
+
+    /**
+     *@brief  Maps 'fileName';  throws 'KKException' if it can not be opened or mapped.
+     *@details  An empty file is not mapped;  'Data' returns NULL and 'Size' zero.
+     */
+    MemoryMappedFile (const KKStr&  _fileName);
+
+    ~MemoryMappedFile ();
+
+    kkMemSize  MemoryConsumedEstimated ()  const;
+
+    const uchar*   Data     ()  const  {return data;}
+    const KKStr&   FileName ()  const  {return fileName;}
+    kkuint64       Size     ()  const  {return size;}
+
+    /** @brief  Tells the operating system how the whole mapping is going to be accessed. */
+    void  Advise (AccessPattern  pattern);
+
+    /** @brief  Asks the operating system to start reading the pages covering the range ['offset', 'offset' + 'len'). */
+    void  WillNeed (kkuint64  offset,
+                    kkuint64  len
+                   );
+
+  private:
+    MemoryMappedFile (const MemoryMappedFile&);
+    MemoryMappedFile&  operator= (const MemoryMappedFile&);
+
+    void  UnMap ();
+
+    const uchar*  data;
+    void*         fileHandle;      /**< WIN32 HANDLE's;  not used elsewhere. */
+    KKStr         fileName;
+    void*         mappingHandle;
+    kkuint64      size;
+  };  /* MemoryMappedFile */
+
+  typedef  MemoryMappedFile::MemoryMappedFilePtr  MemoryMappedFilePtr;
+
+#define  _MemoryMappedFile_Defined_
+
+}  /* KKB */
+
+#endif
@@ -0,0 +1,252 @@
+/* MorphKernels.cpp -- Vectorized building blocks for binary morphological operations.
+ * Copyright (C) 1994-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#include "FirstIncludes.h"
+#include <functional>
+#include <string.h>
+#include <vector>
+#include <iostream>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#if  defined(_M_X64)  ||  defined(__x86_64__)  ||  defined(__SSE2__)  ||  (defined(_M_IX86_FP)  &&  (_M_IX86_FP >= 2))
+#  define  MORPHKERNELS_SSE2
+#  include <emmintrin.h>
+#endif
+
+
+#include "MorphKernels.h"
+#include "KKException.h"
+using namespace KKB;
+
+
+
+void  MorphKernels::Binarize (const kkuint8*  src,
+                              kkuint8*        dest,
+                              kkint32         count,
+                              kkuint8         backgroundPixelTH,
+                              bool            foregroundBelowTH
+                             )
+{
+  kkint32  x = 0;
+
+#if  defined(MORPHKERNELS_SSE2)
+  // A saturated subtraction is non zero exactly when the first operand is greater than the second.
+  const __m128i  th   = _mm_set1_epi8 ((char)backgroundPixelTH);
+  const __m128i  zero = _mm_setzero_si128 ();
+  const __m128i  ones = _mm_set1_epi8 ((char)0xFF);
+  for  (;  (x + 16) <= count;  x += 16)
+  {
+    __m128i  p = _mm_loadu_si128 ((const __m128i*)(src + x));
+    __m128i  d = foregroundBelowTH ? _mm_subs_epu8 (th, p) : _mm_subs_epu8 (p, th);
+    _mm_storeu_si128 ((__m128i*)(dest + x), _mm_xor_si128 (_mm_cmpeq_epi8 (d, zero), ones));
+  }
+#endif
+
+  if  (foregroundBelowTH)
+  {
+    for  (;  x < count;  ++x)
+      dest[x] = (src[x] < backgroundPixelTH) ? 255 : 0;
+  }
+  else
+  {
+    for  (;  x < count;  ++x)
+      dest[x] = (src[x] > backgroundPixelTH) ? 255 : 0;
+  }
+}  /* Binarize */
+
+
+
+void  MorphKernels::Max (const kkuint8*  a,
+                         const kkuint8*  b,
+                         kkuint8*        dest,
+                         kkint32         count
+                        )
+{
+  kkint32  x = 0;
+#if  defined(MORPHKERNELS_SSE2)
+  for  (;  (x + 16) <= count;  x += 16)
+    _mm_storeu_si128 ((__m128i*)(dest + x), _mm_max_epu8 (_mm_loadu_si128 ((const __m128i*)(a + x)), _mm_loadu_si128 ((const __m128i*)(b + x))));
+#endif
+  for  (;  x < count;  ++x)
+    dest[x] = (a[x] > b[x]) ? a[x] : b[x];
+}  /* Max */
+
+
+
+void  MorphKernels::Min (const kkuint8*  a,
+                         const kkuint8*  b,
+                         kkuint8*        dest,
+                         kkint32         count
+                        )
+{
+  kkint32  x = 0;
+#if  defined(MORPHKERNELS_SSE2)
+  for  (;  (x + 16) <= count;  x += 16)
+    _mm_storeu_si128 ((__m128i*)(dest + x), _mm_min_epu8 (_mm_loadu_si128 ((const __m128i*)(a + x)), _mm_loadu_si128 ((const __m128i*)(b + x))));
+#endif
+  for  (;  x < count;  ++x)
+    dest[x] = (a[x] < b[x]) ? a[x] : b[x];
+}  /* Min */
+
+
+
+void  MorphKernels::WindowMax (const kkuint8*  src,
+                               kkuint8*        dest,
+                               kkint32         count,
+                               kkint32         windowLen
+                              )
+{
+  memcpy (dest, src, count);
+  for  (kkint32 offset = 1;  offset < windowLen;  ++offset)
+    Max (dest, src + offset, dest, count);
+}  /* WindowMax */
+
+
+
+void  MorphKernels::WindowMin (const kkuint8*  src,
+                               kkuint8*        dest,
+                               kkint32         count,
+                               kkint32         windowLen
+                              )
+{
+  memcpy (dest, src, count);
+  for  (kkint32 offset = 1;  offset < windowLen;  ++offset)
+    Min (dest, src + offset, dest, count);
+}  /* WindowMin */
+
+
+
+kkint32  MorphKernels::CountNonZero (const kkuint8*  src,
+                                     kkint32         count
+                                    )
+{
+  kkint32  x = 0;
+  kkint32  total = 0;
+
+#if  defined(MORPHKERNELS_SSE2)
+  // Each non zero byte becomes a 1 and '_mm_sad_epu8' adds them up 8 at a time.
+  const __m128i  zero = _mm_setzero_si128 ();
+  const __m128i  one  = _mm_set1_epi8 (1);
+  __m128i  sums = _mm_setzero_si128 ();
+  for  (;  (x + 16) <= count;  x += 16)
+  {
+    __m128i  nonZero = _mm_andnot_si128 (_mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i*)(src + x)), zero), one);
+    sums = _mm_add_epi64 (sums, _mm_sad_epu8 (nonZero, zero));
+  }
+  total = _mm_cvtsi128_si32 (sums) + _mm_cvtsi128_si32 (_mm_unpackhi_epi64 (sums, sums));
+#endif
+
+  for  (;  x < count;  ++x)
+  {
+    if  (src[x] != 0)
+      ++total;
+  }
+  return  total;
+}  /* CountNonZero */
+
+
+
+MorphRowFilter::MorphRowFilter (kkint32                 _height,
+                                kkint32                 _width,
+                                MorphOp::StructureType  _structure,
+                                kkint32                 _bias,
+                                bool                    _dilate,
+                                kkuint8                 _backgroundPixelTH,
+                                bool                    _foregroundBelowTH,
+                                RowSink                 _sink
+                               ):
+    bias              (_bias),
+    binRows           (),
+    dilate            (_dilate),
+    backgroundPixelTH (_backgroundPixelTH),
+    foregroundBelowTH (_foregroundBelowTH),
+    height            (_height),
+    horzRows          (),
+    padded            (),
+    result            (),
+    rowsAdded         (0),
+    rowsEmitted       (0),
+    sink              (_sink),
+    structure         (_structure),
+    width             (_width),
+    window            (),
+    windowLen         (2 * _bias + 1)
+{
+  KKCheck (bias >= 0, "MorphRowFilter   Invalid bias: " << bias)
+  binRows.resize  (windowLen * width);
+  horzRows.resize (windowLen * width);
+  result.resize   (width);
+  window.resize   (windowLen, NULL);
+
+  // Pixels past the left and right edges never change the result.
+  padded.assign (width + 2 * bias, dilate ? 0 : 255);
+}
+
+
+
+MorphRowFilter::~MorphRowFilter ()
+{
+}
+
+
+
+void  MorphRowFilter::AddRow (const kkuint8*  srcRow)
+{
+  KKCheck (rowsAdded < height, "MorphRowFilter::AddRow   More than " << height << " rows added.")
+
+  kkint32   row = rowsAdded;
+  kkuint8*  binRow = BinRow (row);
+  MorphKernels::Binarize (srcRow, binRow, width, backgroundPixelTH, foregroundBelowTH);
+
+  memcpy (&padded[bias], binRow, width);
+  if  (dilate)
+    MorphKernels::WindowMax (&padded[0], HorzRow (row), width, windowLen);
+  else
+    MorphKernels::WindowMin (&padded[0], HorzRow (row), width, windowLen);
+
+  ++rowsAdded;
+
+  if  (row >= bias)
+    EmitRow (row - bias);
+
+  if  (rowsAdded == height)
+  {
+    while  (rowsEmitted < height)
+      EmitRow (rowsEmitted);
+  }
+}  /* AddRow */
+
+
+
+void  MorphRowFilter::EmitRow (kkint32  row)
+{
+  kkint32  firstRow = (row - bias < 0) ? 0 : (row - bias);
+  kkint32  lastRow  = (row + bias >= height) ? (height - 1) : (row + bias);
+
+  for  (kkint32 x = 0;  x < windowLen;  ++x)
+  {
+    kkint32  r = row - bias + x;
+    window[x] = ((r >= firstRow)  &&  (r <= lastRow)) ? BinRow (r) : NULL;
+  }
+
+  // A square reduces the horizontally reduced rows;  a cross combines the column with the centre row.
+  bool  square = (structure == MorphOp::StructureType::stSquare);
+  kkuint8*  dest = &result[0];
+  memcpy (dest, HorzRow (row), width);
+  for  (kkint32 r = firstRow;  r <= lastRow;  ++r)
+  {
+    if  (r == row)
+      continue;
+    const kkuint8*  src = square ? HorzRow (r) : BinRow (r);
+    if  (dilate)
+      MorphKernels::Max (dest, src, dest, width);
+    else
+      MorphKernels::Min (dest, src, dest, width);
+  }
+
+  ++rowsEmitted;
+  sink (row, &window[0], dest);
+}  /* EmitRow */
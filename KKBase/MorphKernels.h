@@ -0,0 +1,141 @@
+/* MorphKernels.h -- Vectorized building blocks for binary morphological operations.
+ * Copyright (C) 1994-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#if  !defined(_KKB_MORPHKERNELS_)
+#define  _KKB_MORPHKERNELS_
+
+WarningsLowered()
+#include <functional>
+#include <vector>
+WarningsRestored()
+
+#include "KKBaseTypes.h"
+#include "MorphOp.h"
+
+
+namespace KKB
+{
+  /**
+   *@namespace  MorphKernels
+   *@brief  Byte wise operations on rows of pixels used by the binary morphological operators in 'Raster'.
+   *@details  Binarized rows hold 255 for foreground and 0 for background so the maximum of a set of pixels is
+   * their dilation and the minimum their erosion.  On x86 the rows are processed 16 pixels at a time with SSE2;
+   * other platforms use plain loops.  Source and destination may be the same row unless noted otherwise.
+   */
+  namespace  MorphKernels
+  {
+    /**
+     *@brief  Sets 'dest'[x] to 255 where 'src'[x] is a foreground pixel and 0 otherwise.
+     *@param[in]  foregroundBelowTH  When false foreground pixels are those greater than 'backgroundPixelTH', when
+     *            true those less than it;  the same rule as 'Raster::ForegroundPixel'.
+     */
+    void  Binarize (const kkuint8*  src,
+                    kkuint8*        dest,
+                    kkint32         count,
+                    kkuint8         backgroundPixelTH,
+                    bool            foregroundBelowTH
+                   );
+
+    void  Max (const kkuint8*  a,
+               const kkuint8*  b,
+               kkuint8*        dest,
+               kkint32         count
+              );
+
+    void  Min (const kkuint8*  a,
+               const kkuint8*  b,
+               kkuint8*        dest,
+               kkint32         count
+              );
+
+    /** @brief  'dest'[x] = max ('src'[x], ..., 'src'[x + 'windowLen' - 1]);  'src' must hold 'count' + 'windowLen' - 1 pixels and not overlap 'dest'. */
+    void  WindowMax (const kkuint8*  src,
+                     kkuint8*        dest,
+                     kkint32         count,
+                     kkint32         windowLen
+                    );
+
+    /** @brief  'dest'[x] = min ('src'[x], ..., 'src'[x + 'windowLen' - 1]);  'src' must hold 'count' + 'windowLen' - 1 pixels and not overlap 'dest'. */
+    void  WindowMin (const kkuint8*  src,
+                     kkuint8*        dest,
+                     kkint32         count,
+                     kkint32         windowLen
+                    );
+
+    kkint32  CountNonZero (const kkuint8*  src,
+                           kkint32         count
+                          );
+  }  /* MorphKernels */
+
+
+
+  /**
+   *@class  MorphRowFilter
+   *@brief  Streams the rows of an image through a binary dilation or erosion with a square or cross structure.
+   *@details  Rows are added in order, top to bottom, and binarized as they come in.  As soon as the rows needed
+   * for an output row are available the 'sink' is called with it;  after the last row is added every row has
+   * been delivered.  Only 2 * 'bias' + 1 rows are kept so a filter can feed its output straight into another
+   * filter, letting a chain of operations be done in one pass over the image.
+   *
+   * The structure is separable:  each row is first reduced horizontally and the result of the structure is
+   * then the reduction over the rows above and below.  Pixels outside the image are treated as background when
+   * dilating and as foreground when eroding, the same as clipping the structure to the image.  This gives the
+   * same results as 'Raster::IsThereANeighbor' and 'Raster::Fit'.
+   */
+  class  MorphRowFilter
+  {
+  public:
+    /**
+     *@brief  Receives each output row.
+     *@param[in]  row     Index of the row being delivered.
+     *@param[in]  window  The 2 * 'bias' + 1 binarized input rows centered on 'row';  NULL for rows outside the image.
+     *@param[in]  result  The dilated or eroded row;  holds 255 or 0.
+     */
+    typedef  std::function<void (kkint32 row, kkuint8 const* const* window, const kkuint8* result)>  RowSink;
+
+    MorphRowFilter (kkint32                 _height,
+                    kkint32                 _width,
+                    MorphOp::StructureType  _structure,
+                    kkint32                 _bias,
+                    bool                    _dilate,
+                    kkuint8                 _backgroundPixelTH,
+                    bool                    _foregroundBelowTH,
+                    RowSink                 _sink
+                   );
+
+    ~MorphRowFilter ();
+
+    kkint32  Bias      ()  const  {return bias;}
+    kkint32  RowsAdded ()  const  {return rowsAdded;}
+
+    /** @brief  Adds the next row of the source image;  'width' pixels. */
+    void  AddRow (const kkuint8*  srcRow);
+
+  private:
+    kkuint8*  BinRow  (kkint32 row)  {return &binRows [(row % windowLen) * width];}
+    kkuint8*  HorzRow (kkint32 row)  {return &horzRows[(row % windowLen) * width];}
+
+    void  EmitRow (kkint32  row);
+
+    kkint32                 bias;
+    std::vector<kkuint8>    binRows;            /**< Last 'windowLen' binarized rows.                      */
+    bool                    dilate;
+    kkuint8                 backgroundPixelTH;
+    bool                    foregroundBelowTH;
+    kkint32                 height;
+    std::vector<kkuint8>    horzRows;           /**< Horizontal reduction of each row in 'binRows'.        */
+    std::vector<kkuint8>    padded;             /**< Binarized row with 'bias' pixels of padding each side. */
+    std::vector<kkuint8>    result;
+    kkint32                 rowsAdded;
+    kkint32                 rowsEmitted;
+    RowSink                 sink;
+    MorphOp::StructureType  structure;
+    kkint32                 width;
+    std::vector<const kkuint8*>  window;
+    kkint32                 windowLen;
+  };  /* MorphRowFilter */
+
+}  /* KKB */
+
+#endif
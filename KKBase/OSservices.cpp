@@ -22,6 +22,9 @@
 #include <dirent.h>
 #include <limits>
 #include <unistd.h>
+#if  defined(__linux__)
+#include <sys/syscall.h>
+#endif
 #endif
 
 #include <chrono>
@@ -1434,6 +1437,13 @@ kkuint64  KKB::osGetSystemTimeInMiliSecs ()
 
 
 
+double  KKB::osGetElapsedSecs ()
+{
+  return  std::chrono::duration<double> (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+
+
 #ifdef  WIN32
 DateTime  KKB::osGetLocalDateTime ()
 {
@@ -2171,10 +2181,12 @@ kkint32  KKB::osGetThreadId ()
   //DWORD WINAPI threadId = GetCurrentThreadId ();
   DWORD threadId = GetCurrentThreadId();
   return  threadId;
+#elif  defined(__linux__)
+  return  (kkint32)syscall (SYS_gettid);
 #else
-  cerr << endl << "KKB::osGetThreadId   ***ERROR***  Do noty support thgis method!!!" << endl << endl;
-  //pid_t threadID = gettid (void);
-  return -1;
+  // No portable numeric thread id;  a hash of the std::thread::id is unique enough for the
+  // purposes of GoalKeeper which only compares it against other live threads.
+  return  (kkint32)(std::hash<std::thread::id> () (std::this_thread::get_id ()) & 0x7fffffff);
 #endif
 }
 
@@ -2205,8 +2217,9 @@ void  KKB::osSleepMiliSecs (kkuint32  numMiliSecs)
   #ifdef  WIN32
     Sleep (numMiliSecs);
   #else
-    int  numSecsToSleep = (numMiliSecs / 1000);
-    sleep (numSecsToSleep);
+    // 'sleep' only takes whole seconds;  anything under a second would not sleep at all.
+    usleep ((numMiliSecs % 1000) * 1000);
+    sleep (numMiliSecs / 1000);
   #endif
 }
 
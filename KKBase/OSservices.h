@@ -157,6 +157,13 @@ namespace KKB
    */
   char           osGetDriveLetter (const KKStr&  pathName);   
 
+  /**
+   *@brief  Returns seconds on a steady clock that has an arbitrary starting point.
+   *@details  Use the difference between two calls to time some function in wall clock terms;  unlike
+   * 'osGetSystemTimeUsed' the result is not inflated by other threads of the process running at the same time.
+   */
+  double         osGetElapsedSecs ();
+
   KKStrPtr       osGetEnvVariable (const KKStr&  _varName);
 
   KKB::DateTime  osGetFileDateTime (const KKStr& fileName);
@@ -3,14 +3,18 @@
  * For conditions of distribution and use, see copyright notice in KKB.h
  */
 #include "FirstIncludes.h"
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <math.h>
 #include <limits.h>
 #include <fstream>
 #include <map>
+#include <mutex>
 #include <string.h>
 #include <string>
 #include <iostream>
+#include <unordered_set>
 #include <vector>
 #include "MemoryDebug.h"
 using namespace std;
@@ -37,6 +41,7 @@ using namespace std;
 #include "KKException.h"
 #include "kku_fftw.h"
 #include "Matrix.h"
+#include "MorphKernels.h"
 #include "MorphOpBinarize.h"
 #include "MorphOpDilation.h"
 #include "MorphOpErosion.h"
@@ -50,9 +55,6 @@ using namespace std;
 using namespace KKB;
 
 
-volatile GoalKeeperPtr  Raster::goalKeeper = NULL;
-volatile bool           Raster::rasterInitialized = false;
-
 
 
 KKStr  KKB::ColorChannelToKKStr (ColorChannels  c)
@@ -95,82 +97,96 @@ KKStr&  KKB::operator<< (KKStr& lhs, ColorChannels rhs)
 
 
 
-void  Raster::Initialize ()
+namespace
 {
-  GoalKeeper::Create ("Raster", goalKeeper);
+  /**
+   *@brief  Supports detection of memory leaks in Raster; maintains list of 'Raster' objects created.
+   *@details  The list is split into shards by address so that threads creating and destroying Raster
+   * instances at the same time rarely contend for the same mutex.
+   */
+  struct  RasterInstanceShard
+  {
+    std::mutex                     mutex;
+    std::unordered_set<RasterPtr>  instances;
+  };
+
+  const  kkuint32  numRasterInstanceShards = 64;
+
+#if  defined(KKB_RASTER_INSTANCE_TRACKING)
+  std::atomic<bool>  trackRasterInstances (true);
+#else
+  std::atomic<bool>  trackRasterInstances (false);
+#endif
 
-  goalKeeper->StartBlock ();
-  if  (!rasterInitialized)
+  RasterInstanceShard*  RasterInstanceShards ()
   {
-    rasterInitialized = true;
-    atexit (Raster::FinalCleanUp);
+    // Intentionally never deleted so that Raster instances destroyed during program exit can still be removed.
+    static  RasterInstanceShard*  shards = new RasterInstanceShard[numRasterInstanceShards];
+    return  shards;
+  }
+
+  RasterInstanceShard&  RasterInstanceShardFor (RasterPtr  r)
+  {
+    // Low bits of a heap address are mostly alignment;  skip them.
+    size_t  addr = (size_t)r;
+    return  RasterInstanceShards ()[((addr >> 4) ^ (addr >> 12)) % numRasterInstanceShards];
   }
-  goalKeeper->EndBlock ();
 }
 
 
 
-void  Raster::FinalCleanUp ()
+void  Raster::TrackRasterInstances (bool  _trackRasterInstances)
 {
-  GoalKeeper::Destroy (goalKeeper);
-  goalKeeper = NULL;
+  trackRasterInstances.store (_trackRasterInstances);
 }
 
 
 
-/** Supports detection of memory leaks in Raster; maintains list of 'Raster' objects created. */
-map<RasterPtr, RasterPtr>  Raster::allocatedRasterInstances;
-
-void  Raster::AddRasterInstance (const RasterPtr  r)
+bool  Raster::TrackingRasterInstances ()
 {
-  if  (!rasterInitialized)
-    Initialize ();
+  return  trackRasterInstances.load ();
+}
 
-  goalKeeper->StartBlock ();
 
-  map<RasterPtr, RasterPtr>::iterator  idx;
-  idx = allocatedRasterInstances.find (r);
-  if  (idx != allocatedRasterInstances.end ())
-  {
+
+void  Raster::AddRasterInstance (const RasterPtr  r)
+{
+  RasterInstanceShard&  shard = RasterInstanceShardFor (r);
+  std::lock_guard<std::mutex>  lock (shard.mutex);
+  if  (!shard.instances.insert (r).second)
     cerr << std::endl << "Raster::AddRasterInstance   ***ERROR***   Raster Instance[" << r << "] Already in list." << std::endl << std::endl;
-  }
-  else
-  {
-    allocatedRasterInstances.insert (pair<RasterPtr, RasterPtr> (r, r));
-  }
-  goalKeeper->EndBlock ();
 }
 
 
 
 void  Raster::RemoveRasterInstance (const RasterPtr  r)
 {
-  if  (!rasterInitialized)
-    Initialize ();
-
-  goalKeeper->StartBlock ();
-
-  map<RasterPtr, RasterPtr>::iterator  idx;
-  idx = allocatedRasterInstances.find (r);
-  if  (idx == allocatedRasterInstances.end ())
-  {
+  RasterInstanceShard&  shard = RasterInstanceShardFor (r);
+  std::lock_guard<std::mutex>  lock (shard.mutex);
+  if  (shard.instances.erase (r) == 0)
     cerr << std::endl << "Raster::RemoveRasterInstance   ***ERROR***   Raster Instance[" << r << "] Not Found." << std::endl << std::endl;
-  }
-  else
-  {
-    allocatedRasterInstances.erase (idx);
-  }
-  goalKeeper->EndBlock ();
 }  /* RemoveRasterInstance */
 
 
 
 void  Raster::PrintOutListOfAllocatedrasterInstances ()
 {
-  map<RasterPtr, RasterPtr>::iterator  idx;
-  for  (idx = allocatedRasterInstances.begin ();  idx != allocatedRasterInstances.end ();  ++idx)
+  if  (!trackRasterInstances.load ())
+    return;
+
+  // Collect and sort so the output does not depend on how instances were spread across shards.
+  vector<RasterPtr>  instances;
+  RasterInstanceShard*  shards = RasterInstanceShards ();
+  for  (kkuint32 shardIdx = 0;  shardIdx < numRasterInstanceShards;  ++shardIdx)
+  {
+    RasterInstanceShard&  shard = shards[shardIdx];
+    std::lock_guard<std::mutex>  lock (shard.mutex);
+    instances.insert (instances.end (), shard.instances.begin (), shard.instances.end ());
+  }
+  sort (instances.begin (), instances.end ());
+
+  for  (auto  r: instances)
   {
-    RasterPtr  r = idx->first;
     cout << r << "\t"
              << r->Height () << "\t"
              << r->Width  () << "\t"
@@ -236,9 +252,15 @@ Raster::Raster ():
 
   red                  (NULL),
   green                (NULL),
-  blue                 (NULL)
+  blue                 (NULL),
+
+  instanceTracked      (false)
 {
-  AddRasterInstance (this);
+  if  (trackRasterInstances.load (std::memory_order_relaxed))
+  {
+    AddRasterInstance (this);
+    instanceTracked = true;
+  }
 }
 
 
@@ -496,7 +518,8 @@ Raster::Raster (kkint32         _height,
 
 Raster::~Raster ()
 {
-  RemoveRasterInstance (this);
+  if  (instanceTracked)
+    RemoveRasterInstance (this);
   CleanUpMemory ();
 }
 
@@ -1398,100 +1421,183 @@ void  Raster::Dilation (MorphOp::StructureType  _structure,
 
 
 
-void  Raster::Dilation (RasterPtr  dest)  const
+kkint32  Raster::Dilation3x3Row (kkint32                row,
+                                kkuint8 const* const*  window,
+                                const kkuint8*         body,
+                                kkuint8*               destRow
+                               )  const
 {
-  if  ((dest->Height () != height)  ||  (dest->Width () != width)  ||  (dest->Color ()  != color))
-    dest->ReSize (height, width, color);
+  // 'window' holds the binarized rows above, at and below 'row';  the border rules are the ones
+  // 'Dilation (RasterPtr)' has always used:  the corners are left as background and the bottom row
+  // does not look at its own centre pixel.
+  const kkuint8*  above = window[0];
+  const kkuint8*  cur   = window[1];
+  const kkuint8*  below = window[2];
+  kkint32  lastCol = width - 1;
 
-  kkuint8**  srcRows  = Green ();
+  memset (destRow, 0, width);
 
-  kkuint8*   destArea = dest->GreenArea ();
-  kkuint8**  destRows = dest->Green     ();
+  if  (row == 0)
+  {
+    for  (kkint32 c = 1;  c < lastCol;  ++c)
+    {
+      kkuint8  v = cur[c - 1] | cur[c] | cur[c + 1];
+      if  (below)
+        v |= below[c - 1] | below[c] | below[c + 1];
+      destRow[c] = v;
+    }
+  }
 
-  memset (destArea, 0, totPixels);
-  kkint32  pixelCount = 0;
+  else if  (row == (height - 1))
+  {
+    for  (kkint32 c = 1;  c < lastCol;  ++c)
+      destRow[c] = cur[c - 1] | cur[c + 1] | above[c - 1] | above[c] | above[c + 1];
+  }
 
-  //  Take care of Top and Bottom rows.
+  else if  (width > 1)
   {
-    kkuint8*  srcRow0    = srcRows[0];
-    kkuint8*  srcRow1    = srcRows[1];
-    kkuint8*  srcRowBot0 = srcRows[height - 1];
-    kkuint8*  srcRowBot1 = srcRows[height - 2];
+    destRow[0]       = above[0]       | above[1]           | cur[0]       | cur[1]           | below[0]       | below[1];
+    destRow[lastCol] = above[lastCol] | above[lastCol - 1] | cur[lastCol] | cur[lastCol - 1] | below[lastCol] | below[lastCol - 1];
+    if  (width > 2)
+      memcpy (destRow + 1, body + 1, width - 2);
+  }
 
-    kkuint8*  destRow0 = destRows[0];
-    kkuint8*  destRowBot = destRows[height - 1];
-    for (kkint32 c = 1;  c < (width  - 1);  ++c)
-    {
-      if  ((srcRow0[c - 1] > backgroundPixelTH)  ||  (srcRow0[c] > backgroundPixelTH)  ||  (srcRow0[c + 1] > backgroundPixelTH)  ||
-           (srcRow1[c - 1] > backgroundPixelTH)  ||  (srcRow1[c] > backgroundPixelTH)  ||  (srcRow1[c + 1] > backgroundPixelTH)
-          )
-      {
-        destRow0[c] = 255;
-        ++pixelCount;
-      }
+  return  MorphKernels::CountNonZero (destRow, width);
+}  /* Dilation3x3Row */
 
-      if  ((srcRowBot0[c - 1] > backgroundPixelTH)  ||                                           (srcRowBot0[c + 1] > backgroundPixelTH)  ||
-           (srcRowBot1[c - 1] > backgroundPixelTH)  ||  (srcRowBot1[c] > backgroundPixelTH)  ||  (srcRowBot1[c + 1] > backgroundPixelTH)
-          )
-      {
-        destRowBot[c] = 255;
-        ++pixelCount;
-      }
+
+
+kkint32  Raster::Erosion3x3Row (kkint32                row,
+                               kkuint8 const* const*  window,
+                               const kkuint8*         body,
+                               kkuint8*               destRow
+                              )  const
+{
+  // Same border rules as 'Dilation3x3Row'.
+  const kkuint8*  above = window[0];
+  const kkuint8*  cur   = window[1];
+  const kkuint8*  below = window[2];
+  kkint32  lastCol = width - 1;
+
+  memset (destRow, 0, width);
+
+  if  (row == 0)
+  {
+    for  (kkint32 c = 1;  c < lastCol;  ++c)
+    {
+      kkuint8  v = cur[c - 1] & cur[c] & cur[c + 1];
+      if  (below)
+        v &= below[c - 1] & below[c] & below[c + 1];
+      destRow[c] = v;
     }
   }
 
-  // Take care of left and right columns
+  else if  (row == (height - 1))
   {
-    for  (kkint32 r = 1;  r < (height - 1);  ++r)
+    for  (kkint32 c = 1;  c < lastCol;  ++c)
+      destRow[c] = cur[c - 1] & cur[c + 1] & above[c - 1] & above[c] & above[c + 1];
+  }
+
+  else if  (width > 1)
+  {
+    destRow[0]       = above[0]       & above[1]           & cur[0]       & cur[1]           & below[0]       & below[1];
+    destRow[lastCol] = above[lastCol] & above[lastCol - 1] & cur[lastCol] & cur[lastCol - 1] & below[lastCol] & below[lastCol - 1];
+    if  (width > 2)
+      memcpy (destRow + 1, body + 1, width - 2);
+  }
+
+  return  MorphKernels::CountNonZero (destRow, width);
+}  /* Erosion3x3Row */
+
+
+
+kkint32  Raster::EdgeRow (kkint32         row,
+                         const kkuint8*  cur,
+                         const kkuint8*  eroded,
+                         kkuint8*        destRow
+                        )  const
+{
+  // Only foreground pixels inside the border are written;  the rest of 'destRow' is left as it was.
+  if  ((row < 1)  ||  (row >= (height - 1)))
+    return  0;
+
+  kkint32  pixelCount = 0;
+  for  (kkint32 c = 1;  c < (width - 1);  ++c)
+  {
+    if  (cur[c])
     {
-      if  ((srcRows[r - 1][0] > backgroundPixelTH)  ||  (srcRows[r - 1][1] > backgroundPixelTH)  ||
-           (srcRows[r    ][0] > backgroundPixelTH)  ||  (srcRows[r    ][1] > backgroundPixelTH)  ||
-           (srcRows[r + 1][0] > backgroundPixelTH)  ||  (srcRows[r + 1][1] > backgroundPixelTH)
-          )
+      if  (eroded[c])
       {
-        destRows[r][0] = 255;
-        ++pixelCount;
+        destRow[c] = backgroundPixelValue;
       }
-
-
-      if  ((srcRows[r - 1][width - 1] > backgroundPixelTH)  ||  (srcRows[r - 1][width - 2] > backgroundPixelTH)  ||
-           (srcRows[r    ][width - 1] > backgroundPixelTH)  ||  (srcRows[r    ][width - 2] > backgroundPixelTH)  ||
-           (srcRows[r + 1][width - 1] > backgroundPixelTH)  ||  (srcRows[r + 1][width - 2] > backgroundPixelTH)
-          )
+      else
       {
-        destRows[r][width - 1] = 255;
+        destRow[c] = foregroundPixelValue;
         ++pixelCount;
       }
     }
   }
+  return  pixelCount;
+}  /* EdgeRow */
 
-  // Take care of main Body
-  {
-    for  (kkint32 r = 1;  r < (height - 1);  ++r)
-    {
-      kkuint8*  srcRow0 = srcRows[r - 1];
-      kkuint8*  srcRow1 = srcRows[r    ];
-      kkuint8*  srcRow2 = srcRows[r + 1];
 
-      for  (kkint32 c = 1;  c < (width - 1);  ++c)
-      {
-        if  ((srcRow0[c - 1] > backgroundPixelTH)  ||  (srcRow0[c] > backgroundPixelTH)  ||  (srcRow0[c + 1] > backgroundPixelTH)  ||
-             (srcRow1[c - 1] > backgroundPixelTH)  ||  (srcRow1[c] > backgroundPixelTH)  ||  (srcRow1[c + 1] > backgroundPixelTH)  ||
-             (srcRow2[c - 1] > backgroundPixelTH)  ||  (srcRow2[c] > backgroundPixelTH)  ||  (srcRow2[c + 1] > backgroundPixelTH)
-            )
-        {
-          destRows[r][c] = 255;
-          ++pixelCount;
-        }
-      }
+
+void  Raster::Dilation (RasterPtr  dest)  const
+{
+  if  ((dest->Height () != height)  ||  (dest->Width () != width)  ||  (dest->Color ()  != color))
+    dest->ReSize (height, width, color);
+
+  kkuint8**  destRows = dest->Green ();
+  kkint32    pixelCount = 0;
+
+  MorphRowFilter  dilation (height, width, StructureType::stSquare, 1, true, backgroundPixelTH, false,
+    [this, destRows, &pixelCount] (kkint32 row, kkuint8 const* const* window, const kkuint8* body)
+    {
+      pixelCount += Dilation3x3Row (row, window, body, destRows[row]);
     }
-  }
+  );
+
+  for  (kkint32 r = 0;  r < height;  ++r)
+    dilation.AddRow (green[r]);
 
   dest->foregroundPixelCount = pixelCount;
 }  /* Dilation */
 
 
 
+void  Raster::DoubleDilation (RasterPtr  dest)  const
+{
+  if  ((dest->Height () != height)  ||  (dest->Width () != width)  ||  (dest->Color ()  != color))
+    dest->ReSize (height, width, color);
+
+  kkuint8**  destRows = dest->Green ();
+  kkint32    pixelCount = 0;
+
+  MorphRowFilter  second (height, width, StructureType::stSquare, 1, true, backgroundPixelTH, false,
+    [this, destRows, &pixelCount] (kkint32 row, kkuint8 const* const* window, const kkuint8* body)
+    {
+      pixelCount += Dilation3x3Row (row, window, body, destRows[row]);
+    }
+  );
+
+  // Each row of the first dilation is handed to the second as soon as it is complete.
+  vector<kkuint8>  firstRow (width);
+  MorphRowFilter  first (height, width, StructureType::stSquare, 1, true, backgroundPixelTH, false,
+    [this, &second, &firstRow] (kkint32 row, kkuint8 const* const* window, const kkuint8* body)
+    {
+      Dilation3x3Row (row, window, body, &firstRow[0]);
+      second.AddRow (&firstRow[0]);
+    }
+  );
+
+  for  (kkint32 r = 0;  r < height;  ++r)
+    first.AddRow (green[r]);
+
+  dest->foregroundPixelCount = pixelCount;
+}  /* DoubleDilation */
+
+
+
 void  Raster::Dilation (RasterPtr  dest,
                         MaskTypes  mask
                        )
@@ -1500,26 +1606,20 @@ void  Raster::Dilation (RasterPtr  dest,
   if  ((dest->Height () != height)  ||  (dest->Width () != width)  ||  (dest->Color ()  != color))
     dest->ReSize (height, width, color);
 
-  kkuint8*   destArea = dest->GreenArea ();
-  kkuint8**  destRows = dest->Green     ();
-
-  memset (destArea, 0, totPixels);
-  kkint32  pixelCount = 0;
+  kkuint8**  destRows = dest->Green ();
+  kkint32    pixelCount = 0;
 
-  // Take care of main Body
-  {
-    for  (kkint32 r = 0;  r < height;  ++r)
+  MorphRowFilter  dilation (height, width, MorphOp::MaskShapes (mask), MorphOp::Biases (mask), true, backgroundPixelTH, ForegroundBelowTH (),
+    [destRows, &pixelCount, this] (kkint32 row, kkuint8 const* const* window, const kkuint8* result)
     {
-      for  (kkint32 c = 0;  c < width;  ++c)
-      {
-        if  (IsThereANeighbor (mask, r, c)) 
-        {
-          destRows[r][c] = 255;
-          ++pixelCount;
-        }
-      }
+      (void)window;
+      memcpy (destRows[row], result, width);
+      pixelCount += MorphKernels::CountNonZero (result, width);
     }
-  }
+  );
+
+  for  (kkint32 r = 0;  r < height;  ++r)
+    dilation.AddRow (green[r]);
 
   dest->foregroundPixelCount = pixelCount;
 }  /* Dilation */
@@ -1692,112 +1792,50 @@ void  Raster::FillHole (RasterPtr  mask)
   if  ((mask->Height () != height)  |  (mask->Width () != width))
     mask->ReSize (height, width, false);
 
-  kkuint8*   srcArea = this->GreenArea ();
-
+  kkuint8*   srcArea  = this->GreenArea ();
   kkuint8*   maskArea = mask->GreenArea ();
-  kkuint8**  maskRows = mask->Green ();
 
-  memset (maskArea, 0, totPixels);
+  MorphKernels::Binarize (srcArea, maskArea, totPixels, backgroundPixelTH, false);
 
-  for  (kkint32 x = 0;  x < totPixels;  ++x)
-  {
-    if  (srcArea[x] > backgroundPixelTH)
-      maskArea[x] = 255;
-  }
-
-  {
-    // Check Top and Bottom Mask Rows for background pixels and flag them as having access to the border.
-    kkuint8*  rowTop = maskRows[0];
-    kkuint8*  rowBot = maskRows[height - 1];
+  // Background pixels on the border have access to the edge of the image;  flag them with a '1' and then
+  // flood out from them through the cross shaped neighborhood of each flagged pixel.
+  kkint32  lastRow = height - 1;
+  kkint32  lastCol = width  - 1;
+  vector<kkint32>  toVisit;
 
-    for  (kkint32 c = 0;  c < width;  ++c)
+  auto  flag = [maskArea, &toVisit] (kkint32 x)
     {
-      if  (rowTop[c] == 0)
-        rowTop[c] = 1;
-      if  (rowBot[c] == 0)
-        rowBot[c] = 1;
-    }
-  }
+      if  (maskArea[x] == 0)
+      {
+        maskArea[x] = 1;
+        toVisit.push_back (x);
+      }
+    };
 
+  for  (kkint32 c = 0;  c < width;  ++c)
   {
-    // Check Left and Right columns for background pixels and flag them as having access to the border.
-    kkuint8*  leftCol  = maskArea;
-    kkuint8*  rightCol = maskArea + (width - 1);
-    for  (kkint32  r = 0;  r < height;  ++r)
-    {
-      if  (*leftCol == 0)
-        *leftCol = 1;
-      if  (*rightCol == 0)
-        *rightCol = 1;
-
-      leftCol  += width;
-      rightCol += width;
-    }
+    flag (c);
+    flag (lastRow * width + c);
   }
 
-  // We will not iteratively scan the Mask image for pixels that have access top the edge of the image.
-  // We will repeat the following loop until no pixels get flagged.
-  bool  fillInFound = false;
-  do
+  for  (kkint32 r = 0;  r < height;  ++r)
   {
-    fillInFound = false;
-
-    // Scan from TopLeft  to  BotRight
-    kkuint8*  rowPrev  = maskArea;
-    kkuint8*  rowCur   = rowPrev + width;
-    kkuint8*  rowNext  = rowCur  + width;
-
-    for  (kkint32 r = 1;  r < (height - 1);  ++r)
-    {
-      for  (kkint32 c = 1;  c < (width - 1);  ++c)
-      {
-        if  (rowCur[c] == 0)
-        {
-          if  ((rowPrev[c    ] == 1)  ||  
-               (rowCur [c - 1] == 1)  ||
-               (rowCur [c + 1] == 1)  ||
-               (rowNext[c    ] == 1)
-              )
-          {
-            rowCur[c] = 1;
-            fillInFound = true;
-          }
-        }
-      }
-
-      rowPrev += width;
-      rowCur  += width;
-      rowNext += width;
-    }
-    
-    // Scan from Bot-Right  to  Top-Left
-    rowPrev  = maskRows[height - 1];
-    rowCur   = rowPrev - width;
-    rowNext  = rowCur  - width;
+    flag (r * width);
+    flag (r * width + lastCol);
+  }
 
-    for  (kkint32 r = (height - 2);  r > 0;  --r)
-    {
-      for  (kkint32 c = (width - 2);  c > 0;  --c)
-      {
-        if  (rowCur[c] == 0)
-        {
-          if  ((rowPrev[c    ] == 1)  ||  
-               (rowCur [c - 1] == 1)  ||
-               (rowCur [c + 1] == 1)  ||
-               (rowNext[c    ] == 1)
-              )
-          {
-            rowCur[c] = 1;
-            fillInFound = true;
-          }
-        }
-      }
+  while  (!toVisit.empty ())
+  {
+    kkint32  x = toVisit.back ();
+    toVisit.pop_back ();
 
-      rowPrev -= width;
-      rowCur  -= width;
-      rowNext -= width;
-    }
-  }  while  (fillInFound);
+    kkint32  r = x / width;
+    kkint32  c = x - r * width;
+    if  (r > 0)        flag (x - width);
+    if  (r < lastRow)  flag (x + width);
+    if  (c > 0)        flag (x - 1);
+    if  (c < lastCol)  flag (x + 1);
+  }
 
   // At this point the only pixels in the mask image that contain a '0' are the ones that are in holes.
   // We will now fill the corresponding pixel locations in the original image with the ForegroundPixelValue.
@@ -1979,88 +2017,18 @@ void  Raster::Erosion (RasterPtr  dest)  const
   if  ((dest->Height () != height)  |  (dest->Width () != width))
     dest->ReSize (height, width, false);
 
-  kkuint8*   destArea = dest->GreenArea ();
   kkuint8**  destRows = dest->Green ();
+  kkint32    pixelCount = 0;
 
-  kkuint8**  srcRows = green;
-
-  memset (destArea, 0, totPixels);
-  kkint32  pixelCount = 0;
-
-  //  Take care of Top and Bottom rows.
-  {
-    kkuint8*  srcRow0         = srcRows[0];
-    kkuint8*  srcRow1         = srcRows[1];
-    kkuint8*  srcRowBot0      = srcRows[height - 1];
-    kkuint8*  srcRowBot1      = srcRows[height - 2];
-
-    kkuint8*  destRow0 = destRows[0];
-    kkuint8*  destRowBot = destRows[height - 1];
-    for (kkint32 c = 1;  c < (width  - 1);  ++c)
+  MorphRowFilter  erosion (height, width, StructureType::stSquare, 1, false, backgroundPixelTH, false,
+    [this, destRows, &pixelCount] (kkint32 row, kkuint8 const* const* window, const kkuint8* body)
     {
-      if  ((srcRow0[c - 1] > backgroundPixelTH)  &&  (srcRow0[c] > backgroundPixelTH)  &&  (srcRow0[c + 1] > backgroundPixelTH)  &&
-           (srcRow1[c - 1] > backgroundPixelTH)  &&  (srcRow1[c] > backgroundPixelTH)  &&  (srcRow1[c + 1] > backgroundPixelTH)
-          )
-      {
-        destRow0[c] = 255;
-        ++pixelCount;
-      }
-
-      if  ((srcRowBot0[c - 1] > backgroundPixelTH)  &&                                           (srcRowBot0[c + 1] > backgroundPixelTH)  &&
-           (srcRowBot1[c - 1] > backgroundPixelTH)  &&  (srcRowBot1[c] > backgroundPixelTH)  &&  (srcRowBot1[c + 1] > backgroundPixelTH)
-          )
-      {
-        destRowBot[c] = 255;
-        ++pixelCount;
-      }
+      pixelCount += Erosion3x3Row (row, window, body, destRows[row]);
     }
-  }
+  );
 
-  // Take care of left and right columns
-  {
-    for  (kkint32 r = 1;  r < (height - 1);  ++r)
-    {
-      if  ((srcRows[r - 1][0] > backgroundPixelTH)  &&  (srcRows[r - 1][1] > backgroundPixelTH)  &&
-           (srcRows[r    ][0] > backgroundPixelTH)  &&  (srcRows[r    ][1] > backgroundPixelTH)  &&
-           (srcRows[r + 1][0] > backgroundPixelTH)  &&  (srcRows[r + 1][1] > backgroundPixelTH)
-          )
-      {
-        destRows[r][0] = 255;
-        ++pixelCount;
-      }
-
-      if  ((srcRows[r - 1][width - 1] > backgroundPixelTH)  &&  (srcRows[r - 1][width - 2] > backgroundPixelTH)  &&
-           (srcRows[r    ][width - 1] > backgroundPixelTH)  &&  (srcRows[r    ][width - 2] > backgroundPixelTH)  &&
-           (srcRows[r + 1][width - 1] > backgroundPixelTH)  &&  (srcRows[r + 1][width - 2] > backgroundPixelTH)
-          )
-      {
-        destRows[r][width - 1] = 255;
-        ++pixelCount;
-      }
-    }
-  }
-
-  // Take care of main Body
-  {
-    for  (kkint32 r = 1;  r < (height - 1);  ++r)
-    {
-      kkuint8*  srcRow0 = srcRows[r - 1];
-      kkuint8*  srcRow1 = srcRows[r    ];
-      kkuint8*  srcRow2 = srcRows[r + 1];
-
-      for  (kkint32 c = 1;  c < (width - 1);  ++c)
-      {
-        if  ((srcRow0[c - 1] > backgroundPixelTH)  &&  (srcRow0[c] > backgroundPixelTH)  &&  (srcRow0[c + 1] > backgroundPixelTH)  &&
-             (srcRow1[c - 1] > backgroundPixelTH)  &&  (srcRow1[c] > backgroundPixelTH)  &&  (srcRow1[c + 1] > backgroundPixelTH)  &&
-             (srcRow2[c - 1] > backgroundPixelTH)  &&  (srcRow2[c] > backgroundPixelTH)  &&  (srcRow2[c + 1] > backgroundPixelTH)
-            )
-        {
-          destRows[r][c] = 255;
-          ++pixelCount;
-        }
-      }
-    }
-  }
+  for  (kkint32 r = 0;  r < height;  ++r)
+    erosion.AddRow (green[r]);
 
   dest->foregroundPixelCount = pixelCount;
 }  /* Erosion*/
@@ -2075,30 +2043,20 @@ void  Raster::Erosion (RasterPtr  dest,
   if  ((dest->Height () != height)  |  (dest->Width () != width))
     dest->ReSize (height, width, false);
 
-  kkuint8*   destArea = dest->GreenArea ();
   kkuint8**  destRows = dest->Green ();
+  kkint32    pixelCount = 0;
 
-  memset (destArea, 0, totPixels);
-  kkint32  pixelCount = 0;
-
-  // Take care of main Body
-  {
-    for  (kkint32 r = 0;  r < height;  ++r)
+  MorphRowFilter  erosion (height, width, MorphOp::MaskShapes (mask), MorphOp::Biases (mask), false, backgroundPixelTH, ForegroundBelowTH (),
+    [destRows, &pixelCount, this] (kkint32 row, kkuint8 const* const* window, const kkuint8* result)
     {
-      kkuint8*  rowData = green[r];
-      for  (kkint32 c = 0;  c < width;  ++c)
-      {
-        if  (ForegroundPixel (rowData[c]))
-        {
-          if  (Fit (mask, r, c))
-          {
-            destRows[r][c] = 255;
-            ++pixelCount;
-          }
-        }
-      }
+      (void)window;
+      memcpy (destRows[row], result, width);
+      pixelCount += MorphKernels::CountNonZero (result, width);
     }
-  }
+  );
+
+  for  (kkint32 r = 0;  r < height;  ++r)
+    erosion.AddRow (green[r]);
 
   dest->foregroundPixelCount = pixelCount;
 }  /* Erosion*/
@@ -2585,55 +2543,63 @@ void  Raster::Edge (RasterPtr  dest)
   if  ((dest->Height () != height)  |  (dest->Width () != width))
     dest->ReSize (height, width, false);
 
-  kkint32   lastRow = height - 1;
-  kkint32   lastCol = width - 1;
+  kkuint8**  destRows = dest->Green ();
+  kkint32    pixelCount = 0;
 
-  kkuint8** origRows = Green ();
+  MorphRowFilter  erosion (height, width, StructureType::stSquare, 1, false, backgroundPixelTH, ForegroundBelowTH (),
+    [this, destRows, &pixelCount] (kkint32 row, kkuint8 const* const* window, const kkuint8* eroded)
+    {
+      pixelCount += EdgeRow (row, window[1], eroded, destRows[row]);
+    }
+  );
 
-  kkuint8*  origRowLast = NULL;
-  kkuint8*  origRowCur  = NULL;
-  kkuint8*  origRowNext = NULL;
-   
-  kkint32   pixelCount = 0;
+  for  (kkint32 r = 0;  r < height;  ++r)
+    erosion.AddRow (green[r]);
 
-  kkuint8** destRows = dest->Green ();
+  dest->foregroundPixelCount = pixelCount;
+}  /*  Edge */
 
-  for  (kkint32 r = 1;  r < lastRow;  ++r)
-  {
-    origRowLast = origRows[r - 1];
-    origRowCur  = origRows[r];
-    origRowNext = origRows[r + 1];
 
-    kkuint8*  destRow = destRows[r];
 
-    for  (kkint32 c = 1; c < lastCol; c++)
+void  Raster::ErosionEdge (RasterPtr  eroded,
+                           RasterPtr  edge
+                          )  const
+{
+  if  ((eroded->Height () != height)  |  (eroded->Width () != width))
+    eroded->ReSize (height, width, false);
+
+  if  ((edge->Height () != height)  |  (edge->Width () != width))
+    edge->ReSize (height, width, false);
+
+  kkuint8**  erodedRows  = eroded->Green ();
+  kkuint8**  edgeRows    = edge->Green ();
+  kkint32    erodedCount = 0;
+  kkint32    edgeCount   = 0;
+
+  // The edge is judged by the eroded image's thresholds, as 'eroded->Edge (edge)' would.
+  MorphRowFilter  edgeFilter (height, width, StructureType::stSquare, 1, false, eroded->backgroundPixelTH, eroded->ForegroundBelowTH (),
+    [eroded, edgeRows, &edgeCount] (kkint32 row, kkuint8 const* const* window, const kkuint8* erodedAgain)
     {
-      if  (ForegroundPixel (origRowCur[c]))
-      {
-        if ((ForegroundPixel (origRowLast [c - 1])) &&
-            (ForegroundPixel (origRowLast [c]    )) &&
-            (ForegroundPixel (origRowLast [c + 1])) &&
-            (ForegroundPixel (origRowCur  [c - 1])) &&
-            (ForegroundPixel (origRowCur  [c]    )) &&
-            (ForegroundPixel (origRowCur  [c + 1])) &&
-            (ForegroundPixel (origRowNext [c - 1])) &&
-            (ForegroundPixel (origRowNext [c]    )) &&
-            (ForegroundPixel (origRowNext [c + 1]))
-           )
-        {
-          destRow[c] = backgroundPixelValue;
-        }
-        else
-        {
-          destRow[c] = foregroundPixelValue;
-          ++pixelCount;
-        }
-      }
+      edgeCount += eroded->EdgeRow (row, window[1], erodedAgain, edgeRows[row]);
     }
-  }
+  );
 
-  dest->foregroundPixelCount = pixelCount;
-}  /*  Edge */
+  // By the time edge row 'r' is written source rows up to 'r' + 2 have been read;  this is what
+  // allows 'edge' to be this raster.
+  MorphRowFilter  erosion (height, width, StructureType::stSquare, 1, false, backgroundPixelTH, false,
+    [this, erodedRows, &erodedCount, &edgeFilter] (kkint32 row, kkuint8 const* const* window, const kkuint8* body)
+    {
+      erodedCount += Erosion3x3Row (row, window, body, erodedRows[row]);
+      edgeFilter.AddRow (erodedRows[row]);
+    }
+  );
+
+  for  (kkint32 r = 0;  r < height;  ++r)
+    erosion.AddRow (green[r]);
+
+  eroded->foregroundPixelCount = erodedCount;
+  edge->foregroundPixelCount   = edgeCount;
+}  /* ErosionEdge */
 
 
 
@@ -3860,6 +3826,122 @@ void    Raster::ComputeCentralMoments (kkint32&  _foregroundPixelCount,
   float    mw00, mw10, mw01;
   Moments (m00, m10, m01, mw00, mw10, mw01);
 
+  CentralMomentsFromMoments (m00, m10, m01, mw00, mw10, mw01,
+                             0, 0, height - 1, width - 1,
+                             _foregroundPixelCount, weightedPixelCount, centralMoments, centralMomentsWeighted
+                            );
+}  /* ComputeCentralMoments */
+
+
+
+void    Raster::CalcAreaIntensityAndCentralMoments (kkint32&  area,
+                                                    float&    weightedSize,
+                                                    kkuint32  intensityHistBuckets[8],
+                                                    kkint32&  _foregroundPixelCount,
+                                                    float&    weightedPixelCount,
+                                                    float     centralMoments[9],
+                                                    float     centralMomentsWeighted[9]
+                                                   )  
+                                                    const
+{
+  // Foreground pixels for the moments are those greater than 'backgroundPixelTH' which are always a subset
+  // of the non zero pixels that make up the area and histogram.
+  kkint64  totalPixelValues = 0;
+
+  area = 0;
+  for  (kkint32 x = 0;  x < 8;  ++x)
+    intensityHistBuckets[x] = 0;
+
+  kkint64  m00 = 0,  m10 = 0,  m01 = 0;
+  kkint64  m00Int = 0,  m10Int = 0,  m01Int = 0;
+
+  kkint32  tlRow = height;
+  kkint32  tlCol = width;
+  kkint32  brRow = -1;
+  kkint32  brCol = -1;
+
+  maxPixVal = 0;
+
+  for  (kkint32 row = 0;  row < height;  ++row)
+  {
+    const kkuint8*  rowData = green[row];
+    kkint32  firstCol = -1;
+    kkint32  lastCol  = -1;
+    kkint32  rowCount = 0;
+    kkint64  rowColSum = 0;
+    kkint64  rowPvSum  = 0;
+
+    for  (kkint32 col = 0;  col < width;  ++col)
+    {
+      kkuint8 pv = rowData[col];
+      if  (pv == 0)
+        continue;
+
+      ++area;
+      intensityHistBuckets[freqHistBucketIdx[pv]]++;
+      totalPixelValues += pv;
+
+      if  (pv > backgroundPixelTH)
+      {
+        if  (firstCol < 0)
+          firstCol = col;
+        lastCol = col;
+
+        ++rowCount;
+        rowColSum += col;
+        rowPvSum  += pv;
+        m10Int    += col * pv;
+        if  (pv > maxPixVal)
+          maxPixVal = pv;
+      }
+    }
+
+    if  (rowCount > 0)
+    {
+      m00    += rowCount;
+      m10    += rowColSum;
+      m01    += (kkint64)row * rowCount;
+      m00Int += rowPvSum;
+      m01Int += (kkint64)row * rowPvSum;
+
+      if  (row < tlRow)  tlRow = row;
+      brRow = row;
+      if  (firstCol < tlCol)  tlCol = firstCol;
+      if  (lastCol  > brCol)  brCol = lastCol;
+    }
+  }
+
+  weightedSize = (float)totalPixelValues / (float)255.0f;
+
+  float  mw00 = (float)m00Int / (float)maxPixVal;
+  float  mw10 = (float)m10Int / (float)maxPixVal;
+  float  mw01 = (float)m01Int / (float)maxPixVal;
+
+  CentralMomentsFromMoments (m00, m10, m01, mw00, mw10, mw01,
+                             tlRow, tlCol, brRow, brCol,
+                             _foregroundPixelCount, weightedPixelCount, centralMoments, centralMomentsWeighted
+                            );
+}  /* CalcAreaIntensityAndCentralMoments */
+
+
+
+void    Raster::CentralMomentsFromMoments (kkint64   m00,
+                                           kkint64   m10,
+                                           kkint64   m01,
+                                           float     mw00,
+                                           float     mw10,
+                                           float     mw01,
+                                           kkint32   tlRow,
+                                           kkint32   tlCol,
+                                           kkint32   brRow,
+                                           kkint32   brCol,
+                                           kkint32&  _foregroundPixelCount,
+                                           float&    weightedPixelCount,
+                                           float     centralMoments[9],
+                                           float     centralMomentsWeighted[9]
+                                          )  
+                                           const
+{
   foregroundPixelCount =  (kkint32)m00;
   _foregroundPixelCount = foregroundPixelCount;
 
@@ -3900,7 +3982,7 @@ void    Raster::ComputeCentralMoments (kkint32&  _foregroundPixelCount,
   {
     maxPixVal = 0;
 
-    for  (kkint32 row = 0;  row < height;  ++row)
+    for  (kkint32 row = tlRow;  row <= brRow;  ++row)
     {
       kkuint8*  rowData = green[row];
 
@@ -3917,7 +3999,7 @@ void    Raster::ComputeCentralMoments (kkint32&  _foregroundPixelCount,
       float  rowPowW2 = deltaRowW * deltaRowW;
       float  rowPowW3 = rowPowW2  * deltaRowW;
 
-      for  (kkint32 col = 0;  col < width;  ++col)
+      for  (kkint32 col = tlCol;  col <= brCol;  ++col)
       {
         kkuint8 pv = rowData[col];
         if  (pv > backgroundPixelTH)
@@ -4054,7 +4136,7 @@ void    Raster::ComputeCentralMoments (kkint32&  _foregroundPixelCount,
                 (4.0 * cmw11 * cmw11))/((cmw20 + cmw02) * (cmw20 + cmw02)));
 
   return;
-}  /* CentralMoments */
+}  /* CentralMomentsFromMoments */
 
 
 
@@ -4483,7 +4565,8 @@ RasterPtr  Raster::FastFourier ()  const
     fftwf_execute (plan);
     fftwDestroyPlan (plan);
   #else
-    plan.Transform (src, dest);
+    // 'green' holds the same values as 'src';  the real input version does half the work.
+    plan.Transform (green, dest);
   #endif
 
   RasterPtr fourierImage = new Raster (height, width);
@@ -7211,6 +7294,8 @@ RasterPtr  Raster::BandPass (float  lowerFreqBound,    /**< Number's between 0.0
   #else
     KK_DFT2D_Float*  reversePlan = new KK_DFT2D_Float (height, width, false);
     reversePlan->Transform (dest, src);
+    delete  reversePlan;
+    reversePlan = NULL;
   #endif
 
   // We now need to transform the Fourier results back to GreayScale.
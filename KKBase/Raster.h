@@ -547,6 +547,23 @@ namespace KKB
                                                )  const;
 
 
+    /**
+     *@brief  Same results as 'CalcAreaAndIntensityFeatures (area, weightedSize, intensityHistBuckets)' followed by
+     *  'ComputeCentralMoments' but with one pass over the image less.
+     *@details  The area, intensity histogram and raw moments are gathered together in the first pass which also
+     * finds the bounding box of the foreground pixels;  the central moment pass then only visits the pixels inside
+     * that box.  Pixels are still visited in the same order so the results are identical to the separate calls.
+     */
+    void          CalcAreaIntensityAndCentralMoments (kkint32&  area,
+                                                      float&    weightedSize,
+                                                      kkuint32  intensityHistBuckets[8],
+                                                      kkint32&  _foregroundPixelCount,
+                                                      float&    weightedPixelCount,
+                                                      float     centralMoments[9],
+                                                      float     centralMomentsWeighted[9]
+                                                     )  const;
+
+
     void          CalcCentroid (kkint32&  size,
                                 kkint32&  weight,
                                 float&  rowCenter,  
@@ -631,6 +648,13 @@ namespace KKB
                             kkint32                 _foregroundCountTH
                            );
 
+    /**
+     *@brief  Places into 'dest' this image dilated twice;  same result as 'Dilation (temp)' followed by 'temp->Dilation (dest)'.
+     *@details  Both dilations are done in one pass over the image;  the intermediate image is never stored.  Its
+     * pixels are 0 or 255 so they are judged by this instance's 'backgroundPixelTH'.
+     */
+    void          DoubleDilation (RasterPtr  dest)  const;
+
     RasterPtr     CreateErodedImage (MaskTypes  mask)  const;
 
 
@@ -858,6 +882,14 @@ namespace KKB
                           )
                             const;
 
+    /**
+     *@brief  Same result as 'Erosion (eroded)' followed by 'eroded->Edge (edge)' but done in one pass over the image.
+     *@details  'edge' may be this instance;  it is only written where the source rows are no longer needed.
+     */
+    void          ErosionEdge (RasterPtr  eroded,
+                               RasterPtr  edge
+                              )  const;
+
     void          ErosionChanged (MaskTypes  mask, kkint32 row, kkint32 col);
 
     void          ErosionChanged1 (MaskTypes  mask, kkint32 row, kkint32 col);
@@ -1253,9 +1285,58 @@ namespace KKB
                                )  const;
 
 
+    /**
+     *@brief  The central moment pass of 'ComputeCentralMoments' given the raw moments from 'Moments';  only the
+     *  pixels inside the bounding box 'tlRow', 'tlCol' to 'brRow', 'brCol' are visited.
+     */
+    void  CentralMomentsFromMoments (kkint64   m00,
+                                     kkint64   m10,
+                                     kkint64   m01,
+                                     float     mw00,
+                                     float     mw10,
+                                     float     mw01,
+                                     kkint32   tlRow,
+                                     kkint32   tlCol,
+                                     kkint32   brRow,
+                                     kkint32   brCol,
+                                     kkint32&  _foregroundPixelCount,
+                                     float&    weightedPixelCount,
+                                     float     centralMoments[9],
+                                     float     centralMomentsWeighted[9]
+                                    )  const;
+
+
     void  DeleteExistingBlobIds ();
 
 
+    /**
+     *@brief  Computes one row of 'Dilation (RasterPtr)' from 'window', the binarized rows above, at and below 'row',
+     *  and 'body', their 3x3 dilation;  returns the number of foreground pixels in 'destRow'.
+     */
+    kkint32  Dilation3x3Row (kkint32                row,
+                             kkuint8 const* const*  window,
+                             const kkuint8*         body,
+                             kkuint8*               destRow
+                            )  const;
+
+    /** @brief  Same as 'Dilation3x3Row' for 'Erosion (RasterPtr)'. */
+    kkint32  Erosion3x3Row (kkint32                row,
+                            kkuint8 const* const*  window,
+                            const kkuint8*         body,
+                            kkuint8*               destRow
+                           )  const;
+
+    /**
+     *@brief  Computes one row of 'Edge (RasterPtr)' from the binarized row 'cur' and its 3x3 erosion 'eroded';
+     *  returns the number of edge pixels.
+     */
+    kkint32  EdgeRow (kkint32         row,
+                      const kkuint8*  cur,
+                      const kkuint8*  eroded,
+                      kkuint8*        destRow
+                     )  const;
+
+
     kkuint8  DeltaMagnitude (kkuint8 c1, kkuint8 c2);
 
 
@@ -1271,6 +1352,9 @@ namespace KKB
     
     bool   ForegroundPixel (kkuint8  pixel)  const;
 
+    /** @brief  True when 'ForegroundPixel' treats pixels below 'backgroundPixelTH' as foreground. */
+    bool   ForegroundBelowTH ()  const  {return  (backgroundPixelValue >= 125);}
+
 
     kkuint8  Hit (MaskTypes  mask,
                   kkint32    row, 
@@ -1368,15 +1452,24 @@ namespace KKB
     kkuint8**       blue;           // Provides row indexes into 'blueArea'.
 
 
-    //  The following code is being added to support the tracking down of memory leaks in Raster.
-    static std::map<RasterPtr, RasterPtr>  allocatedRasterInstances;
-    static volatile GoalKeeperPtr  goalKeeper;
-    static volatile bool           rasterInitialized;
-    static void  Initialize ();
-    static void  FinalCleanUp ();
+    //  The following code supports the tracking down of memory leaks in Raster.  Tracking is off unless
+    //  'KKB_RASTER_INSTANCE_TRACKING' is defined at compile time or 'TrackRasterInstances (true)' is called;
+    //  while off constructing and destroying a Raster does not touch any shared state.
+    bool  instanceTracked;   /**< 'true' = this instance was added to the tracking list and needs to be removed. */
+
     static void  AddRasterInstance (const RasterPtr  r);
     static void  RemoveRasterInstance (const RasterPtr  r);
   public:
+    /**
+     *@brief  Turns the tracking of allocated Raster instances on or off.
+     *@details  Meant to be called at start up before any Raster instances are created;  only instances
+     *  created while tracking is on will be listed by 'PrintOutListOfAllocatedrasterInstances'.
+     */
+    static void  TrackRasterInstances (bool  _trackRasterInstances);
+
+    static bool  TrackingRasterInstances ();
+
+    /** @brief  Lists every tracked Raster instance that has not been deleted yet;  nothing is listed when tracking is off. */
     static void  PrintOutListOfAllocatedrasterInstances ();
 
   };  /* Raster */
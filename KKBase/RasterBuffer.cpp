@@ -13,8 +13,11 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <chrono>
+#include <condition_variable>
 #include <istream>
 #include <iostream>
+#include <mutex>
 #include <queue>
 #include <vector>
 using namespace std;
@@ -22,7 +25,6 @@ using namespace std;
 
 #include "KKBaseTypes.h"
 #include "KKException.h"
-#include "GoalKeeper.h"
 #include "OSservices.h"
 using namespace KKB;
 
@@ -34,6 +36,36 @@ using  namespace  KKB;
 
 
 
+namespace
+{
+  typedef  std::chrono::steady_clock  WaitClock;
+
+  double  SecsSince (WaitClock::time_point  start)
+  {
+    return  std::chrono::duration<double> (WaitClock::now () - start).count ();
+  }
+}
+
+
+
+KKStr  RasterBuffer::FullPolicyToStr (FullPolicy  policy)
+{
+  if  (policy == FullPolicy::BackPressure)
+    return  "BackPressure";
+  else
+    return  "DropOldest";
+}
+
+
+
+RasterBuffer::FullPolicy  RasterBuffer::FullPolicyFromStr (const KKStr&  s)
+{
+  if  (s.EqualIgnoreCase ("BackPressure")  ||  s.EqualIgnoreCase ("Block"))
+    return  FullPolicy::BackPressure;
+  else
+    return  FullPolicy::DropOldest;
+}
+
 
 
 RasterBuffer::RasterBuffer (const KKStr&  _name,
@@ -41,20 +73,32 @@ RasterBuffer::RasterBuffer (const KKStr&  _name,
                            ):
   
     buffer               (),
-    gateKeeper           (NULL),
+    closed               (false),
+    consumerWaitSecs     (0.0),
+    freeRasters          (),
+    fullPolicy           (FullPolicy::DropOldest),
     maxNumOfBuffers      (_maxNumOfBuffers),
+    maxNumOfFreeRasters  (2 * _maxNumOfBuffers),
     memoryConsumed       (0),
+    mutex                (),
     name                 (_name),
-    rastersDropped       (0)
+    peakNumPopulated     (0),
+    producerWaitSecs     (0.0),
+    rasterAdded          (),
+    rasterRemoved        (),
+    rastersAllocated     (0),
+    rastersDropped       (0),
+    rastersReused        (0)
 {
-  GoalKeeper::Create ("RasterBuffer_" + name, gateKeeper);
-  memoryConsumed = sizeof (RasterBuffer) + gateKeeper->MemoryConsumedEstimated ();
+  memoryConsumed = sizeof (RasterBuffer) + name.MemoryConsumedEstimated ();
 }
 
 
 
 RasterBuffer::~RasterBuffer ()
 {
+  Close ();
+
   while  (buffer.size () > 0)
   {
     RasterPtr r = buffer.front ();
@@ -63,46 +107,161 @@ RasterBuffer::~RasterBuffer ()
     r = NULL;
   }
 
-  GoalKeeper::Destroy (gateKeeper);
-  gateKeeper = NULL;
+  for  (auto  r: freeRasters)
+    delete  r;
+  freeRasters.clear ();
 }
 
 
 
 void  RasterBuffer::ThrowOutOldestOccupiedBuffer ()
 {
-  gateKeeper->StartBlock ();
-
   if  (buffer.size () > 0)
   {
     RasterPtr r = buffer.front ();
     buffer.pop ();
     memoryConsumed = memoryConsumed - r->MemoryConsumedEstimated ();
-    delete  r;  
+    RecycleRasterLocked (r);
     r = NULL;
     rastersDropped++;
   }
-
-  gateKeeper->EndBlock ();
   return;
 }  /* ThrowOutOldestOccupiedBuffer */
 
 
 
+void  RasterBuffer::RecycleRasterLocked (RasterPtr  raster)
+{
+  if  ((kkint32)freeRasters.size () < maxNumOfFreeRasters)
+  {
+    freeRasters.push_back (raster);
+    memoryConsumed = memoryConsumed + raster->MemoryConsumedEstimated ();
+  }
+  else
+  {
+    delete  raster;
+  }
+}  /* RecycleRasterLocked */
+
+
 
 kkint32  RasterBuffer::NumAvailable () const 
 {
+  lock_guard<std::mutex>  lock (mutex);
   return  maxNumOfBuffers - (kkint32)buffer.size ();
 }
 
 
 kkint32  RasterBuffer::NumPopulated () const
 {
+  lock_guard<std::mutex>  lock (mutex);
   return  (kkint32)buffer.size ();
 }
 
 
+kkint32  RasterBuffer::PeakNumPopulated () const
+{
+  lock_guard<std::mutex>  lock (mutex);
+  return  peakNumPopulated;
+}
+
+
+kkint32  RasterBuffer::RastersDropped () const
+{
+  lock_guard<std::mutex>  lock (mutex);
+  return  rastersDropped;
+}
+
+
+kkint32  RasterBuffer::RastersAllocated () const
+{
+  lock_guard<std::mutex>  lock (mutex);
+  return  rastersAllocated;
+}
+
+
+kkint32  RasterBuffer::RastersReused () const
+{
+  lock_guard<std::mutex>  lock (mutex);
+  return  rastersReused;
+}
+
+
+double  RasterBuffer::ProducerWaitSecs () const
+{
+  lock_guard<std::mutex>  lock (mutex);
+  return  producerWaitSecs;
+}
+
+
+double  RasterBuffer::ConsumerWaitSecs () const
+{
+  lock_guard<std::mutex>  lock (mutex);
+  return  consumerWaitSecs;
+}
+
+
+bool  RasterBuffer::Closed () const
+{
+  lock_guard<std::mutex>  lock (mutex);
+  return  closed;
+}
+
+
+
+void  RasterBuffer::MaxNumOfBuffers (kkint32 _maxNumOfBuffers)
+{
+  {
+    lock_guard<std::mutex>  lock (mutex);
+    maxNumOfBuffers = _maxNumOfBuffers;
+  }
+  // A larger limit may let waiting producers in.
+  rasterRemoved.notify_all ();
+}
+
+
+
+void  RasterBuffer::MaxNumOfFreeRasters (kkint32 _maxNumOfFreeRasters)
+{
+  lock_guard<std::mutex>  lock (mutex);
+  maxNumOfFreeRasters = _maxNumOfFreeRasters;
+  while  ((kkint32)freeRasters.size () > maxNumOfFreeRasters)
+  {
+    RasterPtr  r = freeRasters.back ();
+    freeRasters.pop_back ();
+    memoryConsumed = memoryConsumed - r->MemoryConsumedEstimated ();
+    delete  r;
+  }
+}
+
+
+
+void  RasterBuffer::Policy (FullPolicy  _fullPolicy)
+{
+  {
+    lock_guard<std::mutex>  lock (mutex);
+    fullPolicy = _fullPolicy;
+  }
+  // Producers waiting under 'BackPressure' now drop instead.
+  rasterRemoved.notify_all ();
+}
+
+
+
 void  RasterBuffer::AddRaster (RasterPtr  raster)
+{
+  if  (!AddRaster (raster, -1.0f))
+  {
+    // Only happens when the buffer has been closed.
+    RecycleRaster (raster);
+  }
+}  /* AddRaster */
+
+
+
+bool  RasterBuffer::AddRaster (RasterPtr  raster,
+                               float      maxWaitSecs
+                              )
 {
   if  (raster == NULL)
   {
@@ -112,16 +271,39 @@ void  RasterBuffer::AddRaster (RasterPtr  raster)
     throw KKException (errMsg);
   }
 
-  gateKeeper->StartBlock ();
+  unique_lock<std::mutex>  lock (mutex);
 
-  while  (buffer.size () >= (kkuint32)maxNumOfBuffers)
+  auto  full = [this] () {return  buffer.size () >= (kkuint32)Max (1, maxNumOfBuffers);};
+
+  if  ((fullPolicy == FullPolicy::BackPressure)  &&  (!closed)  &&  full ())
+  {
+    auto  canProceed = [this, &full] () {return  closed  ||  (fullPolicy != FullPolicy::BackPressure)  ||  !full ();};
+    WaitClock::time_point  start = WaitClock::now ();
+    if  (maxWaitSecs < 0.0f)
+      rasterRemoved.wait (lock, canProceed);
+    else
+      rasterRemoved.wait_for (lock, std::chrono::duration<float> (maxWaitSecs), canProceed);
+    producerWaitSecs += SecsSince (start);
+
+    if  ((fullPolicy == FullPolicy::BackPressure)  &&  full ())
+      return  false;
+  }
+
+  if  (closed)
+    return  false;
+
+  while  (full ())
     ThrowOutOldestOccupiedBuffer ();
 
   buffer.push (raster);
   memoryConsumed = memoryConsumed + raster->MemoryConsumedEstimated ();
+  if  ((kkint32)buffer.size () > peakNumPopulated)
+    peakNumPopulated = (kkint32)buffer.size ();
 
-  gateKeeper->EndBlock ();
-}  /* AddFrame */
+  lock.unlock ();
+  rasterAdded.notify_one ();
+  return  true;
+}  /* AddRaster */
 
 
 
@@ -129,16 +311,50 @@ RasterPtr  RasterBuffer::GetNextRaster ()
 {
   RasterPtr  result = NULL;
 
-  gateKeeper->StartBlock ();
+  {
+    lock_guard<std::mutex>  lock (mutex);
+    if  (buffer.size () > 0)
+    {
+      result = buffer.front ();
+      buffer.pop ();
+      memoryConsumed = memoryConsumed - result->MemoryConsumedEstimated ();
+    }
+  }
+
+  if  (result)
+    rasterRemoved.notify_one ();
+  return result;
+}  /* GetNextRaster */
+
+
+
+RasterPtr  RasterBuffer::GetNextRaster (float  maxWaitSecs)
+{
+  RasterPtr  result = NULL;
 
-  if  (buffer.size () > 0)
   {
-    result = buffer.front ();
-    buffer.pop ();
-    memoryConsumed = memoryConsumed - result->MemoryConsumedEstimated ();
+    unique_lock<std::mutex>  lock (mutex);
+    if  ((buffer.size () == 0)  &&  (!closed))
+    {
+      auto  canProceed = [this] () {return  closed  ||  (buffer.size () > 0);};
+      WaitClock::time_point  start = WaitClock::now ();
+      if  (maxWaitSecs < 0.0f)
+        rasterAdded.wait (lock, canProceed);
+      else
+        rasterAdded.wait_for (lock, std::chrono::duration<float> (maxWaitSecs), canProceed);
+      consumerWaitSecs += SecsSince (start);
+    }
+
+    if  (buffer.size () > 0)
+    {
+      result = buffer.front ();
+      buffer.pop ();
+      memoryConsumed = memoryConsumed - result->MemoryConsumedEstimated ();
+    }
   }
 
-  gateKeeper->EndBlock ();
+  if  (result)
+    rasterRemoved.notify_one ();
   return result;
 }  /* GetNextRaster */
 
@@ -146,11 +362,8 @@ RasterPtr  RasterBuffer::GetNextRaster ()
 
 kkMemSize  RasterBuffer::MemoryConsumedEstimated () const
 {
-  kkMemSize  result = 0;
-  gateKeeper->StartBlock ();
-  result = memoryConsumed;
-  gateKeeper->EndBlock ();
-  return  result;
+  lock_guard<std::mutex>  lock (mutex);
+  return  memoryConsumed;
 }  /* MemoryConsumedEstimated */
 
 
@@ -158,11 +371,60 @@ kkMemSize  RasterBuffer::MemoryConsumedEstimated () const
 RasterPtr  RasterBuffer::GetCopyOfLastImage ()
 {
   RasterPtr  result = NULL;
-  gateKeeper->StartBlock ();
+  lock_guard<std::mutex>  lock (mutex);
   if  (buffer.size () > 0)
   {
     result = new Raster (*(buffer.back ()));
   }
-  gateKeeper->EndBlock ();
   return  result;
 }
+
+
+
+RasterPtr  RasterBuffer::AllocateRaster (kkint32  height,
+                                         kkint32  width,
+                                         bool     color
+                                        )
+{
+  {
+    lock_guard<std::mutex>  lock (mutex);
+    for  (auto  idx = freeRasters.rbegin ();  idx != freeRasters.rend ();  ++idx)
+    {
+      RasterPtr  r = *idx;
+      if  ((r->Height () == height)  &&  (r->Width () == width)  &&  (r->Color () == color))
+      {
+        *idx = freeRasters.back ();
+        freeRasters.pop_back ();
+        memoryConsumed = memoryConsumed - r->MemoryConsumedEstimated ();
+        rastersReused++;
+        return  r;
+      }
+    }
+    rastersAllocated++;
+  }
+
+  return  new Raster (height, width, color);
+}  /* AllocateRaster */
+
+
+
+void  RasterBuffer::RecycleRaster (RasterPtr  raster)
+{
+  if  (raster == NULL)
+    return;
+
+  lock_guard<std::mutex>  lock (mutex);
+  RecycleRasterLocked (raster);
+}  /* RecycleRaster */
+
+
+
+void  RasterBuffer::Close ()
+{
+  {
+    lock_guard<std::mutex>  lock (mutex);
+    closed = true;
+  }
+  rasterAdded.notify_all ();
+  rasterRemoved.notify_all ();
+}  /* Close */
@@ -5,11 +5,13 @@
 #if  !defined(_RASTERBUFFER_X_)
 #define  _RASTERBUFFER_X_
 
+#include <condition_variable>
+#include <mutex>
 #include <queue>
+#include <vector>
 
 
 #include "KKStr.h"
-#include "GoalKeeper.h"
 
 namespace KKB
 {
@@ -25,40 +27,82 @@ namespace KKB
    *@class  RasterBuffer
    *@brief  Will manage a buffer that will allow multiple threads to add and remove instances of 'Raster' objects.
    *@details
-   * A 'GoalKeepeer' object 'gateKeeper' will be used to enforce integrity in the Multi-Threaded environment.  It
-   * will guarantee that only one thread at a time can access the Raster Queue.  This queue will take ownership of
-   * 'Raster' instances added to it via 'AddRaster'.  It will pass ownership of the 'Raster' instances when it
-   * returns them in GetNextRaster.  When a 'RasterBuffer' instance is deleted it will delete all the 'Raster'
-   * instances it still contains.
+   * A mutex guards the Raster Queue so that only one thread at a time can access it.  This queue will take
+   * ownership of 'Raster' instances added to it via 'AddRaster'.  It will pass ownership of the 'Raster' instances
+   * when it returns them in GetNextRaster.  When a 'RasterBuffer' instance is deleted it will delete all the
+   * 'Raster' instances it still contains.
+   *
+   * Producer / consumer pipelines, such as camera to feature extractor, can use the timed variants of 'AddRaster'
+   * and 'GetNextRaster' which block rather than poll, and 'Close' to tell consumers that no more rasters are
+   * coming.  What 'AddRaster' does when the buffer is full is selected by 'FullPolicy';  'DropOldest', the
+   * default, is the original behavior.
+   *
+   * To avoid allocating a new 'Raster' for every frame a producer can get one from 'AllocateRaster' and a consumer
+   * hand back the ones it is done with via 'RecycleRaster';  rasters thrown out by 'DropOldest' are recycled as
+   * well.  Up to 'MaxNumOfFreeRasters' of them are kept on a free list and reused for requests of the same
+   * dimensions, so that once the pipeline reaches steady state no rasters are allocated.
    */
-  class  RasterBuffer 
+  class  RasterBuffer
   {
   public:
     typedef  RasterBuffer*  RasterBufferPtr;
 
+    /** @brief  What 'AddRaster' does when the buffer already holds 'maxNumOfBuffers' rasters. */
+    enum  class  FullPolicy
+    {
+      DropOldest,      /**< Oldest rasters are removed and recycled to make room;  'AddRaster' never waits. */
+      BackPressure     /**< 'AddRaster' waits for a consumer to make room. */
+    };
+
+    static  KKStr       FullPolicyToStr   (FullPolicy  policy);
+    static  FullPolicy  FullPolicyFromStr (const KKStr&  s);
+
+
     /**
      *@brief  Constructor.
-     *@param[in] _name  Name of the buffer; this will be used by the associated 'GateKeeper' instance; should be unique.
+     *@param[in] _name  Name of the buffer; used in messages; should be unique.
      *@param[in] _maxNumOfBuffers The maximum number of raster instances that can be added to this buffer.  When
      *            this limit has been reached the oldest entries in the list will be deleted when a new one is
-     *            added (AddRaster).
+     *            added (AddRaster), unless 'FullPolicy' is set to 'BackPressure'.
      */
     RasterBuffer (const KKStr&  _name,
                   kkint32       _maxNumOfBuffers
                  );
 
+    /** @brief  Calls 'Close' and then deletes the rasters that are still queued or on the free list. */
     ~RasterBuffer ();
 
     /** @brief  Returns the number of 'Raster' instances that had to be deleted because the size of the queue had reached 'maxNumOfBuffers'. */
-    kkint32  RastersDropped          () const {return rastersDropped;}
+    kkint32  RastersDropped          () const;
 
     kkint32  MaxNumOfBuffers         () const {return maxNumOfBuffers;}
 
+    kkint32  MaxNumOfFreeRasters     () const {return maxNumOfFreeRasters;}
+
+    FullPolicy  Policy               () const {return fullPolicy;}
+
     /** @brief  The number of entries that are left in the buffer before 'maxNumOfBuffers' is reached. */
     kkint32  NumAvailable            () const;
 
     kkint32  NumPopulated            () const;
 
+    /** @brief  The largest number of rasters that were queued at one time. */
+    kkint32  PeakNumPopulated        () const;
+
+    /** @brief  Number of rasters handed out by 'AllocateRaster' that had to be newly allocated. */
+    kkint32  RastersAllocated        () const;
+
+    /** @brief  Number of rasters handed out by 'AllocateRaster' that came off the free list. */
+    kkint32  RastersReused           () const;
+
+    /** @brief  Total seconds that producers spent waiting in 'AddRaster' for room. */
+    double   ProducerWaitSecs        () const;
+
+    /** @brief  Total seconds that consumers spent waiting in 'GetNextRaster' for a raster. */
+    double   ConsumerWaitSecs        () const;
+
+    bool     Closed                  () const;
+
 
     /** @brief Returns an estimate of the amount of memory consumed in bytes.
      * @details  This will help managed objects keep track of how much memory they are using in the unmanaged world.
@@ -66,38 +110,102 @@ namespace KKB
     kkMemSize  MemoryConsumedEstimated () const;
 
 
-    void  MaxNumOfBuffers (kkint32 _maxNumOfBuffers)  {maxNumOfBuffers = _maxNumOfBuffers;}
+    void  MaxNumOfBuffers (kkint32 _maxNumOfBuffers);
+
+    /**
+     *@brief  Rasters on the free list beyond this number are deleted rather than kept.
+     *@details  Defaults to twice 'maxNumOfBuffers';  the free list has to be able to take back a full queue's worth
+     *          plus the rasters that producers and consumers are holding, or steady state will still allocate.
+     */
+    void  MaxNumOfFreeRasters (kkint32 _maxNumOfFreeRasters);
+
+    void  Policy (FullPolicy  _fullPolicy);
 
 
     /** @brief Adds 'raster' to the end of the queue giving the queue ownership of the instance.
      * @details
      *         If the number of entries in the queue are already equal or greater than 'MaxNumOfBuffers' specified
-     *         then the oldest instances in the queue(back of the queue) will be removed and deleted until the
-     *         size of the queue is less than 'MaxNumOfBuffers' before adding this new instance.
+     *         then under 'FullPolicy::DropOldest' the oldest instances in the queue(back of the queue) will be
+     *         removed and recycled until the size of the queue is less than 'MaxNumOfBuffers' before adding this
+     *         new instance;  under 'FullPolicy::BackPressure' will wait until a consumer makes room.  If the buffer
+     *         has been closed 'raster' is recycled instead.
      */
     void  AddRaster (RasterPtr  raster);
 
+    /**
+     *@brief  Same as 'AddRaster (raster)' but under 'FullPolicy::BackPressure' waits no longer than 'maxWaitSecs'.
+     *@details  Returns 'false' if the buffer was still full after 'maxWaitSecs' or the buffer has been closed;  in
+     *          that case the caller retains ownership of 'raster'.  A negative 'maxWaitSecs' waits indefinitely.
+     */
+    bool  AddRaster (RasterPtr  raster,
+                     float      maxWaitSecs
+                    );
+
     /** @brief  Removes from the buffer the oldest instance of 'Raster' and returns it to caller; if buffer is
      *          empty will return NULL.
      */
     RasterPtr  GetNextRaster ();
 
+    /**
+     *@brief  Removes from the buffer the oldest instance of 'Raster' and returns it to caller, waiting up to
+     *        'maxWaitSecs' for one to be added;  a negative 'maxWaitSecs' waits indefinitely.
+     *@details  Returns NULL if the time ran out, or if the buffer is empty and has been closed.
+     */
+    RasterPtr  GetNextRaster (float  maxWaitSecs);
+
     /**@brief Returns a copy of the last Raster instance added to the queue; if buffer is empty will return NULL.
      * @details  Caller will get ownership and be responsible for deleting it.
      */
     RasterPtr  GetCopyOfLastImage ();
 
 
+    /**
+     *@brief  Returns a raster of the requested dimensions, taken from the free list if one is available;  the caller
+     *        gets ownership.
+     *@details  A recycled raster still holds the pixel data of its previous use;  callers that do not overwrite
+     *          every pixel have to clear it themselves.
+     */
+    RasterPtr  AllocateRaster (kkint32  height,
+                               kkint32  width,
+                               bool     color
+                              );
+
+    /** @brief  Takes ownership of 'raster', putting it on the free list for 'AllocateRaster' or deleting it if the list is full. */
+    void  RecycleRaster (RasterPtr  raster);
+
+    /**
+     *@brief  Indicates that no more rasters will be added;  wakes up all threads waiting in 'AddRaster' or
+     *        'GetNextRaster'.
+     *@details  Consumers can still retrieve the rasters that are queued;  once the buffer is empty 'GetNextRaster'
+     *          returns NULL without waiting.
+     */
+    void  Close ();
+
+
   private:
-    /** @brief  Remove the oldest 'Raster' instance from the buffer.  */
-     void  ThrowOutOldestOccupiedBuffer ();
-
-    std::queue<RasterPtr> buffer;
-    GoalKeeperPtr         gateKeeper;
-    kkint32               maxNumOfBuffers;
-    kkMemSize             memoryConsumed;
-    KKStr                 name;             /**< Name of buffer. */
-    kkint32               rastersDropped;   /**< The number of raster instances that had to be deleted because 'maxNumOfBuffers' was reached. */
+    /** @brief  Remove the oldest 'Raster' instance from the buffer;  caller must hold 'mutex'.  */
+    void  ThrowOutOldestOccupiedBuffer ();
+
+    /** @brief  Caller must hold 'mutex'. */
+    void  RecycleRasterLocked (RasterPtr  raster);
+
+    std::queue<RasterPtr>    buffer;
+    bool                     closed;
+    double                   consumerWaitSecs;
+    std::vector<RasterPtr>   freeRasters;
+    FullPolicy               fullPolicy;
+    kkint32                  maxNumOfBuffers;
+    kkint32                  maxNumOfFreeRasters;
+    kkMemSize                memoryConsumed;
+    mutable std::mutex       mutex;
+    KKStr                    name;             /**< Name of buffer. */
+    kkint32                  peakNumPopulated;
+    double                   producerWaitSecs;
+    std::condition_variable  rasterAdded;
+    std::condition_variable  rasterRemoved;
+    kkint32                  rastersAllocated;
+    kkint32                  rastersDropped;   /**< The number of raster instances that had to be thrown out because 'maxNumOfBuffers' was reached. */
+    kkint32                  rastersReused;
   };  /* RasterBuffer */
 
 
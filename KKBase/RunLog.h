@@ -120,6 +120,9 @@ namespace KKB
 
     kkint32 LineCount ()  const  {return  lineCount;}
 
+    /** @brief  Threshold that messages must be at or below to be recorded;  see 'SetLoggingLevel'. */
+    kkint32 LoggingLevel ()  const  {return  loggingLevel;}
+
     void    SetLoggingLevel (kkint32 _loggingLevel);
 
 
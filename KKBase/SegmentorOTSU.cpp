@@ -4,14 +4,11 @@
  */
 #include "FirstIncludes.h"
 
-#include <memory>
 #include <math.h>
 
 #include <float.h>
 #include <limits.h>
 #include <algorithm>
-#include <fstream>
-#include <map>
 #include <string>
 #include <iostream>
 #include <vector>
@@ -22,16 +19,20 @@ using namespace std;
 #include "SegmentorOTSU.h"
 
 #include "KKBaseTypes.h"
+#include "Matrix.h"
 #include "Raster.h"
 using namespace  KKB;
 
 
 
 SegmentorOTSU::SegmentorOTSU (RunLog&  _log):
-  threshold1 (0),
-  threshold2 (0),
-  NaN        (0.0),
-  log        (_log)
+  dpBest            (),
+  dpSplit           (),
+  grayScale         (),
+  optimalThresholds (false),
+  threshold1        (0),
+  threshold2        (0),
+  log               (_log)
 {
 }
 
@@ -43,643 +44,544 @@ SegmentorOTSU::~SegmentorOTSU ()
 
 
 
-void   SegmentorOTSU::LabelRaster (RasterPtr  result,
-                                   uchar      pixelValue,
-                                   uchar      label,
-                                   RasterPtr  srcImage
-                                  )
+const uchar*  SegmentorOTSU::GrayScaleHistogram (RasterPtr  srcImage,
+                                                 RasterPtr  mask,
+                                                 kkint32*   counts
+                                                )
 {
-  uchar*  resultArea = result->GreenArea ();
-  uchar*  srcArea    = srcImage->GreenArea ();
-  kkint32 totPixels  = srcImage->TotPixels ();
-  for  (kkint32  x = 0;  x < totPixels;  ++x)
+  kkint32  totPixels = srcImage->TotPixels ();
+  kkint32  x = 0;
+
+  const uchar*  maskArea = NULL;
+  uchar         maskTh   = 0;
+  if  (mask)
   {
-    if  (srcArea[x] == pixelValue)
-    {
-      resultArea[x] = label;
-    }
+    maskArea = mask->GreenArea ();
+    maskTh   = mask->BackgroundPixelTH ();
   }
-}  /* LabelRaster */
 
+  for  (x = 0;  x < 256;  ++x)
+    counts[x] = 0;
 
-void   SegmentorOTSU::LabelRaster (RasterPtr  result,
-                                   RasterPtr  mask,
-                                   uchar      pixelValue,
-                                   uchar      label,
-                                   RasterPtr  srcImage
-                                  )
-{
-  uchar*  resultArea = result->GreenArea();
-  uchar*  srcArea    = srcImage->GreenArea();
-  kkint32 totPixels  = srcImage->TotPixels();
-  if  (mask)
+  if  (!srcImage->Color ())
   {
-    uchar*  maskArea = mask->GreenArea ();
-    uchar   maskTh   = mask->BackgroundPixelTH ();
-    for (kkint32 x = 0; x < totPixels; ++x)
+    const uchar*  grayArea = srcImage->GreenArea ();
+    if  (maskArea)
     {
-      if ((srcArea[x] == pixelValue) && (maskArea[x] > maskTh))
+      for  (x = 0;  x < totPixels;  ++x)
       {
-        resultArea[x] = label;
+        if  (maskArea[x] > maskTh)
+          ++counts[grayArea[x]];
       }
     }
+    else
+    {
+      for  (x = 0;  x < totPixels;  ++x)
+        ++counts[grayArea[x]];
+    }
+    return  grayArea;
   }
-  else
-  {
-    for  (kkint32  x = 0;  x < totPixels;  ++x)
-      if  (srcArea[x] == pixelValue)
-        resultArea[x] = label;
-  }
-}  /* LabelRaster */
 
+  const uchar*  redArea   = srcImage->RedArea   ();
+  const uchar*  greenArea = srcImage->GreenArea ();
+  const uchar*  blueArea  = srcImage->BlueArea  ();
 
-template<typename T>
-vector<T>  SegmentorOTSU::BDV (T  start,
-                               T  inc,
-                               T  end
-                              )
-{
-  vector<T>  r;
-  while  (start <= end)
+  grayScale.resize (totPixels);
+  uchar*  grayArea = grayScale.data ();
+
+  // The channel totals are integers;  exact, as were the double totals they replace.
+  kkuint64  totals[3] = {0, 0, 0};
+  kkint32   numPixels = 0;
+  for  (x = 0;  x < totPixels;  ++x)
   {
-    r.push_back (start);
-    start += inc;
+    if  ((!maskArea)  ||  (maskArea[x] > maskTh))
+    {
+      totals[0] += redArea  [x];
+      totals[1] += greenArea[x];
+      totals[2] += blueArea [x];
+      ++numPixels;
+    }
   }
-  return  r;
-}  /* BDV */
-
-
-
-/**
- *@brief  Returns a vector that represents the accumulated sum of the input vector.
- */
-template<typename T>
-vector<T>   SegmentorOTSU::CumSum (const vector<T>&  v)
-{
-  vector<T>  r;
 
-  T  total = 0.0;
-  for  (kkuint32  x = 0;  x < v.size ();  ++x)
+  if  (numPixels < 1)
   {
-    total += v[x];
-    r.push_back (total);
+    fill (grayScale.begin (), grayScale.end (), (uchar)0);
+    return  grayArea;
   }
 
-  return  r;
-}  /* CumSum */
-
-
-
-VectorDouble  SegmentorOTSU::DotMult (const VectorDouble&  left,
-                                      const VectorDouble&  right
-                                     )
-{
-  kkuint32  lenMax = (kkuint32)Max (left.size (), right.size ());
-  kkuint32  lenMin = (kkuint32)Min (left.size (), right.size ());
-
-  VectorDouble  r (lenMax, 0.0);
-  for  (kkuint32 x = 0;  x < lenMin;  ++x)
-    r[x] = left[x] * right[x];
+  double  means[3];
+  for  (kkint32 chan = 0;  chan < 3;  ++chan)
+    means[chan] = (double)totals[chan] / (double)numPixels;
 
-  return  r;
-}  /* DotMult */
-
-
-
-MatrixD  SegmentorOTSU::DotMult (const MatrixD&  left,
-                                 const MatrixD&  right
-                                )
-{
-  kkint32  maxNumOfRows = Max (left.NumOfRows (), right.NumOfRows ());
-  kkint32  maxNumOfCols = Max (left.NumOfCols (), right.NumOfCols ());
-  
-  kkint32  minNumOfRows = Min (left.NumOfRows (), right.NumOfRows ());
-  kkint32  minNumOfCols = Min (left.NumOfCols (), right.NumOfCols ());
-
-  MatrixD  result (maxNumOfRows, maxNumOfCols);
-
-  double const * const * leftData   = left.Data  ();
-  double const * const * rightData  = right.Data ();
-  double**               resultData = result.DataNotConst ();
-
-  kkint32  r, c;
-
-  for  (r = 0;  r < minNumOfRows;  ++r)
+  // All six covariance sums in one pass;  each is still accumulated in pixel order.
+  double  sumRR = 0.0, sumRG = 0.0, sumRB = 0.0, sumGG = 0.0, sumGB = 0.0, sumBB = 0.0;
+  for  (x = 0;  x < totPixels;  ++x)
   {
-    double const *  leftDataRow   = leftData[r];
-    double const *  rightDataRow  = rightData[r];
-    double*         resultDataRow = resultData[r];
-
-    for  (c = 0;  c < minNumOfCols;  ++c)
-      resultDataRow[c] = leftDataRow[c] * rightDataRow[c];
+    if  ((!maskArea)  ||  (maskArea[x] > maskTh))
+    {
+      double  r = (double)redArea  [x] - means[0];
+      double  g = (double)greenArea[x] - means[1];
+      double  b = (double)blueArea [x] - means[2];
+      sumRR += r * r;
+      sumRG += r * g;
+      sumRB += r * b;
+      sumGG += g * g;
+      sumGB += g * b;
+      sumBB += b * b;
+    }
   }
 
-  for  (r = minNumOfRows;  r < maxNumOfRows;  ++r)
+  MatrixD  cov (3, 3);
+  double  n1 = (double)(numPixels - 1);
+  cov[0][0] = sumRR / n1;
+  cov[0][1] = cov[1][0] = sumRG / n1;
+  cov[0][2] = cov[2][0] = sumRB / n1;
+  cov[1][1] = sumGG / n1;
+  cov[1][2] = cov[2][1] = sumGB / n1;
+  cov[2][2] = sumBB / n1;
+
+  MatrixDPtr     eigenVectors = NULL;
+  VectorDouble*  eigenValues  = NULL;
+  cov.EigenVectors (eigenVectors, eigenValues);
+  if  ((!eigenVectors)  ||  (!eigenValues))
   {
-    double*  resultDataRow = resultData[r];
-    for  (c = minNumOfCols;  c < maxNumOfCols;  ++c)
-      resultDataRow[c] = 0.0;
+    log.Level (-1) << endl
+      << "SegmentorOTSU::GrayScaleHistogram   ***ERROR***   Could not derive Eigen Vectors of covariance matrix." << endl
+      << endl;
+    delete  eigenVectors;  eigenVectors = NULL;
+    delete  eigenValues;   eigenValues  = NULL;
+    return  NULL;
   }
-  return  result;
-}  /* DotMult */
-
-
-VectorDouble  SegmentorOTSU::DotDiv (const VectorDouble&  left,
-                                     const VectorDouble&  right
-                                    )
-{
-  kkuint32 x = 0;
-  kkuint32  lenMax = (kkuint32)Max (left.size (), right.size ());
-  kkuint32  lenMin = (kkuint32)Min (left.size (), right.size ());
 
-  VectorDouble  r (lenMax, 0.0);
-  for  (x = 0;  x < lenMin;  ++x)
+  kkuint32  eigenValueMaxIdx = 0;
+  double    eigenValueMax    = (*eigenValues)[0];
+  for  (kkuint32 y = 1;  y < eigenValues->size ();  ++y)
   {
-    double  rs = right[x];
-    if  (rs == 0.0)
-      r[x] = NaN;
-    else
-      r[x] = left[x] / rs;
+    if  ((*eigenValues)[y] > eigenValueMax)
+    {
+      eigenValueMaxIdx = y;
+      eigenValueMax = (*eigenValues)[y];
+    }
   }
 
-  for  (x = lenMin;  x < lenMax;  ++x)
-    r[x] = (double)NaN;
-
-  return  r;
-}  /* DotDiv */
-
+  VectorDouble  eigenVector = eigenVectors->GetCol (eigenValueMaxIdx);
+  delete  eigenVectors;  eigenVectors = NULL;
+  delete  eigenValues;   eigenValues  = NULL;
 
-
-MatrixD  SegmentorOTSU::DotDiv (const MatrixD&  left,
-                               const MatrixD&  right
-                              )
-{
-  kkuint32  maxNumOfRows = Max (left.NumOfRows (), right.NumOfRows ());
-  kkuint32  maxNumOfCols = Max (left.NumOfCols (), right.NumOfCols ());
-  
-  kkuint32  minNumOfRows = Min (left.NumOfRows (), right.NumOfRows ());
-  kkuint32  minNumOfCols = Min (left.NumOfCols (), right.NumOfCols ());
-
-  MatrixD  result (maxNumOfRows, maxNumOfCols);
-
-  double const * const * leftData   = left.Data  ();
-  double const * const * rightData  = right.Data ();
-  double**               resultData = result.DataNotConst ();
-
-  for  (kkuint32 r = 0;  r < minNumOfRows;  ++r)
+  // Every projection is the sum of one entry from each table;  the same products the Raster methods compute per pixel.
+  double  redProj[256], greenProj[256], blueProj[256];
+  for  (x = 0;  x < 256;  ++x)
   {
-    double const *  leftDataRow   = leftData[r];
-    double const *  rightDataRow  = rightData[r];
-    double*         resultDataRow = resultData[r];
-
-    for  (kkuint32 c = 0;  c < minNumOfCols;  ++c)
-      resultDataRow[c] = leftDataRow[c] / rightDataRow[c];
+    redProj  [x] = (double)x * eigenVector[0];
+    greenProj[x] = (double)x * eigenVector[1];
+    blueProj [x] = (double)x * eigenVector[2];
   }
 
-  for  (kkuint32 r = minNumOfRows;  r < maxNumOfRows;  ++r)
+  // Same starting values as 'CreateGrayScaleKLT' and 'CreateGrayScaleKLTOnMaskedArea' so the scaling matches.
+  double  valMin = DBL_MAX;
+  double  valMax = maskArea ? -9999999999.99 : DBL_MIN;
+  for  (x = 0;  x < totPixels;  ++x)
   {
-    double*  resultDataRow = resultData[r];
-    for  (kkuint32 c = minNumOfCols;  c < maxNumOfCols;  ++c)
+    if  ((!maskArea)  ||  (maskArea[x] > maskTh))
     {
-      if  ((r >= right.NumOfRows ())  ||  (c >= right.NumOfCols ()))
-        resultDataRow[c] = NaN;
-
-      else if  (rightData[r][c] == 0.0)
-        resultDataRow[c] = NaN;
-
-      else
-        resultDataRow[c] = 0.0;
+      double  adjVal = redProj[redArea[x]] + greenProj[greenArea[x]] + blueProj[blueArea[x]];
+      if  (adjVal < valMin)  valMin = adjVal;
+      if  (adjVal > valMax)  valMax = adjVal;
     }
   }
 
-  return  result;
-}  /* DotDiv */
-
-
+  if  (valMax <= valMin)  valMax = valMin + 1.0;   // Whole image has the same Gray-Scale value.
+  double  adjScaleFact = 255.0 / (valMax - valMin);
 
-template<typename T>
-vector<T>   SegmentorOTSU::FlipLeftRight (const vector<T>&  v)
-{
-  
-  vector<T>  r(v.size (), (T)0);
-  reverse_copy (v.begin (), v.end (), r.begin ());
-  return  r;
-}  /* FlipLeftRight */
-
-
-
-
-KKB::VectorDouble  SegmentorOTSU::Add (const VectorDouble&  left,
-                                       double               right
-                                      )
-{
-  kkuint32 x = 0;
-  kkuint32 len = (kkuint32)left.size ();
-
-  VectorDouble  r (len, 0.0);
-  for  (x = 0;  x < len;  ++x)
+  for  (x = 0;  x < totPixels;  ++x)
   {
-    double  z1 = left[x];
-    double  z2 = z1 + right;
-    r[x] = z2;
-    //r[x] = (left[r] - right);
+    if  ((!maskArea)  ||  (maskArea[x] > maskTh))
+    {
+      double  adjVal = redProj[redArea[x]] + greenProj[greenArea[x]] + blueProj[blueArea[x]];
+      uchar   gray = (uchar)Min ((kkint32)((adjVal - valMin) * adjScaleFact + 0.5), (kkint32)255);
+      grayArea[x] = gray;
+      ++counts[gray];
+    }
+    else
+    {
+      grayArea[x] = 0;
+    }
   }
 
-  return  r;
-}  /* Add */
+  return  grayArea;
+}  /* GrayScaleHistogram */
 
 
 
-KKB::VectorDouble  SegmentorOTSU::Subt (const VectorDouble&  left,
-                                        const VectorDouble&  right
-                                       )
+double  SegmentorOTSU::ClassMoment (const double*  w,
+                                    const double*  mu,
+                                    kkint32        first,
+                                    kkint32        last
+                                   )
 {
-  kkuint32 x = 0;
-  kkuint32  lenMax = (kkuint32)Max (left.size (), right.size ());
-  kkuint32  lenMin = (kkuint32)Min (left.size (), right.size ());
-
-  VectorDouble  r (lenMax, 0.0);
-  for  (x = 0;  x < lenMin;  ++x)
-    r[x] = left[x] - right[x];
-
-  for  (x = lenMin;  x < lenMax;  ++x)
+  double  classW  = w [last];
+  double  classMu = mu[last];
+  if  (first > 0)
   {
-    if  (x < left.size ())
-      r[x] = left[x];
-    else
-      r[x] = 0.0 - right[x];
+    classW  -= w [first - 1];
+    classMu -= mu[first - 1];
   }
 
-  return  r;
-}  /* Subt */
+  if  (classW <= 0.0)
+    return 0.0;
 
+  return  classMu * classMu / classW;
+}  /* ClassMoment */
 
 
-KKB::VectorDouble  SegmentorOTSU::Subt (const VectorDouble&  left,
-                                        double               right
-                                       )
+
+double  SegmentorOTSU::SearchThreeClassesLegacy (kkint32        nbins,
+                                                 const double*  P,
+                                                 const double*  w,
+                                                 const double*  mu,
+                                                 kkint32&       k1,
+                                                 kkint32&       k2
+                                                )
 {
-  kkuint32 x = 0;
-  kkuint32 len = (kkuint32)left.size ();
+  double  muEnd = mu[nbins - 1];
 
-  VectorDouble  r (len, 0.0);
-  for  (x = 0;  x < len;  ++x)
+  //w2 = fliplr(cumsum(fliplr(P)));
+  //mu0 = mu./w;
+  //mu2 = fliplr(cumsum(fliplr((1:nbins).*P)) ./ cumsum(fliplr(P)));
+  // A zero divisor made 'DotDiv' return 'NaN' which was 0.0.
+  double  w2[256], mu0[256], mu2[256];
+  double  sumP = 0.0, sumIdxP = 0.0;
+  kkint32  x = 0;
+  for  (x = nbins - 1;  x >= 0;  --x)
   {
-    double  z1 = left[x];
-    double  z2 = z1 - right;
-    r[x] = z2;
-    //r[x] = (left[r] - right);
+    sumP    += P[x];
+    sumIdxP += (double)(x + 1) * P[x];
+    w2 [x] = sumP;
+    mu2[x] = (sumP == 0.0) ? 0.0 : (sumIdxP / sumP);
   }
+  for  (x = 0;  x < nbins;  ++x)
+    mu0[x] = (w[x] == 0.0) ? 0.0 : (mu[x] / w[x]);
 
-  return  r;
-}  /* Subt */
-
-
-
-KKB::VectorDouble  SegmentorOTSU::Subt (double               left,
-                                        const VectorDouble&  right
-                                       )
-{
-  kkuint32 x = 0;
-  kkuint32 len = (kkuint32)right.size ();
-
-  VectorDouble  r (len, 0.0);
-  for  (x = 0;  x < len;  ++x)
+  //[w0,w2] = ndgrid(w0,w2);  [mu0,mu2] = ndgrid(mu0,mu2);
+  //w1 = 1-w0-w2;  w1(w1<=0) = NaN;
+  //sigma2B = w0.*(mu0-mu(end)).^2 + w2.*(mu2-mu(end)).^2 + (w0.*(mu0-mu(end)) + w2.*(mu2-mu(end))).^2./w1;
+  //sigma2B(isnan(sigma2B)) = 0;
+  //[maxsig,k] = max(sigma2B(:));  [k1,k2] = ind2sub([nbins nbins],k);
+  double  maxSig = 0.0;
+  k1 = 0;
+  k2 = 0;
+  for  (kkint32 r = 0;  r < nbins;  ++r)
   {
-    r[x] = left - right[x];
+    double  w0r = w[r];
+    double  d0  = mu0[r] - muEnd;
+    for  (kkint32 c = 0;  c < nbins;  ++c)
+    {
+      double  w1 = (1.0 - w0r) - w2[c];
+      if  (w1 <= 0.0)
+        w1 = 0.0;
+
+      double  d2 = mu2[c] - muEnd;
+      double  p1 = w0r * pow (d0, 2.0) + w2[c] * pow (d2, 2.0);
+      double  p2 = pow (w0r * d0 + w2[c] * d2, 2.0) / w1;
+      double  sig = p1 + p2;
+      if  (IsNaN (sig))
+        sig = 0.0;
+
+      if  (((r == 0)  &&  (c == 0))  ||  (sig > maxSig))
+      {
+        maxSig = sig;
+        k1 = r;
+        k2 = c;
+      }
+    }
   }
+  return  maxSig;
+}  /* SearchThreeClassesLegacy */
 
-  return  r;
-}  /* Subt */
 
 
-
-
-
-VectorDouble  operator- (const VectorDouble&  left,
-                         double               right
-                        )
+double  SegmentorOTSU::SearchThreeClasses (kkint32        nbins,
+                                           const double*  w,
+                                           const double*  mu,
+                                           kkint32*       ends
+                                          )
 {
-  kkuint32 x = 0;
-  kkuint32 len = (kkuint32)left.size ();
-
-  VectorDouble  r (len, 0.0);
-  for  (x = 0;  x < len;  ++x)
+  // Classes are bins [0 .. k1], [k1 + 1 .. k2] and [k2 + 1 .. nbins - 1];  none of them empty.
+  double  maxSig = -1.0;
+  ends[0] = 0;
+  ends[1] = 1;
+  ends[2] = nbins - 1;
+  for  (kkint32 k1 = 0;  k1 < (nbins - 2);  ++k1)
   {
-    double  z1 = left[x];
-    double  z2 = z1 - right;
-    r[x] = z2;
-    //r[x] = (left[r] - right);
+    double  sig0 = ClassMoment (w, mu, 0, k1);
+    for  (kkint32 k2 = k1 + 1;  k2 < (nbins - 1);  ++k2)
+    {
+      double  sig = sig0 + ClassMoment (w, mu, k1 + 1, k2) + ClassMoment (w, mu, k2 + 1, nbins - 1);
+      if  (sig > maxSig)
+      {
+        maxSig = sig;
+        ends[0] = k1;
+        ends[1] = k2;
+      }
+    }
   }
-
-  return  r;
-}  /* operator- */
-
-
+  return  maxSig;
+}  /* SearchThreeClasses */
 
 
-template<typename T>
-vector<T>  operator- (T                 left,
-                      const vector<T>&  right
-                     )
-{
-  kkuint32 x = 0;
-  kkuint32 len = right.size ();
-
-  vector<T>  r (len, (T)0);
-  for  (x = 0;  x < len;  ++x)
-    r[x] = left - right[r];
-
-  return  r;
-}  /* operator- */
 
-
-
-VectorDouble  operator* (const VectorDouble& left,
-                         double              right
-                        )
-{
-  VectorDouble  result (left.size (), 0.0);
-
-  for  (kkuint32 x = 0;  x < left.size ();  ++x)
-    result[x] = left[x] * right;
-
-  return  result;
-}
-
-
-VectorDouble  operator* (double               left,
-                         const VectorDouble&  right
-                        )
-{
-  VectorDouble  result (right.size (), 0.0);
-
-  for  (kkuint32 x = 0;  x < right.size ();  ++x)
-    result[x] = left * right[x];
-
-  return  result;
-}
-
-
-
-
-VectorDouble  SegmentorOTSU::Power (const VectorDouble&  left,
-                                    double               right
-                                   )
-{
-  kkuint32 x = 0;
-  kkuint32 len = (kkuint32)left.size ();
-  VectorDouble  r (len, 0.0);
-  for  (x = 0;  x < len;  ++x)
-    r[x] = pow (left[x], right);
-
-  return  r;
-}  /* Power */
-
-
-
-MatrixD  SegmentorOTSU::Power (const MatrixD&  left,
-                               double          right
-                              )
+double  SegmentorOTSU::SearchThresholdsDP (kkint32        numClasses,
+                                           kkint32        nbins,
+                                           const double*  w,
+                                           const double*  mu,
+                                           kkint32*       ends
+                                          )
 {
-  kkuint32 numOfRows = left.NumOfRows ();
-  kkuint32 numOfCols = left.NumOfCols ();
-
-  MatrixD  result (numOfRows, numOfCols);
-  double const * const *  leftData = left.Data ();
-  double**  resultData = result.DataNotConst ();
+  // dpBest [c * nbins + e]  Best sum of 'ClassMoment' splitting bins [0 .. e] into 'c' + 1 classes.
+  // dpSplit[c * nbins + e]  First bin of the last of those classes.
+  dpBest.resize  (numClasses * nbins);
+  dpSplit.resize (numClasses * nbins);
 
-  kkuint32  r, c;
-  for  (r = 0;  r < numOfRows;  ++r)
+  kkint32  c = 0, e = 0;
+  for  (e = 0;  e < nbins;  ++e)
   {
-    double const *  leftDataRow = leftData[r];
-    double*  resultDataRow = resultData[r];
-    for  (c = 0;  c < numOfCols;  ++c)
-      resultDataRow[c] = pow (leftDataRow[c], right);
+    dpBest [e] = ClassMoment (w, mu, 0, e);
+    dpSplit[e] = 0;
   }
-  return  result;
-}  /* Power */
-
 
+  for  (c = 1;  c < numClasses;  ++c)
+  {
+    const double*  prevBest = dpBest.data () + (c - 1) * nbins;
+    double*        best     = dpBest.data () + c * nbins;
+    kkint32*       split    = dpSplit.data () + c * nbins;
 
+    // Leave at least one bin for each of the classes that follow.
+    kkint32  lastEnd = nbins - numClasses + c;
+    for  (e = c;  e <= lastEnd;  ++e)
+    {
+      double   maxSig = -1.0;
+      kkint32  maxStart = c;
+      for  (kkint32 start = c;  start <= e;  ++start)
+      {
+        double  sig = prevBest[start - 1] + ClassMoment (w, mu, start, e);
+        if  (sig > maxSig)
+        {
+          maxSig = sig;
+          maxStart = start;
+        }
+      }
+      best [e] = maxSig;
+      split[e] = maxStart;
+    }
+  }
 
-VectorDouble  SegmentorOTSU::Round (const VectorDouble&  v)
-{
-  VectorDouble  r (v.size (), 0.0);
-  for  (kkuint32 x = 0;  x < v.size ();  ++x)
+  e = nbins - 1;
+  for  (c = numClasses - 1;  c >= 0;  --c)
   {
-    r[x] = (kkint32)(v[x] + 0.5f);
+    ends[c] = e;
+    e = dpSplit[c * nbins + e] - 1;
   }
 
-  return  r;
-}  /* Round */
-
+  return  dpBest[(numClasses - 1) * nbins + (nbins - 1)];
+}  /* SearchThresholdsDP */
 
 
 
-template<typename T>
-T  SegmentorOTSU::Sum (const vector<T>&  v)
-{
-  T  sum = (T)0;
-  kkuint32  x = 0;
-  for  (x = 0;  x < v.size ();  ++x)
-    sum += v[x];
-  return  sum;
-}  /* Sum */
-
-
-
-void  SegmentorOTSU::NdGrid (const VectorDouble&  x,
-                             const VectorDouble&  y,
-                             MatrixD&             xm,
-                             MatrixD&             ym
-                            )
+RasterPtr  SegmentorOTSU::Segment (RasterPtr  srcImage,
+                                   RasterPtr  mask,
+                                   bool       zeroIsBackground,
+                                   kkint32    numClasses,
+                                   double&    sep
+                                  )
 {
-  kkuint32  xLen = (kkuint32)x.size ();
-  kkuint32  yLen = (kkuint32)y.size ();
-
-  xm.ReSize (xLen, xLen);
-  ym.ReSize (yLen, yLen);
-
-  kkuint32  row, col;
+  kkint32  totPixels = srcImage->TotPixels ();
+  kkint32  x = 0;
 
-  for  (row = 0;  row < xLen;  ++row)
+  if  (mask  &&  ((mask->Height () != srcImage->Height ())  ||  (mask->Width () != srcImage->Width ())))
   {
-    for  (col = 0;  col < yLen;  ++col)
-      xm[row][col] = x[row];
+    log.Level (-1) << endl
+      << "SegmentorOTSU::Segment   ***ERROR***   Mask dimensions[" << mask->Height () << "," << mask->Width () << "]"
+      << "  do not match image[" << srcImage->Height () << "," << srcImage->Width () << "]." << endl
+      << endl;
+    sep = 0;
+    return NULL;
   }
 
-  for  (row = 0;  row < xLen;  ++row)
+  const uchar*  maskArea = NULL;
+  uchar         maskTh   = 0;
+  if  (mask)
   {
-    for  (col = 0;  col < yLen;  ++col)
-      ym[row][col] = y[col];
+    maskArea = mask->GreenArea ();
+    maskTh   = mask->BackgroundPixelTH ();
   }
-}
-
 
+  kkint32  counts[256];
+  const uchar*  grayArea = GrayScaleHistogram (srcImage, mask, counts);
+  if  (!grayArea)
+  {
+    sep = 0;
+    return NULL;
+  }
 
-void  SegmentorOTSU::MakeNanWhenLesOrEqualZero (MatrixD&  m)
-{
-  double**  data = m.DataNotConst ();
-  for  (kkuint32  r = 0;  r < m.NumOfRows ();  ++r)
+  //unI = sort(unique(srcImage));
+  //[histo,pixval] = hist(srcImage(:),unI);
+  kkint32  pixval[256];
+  kkint32  nbins = 0;
+  kkint32  pixelsCounted = 0;
+  for  (x = (zeroIsBackground ? 1 : 0);  x < 256;  ++x)
   {
-    double*  dataRow = data[r];
-    for  (kkuint32 c = 0;  c < m.NumOfCols ();  ++c)
+    if  (counts[x] > 0)
     {
-      if  (dataRow[c] <= 0.0)
-        dataRow[c] = NaN;
+      pixval[nbins] = x;
+      ++nbins;
+      pixelsCounted += counts[x];
     }
   }
-}  /* MakeNanWhenLesOrEqualZero */
 
+  // 'SegmentImage' has always started counting with the second pixel.
+  if  (zeroIsBackground  &&  (totPixels > 0)  &&  (grayArea[0] > 0))
+    --pixelsCounted;
 
+  uchar  labels[256];
+  for  (x = 0;  x < 256;  ++x)
+    labels[x] = 0;
 
-template<typename T>
-vector<T>  SegmentorOTSU::SubSet (const vector<T>&  P, 
-                                  kkint32           start,
-                                  kkint32           end
-                                 )
-{
-  vector<T>  subSet;
-  for  (kkint32 i = start;  i <= end;  ++i)
-    subSet.push_back (P[i]);
-  return  subSet;
-}
-
+  threshold1 = 0;
+  threshold2 = 0;
 
-
-template<typename T>
-T  SegmentorOTSU::SumSubSet (const vector<T>&  P, 
-                             kkint32           start,
-                             kkint32           end
-                            )
-{
-  T  sum = (T)0.0;
-  for  (kkint32 i = start;  i <= end;  ++i)
-    sum += P[i];
-  return  sum;
-}
-
-
-template<typename T>
-void  SegmentorOTSU::ZeroOutNaN (vector<T>&  v)
-{
-  kkuint32  x = 0;
-  for  (x = 0;  x < v.size ();  ++x)
+  if  (nbins <= numClasses)
   {
-    if  (_isnan (v[x]))
-      v[x] = (T)0.0;
+    //for i = 1:numClasses, IDX(srcImage==unI(i)) = i; end
+    for  (x = 0;  x < nbins;  ++x)
+      labels[pixval[x]] = (uchar)x;
+    sep = 1;
   }
-}
+  else
+  {
+    //P = histo/sum(histo);
+    //w = cumsum(P);
+    //mu = cumsum((1:nbins).*P);
+    double  P[256], w[256], mu[256];
+    for  (x = 0;  x < nbins;  ++x)
+      P[x] = (double)(counts[pixval[x]]) / (double)pixelsCounted;
 
-#if  !defined(KKOS_WINDOWS)
-bool  _isnan (double&   d)
-{
-  return  !(std::isnan (d) == 0);
-}
-#endif
+    w [0] = P[0];
+    mu[0] = 1.0 * P[0];
+    for  (x = 1;  x < nbins;  ++x)
+    {
+      w [x] = w [x - 1] + P[x];
+      mu[x] = mu[x - 1] + ((x + 1) * P[x]);
+    }
+    double  muEnd = mu[nbins - 1];
+
+    if  (numClasses == 2)
+    {
+      //sigma2B = (mu(end) * w(2:end-1) - mu(2:end-1)).^2 ./ w(2:end-1)./(1-w(2:end-1));
+      //[maxsig,k] = max(sigma2B);
+      double   maxSig = 0.0;
+      kkint32  k = 1;
+      for  (x = 1;  x < (nbins - 1);  ++x)
+      {
+        double  oneMinusW = 1.0 - w[x];
+        double  p2 = (oneMinusW == 0.0) ? 0.0 : (w[x] / oneMinusW);
+        double  sig = (p2 == 0.0) ? 0.0 : (pow (muEnd * w[x] - mu[x], 2.0) / p2);
+        if  ((x == 1)  ||  (sig > maxSig))
+        {
+          maxSig = sig;
+          k = x;
+        }
+      }
 
+      //IDX(srcImage>pixval(k+1)) = 2;
+      threshold1 = (uchar)pixval[k];
+      if  (zeroIsBackground)
+      {
+        // Lower the threshold until more than 100 pixels are above it.
+        kkint32  numAbove = 0;
+        for  (x = threshold1 + 1;  x < 256;  ++x)
+          numAbove += counts[x];
 
+        while  ((threshold1 > 0)  &&  (numAbove <= 100))
+        {
+          numAbove += counts[threshold1];
+          --threshold1;
+        }
+      }
 
-void  SegmentorOTSU::ZeroOutNaN (MatrixD&  m)
-{
-  double**  data = m.DataNotConst ();
-  kkuint32  numOfRows = m.NumOfRows ();
-  kkuint32  numOfCols = m.NumOfCols ();
+      for  (x = 0;  x < 256;  ++x)
+        labels[x] = (x > threshold1) ? 2 : 1;
 
-  for  (kkuint32 r = 0;  r < numOfRows;  ++r)
-  {
-    double*  dataRow = data[r];
-    for  (kkuint32 c = 0;  c < numOfCols;  ++c)
-    {
-      if  (IsNaN (dataRow[c]))
-        dataRow[c] = 0.0;
+      // Only the last term of 'sum(((1:nbins)-mu(end)).^2.*P)' has ever made it into the
+      // denominator;  left that way so that 'sep' stays comparable with earlier results.
+      sep = maxSig / (pow ((double)nbins - muEnd, 2.0) * P[nbins - 1]);
     }
-  }
-}  /* ZeroOutNaN */
+    else if  (!optimalThresholds)
+    {
+      if  (numClasses > 3)
+      {
+        // Was never implemented;  'OptimalThresholds' supports it.
+        return  NULL;
+      }
 
+      kkint32  k1 = 0, k2 = 0;
+      double  maxSig = SearchThreeClassesLegacy (nbins, P, w, mu, k1, k2);
 
+      //sep = maxsig / sum (((1:nbins)-mu(end)).^2.*P);
+      double  sum = 0.0;
+      for  (x = 0;  x < nbins;  ++x)
+        sum += pow ((double)(x + 1) - muEnd, 2.0) * P[x];
+      sep = maxSig / sum;
 
-VectorDouble  SegmentorOTSU::LinSpace (double  start,
-                                       double  end,
-                                       kkint32 numPoints
-                                      )
-{
-  // The First and last point are known leaving (numPoints - 2) left to distribute between "start" and "end".
-  // which means there will be a total of (numPoints - 1) intervals.
-  double  inc = (end - start) / (double)(numPoints - 1);
-  VectorDouble  result;
-  while  (result.size () < (kkuint32)numPoints)
-  {
-    result.push_back (start);
-    start += inc;
-  }
+      //IDX(srcImage<=pixval(k1)) = 1;  IDX(srcImage>pixval(k1) & srcImage<=pixval(k2)) = 2;  the rest 3.
+      threshold1 = (uchar)pixval[k1];
+      threshold2 = (uchar)pixval[k2];
+      for  (x = 0;  x < 256;  ++x)
+        labels[x] = (x <= threshold1) ? 1 : ((x <= threshold2) ? 2 : 3);
+    }
+    else
+    {
+      kkint32  ends[256];
+      double  maxSig = (numClasses == 3) ? SearchThreeClasses (nbins, w, mu, ends)
+                                         : SearchThresholdsDP (numClasses, nbins, w, mu, ends);
 
-  return  result;
-}  /* LinSpace */
+      // Between class and total variance about the mean of the counted pixels.
+      double  wEnd = w[nbins - 1];
+      double  muT  = muEnd / wEnd;
+      double  sigma2T = 0.0;
+      for  (x = 0;  x < nbins;  ++x)
+        sigma2T += ((x + 1) - muT) * ((x + 1) - muT) * P[x];
 
+      sep = (sigma2T > 0.0) ? ((maxSig - muEnd * muT) / sigma2T) : 0.0;
 
+      threshold1 = (uchar)pixval[ends[0]];
+      threshold2 = (uchar)pixval[ends[1]];
 
-double  SegmentorOTSU::sig_func (VectorDouble          k,
-                                 kkint32               nbins,
-                                 const VectorDouble&   P,
-                                 kkint32               numClasses
-                                )
-{
-  kkint32 x = 0, y = 0;
-
-  // muT = sum((1:nbins).*P);
-  double  muT = 0.0;
-  for  (x = 0, y = 1;  x < nbins;  ++x, ++y)
-    muT += y * P[x];
-
-  //sigma2T = sum(((1:nbins)-muT).^2.*P);
-  double  sigma2T = 0.0;
-  for  (x = 0, y = 1;  x < nbins;  ++x, ++y)
-    sigma2T +=  (pow ((y - muT), 2.0) * P[x]);
-
-  //k = round(k*(nbins-1)+1);
-  for  (x = 0;  x < (kkint32)k.size ();  ++x)
-    k[x] = floor (k[x] * (nbins - 1) + 1.0 + 0.5);
-
-  //k = sort(k);
-  sort (k.begin (), k.end ());
-
-  //if any(k<1 | k>nbins), y = 1; return, end
-  if  ((k[0] < 1.0)  ||  (k[k.size () - 1] > nbins))
-    return 1.0;
-        
-  //k = [0 k nbins];   %  Puts '0' at beginning and 'nbins' at the end.
-  k.insert (k.begin (), 0.0);
-  k.push_back (nbins);
-
-  // sigma2B = 0;
-  double  sigma2B = 0.0;
-
-  //for j = 1:numClasses
-  for  (kkint32 j = 0;  j < numClasses;  ++j)
+      //IDX(srcImage<=pixval(k1)) = 1;  IDX(srcImage>pixval(k1) & srcImage<=pixval(k2)) = 2;  ...
+      kkint32  classIdx = 0;
+      for  (x = 0;  x < 256;  ++x)
+      {
+        while  ((classIdx < (numClasses - 1))  &&  (x > pixval[ends[classIdx]]))
+          ++classIdx;
+        labels[x] = (uchar)(classIdx + 1);
+      }
+    }
+  }
+
+  RasterPtr  result = new Raster (srcImage->Height (), srcImage->Width (), false);
+  uchar*  resultArea = result->GreenArea ();
+  if  (maskArea)
   {
-    //wj = sum(P(k(j)+1:k(j+1)));
-    double  wj = SumSubSet (P, (kkint32)(k[j] + 1), (kkint32)k[j + 1]);
-
-    //if wj==0, y = 1; return, end
-    if  (wj == 0.0)
-      return 1.0;
-
-    //muj = sum((k(j)+1:k(j+1)).*P(k(j)+1:k(j+1)))/wj;
-    kkint32  idxStart = (kkint32)(k[j] + 1);
-    kkint32  idxEnd   = (kkint32)(k[j + 1]);
-    double  muj = 0.0;
-    for  (kkint32 i = idxStart;  i <= idxEnd;  ++i)
-      muj += (i * P[i] / wj);
-
-    //sigma2B = sigma2B + wj*(muj-muT)^2;
-    sigma2B = sigma2B + wj * pow ((muj - muT), 2.0);
+    for  (x = 0;  x < totPixels;  ++x)
+      resultArea[x] = (maskArea[x] > maskTh) ? labels[grayArea[x]] : 0;
+  }
+  else
+  {
+    for  (x = 0;  x < totPixels;  ++x)
+      resultArea[x] = labels[grayArea[x]];
   }
 
-  //y = 1-sigma2B/sigma2T; % within the range [0 1]
-  return  1.0 - sigma2B / sigma2T;
-}  /* sig_func */
+  return  result;
+}  /* Segment */
 
 
 
@@ -740,13 +642,8 @@ RasterPtr  SegmentorOTSU::SegmentImage (RasterPtr  srcImage,
   %   Visit my <a
   %   href="matlab:web('http://www.biomecardio.com/matlab/otsu.html')">website</a> for more details about OTSU
   */
-  
-  kkint32  pixelIdx = 0;
-  kkint32  x        = 0;
-  bool  isColorImage = srcImage->Color ();
 
   //  Checking numClasses (number of classes)
-  
   if  (numClasses == 1)
   {
     //IDX = NaN(size(srcImage));
@@ -761,306 +658,7 @@ RasterPtr  SegmentorOTSU::SegmentImage (RasterPtr  srcImage,
     return NULL;
   }
 
-  if  (isColorImage)
-  {
-    srcImage = srcImage->CreateGrayScaleKLT ();
-  }
-  else
-  {
-    srcImage = new Raster (*srcImage);
-  }
-
-  kkint32  totPixels = srcImage->TotPixels ();
-  kkint32  pixelsCounted = 0;
-  VectorInt  unI;
-  VectorInt  unICounts;
-  {
-    // %% Convert to 256 levels
-    // srcImage = srcImage-min(srcImage(:));
-    // srcImage = round(srcImage/max(srcImage(:))*255);
-    //  Re-scale Source Image to utilize range of 0 through 255.
-
-    //%% Probability dCistribution
-    //unI = sort(unique(srcImage));
-    //nbins = min(length(unI),256);
- 
-
-    uchar*  greenArea = srcImage->GreenArea ();
-
-    uchar  pixelMin = 255;
-    uchar  pixelMax = 1;
-
-    for  (pixelIdx = 1;  pixelIdx < totPixels;  ++pixelIdx)
-    {
-      if  (greenArea[pixelIdx] < 1)
-        continue;
-
-      pixelsCounted++;
-
-      if  (greenArea[pixelIdx] < pixelMin)
-        pixelMin = greenArea[pixelIdx];
-
-      if  (greenArea[pixelIdx] > pixelMax)
-        pixelMax = greenArea[pixelIdx];
-    }
-
-    VectorInt  counts (256, 0);
-
-    for  (pixelIdx = 0;  pixelIdx < totPixels;  ++pixelIdx)
-    {
-      /*
-      double  pixelFraction = (double)((double)(greenArea[pixelIdx]) - pixelMin) / (double)srcRange;
-      kkuint32  newPixelVal = (uchar)(pixelFraction * 256.0 + 0.5);
-      if  (newPixelVal > 255)
-        newPixelVal = 255;
-
-      greenArea[pixelIdx] = (uchar)newPixelVal;
-      counts[newPixelVal]++;
-      */
-      counts[greenArea[pixelIdx]]++;
-    }
-
-    for  (x = 1;  x < (kkint32)counts.size ();  ++x)
-    {
-      if  (counts[x] > 0)
-      {
-        unI.push_back (x);
-        unICounts.push_back (counts[x]);
-      }
-    }
-  }
-
-  kkint32  nbins = (kkint32)unI.size ();
-
-  if  (nbins <= numClasses)
-  {
-    // IDX = ones (size(srcImage));
-    //for i = 1:numClasses, IDX(srcImage==unI(i)) = i; end
-    //sep = 1;
-    RasterPtr  result = new Raster (srcImage->Height (), srcImage->Width (), false);
-    for  (x = 0;  x < nbins;  ++x)
-    {
-      LabelRaster (result, (uchar)unI[x], (char)x, srcImage);
-    }
-    sep = 1;
-    delete  srcImage;   
-    srcImage = NULL;
-    return  result;
-  }
-
-  //elseif  (nbins < 256)
-  //  [histo,pixval] = hist(srcImage(:),unI);
-  //else
-  //  [histo,pixval] = hist(srcImage(:),256);
-  VectorInt  histo  = unICounts;
-  VectorInt  pixval = unI;
-
-  //P = histo/sum(histo);
-  VectorDouble  P (histo.size (), 0.0);
-  for  (x = 0;  x < (kkint32)histo.size ();  ++x)
-    P[x] = (double)(histo[x]) / (double)pixelsCounted;
-
-  //clear unI
-  unI.clear ();
-
-  //%% Zeroth- and first-order cumulative moments
-  //w = cumsum(P);
-  VectorDouble  w (P.size (), 0.0);
-  w[0] = P[0];
-  for  (x = 1;  x < (kkint32)P.size (); ++x)
-    w[x] = w[x - 1] + P[x];
-
-  //mu = cumsum((1:nbins).*P);
-  VectorDouble  mu (P.size (), 0.0);
-  mu[0] = 1.0 * P[0];
-  for  (x = 1;  x < (kkint32)P.size ();  ++x)
-    mu[x] = mu[x - 1] + ((x + 1) * P[x]);
-  double  muEnd = mu[mu.size () - 1];
-  
-  //%% Maximal sigmaB^2 and Segmented image
-  if  (numClasses == 2)
-  {
-    //sigma2B =...
-    //    (mu(end) * w(2:end-1) - mu(2:end-1)) .^2  ./  w(2:end-1)./(1-w(2:end-1));
-    //    ------------------- P1 -----------------      ----------- P2 -----------
-    //[maxsig,k] = max(sigma2B);
-
-    VectorDouble  wSubSet  = SubSet (w,  1, (kkint32)w.size  () - 2);
-    VectorDouble  muSubSet = SubSet (mu, 1, (kkint32)mu.size () - 2);
-   
-    VectorDouble P1 = Power (Subt (muEnd * wSubSet, muSubSet), 2.0);
-    VectorDouble P2 = DotDiv (wSubSet, Subt (1.0, wSubSet));
-    VectorDouble sigma2B = DotDiv (P1, P2);
-    double  maxSig = sigma2B[0];
-    kkint32 maxSigIdx = 0;
-    for  (x = 1;  x < (kkint32)sigma2B.size ();  ++x)
-    {
-      if  (sigma2B[x] > maxSig)
-      {
-        maxSig = sigma2B[x];
-        maxSigIdx = x;
-      }
-    }
-      
-    //[maxsig,k] = max(sigma2B);
-    kkint32  k = maxSigIdx;
-    
-    //% segmented image
-    //IDX = ones(size(srcImage));
-    //IDX(srcImage>pixval(k+1)) = 2;
-    threshold1 = (uchar)pixval[k + 1];
-    RasterPtr  result = new Raster (srcImage->Height (), srcImage->Width (), false);
-    uchar*  resultArea = result->GreenArea ();
-    uchar*  srcArea    = srcImage->GreenArea ();
-
-    while  (true)
-    {
-      kkuint32  numClass2Pixs = 0;
-      for  (x = 0;  x < totPixels;  ++x)
-      {
-        if  (srcArea[x] > threshold1)
-        {
-          resultArea[x] = 2;
-          ++numClass2Pixs;
-        }
-        else
-        {
-          resultArea[x] = 1;
-        }
-      }
-
-      if  ((threshold1 < 1)  ||  (numClass2Pixs >100))
-        break;
-      --threshold1;
-    }
-    
-    //% separability criterion
-    //sep = maxsig/sum(((1:nbins)-mu(end)).^2.*P);
-    double  sum = 0.0;
-    kkint32  y = 0;
-    muEnd = mu[mu.size () - 1];
-    for  (x = 0, y = 1;  x < nbins;  ++x, ++y)
-      sum = pow (((double)y - muEnd), 2.0) * P[x];
-
-    sep = maxSig / sum;
-    delete  srcImage;
-    srcImage = NULL;
-    return  result;
-  }
-    
-  if  (numClasses == 3)
-  {
-    //w0 = w;
-    //w2 = fliplr(cumsum(fliplr(P)));
-    VectorDouble  w0 = w;
-    VectorDouble  w2 = FlipLeftRight (CumSum (FlipLeftRight (P)));
-
-
-    //[w0,w2] = ndgrid(w0,w2);
-    MatrixD w0M ((kkint32)w0.size (), (kkint32)w0.size ());
-    MatrixD w2M ((kkint32)w2.size (), (kkint32)w2.size ());
-    NdGrid (w0, w2, w0M, w2M);
-
-    
-    //mu0 = mu./w;
-    VectorDouble  mu0 = DotDiv (mu, w);
-
-    //mu2 = fliplr(cumsum(fliplr((1:nbins).*P)) ./ cumsum(fliplr(P)));
-    //            1      2      34       4   32        3      4 321
-    //             ---------- P1 -------------     ------ P2 --------
-    VectorDouble  P1 = CumSum (FlipLeftRight (DotMult (BDV (1.0, 1.0, (double)nbins), P)));
-    VectorDouble  P2 = CumSum (FlipLeftRight (P));
-    VectorDouble  mu2 = FlipLeftRight (DotDiv (P1, P2));
-
-    // TODO  
-    //[mu0,mu2] = ndgrid(mu0,mu2);
-    MatrixD  mu0M ((kkint32)mu0.size (), (kkint32)mu0.size ());
-    MatrixD  mu2M ((kkint32)mu2.size (), (kkint32)mu2.size ());
-    NdGrid (mu0, mu2, mu0M, mu2M);
-    
-    //w1 = 1-w0-w2;
-    MatrixD  w1M = 1.0 - w0M - w2M;
-
-    //w1(w1<=0) = NaN;
-    MakeNanWhenLesOrEqualZero (w1M);
-
-    //sigma2B =...
-    //    w0.*(mu0-mu(end)).^2 + w2.*(mu2-mu(end)).^2 +...
-    //    (w0.*(mu0-mu(end)) + w2.*(mu2-mu(end))).^2./w1;
-    MatrixD  P1M = (DotMult (w0M, Power ((mu0M - muEnd), 2.0)))  +  (DotMult (w2M, Power ((mu2M - muEnd), 2.0)));
-    MatrixD  P2M = DotDiv (Power ((DotMult (w0M, (mu0M - muEnd)) + DotMult (w2M, (mu2M - muEnd))), 2.0), w1M);
-    MatrixD  sigma2B = P1M + P2M;
-
-
-    //sigma2B(isnan(sigma2B)) = 0; % zeroing if k1 >= k2
-    ZeroOutNaN (sigma2B);
-
-    //[maxsig,k] = max(sigma2B(:));         % Turns sigma2B into 1D Array then locates largest value and index.
-    // [k1,k2] = ind2sub([nbins nbins],k);  % Sets k1 and k2 to the indexes for k mapped into a 2D square matrix that is (nbins x nbins)
-    kkuint32  k1 = 0, k2 = 0;
-    double  maxsig = 0.0;
-    sigma2B.FindMaxValue (maxsig, k1, k2);
-   
-    //% segmented image
-    RasterPtr  result = new Raster (srcImage->Height (), srcImage->Width (), false);
-    {
-      //IDX = ones(size(srcImage))*3;
-      //IDX(srcImage<=pixval(k1)) = 1;
-      //IDX(srcImage>pixval(k1) & srcImage<=pixval(k2)) = 2;
-      uchar*  srcData = srcImage->GreenArea ();
-      uchar*  data = result->GreenArea ();
-      threshold1 = (uchar)pixval[k1];
-      threshold2 = (uchar)pixval[k2];
-      for  (x = 0;  x < totPixels;  ++x)
-      {
-        if  (srcData[x] <= threshold1)
-          data[x] = 1;
-        else if  (srcData[x] <= threshold2)
-          data[x] = 2;
-        else
-          data[x] = 3;
-      }
-    }
-    
-    //% separability criterion
-    //sep = maxsig / sum (((1:nbins)-mu(end)).^2.*P);
-
-    //VectorDouble  xxx = BDV (1.0, 1.0, (double)nbins);
-    //VectorDouble  yyy = Subt (xxx, muEnd);
-    //VectorDouble  zzz = Power (yyy, 2.0);
-    sep = maxsig / Sum (DotMult (Power (Subt (BDV (1.0, 1.0, (double)nbins), muEnd), 2.0), P));
-    delete  srcImage;
-    srcImage = NULL;
-    return  result;
-  }
-    
-  {
-    /*
-    //k0 = linspace(0,1,numClasses+1);   %  k0 = row vector of linear spaced points between 0 and 1  with (numClasses + 1) points
-    VectorDouble  k0 = LinSpace (0, 1, numClasses + 1);
-
-    //k0 = k0(2:numClasses);
-    
-
-    [k,y] = fminsearch(@sig_func,k0,optimset('TolX',1));
-    k = round(k*(nbins-1)+1);
-    
-    % segmented image
-    IDX = ones(size(srcImage))*numClasses;
-    IDX(srcImage<=pixval(k(1))) = 1;
-    for i = 1:numClasses-2
-        IDX(srcImage>pixval(k(i)) & srcImage<=pixval(k(i+1))) = i+1;
-    end
-    
-    % separability criterion
-    sep = 1-y;
-    */
-  }
-
-  delete  srcImage;
-  srcImage = NULL;
-    
-  return NULL;
+  return  Segment (srcImage, NULL, true, numClasses, sep);
 }  /* SegmentImage */
 
 
@@ -1072,7 +670,7 @@ RasterPtr  SegmentorOTSU::SegmentImage (RasterPtr  srcImage,
  *                      converted to GrayScale using 'CreateGrayScaleKLTOnMaskedArea'
  *@param[in]  mask  Indicates which pixels to consider when thresholding image.  Pixels 
  *                  that are not part of mask will be assigned label '0'.
- *@param[in]  numClasses Number of classes to segment image into.  Current only '2' and '3' are supported.
+ *@param[in]  numClasses Number of classes to segment image into.  Between '2' and '255'.
  *@param[out]  sep  
  *@return  Labeled GrayScale image where pixels will be label into their respective class; between '1' and 'numClasses'.
  */
@@ -1082,18 +680,6 @@ RasterPtr  SegmentorOTSU::SegmentMaskedImage (RasterPtr  srcImage,
                                               double&    sep
                                              )
 {
-  kkint32  pixelIdx = 0;
-  kkint32  x        = 0;
-  bool  isColorImage = srcImage->Color ();
-
-  uchar*  maskArea = NULL;
-  uchar   maskTh   = 0;
-  if  (mask)
-  {
-    maskArea = mask->GreenArea ();
-    maskTh   = mask->BackgroundPixelTH ();
-  }
-
   if  (numClasses == 1)
   {
     return  NULL;
@@ -1108,248 +694,7 @@ RasterPtr  SegmentorOTSU::SegmentMaskedImage (RasterPtr  srcImage,
     return NULL;
   }
 
-  if  (isColorImage)
-  {
-    if  (mask)
-      srcImage = srcImage->CreateGrayScaleKLTOnMaskedArea (*mask);
-    else
-      srcImage = srcImage->CreateGrayScaleKLT ();
-  }
-  else
-  {
-    srcImage = new Raster (*srcImage);
-  }
-
-  kkint32  totPixels = srcImage->TotPixels ();
-  kkint32  totMaskPixels = totPixels;
-  if  (mask)
-    totMaskPixels = mask->TotalBackgroundPixels ();
-
-  VectorInt  unI;
-  VectorInt  unICounts;
-  
-  {
-    uchar*  greenArea = srcImage->GreenArea ();
-
-    uchar  pixelMin = greenArea[0];
-    uchar  pixelMax = greenArea[0];
-
-    for  (pixelIdx = 1;  pixelIdx < totPixels;  ++pixelIdx)
-    {
-      if  ((!mask)  ||  (maskArea[pixelIdx] > maskTh))
-      {
-        if  (greenArea[pixelIdx] < pixelMin)
-          pixelMin = greenArea[pixelIdx];
-
-        if  (greenArea[pixelIdx] > pixelMax)
-          pixelMax = greenArea[pixelIdx];
-      }
-    }
-
-    //kkint32  srcRange = pixelMax - pixelMin + 1;
-    VectorInt  counts (256, 0);
-
-    for  (pixelIdx = 0;  pixelIdx < totPixels;  ++pixelIdx)
-    {
-      if  ((!mask)  ||  (maskArea[pixelIdx] > maskTh))
-        counts[greenArea[pixelIdx]]++;
-    }
-
-    for  (x = 0;  x < (kkint32)counts.size ();  ++x)
-    {
-      if  (counts[x] > 0)
-      {
-        unI.push_back (x);
-        unICounts.push_back (counts[x]);
-      }
-    }
-  }
-
-  kkint32  nbins = (kkint32)unI.size ();
-
-  if  (nbins <= numClasses)
-  {
-    RasterPtr  result = new Raster (srcImage->Height (), srcImage->Width (), false);
-    for  (x = 0;  x < nbins;  ++x)
-    {
-      LabelRaster (result, mask, (uchar)(unI[x]), (uchar)x, srcImage);
-    }
-    sep = 1;
-    delete  srcImage;   
-    srcImage = NULL;
-    return  result;
-  }
-
-  VectorInt  histo  = unICounts;
-  VectorInt  pixval = unI;
-
-  VectorDouble  P (histo.size (), 0.0);
-  for  (x = 0;  x < (kkint32)histo.size ();  ++x)
-    P[x] = (double)(histo[x]) / (double)totMaskPixels;
-
-  unI.clear ();
-
-  //%% Zeroth- and first-order cumulative moments
-  //w = cumsum(P);
-  VectorDouble  w (P.size (), 0.0);
-  w[0] = P[0];
-  for  (x = 1;  x < (kkint32)P.size (); ++x)
-    w[x] = w[x - 1] + P[x];
-
-  //mu = cumsum((1:nbins).*P);
-  VectorDouble  mu (P.size (), 0.0);
-  mu[0] = 1.0 * P[0];
-  for  (x = 1;  x < (kkint32)P.size ();  ++x)
-    mu[x] = mu[x - 1] + ((x + 1) * P[x]);
-  double  muEnd = mu[mu.size () - 1];
-  
-  //%% Maximal sigmaB^2 and Segmented image
-  if  (numClasses == 2)
-  {
-    //sigma2B =...
-    //    (mu(end) * w(2:end-1) - mu(2:end-1)) .^2  ./  w(2:end-1)./(1-w(2:end-1));
-    //    ------------------- P1 -----------------      ----------- P2 -----------
-    //[maxsig,k] = max(sigma2B);
-
-    VectorDouble  wSubSet  = SubSet (w,  1, (kkint32)w.size  () - 2);
-    VectorDouble  muSubSet = SubSet (mu, 1, (kkint32)mu.size () - 2);
-   
-    VectorDouble P1 = Power (Subt (muEnd * wSubSet, muSubSet), 2.0);
-    VectorDouble P2 = DotDiv (wSubSet, Subt (1.0, wSubSet));
-    VectorDouble sigma2B = DotDiv (P1, P2);
-    double  maxSig = sigma2B[0];
-    kkint32 maxSigIdx = 0;
-    for  (x = 1;  x < (kkint32)sigma2B.size ();  ++x)
-    {
-      if  (sigma2B[x] > maxSig)
-      {
-        maxSig = sigma2B[x];
-        maxSigIdx = x;
-      }
-    }
-      
-    //[maxsig,k] = max(sigma2B);
-    kkint32  k = maxSigIdx;
-    
-    //% segmented image
-    //IDX = ones(size(srcImage));
-    //IDX(srcImage>pixval(k+1)) = 2;
-    kkint32  threshold = pixval[k + 1];
-    RasterPtr  result = new Raster (srcImage->Height (), srcImage->Width (), false);
-    uchar*  resultArea = result->GreenArea ();
-    uchar*  srcArea    = srcImage->GreenArea ();
-    for  (x = 0;  x < totPixels;  ++x)
-    {
-      if  ((!maskArea)  ||  (maskArea[x] > maskTh))
-      {
-        if  (srcArea[x] > threshold)
-          resultArea[x] = 2;
-        else
-          resultArea[x] = 1;
-      }
-      else
-      {
-        resultArea[x] = 0;
-      }
-    }
-    
-    //% separability criterion
-    //sep = maxsig/sum(((1:nbins)-mu(end)).^2.*P);
-    double  sum = 0.0;
-    kkint32  y = 0;
-    muEnd = mu[mu.size () - 1];
-    for  (x = 0, y = 1;  x < nbins;  ++x, ++y)
-      sum = pow (((double)y - muEnd), 2.0) * P[x];
-
-    sep = maxSig / sum;
-    delete  srcImage;
-    srcImage = NULL;
-    return  result;
-  }
-    
-  if  (numClasses == 3)
-  {
-    VectorDouble  w0 = w;
-    VectorDouble  w2 = FlipLeftRight (CumSum (FlipLeftRight (P)));
-
-    MatrixD w0M ((kkint32)w0.size (), (kkint32)w0.size ());
-    MatrixD w2M ((kkint32)w2.size (), (kkint32)w2.size ());
-    NdGrid (w0, w2, w0M, w2M);
-    
-    VectorDouble  mu0 = DotDiv (mu, w);
-
-    //mu2 = fliplr(cumsum(fliplr((1:nbins).*P)) ./ cumsum(fliplr(P)));
-    //            1      2      34       4   32        3      4 321
-    //             ---------- P1 -------------     ------ P2 --------
-    VectorDouble  P1 = CumSum (FlipLeftRight (DotMult (BDV (1.0, 1.0, (double)nbins), P)));
-    VectorDouble  P2 = CumSum (FlipLeftRight (P));
-    VectorDouble  mu2 = FlipLeftRight (DotDiv (P1, P2));
-
-    //[mu0,mu2] = ndgrid(mu0,mu2);
-    MatrixD  mu0M ((kkint32)mu0.size (), (kkint32)mu0.size ());
-    MatrixD  mu2M ((kkint32)mu2.size (), (kkint32)mu2.size ());
-    NdGrid (mu0, mu2, mu0M, mu2M);
-    
-    //w1 = 1-w0-w2;
-    MatrixD  w1M = 1.0 - w0M - w2M;
-
-    //w1(w1<=0) = NaN;
-    MakeNanWhenLesOrEqualZero (w1M);
-
-    //sigma2B =...
-    //    w0.*(mu0-mu(end)).^2 + w2.*(mu2-mu(end)).^2 +...
-    //    (w0.*(mu0-mu(end)) + w2.*(mu2-mu(end))).^2./w1;
-    MatrixD  P1M = (DotMult (w0M, Power ((mu0M - muEnd), 2.0)))  + (DotMult (w2M, Power ((mu2M - muEnd), 2.0)));
-    MatrixD  P2M = DotDiv (Power ((DotMult (w0M, (mu0M - muEnd)) +  DotMult (w2M, (mu2M - muEnd))), 2.0), w1M);
-    MatrixD  sigma2B = P1M + P2M;
-
-    //sigma2B(isnan(sigma2B)) = 0; % zeroing if k1 >= k2
-    ZeroOutNaN (sigma2B);
-
-    //[maxsig,k] = max(sigma2B(:));         % Turns sigma2B into 1D Array then locates largest value and index.
-    // [k1,k2] = ind2sub([nbins nbins],k);  % Sets k1 and k2 to the indexes for k mapped into a 2D square matrix that is (nbins x nbins)
-    kkuint32  k1 = 0, k2 = 0;
-    double  maxsig = 0.0;
-    sigma2B.FindMaxValue (maxsig, k1, k2);
-   
-    //% segmented image
-    RasterPtr  result = new Raster (srcImage->Height (), srcImage->Width (), false);
-    {
-      //IDX = ones(size(srcImage))*3;
-      //IDX(srcImage<=pixval(k1)) = 1;
-      //IDX(srcImage>pixval(k1) & srcImage<=pixval(k2)) = 2;
-      uchar*  srcData = srcImage->GreenArea ();
-      uchar*  data = result->GreenArea ();
-      double  th1 = pixval[k1];
-      double  th2 = pixval[k2];
-      for  (x = 0;  x < totPixels;  ++x)
-      {
-        if  ((!maskArea)  ||  (maskArea[x] > maskTh))
-        {
-          if  (srcData[x] <= th1)
-            data[x] = 1;
-          else if  (srcData[x] <= th2)
-            data[x] = 2;
-          else
-            data[x] = 3;
-        }
-        else
-        {
-          data[x] = 0;
-        }
-      }
-    }
-    
-    sep = maxsig / Sum (DotMult (Power (Subt (BDV (1.0, 1.0, (double)nbins), muEnd), 2.0), P));
-    delete  srcImage;
-    srcImage = NULL;
-    return  result;
-  }
-    
-  delete  srcImage;
-  srcImage = NULL;
-    
-  return NULL;
+  return  Segment (srcImage, mask, false, numClasses, sep);
 }  /* SegmentMaskedImage */
 
 
@@ -6,7 +6,6 @@
 #define _SEGMENTOROTSU_
 
 #include  "KKBaseTypes.h"
-#include  "Matrix.h"
 #include  "KKStr.h"
 #include  "Raster.h"
 #include  "RunLog.h"
@@ -30,6 +29,11 @@ namespace KKB
    **     IEEE Trans. Syst. Man Cybern. 9:62-66;1979                                    *
    **************************************************************************************
    *@endcode
+   *
+   * The thresholds are searched for directly on the histogram of the (at most 256) gray levels that occur in
+   * the image.  By default the results are those of the original implementation;  'OptimalThresholds' turns on
+   * an exhaustive search for 3 classes and dynamic programming for more.  The scratch buffers
+   * are kept between calls so an instance used for a stream of images allocates little more than the result.
    *@sa raster
    */
 
@@ -37,13 +41,13 @@ namespace KKB
   {
   public:
     SegmentorOTSU (RunLog&  _log);
-	  ~SegmentorOTSU ();
+    ~SegmentorOTSU ();
 
     /**
      *@brief  Segments image into 'numClasses'.
      *@param[in]  srcImage  Image to segment.  If it is a color image will be 
      *                      converted to Gray-Scale using 'CreateGrayScaleKLTOnMaskedArea'
-     *@param[in]  numClasses Number of classes to segment image into.  Current only '2' and '3' are supported.
+     *@param[in]  numClasses Number of classes to segment image into.  Between '2' and '255'.
      *@param[out]  sep  
      *@return  Labeled gray-scale image where pixels will be labels into their respective class; between '1' and 'numClasses'.
      */
@@ -60,7 +64,7 @@ namespace KKB
      *                      converted to Gray-Scale using 'CreateGrayScaleKLTOnMaskedArea'
      *@param[in]  mask  Indicates which pixels to consider when thresholding image.  Pixels
      *                  that are not part of mask will be assigned label '0'.
-     *@param[in]  numClasses Number of classes to segment image into.  Current only '2' and '3' are supported.
+     *@param[in]  numClasses Number of classes to segment image into.  Between '2' and '255'.
      *@param[out]  sep  
      *@return  Labeled gray-scale image where pixels will be label into their respective class; between '1' and 'numClasses'.
      */
@@ -98,126 +102,104 @@ namespace KKB
     uchar  Threshold1 ()  const  {return threshold1;}
     uchar  Threshold2 ()  const  {return threshold2;}
 
+    bool   OptimalThresholds ()  const  {return optimalThresholds;}
 
-  private:
-    void   LabelRaster (RasterPtr  result, 
-                        uchar      pixelValue,
-                        uchar      label,
-                        RasterPtr  srcImage
-                       );
-
-    void   LabelRaster (RasterPtr  result, 
-                        RasterPtr  mask,
-                        uchar      pixelValue,
-                        uchar      label,
-                        RasterPtr  srcImage
-                       );
-
-    double  sig_func (VectorDouble          k,
-                      kkint32               nbins,
-                      const VectorDouble&   P,
-                      kkint32               numClasses
-                     );
-
-   template<typename T>
-   vector<T>  BDV (T  start,
-                   T  inc,
-                   T  end
-                  );
-
-
-   VectorDouble  Add (const VectorDouble&  left,
-                      double               right
-                     );
-
-
-   template<typename T>
-   vector<T>   CumSum (const vector<T>&  v);
-
-
-   VectorDouble  DotMult (const VectorDouble&  left,
-                          const VectorDouble&  right
-                         );
-
-   MatrixD  DotMult (const MatrixD&  left,
-                     const MatrixD&  right
-                    );
-
-
-   VectorDouble  DotDiv (const VectorDouble&  left,
-                         const VectorDouble&  right
-                        );
-
-   MatrixD  DotDiv (const MatrixD&  left,
-                    const MatrixD&  right
-                   );
-
-   template<typename T>
-   vector<T>   FlipLeftRight (const vector<T>&  v);
-
-   VectorDouble  LinSpace (double  start,
-                           double  end,
-                           kkint32 numPoints
-                          );
-
-   void  MakeNanWhenLesOrEqualZero (MatrixD&  m);
+    /**
+     *@brief  Selects how thresholds are searched for when segmenting into 3 or more classes;  defaults to false.
+     *@details  When false 3 classes are searched for over the same 'sigma2B' grid, with the same arithmetic,
+     * as 'SegmentImage' always has and more than 3 classes return NULL;  results stay identical to earlier
+     * releases.  That search divides by a zero middle class weight at its first cell so it nearly always
+     * ends up with 'Threshold1' == 'Threshold2' == the lowest gray level and an infinite 'sep'.  When true the
+     * thresholds that maximize the between class variance are found, 'sep' is that variance over the total
+     * variance, and any number of classes is supported.  Two class segmentation is the same either way.
+     */
+    void   OptimalThresholds (bool  _optimalThresholds)  {optimalThresholds = _optimalThresholds;}
 
-   void  NdGrid (const VectorDouble&  x,
-                 const VectorDouble&  y,
-                 MatrixD&             xm,
-                 MatrixD&             ym
-                );
 
+  private:
+    /**
+     *@brief  Returns the gray-scale levels of 'srcImage' and fills in 'counts' with the number of pixels at each level.
+     *@details  Gray-scale images are used as is.  Color images are projected onto the principal component of
+     * their RGB values, the same way 'Raster::CreateGrayScaleKLT' and 'Raster::CreateGrayScaleKLTOnMaskedArea'
+     * do it, into 'grayScale';  the covariance is accumulated in one pass and no per pixel floating point
+     * channels are allocated.  Only pixels that are part of 'mask' are counted.  Returns NULL on failure.
+     */
+    const uchar*  GrayScaleHistogram (RasterPtr  srcImage,
+                                      RasterPtr  mask,
+                                      kkint32*   counts
+                                     );
 
-   VectorDouble  Power (const VectorDouble&  left,
-                        double               right
+    /**
+     *@brief  Common implementation of 'SegmentImage' and 'SegmentMaskedImage'.
+     *@param[in]  zeroIsBackground  When true level '0' is left out of the histogram and the 2 class threshold
+     *            is lowered until more than 100 pixels are above it;  what 'SegmentImage' has always done.
+     */
+    RasterPtr  Segment (RasterPtr  srcImage,
+                        RasterPtr  mask,
+                        bool       zeroIsBackground,
+                        kkint32    numClasses,
+                        double&    sep
                        );
 
-   MatrixD  Power (const MatrixD&  left,
-                   double          right
-                  );
-
-   VectorDouble  Round (const VectorDouble&  v);
-  
-   VectorDouble  Subt (const VectorDouble&  left,
-                       const VectorDouble&  right
-                      );
-
-   VectorDouble  Subt (const VectorDouble&  left,
-                       double               right
-                      );
-
-   VectorDouble  Subt (double               left,
-                       const VectorDouble&  right
-                      );
-
-   template<typename T>
-   vector<T>  SubSet (const vector<T>&  P, 
-                      kkint32           start,
-                      kkint32           end
-                     );
-
-   template<typename T>
-   T  Sum (const vector<T>&  v);
-
-   template<typename T>
-   T  SumSubSet (const vector<T>&  P, 
-                 kkint32           start,
-                 kkint32           end
-                );
-
-   template<typename T>
-   void  ZeroOutNaN (vector<T>&  v);
-
-   void  ZeroOutNaN (MatrixD&  m);
+    /**
+     *@brief  Square of the first order moment over the zeroth order moment of histogram bins 'first' through 'last'.
+     *@details  'w' and 'mu' are the cumulative zeroth and first order moments.  Summed over the classes this is
+     * the between class variance plus a constant so maximizing one maximizes the other.
+     */
+    static  double  ClassMoment (const double*  w,
+                                 const double*  mu,
+                                 kkint32        first,
+                                 kkint32        last
+                                );
 
+    /**
+     *@brief  The 3 class search 'SegmentImage' and 'SegmentMaskedImage' have always done.
+     *@details  Evaluates the MatLab 'sigma2B' expression for every ('k1', 'k2') cell in the order and with the
+     * operations the earlier 'MatrixD' implementation used;  cells that are NaN count as 0 and the first
+     * maximum, scanning row by row, wins.  O(nbins^2) with no matrices allocated.
+     *@param[out]  k1  Histogram bin of 'Threshold1'.
+     *@param[out]  k2  Histogram bin of 'Threshold2'.
+     *@return  'sigma2B' at ('k1', 'k2').
+     */
+    static  double  SearchThreeClassesLegacy (kkint32        nbins,
+                                              const double*  P,
+                                              const double*  w,
+                                              const double*  mu,
+                                              kkint32&       k1,
+                                              kkint32&       k2
+                                             );
 
-   //VectorDouble  PWD
+    /**
+     *@brief  Exhaustive O(nbins^2) search for the two thresholds that maximize the between class variance.
+     *@param[out]  ends  Last histogram bin of each of the three classes.
+     *@return  Sum of 'ClassMoment' of the best split.
+     */
+    double  SearchThreeClasses (kkint32        nbins,
+                                const double*  w,
+                                const double*  mu,
+                                kkint32*       ends
+                               );
 
-    uchar   threshold1;
-    uchar   threshold2;
-    double  NaN;
-    RunLog&  log;
+    /**
+     *@brief  Dynamic programming search for the 'numClasses' - 1 thresholds that maximize the between class variance.
+     *@details  O(numClasses * nbins^2);  the tables are kept in 'dpBest' and 'dpSplit' between calls.
+     *@param[out]  ends  Last histogram bin of each class.
+     *@return  Sum of 'ClassMoment' of the best split.
+     */
+    double  SearchThresholdsDP (kkint32        numClasses,
+                                kkint32        nbins,
+                                const double*  w,
+                                const double*  mu,
+                                kkint32*       ends
+                               );
+
+    VectorDouble        dpBest;
+    VectorInt32         dpSplit;
+    std::vector<uchar>  grayScale;   /**< Gray-scale version of color images;  reused between calls. */
+    bool                optimalThresholds;
+    uchar               threshold1;
+    uchar               threshold2;
+    RunLog&             log;
   };  /* SegmentorOTSU */
 }  /* KKB */
 
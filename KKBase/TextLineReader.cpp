@@ -0,0 +1,373 @@
+/* TextLineReader.cpp -- Reads a text stream a block at a time and splits it into lines without copying them.
+ * Copyright (C) 1994-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#include "FirstIncludes.h"
+#include <ctype.h>
+#include <istream>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#include "TextLineReader.h"
+#include "KKException.h"
+#include "KKStr.h"
+using namespace KKB;
+
+
+
+TextLineReader::TextLineReader (istream&  _in,
+                                kkuint32  _blockSize
+                               ):
+    buff      (NULL),
+    buffLen   (0),
+    buffSize  (_blockSize < 1024 ? 1024 : _blockSize),
+    in        (_in),
+    inEof     (false),
+    linesRead (0),
+    nextPos   (0)
+{
+  buff = new char[buffSize];
+}
+
+
+
+TextLineReader::~TextLineReader ()
+{
+  delete[]  buff;
+  buff = NULL;
+}
+
+
+
+bool  TextLineReader::FillBuffer ()
+{
+  if  (inEof)
+    return false;
+
+  if  (nextPos > 0)
+  {
+    buffLen -= nextPos;
+    memmove (buff, buff + nextPos, buffLen);
+    nextPos = 0;
+  }
+
+  if  (buffLen >= buffSize)
+  {
+    // A single line is longer than the buffer.
+    kkuint32  newBuffSize = buffSize * 2;
+    char*  newBuff = new char[newBuffSize];
+    memcpy (newBuff, buff, buffLen);
+    delete[]  buff;
+    buff = newBuff;
+    buffSize = newBuffSize;
+  }
+
+  in.read (buff + buffLen, buffSize - buffLen);
+  kkuint32  bytesRead = static_cast<kkuint32> (in.gcount ());
+  if  (bytesRead < (buffSize - buffLen))
+    inEof = true;
+
+  buffLen += bytesRead;
+  return  (bytesRead > 0);
+}  /* FillBuffer */
+
+
+
+bool  TextLineReader::NextLineInBuffer (Line&  line)
+{
+  if  (nextPos >= buffLen)
+    return false;
+
+  const char*  start = buff + nextPos;
+  const char*  end   = buff + buffLen;
+  const char*  p     = start;
+  while  ((p < end)  &&  (*p != '\n')  &&  (*p != '\r'))
+    ++p;
+
+  if  (p >= end)
+  {
+    if  (!inEof)
+      return false;
+
+    // Last line of stream has no terminator.
+    line.str = start;
+    line.len = static_cast<kkuint32> (p - start);
+    nextPos = buffLen;
+    ++linesRead;
+    return true;
+  }
+
+  if  (((p + 1) >= end)  &&  (!inEof))
+  {
+    // Can not tell yet if the terminator is one or two characters.
+    return false;
+  }
+
+  line.str = start;
+  line.len = static_cast<kkuint32> (p - start);
+
+  char  terminator = *p;
+  ++p;
+  if  ((p < end)  &&  ((*p == '\n')  ||  (*p == '\r'))  &&  (*p != terminator))
+    ++p;
+
+  nextPos = static_cast<kkuint32> (p - buff);
+  ++linesRead;
+  return true;
+}  /* NextLineInBuffer */
+
+
+
+bool  TextLineReader::GetLine (Line&  line)
+{
+  while  (true)
+  {
+    if  (NextLineInBuffer (line))
+      return true;
+
+    if  (!FillBuffer ())
+      return NextLineInBuffer (line);
+  }
+}  /* GetLine */
+
+
+
+kkuint32  TextLineReader::GetBlockOfLines (LineList&  lines)
+{
+  lines.clear ();
+  while  (true)
+  {
+    FillBuffer ();
+
+    Line  line;
+    while  (NextLineInBuffer (line))
+      lines.push_back (line);
+
+    if  ((!lines.empty ())  ||  inEof)
+      break;
+  }
+
+  return  static_cast<kkuint32> (lines.size ());
+}  /* GetBlockOfLines */
+
+
+
+double  TextLineReader::ParseDouble (const char*  str,
+                                     const char*  end
+                                    )
+{
+  // Powers of ten that are represented exactly by a double.
+  static const double  powersOf10[] = {1.0e0,  1.0e1,  1.0e2,  1.0e3,  1.0e4,  1.0e5,  1.0e6,  1.0e7,
+                                       1.0e8,  1.0e9,  1.0e10, 1.0e11, 1.0e12, 1.0e13, 1.0e14, 1.0e15,
+                                       1.0e16, 1.0e17, 1.0e18, 1.0e19, 1.0e20, 1.0e21, 1.0e22
+                                      };
+
+  const char*  p = str;
+  while  ((p < end)  &&  isspace (static_cast<uchar> (*p)))
+    ++p;
+
+  bool  negative = false;
+  if  ((p < end)  &&  ((*p == '-')  ||  (*p == '+')))
+  {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  kkuint64  mantissa        = 0;
+  kkint32   numSigDigits    = 0;
+  kkint32   exponent        = 0;
+  bool      digitsFound     = false;
+  bool      tooManyDigits   = false;
+
+  while  ((p < end)  &&  isdigit (static_cast<uchar> (*p)))
+  {
+    digitsFound = true;
+    if  ((mantissa > 0)  ||  (*p != '0'))
+    {
+      if  (numSigDigits < 19)
+      {
+        mantissa = mantissa * 10 + static_cast<kkuint64> (*p - '0');
+        ++numSigDigits;
+      }
+      else
+      {
+        tooManyDigits = true;
+      }
+    }
+    ++p;
+  }
+
+  if  ((p < end)  &&  (*p == '.'))
+  {
+    ++p;
+    while  ((p < end)  &&  isdigit (static_cast<uchar> (*p)))
+    {
+      digitsFound = true;
+      if  ((mantissa > 0)  ||  (*p != '0'))
+      {
+        if  (numSigDigits < 19)
+        {
+          mantissa = mantissa * 10 + static_cast<kkuint64> (*p - '0');
+          ++numSigDigits;
+        }
+        else
+        {
+          tooManyDigits = true;
+        }
+      }
+      --exponent;
+      ++p;
+    }
+  }
+
+  if  (digitsFound  &&  (p < end)  &&  ((*p == 'e')  ||  (*p == 'E')))
+  {
+    // Only an exponent if followed by digits;  otherwise 'atof' stops at the 'e'.
+    const char*  e = p + 1;
+    bool  expNegative = false;
+    if  ((e < end)  &&  ((*e == '-')  ||  (*e == '+')))
+    {
+      expNegative = (*e == '-');
+      ++e;
+    }
+
+    if  ((e < end)  &&  isdigit (static_cast<uchar> (*e)))
+    {
+      kkint32  expValue = 0;
+      while  ((e < end)  &&  isdigit (static_cast<uchar> (*e)))
+      {
+        if  (expValue < 100000)
+          expValue = expValue * 10 + (*e - '0');
+        ++e;
+      }
+      exponent += (expNegative ? -expValue : expValue);
+      p = e;
+    }
+  }
+
+  bool  hexPrefix = (p < end)  &&  ((*p == 'x')  ||  (*p == 'X'));
+
+  if  (digitsFound  &&  (!tooManyDigits)  &&  (!hexPrefix)  &&  (mantissa <= (kkuint64(1) << 53)))
+  {
+    if  (mantissa == 0)
+      return  negative ? -0.0 : 0.0;
+
+    if  ((exponent >= -22)  &&  (exponent <= 22))
+    {
+      // Both operands are exact so the single rounding gives the same result as 'atof'.
+      double  result = static_cast<double> (mantissa);
+      if  (exponent < 0)
+        result /= powersOf10[-exponent];
+      else
+        result *= powersOf10[exponent];
+      return  negative ? -result : result;
+    }
+  }
+
+  // Everything else, ex: "inf", "nan", hex, very long or very large numbers, is left to 'atof'.
+  char  smallBuff[64];
+  kkuint32  len = static_cast<kkuint32> (end - str);
+  if  (len < sizeof (smallBuff))
+  {
+    memcpy (smallBuff, str, len);
+    smallBuff[len] = 0;
+    return  atof (smallBuff);
+  }
+  else
+  {
+    KKStr  s (str, 0, len - 1);
+    return  atof (s.Str ());
+  }
+}  /* ParseDouble */
+
+
+
+kkint32  TextLineReader::ParseInt32 (const char*  str,
+                                     const char*  end
+                                    )
+{
+  const char*  p = str;
+  while  ((p < end)  &&  isspace (static_cast<uchar> (*p)))
+    ++p;
+
+  bool  negative = false;
+  if  ((p < end)  &&  ((*p == '-')  ||  (*p == '+')))
+  {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  kkint64  result = 0;
+  while  ((p < end)  &&  isdigit (static_cast<uchar> (*p)))
+  {
+    result = result * 10 + (*p - '0');
+    if  (result > int32_max)
+      result = static_cast<kkint64> (int32_max) + 1;
+    ++p;
+  }
+
+  return  static_cast<kkint32> (negative ? -result : result);
+}  /* ParseInt32 */
+
+
+
+bool  TextLineReader::NextToken (const char*&  next,
+                                 const char*   end,
+                                 const char*   delStr,
+                                 const char*&  token,
+                                 const char*&  tokenEnd
+                                )
+{
+  while  ((next < end)  &&  (*next != 0)  &&  strchr (delStr, *next))
+    ++next;
+
+  if  (next >= end)
+  {
+    token = tokenEnd = end;
+    return false;
+  }
+
+  token = next;
+  while  ((next < end)  &&  ((*next == 0)  ||  (!strchr (delStr, *next))))
+    ++next;
+  tokenEnd = next;
+
+  if  (next < end)
+    ++next;   // Skip over the delimiter.
+
+  return true;
+}  /* NextToken */
+
+
+
+bool  TextLineReader::NextField (const char*&  next,
+                                 const char*   end,
+                                 const char*   delStr,
+                                 const char*&  field,
+                                 const char*&  fieldEnd
+                                )
+{
+  while  ((next < end)  &&  (*next == ' '))
+    ++next;
+
+  if  (next >= end)
+  {
+    field = fieldEnd = end;
+    return false;
+  }
+
+  field = next;
+  while  ((next < end)  &&  ((*next == 0)  ||  (!strchr (delStr, *next))))
+    ++next;
+  fieldEnd = next;
+
+  if  (next < end)
+    ++next;   // Skip over the delimiter.
+
+  return true;
+}  /* NextField */
@@ -0,0 +1,138 @@
+/* TextLineReader.h -- Reads a text stream a block at a time and splits it into lines without copying them.
+ * Copyright (C) 1994-2014 Kurt Kramer
+ * For conditions of distribution and use, see copyright notice in KKB.h
+ */
+#if  !defined(_KKB_TEXTLINEREADER_)
+#define  _KKB_TEXTLINEREADER_
+
+WarningsLowered()
+#include <istream>
+#include <vector>
+WarningsRestored()
+
+#include "KKBaseTypes.h"
+
+
+namespace KKB
+{
+  /**
+   *@class  TextLineReader
+   *@brief  Reads a stream in large blocks and hands out its lines as pointers into the block.
+   *@details  Meant for loading large text data files where reading one character at a time through
+   * 'std::istream' dominates the load time.  A line is terminated by a line-feed, a carriage-return or
+   * either combination of the two;  the terminator is not part of the line.  Lines returned stay valid
+   * until the next call to 'GetLine' or 'GetBlockOfLines'.
+   *
+   * 'GetBlockOfLines' returns every complete line in the next block so that they can be parsed in
+   * parallel, ex: with 'KKThreadPool::ParallelFor', before the next block is read.
+   *
+   * Also provides the parsing helpers the data file readers need so they do not have to copy each field
+   * into a 'KKStr' first.
+   */
+  class  TextLineReader
+  {
+  public:
+    typedef  TextLineReader*  TextLineReaderPtr;
+
+    struct  Line
+    {
+      const char*  str;
+      kkuint32     len;
+    };
+
+    typedef  std::vector<Line>  LineList;
+
+    static  const kkuint32  DefaultBlockSize = 8 * 1024 * 1024;
+
+    TextLineReader (std::istream&  _in,
+                    kkuint32       _blockSize = DefaultBlockSize
+                   );
+
+    ~TextLineReader ();
+
+    kkuint64  LinesRead ()  const  {return linesRead;}
+
+    /** @brief  Returns the next line in 'line';  returns false when there are no more lines. */
+    bool  GetLine (Line&  line);
+
+    /**
+     *@brief  Replaces the contents of 'lines' with the lines from the next block of the stream;
+     * returns the number of lines, zero when there are no more.
+     */
+    kkuint32  GetBlockOfLines (LineList&  lines);
+
+
+    /**
+     *@brief  Same result as 'atof' on the characters in [str, end) without needing them to be NUL terminated.
+     *@details  Values with up to 19 significant digits and a power of ten that can be applied exactly
+     * are computed directly, the rest are handed to 'atof'.
+     */
+    static  double  ParseDouble (const char*  str,
+                                 const char*  end
+                                );
+
+    /** @brief  Same result as 'atoi' on the characters in [str, end). */
+    static  kkint32  ParseInt32 (const char*  str,
+                                 const char*  end
+                                );
+
+    /**
+     *@brief  Finds the next token in [next, end) skipping leading delimiters, the same rules as 'KKStr::ExtractToken'.
+     *@param[in,out] next    Where to start;  on return the character after the delimiter that ended the token.
+     *@param[in]     end     One past last character of the line.
+     *@param[in]     delStr  Delimiter characters.
+     *@param[out]    token   First character of token.
+     *@param[out]    tokenEnd  One past last character of the token.
+     *@returns  false if there were no more tokens.
+     */
+    static  bool  NextToken (const char*&  next,
+                             const char*   end,
+                             const char*   delStr,
+                             const char*&  token,
+                             const char*&  tokenEnd
+                            );
+
+    /**
+     *@brief  Finds the next field in [next, end) the way a delimited file is read one character at a time.
+     *@details  Only leading blanks are skipped so two delimiters in a row, or a line that starts with one
+     * that is not a blank, give an empty field.  One delimiter after the field is consumed.
+     *@param[in,out] next    Where to start;  on return the character after the delimiter that ended the field.
+     *@param[in]     end     One past last character of the line.
+     *@param[in]     delStr  Delimiter characters.
+     *@param[out]    field   First character of field.
+     *@param[out]    fieldEnd  One past last character of the field.
+     *@returns  false if the end of the line was reached before a field started.
+     */
+    static  bool  NextField (const char*&  next,
+                             const char*   end,
+                             const char*   delStr,
+                             const char*&  field,
+                             const char*&  fieldEnd
+                            );
+
+  private:
+    TextLineReader (const TextLineReader&);
+    TextLineReader&  operator= (const TextLineReader&);
+
+    /** @brief  Moves the unread part of the buffer to the front and fills the rest from 'in';  returns false if nothing was added. */
+    bool  FillBuffer ();
+
+    /** @brief  Returns the next line if it is complete within the buffer. */
+    bool  NextLineInBuffer (Line&  line);
+
+    char*          buff;
+    kkuint32       buffLen;    /**< Number of characters in 'buff'. */
+    kkuint32       buffSize;
+    std::istream&  in;
+    bool           inEof;
+    kkuint64       linesRead;
+    kkuint32       nextPos;    /**< Next unread character in 'buff'. */
+  };  /* TextLineReader */
+
+  typedef  TextLineReader::TextLineReaderPtr  TextLineReaderPtr;
+
+#define  _TextLineReader_Defined_
+
+}  /* KKB */
+
+#endif
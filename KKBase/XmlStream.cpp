@@ -13,6 +13,7 @@
 #include "MemoryDebug.h"
 using namespace std;
 
+#include "BinaryContainer.h"
 #include "BitString.h"
 #include "GlobalGoalKeeper.h"
 #include "KKBaseTypes.h"
@@ -26,6 +27,7 @@ using namespace KKB;
 
 XmlStream::XmlStream (XmlTokenizerPtr _tokenStream):
     endOfElementTagNames (),
+    container            (NULL),
     endOfElemenReached   (false),
     fileName             (),
     nameOfLastEndTag     (),
@@ -38,6 +40,7 @@ XmlStream::XmlStream (XmlTokenizerPtr _tokenStream):
 
 XmlStream::XmlStream (const KKStr& _fileName,  RunLog& _log):
     endOfElementTagNames (),
+    container            (NULL),
     endOfElemenReached   (false),
     fileName             (_fileName),
     nameOfLastEndTag     (),
@@ -56,6 +59,17 @@ XmlStream::~XmlStream ()
 {
   delete tokenStream;
   tokenStream = NULL;
+  BinaryContainer::Release (container);
+}
+
+
+
+void  XmlStream::Container (BinaryContainerConstPtr  _container)
+{
+  if  (_container)
+    _container->Reference ();
+  BinaryContainer::Release (container);
+  container = _container;
 }
 
 
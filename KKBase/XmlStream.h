@@ -6,7 +6,9 @@
 #define  _XMLSTREAM_
 #include <map>
 #include <sstream>
+#include <string.h>
 
+#include "BinaryContainer.h"
 #include "DateTime.h"
 #include "KKStr.h"
 #include "KKStrParser.h"
@@ -69,6 +71,14 @@ namespace  KKB
 
     void  RegisterFactory (XmlFactoryPtr  factory);        /**< Registers factory with the highest level FactoryManager in 'factoryManagers'. */
 
+    /**
+     *@brief  Container that array elements with a 'Section' attribute are read from;  NULL when the stream
+     * is plain XML.  The stream keeps a reference to '_container' until it is destroyed or replaced.
+     */
+    void  Container (BinaryContainerConstPtr  _container);
+
+    BinaryContainerConstPtr  Container ()  const  {return container;}
+
 
   private:
     void  PushXmlElementLevel (const KKStr&  sectionName);
@@ -96,6 +106,7 @@ namespace  KKB
     std::vector<XmlFactoryManagerPtr>  factoryManagers;
 
 
+    BinaryContainerConstPtr  container;
     bool             endOfElemenReached;
     KKStr            fileName;
     KKStr            nameOfLastEndTag;
@@ -842,6 +853,21 @@ public:
     }
 
     kkuint32  fieldsExtracted = 0;
+
+    const KKStr&  sectionName = tag->AttributeValueKKStr ("Section");
+    if  (!sectionName.Empty ())
+    {
+      // Data was written to a binary container by 'WriteXML';  copy it instead of parsing text.
+      BinaryContainerConstPtr  container = s.Container ();
+      KKCheck(container, "XmlElementArray" << ZZZZTypeName << " variable: " << VarName () << "  Section: " << sectionName << " but no binary container attached to stream.")
+      const BinaryContainer::SectionEntry*  section = container->LookUp (sectionName);
+      KKCheck(section  &&  (section->elementSize == sizeof (T))  &&  (section->count == count)  &&  (KKStr (section->typeName) == ZZZZTypeName),
+              "XmlElementArray" << ZZZZTypeName << " variable: " << VarName () << "  Section: " << sectionName << " missing or does not match.")
+      if  (count > 0)
+        memcpy (value, container->SectionData (*section), count * sizeof (T));
+      fieldsExtracted = count;
+    }
+
     XmlTokenPtr  tok = s.GetNextToken (cancelFlag, log);
     while  (tok)
     {
@@ -933,13 +959,22 @@ void  KKB::XmlElementArray<T, ZZZZTypeName>::WriteXML (kkuint32       count,
   if  (!varName.Empty ())
     startTag.AddAtribute ("VarName", varName);
   startTag.AddAtribute ("Count", count);
-  startTag.WriteXML (o);
 
-  for  (kkuint32 x = 0;  x < count;  ++x)
+  BinaryContainerWriterPtr  binWriter = BinaryContainerWriter::AttachedTo (o);
+  if  (binWriter)
+  {
+    startTag.AddAtribute ("Section", binWriter->AddArray (ZZZZTypeName, sizeof (T), count, d));
+    startTag.WriteXML (o);
+  }
+  else
   {
-    if  (x > 0)
-      o << "\t";
-    o << d[x];
+    startTag.WriteXML (o);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      if  (x > 0)
+        o << "\t";
+      o << d[x];
+    }
   }
   XmlTag  endTag (ZZZZTypeName, XmlTag::TagTypes::tagEnd);
   endTag.WriteXML (o);
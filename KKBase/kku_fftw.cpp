@@ -12,118 +12,11 @@
 #include "MemoryDebug.h"
 using namespace std;
 
-#if  defined(FFTW_AVAILABLE)
-#endif
-
 #include "KKBaseTypes.h"
 #include "GoalKeeper.h"
 #include "kku_fftw.h"
 using namespace KKB;
 
-/*
-fftw_plan_class::fftw_plan_class (kkint32         _n,
-                                  fftw_direction  _dir,
-                                  kkint32         _flags
-                                 ):
-   n     (_n),
-   dir   (_dir),
-   flags (_flags)
-{
-}
-
-
-
-fftwnd_plan_class::fftwnd_plan_class (kkint32         _nx,
-                                      kkint32         _ny, 
-                                      fftw_direction  _dir,
-		                                  kkint32         _flags
-                                     ):
-   nx    (_nx),
-   ny    (_ny),
-   dir   (_dir),
-   flags (_flags)
-{
-}
-
-
-
-fftw_plan  KKB::fftw_create_plan (kkint32         n, 
-                                  fftw_direction  dir, 
-                                  kkint32         flags
-                                 )
-{
-  return  new fftw_plan_class (n, dir, flags);
-}
-
-
-
-void  KKB::fftw_destroy_plan (fftw_plan  plan)
-{
-  delete  plan;
-  plan = NULL;
-}
-
-
-
-fftwnd_plan  KKB::fftw2d_create_plan (kkint32         nx, 
-                                      kkint32         ny, 
-                                      fftw_direction  dir,
-				                              kkint32         flags
-                                     )
-{
-  return new fftwnd_plan_class (nx, ny, dir, flags);
-}  // fftw2d_create_plan
-
-
-
-void  KKB::fftwnd_destroy_plan (fftwnd_plan  plan)
-{
-  delete  plan;
-}
-
-
-
-void  KKB::fftw_one (fftw_plan      plan, 
-                     fftw_complex*  in, 
-                     fftw_complex*  out
-                    )
-{
-  cerr << endl << endl
-    << "fftw_one    ****ERROR***    This function is not implemented."  << endl
-    << endl;
-
-  for  (kkint32  x = 0;  x < plan->N ();  ++x)
-  {
-    out[x].im = 0.0;
-    out[x].re = 0.0;
-  }
-}  // fftw_one 
-
-
-
-
-void  KKB::fftwnd_one (fftwnd_plan    p, 
-                       fftw_complex*  in, 
-                       fftw_complex*  out
-                      )
-{
-  cerr << endl << endl
-    << "fftw_one    ****ERROR***    This function is not implemented."  << endl
-    << endl;
-
-  kkint32  totCells = p->NX () * p->NY ();
-
-  for  (kkint32  x = 0;  x < totCells;  ++x)
-  {
-    out[x].im = 0.0;
-    out[x].re = 0.0;
-  }
-}  // fftwnd_one 
-
-*/
-
-
-
 
 
 void  SWAP (float& a,  float& b)
@@ -311,3 +204,118 @@ fftwf_plan  KKB::fftwCreateOneDPlan (kkint32         len,
 
 
 
+#if  !defined(FFTW_AVAILABLE)
+
+namespace  KKB
+{
+  class  FftwPlanShim
+  {
+  public:
+    FftwPlanShim (kkint32         _height,
+                  kkint32         _width,
+                  fftwf_complex*  _src,
+                  fftwf_complex*  _dest,
+                  bool            _forwardTransform
+                 ):
+        dest   (_dest),
+        height (_height),
+        oneD   (NULL),
+        src    (_src),
+        twoD   (NULL),
+        width  (_width)
+    {
+      if  (height < 0)
+        oneD = new KK_DFT1D_Float (width, _forwardTransform);
+      else
+        twoD = new KK_DFT2D_Float (height, width, _forwardTransform);
+    }
+
+    ~FftwPlanShim ()
+    {
+      delete  oneD;  oneD = NULL;
+      delete  twoD;  twoD = NULL;
+    }
+
+    fftwf_complex*   dest;
+    kkint32          height;   /**< -1 indicates a one dimensional plan. */
+    KK_DFT1D_Float*  oneD;
+    fftwf_complex*   src;
+    KK_DFT2D_Float*  twoD;
+    kkint32          width;
+  };  /* FftwPlanShim */
+}
+
+
+
+fftwf_plan  KKB::fftwCreateTwoDPlan (kkint32         height,
+                                     kkint32         width,
+                                     fftwf_complex*  src,
+                                     fftwf_complex*  dest,
+                                     int             sign,
+                                     int             flag
+                                    )
+{
+  (void)flag;
+  return  new FftwPlanShim (height, width, src, dest, (sign == FFTW_FORWARD));
+}
+
+
+
+fftwf_plan  KKB::fftwCreateOneDPlan (kkint32         len,
+                                     fftwf_complex*  src,
+                                     fftwf_complex*  dest,
+                                     int             sign,
+                                     int             flag
+                                    )
+{
+  (void)flag;
+  return  new FftwPlanShim (-1, len, src, dest, (sign == FFTW_FORWARD));
+}
+
+
+
+void  KKB::fftwDestroyPlan (fftwf_plan&  plan)
+{
+  delete  plan;
+  plan = NULL;
+}
+
+
+
+void  KKB::fftwf_execute (const fftwf_plan  plan)
+{
+  // 'std::complex<float>' is guaranteed to have the same layout as 'float[2]'.
+  KK_DFT1D_Float::DftComplexType*  src  = reinterpret_cast<KK_DFT1D_Float::DftComplexType*> (plan->src);
+  KK_DFT1D_Float::DftComplexType*  dest = reinterpret_cast<KK_DFT1D_Float::DftComplexType*> (plan->dest);
+
+  if  (plan->oneD)
+  {
+    plan->oneD->Transform (src, dest);
+    return;
+  }
+
+  vector<KK_DFT2D_Float::DftComplexType*>  srcRows  (plan->height);
+  vector<KK_DFT2D_Float::DftComplexType*>  destRows (plan->height);
+  for  (kkint32 row = 0;  row < plan->height;  ++row)
+  {
+    srcRows[row]  = src  + row * plan->width;
+    destRows[row] = dest + row * plan->width;
+  }
+  plan->twoD->Transform (srcRows.data (), destRows.data ());
+}  /* fftwf_execute */
+
+
+
+void*  KKB::fftwf_malloc (size_t  n)
+{
+  return  malloc (n);
+}
+
+
+
+void  KKB::fftwf_free (void*  p)
+{
+  free (p);
+}
+
+#endif
@@ -15,104 +15,11 @@
 #endif
 
 #include "KKBaseTypes.h"
+#include "FftPlan.h"
 
 
 namespace  KKB
 {
-  /*********************************************
-   * Complex numbers and operations 
-   *********************************************/
-
-  /*
-  typedef struct 
-  {
-    double re;
-    double im;
-  } fftw_complex;
-  
-
-  // flags for the planner
-  #define  FFTW_ESTIMATE (0)
-  #define  FFTW_MEASURE  (1)
-
-  typedef enum {FFTW_FORWARD = -1, FFTW_BACKWARD = 1}  fftw_direction;
-
-  
-  class  fftw_plan_class
-  {
-  public:
-    fftw_plan_class (kkint32           _n,
-                     fftw_direction  _dir,
-                     kkint32           _flags
-                    );
-
-    fftw_direction  Dir   ()  const  {return dir;}
-    kkint32           Flags ()  const  {return flags;}
-    kkint32           N     ()  const  {return n;}
-
-
-  private:
-    kkint32             n;
-    fftw_direction    dir;
-    kkint32             flags;
-  };  // fftw_plan_class
-
-
-  class  fftwnd_plan_class
-  {
-  public:
-    fftwnd_plan_class (kkint32           nx,
-                       kkint32           ny, 
-                       fftw_direction  dir,
-                       kkint32           flags
-                      );
-
-    fftw_direction  Dir   ()  const  {return dir;}
-    kkint32           Flags ()  const  {return flags;}
-    kkint32           NX    ()  const  {return nx;}
-    kkint32           NY    ()  const  {return ny;}
-
-  private:
-    kkint32           nx;
-    kkint32           ny; 
-    fftw_direction  dir;
-		kkint32           flags;
-  }; // fftwnd_plan_class 
-
-
-  typedef  fftw_plan_class*    fftw_plan;
-  typedef  fftwnd_plan_class*  fftwnd_plan;
-
-
-  fftw_plan    fftw_create_plan (kkint32           n, 
-                                 fftw_direction  dir, 
-                                 kkint32           flags
-                                );
- 
-  fftwnd_plan  fftw2d_create_plan (kkint32           nx, 
-                                   kkint32           ny, 
-                                   fftw_direction  dir,
-				                   kkint32           flags
-                                  );
-
-  void  fftw_destroy_plan (fftw_plan  plan);
-
-  void  fftwnd_destroy_plan (fftwnd_plan  plan);
-
-
-  void  fftw_one (fftw_plan      plan, 
-                  fftw_complex*  in, 
-                  fftw_complex*  out
-                 );
-
-
-  void  fftwnd_one (fftwnd_plan    p, 
-                    fftw_complex*  in, 
-                    fftw_complex*  out
-                   );
- */
-
-
   void  FFT (float  data[], 
              kkuint32 number_of_complex_samples, 
              kkint32  isign
@@ -123,6 +30,11 @@ namespace  KKB
 
 
 
+  /**
+   *@brief  One dimensional Discrete Fourier Transform of a fixed length.
+   *@details  Performed in O(N log N) by the cached 'FftPlan' for 'size'.  The instance has its own work area so it
+   * should only be used by one thread at a time.
+   */
   template<typename DftType>
   class  KK_DFT1D
   {
@@ -136,6 +48,7 @@ namespace  KKB
     ~KK_DFT1D ();
 
 
+    /** @brief  Transforms 'src' into 'dest';  they may be the same array. */
     void  Transform (DftComplexType*  src,
                      DftComplexType*  dest
                     );
@@ -147,6 +60,7 @@ namespace  KKB
     void  TransformNR (DftComplexType*  src);
 
 
+    /** @brief  The 'size' x 'size' matrix of the transform;  only built when asked for. */
     DftComplexType**  FourierMask () 
     {
       if  (!fourierMask)
@@ -163,16 +77,28 @@ namespace  KKB
     DftComplexType  Two;
     DftComplexType  Zero;
 
-    bool              forwardTransform;
-    DftComplexType**  fourierMask;
-    DftComplexType*   fourierMaskArea;
-    kkint32             size;
+    bool                                          forwardTransform;
+    DftComplexType**                              fourierMask;
+    DftComplexType*                               fourierMaskArea;
+    typename FftPlan<DftType>::FftPlanConstPtr    plan;
+    kkint32                                       size;
+    std::vector<DftComplexType>                   work;
   };  /* KK_DFT1D */
 
   typedef  KK_DFT1D<float>   KK_DFT1D_Float;
   typedef  KK_DFT1D<double>  KK_DFT1D_Double;
 
 
+
+  /**
+   *@brief  Two dimensional Discrete Fourier Transform of a fixed size.
+   *@details  Transforms the rows and then the columns with the cached 'FftPlan's for 'width' and 'height';  the rows
+   * and columns are spread across threads by 'FftParallelFor'.  When the source is an image, a pair of rows is
+   * transformed with one complex transform and only half of the columns are transformed, the other half follows from
+   * the conjugate symmetry of the transform of real data.
+   *
+   * The instance holds no work areas so 'Transform' may be called by several threads at the same time.
+   */
   template<typename DftType>
   class  KK_DFT2D
   {
@@ -186,6 +112,7 @@ namespace  KKB
 
     ~KK_DFT2D ();
 
+    /** @brief  Transforms 'src' into 'dest';  they may be the same array. */
     void  Transform (DftComplexType**  src,
                      DftComplexType**  dest
                     );
@@ -207,17 +134,19 @@ namespace  KKB
                        )  const;
 
   private:
+    /** @brief  Transforms columns 0 thru 'numCols' - 1 of 'data' in place. */
+    void  TransformColumns (DftComplexType**  data,
+                            kkint32           numCols
+                           );
+
     kkint32  height;
     kkint32  width;
     bool forwardTransform;
 
     DftComplexType    Zero;
-    DftComplexType**  workArray;
-    DftComplexType*   workArrayArea;
-    DftComplexType*   workCol;
 
-    KK_DFT1D<DftType>*  rowDFT;
-    KK_DFT1D<DftType>*  colDFT;
+    typename FftPlan<DftType>::FftPlanConstPtr  colPlan;
+    typename FftPlan<DftType>::FftPlanConstPtr  rowPlan;
   };  /* KK_DFT2D */
 
   typedef  KK_DFT2D<float>   KK_DFT2D_Float;
@@ -237,17 +166,20 @@ namespace  KKB
       forwardTransform (_forwardTransform),
       fourierMask      (NULL),
       fourierMaskArea  (NULL),
-      size             (_size)
+      plan             (NULL),
+      size             (Max (_size, (kkint32)0)),
+      work             ()
   {
-    //BuildMask ();
+    plan = FftPlan<DftType>::GetPlan ((kkuint32)size, forwardTransform);
+    work.resize (plan->WorkSize () + size);
   }
 
 
   template<typename DftType>
   KK_DFT1D<DftType>::~KK_DFT1D ()
   {
-    delete  fourierMask;      fourierMask     = NULL;
-    delete  fourierMaskArea;  fourierMaskArea = NULL;
+    delete[]  fourierMask;      fourierMask     = NULL;
+    delete[]  fourierMaskArea;  fourierMaskArea = NULL;
   }
 
 
@@ -298,81 +230,7 @@ namespace  KKB
                                       DftComplexType*  dest
                                      )
   {
-    DftComplexType  M((DftType)size, 0);
-
-    DftComplexType direction;
-    if  (forwardTransform)
-      direction = DftComplexType ((DftType)-1.0, (DftType)0.0);
-    else
-      direction = DftComplexType ((DftType)1.0, (DftType)0.0);
- 
-    DftComplexType  j;
-    j = sqrt (MinusOne);
-
-
-    for  (kkint32  l = 0;  l < size;  l++)
-    {
-      dest[l] = Zero;
-
-      DftComplexType  lc ((DftType)l, (DftType)0);
-      for  (kkint32 k = 0;  k < size;  k++)
-      {
-        //DftType  exponetPart = (DftType)2.0 * (DftType)3.14159265359 * (DftType)k * (DftType)l / (DftType)size;
-        //DftType  realPart = cos (exponetPart);
-        //DftType  imgPart  = -sin (exponetPart);
-
-        DftComplexType  kc ((DftType)k, (DftType)0);
-        DftComplexType  fm = exp (direction * j * Two * Pi * kc * lc / M);
-
-        //dest[l] = dest[l] + src[k] * fourierMask[l][k];
-        dest[l] = dest[l] + src[k] * fm;
-      }
-    }
-  
-    /*
-    {
-      // Performs a comparison with a alternatve result that performs much faster but is only good for 
-      //  where size is = (n^2) for (n > 0)
-      kkint32  newSize = (kkint32)pow (2.0f, (float)ceil (Log2 ((float)size)));
-
-      // Lets do a comparison
-      int x, y;
-      float* wa = new float[newSize * 2];
-      for  (x = 0;  x < (newSize * 2);  ++x)
-        wa[x] = 0.0;
-
-      for  (x = 0, y = 0;  x < size;  ++x, y += 2)
-      {
-        wa[y]     = src[x].real ();
-        wa[y + 1] = src[x].imag ();
-      }
-      FFT (wa, size, 1); 
-
-      for  (x = 0, y = 0;  x < size;  ++x, y += 2)
-      {
-        float  deltaR = (wa[y]     - dest[x].real ());
-        float  deltaI = (wa[y + 1] - dest[x].imag ());
-
-        //if  (deltaR != 0.0)
-        //  cout << x << "\t" << wa[y]     << "\t" << dest[x].real () << "\t" << deltaR << endl;
-
-        //if  (deltaI != 0.0)
-        //  cout << x << "\t" << wa[y + 1] << "\t" << dest[x].imag () << "\t" << deltaI << endl;
-
-        float waSquare   = wa[y]           * wa[y]            + wa[y + 1]       * wa[y + 1];
-        float destSquare = dest[x].real () * dest[x].real ()  + dest[x].imag () * dest[x].imag ();
-
-        float  waMag   = sqrt (waSquare);
-        float  destMag = sqrt (destSquare);
-
-        cout  << x << "\t" << waMag << "\t" << destMag << endl;
-      }
-      delete  wa;
-      wa = NULL;
-    }
-    */
-
-    return;
+    plan->Transform (src, dest, work.data ());
   }  /* Transform */
 
 
@@ -382,42 +240,7 @@ namespace  KKB
                                       DftComplexType*  dest
                                      )
   {
-    if  (!fourierMask)
-      BuildMask ();
-    
-    kkint32  firstK = 0;
-    bool   firstKFound = false;
-    kkint32  lastK  = 0;
-
-    for  (kkint32 k = 0;  k < size;  ++k)
-    {
-      if  (src[k] != 0)
-      {
-        lastK = k;
-        if  (!firstKFound)
-        {
-          firstKFound = true;
-          firstK = k;
-        }
-      }
-    }
-
-    for  (kkint32  l = 0;  l < size;  l++)
-    {
-      DftComplexType*  fourierMaskL = fourierMask[l];
-
-      DftType  destReal = 0.0;
-      DftType  destImag = 0.0;
-
-      for  (kkint32 k = firstK;  k <= lastK;  k++)
-      {
-        destReal +=  src[k] * fourierMaskL[k].real ();
-        destImag +=  src[k] * fourierMaskL[k].imag ();
-      }
-
-      dest[l] = complex<DftType> (destReal, destImag);
-    }
-    return;
+    plan->TransformReal (src, (const KKB::uchar*)NULL, dest, (DftComplexType*)NULL, work.data ());
   }  /* Transform */
 
 
@@ -482,34 +305,20 @@ namespace  KKB
   }  /* TransformNR */
 
 
-
   template<typename DftType>
   KK_DFT2D<DftType>::KK_DFT2D (kkint32 _height,
                                kkint32 _width,
                                bool  _forwardTransform
                               ):
-    height           (_height),
-    width            (_width),
+    height           (Max (_height, (kkint32)0)),
+    width            (Max (_width,  (kkint32)0)),
     forwardTransform (_forwardTransform),
     Zero             ((DftType)0.0, (DftType)0.0),
-    workArray        (NULL),
-    workArrayArea    (NULL),
-    workCol          (NULL),
-    rowDFT           (NULL),
-    colDFT           (NULL)
+    colPlan          (NULL),
+    rowPlan          (NULL)
   {
-    rowDFT = new KK_DFT1D<DftType> (_width,  _forwardTransform);
-    colDFT = new KK_DFT1D<DftType> (_height, _forwardTransform);
-
-    workArrayArea = new DftComplexType[height * width];
-    workArray     = new DftComplexType*[height];
-    DftComplexType*  workArrayAreaPtr = workArrayArea;
-    for  (kkint32 row = 0;  row < height;  ++row)
-    {
-      workArray[row] = workArrayAreaPtr;
-      workArrayAreaPtr += width;
-    }
-    workCol = new DftComplexType[height];
+    colPlan = FftPlan<DftType>::GetPlan ((kkuint32)height, forwardTransform);
+    rowPlan = FftPlan<DftType>::GetPlan ((kkuint32)width,  forwardTransform);
   }
 
 
@@ -517,11 +326,7 @@ namespace  KKB
   template<typename DftType>
   KK_DFT2D<DftType>::~KK_DFT2D ()
   {
-    delete  rowDFT;         rowDFT        = NULL;
-    delete  colDFT;         colDFT        = NULL;
-    delete  workArray;      workArray     = NULL;
-    delete  workArrayArea;  workArrayArea = NULL;
-    delete  workCol;        workCol       = NULL;
+    // 'colPlan' and 'rowPlan' belong to the 'FftPlan' cache.
   }
 
 
@@ -531,25 +336,20 @@ namespace  KKB
                                       DftComplexType**  dest
                                      )
   {
-    for  (kkint32 row = 0;  row < height;  ++row)
-      rowDFT->Transform (src[row], workArray[row]);
-
-    DftComplexType**  colFourierMask = colDFT->FourierMask ();
+    if  ((height < 1)  ||  (width < 1))
+      return;
 
-    for  (kkint32 col = 0;  col < width;  ++col)
-    {
-      for  (kkint32  row = 0;  row < height;  row++)
+    typename FftPlan<DftType>::FftPlanConstPtr  plan = rowPlan;
+    FftParallelFor ((kkuint32)height, (kkuint32)width,
+      [plan, src, dest] (kkuint32 first, kkuint32 last)
       {
-        DftComplexType  v = Zero;
-        for  (kkint32 k = 0;  k < height;  k++)
-        {
-          v = v  + workArray[k][col] * colFourierMask[row][k];
-        }
-
-        dest[row][col] = v;
+        std::vector<DftComplexType>  work (plan->WorkSize ());
+        for  (kkuint32 row = first;  row < last;  ++row)
+          plan->Transform (src[row], dest[row], work.data ());
       }
-    }
+    );
 
+    TransformColumns (dest, width);
   }  /* Transform*/
 
 
@@ -558,46 +358,83 @@ namespace  KKB
                                       DftComplexType**  dest
                                      )
   {
-    for  (kkint32 row = 0;  row < height;  ++row)
-      rowDFT->Transform (src[row], workArray[row]);
+    if  ((height < 1)  ||  (width < 1))
+      return;
+
+    kkint32  h = height;
+    typename FftPlan<DftType>::FftPlanConstPtr  plan = rowPlan;
+    FftParallelFor ((kkuint32)((height + 1) / 2), 2 * (kkuint32)width,
+      [plan, src, dest, h] (kkuint32 first, kkuint32 last)
+      {
+        std::vector<DftComplexType>  work (plan->WorkSize () + plan->Size ());
+        for  (kkuint32 pair = first;  pair < last;  ++pair)
+        {
+          kkint32  row = 2 * (kkint32)pair;
+          if  ((row + 1) < h)
+            plan->TransformReal (src[row], src[row + 1], dest[row], dest[row + 1], work.data ());
+          else
+            plan->TransformReal (src[row], (const KKB::uchar*)NULL, dest[row], (DftComplexType*)NULL, work.data ());
+        }
+      }
+    );
 
-    DftComplexType**  colFourierMask = colDFT->FourierMask ();
+    // The transform of real data is conjugate symmetric, F[row][col] = conj (F[-row][-col]), so
+    // only the first half of the columns has to be transformed.
+    kkint32  numCols = width / 2 + 1;
+    TransformColumns (dest, numCols);
 
-    for  (kkint32 col = 0;  col < width;  ++col)
+    for  (kkint32 row = 0;  row < height;  ++row)
     {
-      kkuint32  firstRow = 0;
-      bool    firstRowFound = false;
-      kkuint32  lastRow = 0;
+      DftComplexType*  mirrorRow = dest[(height - row) % height];
+      DftComplexType*  destRow   = dest[row];
+      for  (kkint32 col = numCols;  col < width;  ++col)
+        destRow[col] = std::conj (mirrorRow[width - col]);
+    }
+  }  /* Transform */
+
 
-      for  (kkint32 l = 0;  l < height;  ++l)
+
+  template<typename DftType>
+  void  KK_DFT2D<DftType>::TransformColumns (DftComplexType**  data,
+                                             kkint32           numCols
+                                            )
+  {
+    // Columns are copied out a block at a time so that each row is read and written sequentially.
+    const kkint32  blockWidth = 16;
+    kkint32  h = height;
+    kkint32  numBlocks = (numCols + blockWidth - 1) / blockWidth;
+    typename FftPlan<DftType>::FftPlanConstPtr  plan = colPlan;
+
+    FftParallelFor ((kkuint32)numBlocks, (kkuint32)(blockWidth * height),
+      [plan, data, h, numCols, blockWidth] (kkuint32 first, kkuint32 last)
       {
-        workCol[l] = workArray[l][col];
-        bool  nonZero = (workCol[l].imag () != 0.0f)  ||  (workCol[l].real () != 0.0f);
-        if  (nonZero)
+        std::vector<DftComplexType>  cols (blockWidth * h);
+        std::vector<DftComplexType>  work (plan->WorkSize ());
+        for  (kkuint32 block = first;  block < last;  ++block)
         {
-          lastRow = l;
-          if  (!firstRowFound)
+          kkint32  firstCol = (kkint32)block * blockWidth;
+          kkint32  n = Min (blockWidth, numCols - firstCol);
+
+          for  (kkint32 row = 0;  row < h;  ++row)
           {
-            firstRowFound = true;
-            firstRow = l;
+            const DftComplexType*  rowPtr = data[row] + firstCol;
+            for  (kkint32 c = 0;  c < n;  ++c)
+              cols[c * h + row] = rowPtr[c];
           }
-        }
-      }
 
-      for  (kkint32  row = 0;  row < height;  row++)
-      {
-        DftComplexType*  colFourierMaskRow = colFourierMask[row];
+          for  (kkint32 c = 0;  c < n;  ++c)
+            plan->Transform (&cols[c * h], &cols[c * h], work.data ());
 
-        DftComplexType  v = Zero;
-        for  (kkuint32 k = firstRow;  k <= lastRow;  k++)
-        {
-          v = v  + workCol[k] * colFourierMaskRow[k];
+          for  (kkint32 row = 0;  row < h;  ++row)
+          {
+            DftComplexType*  rowPtr = data[row] + firstCol;
+            for  (kkint32 c = 0;  c < n;  ++c)
+              rowPtr[c] = cols[c * h + row];
+          }
         }
-
-        dest[row][col] = v;
       }
-    }
-  }  /* Transform */
+    );
+  }  /* TransformColumns */
 
 
 
@@ -641,8 +478,8 @@ namespace  KKB
                                          DftComplexType**  &array
                                         )  const
   {
-    delete  arrayArea;  arrayArea = NULL;
-    delete  array;      array     = NULL;
+    delete[]  arrayArea;  arrayArea = NULL;
+    delete[]  array;      array     = NULL;
     return;
   }  /* DestroyArray */
 
@@ -651,11 +488,29 @@ namespace  KKB
 
 
 #if  !defined(FFTW_AVAILABLE)
+  /**
+   * Stand ins for the parts of the FFTW3 single precision interface this library uses so that code written
+   * against FFTW builds without it;  the transforms are performed by 'KK_DFT1D_Float' and 'KK_DFT2D_Float'.
+   */
+  typedef  float  fftwf_complex[2];
+
+  class  FftwPlanShim;
+  typedef  FftwPlanShim*  fftwf_plan;
+
+  #define  FFTW_FORWARD   (-1)
+  #define  FFTW_BACKWARD  (+1)
+  #define  FFTW_MEASURE   (0U)
+  #define  FFTW_ESTIMATE  (1U << 6)
+
+  void*  fftwf_malloc (size_t  n);
+
+  void   fftwf_free (void*  p);
+
+  void   fftwf_execute (const fftwf_plan  plan);
 #endif
 
 
 
-#if  defined(FFTW_AVAILABLE)
   fftwf_plan  fftwCreateTwoDPlan (kkint32         height,
                                   kkint32         width,
                                   fftwf_complex*  src,
@@ -672,7 +527,6 @@ namespace  KKB
                                  );
 
   void  fftwDestroyPlan (fftwf_plan&  plan);
-#endif
 
 }  /* KKB */
 
@@ -12,6 +12,8 @@ using namespace std;
 
 
 #include "KKBaseTypes.h"
+#include "KKException.h"
+#include "MemoryMappedFile.h"
 #include "OSservices.h"
 #include "RunLog.h"
 #include "KKStr.h"
@@ -26,6 +28,7 @@ using namespace KKB;
 #include "ScannerFile4BitEncoded.h"
 #include "ScannerFileZLib3BitEncoded.h"
 #include "ScannerFileEntry.h"
+#include "ScannerFileReadAhead.h"
 #include "StartStopPoint.h"
 #include "Variables.h"
 using namespace  KKLSC;
@@ -71,6 +74,11 @@ ScannerFile::ScannerFile (const KKStr&  _fileName,
   goalie                    (NULL),
   indexFile                 (NULL),
   indexFileName             (),
+  instrumentDataCapture     (NULL),
+  mappedEof                 (false),
+  mappedFile                (NULL),
+  mappedPos                 (0),
+  readAhead                 (NULL),
   scannerFileEntry          (NULL),
   startStopPoints           ()
 {
@@ -83,7 +91,7 @@ ScannerFile::ScannerFile (const KKStr&  _fileName,
   if  (opened)
   {
     ReadHeader ();
-    byteOffsetScanLineZero = osFTELL (file);
+    byteOffsetScanLineZero = FTell ();
     if  (frameHeight == 0)
       frameHeight = pixelsPerScanLine;
     AllocateFrameBuffer ();
@@ -138,6 +146,11 @@ ScannerFile::ScannerFile (const KKStr&  _fileName,
   goalie                    (NULL),
   indexFile                 (NULL),
   indexFileName             (),
+  instrumentDataCapture     (NULL),
+  mappedEof                 (false),
+  mappedFile                (NULL),
+  mappedPos                 (0),
+  readAhead                 (NULL),
   scannerFileEntry          (NULL),
   startStopPoints           ()
 {
@@ -158,11 +171,21 @@ ScannerFile::ScannerFile (const KKStr&  _fileName,
 
 ScannerFile::~ScannerFile ()
 {
+  ReadAheadStop ();
+
   if  (opened)
     Close ();
 
+  if  (file)
+  {
+    // Files opened for reading are not closed by 'Close'.
+    fclose (file);
+    file = NULL;
+  }
+
   delete  headerFields;  headerFields = NULL;
-  delete  frameBuffer;   frameBuffer  = NULL;
+  delete[]  frameBuffer;   frameBuffer  = NULL;
+  delete  mappedFile;    mappedFile   = NULL;
   
   GoalKeeper::Destroy (goalie);
   goalie = NULL;
@@ -182,6 +205,8 @@ kkMemSize  ScannerFile::MemoryConsumedEstimated ()  const
   if  (headerFields)      mem += headerFields->MemoryConsumedEstimated ();
   if  (frameBuffer)       mem += frameBufferSize;
   if  (indexFile)         mem += 2000;
+  if  (mappedFile)        mem += mappedFile->MemoryConsumedEstimated ();
+  if  (readAhead)         mem += readAhead->MemoryConsumedEstimated ();
   if  (scannerFileEntry)  mem += scannerFileEntry->MemoryConsumedEstimated ();
   return  mem;
 }
@@ -190,7 +215,7 @@ kkMemSize  ScannerFile::MemoryConsumedEstimated ()  const
 
 void  ScannerFile::AllocateFrameBuffer ()
 {
-  delete  frameBuffer;   frameBuffer = NULL;
+  delete[]  frameBuffer;   frameBuffer = NULL;
   frameBufferSize = frameHeight * pixelsPerScanLine;
   frameBufferLen  = 0;
   frameBuffer = new uchar[frameBufferSize];
@@ -247,12 +272,14 @@ void  ScannerFile::Reset ()
   eof = false;  
   rewind (file);
   ReadHeader ();
+  if  (mappedFile)
+    FSeek (osFTELL (file));
 
   frameBufferLastReadEof = false;
   lastScanLine = 0;
   nextScanLine = 0;
   frameBufferFileOffsetLast = -1;
-  frameBufferFileOffsetNext = osFTELL (file);
+  frameBufferFileOffsetNext = FTell ();
 }  /* Reset */
 
 
@@ -506,21 +533,23 @@ void  ScannerFile::FrameRead (kkuint32  frameNum,
   goalie->StartBlock ();
   FSeek (frameOffsets[frameNum]);
 
-  frameBufferNumScanLines = ReadBufferFrame ();
+  if  (mappedFile)
+  {
+    // Have the operating system read the whole frame at once rather than a page fault at a time.
+    kkint64  frameLen = frameBufferSize;
+    if  (((frameNum + 1) < frameOffsets.size ())  &&  (frameOffsets[frameNum + 1] > frameOffsets[frameNum]))
+      frameLen = frameOffsets[frameNum + 1] - frameOffsets[frameNum];
+    mappedFile->WillNeed (frameOffsets[frameNum], frameLen);
+  }
 
-  frameBufferNextLine = 0;
-  frameBufferLastReadEof = (feof (file) != 0);
-  frameNumCurLoaded = frameNum;
+  LoadFrameBuffer (frameNum);
 
   if  (frameBufferNumScanLines > 1)
   {
     found = true;
+    eof = false;
     nextScanLine = frameNum * frameHeight;
     lastScanLine = nextScanLine - 1;
-    kkint32  lastScanLineInFrame = nextScanLine + frameBufferNumScanLines - 1;
-    if  (lastScanLineInFrame > largestKnownScanLine)
-      largestKnownScanLine = lastScanLineInFrame;
-    UpdateFrameOffset (frameNum + 1, (nextScanLine + frameHeight), frameBufferFileOffsetNext);
   }
   else
   {
@@ -533,6 +562,75 @@ void  ScannerFile::FrameRead (kkuint32  frameNum,
 
 
 
+void  ScannerFile::LoadFrameBuffer (kkuint32  frameNum)
+{
+  if  (readAhead  &&  readAhead->LoadFrame (frameNum, FTell ()))
+  {
+    FSeek (frameBufferFileOffsetNext);
+  }
+  else
+  {
+    frameBufferNumScanLines = ReadBufferFrame ();
+    frameBufferLastReadEof = FEof ();
+  }
+
+  frameBufferNextLine = 0;
+  frameNumCurLoaded = frameNum;
+
+  if  (frameBufferNumScanLines > 0)
+  {
+    kkint32  firstScanLineInFrame = frameNum * frameHeight;
+    kkint32  lastScanLineInFrame = firstScanLineInFrame + frameBufferNumScanLines - 1;
+    if  (lastScanLineInFrame > largestKnownScanLine)
+      largestKnownScanLine = lastScanLineInFrame;
+    UpdateFrameOffset (frameNum, firstScanLineInFrame, frameBufferFileOffsetLast);
+    if  (!frameBufferLastReadEof)
+      UpdateFrameOffset (frameNum + 1, (firstScanLineInFrame + frameHeight), frameBufferFileOffsetNext);
+  }
+
+  if  (readAhead)
+    readAhead->ScheduleFrom (frameNum + 1);
+}  /* LoadFrameBuffer */
+
+
+
+const uchar*  ScannerFile::GetNextFrame (kkuint32&  numScanLines)
+{
+  numScanLines = 0;
+  if  (eof)
+    return NULL;
+
+  if  (frameBufferNextLine >= frameBufferNumScanLines)
+  {
+    if  (frameBufferLastReadEof)
+    {
+      eof = true;
+      return NULL;
+    }
+
+    goalie->StartBlock ();
+    LoadFrameBuffer (nextScanLine / frameHeight);
+    goalie->EndBlock ();
+
+    if  (frameBufferNumScanLines == 0)
+    {
+      if  (frameBufferLastReadEof)
+        eof = true;
+      else
+        cerr << endl << "ScannerFile::GetNextFrame   ***ERROR***   No scan lines loaded." << endl << endl;
+      return NULL;
+    }
+  }
+
+  numScanLines = frameBufferNumScanLines - frameBufferNextLine;
+  const uchar*  scanLines = frameBuffer + frameBufferNextLine * pixelsPerScanLine;
+
+  lastScanLine = nextScanLine + numScanLines - 1;
+  nextScanLine += numScanLines;
+  frameBufferNextLine = frameBufferNumScanLines;
+  return  scanLines;
+}  /* GetNextFrame */
+
 
 
 void  ScannerFile::GetNextLine (uchar*     lineBuff,
@@ -556,26 +654,17 @@ void  ScannerFile::GetNextLine (uchar*     lineBuff,
     }     
     
     goalie->StartBlock ();
-    frameBufferNumScanLines = ReadBufferFrame ();
-    frameBufferNextLine = 0;
-    frameBufferLastReadEof = (feof (file) != 0);
+    LoadFrameBuffer (nextScanLine / frameHeight);
 
     if  ((frameBufferNumScanLines == 0) &&  frameBufferLastReadEof)
     {
       // We already are at EOF.
+      goalie->EndBlock ();
       eof = true;
       return;
     }
 
-    if  (frameBufferNumScanLines > 0)
-    {
-      frameNumCurLoaded = nextScanLine / frameHeight;
-      kkint32  lastScanLineInFrame = nextScanLine + frameBufferNumScanLines - 1;
-      if  (lastScanLineInFrame > largestKnownScanLine)
-        largestKnownScanLine = lastScanLineInFrame;
-      UpdateFrameOffset (frameNumCurLoaded, nextScanLine, frameBufferFileOffsetNext);
-    }
-    else
+    if  (frameBufferNumScanLines == 0)
     {
       // There were no scan lines loaded.
       cerr << endl << "ScannerFile::GetNextLine   ***ERROR***   No scan lines loaded." << endl << endl;
@@ -624,19 +713,9 @@ void  ScannerFile::SkipNextLine ()
     }     
     
     goalie->StartBlock ();
-    frameBufferNumScanLines = ReadBufferFrame ();
-    frameBufferNextLine = 0;
-    frameBufferLastReadEof = (feof (file) != 0);
+    LoadFrameBuffer (nextScanLine / frameHeight);
 
-    if  (frameBufferNumScanLines > 0)
-    {
-      frameNumCurLoaded = nextScanLine / frameHeight;
-      kkint32  lastScanLineInFrame = nextScanLine + frameBufferNumScanLines - 1;
-      if  (lastScanLineInFrame > largestKnownScanLine)
-        largestKnownScanLine = lastScanLineInFrame;
-      UpdateFrameOffset (frameNumCurLoaded, nextScanLine, frameBufferFileOffsetNext);
-    }
-    else
+    if  (frameBufferNumScanLines == 0)
     {
       cerr << endl << "ScannerFile::SkipNextLine   ***ERROR***     No scan lines were loaded." << endl << endl;
     }
@@ -650,6 +729,111 @@ void  ScannerFile::SkipNextLine ()
 
 
 
+bool  ScannerFile::ReadAheadStart (kkuint32  numThreads,
+                                   kkuint32  numFramesAhead
+                                  )
+{
+  ReadAheadStop ();
+
+  if  ((!opened)  ||  (ioMode != ioRead))
+    return false;
+
+  ScannerFileReadAheadPtr  newReadAhead = new ScannerFileReadAhead (this, numThreads, numFramesAhead, log);
+  if  (newReadAhead->NumDecoders () < 1)
+  {
+    delete  newReadAhead;
+    newReadAhead = NULL;
+    return false;
+  }
+
+  goalie->StartBlock ();
+  readAhead = newReadAhead;
+  if  (frameBufferNextLine < frameBufferNumScanLines)
+    readAhead->ScheduleFrom (frameNumCurLoaded + 1);
+  else
+    readAhead->ScheduleFrom (nextScanLine / frameHeight);
+  goalie->EndBlock ();
+
+  return true;
+}  /* ReadAheadStart */
+
+
+
+bool  ScannerFile::MemoryMap (MemoryMappedFile::AccessPattern  accessPattern)
+{
+  if  (mappedFile)
+  {
+    mappedFile->Advise (accessPattern);
+    return true;
+  }
+
+  if  ((!opened)  ||  (ioMode != ioRead))
+    return false;
+
+  MemoryMappedFilePtr  newMapping = NULL;
+  try
+  {
+    newMapping = new MemoryMappedFile (fileName);
+  }
+  catch  (const KKException&  e)
+  {
+    log.Level (-1) << endl << "ScannerFile::MemoryMap   ***ERROR***   " << e.ToString () << endl << endl;
+    return false;
+  }
+
+  if  (newMapping->Size () < 1)
+  {
+    delete  newMapping;
+    newMapping = NULL;
+    return false;
+  }
+
+  newMapping->Advise (accessPattern);
+
+  goalie->StartBlock ();
+  // From here on the decoders read straight out of the mapped pages;  'file' is only used to re-read the header.
+  mappedPos = osFTELL (file);
+  mappedEof = (feof (file) != 0);
+  mappedFile = newMapping;
+  goalie->EndBlock ();
+
+  return true;
+}  /* MemoryMap */
+
+
+
+const uchar*  ScannerFile::MappedBytes (kkint64   offset,
+                                        kkuint32  len
+                                       )  const
+{
+  if  ((!mappedFile)  ||  (offset < 0))
+    return NULL;
+
+  if  (((kkuint64)offset + len) > mappedFile->Size ())
+    return NULL;
+
+  return  mappedFile->Data () + offset;
+}  /* MappedBytes */
+
+
+
+void  ScannerFile::ReadAheadStop ()
+{
+  if  (!readAhead)
+    return;
+
+  goalie->StartBlock ();
+  ScannerFileReadAheadPtr  oldReadAhead = readAhead;
+  readAhead = NULL;
+  goalie->EndBlock ();
+
+  delete  oldReadAhead;
+  oldReadAhead = NULL;
+}  /* ReadAheadStop */
+
+
+
+
 void   ScannerFile::WriteScanLine (const uchar*  buffer,
                                    kkuint32      bufferLen
                                   )
@@ -681,7 +865,8 @@ void  ScannerFile::SkipToScanLine (kkuint32  scanLine)
   if  (frameNum >= frameOffsets.size ())
     frameNum = (kkuint32)frameOffsets.size () - 1;
 
-  if  (frameNum != frameNumCurLoaded)
+  // 'frameNumCurLoaded' starts out as 0;  until a frame has been loaded there is nothing in the buffer to reuse.
+  if  ((frameNum != frameNumCurLoaded)  ||  (frameBufferNumScanLines == 0))
   {
     bool found = false;
     FrameRead (frameNum, found);
@@ -698,6 +883,11 @@ void  ScannerFile::SkipToScanLine (kkuint32  scanLine)
     // I believe that the only way that this could happen is if 'frameNum' is the last frame in the file.
     cerr << endl << endl << "ScannerFile::SkipToScanLine   ***ERROR***   FrameBufer is short scan lines." << endl << endl;
   }
+  else
+  {
+    // Having played through to the end of the file and then skipping back into the last frame, which is still loaded.
+    eof = false;
+  }
 
   lastScanLine = scanLine - 1;
   nextScanLine = scanLine;
@@ -1162,6 +1352,12 @@ void  ScannerFile::ReportInstrumentDataWord (uchar             idNum,
    *@todo  Need to add code to do something the data word just posted.
    */
 
+  if  (instrumentDataCapture)
+  {
+    instrumentDataCapture->push_back (InstrumentDataReport (idNum, scanLineNum, dataWord));
+    return;
+  }
+
   if  (idNum == 0)
   {
     // This is the FlowMeterCounter field,
@@ -1201,7 +1397,7 @@ void  ScannerFile::BuildFrameOffsets (const volatile bool&  cancelFlag)
   CreateGoalie ();
   goalie->StartBlock ();
 
-  kkint64  origFilePos = osFTELL (file);
+  kkint64  origFilePos = FTell ();
 
   frameOffsetsBuildRunning = true;
 
@@ -1228,7 +1424,7 @@ void  ScannerFile::BuildFrameOffsets (const volatile bool&  cancelFlag)
           goalie->EndBlock ();
           osSleepMiliSecs (10);
           goalie->StartBlock ();
-          origFilePos = osFTELL (file);
+          origFilePos = FTell ();
         }
          changesMadeToIndexFile = true;
         DetermineFrameOffsetForFrame (frameNum);
@@ -1251,7 +1447,7 @@ void  ScannerFile::BuildFrameOffsets (const volatile bool&  cancelFlag)
           ++loopCount;
         }
         goalie->StartBlock ();
-        origFilePos = osFTELL (file);
+        origFilePos = FTell ();
       }
 
       kkuint32  lastFrameNum = (kkint32)frameOffsets.size () - 1;
@@ -1343,12 +1539,13 @@ void  ScannerFile::LoadIndexFile (bool&  successful)
   }
 
   KKStrPtr  ln = NULL;
+  bool  eofIndexFile = false;
 
   while  (true)
   {
     delete ln;
-    ln = KKB::osReadRestOfLine (f, eof);
-    if  (eof)  break;
+    ln = KKB::osReadRestOfLine (f, eofIndexFile);
+    if  (eofIndexFile)  break;
     if  (!ln)  continue;
 
     KKStr lineName = ln->ExtractToken2 ("\t\n\r");
@@ -1400,6 +1597,13 @@ void  ScannerFile::LoadIndexFile (bool&  successful)
 
 void  ScannerFile::SkipBytesForward (kkuint32  numBytes)
 {
+  if  (mappedFile)
+  {
+    mappedPos += numBytes;
+    mappedEof = false;
+    return;
+  }
+
   kkint32  returnCd = osFSEEK (file, numBytes, SEEK_CUR);
   if  (returnCd != 0)
   {
@@ -1413,7 +1617,74 @@ void  ScannerFile::SkipBytesForward (kkuint32  numBytes)
 
 kkint32  ScannerFile::FSeek (kkint64  filePos)
 {
+  if  (mappedFile)
+  {
+    if  (filePos < 0)
+      return -1;
+    mappedPos = filePos;
+    mappedEof = false;
+    return 0;
+  }
+
   kkint32  returnCd = 0;
   returnCd = osFSEEK (file, filePos, SEEK_SET);
   return  returnCd;
 }  /* FSeek */
+
+
+
+size_t  ScannerFile::FRead (void*   dest,
+                            size_t  size,
+                            size_t  count
+                           )
+{
+  if  (!mappedFile)
+    return  fread (dest, size, count, file);
+
+  kkuint64  bytesWanted = size * count;
+  kkuint64  bytesAvailable = (mappedPos < (kkint64)mappedFile->Size ()) ? (mappedFile->Size () - mappedPos) : 0;
+  kkuint64  bytesRead = Min (bytesWanted, bytesAvailable);
+  if  (bytesRead > 0)
+    memcpy (dest, mappedFile->Data () + mappedPos, bytesRead);
+  mappedPos += bytesRead;
+  if  (bytesRead < bytesWanted)
+    mappedEof = true;
+
+  return  (size > 0) ? (bytesRead / size) : 0;
+}  /* FRead */
+
+
+
+bool  ScannerFile::FEof ()  const
+{
+  if  (mappedFile)
+    return  mappedEof;
+  else
+    return  (feof (file) != 0);
+}
+
+
+
+kkint64  ScannerFile::FTell ()  const
+{
+  if  (mappedFile)
+    return  mappedPos;
+  else
+    return  osFTELL (file);
+}
+
+
+
+void  ScannerFile::FUnGetC (uchar  ch)
+{
+  if  (!mappedFile)
+  {
+    ungetc (ch, file);
+    return;
+  }
+
+  // Only ever called to push back the byte just read.
+  if  (mappedPos > 0)
+    --mappedPos;
+  mappedEof = false;
+}  /* FUnGetC */
@@ -21,6 +21,7 @@
 #include "GoalKeeper.h"
 #include "KKBaseTypes.h"
 #include "KKStr.h"
+#include "MemoryMappedFile.h"
 #include "RunLog.h"
 using namespace KKB;
 
@@ -38,6 +39,9 @@ namespace  KKLSC
   typedef  class  ScannerFileEntry*  ScannerFileEntryPtr;
 #endif
 
+  class  ScannerFileReadAhead;
+  typedef  ScannerFileReadAhead*  ScannerFileReadAheadPtr;
+
 
   /** 
    * @class  ScannerFile  ScannerFile.h  base class to be used for all the different Scanner File Formats.
@@ -58,6 +62,23 @@ namespace  KKLSC
 
     typedef  enum  {ioRead,  ioWrite}  IOMode;
 
+    /** @brief  Instrument data word that was embedded in the scanner file;  see 'ReportInstrumentDataWord'. */
+    struct  InstrumentDataReport
+    {
+      InstrumentDataReport (uchar             _idNum,
+                            kkuint32          _scanLineNum,
+                            WordFormat32Bits  _dataWord
+                           ):
+          idNum (_idNum),  scanLineNum (_scanLineNum),  dataWord (_dataWord)
+      {}
+
+      uchar             idNum;
+      kkuint32          scanLineNum;
+      WordFormat32Bits  dataWord;
+    };
+
+    typedef  std::vector<InstrumentDataReport>  InstrumentDataReportList;
+
 
     /**  Constructor for opening file for reading */
     ScannerFile (const KKStr&  _fileName,
@@ -97,6 +118,7 @@ namespace  KKLSC
     kkint32                 FrameHeight               ()  const {return  frameHeight;}
     uchar*                  FrameBuffer               ()  const {return  frameBuffer;}
     bool                    FrameOffsetsLoaded        ()  const {return  frameOffsetsLoaded;}
+    bool                    MemoryMapped              ()  const {return  mappedFile != NULL;}
     kkint64                 FrameBufferFileOffsetLast ()  const {return  frameBufferFileOffsetLast;}
     kkint64                 FrameBufferFileOffsetNext ()  const {return  frameBufferFileOffsetNext;}
     ScannerHeaderFieldsPtr  HeaderFields              ()  const {return  headerFields;}
@@ -186,6 +208,17 @@ namespace  KKLSC
                     );
 
 
+    /**
+     *@brief  Returns the scan lines remaining in the current frame, reading the next frame if needed.
+     *@details  Meant for consumers that process whole frames;  avoids the per scan-line call and copy of 'GetNextLine'.
+     * The scan lines are contiguous, 'PixelsPerScanLine' bytes each, and remain valid until the next call that reads
+     * from this file.
+     *@param[out]  numScanLines  Number of scan lines returned;  zero at end of file.
+     *@returns  Pointer to the first scan line returned or NULL at end of file.
+     */
+    const uchar*  GetNextFrame (kkuint32&  numScanLines);
+
+
     virtual 
     void  GetNextLine (uchar*     lineBuff,
                        kkuint32   lineBuffSize,
@@ -196,6 +229,38 @@ namespace  KKLSC
   
     void  InitiateWritting ();
 
+
+    /**
+     *@brief  Starts decoding frames ahead of the reader using worker threads;  see 'ScannerFileReadAhead'.
+     *@details  Frames can only be decoded ahead once their byte offsets are known, so it is most effective after
+     * 'LoadIndexFile' or 'BuildFrameOffsets'.  'GetNextLine', 'GetNextFrame', 'SkipNextLine' and 'FrameRead' return
+     * the same data with or without read-ahead.
+     *@param[in]  numThreads      Number of frames decoded at the same time;  zero indicates one per processor.
+     *@param[in]  numFramesAhead  Number of decoded frames buffered ahead of the reader;  zero defaults to two per thread.
+     *@returns  false if the file is not opened for reading or could not be reopened by the worker threads.
+     */
+    bool  ReadAheadStart (kkuint32  numThreads,
+                          kkuint32  numFramesAhead
+                         );
+
+    /** @brief  Stops the read-ahead worker threads and releases their frame buffers. */
+    void  ReadAheadStop ();
+
+    bool  ReadAheadActive ()  const  {return  readAhead != NULL;}
+
+
+    /**
+     *@brief  Switches reading from buffered file IO to a read only memory mapping of the file.
+     *@details  Repositioning, ex: 'SkipToScanLine' and 'FrameRead', no longer costs a system call and the decoders
+     * read straight from the mapped pages.  Combined with the frame offsets from 'LoadIndexFile' jumping to any
+     * scan line only touches the pages of the frame that contains it.  The mapping covers the file as it was when
+     * this method was called.  May be called again to change the access pattern.
+     *@param[in]  accessPattern  'Sequential' when the file will be played through, 'Random' when jumping around.
+     *@returns  false if the file is not opened for reading or could not be mapped;  reading continues through
+     *          buffered file IO.
+     */
+    bool  MemoryMap (MemoryMappedFile::AccessPattern  accessPattern);
+
     void  Reset ();
   
     void  SkipNextLine ();
@@ -299,6 +364,8 @@ namespace  KKLSC
 
 
   protected:
+    friend class  ScannerFileReadAhead;
+
     void  AllocateFrameBuffer ();
 
     void  ExtractHeaderField (const KKStr&  fieldName,
@@ -328,6 +395,11 @@ namespace  KKLSC
                          kkint32      numTextBytes
                         );
 
+    /**
+     *@brief  Instrument data embedded in a scanner file is reported here.
+     *@details  When 'instrumentDataCapture' is set the report is appended to it instead;  this is how frames decoded by
+     * 'ScannerFileReadAhead' pass their instrument data back to the reader in scan line order.
+     */
     void  ReportInstrumentDataWord (uchar             idNum,
                                     kkuint32          scanLineNum,
                                     WordFormat32Bits  dataWord
@@ -336,6 +408,22 @@ namespace  KKLSC
 
     kkint32  FSeek (kkint64  filePos);
 
+    /**
+     *@brief  Read primitives the format decoders use in place of 'fread', 'feof', 'ftell' and 'ungetc'.
+     *@details  Once 'MemoryMap' has been called they copy straight out of the mapped pages at 'mappedPos' rather
+     * than going through 'file';  when end of file is flagged matches the C library.
+     */
+    size_t   FRead (void*   dest,
+                    size_t  size,
+                    size_t  count
+                   );
+
+    bool     FEof ()  const;
+
+    kkint64  FTell ()  const;
+
+    void     FUnGetC (uchar  ch);
+
     /**  
      *@brief Write the contents of 'frameBuffer' to he end of the scanner file.
      *@details  Will write the entire contents of 'frameBuffer' to the end of the scanner file.
@@ -359,6 +447,14 @@ namespace  KKLSC
 
     void  SkipBytesForward (kkuint32  numBytes);
 
+    /**
+     *@brief  When memory mapped returns a pointer to the 'len' bytes starting at 'offset' in the file.
+     *@returns  NULL if not memory mapped or the range extends past the end of the file.
+     */
+    const uchar*  MappedBytes (kkint64   offset,
+                               kkuint32  len
+                              )  const;
+
     static
     const KKStr  fileFormatOptions[];
 
@@ -366,6 +462,13 @@ namespace  KKLSC
     kkint64  GetFrameOffset (kkuint32  frameNum);
     void     DetermineFrameOffsetForFrame (kkuint32  frameNum);
 
+    /**
+     *@brief  Loads 'frameNum' into 'frameBuffer' and updates 'frameOffsets';  'file' must be positioned at the start of the frame.
+     *@details  When read-ahead is active the frame is taken from its buffers if it was decoded ahead, after which 'file'
+     * is repositioned to the following frame as if the frame had been read from it.  Caller must hold 'goalie'.
+     */
+    void     LoadFrameBuffer (kkuint32  frameNum);
+
     void     UpdateFrameOffset (kkuint32 frameNum,
                                 kkuint32 scanLineNum,
                                 kkint64  byteOffset
@@ -468,6 +571,16 @@ namespace  KKLSC
                                           */
     KKStr                indexFileName;
 
+    InstrumentDataReportList*  instrumentDataCapture;  /**< When not NULL 'ReportInstrumentDataWord' appends to this list. */
+
+    bool                       mappedEof;              /**< End of file indicator while reading through 'mappedFile'. */
+
+    MemoryMappedFilePtr        mappedFile;             /**< Not NULL when reading through a memory mapping;  see 'MemoryMap'. */
+
+    kkint64                    mappedPos;              /**< Read position while reading through 'mappedFile'. */
+
+    ScannerFileReadAheadPtr    readAhead;              /**< Not NULL while read-ahead is active;  see 'ReadAheadStart'. */
+
     ScannerFileEntryPtr  scannerFileEntry;
 
 
@@ -369,24 +369,29 @@ kkuint32  ScannerFile2BitEncoded::ReadBufferFrame ()
 {
   frameBufferLen = 0;
   frameBufferNextLine = 0;
-  if  (feof (file) != 0)
+  if  (FEof ())
   {
     memset (frameBuffer, 0, frameBufferSize);
     return 0;
   }
 
-  frameBufferFileOffsetLast = osFTELL (file);
+  frameBufferFileOffsetLast = FTell ();
   kkuint32  numScanLinesReadThisFrameBuffer = 0;
   uchar*  buffPtr = frameBuffer;
-  while  ((feof (file) == 0)  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
+  while  ((!FEof ())  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
   {
+    // End of file is only detected by the read that comes up short;  when that is the first read of
+    // the scan line there was no scan line left.
+    kkint64  scanLineStart = FTell ();
     GetNextScanLine (buffPtr, pixelsPerScanLine);
+    if  (FEof ()  &&  (FTell () == scanLineStart))
+      break;
     frameBufferLen += pixelsPerScanLine;
     buffPtr += pixelsPerScanLine;
     ++numScanLinesReadThisFrameBuffer;
   }
 
-  frameBufferFileOffsetNext = osFTELL (file);
+  frameBufferFileOffsetNext = FTell ();
   frameBufferNextLine = 0;
   return  numScanLinesReadThisFrameBuffer;
 }  /* ReadBufferFrame */
@@ -398,16 +403,19 @@ kkint64  ScannerFile2BitEncoded::SkipToNextFrame ()
   uchar*  scanLine = new uchar[pixelsPerScanLine];
 
   kkuint32  numScanLinesReadThisFrameBuffer = 0;
-  while  ((feof (file) == 0)  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
+  while  ((!FEof ())  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
   {
     GetNextScanLine (scanLine, pixelsPerScanLine);
     ++numScanLinesReadThisFrameBuffer;
   }
 
-  if  (feof (file) != 0)
+  delete[]  scanLine;
+  scanLine = NULL;
+
+  if  (FEof ())
     return -1;
   else
-    return osFTELL (file);
+    return FTell ();
 }  /* SkipToNextFrame */
 
 
@@ -416,7 +424,7 @@ void  ScannerFile2BitEncoded::ProcessTextBlock (const OpRec&  rec)
 {
   OpRec  rec2;
 
-  size_t  recsRead = fread (&rec2, sizeof (rec2), 1, file);
+  size_t  recsRead = FRead (&rec2, sizeof (rec2), 1);
   if  (recsRead < 1)
   {
     eof = true;
@@ -427,7 +435,7 @@ void  ScannerFile2BitEncoded::ProcessTextBlock (const OpRec&  rec)
   char* textMsgPtr = new char[numTextBytes + 1];
   kkuint32 textMsgLen = numTextBytes;
   
-  recsRead = fread (textMsgPtr, 1, numTextBytes, file);
+  recsRead = FRead (textMsgPtr, 1, numTextBytes);
   if  (recsRead < numTextBytes)
      eof = true;
   textMsgPtr[recsRead] = 0;
@@ -453,7 +461,7 @@ void  ScannerFile2BitEncoded::ProcessRawPixelRecs (kkuint16  numRawPixels,
   if  (numRawPixelRecsToRead > rawPixelRecBufferSize)
     AllocateRawPixelRecBuffer (numRawPixelRecsToRead + 30);
 
-  size_t  recsRead = fread (rawPixelRecBuffer, sizeof (RawPixelRec), numRawPixelRecsToRead, file);
+  size_t  recsRead = FRead (rawPixelRecBuffer, sizeof (RawPixelRec), numRawPixelRecsToRead);
   if  (recsRead < numRawPixelRecsToRead)
   {
     eof = true;
@@ -510,7 +518,7 @@ void  ScannerFile2BitEncoded::GetNextScanLine (uchar*   lineBuff,
 
   do
   {
-    recsRead = fread (&rec, sizeof (rec), 1, file);
+    recsRead = FRead (&rec, sizeof (rec), 1);
     if  (recsRead == 0)
     {
       break;
@@ -526,7 +534,7 @@ void  ScannerFile2BitEncoded::GetNextScanLine (uchar*   lineBuff,
       // Something has gone wrong,  we should have encountered a eol op code before this point;  that is the 
       // length of the encoded line is exceeding the scan line length.
       eol = true;
-      ungetc (rec.textChar, file);
+      FUnGetC (rec.textChar);
       break;
     }
 
@@ -556,7 +564,7 @@ void  ScannerFile2BitEncoded::GetNextScanLine (uchar*   lineBuff,
     else if  (opCode == 8)
     {
       // Variable Run Length 0 thru 1023
-      recsRead = fread (&rec2, sizeof (rec2), 1, file);
+      recsRead = FRead (&rec2, sizeof (rec2), 1);
       if  (recsRead < 1)
       {
         eol = true;
@@ -608,7 +616,7 @@ void  ScannerFile2BitEncoded::GetNextScanLine (uchar*   lineBuff,
       // Variable Length Raw Pixels where string length = (0 thru 4095)
 
       // Variable Run Length 0 thru 1023
-      recsRead = fread (&rec2, sizeof (rec2), 1, file);
+      recsRead = FRead (&rec2, sizeof (rec2), 1);
       if  (recsRead < 1)
       {
         eol = true;
@@ -749,7 +757,7 @@ void  ScannerFile2BitEncoded::AddRawStrPixelsToEncodedBuffer (kkuint16&  nextCp,
     else
     {
 #include "DisableConversionWarning.h"
-      rec.rawPixelRec.pix0 = rawStr[nextCp];  ++rawStr;
+      rec.rawPixelRec.pix0 = rawStr[nextCp];  ++nextCp;
       if  (len > 1)  {rec.rawPixelRec.pix1 = rawStr[nextCp];  ++nextCp;}
       if  (len > 2)  {rec.rawPixelRec.pix2 = rawStr[nextCp];  ++nextCp;}
       if  (len > 3)  {rec.rawPixelRec.pix3 = rawStr[nextCp];  ++nextCp;}
@@ -228,29 +228,34 @@ kkuint32  ScannerFile3BitEncoded::ReadBufferFrame ()
 {
   frameBufferLen = 0;
   frameBufferNextLine = 0;
-  if  (feof (file) != 0)
+  if  (FEof ())
   {
     memset (frameBuffer, 0, frameBufferSize);
     return 0;
   }
 
-  frameBufferFileOffsetLast = osFTELL (file);
+  frameBufferFileOffsetLast = FTell ();
   kkuint32  numScanLinesReadThisFrameBuffer = 0;
   uchar*  buffPtr = frameBuffer;
 
-  while  ((feof (file) == 0)  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
+  while  ((!FEof ())  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
   {
+    // End of file is only detected by the read that comes up short;  when that is the first read of
+    // the scan line there was no scan line left.
+    kkint64  scanLineStart = FTell ();
     GetNextScanLine (buffPtr, pixelsPerScanLine);
+    if  (FEof ()  &&  (FTell () == scanLineStart))
+      break;
     frameBufferLen += pixelsPerScanLine;
     buffPtr += pixelsPerScanLine;
     ++numScanLinesReadThisFrameBuffer;
   }
 
-  bool  endOfFileFound = (feof (file) != 0);
+  bool  endOfFileFound = FEof ();
   if  (endOfFileFound)
     cerr << "end of file was found." << endl;
 
-  frameBufferFileOffsetNext = osFTELL (file);
+  frameBufferFileOffsetNext = FTell ();
   frameBufferNextLine = 0;
   return  numScanLinesReadThisFrameBuffer;
 }  /* ReadBufferFrame */
@@ -262,7 +267,7 @@ kkint64  ScannerFile3BitEncoded::SkipToNextFrame ()
   uchar*  scanLine = new uchar[pixelsPerScanLine];
 
   kkuint32  numScanLinesReadThisFrameBuffer = 0;
-  while  ((feof (file) == 0)  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
+  while  ((!FEof ())  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
   {
     GetNextScanLine (scanLine, pixelsPerScanLine);
     ++numScanLinesReadThisFrameBuffer;
@@ -271,10 +276,10 @@ kkint64  ScannerFile3BitEncoded::SkipToNextFrame ()
   delete[]  scanLine;
   scanLine = NULL;
 
-  if  (feof (file) != 0)
+  if  (FEof ())
     return -1;
   else
-    return osFTELL (file);
+    return FTell ();
 }  /* SkipToNextFrame */
 
 
@@ -295,7 +300,7 @@ void  ScannerFile3BitEncoded::GetNextScanLine (uchar* lineBuff,
 
   do
   {
-    recsRead = fread (&rec, sizeof (rec), 1, file);
+    recsRead = FRead (&rec, sizeof (rec), 1);
     if  (recsRead == 0)
     {
       break;
@@ -339,7 +344,7 @@ void  ScannerFile3BitEncoded::GetNextScanLine (uchar* lineBuff,
           textMsgLen = newTextMsgLen;
         }
 
-        recsRead = fread (textMsgPtr, 1, numTextBytes, file);
+        recsRead = FRead (textMsgPtr, 1, numTextBytes);
         if  (recsRead < numTextBytes)
         {
           eol = true;
@@ -357,7 +362,7 @@ void  ScannerFile3BitEncoded::GetNextScanLine (uchar* lineBuff,
     case 1:
       {
         eol = (rec.rawPixels.eol == 1);
-        if  (lineSize >= (lineBuffSize - 4))
+        if  ((lineSize + 4) > lineBuffSize)
         {
           // We are going to exceed the length of the provided buffer.
           lineSize = lineBuffSize;
@@ -465,16 +470,7 @@ void  ScannerFile3BitEncoded::WriteBufferFrame ()
     ++frameRow;
   }
  
-  #if  defined(KKOS_WINDOWS)
-    frameBufferFileOffsetNext = osFTELL (file);
-  #else
-    /**
-     *@todo  We need to implement a 64 bit ftell function for non windows; this will involve 
-     * implementation of '#define _FILE_OFFSET_BITS 64' and ftell; probably thru macros
-     * in the "FirstIncludes.h" file.
-     */
-  #endif
-
+  frameBufferFileOffsetNext = osFTELL (file);
   fileSizeInBytes = frameBufferFileOffsetNext;
 }  /* WriteBufferFrame*/
 
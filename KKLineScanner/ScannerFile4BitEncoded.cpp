@@ -434,24 +434,29 @@ kkuint32  ScannerFile4BitEncoded::ReadBufferFrame ()
 {
   frameBufferLen = 0;
   frameBufferNextLine = 0;
-  if  (feof (file) != 0)
+  if  (FEof ())
   {
     memset (frameBuffer, 0, frameBufferSize);
     return 0;
   }
 
-  frameBufferFileOffsetLast = osFTELL (file);
+  frameBufferFileOffsetLast = FTell ();
   kkuint32  numScanLinesReadThisFrameBuffer = 0;
   uchar*  buffPtr = frameBuffer;
-  while  ((feof (file) == 0)  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
+  while  ((!FEof ())  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
   {
+    // End of file is only detected by the read that comes up short;  when that is the first read of
+    // the scan line there was no scan line left.
+    kkint64  scanLineStart = FTell ();
     GetNextScanLine (buffPtr, pixelsPerScanLine);
+    if  (FEof ()  &&  (FTell () == scanLineStart))
+      break;
     frameBufferLen += pixelsPerScanLine;
     buffPtr += pixelsPerScanLine;
     ++numScanLinesReadThisFrameBuffer;
   }
 
-  frameBufferFileOffsetNext = osFTELL (file);
+  frameBufferFileOffsetNext = FTell ();
   frameBufferNextLine = 0;
   return  numScanLinesReadThisFrameBuffer;
 }  /* ReadBufferFrame */
@@ -463,7 +468,7 @@ kkint64  ScannerFile4BitEncoded::SkipToNextFrame ()
   uchar*  scanLine = new uchar[pixelsPerScanLine];
 
   kkuint32  numScanLinesReadThisFrameBuffer = 0;
-  while  ((feof (file) == 0)  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
+  while  ((!FEof ())  &&  (numScanLinesReadThisFrameBuffer < frameHeight))
   {
     GetNextScanLine (scanLine, pixelsPerScanLine);
     ++numScanLinesReadThisFrameBuffer;
@@ -472,10 +477,10 @@ kkint64  ScannerFile4BitEncoded::SkipToNextFrame ()
   delete[]  scanLine;
   scanLine = NULL;
 
-  if  (feof (file) != 0)
+  if  (FEof ())
     return -1;
   else
-    return osFTELL (file);
+    return FTell ();
 }  /* SkipToNextFrame */
 
 
@@ -484,7 +489,7 @@ void  ScannerFile4BitEncoded::ProcessTextBlock (const OpRec&  rec)
 {
   OpRec  rec2;
 
-  size_t  recsRead = fread (&rec2, sizeof (rec2), 1, file);
+  size_t  recsRead = FRead (&rec2, sizeof (rec2), 1);
   if  (recsRead < 1)
   {
     eof = true;
@@ -495,7 +500,7 @@ void  ScannerFile4BitEncoded::ProcessTextBlock (const OpRec&  rec)
    char* textMsgPtr = new char[numTextBytes + 1];  // "+ 1" for terminating NULL Character.
    kkuint32 textMsgLen = numTextBytes;
    
-   recsRead = fread (textMsgPtr, 1, numTextBytes, file);
+   recsRead = FRead (textMsgPtr, 1, numTextBytes);
    if  (recsRead < numTextBytes)
       eof = true;
    else
@@ -515,12 +520,12 @@ void  ScannerFile4BitEncoded::ProcessInstrumentDataWord (const OpRec&  rec)
 
   OpRecInstrumentDataWord2  rec2;
   OpRecInstrumentDataWord3  rec3;
-  size_t  recsRead = fread (&rec2, sizeof (rec2), 1, file);
+  size_t  recsRead = FRead (&rec2, sizeof (rec2), 1);
   if  (recsRead < 1)
     eof = true;
   else
   {
-    recsRead = fread (&rec3, sizeof (rec3), 1, file);
+    recsRead = FRead (&rec3, sizeof (rec3), 1);
     if  (recsRead < 1)
       eof = true;
     else
@@ -539,7 +544,7 @@ void  ScannerFile4BitEncoded::ProcessRawPixelRecs (kkuint32  numRawPixelRecs,
   if  (numRawPixelRecs > rawPixelRecBufferSize)
     AllocateRawPixelRecBuffer (numRawPixelRecs + 30);
 
-  size_t  recsRead = fread (rawPixelRecBuffer, sizeof (RawPixelRec), numRawPixelRecs, file);
+  size_t  recsRead = FRead (rawPixelRecBuffer, sizeof (RawPixelRec), numRawPixelRecs);
   if  (recsRead < numRawPixelRecs)
   {
     eof = true;
@@ -571,7 +576,7 @@ void  ScannerFile4BitEncoded::GetNextScanLine (uchar* lineBuff,
 
   do
   {
-    recsRead = fread (&rec, sizeof (rec), 1, file);
+    recsRead = FRead (&rec, sizeof (rec), 1);
     if  (recsRead == 0)
     {
       break;
@@ -587,7 +592,7 @@ void  ScannerFile4BitEncoded::GetNextScanLine (uchar* lineBuff,
       // Something has gone wrong,  we should have encountered a eol opCode before this point;  that is the
       // length of the encoded line is exceeding the scan line length.
       eol = true;
-      ungetc (rec.textChar, file);
+      FUnGetC (rec.textChar);
       break;
     }
 
@@ -619,7 +624,7 @@ void  ScannerFile4BitEncoded::GetNextScanLine (uchar* lineBuff,
 
     else if  (opCode == opCodeRenLength1Thru256)  /* OpRecRun256Len1 */
     {
-      recsRead = fread (&rec2, sizeof (rec2), 1, file);
+      recsRead = FRead (&rec2, sizeof (rec2), 1);
       if  (recsRead < 1)
         eol = true;
       else
@@ -665,7 +670,7 @@ void  ScannerFile4BitEncoded::GetNextScanLine (uchar* lineBuff,
 
     else if  (opCode == opCodeRawSeqOdd1Thru513Pixels)
     {
-      recsRead = fread (&rec2, sizeof (rec2), 1, file);
+      recsRead = FRead (&rec2, sizeof (rec2), 1);
       if  (recsRead < 1)
       {
         eol = true;
@@ -0,0 +1,365 @@
+#include "FirstIncludes.h"
+#include <stdio.h>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#include "KKBaseTypes.h"
+#include "KKThreadPool.h"
+#include "OSservices.h"
+#include "RunLog.h"
+using namespace KKB;
+
+
+#include "ScannerFileReadAhead.h"
+#include "ScannerFile.h"
+using namespace  KKLSC;
+
+
+
+ScannerFileReadAhead::Slot::Slot ():
+    buffer         (NULL),
+    bufferLen      (0),
+    discard        (false),
+    failed         (false),
+    fileOffset     (-1),
+    fileOffsetLast (-1),
+    fileOffsetNext (-1),
+    frameNum       (0),
+    instrumentData (),
+    lastReadEof    (false),
+    numScanLines   (0),
+    state          (SlotState::Empty)
+{
+}
+
+
+
+ScannerFileReadAhead::ScannerFileReadAhead (ScannerFilePtr  _owner,
+                                            kkuint32        _numThreads,
+                                            kkuint32        _numFramesAhead,
+                                            RunLog&         _log
+                                           ):
+    decoders     (),
+    frameDecoded (),
+    idleDecoders (),
+    log          (_log),
+    mutex        (),
+    owner        (_owner),
+    pool         (NULL),
+    slots        ()
+{
+  kkuint32  numThreads = KKThreadPool::ResolveNumThreads (_numThreads);
+  kkuint32  numFramesAhead = (_numFramesAhead > 0) ? _numFramesAhead : (2 * numThreads);
+
+  for  (kkuint32 x = 0;  x < numThreads;  ++x)
+  {
+    ScannerFilePtr  decoder = ScannerFile::CreateScannerFile (owner->FileName (), log);
+    if  (decoder  &&  decoder->Opened ()  &&
+         (decoder->FileFormat ()      == owner->FileFormat ())  &&
+         (decoder->frameBufferSize    == owner->frameBufferSize)  &&
+         (decoder->pixelsPerScanLine  == owner->pixelsPerScanLine)
+        )
+    {
+      if  (owner->MemoryMapped ())
+        decoder->MemoryMap (MemoryMappedFile::AccessPattern::Normal);
+      decoders.push_back (decoder);
+      idleDecoders.push_back (decoder);
+    }
+    else
+    {
+      log.Level (-1) << endl
+        << "ScannerFileReadAhead   ***ERROR***   Could not open decoder for: " << owner->FileName () << endl
+        << endl;
+      delete  decoder;
+      decoder = NULL;
+      break;
+    }
+  }
+
+  if  (decoders.empty ())
+    return;
+
+  slots.resize (numFramesAhead);
+  for  (auto& slot: slots)
+    slot.buffer = new uchar[owner->frameBufferSize];
+
+  // At least two threads so that the pool always decodes on worker threads rather than the readers thread.
+  pool = new KKThreadPool ("ScannerFileReadAhead", Max ((kkuint32)decoders.size (), (kkuint32)2));
+}
+
+
+
+ScannerFileReadAhead::~ScannerFileReadAhead ()
+{
+  {
+    unique_lock<std::mutex>  lock (mutex);
+    for  (auto& slot: slots)
+    {
+      if  (slot.state == SlotState::Pending)
+        slot.state = SlotState::Empty;
+    }
+    frameDecoded.wait (lock, [this] {return idleDecoders.size () >= decoders.size ();});
+  }
+
+  delete  pool;
+  pool = NULL;
+
+  for  (auto decoder: decoders)
+    delete  decoder;
+  decoders.clear ();
+  idleDecoders.clear ();
+
+  for  (auto& slot: slots)
+  {
+    delete[]  slot.buffer;
+    slot.buffer = NULL;
+  }
+}
+
+
+
+kkMemSize  ScannerFileReadAhead::MemoryConsumedEstimated ()  const
+{
+  kkMemSize  mem = sizeof (*this) + slots.size () * sizeof (Slot);
+
+  for  (auto& slot: slots)
+  {
+    if  (slot.buffer)
+      mem += owner->frameBufferSize;
+    mem += slot.instrumentData.size () * sizeof (ScannerFile::InstrumentDataReport);
+  }
+
+  for  (auto decoder: decoders)
+    mem += decoder->MemoryConsumedEstimated ();
+
+  if  (pool)
+    mem += pool->MemoryConsumedEstimated ();
+
+  return  mem;
+}
+
+
+
+kkint64  ScannerFileReadAhead::FrameOffset (kkuint32  frameNum)
+{
+  kkint64  offset = owner->GetFrameOffset (frameNum);
+  if  ((offset >= 0)  ||  (frameNum < 1))
+    return  offset;
+
+  // The frame before it may already be decoded in which case we know where it ended.
+  const Slot&  prevSlot = slots[(frameNum - 1) % slots.size ()];
+  if  ((prevSlot.state == SlotState::Ready)   &&
+       (prevSlot.frameNum == (frameNum - 1))  &&
+       (!prevSlot.discard)                    &&
+       (!prevSlot.failed)                     &&
+       (!prevSlot.lastReadEof)                &&
+       (prevSlot.numScanLines > 0)
+      )
+    offset = prevSlot.fileOffsetNext;
+
+  return  offset;
+}  /* FrameOffset */
+
+
+
+ScannerFileReadAhead::Slot*  ScannerFileReadAhead::NextPendingSlot ()
+{
+  Slot*  next = NULL;
+  for  (auto& slot: slots)
+  {
+    if  ((slot.state == SlotState::Pending)  &&  ((next == NULL)  ||  (slot.frameNum < next->frameNum)))
+      next = &slot;
+  }
+  return  next;
+}  /* NextPendingSlot */
+
+
+
+void  ScannerFileReadAhead::ScheduleFrom (kkuint32  frameNum)
+{
+  if  (!pool)
+    return;
+
+  kkuint32  numSlots = (kkuint32)slots.size ();
+  kkuint32  tasksToAdd = 0;
+  {
+    lock_guard<std::mutex>  lock (mutex);
+
+    for  (auto& slot: slots)
+    {
+      if  (slot.state == SlotState::Empty)
+        continue;
+
+      if  ((slot.frameNum >= frameNum)  &&  (slot.frameNum < (frameNum + numSlots)))
+        continue;
+
+      if  (slot.state == SlotState::Decoding)
+        slot.discard = true;
+      else
+        slot.state = SlotState::Empty;
+    }
+
+    kkuint32  numPending = 0;
+    for  (kkuint32 f = frameNum;  f < (frameNum + numSlots);  ++f)
+    {
+      Slot&  slot = slots[f % numSlots];
+      if  (slot.state != SlotState::Empty)
+      {
+        if  ((slot.frameNum != f)  ||  slot.discard)
+          break;   // Still busy with a frame that was discarded.
+
+        if  ((slot.state == SlotState::Ready)  &&  (slot.lastReadEof  ||  (slot.numScanLines < 1)))
+          break;   // End of file.
+
+        continue;
+      }
+
+      kkint64  offset = FrameOffset (f);
+      if  (offset < 0)
+        break;
+
+      slot.discard = false;
+      slot.failed = false;
+      slot.fileOffset = offset;
+      slot.frameNum = f;
+      slot.state = SlotState::Pending;
+      ++numPending;
+    }
+
+    tasksToAdd = Min (numPending, (kkuint32)idleDecoders.size ());
+  }
+
+  for  (kkuint32 x = 0;  x < tasksToAdd;  ++x)
+    pool->AddTask ([this] () {DecodePendingFrames ();});
+}  /* ScheduleFrom */
+
+
+
+void  ScannerFileReadAhead::DecodePendingFrames ()
+{
+  ScannerFilePtr  decoder = NULL;
+  {
+    lock_guard<std::mutex>  lock (mutex);
+    if  (idleDecoders.empty ())
+      return;
+    decoder = idleDecoders.back ();
+    idleDecoders.pop_back ();
+  }
+
+  while  (true)
+  {
+    Slot*  slot = NULL;
+    {
+      lock_guard<std::mutex>  lock (mutex);
+      slot = NextPendingSlot ();
+      if  (!slot)
+      {
+        idleDecoders.push_back (decoder);
+        break;
+      }
+      slot->state = SlotState::Decoding;
+    }
+
+    DecodeFrame (decoder, *slot);
+
+    {
+      lock_guard<std::mutex>  lock (mutex);
+      if  (slot->discard)
+      {
+        slot->discard = false;
+        slot->state = SlotState::Empty;
+      }
+      else
+      {
+        slot->state = SlotState::Ready;
+      }
+    }
+    frameDecoded.notify_all ();
+  }
+
+  // Let the destructor know that this decoder is no longer in use.
+  frameDecoded.notify_all ();
+}  /* DecodePendingFrames */
+
+
+
+void  ScannerFileReadAhead::DecodeFrame (ScannerFilePtr  decoder,
+                                         Slot&           slot
+                                        )
+{
+  slot.instrumentData.clear ();
+  slot.failed = false;
+  decoder->instrumentDataCapture = &slot.instrumentData;
+  try
+  {
+    decoder->FSeek (slot.fileOffset);
+    slot.numScanLines   = decoder->ReadBufferFrame ();
+    slot.lastReadEof    = decoder->FEof ();
+    slot.bufferLen      = decoder->frameBufferLen;
+    slot.fileOffsetLast = decoder->frameBufferFileOffsetLast;
+    slot.fileOffsetNext = decoder->frameBufferFileOffsetNext;
+
+    uchar*  decodedFrame = decoder->frameBuffer;
+    decoder->frameBuffer = slot.buffer;
+    slot.buffer = decodedFrame;
+  }
+  catch  (...)
+  {
+    slot.failed = true;
+  }
+  decoder->instrumentDataCapture = NULL;
+}  /* DecodeFrame */
+
+
+
+bool  ScannerFileReadAhead::LoadFrame (kkuint32  frameNum,
+                                       kkint64   fileOffset
+                                      )
+{
+  if  (!pool)
+    return false;
+
+  ScannerFile::InstrumentDataReportList  instrumentData;
+  {
+    unique_lock<std::mutex>  lock (mutex);
+    Slot&  slot = slots[frameNum % slots.size ()];
+    if  ((slot.state == SlotState::Empty)  ||  (slot.frameNum != frameNum)  ||  slot.discard)
+      return false;
+
+    if  (slot.fileOffset != fileOffset)
+    {
+      if  (slot.state == SlotState::Decoding)
+        slot.discard = true;
+      else
+        slot.state = SlotState::Empty;
+      return false;
+    }
+
+    frameDecoded.wait (lock, [&slot] {return slot.state == SlotState::Ready;});
+
+    slot.state = SlotState::Empty;
+    if  (slot.failed)
+      return false;
+
+    uchar*  decodedFrame = slot.buffer;
+    slot.buffer = owner->frameBuffer;
+    owner->frameBuffer = decodedFrame;
+
+    owner->frameBufferLen            = slot.bufferLen;
+    owner->frameBufferNumScanLines   = slot.numScanLines;
+    owner->frameBufferLastReadEof    = slot.lastReadEof;
+    owner->frameBufferFileOffsetLast = slot.fileOffsetLast;
+    owner->frameBufferFileOffsetNext = slot.fileOffsetNext;
+    instrumentData.swap (slot.instrumentData);
+  }
+
+  for  (auto& report: instrumentData)
+    owner->ReportInstrumentDataWord (report.idNum, report.scanLineNum, report.dataWord);
+
+  return  true;
+}  /* LoadFrame */
@@ -0,0 +1,127 @@
+#if  !defined(_SCANNERFILEREADAHEAD_)
+#define  _SCANNERFILEREADAHEAD_
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "KKBaseTypes.h"
+#include "KKThreadPool.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "ScannerFile.h"
+
+
+namespace  KKLSC
+{
+  /**
+   *@brief  Decodes the frames of a ScannerFile ahead of the reader using worker threads.
+   *@details  Each worker thread uses its own instance of the scanner file, opened on the same file, to 'FSeek' to a
+   * frame's byte offset and call 'ReadBufferFrame'.  Decoded frames are kept in a ring of 'numFramesAhead' buffers;
+   * 'LoadFrame' swaps the requested frame's buffer with the owner's 'frameBuffer' so no pixel data is copied.
+   *
+   * A frame can only be decoded ahead once its byte offset is known;  either from the owner's 'frameOffsets' table,
+   * which is complete after 'BuildFrameOffsets' or 'LoadIndexFile', or from the end of the frame decoded before it.
+   * Without the index only one frame is decoded ahead of the reader.
+   *
+   * Instrument data embedded in a frame is captured while decoding and replayed through the owner's
+   * 'ReportInstrumentDataWord' when the frame is loaded so that 'FlowMeterCounter' is updated in scan line order.
+   */
+  class  ScannerFileReadAhead
+  {
+  public:
+    typedef  ScannerFileReadAhead*  ScannerFileReadAheadPtr;
+
+    /**
+     *@param[in]  _owner           Scanner file being read;  must be opened for reading.
+     *@param[in]  _numThreads      Number of frames decoded at the same time;  zero indicates one per processor.
+     *@param[in]  _numFramesAhead  Number of decoded frames buffered ahead of the reader;  zero defaults to two
+     *                             per thread.
+     *@param[in]  _log
+     */
+    ScannerFileReadAhead (ScannerFilePtr  _owner,
+                          kkuint32        _numThreads,
+                          kkuint32        _numFramesAhead,
+                          RunLog&         _log
+                         );
+
+    /** @brief  Waits for frames that are being decoded to complete. */
+    ~ScannerFileReadAhead ();
+
+    kkMemSize  MemoryConsumedEstimated ()  const;
+
+    kkuint32  NumDecoders ()  const  {return (kkuint32)decoders.size ();}
+
+    kkuint32  NumFramesAhead ()  const  {return (kkuint32)slots.size ();}
+
+    /**
+     *@brief  Loads 'frameNum' into the owner's frame buffer if it was decoded ahead, waiting for it if needed.
+     *@details  Updates the owner's 'frameBuffer', 'frameBufferLen', 'frameBufferNumScanLines', 'frameBufferLastReadEof',
+     * 'frameBufferFileOffsetLast' and 'frameBufferFileOffsetNext';  the file position of the owner is not changed.
+     *@param[in]  frameNum    Frame to load.
+     *@param[in]  fileOffset  Byte offset the owner would read the frame from;  if the frame was decoded from a different
+     *                        offset, ex: a stale index file, it is discarded.
+     *@returns  false if 'frameNum' was not scheduled;  the owner then has to decode it itself.
+     */
+    bool  LoadFrame (kkuint32  frameNum,
+                     kkint64   fileOffset
+                    );
+
+    /**
+     *@brief  Starts decoding the frames following the reader's position.
+     *@details  Frames buffered that are not in the range ['frameNum', 'frameNum' + NumFramesAhead ()) are discarded.
+     * Call after the owner has updated 'frameOffsets' for the frame it just loaded.
+     */
+    void  ScheduleFrom (kkuint32  frameNum);
+
+  private:
+    enum  class  SlotState  {Empty, Pending, Decoding, Ready};
+
+    struct  Slot
+    {
+      Slot ();
+
+      uchar*                                 buffer;
+      kkuint32                               bufferLen;
+      bool                                   discard;         /**< Set when the reader moved away while decoding.  */
+      bool                                   failed;          /**< Decoding threw an exception.                    */
+      kkint64                                fileOffset;      /**< Byte offset of the start of the frame.          */
+      kkint64                                fileOffsetLast;
+      kkint64                                fileOffsetNext;
+      kkuint32                               frameNum;
+      ScannerFile::InstrumentDataReportList  instrumentData;
+      bool                                   lastReadEof;
+      kkuint32                               numScanLines;
+      SlotState                              state;
+    };
+
+    void  DecodeFrame (ScannerFilePtr  decoder,
+                       Slot&           slot
+                      );
+
+    /** @brief  Task executed by the thread pool;  decodes pending frames until there are none left. */
+    void  DecodePendingFrames ();
+
+    /** @brief  Byte offset of 'frameNum' or -1 if not known yet;  caller must hold 'mutex'. */
+    kkint64  FrameOffset (kkuint32  frameNum);
+
+    /** @brief  Pending slot with the lowest frame number;  caller must hold 'mutex'. */
+    Slot*  NextPendingSlot ();
+
+    std::vector<ScannerFilePtr>  decoders;      /**< One instance of the scanner file per thread;  owned.           */
+    std::condition_variable      frameDecoded;
+    std::vector<ScannerFilePtr>  idleDecoders;  /**< Decoders not in use by a task.                                 */
+    RunLog&                      log;
+    std::mutex                   mutex;
+    ScannerFilePtr               owner;
+    KKThreadPoolPtr              pool;
+    std::vector<Slot>            slots;         /**< Frame 'n' is decoded into 'slots[n % slots.size ()]'.           */
+  };  /* ScannerFileReadAhead */
+
+  typedef  ScannerFileReadAhead::ScannerFileReadAheadPtr  ScannerFileReadAheadPtr;
+}  /* KKLSC */
+
+#define  _ScannerFileReadAhead_Defined_
+
+#endif
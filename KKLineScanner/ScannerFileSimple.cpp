@@ -64,15 +64,15 @@ kkuint32  ScannerFileSimple::ReadBufferFrame ()
 {
   frameBufferLen = 0;
   frameBufferNextLine = 0;
-  if  (feof (file) != 0)
+  if  (FEof ())
   {
     memset (frameBuffer, 0, frameBufferSize);
     return 0;
   }
 
-  frameBufferFileOffsetLast = osFTELL (file);
-  frameBufferLen = (kkint32)fread (frameBuffer, 1, frameBufferSize, file);
-  frameBufferFileOffsetNext = osFTELL (file);
+  frameBufferFileOffsetLast = FTell ();
+  frameBufferLen = (kkint32)FRead (frameBuffer, 1, frameBufferSize);
+  frameBufferFileOffsetNext = FTell ();
   frameBufferNextLine = 0;
   return  (frameBufferLen / pixelsPerScanLine);
 }  /* ReadBufferFrame */
@@ -82,13 +82,13 @@ kkuint32  ScannerFileSimple::ReadBufferFrame ()
 kkint64  ScannerFileSimple::SkipToNextFrame ()
 {
   //int64  byteOffset = osFTELL (file);
-  kkint64  byteOffset = osFTELL (file);
+  kkint64  byteOffset = FTell ();
 
   kkint64  nextFrameByteOffset = byteOffset + frameBufferSize;
-  size_t   returnCd = osFSEEK (file, nextFrameByteOffset - 1, SEEK_SET);
+  size_t   returnCd = FSeek (nextFrameByteOffset - 1);
 
   char buff[10];
-  returnCd = fread (buff, 1, 1, file);
+  returnCd = FRead (buff, 1, 1);
   if  (returnCd < 1)
     return -1;
   else
@@ -293,16 +293,39 @@ void  ScannerFileZLib3BitEncoded::ExpandBufferNoCopy (uchar*&  buffer,
 
 
 
+void  ScannerFileZLib3BitEncoded::DecompressFrame (kkuint32  compLen)
+{
+  const uchar*  compData = MappedBytes (FTell (), compLen);
+  if  (compData)
+  {
+    SkipBytesForward (compLen);
+  }
+  else
+  {
+    if  (compLen > compBufferSize)
+      ExpandBufferNoCopy (compBuffer, compBufferSize, compLen);
+
+    FRead (compBuffer, compLen, 1);
+    if  (FEof ())
+      return;
+    compData = compBuffer;
+  }
+
+  Compressor::Decompress (compData, compLen, frameBuffer, frameBufferSize, frameBufferLen);
+}  /* DecompressFrame */
+
+
+
 kkint64  ScannerFileZLib3BitEncoded::SkipToNextFrame ()
 {
   bool  bufferFrameRead = false;
 
-  while  ((feof (file) == 0)  &&  (!bufferFrameRead))
+  while  ((!FEof ())  &&  (!bufferFrameRead))
   {
     uint8  opCode;
-    fread (&opCode, sizeof (opCode), 1, file);
+    FRead (&opCode, sizeof (opCode), 1);
 
-    if  (feof (file) != 0)
+    if  (FEof ())
       return -1;
 
     switch  (opCode)
@@ -310,8 +333,8 @@ kkint64  ScannerFileZLib3BitEncoded::SkipToNextFrame ()
     case 1:
       {
         uint8  textBlockLen;
-        fread (&textBlockLen, 1, 1, file);
-        if  (feof (file) != 0)
+        FRead (&textBlockLen, 1, 1);
+        if  (FEof ())
           return -1;
         SkipBytesForward (textBlockLen);
         break;
@@ -320,8 +343,8 @@ kkint64  ScannerFileZLib3BitEncoded::SkipToNextFrame ()
     case 2:
       {
         TwoByteRec  textBlockLen;
-        fread (&textBlockLen, sizeof (textBlockLen), 1, file);
-        if  (feof (file) != 0)
+        FRead (&textBlockLen, sizeof (textBlockLen), 1);
+        if  (FEof ())
           return -1;
         kkuint32  len = textBlockLen.intHi * 256 + textBlockLen.intLo;
         SkipBytesForward (len);
@@ -331,8 +354,8 @@ kkint64  ScannerFileZLib3BitEncoded::SkipToNextFrame ()
     case  5:
       {
         TwoByteRec  textBlockLen;
-        fread (&textBlockLen, sizeof (textBlockLen), 1, file);
-        if  (feof (file) != 0)
+        FRead (&textBlockLen, sizeof (textBlockLen), 1);
+        if  (FEof ())
           return -1;
         kkuint32  compBufferLenCode5 = (kkuint32)(textBlockLen.intHi * 256 + textBlockLen.intLo);
         SkipBytesForward (compBufferLenCode5);
@@ -343,8 +366,8 @@ kkint64  ScannerFileZLib3BitEncoded::SkipToNextFrame ()
     case  6:
       {
         ThreeByteRec  textBlockLen;
-        fread (&textBlockLen, sizeof (textBlockLen), 1, file);
-        if  (feof (file) != 0)
+        FRead (&textBlockLen, sizeof (textBlockLen), 1);
+        if  (FEof ())
           return -1;
         kkuint32  compBufferLenCode6 = (kkuint32)(textBlockLen.intByte0 * 256 * 256 +
                                 textBlockLen.intByte1 * 256       +
@@ -357,8 +380,8 @@ kkint64  ScannerFileZLib3BitEncoded::SkipToNextFrame ()
     case  7:
       {
         FourByteRec  textBlockLen;
-        fread (&textBlockLen, sizeof (textBlockLen), 1, file);
-        if  (feof (file) != 0)
+        FRead (&textBlockLen, sizeof (textBlockLen), 1);
+        if  (FEof ())
           return -1;
 
         kkuint32  compBufferLenCode7 = (kkuint32)(textBlockLen.intByte0 * 256 * 256 * 256 +
@@ -372,10 +395,10 @@ kkint64  ScannerFileZLib3BitEncoded::SkipToNextFrame ()
     }
   }
 
-  if  (feof (file) != 0)
+  if  (FEof ())
     return -1;
   else
-    return osFTELL (file);
+    return FTell ();
 
 }  /* SkipToNextFrame */
 
@@ -386,7 +409,7 @@ kkuint32  ScannerFileZLib3BitEncoded::ReadBufferFrame ()
 {
   frameBufferLen = 0;
   frameBufferNextLine = 0;
-  if  (feof (file) != 0)
+  if  (FEof ())
   {
     memset (frameBuffer, 0, frameBufferSize);
     return 0;
@@ -394,15 +417,15 @@ kkuint32  ScannerFileZLib3BitEncoded::ReadBufferFrame ()
 
   bool  bufferFrameRead = false;
 
-  frameBufferFileOffsetLast = osFTELL (file);
+  frameBufferFileOffsetLast = FTell ();
 
-  while  ((!feof (file))  &&  (!bufferFrameRead))
+  while  ((!FEof ())  &&  (!bufferFrameRead))
   {
     uint8  opCode;
 
-    fread (&opCode, sizeof (opCode), 1, file);
+    FRead (&opCode, sizeof (opCode), 1);
 
-    if  (feof (file) != 0)
+    if  (FEof ())
     {
       memset (frameBuffer, 0, frameBufferSize);
       return  0;
@@ -413,10 +436,10 @@ kkuint32  ScannerFileZLib3BitEncoded::ReadBufferFrame ()
     case 1:
       {
         uint8  textBlockLen;
-        fread (&textBlockLen, 1, 1, file);
+        FRead (&textBlockLen, 1, 1);
         char  buff[257];
-        fread (&buff, textBlockLen, 1, file);
-        if  (!feof (file))
+        FRead (&buff, textBlockLen, 1);
+        if  (!FEof ())
         {
           buff[textBlockLen] = 0;
           ReportTextMsg (buff, textBlockLen);
@@ -427,12 +450,12 @@ kkuint32  ScannerFileZLib3BitEncoded::ReadBufferFrame ()
     case 2:
       {
         TwoByteRec  textBlockLen;
-        fread (&textBlockLen, sizeof (textBlockLen), 1, file);
-        if  (feof (file) == 0)
+        FRead (&textBlockLen, sizeof (textBlockLen), 1);
+        if  (!FEof ())
         {
           kkuint32  len = textBlockLen.intHi * 256 + textBlockLen.intLo;
-          fread (compBuffer, len, 1, file);
-          if  (!feof (file))
+          FRead (compBuffer, len, 1);
+          if  (!FEof ())
             ReportTextMsg ((char*)compBuffer, len);
         }
         break;
@@ -441,20 +464,11 @@ kkuint32  ScannerFileZLib3BitEncoded::ReadBufferFrame ()
     case  5:
       {
         TwoByteRec  textBlockLen;
-        fread (&textBlockLen, sizeof (textBlockLen), 1, file);
-        if  (feof (file) == 0)
+        FRead (&textBlockLen, sizeof (textBlockLen), 1);
+        if  (!FEof ())
         {
           kkuint32  compBufferLenCode5 = (kkuint32)(textBlockLen.intHi * 256 + textBlockLen.intLo);
-          if  (compBufferLenCode5 > compBufferSize)
-            ExpandBufferNoCopy (compBuffer, compBufferSize, compBufferLenCode5);
-
-          fread (compBuffer, compBufferLenCode5, 1, file);
-          if  (feof (file) == 0)
-          {
-            Compressor::Decompress (compBuffer, compBufferLenCode5,
-                                    frameBuffer, frameBufferSize, frameBufferLen
-                                   );
-          }
+          DecompressFrame (compBufferLenCode5);
         }
         bufferFrameRead = true;
         break;
@@ -463,22 +477,13 @@ kkuint32  ScannerFileZLib3BitEncoded::ReadBufferFrame ()
     case  6:
       {
         ThreeByteRec  textBlockLen;
-        fread (&textBlockLen, sizeof (textBlockLen), 1, file);
-        if  (!feof (file))
+        FRead (&textBlockLen, sizeof (textBlockLen), 1);
+        if  (!FEof ())
         {
           kkuint32  compBufferLenCode6 = (kkuint32)(textBlockLen.intByte0 * 256 * 256 +
                                   textBlockLen.intByte1 * 256       +
                                   textBlockLen.intByte2);
-          if  (compBufferLenCode6 > compBufferSize)
-            ExpandBufferNoCopy (compBuffer, compBufferSize, compBufferLenCode6);
-
-          fread (compBuffer, compBufferLenCode6, 1, file);
-          if  (feof (file) == 0)
-          {
-            Compressor::Decompress (compBuffer, compBufferLenCode6,
-                                    frameBuffer, frameBufferSize, frameBufferLen
-                                   );
-          }
+          DecompressFrame (compBufferLenCode6);
         }
         bufferFrameRead = true;
         break;
@@ -487,23 +492,14 @@ kkuint32  ScannerFileZLib3BitEncoded::ReadBufferFrame ()
     case  7:
       {
         FourByteRec  textBlockLen;
-        fread (&textBlockLen, sizeof (textBlockLen), 1, file);
-        if  (!feof (file))
+        FRead (&textBlockLen, sizeof (textBlockLen), 1);
+        if  (!FEof ())
         {
           kkuint32  compBufferLenCode7 = (kkuint32)(textBlockLen.intByte0 * 256 * 256 * 256 +
                                   textBlockLen.intByte1 * 256 * 256       +
                                   textBlockLen.intByte2 * 256             +
                                   textBlockLen.intByte3);
-          if  (compBufferLenCode7 > compBufferSize)
-            ExpandBufferNoCopy (compBuffer, compBufferSize, compBufferLenCode7);
-
-          fread (compBuffer, compBufferLenCode7, 1, file);
-          if  (feof (file) == 0)
-          {
-            Compressor::Decompress (compBuffer, compBufferLenCode7,
-                                    frameBuffer, frameBufferSize, frameBufferLen
-                                   );
-          }
+          DecompressFrame (compBufferLenCode7);
         }
         bufferFrameRead = true;
         break;
@@ -513,7 +509,7 @@ kkuint32  ScannerFileZLib3BitEncoded::ReadBufferFrame ()
     frameBufferNextLine = 0;
   }
 
-  frameBufferFileOffsetNext = osFTELL (file);
+  frameBufferFileOffsetNext = FTell ();
 
   return  (frameBufferLen / pixelsPerScanLine);
 }  /* ReadBufferFrame */
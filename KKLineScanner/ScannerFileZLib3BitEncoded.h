@@ -79,6 +79,12 @@ namespace  KKLSC
                               kkuint32   bufferNewSize
                              );
 
+    /**
+     *@brief  Reads the next 'compLen' bytes, a compressed frame, and decompresses them into 'frameBuffer'.
+     *@details  When memory mapped the frame is decompressed directly from the mapped pages.
+     */
+    void  DecompressFrame (kkuint32  compLen);
+
     virtual
       kkint64  SkipToNextFrame ();
     
@@ -10,6 +10,7 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -25,12 +26,14 @@ using namespace  std;
 
 #include "KKBaseTypes.h"
 #include "KKException.h"
+#include "KKThreadPool.h"
 #include "RunLog.h"
 using namespace  KKB;
 
 
 #include "Classifier2.h"
 #include "ClassProb.h"
+#include "FeatureVector.h"
 #include "MLClass.h"
 #include "NormalizationParms.h"
 #include "TrainingProcess2.h"
@@ -49,6 +52,8 @@ Classifier2::Classifier2 (TrainingProcess2Ptr  _trainer,
   log                       (_log),
   mlClasses                 (NULL),
   noiseMLClass              (NULL),
+  predictionModels          (),
+  predictionModelsUnavailable (false),
   subClassifiers            (NULL),
   trainedModel              (NULL),
   trainedModelOldSVM        (NULL),
@@ -112,6 +117,10 @@ Classifier2::~Classifier2 ()
 {
   delete mlClasses;       mlClasses      = NULL;
   delete subClassifiers;  subClassifiers = NULL;
+
+  for  (auto  idx: predictionModels)
+    delete  idx;
+  predictionModels.clear ();
 }
 
 
@@ -400,6 +409,156 @@ MLClassPtr  Classifier2::ClassifyAExample (FeatureVector&  example)
 
 
 
+namespace
+{
+  // Fewer examples than this per thread and starting the thread costs more than it saves.
+  const  kkuint32  minExamplesPerThread = 64;
+
+  // Examples passed to the model at a time;  the kernel values of a block against a few thousand support vectors
+  // stay within the L2 cache.
+  const  kkuint32  examplesPerBlock = 64;
+}
+
+
+
+kkuint32  Classifier2::BuildPredictionModels (kkuint32  numThreads)
+{
+  while  ((!predictionModelsUnavailable)  &&  ((predictionModels.size () + 1) < numThreads))
+  {
+    ModelPtr  m = trainedModel->ShareForPrediction ();
+    if  (!m)
+    {
+      log.Level (50) << "Classifier2::BuildPredictionModels   Model[" << trainedModel->Name () << "] can not be shared between threads;"
+        << "  batch predictions will use " << (predictionModels.size () + 1) << " thread(s)." << endl;
+      predictionModelsUnavailable = true;
+      break;
+    }
+    predictionModels.push_back (m);
+  }
+
+  kkuint32  threadsAvailable = (kkuint32)predictionModels.size () + 1;
+  return  (threadsAvailable < numThreads) ? threadsAvailable : numThreads;
+}  /* BuildPredictionModels */
+
+
+
+void  Classifier2::PredictExamplesInBlocks (FeatureVectorList&  examples,
+                                            kkuint32            numThreads,
+                                            BlockPredictFunc    predict
+                                           )
+{
+  kkuint32  numExamples = (kkuint32)examples.QueueSize ();
+  if  (numExamples < 1)
+    return;
+
+  kkuint32  numBlocks = KKThreadPool::ResolveNumThreads (numThreads);
+  kkuint32  maxUsefulBlocks = (numExamples + minExamplesPerThread - 1) / minExamplesPerThread;
+  if  (numBlocks > maxUsefulBlocks)
+    numBlocks = maxUsefulBlocks;
+
+  if  (numBlocks > 1)
+    numBlocks = BuildPredictionModels (numBlocks);
+
+  log.Level (50) << "Classifier2::PredictExamplesInBlocks   numExamples[" << numExamples << "]  numBlocks[" << numBlocks << "]" << endl;
+
+  vector<KKStr>  blockLogs (numBlocks);
+  kkint32  loggingLevel = log.LoggingLevel ();
+
+  KKThreadPool::ParallelFor (numBlocks, numBlocks, 
+    [this, &examples, &predict, &blockLogs, numBlocks, numExamples, loggingLevel] (kkuint32 blockIdx)
+    {
+      ModelPtr  model = (blockIdx == 0) ? trainedModel : predictionModels[blockIdx - 1];
+      kkuint32  start = (kkuint32)(((kkuint64)numExamples * blockIdx)       / numBlocks);
+      kkuint32  end   = (kkuint32)(((kkuint64)numExamples * (blockIdx + 1)) / numBlocks);
+
+      // When there is only one block we are on the callers thread and can write to 'log' directly.
+      ostringstream  blockLogStream;
+      RunLog  bufferedLog (blockLogStream);
+      bufferedLog.SetLoggingLevel (loggingLevel);
+      RunLog&  blockLog = (numBlocks > 1) ? bufferedLog : log;
+
+      for  (kkuint32 x = start;  x < end;  x += examplesPerBlock)
+        predict (model, x, Min (x + examplesPerBlock, end), blockLog);
+
+      bufferedLog.Flush ();
+      blockLogs[blockIdx] = blockLogStream.str ().c_str ();
+    }
+  );
+
+  for  (auto&  blockLogText: blockLogs)
+  {
+    blockLogText.TrimRight ();
+    if  (!blockLogText.Empty ())
+      log.WriteLine (blockLogText);
+  }
+}  /* PredictExamplesInBlocks */
+
+
+
+void  Classifier2::ClassifyExamples (FeatureVectorList&        examples,
+                                     vector<MLClassPtr>&       predictions,
+                                     kkuint32                  numThreads
+                                    )
+{
+  kkuint32  numExamples = (kkuint32)examples.QueueSize ();
+  predictions.assign (numExamples, NULL);
+
+  if  (subClassifiers)
+  {
+    for  (kkuint32 x = 0;  x < numExamples;  ++x)
+      predictions[x] = ClassifyAExample (examples[x]);
+    return;
+  }
+
+  PredictExamplesInBlocks (examples, numThreads, 
+    [this, &examples, &predictions] (ModelPtr  model,  kkuint32  start,  kkuint32  end,  RunLog&  blockLog)
+    {
+      for  (kkuint32 idx = start;  idx < end;  ++idx)
+      {
+        FeatureVectorPtr  example = examples.IdxToPtr (idx);
+        MLClassPtr  predClass1      = NULL;
+        MLClassPtr  predClass2      = NULL;
+        kkint32     predClass1Votes = -1;
+        kkint32     predClass2Votes = -1;
+        double      knownClassProb  = 0.0;
+        double      predClass1Prob  = 0.0;
+        double      predClass2Prob  = 0.0;
+        kkint32     numOfWinners    = 0;
+        bool        knownClassOneOfTheWinners = false;
+        double      breakTie        = 0.0;
+
+        model->Predict (example, example->MLClass (),
+                        predClass1,      predClass2,
+                        predClass1Votes, predClass2Votes,
+                        knownClassProb,
+                        predClass1Prob,  predClass2Prob,
+                        numOfWinners,
+                        knownClassOneOfTheWinners,
+                        breakTie,
+                        blockLog
+                       );
+
+        // Same rules as 'ClassifyAImageOneLevel'.
+        if  (predClass1 == NULL)
+        {
+          blockLog.Level (-1) << endl << endl 
+                              << "Classifier2::ClassifyExamples   The trainedModel returned back a NULL pointer for predicted class" << endl
+                              << endl;
+          predClass1 = unKnownMLClass;
+        }
+
+        if  (predClass1->UnDefined ())
+          predClass1 = noiseMLClass;
+
+        example->MLClass (predClass1);
+        predictions[idx] = predClass1;
+      }
+    }
+  );
+}  /* ClassifyExamples */
+
+
+
 vector<KKStr>  Classifier2::SupportVectorNames (MLClassPtr  c1,
                                                 MLClassPtr  c2
                                                )
@@ -495,6 +654,37 @@ void  Classifier2::ProbabilitiesByClass (const MLClassList& classes,
 
 
 
+void  Classifier2::ProbabilitiesByClass (const MLClassList&  classes,
+                                         FeatureVectorList&  examples,
+                                         kkint32*            votes,
+                                         double*             probabilities,
+                                         kkuint32            numThreads
+                                        )
+{
+  kkuint32  numClasses = (kkuint32)classes.size ();
+
+  if  (subClassifiers)
+  {
+    kkuint32  numExamples = (kkuint32)examples.QueueSize ();
+    for  (kkuint32 x = 0;  x < numExamples;  ++x)
+      ProbabilitiesByClass (classes, examples.IdxToPtr (x), votes + (kkMemSize)x * numClasses, probabilities + (kkMemSize)x * numClasses);
+    return;
+  }
+
+  PredictExamplesInBlocks (examples, numThreads, 
+    [&examples, &classes, votes, probabilities, numClasses] (ModelPtr  model,  kkuint32  start,  kkuint32  end,  RunLog&  blockLog)
+    {
+      model->ProbabilitiesByClassForBlock (examples, start, end, classes,
+                                           votes         + (kkMemSize)start * numClasses,
+                                           probabilities + (kkMemSize)start * numClasses,
+                                           blockLog
+                                          );
+    }
+  );
+}  /* ProbabilitiesByClass */
+
+
+
 MLClassListPtr  Classifier2::PredictionsThatHaveSubClassifier (ClassProbListPtr  predictions)
 {
   MLClassListPtr  classes = new MLClassList ();
@@ -3,6 +3,9 @@
 
 
 
+#include <functional>
+#include <vector>
+
 #include "Application.h"
 
 
@@ -90,6 +93,22 @@ typedef  TrainingProcess2List*  TrainingProcess2ListPtr;
 
     MLClassPtr            ClassifyAExample    (FeatureVector&  example);
 
+    /**
+     *@brief  Classifies every example in 'examples';  batch version of 'ClassifyAExample (FeatureVector&)'.
+     *@details  The examples are split into one contiguous block per thread.  The first block uses the trained
+     * model;  each of the other blocks uses an instance made by 'Model::ShareForPrediction' the first time it is
+     * needed and kept for later batches.  It shares the trained classifier and has its own work areas.  Models
+     * that can not be shared are run on one thread.  A classifier that has sub-classifiers processes the
+     * examples one at a time on the callers thread.
+     *@param[in,out] examples     Examples to classify; the MLClass of each is set to its prediction the same as 'ClassifyAExample'.
+     *@param[out]    predictions  'predictions[x]' will be the predicted class of 'examples[x]'.
+     *@param[in]     numThreads   Number of threads to use; 0 = one per processor.
+     */
+    void  ClassifyExamples (FeatureVectorList&        examples,
+                            std::vector<MLClassPtr>&  predictions,
+                            kkuint32                  numThreads
+                           );
+
     void  ClassifyAExample (FeatureVector&  example,
                           MLClassPtr&     predClass1,
                           MLClassPtr&     predClass2,
@@ -182,6 +201,23 @@ typedef  TrainingProcess2List*  TrainingProcess2ListPtr;
                                                double*             probabilities
                                               );
 
+
+    /**
+     *@brief  Batch version of 'ProbabilitiesByClass (classes, example, votes, probabilities)'.
+     *@details  The work is divided the same way as 'ClassifyExamples'.
+     *@param classes       [in]  The ordering of each examples 'votes' and 'probabilities' will be dictated by this list.
+     *@param examples      [in]  Feature Vectors to make predictions on.
+     *@param votes         [out] Must be as large as  examples.QueueSize () * classes.size ();  the votes for 'examples[x]' start at 'votes[x * classes.size ()]'.
+     *@param probabilities [out] Laid out the same as 'votes'.
+     *@param numThreads    [in]  Number of threads to use; 0 = one per processor.
+     */
+    void                 ProbabilitiesByClass (const MLClassList&  classes,
+                                               FeatureVectorList&  examples,
+                                               kkint32*            votes,
+                                               double*             probabilities,
+                                               kkuint32            numThreads
+                                              );
+
     
     ClassProbListPtr     ProbabilitiesByClass (FeatureVectorPtr  example);
 
@@ -212,8 +248,28 @@ typedef  TrainingProcess2List*  TrainingProcess2ListPtr;
     typedef  std::pair<Classifier2Ptr,MLClassPtr>      ClassifierClassPair;
 
 
+    /**
+     *@brief  Called by 'PredictExamplesInBlocks' for examples 'start' thru 'end - 1';  'model' is the one that belongs to the thread.
+     *@details  A thread's share of the examples is passed a block at a time so that the model can prepare and predict
+     * a block of examples at once;  see 'Model::ProbabilitiesByClassForBlock'.
+     */
+    typedef  std::function<void (ModelPtr  model,
+                                 kkuint32  start,
+                                 kkuint32  end,
+                                 RunLog&   log
+                                )
+                          >  BlockPredictFunc;
+
+    /** @brief  Makes sure there is a shared instance of 'trainedModel' for every thread after the first; returns the number of threads that can be used. */
+    kkuint32         BuildPredictionModels (kkuint32  numThreads);
+
     void             BuildSubClassifierIndex ();
 
+    void             PredictExamplesInBlocks (FeatureVectorList&  examples,
+                                              kkuint32            numThreads,
+                                              BlockPredictFunc    predict
+                                             );
+
     MLClassPtr  ClassifyAImageOneLevel (FeatureVector&  example);
  
     MLClassPtr  ClassifyAImageOneLevel (FeatureVector&  example,
@@ -268,6 +324,12 @@ typedef  TrainingProcess2List*  TrainingProcess2ListPtr;
                                                *  in mlClasses.
                                                */
 
+    std::vector<ModelPtr>   predictionModels;            /**< Made by 'trainedModel->ShareForPrediction' for the batch prediction methods;
+                                                          * one for every thread after the first.  We own them.
+                                                          */
+
+    bool                    predictionModelsUnavailable; /**< Set when 'trainedModel->ShareForPrediction' returned NULL so we do not keep trying. */
+
     Classifier2ListPtr      subClassifiers;
 
     ModelPtr                trainedModel;
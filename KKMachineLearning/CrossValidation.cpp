@@ -18,6 +18,7 @@ using namespace KKB;
 #include "CrossValidation.h"
 #include "Classifier2.h"
 #include "ConfusionMatrix2.h"
+#include "CrossValidationFoldRunner.h"
 #include "FactoryFVProducer.h"
 #include "FileDesc.h"
 #include "MLClass.h"
@@ -29,6 +30,41 @@ using namespace  KKMLL;
 
 
 
+class  CrossValidation::FoldResults
+{
+public:
+  FoldResults ():
+    foldNum             (0),
+    trainerAborted      (true),
+    duplicateDataCount  (0),
+    trainingTime        (0.0),
+    foldNumSVs          (0),
+    foldTotalNumSVs     (0),
+    numOfSupportVectors (0),
+    testTime            (0.0),
+    numClassified       (0)
+  {}
+
+  kkint32                   foldNum;
+  bool                      trainerAborted;
+  kkint32                   duplicateDataCount;
+  double                    trainingTime;
+  kkint32                   foldNumSVs;
+  kkint32                   foldTotalNumSVs;
+  kkint32                   numOfSupportVectors;
+  double                    testTime;
+
+  kkint32                   numClassified;   /**< Number of entries in the 'xxxHist' vectors that were filled in. */
+  vector<FeatureVectorPtr>  exampleHist;
+  vector<MLClassPtr>        knownClassHist;
+  vector<bool>              knownClassOneOfTheWinnersHist;
+  vector<kkint32>           numOfWinersHist;
+  vector<MLClassPtr>        predictedClassHist;
+  vector<double>            probabilityHist;
+};  /* FoldResults */
+
+
+
 CrossValidation::CrossValidation (TrainingConfiguration2Ptr  _config,
                                   FeatureVectorListPtr       _examples,
                                   MLClassListPtr             _mlClasses,
@@ -54,6 +90,7 @@ CrossValidation::CrossValidation (TrainingConfiguration2Ptr  _config,
    imagesPerClass               (0),
    maxNumOfConflicts            (0),
    numOfFolds                   (_numOfFolds),
+   numOfThreads                 (1),
    numSVs                       (0),
    totalNumSVs                  (0),
    numOfWinnersCounts           (NULL),
@@ -180,63 +217,34 @@ void  CrossValidation::RunCrossValidation (RunLog&  log)
   DeleteAllocatedMemory ();
   AllocateMemory ();
 
-  kkint32  imageCount       = examples->QueueSize ();
-  kkint32  numImagesPerFold = (imageCount + numOfFolds - 1) / numOfFolds;
-  kkint32  firstInGroup     = 0;
-
-  totalPredProb = 0.0;
-
-
-  kkint32  foldNum;
-
-  for  (foldNum = 0;  foldNum < numOfFolds;  foldNum++)
   {
-    kkint32  lastInGroup;
-
-    // If We are doing the last Fold Make sure that we are including all the examples 
-    // that have not been tested.
-    if  (foldNum == (numOfFolds - 1))
-      lastInGroup = imageCount;
-    else
-      lastInGroup = firstInGroup + numImagesPerFold - 1;
-
-
-    log.Level (20) << "Fold [" << (foldNum + 1) << "]  of  [" << numOfFolds << "]" << endl;
+    // Make sure that a Noise class exists before any folds start; 'mlClasses' is shared by all of them.
+    mlClasses->GetNoiseClass ();
+  }
 
-    FeatureVectorListPtr  trainingExamples = examples->ManufactureEmptyList (true);
-    FeatureVectorListPtr  testImages       = examples->ManufactureEmptyList (true);
+  kkint32  imageCount = examples->QueueSize ();
 
-    log.Level (30) << "Fold Num["        << foldNum        << "]   "
-                   << "FirstTestImage["  << firstInGroup   << "]   "
-                   << "LastInGroup["     << lastInGroup    << "]."
-                   << endl;
+  totalPredProb = 0.0;
 
-    for  (kkint32  x = 0; (x < imageCount)  &&  (!cancelFlag); x++)
-    {
-      FeatureVectorPtr  newImage = examples->IdxToPtr (x)->Duplicate ();
-      if  ((x >= firstInGroup)  &&  (x <= lastInGroup))
-      {
-        testImages->PushOnBack (newImage);
-      }
-      else
-      {
-        trainingExamples->PushOnBack (newImage);
-      }
-    }
+  // Each fold fills in its own 'FoldResults' instance;  they are tallied in fold order once complete.
+  vector<FoldResults>  foldResults (numOfFolds);
 
-    log.Level (20) << "Number Of Training Images : " << trainingExamples->QueueSize () << endl;
-    log.Level (20) << "Number Of Test Images     : " << testImages->QueueSize ()     << endl;
+  CrossValidationFoldRunner  foldRunner (examples, numOfFolds, numOfThreads, cancelFlag);
 
-    if  (cancelFlag)
-      break;
-    
-    CrossValidate (testImages, trainingExamples, foldNum, NULL, log);
+  foldRunner.Run 
+      ([this, &foldResults] (kkint32 foldNum, FeatureVectorListPtr testImages, FeatureVectorListPtr trainingExamples, RunLog& foldLog)
+        {
+          TrainAndTestFold (testImages, trainingExamples, foldNum, foldResults[foldNum], foldLog);
+        },
 
-    delete  trainingExamples;  trainingExamples = NULL;
-    delete  testImages;        testImages       = NULL;
+       [this, &foldResults] (kkint32 foldNum, RunLog& foldLog)
+        {
+          TallyFold (foldResults[foldNum], NULL, foldLog);
+          foldResults[foldNum] = FoldResults ();
+        },
 
-    firstInGroup = firstInGroup + numImagesPerFold;
-  }
+       log
+      );
 
   if  (!cancelFlag)
   {
@@ -269,7 +277,14 @@ void  CrossValidation::RunValidationOnly (FeatureVectorListPtr validationData,
   FeatureVectorListPtr  trainingExamples = examples->DuplicateListAndContents ();
   FeatureVectorListPtr  testImages       = validationData->DuplicateListAndContents ();
 
-  CrossValidate (testImages, trainingExamples, 0, classedCorrectly, log);
+  {
+    // Make sure that a Noise class exists.
+    mlClasses->GetNoiseClass ();
+  }
+
+  FoldResults  results;
+  TrainAndTestFold (testImages, trainingExamples, 0, results, log);
+  TallyFold (results, classedCorrectly, log);
 
   if  (testImages->QueueSize () > 0)
     avgPredProb = totalPredProb / testImages->QueueSize ();
@@ -292,16 +307,17 @@ void  CrossValidation::RunValidationOnly (FeatureVectorListPtr validationData,
 
 
 
-void  CrossValidation::CrossValidate (FeatureVectorListPtr   testImages, 
-                                      FeatureVectorListPtr   trainingExamples,
-                                      kkint32                foldNum,
-                                      bool*                  classedCorrectly,
-                                      RunLog&                log
-                                     )
+void  CrossValidation::TrainAndTestFold (FeatureVectorListPtr   testImages, 
+                                         FeatureVectorListPtr   trainingExamples,
+                                         kkint32                foldNum,
+                                         FoldResults&           results,
+                                         RunLog&                log
+                                        )
 {
-  log.Level (20) << "CrossValidation::CrossValidate   FoldNum[" << foldNum  << "]." << endl;
+  log.Level (20) << "CrossValidation::TrainAndTestFold   FoldNum[" << foldNum  << "]." << endl;
 
-  KKStr  statusMessage;
+  results.foldNum = foldNum;
+  results.trainerAborted = true;
 
   TrainingProcess2Ptr  trainer = TrainingProcess2::CreateTrainingProcessFromTrainingExamples  
                             (config, 
@@ -312,30 +328,26 @@ void  CrossValidation::CrossValidate (FeatureVectorListPtr   testImages,
                              log
                             );
   if  (trainer->Abort ())
+  {
+    delete  trainer;
+    trainer = NULL;
     return;
+  }
 
-  duplicateTrainDataCount += trainer->DuplicateDataCount ();
-  trainingTime            += trainer->TrainingTime ();
-
-  kkint32  foldNumSVs = 0;
-  kkint32  foldTotalNumSVs = 0;
-  trainer->SupportVectorStatistics (foldNumSVs, foldTotalNumSVs);
-  numSVs      += foldNumSVs;
-  totalNumSVs += foldTotalNumSVs;
+  results.trainerAborted      = false;
+  results.duplicateDataCount  = trainer->DuplicateDataCount ();
+  results.trainingTime        = trainer->TrainingTime ();
+  results.numOfSupportVectors = trainer->NumOfSupportVectors ();
+  trainer->SupportVectorStatistics (results.foldNumSVs, results.foldTotalNumSVs);
     
   log.Level (20) << "CrossValidate   Creating Classification Object" << endl;
 
   Classifier2  classifier (trainer, log);
-  {
-    // Make sure that a Noise class exists
-    mlClasses->GetNoiseClass ();
-  }
 
   log.Level (20) << "CrossValidate   Classifying Test Images." << endl;
 
   double            breakTie                   = 0.0f;
   FeatureVectorPtr  example                    = NULL;
-  MLClassPtr        knownClass                 = NULL;
   bool              knownClassOneOfTheWinners  = false;
   kkint32           numOfWinners               = 0;
   MLClassPtr        predictedClass             = NULL;
@@ -343,26 +355,23 @@ void  CrossValidation::CrossValidate (FeatureVectorListPtr   testImages,
 
   kkint32  numTestExamples = testImages->QueueSize ();
 
-  kkint32  foldCorrect = 0;
-  kkint32  foldCount   = 0;
+  kkint32  foldCount = 0;
 
-  vector<FeatureVectorPtr>  exampleHist                   (numTestExamples);
-  vector<MLClassPtr>        knownClassHist                (numTestExamples);
-  vector<bool>              knownClassOneOfTheWinnersHist (numTestExamples, false);
-  vector<kkint32>           numOfWinersHist               (numTestExamples, 0);
-  vector<MLClassPtr>        predictedClassHist            (numTestExamples);
-  vector<double>            probabilityHist               (numTestExamples, 0.0f);
+  results.exampleHist.resize                   (numTestExamples, NULL);
+  results.knownClassHist.resize                (numTestExamples, NULL);
+  results.knownClassOneOfTheWinnersHist.resize (numTestExamples, false);
+  results.numOfWinersHist.resize               (numTestExamples, 0);
+  results.predictedClassHist.resize            (numTestExamples, NULL);
+  results.probabilityHist.resize               (numTestExamples, 0.0f);
 
   FeatureVectorList::iterator  fvIDX;
 
-  double  startClassificationTime = osGetSystemTimeUsed ();
+  double  startClassificationTime = osGetElapsedSecs ();
 
   for  (fvIDX = testImages->begin ();  (fvIDX != testImages->end ())  &&  (!cancelFlag);  fvIDX++)
   {
     example = *fvIDX;
 
-    knownClass = example->MLClass ();
-
     predictedClass =  classifier.ClassifyAExample (*example, 
                                                  probability, 
                                                  numOfWinners,
@@ -370,30 +379,61 @@ void  CrossValidation::CrossValidate (FeatureVectorListPtr   testImages,
                                                  breakTie
                                                 );
 
-    exampleHist                   [foldCount] = example;
-    knownClassHist                [foldCount] = knownClass;
-    predictedClassHist            [foldCount] = predictedClass;
-    probabilityHist               [foldCount] = probability;
-    numOfWinersHist               [foldCount] = numOfWinners;
-    knownClassOneOfTheWinnersHist [foldCount] = knownClassOneOfTheWinners;
+    results.exampleHist                   [foldCount] = example;
+    results.knownClassHist                [foldCount] = example->MLClass ();
+    results.predictedClassHist            [foldCount] = predictedClass;
+    results.probabilityHist               [foldCount] = probability;
+    results.numOfWinersHist               [foldCount] = numOfWinners;
+    results.knownClassOneOfTheWinnersHist [foldCount] = knownClassOneOfTheWinners;
 
     foldCount++;
   }
 
-  double  endClassificationTime = osGetSystemTimeUsed ();
-  double  testTimeThisFold = (endClassificationTime - startClassificationTime);
-  testTime += testTimeThisFold;
+  double  endClassificationTime = osGetElapsedSecs ();
+  results.testTime      = (endClassificationTime - startClassificationTime);
+  results.numClassified = foldCount;
+
+  delete  trainer;
+  trainer = NULL;
+
+  log.Level (20) << "CrossValidation::TrainAndTestFold - Done." << endl;
+}  /* TrainAndTestFold */
+
+
+
+void  CrossValidation::TallyFold (const FoldResults&  results,
+                                  bool*               classedCorrectly,
+                                  RunLog&             log
+                                 )
+{
+  if  (results.trainerAborted)
+    return;
+
+  duplicateTrainDataCount += results.duplicateDataCount;
+  trainingTime            += results.trainingTime;
+  numSVs                  += results.foldNumSVs;
+  totalNumSVs             += results.foldTotalNumSVs;
+  testTime                += results.testTime;
+
+  FeatureVectorPtr  example                    = NULL;
+  MLClassPtr        knownClass                 = NULL;
+  bool              knownClassOneOfTheWinners  = false;
+  kkint32           numOfWinners               = 0;
+  MLClassPtr        predictedClass             = NULL;
+  double            probability                = 0.0f;
+
+  kkint32  foldCorrect = 0;
+  kkint32  foldCount   = 0;
 
   // lets update statistics
-  foldCount = 0;
-  for  (foldCount = 0;  (foldCount < numTestExamples)  &&  (!cancelFlag);  foldCount++)
+  for  (foldCount = 0;  (foldCount < results.numClassified)  &&  (!cancelFlag);  foldCount++)
   {
-    example                    = exampleHist                   [foldCount];
-    predictedClass             = predictedClassHist            [foldCount];
-    probability                = probabilityHist               [foldCount];
-    numOfWinners               = numOfWinersHist               [foldCount];
-    knownClass                 = knownClassHist                [foldCount];
-    knownClassOneOfTheWinners  = knownClassOneOfTheWinnersHist [foldCount];
+    example                    = results.exampleHist                   [foldCount];
+    predictedClass             = results.predictedClassHist            [foldCount];
+    probability                = results.probabilityHist               [foldCount];
+    numOfWinners               = results.numOfWinersHist               [foldCount];
+    knownClass                 = results.knownClassHist                [foldCount];
+    knownClassOneOfTheWinners  = results.knownClassOneOfTheWinnersHist [foldCount];
 
 
     totalPredProb += probability;
@@ -439,15 +479,10 @@ void  CrossValidation::CrossValidate (FeatureVectorListPtr   testImages,
   foldAccuracies.push_back  (foldAccuracy);
   foldCounts.push_back      (foldCount);
  
-  supportPoints.push_back   ((float)trainer->NumOfSupportVectors ());
-  trainTimes.push_back      (trainer->TrainingTime ());
-  testTimes.push_back       (testTimeThisFold);
-
-  delete  trainer;
-  trainer = NULL;
-
-  log.Level (20) << "CrossValidation::CrossValidate - Done." << endl;
-}  /* CrossValidate */
+  supportPoints.push_back   ((float)results.numOfSupportVectors);
+  trainTimes.push_back      (results.trainingTime);
+  testTimes.push_back       (results.testTime);
+}  /* TallyFold */
 
 
 
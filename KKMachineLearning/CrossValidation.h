@@ -109,6 +109,15 @@ namespace  KKMLL
 
     void          NumOfFolds (kkint32 _numOfFolds)  {numOfFolds = _numOfFolds;}
 
+    /**
+     *@brief  Number of folds that 'RunCrossValidation' will train and test at the same time.
+     *@details  1 (the default) processes the folds one after another on the calling thread; 0 will use
+     * one thread per processor.  Results are identical regardless of the number of threads; see
+     * CrossValidationFoldRunner.
+     */
+    void          NumOfThreads (kkuint32 _numOfThreads)  {numOfThreads = _numOfThreads;}
+    kkuint32      NumOfThreads () const  {return numOfThreads;}
+
     const
     VectorFloat&  FoldAccuracies          () const {return  foldAccuracies;}
 
@@ -143,14 +152,28 @@ namespace  KKMLL
     double               TrainTimeTotal  () const {return  trainingTime;}
 
   private:
+    /** @brief  Everything learned from training and testing one fold; kept until the fold is tallied. */
+    class  FoldResults;
+    typedef  FoldResults*  FoldResultsPtr;
+
     void  AllocateMemory ();
 
-    void  CrossValidate (FeatureVectorListPtr   testImages, 
-                         FeatureVectorListPtr   trainingExamples,
-                         kkint32                foldNum,
-                         bool*                  classedCorrectly,
-                         RunLog&                log
-                        );
+    /**
+     *@brief  Trains a model on 'trainingExamples' and classifies 'testImages' placing the outcome in 'results'.
+     *@details  Does not modify any data members so that several folds can be processed at the same time.
+     */
+    void  TrainAndTestFold (FeatureVectorListPtr   testImages, 
+                            FeatureVectorListPtr   trainingExamples,
+                            kkint32                foldNum,
+                            FoldResults&           results,
+                            RunLog&                log
+                           );
+
+    /** @brief  Adds the outcome of one fold to the confusion matrices and statistics. */
+    void  TallyFold (const FoldResults&  results,
+                     bool*               classedCorrectly,
+                     RunLog&             log
+                    );
 
     void  DeleteAllocatedMemory ();
 
@@ -171,6 +194,7 @@ namespace  KKMLL
     kkint32                   imagesPerClass;
     kkint32                   maxNumOfConflicts;  /**< Will indicate the number confusionMatrices created in table in cmByNumOfConflicts; */
     kkint32                   numOfFolds;
+    kkuint32                  numOfThreads;
 
     kkint32                   numSVs;             /**< Total Support Vectors Detected. */
 
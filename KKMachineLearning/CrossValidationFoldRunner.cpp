@@ -0,0 +1,186 @@
+#include "FirstIncludes.h"
+#include <stdio.h>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#include "KKBaseTypes.h"
+#include "KKThreadPool.h"
+#include "OSservices.h"
+#include "RunLog.h"
+using namespace KKB;
+
+
+#include "CrossValidationFoldRunner.h"
+#include "FeatureVector.h"
+using namespace  KKMLL;
+
+
+
+CrossValidationFoldRunner::CrossValidationFoldRunner (FeatureVectorListPtr  _examples,
+                                                      kkint32               _numOfFolds,
+                                                      kkuint32              _numOfThreads,
+                                                      VolConstBool&         _cancelFlag
+                                                     ):
+  cancelFlag   (_cancelFlag),
+  examples     (_examples),
+  numOfFolds   (_numOfFolds),
+  numOfThreads (_numOfThreads)
+{
+}
+
+
+
+CrossValidationFoldRunner::~CrossValidationFoldRunner ()
+{
+}
+
+
+
+void  CrossValidationFoldRunner::FoldRange (kkint32   foldNum,
+                                            kkint32&  firstInGroup,
+                                            kkint32&  lastInGroup
+                                           )  const
+{
+  kkint32  imageCount       = examples->QueueSize ();
+  kkint32  numImagesPerFold = (imageCount + numOfFolds - 1) / numOfFolds;
+
+  firstInGroup = foldNum * numImagesPerFold;
+
+  // If We are doing the last Fold Make sure that we are including all the examples
+  // that have not been tested.
+  if  (foldNum == (numOfFolds - 1))
+    lastInGroup = imageCount;
+  else
+    lastInGroup = firstInGroup + numImagesPerFold - 1;
+}  /* FoldRange */
+
+
+
+void  CrossValidationFoldRunner::BuildFoldViews (kkint32               foldNum,
+                                                 FeatureVectorListPtr  testExamples,
+                                                 FeatureVectorListPtr  trainingExamples,
+                                                 RunLog&               log
+                                                )  const
+{
+  kkint32  firstInGroup = 0;
+  kkint32  lastInGroup  = 0;
+  FoldRange (foldNum, firstInGroup, lastInGroup);
+
+  log.Level (30) << "Fold Num["        << foldNum        << "]   "
+                 << "FirstTestImage["  << firstInGroup   << "]   "
+                 << "LastInGroup["     << lastInGroup    << "]."
+                 << endl;
+
+  kkint32  imageCount = examples->QueueSize ();
+  for  (kkint32  x = 0;  x < imageCount;  ++x)
+  {
+    FeatureVectorPtr  example = examples->IdxToPtr (x);
+    if  ((x >= firstInGroup)  &&  (x <= lastInGroup))
+      testExamples->PushOnBack (example);
+    else
+      trainingExamples->PushOnBack (example);
+  }
+}  /* BuildFoldViews */
+
+
+
+void  CrossValidationFoldRunner::Run (TrainAndTestFunc  trainAndTest,
+                                      TallyFunc         tally,
+                                      RunLog&           log
+                                     )
+{
+  kkuint32  threadsToUse = KKThreadPool::ResolveNumThreads (numOfThreads);
+  if  (threadsToUse > (kkuint32)numOfFolds)
+    threadsToUse = (kkuint32)numOfFolds;
+
+  log.Level (20) << "CrossValidationFoldRunner::Run   numOfFolds[" << numOfFolds << "]  threadsToUse[" << threadsToUse << "]" << endl;
+
+  if  (threadsToUse <= 1)
+  {
+    for  (kkint32 foldNum = 0;  (foldNum < numOfFolds)  &&  (!cancelFlag);  ++foldNum)
+    {
+      log.Level (20) << "Fold [" << (foldNum + 1) << "]  of  [" << numOfFolds << "]" << endl;
+
+      FeatureVectorListPtr  trainingExamples = examples->ManufactureEmptyList (false);
+      FeatureVectorListPtr  testExamples     = examples->ManufactureEmptyList (false);
+      BuildFoldViews (foldNum, testExamples, trainingExamples, log);
+
+      log.Level (20) << "Number Of Training Images : " << trainingExamples->QueueSize () << endl;
+      log.Level (20) << "Number Of Test Images     : " << testExamples->QueueSize ()     << endl;
+
+      trainAndTest (foldNum, testExamples, trainingExamples, log);
+
+      delete  trainingExamples;  trainingExamples = NULL;
+      delete  testExamples;      testExamples     = NULL;
+
+      if  (cancelFlag)
+        break;
+
+      tally (foldNum, log);
+    }
+    return;
+  }
+
+  // 'foldCompleted' is not a vector<bool> because each fold's worker writes to its own element and
+  // the bits of a vector<bool> share storage.
+  vector<KKStr>    foldLogs      (numOfFolds);
+  vector<kkint32>  foldCompleted (numOfFolds, 0);
+  kkint32          loggingLevel = log.LoggingLevel ();
+
+  {
+    KKThreadPool  pool ("CrossValidationFoldRunner", threadsToUse);
+
+    for  (kkint32 foldNum = 0;  foldNum < numOfFolds;  ++foldNum)
+    {
+      pool.AddTask ([this, foldNum, loggingLevel, &trainAndTest, &foldLogs, &foldCompleted] ()
+        {
+          if  (cancelFlag)
+            return;
+
+          ostringstream  foldLogStream;
+          RunLog  foldLog (foldLogStream);
+          foldLog.SetLoggingLevel (loggingLevel);
+
+          foldLog.Level (20) << "Fold [" << (foldNum + 1) << "]  of  [" << numOfFolds << "]" << endl;
+
+          FeatureVectorListPtr  trainingExamples = examples->ManufactureEmptyList (false);
+          FeatureVectorListPtr  testExamples     = examples->ManufactureEmptyList (false);
+          BuildFoldViews (foldNum, testExamples, trainingExamples, foldLog);
+
+          foldLog.Level (20) << "Number Of Training Images : " << trainingExamples->QueueSize () << endl;
+          foldLog.Level (20) << "Number Of Test Images     : " << testExamples->QueueSize ()     << endl;
+
+          trainAndTest (foldNum, testExamples, trainingExamples, foldLog);
+
+          delete  trainingExamples;  trainingExamples = NULL;
+          delete  testExamples;      testExamples     = NULL;
+
+          foldLog.Flush ();
+          foldLogs[foldNum] = foldLogStream.str ().c_str ();
+          foldCompleted[foldNum] = (cancelFlag ? 0 : 1);
+        }
+      );
+    }
+
+    pool.WaitForAllTasks ();
+  }
+
+  for  (kkint32 foldNum = 0;  foldNum < numOfFolds;  ++foldNum)
+  {
+    if  (foldCompleted[foldNum] == 0)
+      break;
+
+    KKStr&  foldLogText = foldLogs[foldNum];
+    foldLogText.TrimRight ();
+    if  (!foldLogText.Empty ())
+      log.WriteLine (foldLogText);
+
+    tally (foldNum, log);
+  }
+}  /* Run */
@@ -0,0 +1,105 @@
+#ifndef  _CROSSVALIDATIONFOLDRUNNER_
+#define  _CROSSVALIDATIONFOLDRUNNER_
+
+/**
+ @class  KKMLL::CrossValidationFoldRunner
+ @brief  Partitions a list of examples into folds and runs the train/test step of each fold, optionally in parallel.
+ @author  Kurt Kramer
+ @details
+   Used by CrossValidation, CrossValidationVoting and indirectly CrossValidationMxN.  For each fold two
+   FeatureVectorList views are built that point into the shared 'examples' list; no examples are duplicated.
+   Anything that needs to modify an example, such as normalization, must make its own copy; Model::TrainModel
+   already does this when it does not own its training data.
+
+   The caller supplies two functions:
+   @code
+     trainAndTest  Trains a model on the training view and classifies the test view; may run on a worker thread
+                   so it must only write into storage that belongs to that fold.
+     tally         Merges the results of a fold into the callers statistics; always called on the callers
+                   thread and always in ascending fold order.
+   @endcode
+   Because results are always merged in fold order the floating point accumulation is performed in the same
+   sequence regardless of the number of threads used, so a parallel run produces the same results as a serial
+   one.  Log messages written by a fold while running on a worker thread are buffered and written to the
+   callers log just before that fold is tallied.
+
+   The one exception is a model whose training draws from the process wide 'rand ()' sequence, such as the
+   internal cross validation SVM289_MFS (ModelSvmBase) performs for probability estimates; with more than one
+   thread the order the folds consume that sequence is not fixed.
+
+   Train and test times of a fold are measured in wall clock seconds ('osGetElapsedSecs');  process CPU time
+   would include the work of the folds running alongside it.
+ */
+
+#include  <functional>
+
+#include  "KKBaseTypes.h"
+#include  "RunLog.h"
+
+
+namespace  KKMLL
+{
+  #ifndef  _FeatureVector_Defined_
+  class  FeatureVectorList;
+  typedef  FeatureVectorList*  FeatureVectorListPtr;
+  #endif
+
+
+  class  CrossValidationFoldRunner
+  {
+  public:
+    typedef  std::function<void (kkint32               foldNum,
+                                 FeatureVectorListPtr  testExamples,
+                                 FeatureVectorListPtr  trainingExamples,
+                                 RunLog&               foldLog
+                                )
+                          >  TrainAndTestFunc;
+
+    typedef  std::function<void (kkint32  foldNum, RunLog&  log)>  TallyFunc;
+
+    /**
+     *@param[in]  _examples    Examples to be partitioned; will not be modified and must not change while 'Run' is executing.
+     *@param[in]  _numOfFolds  Number of folds to partition '_examples' into.
+     *@param[in]  _numOfThreads Number of folds to process at the same time; 1 = serial, 0 = one per processor.
+     *@param[in]  _cancelFlag  Monitored between folds.
+     */
+    CrossValidationFoldRunner (FeatureVectorListPtr  _examples,
+                               kkint32               _numOfFolds,
+                               kkuint32              _numOfThreads,
+                               VolConstBool&         _cancelFlag
+                              );
+
+    ~CrossValidationFoldRunner ();
+
+    /** @brief  Returns the range of example indexes, inclusive, that make up the test data for 'foldNum'. */
+    void  FoldRange (kkint32   foldNum,
+                     kkint32&  firstInGroup,
+                     kkint32&  lastInGroup
+                    )  const;
+
+    /**
+     *@brief  Runs 'trainAndTest' for every fold followed by 'tally' in fold order.
+     *@details  If the cancel flag is set folds that have not started yet are skipped and only folds
+     * that completed before the first skipped fold are tallied.
+     */
+    void  Run (TrainAndTestFunc  trainAndTest,
+               TallyFunc         tally,
+               RunLog&           log
+              );
+
+  private:
+    void  BuildFoldViews (kkint32               foldNum,
+                          FeatureVectorListPtr  testExamples,
+                          FeatureVectorListPtr  trainingExamples,
+                          RunLog&               log
+                         )  const;
+
+    VolConstBool&         cancelFlag;
+    FeatureVectorListPtr  examples;
+    kkint32               numOfFolds;
+    kkuint32              numOfThreads;
+  };  /* CrossValidationFoldRunner */
+
+}  /* namespace  KKMLL */
+
+#endif
@@ -37,6 +37,7 @@ CrossValidationMxN::CrossValidationMxN (TrainingConfiguration2Ptr _config,
   meanConfusionMatrix  (NULL),
   numOfFolds           (_numOfFolds),
   numOfOrderings       (_numOfOrderings),
+  numOfThreads         (1),
   orderings            (NULL),
   weOwnOrderings       (false),
   
@@ -68,6 +69,7 @@ CrossValidationMxN::CrossValidationMxN (TrainingConfiguration2Ptr _config,
   meanConfusionMatrix  (NULL),
   numOfFolds           (_orderings->NumOfFolds ()),
   numOfOrderings       (_orderings->NumOfOrderings ()),
+  numOfThreads         (1),
   orderings            (_orderings),
   weOwnOrderings       (false),
   trainingTimes        (),
@@ -147,6 +149,7 @@ void  CrossValidationMxN::RunValidations (RunLog&  log)
                                                   cancelFlag
                                                  );
 
+    cv->NumOfThreads (numOfThreads);
     cv->RunCrossValidation (log);
 
     accuracies.push_back    (cv->Accuracy       ());
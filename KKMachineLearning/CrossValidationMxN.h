@@ -93,8 +93,15 @@ namespace KKMLL
 
     void  RunValidations (RunLog&  log);
 
+    /**
+     *@brief  Number of folds within each ordering that are trained and tested at the same time.
+     *@details  Passed on to each CrossValidation instance; 1 (the default) = serial, 0 = one per processor.
+     */
+    void  NumOfThreads (kkuint32 _numOfThreads)  {numOfThreads = _numOfThreads;}
+
     // Access Methods
     kkint32               NumOfOrderings       () const {return numOfOrderings;}
+    kkuint32              NumOfThreads         () const {return numOfThreads;}
     kkint32               NumOfFolds           () const {return numOfOrderings;}
 
     const  VectorFloat&   Accuracies           () const {return accuracies;}
@@ -125,6 +132,7 @@ namespace KKMLL
     ConfusionMatrix2Ptr       meanConfusionMatrix;
     kkuint32                  numOfFolds;
     kkuint32                  numOfOrderings;
+    kkuint32                  numOfThreads;
     OrderingsPtr              orderings;
     bool                      weOwnOrderings;
 
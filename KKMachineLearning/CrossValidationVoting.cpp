@@ -19,6 +19,7 @@ using namespace  KKB;
 #include "CrossValidationVoting.h"
 #include "Classifier2.h"
 #include "ConfusionMatrix2.h"
+#include "CrossValidationFoldRunner.h"
 #include "FileDesc.h"
 #include "MLClass.h"
 #include "FeatureVector.h"
@@ -28,6 +29,30 @@ using namespace  KKMLL;
 
 
 
+class  CrossValidationVoting::FoldResults
+{
+public:
+  FoldResults ():
+    foldNum             (0),
+    trainingTime        (0.0),
+    numOfSupportVectors (0),
+    classificationTime  (0.0)
+  {}
+
+  kkint32                   foldNum;
+  double                    trainingTime;
+  kkint32                   numOfSupportVectors;
+  double                    classificationTime;
+
+  vector<FeatureVectorPtr>  exampleHist;
+  vector<MLClassPtr>        predictedClassHist;
+  vector<double>            probabilityHist;
+  vector<kkint32>           numOfWinnersHist;
+  vector<bool>              knownClassOneOfTheWinnersHist;
+};  /* FoldResults */
+
+
+
 CrossValidationVoting::CrossValidationVoting (TrainingConfiguration2ListPtr  _configs,
                                               FeatureVectorListPtr           _examples,
                                               MLClassListPtr                 _mlClasses,
@@ -36,6 +61,7 @@ CrossValidationVoting::CrossValidationVoting (TrainingConfiguration2ListPtr  _co
                                               FileDescPtr                    _fileDesc
                                              ):
 
+   cancelFlag                   (false),
    configs                      (_configs),
    featuresAreAlreadyNormalized (_featuresAreAlreadyNormalized),
    fileDesc                     (_fileDesc),
@@ -48,6 +74,7 @@ CrossValidationVoting::CrossValidationVoting (TrainingConfiguration2ListPtr  _co
    examplesPerClass             (0),
    maxNumOfConflicts            (0),
    numOfFolds                   (_numOfFolds),
+   numOfThreads                 (1),
    numOfSupportVectors          (0),
    numOfWinnersCounts           (NULL),
    numOfWinnersCorrects         (NULL),
@@ -159,52 +186,29 @@ void  CrossValidationVoting::RunCrossValidation (RunLog&  log)
   DeleteAllocatedMemory ();
   AllocateMemory ();
 
-  kkint32  imageCount       = examples->QueueSize ();
-  kkint32  numImagesPerFold = (imageCount + numOfFolds - 1) / numOfFolds;
-  kkint32  firstInGroup     = 0;
-
-  kkint32  foldNum;
-
-  for  (foldNum = 0;  foldNum < numOfFolds;  foldNum++)
   {
-    kkint32  lastInGroup;
-
-    // If We are doing the last Fold Make sure that we are including all the examples 
-    // that have not been tested.
-    if  (foldNum == (numOfFolds - 1))
-      lastInGroup = imageCount;
-    else
-      lastInGroup = firstInGroup + numImagesPerFold - 1;
-
-
-    cout << "Fold [" << (foldNum + 1) << "]  of  [" << numOfFolds << "]" << endl;
+    // Force the creation of a noise class before any folds start;  'mlClasses' is shared by all of them.
+    mlClasses->GetNoiseClass ();
+  }
 
-    FeatureVectorListPtr  trainingExamples = examples->ManufactureEmptyList (true);
-    FeatureVectorListPtr  testImages       = examples->ManufactureEmptyList (true);
+  vector<FoldResults>  foldResults (numOfFolds);
 
-    log.Level (30) << "Fold Num["        << foldNum        << "]   "
-                   << "FirstTestImage["  << firstInGroup   << "]   "
-                   << "LastInGroup["     << lastInGroup    << "]."
-                   << endl;
+  CrossValidationFoldRunner  foldRunner (examples, numOfFolds, numOfThreads, cancelFlag);
 
-    for  (kkint32  x = 0; x < imageCount; x++)
-    {
-      FeatureVectorPtr  newImage = examples->IdxToPtr (x)->Duplicate ();
-      if  ((x >= firstInGroup)  &&  (x <= lastInGroup))
-        testImages->PushOnBack (newImage);
-      else
-        trainingExamples->PushOnBack (newImage);
-    }
-
-    cout << "Number Of Training Images : " << trainingExamples->QueueSize () << endl;
-    cout << "Number Of Test Images     : " << testImages->QueueSize ()     << endl;
+  foldRunner.Run 
+      ([this, &foldResults] (kkint32 foldNum, FeatureVectorListPtr testImages, FeatureVectorListPtr trainingExamples, RunLog& foldLog)
+        {
+          TrainAndTestFold (testImages, trainingExamples, foldNum, foldResults[foldNum], foldLog);
+        },
 
-    CrossValidate (testImages, trainingExamples, foldNum, NULL, log);
+       [this, &foldResults] (kkint32 foldNum, RunLog& foldLog)
+        {
+          TallyFold (foldResults[foldNum], NULL, foldLog);
+          foldResults[foldNum] = FoldResults ();
+        },
 
-    delete  trainingExamples;  trainingExamples = NULL;
-    delete  testImages;        testImages       = NULL;
-    firstInGroup = firstInGroup + numImagesPerFold;
-  }
+       log
+      );
 }  /* RunCrossValidationVoting */
 
 
@@ -225,7 +229,14 @@ void  CrossValidationVoting::RunValidationOnly (FeatureVectorListPtr  validation
   FeatureVectorListPtr  trainingExamples = examples->DuplicateListAndContents ();
   FeatureVectorListPtr  testImages       = validationData->DuplicateListAndContents ();
 
-  CrossValidate (testImages, trainingExamples, 0, classedCorrectly, log);
+  {
+    // Force the creation of a noise class
+    mlClasses->GetNoiseClass ();
+  }
+
+  FoldResults  results;
+  TrainAndTestFold (testImages, trainingExamples, 0, results, log);
+  TallyFold (results, classedCorrectly, log);
 
   delete  trainingExamples;
   delete  testImages;
@@ -233,18 +244,19 @@ void  CrossValidationVoting::RunValidationOnly (FeatureVectorListPtr  validation
 
 
 
-void  CrossValidationVoting::CrossValidate (FeatureVectorListPtr   testImages, 
-                                            FeatureVectorListPtr   trainingExamples,
-                                            kkint32                foldNum,
-                                            bool*                  classedCorrectly,
-                                            RunLog&                log
-                                           )
+void  CrossValidationVoting::TrainAndTestFold (FeatureVectorListPtr   testImages, 
+                                               FeatureVectorListPtr   trainingExamples,
+                                               kkint32                foldNum,
+                                               FoldResults&           results,
+                                               RunLog&                log
+                                              )
 {
-  log.Level (20) << "CrossValidationVoting::CrossValidate   FoldNum[" << foldNum  << "]." << endl;
+  log.Level (20) << "CrossValidationVoting::TrainAndTestFold   FoldNum[" << foldNum  << "]." << endl;
+
+  results.foldNum = foldNum;
 
   kkuint32  numOfClasses = mlClasses->QueueSize ();
 
-  bool   cancelFlag = false;
   KKStr  statusMessage;
 
   vector<TrainingProcess2Ptr>  trainers;
@@ -264,8 +276,8 @@ void  CrossValidationVoting::CrossValidate (FeatureVectorListPtr   testImages,
                                        log
                                       );
 
-    trainingTime         += trainer->TrainingTime ();
-    numOfSupportVectors  += trainer->NumOfSupportVectors ();
+    results.trainingTime         += trainer->TrainingTime ();
+    results.numOfSupportVectors  += trainer->NumOfSupportVectors ();
 
     log.Level (20) << "CrossValidate   Creating Classification Object" << endl;
 
@@ -275,27 +287,16 @@ void  CrossValidationVoting::CrossValidate (FeatureVectorListPtr   testImages,
     classifiers.push_back (classifier);
   }
 
-  {
-    // Force the creation of a noise class
-    mlClasses->GetNoiseClass ();
-  }
-
   FeatureVectorList::iterator  imageIDX = testImages->begin ();
 
   double   probability;
 
-  kkint32  foldCorrect = 0;
-
-  kkint32  foldCount = 0;
-
   log.Level (20) << "CrossValidate   Classifying Test Images." << endl;
 
-  double  startClassificationTime = osGetSystemTimeUsed ();
+  double  startClassificationTime = osGetElapsedSecs ();
 
   for  (imageIDX = testImages->begin (); imageIDX != testImages->end (); imageIDX++)
   {
-    MLClassPtr  knownClass = (*imageIDX)->MLClass ();
-
     kkint32     numOfWinners              = 0;
     bool        knownClassOneOfTheWinners = false;
     MLClassPtr  predictedClass            = NULL;
@@ -381,16 +382,59 @@ void  CrossValidationVoting::CrossValidate (FeatureVectorListPtr   testImages,
       probability    = probTable[winnerIdx];
     }
 
+    results.exampleHist.push_back                   (*imageIDX);
+    results.predictedClassHist.push_back            (predictedClass);
+    results.probabilityHist.push_back               (probability);
+    results.numOfWinnersHist.push_back              (numOfWinners);
+    results.knownClassOneOfTheWinnersHist.push_back (knownClassOneOfTheWinners);
+  }
+
+  double  endClassificationTime = osGetElapsedSecs ();
+  results.classificationTime = (endClassificationTime - startClassificationTime);
+
+  for  (kkuint32 idx = 0;  idx < trainers.size ();  ++idx)
+  {delete  trainers[idx];  trainers[idx] = NULL;}
+
+  for  (kkuint32 idx = 0;  idx < classifiers.size ();  ++idx)
+  {delete  classifiers[idx];  classifiers[idx] = NULL;}
+
+  log.Level (20) << "CrossValidationVoting::TrainAndTestFold - Done." << endl;
+}  /* TrainAndTestFold */
+
+
+
+void  CrossValidationVoting::TallyFold (const FoldResults&  results,
+                                        bool*               classedCorrectly,
+                                        RunLog&             log
+                                       )
+{
+  trainingTime        += results.trainingTime;
+  numOfSupportVectors += results.numOfSupportVectors;
+  classificationTime  += results.classificationTime;
+
+  kkint32  foldCorrect = 0;
+
+  kkint32  foldCount = 0;
+
+  for  (foldCount = 0;  foldCount < (kkint32)results.exampleHist.size ();  ++foldCount)
+  {
+    FeatureVectorPtr  example                   = results.exampleHist                   [foldCount];
+    MLClassPtr        knownClass                = example->MLClass ();
+    MLClassPtr        predictedClass            = results.predictedClassHist            [foldCount];
+    double            probability               = results.probabilityHist               [foldCount];
+    kkint32           numOfWinners              = results.numOfWinnersHist              [foldCount];
+    bool              knownClassOneOfTheWinners = results.knownClassOneOfTheWinnersHist [foldCount];
+
     confusionMatrix->Increment (knownClass, 
                                 predictedClass, 
-                                (kkint32)(*imageIDX)->OrigSize (), 
+                                (kkint32)example->OrigSize (), 
                                 probability,
                                 log
                                );
 
     cmByNumOfConflicts[numOfWinners]->Increment (knownClass, 
                                                  predictedClass, 
-                                                 (kkint32)(*imageIDX)->OrigSize (), 
+                                                 (kkint32)example->OrigSize (), 
                                                  probability,
                                                  log
                                                 );
@@ -415,30 +459,16 @@ void  CrossValidationVoting::CrossValidate (FeatureVectorListPtr   testImages,
     log.Level (50) << "CrossValidate - Known Class["      << knownClass->Name ()     << "]  "
                    <<                 "Predicted Class["  << predictedClass->Name () << "]."
                    << endl;
-
-    foldCount++;
   }
 
-  double  endClassificationTime = osGetSystemTimeUsed ();
-  classificationTime += (endClassificationTime - startClassificationTime);
-
   float  foldAccuracy = 0.0;
 
   if  (foldCount > 0)
     foldAccuracy = 100.0f * (float)foldCorrect / (float)foldCount;
 
-  foldAccuracies [foldNum] = foldAccuracy;
-  foldCounts     [foldNum] = foldCount;
-
-
-  for  (kkuint32 idx = 0;  idx < trainers.size ();  ++idx)
-  {delete  trainers[idx];  trainers[idx] = NULL;}
-
-  for  (kkuint32 idx = 0;  idx < classifiers.size ();  ++idx)
-  {delete  classifiers[idx];  classifiers[idx] = NULL;}
-
-  log.Level (20) << "CrossValidationVoting::CrossValidate - Done." << endl;
-}  /* CrossValidate */
+  foldAccuracies [results.foldNum] = foldAccuracy;
+  foldCounts     [results.foldNum] = foldCount;
+}  /* TallyFold */
 
 
 
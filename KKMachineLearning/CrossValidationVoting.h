@@ -83,19 +83,33 @@ namespace  KKMLL
     kkint32 NumOfSupportVectors       ()  const {return  numOfSupportVectors;}
     double  TrainingTime              ()  const {return  trainingTime;}
 
+    /** @brief  Number of folds trained and tested at the same time; 1 (the default) = serial, 0 = one per processor. */
+    void      NumOfThreads (kkuint32 _numOfThreads)  {numOfThreads = _numOfThreads;}
+    kkuint32  NumOfThreads ()  const  {return numOfThreads;}
+
   private:
+    /** @brief  Votes cast for each test example of a fold; kept until the fold is tallied. */
+    class  FoldResults;
+
     void  AllocateMemory ();
 
-    void  CrossValidate (FeatureVectorListPtr   testImages, 
-                         FeatureVectorListPtr   trainingExamples,
-                         kkint32                foldNum,
-                         bool*                  classedCorrectly,
-                         RunLog&                log
-                        );
+    /** @brief  Trains one classifier per configuration and votes on each test example; does not modify any data members. */
+    void  TrainAndTestFold (FeatureVectorListPtr   testImages, 
+                            FeatureVectorListPtr   trainingExamples,
+                            kkint32                foldNum,
+                            FoldResults&           results,
+                            RunLog&                log
+                           );
+
+    void  TallyFold (const FoldResults&  results,
+                     bool*               classedCorrectly,
+                     RunLog&             log
+                    );
 
     void  DeleteAllocatedMemory ();
 
 
+    bool                          cancelFlag;
     TrainingConfiguration2ListPtr configs;
     bool                          featuresAreAlreadyNormalized;
     FileDescPtr                   fileDesc;
@@ -108,6 +122,7 @@ namespace  KKMLL
     kkint32                       examplesPerClass;
     kkint32                       maxNumOfConflicts;  /**< Will indicate the number confusionMatrices created in table in cmByNumOfConflicts; */
     kkint32                       numOfFolds;
+    kkuint32                      numOfThreads;
     kkint32                       numOfSupportVectors;
     kkint32*                      numOfWinnersCounts;
     kkint32*                      numOfWinnersCorrects;
@@ -1,5 +1,11 @@
 #include "FirstIncludes.h"
 #include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <iostream>
 #include <fstream>
@@ -7,6 +13,8 @@
 using namespace std;
 
 #include "KKBaseTypes.h"
+#include "KKException.h"
+#include "KKThreadPool.h"
 #include "Option.h"
 #include "OSservices.h"
 using namespace KKB;
@@ -14,8 +22,6 @@ using namespace KKB;
 #include "DuplicateImages.h"
                
 #include "FeatureVector.h"
-#include "ImageFeaturesNameIndexed.h"
-#include "ImageFeaturesDataIndexed.h"
 using namespace  KKMLL;
 
 
@@ -26,10 +32,9 @@ DuplicateImages::DuplicateImages (FeatureVectorListPtr  _examples,
    duplicateDataCount (0),
    duplicateNameCount (0),
    dupExamples        (new DuplicateImageList (true)),
-   featureDataTree    (new ImageFeaturesDataIndexed ()),
    fileDesc           (NULL),
-   log                (_log),
-   nameTree           (new ImageFeaturesNameIndexed ())
+   indexShards        (numIndexShards),
+   log                (_log)
 
 {
   if  (!_examples)
@@ -51,10 +56,9 @@ DuplicateImages::DuplicateImages (FileDescConstPtr _fileDesc,
    duplicateDataCount (0),
    duplicateNameCount (0),
    dupExamples        (new DuplicateImageList (true)),
-   featureDataTree    (new ImageFeaturesDataIndexed ()),
    fileDesc           (_fileDesc),
-   log                (_log),
-   nameTree           (new ImageFeaturesNameIndexed ())
+   indexShards        (numIndexShards),
+   log                (_log)
 
 {
 }
@@ -64,8 +68,6 @@ DuplicateImages::DuplicateImages (FileDescConstPtr _fileDesc,
 
 DuplicateImages::~DuplicateImages(void)
 {
-  delete  nameTree;         nameTree        = NULL;
-  delete  featureDataTree;  featureDataTree = NULL;
   delete  dupExamples;      dupExamples     = NULL;
 }
 
@@ -73,11 +75,19 @@ DuplicateImages::~DuplicateImages(void)
 
 bool  DuplicateImages::ExampleInDetector (FeatureVectorPtr  fv)
 {
-  if  (nameTree->GetEqual (fv->ExampleFileName ()) != NULL)
+  std::string  name = fv->ExampleFileName ().Str ();
+  const IndexShard&  nameShard = indexShards[std::hash<std::string> () (name) % numIndexShards];
+  if  (nameShard.byRootName.find (name) != nameShard.byRootName.end ())
     return true;
 
-  if  (featureDataTree->GetEqual (fv) != NULL)
-    return true;
+  size_t  hash = FeatureDataHash (*fv);
+  const IndexShard&  dataShard = indexShards[hash % numIndexShards];
+  auto  range = dataShard.byFeatureData.equal_range (hash);
+  for  (auto idx = range.first;  idx != range.second;  ++idx)
+  {
+    if  (SameFeatureData (*fv, *(idx->second)))
+      return true;
+  }
 
   return false;
 }  /* ExampleInDetector */
@@ -99,6 +109,74 @@ bool   DuplicateImages::AddExamples (FeatureVectorListPtr  examples)
 
 
 
+size_t  DuplicateImages::FeatureDataHash (const FeatureVector&  example)
+{
+  // FNV-1a over the bits of each feature.
+  const float*  featureData = example.FeatureDataConst ();
+  kkuint64  hash = 14695981039346656037ULL;
+  for  (kkuint32 x = 0;  x < example.NumOfFeatures ();  ++x)
+  {
+    float  f = featureData[x];
+    if  (f == 0.0f)
+      f = 0.0f;
+    else if  (std::isnan (f))
+      f = std::numeric_limits<float>::quiet_NaN ();
+
+    kkuint32  bits = 0;
+    memcpy (&bits, &f, sizeof (bits));
+    hash = (hash ^ bits) * 1099511628211ULL;
+  }
+  return  (size_t)hash;
+}  /* FeatureDataHash */
+
+
+
+bool  DuplicateImages::SameFeatureData (const FeatureVector&  left,
+                                        const FeatureVector&  right
+                                       )
+{
+  const float*  f1 = left.FeatureDataConst ();
+  const float*  f2 = right.FeatureDataConst ();
+
+  for  (kkuint32 x = 0;  x < left.NumOfFeatures ();  x++)
+  {
+    if  ((f1[x] != f2[x])  &&  !(std::isnan (f1[x])  &&  std::isnan (f2[x])))
+      return false;
+  }
+  return true;
+}  /* SameFeatureData */
+
+
+
+FeatureVectorPtr  DuplicateImages::FindOrAddFeatureData (FeatureVectorPtr  example,
+                                                         size_t            hash
+                                                        )
+{
+  IndexShard&  shard = indexShards[hash % numIndexShards];
+  auto  range = shard.byFeatureData.equal_range (hash);
+  for  (auto idx = range.first;  idx != range.second;  ++idx)
+  {
+    if  (SameFeatureData (*example, *(idx->second)))
+      return  idx->second;
+  }
+
+  shard.byFeatureData.insert (pair<size_t, FeatureVectorPtr> (hash, example));
+  return  NULL;
+}  /* FindOrAddFeatureData */
+
+
+
+FeatureVectorPtr  DuplicateImages::FindOrAddRootName (FeatureVectorPtr    example,
+                                                      const std::string&  rootName,
+                                                      size_t              hash
+                                                     )
+{
+  IndexShard&  shard = indexShards[hash % numIndexShards];
+  auto  result = shard.byRootName.insert (pair<std::string, FeatureVectorPtr> (rootName, example));
+  return  result.second ? NULL : result.first->second;
+}  /* FindOrAddRootName */
+
+
 
 /**
  *@brief Will add one more example to list and if it turns out to be a duplicate will return pointer to a "DuplicateImage" structure
@@ -106,22 +184,29 @@ bool   DuplicateImages::AddExamples (FeatureVectorListPtr  examples)
  */
 DuplicateImagePtr  DuplicateImages::AddSingleExample (FeatureVectorPtr  example)
 {
-  DuplicateImagePtr dupExample = NULL;
-
   FeatureVectorPtr    existingNameExample = NULL;
 
   const KKStr&  imageFileName = example->ExampleFileName ();
   if  (!imageFileName.Empty ())
   {
-    existingNameExample = nameTree->GetEqual (osGetRootName (example->ExampleFileName ()));
-    if  (!existingNameExample)
-      nameTree->RBInsert (example);
+    std::string  rootName = osGetRootName (imageFileName).Str ();
+    existingNameExample = FindOrAddRootName (example, rootName, std::hash<std::string> () (rootName));
   }
 
-  FeatureVectorPtr  existingDataExample = featureDataTree->GetEqual (example);
-  if  (!existingDataExample)
-    featureDataTree->RBInsert (example);
-  
+  FeatureVectorPtr  existingDataExample = FindOrAddFeatureData (example, FeatureDataHash (*example));
+
+  return  RecordDuplicate (example, existingNameExample, existingDataExample);
+}  /* AddSingleExample */
+
+
+
+DuplicateImagePtr  DuplicateImages::RecordDuplicate (FeatureVectorPtr  example,
+                                                     FeatureVectorPtr  existingNameExample,
+                                                     FeatureVectorPtr  existingDataExample
+                                                    )
+{
+  DuplicateImagePtr dupExample = NULL;
+
   if  ((existingNameExample)  ||  (existingDataExample))
   {
     duplicateCount++;
@@ -132,11 +217,11 @@ DuplicateImagePtr  DuplicateImages::AddSingleExample (FeatureVectorPtr  example)
       if  (!dupExample)
       {
         dupExample = new DuplicateImage (fileDesc, existingNameExample, example);
-        dupExamples->PushOnBack (dupExample);
+        dupExamples->AddDuplicateSet (dupExample);
       }
       else
       {
-        dupExample->AddADuplicate (example);
+        dupExamples->AddToDuplicateSet (dupExample, example);
       }
     }
     
@@ -149,18 +234,18 @@ DuplicateImagePtr  DuplicateImages::AddSingleExample (FeatureVectorPtr  example)
         if  (!dupExample)
         {
           dupExample = new DuplicateImage (fileDesc, existingDataExample, example);
-          dupExamples->PushOnBack (dupExample);
+          dupExamples->AddDuplicateSet (dupExample);
         }
         else
         {
-          dupExample->AddADuplicate (example);
+          dupExamples->AddToDuplicateSet (dupExample, example);
         }
       }
     }
   }
 
   return dupExample;
-}  /* AddSingleExample */
+}  /* RecordDuplicate */
 
 
 
@@ -169,11 +254,63 @@ void  DuplicateImages::FindDuplicates (FeatureVectorListPtr  examples)
   if  (!examples)
     return;
 
-  for  (auto idx: *examples)
+  vector<FeatureVectorPtr>  list (examples->begin (), examples->end ());
+  kkuint32  count = (kkuint32)list.size ();
+
+  // Keys are computed on all threads;  then each shard is filled by one thread in list order, which finds
+  // the same first example for every key as adding them one at a time.
+  vector<size_t>       dataHashes (count, 0);
+  vector<size_t>       nameHashes (count, 0);
+  vector<std::string>  rootNames  (count);
+  vector<bool>         hasName    (count, false);
+
+  kkuint32  numThreads = KKThreadPool::ResolveNumThreads (0);
+  if  (count < 1000)
+    numThreads = 1;
+
+  KKThreadPool::ParallelFor (numThreads, numThreads, [&](kkuint32 threadIdx)
+    {
+      kkuint32  start = (kkuint32)(((kkuint64)count * threadIdx)       / numThreads);
+      kkuint32  end   = (kkuint32)(((kkuint64)count * (threadIdx + 1)) / numThreads);
+      for  (kkuint32 x = start;  x < end;  ++x)
+      {
+        dataHashes[x] = FeatureDataHash (*list[x]);
+        const KKStr&  imageFileName = list[x]->ExampleFileName ();
+        if  (!imageFileName.Empty ())
+        {
+          rootNames[x]  = osGetRootName (imageFileName).Str ();
+          nameHashes[x] = std::hash<std::string> () (rootNames[x]);
+        }
+      }
+    }
+  );
+
+  for  (kkuint32 x = 0;  x < count;  ++x)
+    hasName[x] = !list[x]->ExampleFileName ().Empty ();
+
+  vector<vector<kkuint32>>  dataByShard (numIndexShards);
+  vector<vector<kkuint32>>  nameByShard (numIndexShards);
+  for  (kkuint32 x = 0;  x < count;  ++x)
   {
-    FeatureVectorPtr   example = idx;
-    AddSingleExample (example);
+    dataByShard[dataHashes[x] % numIndexShards].push_back (x);
+    if  (hasName[x])
+      nameByShard[nameHashes[x] % numIndexShards].push_back (x);
   }
+
+  vector<FeatureVectorPtr>  existingData (count, NULL);
+  vector<FeatureVectorPtr>  existingName (count, NULL);
+
+  KKThreadPool::ParallelFor (numThreads, numIndexShards, [&](kkuint32 shardIdx)
+    {
+      for  (auto x: dataByShard[shardIdx])
+        existingData[x] = FindOrAddFeatureData (list[x], dataHashes[x]);
+      for  (auto x: nameByShard[shardIdx])
+        existingName[x] = FindOrAddRootName (list[x], rootNames[x], nameHashes[x]);
+    }
+  );
+
+  for  (kkuint32 x = 0;  x < count;  ++x)
+    RecordDuplicate (list[x], existingName[x], existingData[x]);
 }  /* FindDuplicates */
 
 
@@ -450,7 +587,11 @@ FeatureVectorPtr  DuplicateImage::ExampleWithSmallestScanLine ()
 
 
 DuplicateImageList::DuplicateImageList (bool _owner):
-  KKQueue<DuplicateImage> (_owner)
+  KKQueue<DuplicateImage> (_owner),
+  indexValid   (true),
+  indexedCount (0),
+  setByExample (),
+  setPositions ()
 {
 }
 
@@ -462,13 +603,200 @@ DuplicateImageList::~DuplicateImageList ()
 
 
 
-DuplicateImagePtr  DuplicateImageList::LocateByImage (FeatureVectorPtr  example)
+bool  DuplicateImageList::IndexCurrent ()  const
+{
+  return  indexValid  &&  (indexedCount == QueueSize ());
+}
+
+
+
+void  DuplicateImageList::IndexExample (DuplicateImagePtr  dupSet,
+                                        kkuint32           setIdx,
+                                        FeatureVectorPtr   example
+                                       )
+{
+  auto  result = setByExample.insert (pair<FeatureVectorPtr, pair<kkuint32, DuplicateImagePtr>> (example, pair<kkuint32, DuplicateImagePtr> (setIdx, dupSet)));
+  if  ((!result.second)  &&  (setIdx < result.first->second.first))
+    result.first->second = pair<kkuint32, DuplicateImagePtr> (setIdx, dupSet);
+}  /* IndexExample */
+
+
+
+void  DuplicateImageList::RebuildIndex ()
 {
-  for  (auto dupExampleSet: *this)
+  setByExample.clear ();
+  setPositions.clear ();
+
+  kkuint32  setIdx = 0;
+  for  (auto dupSet: *this)
   {
-    if  (dupExampleSet->AlreadyHaveExample (example))
-      return  dupExampleSet;
+    setPositions.insert (pair<DuplicateImagePtr, kkuint32> (dupSet, setIdx));
+    for  (auto example: *(dupSet->DuplicatedImages ()))
+      IndexExample (dupSet, setIdx, example);
+    ++setIdx;
   }
 
-  return NULL;
+  indexedCount = setIdx;
+  indexValid   = true;
+}  /* RebuildIndex */
+
+
+
+void  DuplicateImageList::AddDuplicateSet (DuplicateImagePtr  dupSet)
+{
+  bool  wasCurrent = IndexCurrent ();
+  kkuint32  setIdx = QueueSize ();
+  KKQueue<DuplicateImage>::PushOnBack (dupSet);
+  if  (!wasCurrent)
+  {
+    indexValid = false;
+    return;
+  }
+
+  setPositions.insert (pair<DuplicateImagePtr, kkuint32> (dupSet, setIdx));
+  for  (auto example: *(dupSet->DuplicatedImages ()))
+    IndexExample (dupSet, setIdx, example);
+  ++indexedCount;
+}  /* AddDuplicateSet */
+
+
+
+void  DuplicateImageList::AddToDuplicateSet (DuplicateImagePtr  dupSet,
+                                             FeatureVectorPtr   example
+                                            )
+{
+  dupSet->AddADuplicate (example);
+  if  (!IndexCurrent ())
+    return;
+
+  auto  idx = setPositions.find (dupSet);
+  if  (idx == setPositions.end ())
+    indexValid = false;
+  else
+    IndexExample (dupSet, idx->second, example);
+}  /* AddToDuplicateSet */
+
+
+
+DuplicateImagePtr  DuplicateImageList::LocateByImage (FeatureVectorPtr  example)
+{
+  if  (!IndexCurrent ())
+    RebuildIndex ();
+
+  auto  idx = setByExample.find (example);
+  return  (idx == setByExample.end ()) ? NULL : idx->second.second;
 }  /* LocateByImage */
+
+
+
+void  DuplicateImageList::AddQueue (const KKQueue<DuplicateImage>&  q)
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::AddQueue (q);
+}
+
+
+
+void  DuplicateImageList::DeleteContents ()
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::DeleteContents ();
+}
+
+
+
+DuplicateImagePtr  DuplicateImageList::PopFromBack ()
+{
+  indexValid = false;
+  return  KKQueue<DuplicateImage>::PopFromBack ();
+}
+
+
+
+DuplicateImagePtr  DuplicateImageList::PopFromFront ()
+{
+  indexValid = false;
+  return  KKQueue<DuplicateImage>::PopFromFront ();
+}
+
+
+
+void  DuplicateImageList::PushOnBack (DuplicateImagePtr  dupSet)
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::PushOnBack (dupSet);
+}
+
+
+
+void  DuplicateImageList::PushOnFront (DuplicateImagePtr  dupSet)
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::PushOnFront (dupSet);
+}
+
+
+
+void  DuplicateImageList::DeleteEntry (DuplicateImagePtr  dupSet)
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::DeleteEntry (dupSet);
+}
+
+
+
+void  DuplicateImageList::DeleteEntry (size_t  idx)
+{
+  indexValid = false;
+  if  (idx >= size ())
+  {
+    KKStr  errMsg = "DuplicateImageList::DeleteEntry   idx: " + StrFromUint64 (idx) + " out of range: " + StrFromUint32 (QueueSize ());
+    cerr << errMsg << endl;
+    throw KKException (errMsg);
+  }
+  erase (begin () + idx);
+}
+
+
+
+void  DuplicateImageList::RandomizeOrder ()
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::RandomizeOrder ();
+}
+
+
+
+void  DuplicateImageList::RandomizeOrder (kkint64  seed)
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::RandomizeOrder (seed);
+}
+
+
+
+void  DuplicateImageList::RandomizeOrder (RandomNumGenerator&  randomVariable)
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::RandomizeOrder (randomVariable);
+}
+
+
+
+void  DuplicateImageList::SetIdxToPtr (size_t             idx,
+                                       DuplicateImagePtr  dupSet
+                                      )
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::SetIdxToPtr (idx, dupSet);
+}
+
+
+
+void  DuplicateImageList::SwapIndexes (size_t  idx1,
+                                       size_t  idx2
+                                      )
+{
+  indexValid = false;
+  KKQueue<DuplicateImage>::SwapIndexes (idx1, idx2);
+}
@@ -13,9 +13,18 @@
  *          The simplest way to use this object is to create an instance with a FeatureVectorList 
  *          object that you are concerned with.  Then call the method DupExamples (), which will 
  *          return the list of duplicates found via a structure called DuplicateImageList.
+ *
+ *          Examples are indexed by hash tables, one on the root name of ExampleFileName and one on a hash
+ *          of the feature data;  feature data with equal hashes is compared value by value so only exact
+ *          duplicates are reported.  When created from a FeatureVectorList the indexes are built by
+ *          several threads and the duplicates then recorded in list order, so the results are the same as
+ *          adding the examples one at a time with 'AddSingleExample'.
  */
 
 
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include  "RunLog.h"
 #include  "FeatureVector.h"
 
@@ -29,12 +38,6 @@ namespace KKMLL
   typedef  DuplicateImage*  DuplicateImagePtr;
 
 
-  #ifndef  _IMAGEFEATURESDATAINDEXED_
-  class  ImageFeaturesDataIndexed;
-  typedef  ImageFeaturesDataIndexed*  ImageFeaturesDataIndexedPtr;
-  #endif
-
-
   #ifndef  _FEATUREVECTOR_
   class FeatureVector;
   typedef  FeatureVector* FeatureVectorPtr;
@@ -42,10 +45,6 @@ namespace KKMLL
   typedef  FeatureVectorList*  FeatureVectorListPtr;
   #endif
 
-  #ifndef  _IMAGEFEATURESNAMEINDEXED_
-  class  ImageFeaturesNameIndexed;
-  typedef  ImageFeaturesNameIndexed* ImageFeaturesNameIndexedPtr;
-  #endif
 
 
 
@@ -103,16 +102,61 @@ namespace KKMLL
 
 
   private:
+    /**
+     *@brief  One slice of the indexes;  an example is kept in the shard selected by its hash so that
+     *        'FindDuplicates' can fill the shards on separate threads.
+     */
+    struct  IndexShard
+    {
+      std::unordered_multimap<size_t, FeatureVectorPtr>  byFeatureData;   /**< Keyed by 'FeatureDataHash'.           */
+      std::unordered_map<std::string, FeatureVectorPtr>  byRootName;      /**< First example added with a root name. */
+    };
+
+    static  const  kkuint32  numIndexShards = 64;
+
     void  FindDuplicates (FeatureVectorListPtr  examples);  /**< Used to build duplicate list from current contents of examples. */
 
+    /**
+     *@brief  Returns the first example added with the same feature data as 'example';  if there is none 'example' is added and NULL returned.
+     */
+    FeatureVectorPtr  FindOrAddFeatureData (FeatureVectorPtr  example,
+                                            size_t            hash
+                                           );
+
+    /**
+     *@brief  Returns the first example added with root name 'rootName';  if there is none 'example' is added and NULL returned.
+     */
+    FeatureVectorPtr  FindOrAddRootName (FeatureVectorPtr    example,
+                                         const std::string&  rootName,
+                                         size_t              hash
+                                        );
+
+    /** @brief  Updates the counts and duplicate sets for 'example' given the examples it was found to duplicate;  either may be NULL. */
+    DuplicateImagePtr  RecordDuplicate (FeatureVectorPtr  example,
+                                        FeatureVectorPtr  existingNameExample,
+                                        FeatureVectorPtr  existingDataExample
+                                       );
+
+    /** @brief  Hash of the feature data;  0.0 and -0.0 hash the same as do all NaN's so that equal data always has equal hashes. */
+    static  size_t  FeatureDataHash (const FeatureVector&  example);
+
+    /**
+     *@brief  True when every feature of 'left' equals the same feature in 'right', a NaN being equal only to another NaN.
+     *@details  The red-black trees that were used before compared with '<' and '>', which made a NaN equal to every
+     *          value;  that is not an equivalence so the duplicates reported depended on insertion order.  Here a
+     *          NaN only matches a NaN, which is also what 'FeatureDataHash' assumes.
+     */
+    static  bool    SameFeatureData (const FeatureVector&  left,
+                                     const FeatureVector&  right
+                                    );
+
     kkint32                      duplicateCount;
     kkint32                      duplicateDataCount;
     kkint32                      duplicateNameCount;
     DuplicateImageListPtr        dupExamples;
-    ImageFeaturesDataIndexedPtr  featureDataTree;
     FileDescConstPtr             fileDesc;
+    std::vector<IndexShard>      indexShards;
     RunLog&                      log;
-    ImageFeaturesNameIndexedPtr  nameTree;
   };
 
 
@@ -164,9 +208,61 @@ namespace KKMLL
     DuplicateImageList (bool _owner);
     ~DuplicateImageList ();
 
+    /** @brief  Adds a new set of duplicates to the end of the list and indexes its examples for 'LocateByImage'. */
+    void  AddDuplicateSet (DuplicateImagePtr  dupSet);
+
+    /** @brief  Adds 'example' to 'dupSet', which must already be in this list, and indexes it for 'LocateByImage'. */
+    void  AddToDuplicateSet (DuplicateImagePtr  dupSet,
+                             FeatureVectorPtr   example
+                            );
+
+    /**
+     *@brief  Returns the first set of duplicates in the list that contains 'example';  NULL if there is none.
+     *@details  A hash table lookup.  Any change to the list other than 'AddDuplicateSet' and 'AddToDuplicateSet'
+     *          discards the index, which is then rebuilt from the list by the next call.  Examples added to a set
+     *          directly with 'DuplicateImage::AddADuplicate' are not seen until the index is rebuilt, so use
+     *          'AddToDuplicateSet' instead.
+     */
     DuplicateImagePtr  LocateByImage (FeatureVectorPtr  example);
 
+    //  The KKQueue methods that change the list;  each one discards the 'LocateByImage' index.
+    virtual  void               AddQueue       (const KKQueue<DuplicateImage>&  q)  override;
+    virtual  void               DeleteContents ()  override;
+    virtual  DuplicateImagePtr  PopFromBack    ()  override;
+    virtual  DuplicateImagePtr  PopFromFront   ()  override;
+    virtual  void               PushOnBack     (DuplicateImagePtr  dupSet)  override;
+    virtual  void               PushOnFront    (DuplicateImagePtr  dupSet)  override;
+
+    void  DeleteEntry    (DuplicateImagePtr  dupSet);
+    void  DeleteEntry    (size_t  idx);
+    void  RandomizeOrder ();
+    void  RandomizeOrder (kkint64  seed);
+    void  RandomizeOrder (RandomNumGenerator&  randomVariable);
+    void  SetIdxToPtr    (size_t             idx,
+                          DuplicateImagePtr  dupSet
+                         );
+    void  SwapIndexes    (size_t  idx1,
+                          size_t  idx2
+                         );
+
   private:
+    /** @brief  True when the index reflects the list;  sets added or removed directly through 'std::vector' are caught by the size check. */
+    bool  IndexCurrent () const;
+
+    void  IndexExample (DuplicateImagePtr  dupSet,
+                        kkuint32           setIdx,
+                        FeatureVectorPtr   example
+                       );
+
+    void  RebuildIndex ();
+
+    bool      indexValid;     /**< Cleared by every change to the list other than 'AddDuplicateSet' and 'AddToDuplicateSet'. */
+    kkuint32  indexedCount;   /**< Number of sets in the list when the index was last brought up to date.                     */
+
+    /** @brief  The set of each example with the lowest position in the list, along with that position. */
+    std::unordered_map<FeatureVectorPtr, std::pair<kkuint32, DuplicateImagePtr>>  setByExample;
+
+    std::unordered_map<DuplicateImagePtr, kkuint32>  setPositions;   /**< Position in the list of each indexed set. */
   };
 
   typedef  DuplicateImageList*  DuplicateImageListPtr;
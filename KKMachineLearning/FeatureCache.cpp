@@ -0,0 +1,405 @@
+#include "FirstIncludes.h"
+#include <mutex>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#include "KKBaseTypes.h"
+#include "BinaryContainer.h"
+#include "KKException.h"
+#include "MemoryMappedFile.h"
+#include "OSservices.h"
+#include "RunLog.h"
+#include "KKStr.h"
+using namespace  KKB;
+
+
+#include "FeatureCache.h"
+#include "FeatureVector.h"
+#include "MLClass.h"
+using namespace  KKMLL;
+
+
+namespace
+{
+  const char*  headerSectionName  = "FeatureCache.Header";
+  const char*  entriesSectionName = "FeatureCache.Entries";
+  const char*  namesSectionName    = "FeatureCache.Names";
+  const char*  featuresSectionName = "FeatureCache.Features";
+}
+
+
+
+mutex                                                        FeatureCache::indexMutex;
+unordered_map<string, FeatureCache::IndexEntry>*             FeatureCache::index           = NULL;
+unordered_map<string, FeatureCache::IndexedSideCar>*         FeatureCache::indexedSideCars = NULL;
+
+
+
+KKStr  FeatureCache::SideCarFileName (const KKStr&  fullFeatureFileName)
+{
+  return  fullFeatureFileName + ".fcache";
+}
+
+
+
+kkuint64  FeatureCache::ContentHash (const KKStr&  fileName,
+                                     bool&         successful
+                                    )
+{
+  successful = false;
+  kkuint64  hash = 14695981039346656037ULL;
+  try
+  {
+    MemoryMappedFile  f (fileName);
+    f.Advise (MemoryMappedFile::AccessPattern::Sequential);
+    const uchar*  next = f.Data ();
+    const uchar*  end  = next + f.Size ();
+    while  (next < end)
+    {
+      hash ^= *next;
+      hash *= 1099511628211ULL;
+      ++next;
+    }
+    successful = true;
+  }
+  catch  (const KKException&)
+  {
+    successful = false;
+  }
+  return  hash;
+}  /* ContentHash */
+
+
+
+FeatureCache::FeatureCache (const KKStr&  _sideCarFileName,
+                            const KKStr&  _producerName,
+                            kkint16       _producerVersion,
+                            RunLog&       _log
+                           ):
+  container       (NULL),
+  byName          (),
+  entries         (NULL),
+  features        (NULL),
+  header          (NULL),
+  names           (NULL),
+  numEntries      (0),
+  numFeatures     (0),
+  producerName    (_producerName),
+  producerVersion (_producerVersion),
+  sideCarFileName (_sideCarFileName)
+{
+  if  (!osFileExists (_sideCarFileName))
+    return;
+
+  try
+  {
+    container = new BinaryContainer (_sideCarFileName);
+  }
+  catch  (const KKException&  e)
+  {
+    _log.Level (10) << "FeatureCache   Ignoring side car[" << _sideCarFileName << "]  " << e.ToString () << endl;
+    container = NULL;
+    return;
+  }
+
+  const BinaryContainer::SectionEntry*  headerSection  = container->LookUp (headerSectionName);
+  const BinaryContainer::SectionEntry*  entriesSection = container->LookUp (entriesSectionName);
+  const BinaryContainer::SectionEntry*  namesSection    = container->LookUp (namesSectionName);
+  const BinaryContainer::SectionEntry*  featuresSection = container->LookUp (featuresSectionName);
+
+  if  ((!headerSection)  ||  (!entriesSection)  ||  (!namesSection)  ||  (!featuresSection)   ||
+       (headerSection->elementSize   != sizeof (SideCarHeader))  ||  (headerSection->count != 1)  ||
+       (entriesSection->elementSize  != sizeof (ImageEntry))                                        ||
+       (featuresSection->elementSize != sizeof (float))
+      )
+  {
+    _log.Level (10) << "FeatureCache   Side car[" << _sideCarFileName << "] is not laid out as expected;  ignoring it." << endl;
+    BinaryContainer::Release (container);
+    return;
+  }
+
+  header = (const SideCarHeader*)container->SectionData (*headerSection);
+  char  producerNameBuff[sizeof (header->producerName) + 1];
+  memcpy (producerNameBuff, header->producerName, sizeof (header->producerName));
+  producerNameBuff[sizeof (header->producerName)] = 0;
+  KKStr  sideCarProducerName (producerNameBuff);
+  if  ((header->producerVersion != _producerVersion)  ||  (sideCarProducerName != _producerName)  ||
+       (header->numEntries != entriesSection->count)                                              ||
+       (featuresSection->count != (kkuint64)header->numEntries * header->numFeatures)
+      )
+  {
+    _log.Level (10) << "FeatureCache   Side car[" << _sideCarFileName << "] was written by a different producer;  ignoring it." << endl;
+    BinaryContainer::Release (container);
+    header = NULL;
+    return;
+  }
+
+  kkuint64  namesSize = namesSection->count;
+  const ImageEntry*  sideCarEntries = (const ImageEntry*)container->SectionData (*entriesSection);
+  for  (kkuint64 x = 0;  x < entriesSection->count;  ++x)
+  {
+    const ImageEntry&  entry = sideCarEntries[x];
+    if  ((((kkuint64)entry.nameOffset      + entry.nameLen)      > namesSize)  ||
+         (((kkuint64)entry.classNameOffset + entry.classNameLen) > namesSize)
+        )
+    {
+      _log.Level (10) << "FeatureCache   Side car[" << _sideCarFileName << "] has names out of range;  ignoring it." << endl;
+      BinaryContainer::Release (container);
+      header = NULL;
+      return;
+    }
+  }
+
+  entries     = sideCarEntries;
+  features    = (const float*)container->SectionData (*featuresSection);
+  names       = (const char*)container->SectionData (*namesSection);
+  numEntries  = header->numEntries;
+  numFeatures = header->numFeatures;
+
+  byName.reserve ((size_t)numEntries);
+  for  (kkuint32 x = 0;  x < numEntries;  ++x)
+    byName[string (names + entries[x].nameOffset, entries[x].nameLen)] = entries + x;
+}
+
+
+
+FeatureCache::~FeatureCache ()
+{
+  byName.clear ();
+  if  (container)
+    BinaryContainer::Release (container);
+}
+
+
+
+const FeatureCache::ImageEntry*  FeatureCache::LookUp (const KKStr&  imageFileName)  const
+{
+  auto  idx = byName.find (imageFileName.Str ());
+  if  (idx == byName.end ())
+    return  NULL;
+  return  idx->second;
+}
+
+
+
+bool  FeatureCache::FeatureFileUnchanged (const KKStr&  featureFileName,
+                                          kkuint32      expectedNumFeatures
+                                         )  const
+{
+  if  ((!header)  ||  (header->allExamples == 0)  ||  (numFeatures != expectedNumFeatures))
+    return  false;
+
+  if  (osGetFileSize (featureFileName) != header->featureFileSize)
+    return  false;
+
+  return  osGetFileDateTime (featureFileName).ToSeconds () == header->featureFileModifiedSeconds;
+}  /* FeatureFileUnchanged */
+
+
+
+void  FeatureCache::Examples (FeatureVectorList&  examples,
+                              MLClassList&        mlClasses
+                             )  const
+{
+  for  (kkuint32 x = 0;  x < numEntries;  ++x)
+  {
+    const ImageEntry&  entry = entries[x];
+    FeatureVectorPtr  fv = new FeatureVector (numFeatures);
+    memcpy (fv->FeatureDataAlter (), features + (size_t)x * numFeatures, numFeatures * sizeof (float));
+    fv->ExampleFileName (KKStr (string (names + entry.nameOffset, entry.nameLen)));
+    fv->MLClass (mlClasses.GetMLClassPtr (KKStr (string (names + entry.classNameOffset, entry.classNameLen))));
+    examples.PushOnBack (fv);
+  }
+}  /* Examples */
+
+
+
+void  FeatureCache::WriteSideCar (const KKStr&                     sideCarFileName,
+                                  const KKStr&                     producerName,
+                                  kkint16                          producerVersion,
+                                  const KKStr&                     featureFileName,
+                                  bool                             allExamples,
+                                  const VectorKKStr&               imageFileNames,
+                                  const vector<FeatureVectorPtr>&  examples,
+                                  vector<ImageEntry>&              entries,
+                                  RunLog&                          log
+                                 )
+{
+  if  ((imageFileNames.size () != entries.size ())  ||  (examples.size () != entries.size ()))
+    throw KKException ("FeatureCache::WriteSideCar   ***ERROR***   Number of names[" + StrFromUint32 ((kkuint32)imageFileNames.size ()) + "] "
+                       "and examples[" + StrFromUint32 ((kkuint32)examples.size ()) + "] "
+                       "do not match number of entries[" + StrFromUint32 ((kkuint32)entries.size ()) + "].");
+
+  kkuint32  numFeatures = examples.empty () ? 0 : examples[0]->NumOfFeatures ();
+  for  (auto fv: examples)
+  {
+    if  (fv->NumOfFeatures () != numFeatures)
+    {
+      log.Level (-1) << "FeatureCache::WriteSideCar   ***ERROR***   Examples do not all have " << numFeatures << " features;  not writing[" << sideCarFileName << "]." << endl;
+      return;
+    }
+  }
+
+  SideCarHeader  header;
+  memset (&header, 0, sizeof (header));
+  header.producerVersion            = producerVersion;
+  header.numEntries                 = (kkuint32)entries.size ();
+  header.numFeatures                = numFeatures;
+  header.allExamples                = allExamples ? 1 : 0;
+  header.featureFileSize            = osGetFileSize (featureFileName);
+  header.featureFileModifiedSeconds = osGetFileDateTime (featureFileName).ToSeconds ();
+  STRCOPY (header.producerName, (kkint32)sizeof (header.producerName), producerName.Str ());
+
+  vector<char>   names;
+  vector<float>  features;
+  features.reserve ((size_t)numFeatures * examples.size ());
+  for  (kkuint32 x = 0;  x < entries.size ();  ++x)
+  {
+    const KKStr&  name = imageFileNames[x];
+    entries[x].nameOffset = (kkuint32)names.size ();
+    entries[x].nameLen    = name.Len ();
+    names.insert (names.end (), name.Str (), name.Str () + name.Len ());
+
+    const KKStr&  className = examples[x]->MLClassName ();
+    entries[x].classNameOffset = (kkuint32)names.size ();
+    entries[x].classNameLen    = className.Len ();
+    names.insert (names.end (), className.Str (), className.Str () + className.Len ());
+
+    const float*  featureData = examples[x]->FeatureData ();
+    features.insert (features.end (), featureData, featureData + numFeatures);
+  }
+
+  try
+  {
+    BinaryContainerWriter  writer (sideCarFileName);
+    writer.AddSection (headerSectionName,   "SideCarHeader", sizeof (SideCarHeader), 1,                &header);
+    writer.AddSection (entriesSectionName,  "ImageEntry",    sizeof (ImageEntry),    entries.size (),  entries.data ());
+    writer.AddSection (namesSectionName,    "char",          sizeof (char),          names.size (),    names.data ());
+    writer.AddSection (featuresSectionName, "float",         sizeof (float),         features.size (), features.data ());
+    writer.Close ();
+  }
+  catch  (const KKException&  e)
+  {
+    log.Level (-1) << "FeatureCache::WriteSideCar   ***ERROR***   Writing[" << sideCarFileName << "]  " << e.ToString () << endl;
+  }
+}  /* WriteSideCar */
+
+
+
+KKStr  FeatureCache::IndexKey (const KKStr&  producerName,
+                               kkint16       producerVersion,
+                               kkuint64      contentHash
+                              )
+{
+  KKStr  key ((kkStrUint)(producerName.Len () + 32));
+  key << producerName << "\t" << producerVersion << "\t" << contentHash;
+  return  key;
+}
+
+
+
+FeatureVectorPtr  FeatureCache::IndexLookUp (const KKStr&  producerName,
+                                             kkint16       producerVersion,
+                                             kkuint64      contentHash
+                                            )
+{
+  KKStr  key = IndexKey (producerName, producerVersion, contentHash);
+
+  lock_guard<mutex>  indexLock (indexMutex);
+  if  (!index)
+    return  NULL;
+
+  auto  idx = index->find (key.Str ());
+  if  (idx == index->end ())
+    return  NULL;
+
+  const IndexedSideCar&  sideCar = *(idx->second.sideCar);
+  FeatureVectorPtr  fv = new FeatureVector (sideCar.numFeatures);
+  memcpy (fv->FeatureDataAlter (), sideCar.features + (size_t)idx->second.entryIdx * sideCar.numFeatures, sideCar.numFeatures * sizeof (float));
+  return  fv;
+}  /* IndexLookUp */
+
+
+
+void  FeatureCache::IndexAdd (const FeatureCache&  sideCar)
+{
+  if  (!sideCar.container)
+    return;
+
+  lock_guard<mutex>  indexLock (indexMutex);
+  IndexRemoveLocked (sideCar.sideCarFileName.Str ());
+
+  if  (!index)
+    index = new unordered_map<string, IndexEntry> ();
+  if  (!indexedSideCars)
+    indexedSideCars = new unordered_map<string, IndexedSideCar> ();
+
+  IndexedSideCar&  indexed = (*indexedSideCars)[sideCar.sideCarFileName.Str ()];
+  sideCar.container->Reference ();
+  indexed.container   = sideCar.container;
+  indexed.entries     = sideCar.entries;
+  indexed.features    = sideCar.features;
+  indexed.numFeatures = sideCar.numFeatures;
+
+  for  (kkuint32 x = 0;  x < sideCar.numEntries;  ++x)
+  {
+    if  (sideCar.entries[x].contentHash == 0)
+      continue;
+
+    IndexEntry  entry;
+    entry.sideCar  = &indexed;
+    entry.entryIdx = x;
+    string  key = IndexKey (sideCar.producerName, sideCar.producerVersion, sideCar.entries[x].contentHash).Str ();
+    if  (index->insert (pair<string, IndexEntry> (key, entry)).second)
+      indexed.keys.push_back (key);
+  }
+}  /* IndexAdd */
+
+
+
+void  FeatureCache::IndexRemoveLocked (const string&  sideCarFileName)
+{
+  if  (!indexedSideCars)
+    return;
+
+  auto  idx = indexedSideCars->find (sideCarFileName);
+  if  (idx == indexedSideCars->end ())
+    return;
+
+  for  (auto&  key: idx->second.keys)
+    index->erase (key);
+
+  BinaryContainer::Release (idx->second.container);
+  indexedSideCars->erase (idx);
+}  /* IndexRemoveLocked */
+
+
+
+void  FeatureCache::IndexRemove (const KKStr&  sideCarFileName)
+{
+  lock_guard<mutex>  indexLock (indexMutex);
+  IndexRemoveLocked (sideCarFileName.Str ());
+}
+
+
+
+void  FeatureCache::FinalCleanUp ()
+{
+  lock_guard<mutex>  indexLock (indexMutex);
+  if  (indexedSideCars)
+  {
+    for  (auto&  idx: *indexedSideCars)
+      BinaryContainer::Release (idx.second.container);
+    delete  indexedSideCars;
+    indexedSideCars = NULL;
+  }
+
+  delete  index;
+  index = NULL;
+}  /* FinalCleanUp */
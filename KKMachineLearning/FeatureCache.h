@@ -0,0 +1,218 @@
+#if  !defined(_FEATURECACHE_)
+#define  _FEATURECACHE_
+/**
+ *@class  KKMLL::FeatureCache
+ *@brief  Remembers the content of the images in a directory so that 'FeatureFileIO::FeatureDataReSink' only has to
+ *        compute features for images whose content actually changed.
+ *@author  Kurt Kramer
+ *@details  Each directory processed by 'FeatureDataReSink' gets a binary side car file next to its feature file,
+ * see 'SideCarFileName', holding for every image its name, class, size, modification time, a 64 bit hash of its
+ * contents and its features.  The side car is read through a memory mapping ('BinaryContainer');  an image whose
+ * size and time still match its entry is taken to be unchanged without being read, and when the feature file
+ * itself is as it was when the side car was written the examples are taken from the side car rather than parsed
+ * from the feature file.
+ *
+ * Images that are new, renamed or modified are hashed and the hash looked up in an index shared by every
+ * directory processed by the process, so a renamed image, or the same image filed under several class
+ * directories, gets its features from the one computation.  The index only records which side car and entry
+ * has the content;  the features stay in the side car's mapping until they are asked for.
+ *
+ * Entries are only meaningful for the producer that computed them;  a side car written by a different producer
+ * or version is ignored and the index is keyed on producer name and version as well as content hash.
+ */
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "KKBaseTypes.h"
+#include "BinaryContainer.h"
+#include "KKStr.h"
+#include "RunLog.h"
+
+
+namespace KKMLL
+{
+#if  !defined(_FeatureVector_Defined_)
+  class  FeatureVector;
+  typedef  FeatureVector*  FeatureVectorPtr;
+
+  class  FeatureVectorList;
+#endif
+
+#if  !defined(_MLCLASS_)
+  class  MLClassList;
+#endif
+
+
+  class  FeatureCache
+  {
+  public:
+    typedef  FeatureCache*  FeatureCachePtr;
+
+    /** @brief  Name of the side car that goes with the feature file 'fullFeatureFileName'. */
+    static  KKStr  SideCarFileName (const KKStr&  fullFeatureFileName);
+
+    /**
+     *@brief  64 bit FNV-1a hash of the contents of 'fileName';  'successful' is set to false if it could not be read.
+     */
+    static  kkuint64  ContentHash (const KKStr&  fileName,
+                                   bool&         successful
+                                  );
+
+
+    /** @brief  What the side car records about one image;  its features are row 'entry number' of the "FeatureCache.Features" section. */
+    struct  ImageEntry
+    {
+      kkuint64  contentHash;
+      kkint64   fileSize;
+      kkuint64  modifiedSeconds;    /**< 'DateTime::ToSeconds' of the file time. */
+      kkuint32  nameOffset;         /**< Into the "FeatureCache.Names" section.  */
+      kkuint32  nameLen;
+      kkuint32  classNameOffset;    /**< Into the "FeatureCache.Names" section.  */
+      kkuint32  classNameLen;
+    };
+
+
+    /**
+     *@brief  Maps the side car '_sideCarFileName' if it exists and was written for '_producerName' / '_producerVersion'.
+     *@details  A missing, unreadable or stale side car is not an error;  the instance is then simply empty.
+     */
+    FeatureCache (const KKStr&  _sideCarFileName,
+                  const KKStr&  _producerName,
+                  kkint16       _producerVersion,
+                  RunLog&       _log
+                 );
+
+    ~FeatureCache ();
+
+    kkuint32  NumEntries ()  const  {return numEntries;}
+
+    kkuint32  NumFeatures ()  const  {return numFeatures;}
+
+    /** @brief  Returns the side car's entry for 'imageFileName' or NULL if it has none. */
+    const ImageEntry*  LookUp (const KKStr&  imageFileName)  const;
+
+    /**
+     *@brief  True when the side car holds every example of 'featureFileName' and that file has the size and time
+     *        it had when the side car was written;  'Examples' can then be used instead of loading it.
+     */
+    bool  FeatureFileUnchanged (const KKStr&  featureFileName,
+                                kkuint32      expectedNumFeatures
+                               )  const;
+
+    /**
+     *@brief  Creates an example for every entry, in side car order, adding them to 'examples';  class names are
+     *        looked up in 'mlClasses'.
+     */
+    void  Examples (FeatureVectorList&  examples,
+                    MLClassList&        mlClasses
+                   )  const;
+
+    /**
+     *@brief  Writes the side car for the images of one directory;  'imageFileNames', 'entries' and 'examples' are
+     *        parallel, 'examples' supplying the class and features of each entry.
+     *@details  The name and class name offsets of 'entries' are filled in here.  'featureFileName' is the feature
+     * file just written;  its size and time are recorded for 'FeatureFileUnchanged' along with whether 'entries'
+     * covers all of it.  Nothing may have the side car mapped, see 'IndexRemove'.  Failing to write the side car
+     * only costs the next run some hashing so it is logged rather than thrown.
+     */
+    static  void  WriteSideCar (const KKStr&                          sideCarFileName,
+                                const KKStr&                          producerName,
+                                kkint16                               producerVersion,
+                                const KKStr&                          featureFileName,
+                                bool                                  allExamples,
+                                const VectorKKStr&                    imageFileNames,
+                                const std::vector<FeatureVectorPtr>&  examples,
+                                std::vector<ImageEntry>&              entries,
+                                RunLog&                               log
+                               );
+
+
+    /**
+     *@brief  Returns a new example with the features recorded for content 'contentHash' by the named producer, or
+     *        NULL if the index has none;  the caller owns it and has to set its name and class.
+     */
+    static  FeatureVectorPtr  IndexLookUp (const KKStr&  producerName,
+                                           kkint16       producerVersion,
+                                           kkuint64      contentHash
+                                          );
+
+    /**
+     *@brief  Adds every entry of 'sideCar' to the index that does not already have one for its content;  the
+     *        index keeps a reference to its mapping.
+     *@details  Replaces whatever the index had from the same side car file before.
+     */
+    static  void  IndexAdd (const FeatureCache&  sideCar);
+
+    /** @brief  Removes the entries of side car 'sideCarFileName' from the index and releases its mapping. */
+    static  void  IndexRemove (const KKStr&  sideCarFileName);
+
+    /** @brief  Releases the index;  called by 'FeatureFileIO::FinalCleanUp'. */
+    static  void  FinalCleanUp ();
+
+  private:
+    FeatureCache (const FeatureCache&);
+    FeatureCache&  operator= (const FeatureCache&);
+
+    struct  SideCarHeader
+    {
+      kkint32   producerVersion;
+      kkuint32  numEntries;
+      kkuint32  numFeatures;
+      kkuint32  allExamples;                 /**< Non zero when the entries are every example of the feature file. */
+      kkint64   featureFileSize;
+      kkuint64  featureFileModifiedSeconds;
+      char      producerName[56];
+    };
+
+    /** @brief  A side car that the index refers to. */
+    struct  IndexedSideCar
+    {
+      BinaryContainerPtr        container;     /**< One reference held by the index. */
+      const ImageEntry*         entries;
+      const float*              features;
+      kkuint32                  numFeatures;
+      std::vector<std::string>  keys;          /**< Index entries that refer to this side car. */
+    };
+
+    /** @brief  Where the features for a content hash are;  'sideCar' is stable as 'indexedSideCars' is node based. */
+    struct  IndexEntry
+    {
+      const IndexedSideCar*  sideCar;
+      kkuint32               entryIdx;
+    };
+
+    static  KKStr  IndexKey (const KKStr&  producerName,
+                             kkint16       producerVersion,
+                             kkuint64      contentHash
+                            );
+
+    /** @brief  Caller must hold 'indexMutex'. */
+    static  void  IndexRemoveLocked (const std::string&  sideCarFileName);
+
+    BinaryContainerPtr                                     container;
+    std::unordered_map<std::string, const ImageEntry*>     byName;
+    const ImageEntry*                                      entries;
+    const float*                                           features;
+    const SideCarHeader*                                   header;
+    const char*                                            names;
+    kkuint32                                               numEntries;
+    kkuint32                                               numFeatures;
+    KKStr                                                  producerName;
+    kkint16                                                producerVersion;
+    KKStr                                                  sideCarFileName;
+
+    static  std::mutex                                              indexMutex;
+    static  std::unordered_map<std::string, IndexEntry>*            index;
+    static  std::unordered_map<std::string, IndexedSideCar>*        indexedSideCars;
+  };  /* FeatureCache */
+
+  typedef  FeatureCache::FeatureCachePtr  FeatureCachePtr;
+
+#define  _FeatureCache_Defined_
+
+}  /* KKMLL */
+
+#endif
@@ -0,0 +1,125 @@
+#include "FirstIncludes.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string.h>
+#include <iostream>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#include "KKBaseTypes.h"
+#include "KKException.h"
+#include "KKStr.h"
+using namespace  KKB;
+
+
+#include "FeatureDataBlock.h"
+#include "KernelEngine.h"
+using namespace  KKMLL;
+
+
+namespace
+{
+  const size_t  rowAlignment = 32;
+
+  /** @brief  Every live block by the address of its first row;  see 'FeatureDataBlock::BlockContaining'. */
+  typedef  std::map<const float*, FeatureDataBlockPtr>  BlockIndex;
+
+  std::mutex&  BlocksMutex ()
+  {
+    static  std::mutex  blocksMutex;
+    return  blocksMutex;
+  }
+
+  BlockIndex&  Blocks ()
+  {
+    static  BlockIndex  blocks;
+    return  blocks;
+  }
+}
+
+
+
+FeatureDataBlock::FeatureDataBlock (kkuint32  _numRows,
+                                    kkuint32  _numCols
+                                   ):
+  data       (NULL),
+  dataBlock  (NULL),
+  numCols    (_numCols),
+  numRows    (_numRows),
+  references (1),
+  stride     ((kkuint32)PackedFeatureVectors::StrideForNumCols ((kkint32)_numCols))
+{
+  kkMemSize  numFloats = (kkMemSize)numRows * stride;
+  kkMemSize  extra     = rowAlignment / sizeof (float);
+
+  dataBlock = new float[numFloats + extra];
+  size_t  addr    = (size_t)dataBlock;
+  size_t  aligned = (addr + rowAlignment - 1) & ~(rowAlignment - 1);
+  data = (float*)aligned;
+  memset (data, 0, numFloats * sizeof (float));
+
+  std::lock_guard<std::mutex>  lock (BlocksMutex ());
+  Blocks ()[data] = this;
+}
+
+
+
+FeatureDataBlock::~FeatureDataBlock ()
+{
+  {
+    std::lock_guard<std::mutex>  lock (BlocksMutex ());
+    Blocks ().erase (data);
+  }
+  delete[]  dataBlock;  dataBlock = NULL;
+  data = NULL;
+}
+
+
+
+kkMemSize  FeatureDataBlock::MemoryConsumedEstimated ()  const
+{
+  return  sizeof (FeatureDataBlock) + ((kkMemSize)numRows * stride + rowAlignment / sizeof (float)) * sizeof (float);
+}
+
+
+
+FeatureDataBlock::ColumnView  FeatureDataBlock::Column (kkuint32  col)  const
+{
+  if  (col >= numCols)
+    throw KKException ("FeatureDataBlock::Column   ***ERROR***   Col[" + StrFromUint32 (col) + "] out of range;  NumCols[" + StrFromUint32 (numCols) + "].");
+  return  ColumnView (data + col, numRows, stride);
+}
+
+
+
+FeatureDataBlockPtr  FeatureDataBlock::BlockContaining (const float*  row)
+{
+  std::lock_guard<std::mutex>  lock (BlocksMutex ());
+  BlockIndex&  blocks = Blocks ();
+  BlockIndex::iterator  idx = blocks.upper_bound (row);
+  if  (idx == blocks.begin ())
+    return  NULL;
+  --idx;
+
+  FeatureDataBlockPtr  block = idx->second;
+  if  (row >= block->data + (kkMemSize)block->numRows * block->stride)
+    return  NULL;
+  return  block;
+}  /* BlockContaining */
+
+
+
+void  FeatureDataBlock::AddReference ()
+{
+  references.fetch_add (1, std::memory_order_relaxed);
+}
+
+
+
+void  FeatureDataBlock::ReleaseReference ()
+{
+  if  (references.fetch_sub (1, std::memory_order_acq_rel) == 1)
+    delete  this;
+}
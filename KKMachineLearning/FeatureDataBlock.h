@@ -0,0 +1,99 @@
+#if  !defined(_FEATUREDATABLOCK_)
+#define  _FEATUREDATABLOCK_
+/**
+ *@class  KKMLL::FeatureDataBlock
+ *@brief  The feature data of a list of FeatureVector instances stored in one contiguous, row major block of floats.
+ *@author  Kurt Kramer
+ *@details  Created by 'FeatureVectorList::ConsolidateFeatureData';  each FeatureVector of the list is left pointing at
+ * its row so that it keeps working as before while scans across examples, such as those done by
+ * 'NormalizationParms', run straight through memory.  Rows are 'Stride ()' floats long, padded with zeros and
+ * aligned on a 32 byte boundary the same as 'PackedFeatureVectors' so 'KernelEngine' can work on them directly.
+ *
+ * The block is reference counted:  every FeatureVector pointing into it holds one reference and the block
+ * deletes itself when the last one is released.  A FeatureVector that is resized gets its own array again.
+ * So that FeatureVector does not need a pointer to its block, live blocks are registered by address and
+ * 'BlockContaining' finds the block a row belongs to.
+ */
+
+#include <atomic>
+#include  "KKBaseTypes.h"
+
+
+namespace KKMLL
+{
+  class  FeatureDataBlock
+  {
+  public:
+    typedef  FeatureDataBlock*  FeatureDataBlockPtr;
+
+    /**
+     *@brief  A single feature across all the rows of a 'FeatureDataBlock';  'view[row]' is feature 'col' of that row.
+     */
+    class  ColumnView
+    {
+    public:
+      ColumnView (const float*  _first,
+                  kkuint32      _count,
+                  kkuint32      _stride
+                 ):
+          count  (_count),
+          first  (_first),
+          stride (_stride)
+      {}
+
+      kkuint32  Count () const  {return count;}
+
+      float  operator[] (kkuint32  row) const  {return first[(kkMemSize)row * stride];}
+
+    private:
+      kkuint32      count;
+      const float*  first;
+      kkuint32      stride;
+    };  /* ColumnView */
+
+
+    /** @brief  Allocates '_numRows' rows of '_numCols' features, all zeros;  the caller holds the first reference. */
+    FeatureDataBlock (kkuint32  _numRows,
+                      kkuint32  _numCols
+                     );
+
+    kkMemSize  MemoryConsumedEstimated ()  const;
+
+    kkuint32  NumCols ()  const  {return numCols;}
+    kkuint32  NumRows ()  const  {return numRows;}
+    kkuint32  Stride  ()  const  {return stride;}
+
+    float*        Row (kkuint32 row)        {return data + (kkMemSize)row * stride;}
+    const float*  Row (kkuint32 row)  const {return data + (kkMemSize)row * stride;}
+
+    ColumnView  Column (kkuint32  col)  const;
+
+    /** @brief  The live block that 'row' points into;  NULL when it is not part of any. */
+    static  FeatureDataBlock*  BlockContaining (const float*  row);
+
+    void  AddReference ();
+
+    /** @brief  Gives up one reference;  the block is deleted with the last one so it must not be used afterwards. */
+    void  ReleaseReference ();
+
+  private:
+    FeatureDataBlock (const FeatureDataBlock&);
+    FeatureDataBlock&  operator= (const FeatureDataBlock&);
+
+    ~FeatureDataBlock ();
+
+    float*                 data;         /**< Aligned start of row 0.                 */
+    float*                 dataBlock;    /**< Block as allocated;  'data' points into it. */
+    kkuint32               numCols;
+    kkuint32               numRows;
+    std::atomic<kkint32>   references;
+    kkuint32               stride;
+  };  /* FeatureDataBlock */
+
+  typedef  FeatureDataBlock::FeatureDataBlockPtr  FeatureDataBlockPtr;
+
+#define  _FeatureDataBlock_Defined_
+
+}  /* KKMLL */
+
+#endif
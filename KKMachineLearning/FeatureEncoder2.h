@@ -58,6 +58,8 @@ namespace KKMLL
                                              RunLog&   log
                                             )  const;  /**< If 'o' is not NULL will write out a table showing assignments from old to new.  */
 
+    FileDescConstPtr  EncodedFileDesc () const  {return encodedFileDesc;}
+
     FeatureVectorListPtr  EncodedFeatureVectorList (const  FeatureVectorList&  srcData)  const;
 
     FeatureVectorListPtr  EncodeAllExamples (const FeatureVectorListPtr  srcData);
@@ -6,6 +6,11 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unordered_map>
 #include <vector>
 #include <stdlib.h>
 #include <string.h>
@@ -18,6 +23,7 @@ using namespace std;
 #include "GoalKeeper.h"
 #include "GlobalGoalKeeper.h"
 #include "ImageIO.h"
+#include "KKThreadPool.h"
 #include "OSservices.h"
 #include "RunLog.h"
 #include "KKStr.h"
@@ -25,6 +31,7 @@ using namespace KKB;
 
 
 #include "FeatureFileIO.h"
+#include "FeatureCache.h"
 #include "FeatureFileIOArff.h"
 #include "FeatureFileIOC45.h"
 #include "FeatureFileIOColumn.h"
@@ -60,6 +67,10 @@ void  ReportError (RunLog&       log,
 
 vector<FeatureFileIOPtr>*  FeatureFileIO::registeredDrivers = NULL;
 
+kkuint32  FeatureFileIO::loadThreads = 0;
+
+FeatureFileIO::ReSinkProgressFunc  FeatureFileIO::reSinkProgress;
+
 
 
 std::vector<FeatureFileIOPtr>*  FeatureFileIO::RegisteredDrivers  ()
@@ -163,6 +174,8 @@ void FeatureFileIO::FinalCleanUp ()
     registeredDrivers = NULL;
   }
 
+  FeatureCache::FinalCleanUp ();
+
   GlobalGoalKeeper::EndBlock ();
 }  /* CleanUpFeatureFileIO */
 
@@ -333,29 +346,42 @@ void  FeatureFileIO::GetLine (istream&  _in,
     return;
   }
 
-  kkint32  ch = _in.peek ();
-  while  ((ch != '\n')  &&  (ch != '\r')  &&  (!_in.eof ()))
-  {
-    ch = _in.get ();
-    _line.Append ((char)ch);
-    ch = _in.peek ();
-  }
+  // Works with the stream buffer directly;  going through 'peek' and 'get' for every character
+  // constructs a sentry each time and dominated the load time of large files.
+  streambuf*  sb = _in.rdbuf ();
 
-  if  (!_in.eof ())
+  char      chunk[256];
+  kkuint32  chunkLen = 0;
+
+  kkint32  ch = sb->sgetc ();
+  while  ((ch != EOF)  &&  (ch != '\n')  &&  (ch != '\r'))
   {
-    _in.get ();  // Skip over end of line character.
-    if  (ch == '\n')
-    {
-      ch = _in.peek ();
-      if  (ch == '\r')
-        _in.get ();  // line is terminated by LineFeed + CarrageReturn;  we need to skip over both.
-    }
-    else if  (ch  == '\r')
+    chunk[chunkLen++] = (char)ch;
+    if  (chunkLen >= sizeof (chunk))
     {
-      ch = _in.peek ();
-      if  (ch == '\n')
-        _in.get ();  // line is terminated by CarrageReturn + LineFeed;  we need to skip over both.
+      _line.Append (chunk, chunkLen);
+      chunkLen = 0;
     }
+    ch = sb->snextc ();
+  }
+
+  if  (chunkLen > 0)
+    _line.Append (chunk, chunkLen);
+
+  if  (ch == EOF)
+  {
+    _in.setstate (ios_base::eofbit);
+  }
+  else
+  {
+    // Skip over end of line character;  if the line is terminated by LineFeed + CarrageReturn
+    // or CarrageReturn + LineFeed we need to skip over both.
+    kkint32  nextCh = sb->snextc ();
+    if  (nextCh == EOF)
+      _in.setstate (ios_base::eofbit);
+
+    else if  (((nextCh == '\n')  ||  (nextCh == '\r'))  &&  (nextCh != ch))
+      sb->sbumpc ();
   }
 
   _eof = false;
@@ -383,61 +409,79 @@ void  FeatureFileIO::GetToken (istream&     _in,
     return;
   }
 
-  kkint32  ch;
+  streambuf*  sb = _in.rdbuf ();
 
   // Skip past any leading white space.
-  ch = _in.peek ();
-  while  ((ch == ' ')  &&  (!_in.eof ()))
-  {
-    _in.get ();
-    ch = _in.peek ();
-  }
+  kkint32  ch = sb->sgetc ();
+  while  (ch == ' ')
+    ch = sb->snextc ();
 
-  if  (_in.eof ())
+  if  (ch == EOF)
   {
+    _in.setstate (ios_base::eofbit);
     _eof = true;
     _eol = true;
     return;
   }
 
-  if  (ch == '\n')
+  if  ((ch == '\n')  ||  (ch == '\r'))
   {
     _eol = true;
-    _in.get ();
-    if  (_in.peek () == '\r')
-      _in.get ();
+    kkint32  nextCh = sb->snextc ();
+    if  (nextCh == EOF)
+      _in.setstate (ios_base::eofbit);
+
+    else if  (((nextCh == '\n')  ||  (nextCh == '\r'))  &&  (nextCh != ch))
+    {
+      if  (sb->snextc () == EOF)
+        _in.setstate (ios_base::eofbit);
+    }
     return;
   }
 
-  if  (ch == '\r')
+  char      chunk[256];
+  kkuint32  chunkLen = 0;
+
+  while  ((ch != EOF)  &&  (ch != '\n')  &&  (ch != '\r')  &&  ((ch == 0)  ||  (strchr (_delimiters, ch) == NULL)))
   {
-    _eol = true;
-    _in.get ();
-    if  (_in.peek () == '\n')
-      _in.get ();
-    return;
+    chunk[chunkLen++] = (char)ch;
+    if  (chunkLen >= sizeof (chunk))
+    {
+      _token.Append (chunk, chunkLen);
+      chunkLen = 0;
+    }
+    ch = sb->snextc ();
   }
 
+  if  (chunkLen > 0)
+    _token.Append (chunk, chunkLen);
 
-  while  ((!_in.eof ())  &&  (ch != '\n')  &&  (ch != '\r')  &&  (strchr (_delimiters, ch) == NULL))
+  if  (ch == EOF)
   {
-    _in.get ();
-    _token.Append ((char)ch);
-    ch = _in.peek ();
+    _in.setstate (ios_base::eofbit);
   }
 
-  if  (strchr (_delimiters, ch) != NULL)
+  else if  ((ch != 0)  &&  (strchr (_delimiters, ch) != NULL))
   {
     // the next character was a delimiter;  in this case we want to remove from stream.
-    _in.get ();
+    if  (sb->snextc () == EOF)
+      _in.setstate (ios_base::eofbit);
   }
 
-
   return;
 }  /* GetToken */
 
 
 
+void  FeatureFileIO::ParallelForLoad (kkuint32                        count,
+                                     std::function<void (kkuint32)>  body
+                                    )
+{
+  KKThreadPool::ParallelFor (loadThreads, count, body);
+}
+
+
+
 FeatureVectorListPtr  FeatureFileIO::LoadFeatureFile 
                                       (const KKStr&   _fileName,
                                        MLClassList&   _mlClasses,
@@ -789,8 +833,31 @@ FeatureVectorListPtr  FeatureFileIO::FeatureDataReSink (FactoryFVProducerPtr  _f
 
   bool  versionsAreSame = false;
 
-  FeatureVectorListPtr  origFeatureVectorData 
-        = LoadFeatureFile (fileNameToOpen, _mlClasses, -1, _cancelFlag, successful, _changesMade, _log);
+  FeatureVectorProducerPtr  fvProducer = _fvProducerFactory->ManufactureInstance (_log);
+
+  // The side car says which images are unchanged since the last time the directory was processed;  an image it
+  // has no entry for is trusted the same as before the side car existed, one whose size or time differs is hashed
+  // and only keeps its entry if the content turns out to be the same.  When the feature file has not changed
+  // since the side car was written the examples are taken from the side car instead of parsing the feature file.
+  KKStr  sideCarFileName = FeatureCache::SideCarFileName (fullFeatureFileName);
+  FeatureCachePtr  sideCar = new FeatureCache (sideCarFileName, fvProducer->Name (), fvProducer->Version (), _log);
+  kkuint32  numFeatures = _fvProducerFactory->FileDesc ()->NumOfFields ();
+
+  FeatureVectorListPtr  origFeatureVectorData = NULL;
+  if  ((_fvProducerFactory->FeatureVectorTypeId () == &typeid (FeatureVector))  &&
+       (sideCar->FeatureFileUnchanged (fileNameToOpen, numFeatures))
+      )
+  {
+    origFeatureVectorData = _fvProducerFactory->ManufacturFeatureVectorList (true);
+    sideCar->Examples (*origFeatureVectorData, _mlClasses);
+    origFeatureVectorData->Version (fvProducer->Version ());
+    successful = true;
+    _log.Level (20) << "FeatureDataReSink  Dir: " << _dirName << "  " << origFeatureVectorData->QueueSize () << " examples from side car." << endl;
+  }
+  else
+  {
+    origFeatureVectorData = LoadFeatureFile (fileNameToOpen, _mlClasses, -1, _cancelFlag, successful, _changesMade, _log);
+  }
 
   if  (origFeatureVectorData == NULL)
   {
@@ -801,6 +868,8 @@ FeatureVectorListPtr  FeatureFileIO::FeatureDataReSink (FactoryFVProducerPtr  _f
   if  (_cancelFlag)
   {
     delete  origFeatureVectorData;  origFeatureVectorData = NULL;
+    delete  sideCar;                sideCar               = NULL;
+    delete  fvProducer;             fvProducer            = NULL;
     return  _fvProducerFactory->ManufacturFeatureVectorList (true);
   }
 
@@ -831,12 +900,12 @@ FeatureVectorListPtr  FeatureFileIO::FeatureDataReSink (FactoryFVProducerPtr  _f
       _changesMade = true;
 
     delete  origFeatureData;  origFeatureData = NULL;
+    delete  sideCar;          sideCar         = NULL;
+    delete  fvProducer;       fvProducer      = NULL;
 
     return  _fvProducerFactory->ManufacturFeatureVectorList (true);
   }
 
-  FeatureVectorProducerPtr  fvProducer = _fvProducerFactory->ManufactureInstance (_log);
-
   if  (successful)
   {
     if  (origFeatureData->Version () == fvProducer->Version ())
@@ -856,44 +925,60 @@ FeatureVectorListPtr  FeatureFileIO::FeatureDataReSink (FactoryFVProducerPtr  _f
     origFeatureData = _fvProducerFactory->ManufacturFeatureVectorList (true);
   }
 
-  origFeatureData->SortByRootName (false);
-
   FeatureVectorListPtr  extractedFeatures = _fvProducerFactory->ManufacturFeatureVectorList (true);
   extractedFeatures->Version (fvProducer->Version ());
 
   fileNameList->Sort (false);
 
-  KKStrList::iterator  fnIDX;
-  fnIDX = fileNameList->begin ();   // fileNameList
+  // Existing entries are found by name through a hash table;  matched ones are taken out of 'origFeatureData'
+  // all at once at the end rather than one at a time.
+  unordered_map<string, FeatureVectorPtr>  origByName;
+  for  (auto fv: *origFeatureData)
+    origByName.insert (pair<string, FeatureVectorPtr> (fv->ExampleFileName ().Str (), fv));
 
-  KKStrPtr  imageFileName;
+  // Decide in directory order which images can keep their existing entries and which need computing.
+  vector<KKStrPtr>                  imageFileNames;
+  vector<FeatureCache::ImageEntry>  imageEntries;
+  vector<FeatureVectorPtr>          results;
+  vector<kkuint32>                  toCompute;      /**< Index into 'imageFileNames' of the images that need computing. */
+  vector<kkuint32>                  toHash;         /**< Index into 'imageFileNames' of the images without a current hash. */
+  vector<kkuint64>                  priorHashes;    /**< Side car hash of the images in 'toHash';  0 when there is none. */
 
   kkuint32  numImagesFoundInOrigFeatureData = 0;
-  kkuint32  numOfNewFeatureExtractions = 0;
 
-  for  (fnIDX = fileNameList->begin ();  (fnIDX != fileNameList->end ())  &&  (!_cancelFlag);  ++fnIDX)
+  for  (auto imageFileName: *fileNameList)
   {
-    imageFileName = *fnIDX;
-
-    // pv414-_002_20140414-162243_02068814-1261.bmp
-    KKStr  rootName = osGetRootName (*imageFileName);
-    if  (rootName == "pv414-_002_20140414-162243_02068814-1261")
-      cout << "Stop Here." << endl;
-
-    bool validImageFileFormat = SupportedImageFileFormat (*imageFileName);
-    
-    if  (!validImageFileFormat)
+    if  (!SupportedImageFileFormat (*imageFileName))
       continue;
 
-    bool  featureVectorCoputaionSuccessful = false;
+    KKStr  fullImageFileName = osAddSlash (_dirName) + *imageFileName;
+    FeatureCache::ImageEntry  imageEntry;
+    memset (&imageEntry, 0, sizeof (imageEntry));
+    imageEntry.fileSize        = osGetFileSize (fullImageFileName);
+    imageEntry.modifiedSeconds = osGetFileDateTime (fullImageFileName).ToSeconds ();
+
+    const FeatureCache::ImageEntry*  sideCarEntry = sideCar->LookUp (*imageFileName);
+    if  (sideCarEntry  &&  (sideCarEntry->fileSize == imageEntry.fileSize)  &&  (sideCarEntry->modifiedSeconds == imageEntry.modifiedSeconds))
+    {
+      imageEntry.contentHash = sideCarEntry->contentHash;
+    }
+    else
+    {
+      toHash.push_back ((kkuint32)imageFileNames.size ());
+      priorHashes.push_back (sideCarEntry ? sideCarEntry->contentHash : 0);
+    }
 
-    FeatureVectorPtr  origFV = origFeatureData->BinarySearchByName (*imageFileName);
-    if  (origFV)
+    FeatureVectorPtr  origFV = NULL;
+    auto  origIdx = origByName.find (imageFileName->Str ());
+    if  (origIdx != origByName.end ())
+    {
+      origFV = origIdx->second;
+      origByName.erase (origIdx);
       numImagesFoundInOrigFeatureData++;
+    }
 
     if  (origFV  &&  versionsAreSame)
     {
-      featureVectorCoputaionSuccessful = true;
       if  (_useDirectoryNameForClassName)
       {
         if  (origFV->MLClass () != _unknownClass)
@@ -908,54 +993,208 @@ FeatureVectorListPtr  FeatureFileIO::FeatureDataReSink (FactoryFVProducerPtr  _f
         _changesMade = true;
         origFV->MLClass (_unknownClass);
       }
-
-      extractedFeatures->PushOnBack (origFV);
-      origFeatureData->DeleteEntry (origFV);
     }
     else
     {
       // We either  DON'T have an original image    or    versions are not the same.
+      toCompute.push_back ((kkuint32)imageFileNames.size ());
+      origFV = NULL;
+    }
+
+    imageFileNames.push_back (imageFileName);
+    imageEntries.push_back (imageEntry);
+    results.push_back (origFV);
+  }
+
+  ParallelForLoad ((kkuint32)toHash.size (), [&](kkuint32 x)
+    {
+      kkuint32  idx = toHash[x];
+      bool  hashed = false;
+      kkuint64  hash = FeatureCache::ContentHash (osAddSlash (_dirName) + *(imageFileNames[idx]), hashed);
+      imageEntries[idx].contentHash = hashed ? hash : 0;
+    }
+  );
 
-      KKStr  fullFileName = osAddSlash (_dirName) + (*imageFileName);
-      FeatureVectorPtr fv = NULL;
-      try
+  // An existing entry is dropped when the image it was computed from has been modified.
+  for  (kkuint32 x = 0;  x < toHash.size ();  ++x)
+  {
+    kkuint32  idx = toHash[x];
+    if  ((results[idx] != NULL)  &&  (priorHashes[x] != 0)  &&  (imageEntries[idx].contentHash != priorHashes[x]))
+    {
+      results[idx] = NULL;
+      toCompute.push_back (idx);
+    }
+  }
+
+  // The side car's entries go into the content index;  this includes those of images that are no longer in the
+  // directory under their old name so that a renamed image gets its features back.
+  FeatureCache::IndexAdd (*sideCar);
+
+  // Images whose content has already been computed, here or under another directory, are copied rather than
+  // computed;  of several identical images still to compute only the first one is.
+  vector<kkuint32>  stillToCompute;
+  vector<pair<kkuint32, kkuint32> >  sameContentAs;     /**< (image, image with the same content that is being computed). */
+  unordered_map<kkuint64, kkuint32>  computingByHash;
+  kkuint32  numFromFeatureCache = 0;
+
+  for  (auto idx: toCompute)
+  {
+    kkuint64  hash = imageEntries[idx].contentHash;
+    if  (hash == 0)
+    {
+      stillToCompute.push_back (idx);
+      continue;
+    }
+
+    FeatureVectorPtr  cachedFV = FeatureCache::IndexLookUp (fvProducer->Name (), fvProducer->Version (), hash);
+    if  (cachedFV)
+    {
+      cachedFV->ExampleFileName (*(imageFileNames[idx]));
+      cachedFV->MLClass (_unknownClass);
+      results[idx] = cachedFV;
+      numFromFeatureCache++;
+      continue;
+    }
+
+    auto  computing = computingByHash.find (hash);
+    if  (computing != computingByHash.end ())
+    {
+      sameContentAs.push_back (pair<kkuint32, kkuint32> (idx, computing->second));
+    }
+    else
+    {
+      computingByHash[hash] = idx;
+      stillToCompute.push_back (idx);
+    }
+  }
+  toCompute.swap (stillToCompute);
+
+  // Read the images and compute their features;  each worker has its own FeatureVectorProducer and log buffer.
+  kkuint32  numToCompute = (kkuint32)toCompute.size ();
+  kkuint32  numWorkers = Min (KKThreadPool::ResolveNumThreads (loadThreads), Max (numToCompute, (kkuint32)1));
+
+  vector<FeatureVectorProducerPtr>  producers (numWorkers, NULL);
+  producers[0] = fvProducer;
+  for  (kkuint32 x = 1;  x < numWorkers;  ++x)
+    producers[x] = _fvProducerFactory->ManufactureInstance (_log);
+
+  vector<KKStr>    workerLogs (numWorkers);
+  atomic<kkuint32> nextToCompute (0);
+  kkuint32         numOfNewFeatureExtractions = 0;
+  mutex            progressMutex;
+  kkint32          loggingLevel = _log.LoggingLevel ();
+
+  KKThreadPool::ParallelFor (numWorkers, numWorkers, [&](kkuint32 workerIdx)
+    {
+      ostringstream  workerLogStream;
+      RunLog  bufferedLog (workerLogStream);
+      bufferedLog.SetLoggingLevel (loggingLevel);
+      RunLog&  workerLog = (numWorkers > 1) ? bufferedLog : _log;
+
+      FeatureVectorProducerPtr  producer = producers[workerIdx];
+
+      while  (!_cancelFlag)
       {
-        RasterPtr image = ReadImage (fullFileName);
-        if  (image)
-          fv = fvProducer->ComputeFeatureVector (*image, _unknownClass, NULL, 1.0f, _log);
-        delete image;
-        image = NULL;
-        if  (fv)
-          featureVectorCoputaionSuccessful = true;
+        kkuint32  next = nextToCompute.fetch_add (1);
+        if  (next >= numToCompute)
+          break;
+
+        kkuint32  idx = toCompute[next];
+        const KKStr&  imageFileName = *(imageFileNames[idx]);
+
+        KKStr  fullFileName = osAddSlash (_dirName) + imageFileName;
+        FeatureVectorPtr fv = NULL;
+        try
+        {
+          RasterPtr image = ReadImage (fullFileName);
+          if  (image)
+            fv = producer->ComputeFeatureVector (*image, _unknownClass, NULL, 1.0f, workerLog);
+          delete image;
+          image = NULL;
+        }
+        catch  (...)
+        {
+          workerLog.Level (-1) << "FeatureDataReSink   ***ERROR***   Exception occurred calling constructor 'ComputeFeatureVector'." << endl;
+          delete  fv;
+          fv = NULL;
+        }
+
+        if  (!fv)
+        {
+          workerLog.Level (-1) << "FeatureFileIOKK::FeatureDataReSink   ***ERROR***   Processing Image File: "<< imageFileName << endl;
+        }
         else
-          featureVectorCoputaionSuccessful = false;
-      }
-      catch  (...)
-      {
-        _log.Level (-1) << "FeatureDataReSink   ***ERROR***   Exception occurred calling constructor 'ComputeFeatureVector'." << endl;
-        featureVectorCoputaionSuccessful = false;
-        fv = NULL;
+        {
+          fv->ExampleFileName (imageFileName);
+          workerLog.Level (30) << fv->ExampleFileName () << "  " << fv->OrigSize () << endl;
+          results[idx] = fv;
+
+          lock_guard<mutex>  progressLock (progressMutex);
+          numOfNewFeatureExtractions++;
+          if  (reSinkProgress)
+            reSinkProgress (_dirName, numOfNewFeatureExtractions, numToCompute);
+        }
       }
 
-      if  (!featureVectorCoputaionSuccessful)
+      if  (numWorkers > 1)
       {
-        _log.Level (-1) << "FeatureFileIOKK::FeatureDataReSink   ***ERROR***   Processing Image File: "<< imageFileName << endl;
-        delete  fv;
-        fv = NULL;
+        bufferedLog.Flush ();
+        workerLogs[workerIdx] = workerLogStream.str ().c_str ();
       }
+    }
+  );
 
-      else
-      {
-        _changesMade = true;
-        fv->ExampleFileName (*imageFileName);
-        _log.Level (30) << fv->ExampleFileName () << "  " << fv->OrigSize () << endl;
-        extractedFeatures->PushOnBack (fv);
-        numOfNewFeatureExtractions++;
+  for  (auto&  workerLogText: workerLogs)
+  {
+    workerLogText.TrimRight ();
+    if  (!workerLogText.Empty ())
+      _log.WriteLine (workerLogText);
+  }
 
-        if  ((numOfNewFeatureExtractions % 100) == 0)
-          cout << numOfNewFeatureExtractions << " Images Extracted." << endl;
-      }
+  for  (kkuint32 x = 1;  x < numWorkers;  ++x)
+  {
+    delete  producers[x];
+    producers[x] = NULL;
+  }
+
+  for  (auto&  sameContent: sameContentAs)
+  {
+    FeatureVectorPtr  sourceFV = results[sameContent.second];
+    if  (!sourceFV)
+      continue;
+    FeatureVectorPtr  fv = sourceFV->Duplicate ();
+    fv->ExampleFileName (*(imageFileNames[sameContent.first]));
+    results[sameContent.first] = fv;
+    numFromFeatureCache++;
+  }
+
+  if  ((numOfNewFeatureExtractions > 0)  ||  (numFromFeatureCache > 0))
+    _changesMade = true;
+
+  _log.Level (20) << "FeatureDataReSink  Dir: " << _dirName << "  Computed: " << numOfNewFeatureExtractions
+                  << "  FromFeatureCache: " << numFromFeatureCache << "  Hashed: " << toHash.size () << endl;
+
+  // Assemble in directory order;  'origFeatureData' gives up the entries that were kept.
+  set<FeatureVectorPtr>  kept;
+  for  (auto fv: results)
+  {
+    if  (!fv)
+      continue;
+    extractedFeatures->PushOnBack (fv);
+    kept.insert (fv);
+  }
+
+  if  (!kept.empty ())
+  {
+    FeatureVectorListPtr  notKept = _fvProducerFactory->ManufacturFeatureVectorList (true);
+    for  (auto fv: *origFeatureData)
+    {
+      if  (kept.find (fv) == kept.end ())
+        notKept->PushOnBack (fv);
     }
+    origFeatureData->Owner (false);
+    delete  origFeatureData;
+    origFeatureData = notKept;
   }
 
   if  (numImagesFoundInOrigFeatureData != extractedFeatures->QueueSize ())
@@ -981,6 +1220,40 @@ FeatureVectorListPtr  FeatureFileIO::FeatureDataReSink (FactoryFVProducerPtr  _f
     _timeStamp = osGetLocalDateTime ();
   }
 
+  if  (((_changesMade)  ||  (!toHash.empty ())  ||  (sideCar->NumEntries () != imageEntries.size ())  ||
+        (!sideCar->FeatureFileUnchanged (fullFeatureFileName, numFeatures))
+       )  &&
+       (!_cancelFlag)
+      )
+  {
+    VectorKKStr                       sideCarNames;
+    vector<FeatureVectorPtr>          sideCarExamples;
+    vector<FeatureCache::ImageEntry>  sideCarEntries;
+    for  (kkuint32 idx = 0;  idx < results.size ();  ++idx)
+    {
+      if  (results[idx]  &&  (imageEntries[idx].contentHash != 0))
+      {
+        sideCarNames.push_back (*(imageFileNames[idx]));
+        sideCarExamples.push_back (results[idx]);
+        sideCarEntries.push_back (imageEntries[idx]);
+      }
+    }
+
+    // Nothing may have the old side car mapped while it is rewritten;  the new one then takes its place in the index.
+    delete  sideCar;
+    sideCar = NULL;
+    FeatureCache::IndexRemove (sideCarFileName);
+
+    bool  allExamples = (sideCarEntries.size () == extractedFeatures->QueueSize ());
+    FeatureCache::WriteSideCar (sideCarFileName, fvProducer->Name (), fvProducer->Version (), fullFeatureFileName, allExamples,
+                                sideCarNames, sideCarExamples, sideCarEntries, _log
+                               );
+
+    FeatureCache  newSideCar (sideCarFileName, fvProducer->Name (), fvProducer->Version (), _log);
+    FeatureCache::IndexAdd (newSideCar);
+  }
+
+  delete sideCar;          sideCar         = NULL;
   delete fvProducer;       fvProducer      = NULL;
   delete fileNameList;     fileNameList    = NULL;
   delete origFeatureData;  origFeatureData = NULL;
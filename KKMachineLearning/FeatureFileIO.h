@@ -1,6 +1,8 @@
 #ifndef  _FEATUREFILEIO_
 #define  _FEATUREFILEIO_
 
+#include <functional>
+
 
 /**
  *@class  KKMLL::FeatureFileIO
@@ -20,6 +22,7 @@
 #include "OSservices.h"
 #include "RunLog.h"
 #include "KKStr.h"
+#include "TextLineReader.h"
 
 namespace KKMLL 
 {
@@ -161,6 +164,15 @@ namespace KKMLL
      * A change in feature file version number would also cause all entries in the feature
      * file to be recomputed.  The feature file version number gets incremented whenever we change
      * the feature file computation routine.
+     *
+     * Images that need their features computed are read and processed on 'LoadThreads' threads, each with a
+     * FeatureVectorProducer of its own;  the returned list is in the same order no matter how many are used.
+     * Progress is reported through 'ReSinkProgress'.
+     *
+     * A 'FeatureCache' side car next to the feature file records the size, time, content hash and features of
+     * every image;  an image modified since is recomputed even though its name is in the feature file, and an image
+     * that is new or renamed gets the features of any image with the same content in a side car already processed
+     * by the process.  While the feature file is unchanged its examples are read from the side car.
      */
     virtual
     FeatureVectorListPtr  FeatureDataReSink (FactoryFVProducerPtr  _fvProducerFactory,
@@ -301,6 +313,20 @@ namespace KKMLL
 
     static  void               FinalCleanUp ();
 
+    /** @brief  Number of threads drivers use to parse a file;  0 (the default) = one per processor, 1 = parse on the calling thread. */
+    static  kkuint32           LoadThreads ()  {return loadThreads;}
+
+    static  void               LoadThreads (kkuint32  _loadThreads)  {loadThreads = _loadThreads;}
+
+    /**
+     *@brief  Called by 'FeatureDataReSink' as images have their features computed;  the directory, the number of
+     *        images done so far and the number that need computing.
+     *@details  May be called from any of the worker threads but never from two at the same time.
+     */
+    typedef  std::function<void (const KKStr&  dirName, kkuint32  numDone, kkuint32  numToDo)>  ReSinkProgressFunc;
+
+    static  void               ReSinkProgress (ReSinkProgressFunc  _reSinkProgress)  {reSinkProgress = _reSinkProgress;}
+
     /**
      *@brief  For each feature file format register the appropriate driver through this static method.
      *@details  You will be giving ownership of the driver to this class; it will call the destructor 
@@ -338,6 +364,29 @@ namespace KKMLL
                     bool&          _eof
                    );
 
+
+    /**
+     *@brief  Reads '_in' a block at a time and parses the lines of each block on 'LoadThreads' threads.
+     *@details  'parseLine (const TextLineReader::Line&, ParsedLine&)' is called for every line from multiple
+     * threads;  it may only update the 'ParsedLine' it is given.  'processLine (ParsedLine&)' is then called on
+     * the calling thread for each line in file order;  class look-ups, logging and adding examples to the result
+     * belong here.  Returning false from 'processLine' or setting '_cancelFlag' stops the reading.
+     *
+     * 'ParsedLine' must be default constructible and its destructor has to free anything 'processLine' did not
+     * take ownership of since lines parsed past the point of stopping are never processed.
+     */
+    template<typename ParsedLine, typename ParseFunc, typename ProcessFunc>
+    void  ParseLinesInParallel (std::istream&  _in,
+                                VolConstBool&  _cancelFlag,
+                                ParseFunc      parseLine,
+                                ProcessFunc    processLine
+                               );
+
+    /** @brief  Calls 'body' for each index in [0, count) using 'LoadThreads' threads. */
+    static  void  ParallelForLoad (kkuint32                        count,
+                                   std::function<void (kkuint32)>  body
+                                  );
+
 protected:
   static void  RegisterDriver (FeatureFileIOPtr  driver);
 
@@ -351,6 +400,10 @@ protected:
     static void  RegisterAllDrivers ();
     static GoalKeeperPtr  featureFileIOGoalKeeper;
 
+    static  kkuint32  loadThreads;
+
+    static  ReSinkProgressFunc  reSinkProgress;
+
 
     static  std::vector<FeatureFileIOPtr>*  registeredDrivers;
 
@@ -363,6 +416,58 @@ protected:
 
   typedef  FeatureFileIO::FeatureFileIOPtr   FeatureFileIOPtr;
 
+
+
+  template<typename ParsedLine, typename ParseFunc, typename ProcessFunc>
+  void  FeatureFileIO::ParseLinesInParallel (std::istream&  _in,
+                                             VolConstBool&  _cancelFlag,
+                                             ParseFunc      parseLine,
+                                             ProcessFunc    processLine
+                                            )
+  {
+    // Lines are handed to the threads in groups so they are not contending for every line.
+    const kkuint32  linesPerTask = 512;
+
+    KKB::TextLineReader            reader (_in);
+    KKB::TextLineReader::LineList  lines;
+
+    while  ((!_cancelFlag)  &&  (reader.GetBlockOfLines (lines) > 0))
+    {
+      kkuint32  numLines = (kkuint32)lines.size ();
+      kkuint32  numTasks = (numLines + linesPerTask - 1) / linesPerTask;
+
+      ParsedLine*  parsed = new ParsedLine[numLines];
+      try
+      {
+        ParallelForLoad (numTasks, [&lines, &parsed, &parseLine, numLines, linesPerTask] (kkuint32  taskIdx)
+          {
+            kkuint32  lastIdx = (taskIdx + 1) * linesPerTask;
+            if  (lastIdx > numLines)
+              lastIdx = numLines;
+            for  (kkuint32  idx = taskIdx * linesPerTask;  idx < lastIdx;  ++idx)
+              parseLine (lines[idx], parsed[idx]);
+          }
+        );
+
+        bool  keepGoing = true;
+        for  (kkuint32  idx = 0;  (idx < numLines)  &&  keepGoing;  ++idx)
+          keepGoing = (!_cancelFlag)  &&  processLine (parsed[idx]);
+
+        delete[]  parsed;
+        parsed = NULL;
+
+        if  (!keepGoing)
+          break;
+      }
+      catch  (...)
+      {
+        delete[]  parsed;
+        parsed = NULL;
+        throw;
+      }
+    }
+  }  /* ParseLinesInParallel */
+
 #define  _FeatureFileIO_Defined_
 
 
@@ -1,5 +1,6 @@
 #include  "FirstIncludes.h"
 #include <ctype.h>
+#include <float.h>
 #include <limits.h>
 #include <math.h>
 #include <stdio.h>
@@ -18,6 +19,7 @@ using namespace std;
 #include "OSservices.h"
 #include "RunLog.h"
 #include "KKStr.h"
+#include "TextLineReader.h"
 using namespace  KKB;
 
 #include "FeatureFileIOC45.h"
@@ -504,195 +506,270 @@ FileDescConstPtr  FeatureFileIOC45::GetFileDesc (const KKStr&    _fileName,
 
 
 
-KKStr  FeatureFileIOC45::C45ReadNextToken (istream&     in, 
-                                           const char*  delimiters,
-                                           bool&        eof,
-                                           bool&        eol
-                                          )
+void  FeatureFileIOC45::C45NextToken (const char*&  next,
+                                      const char*   end,
+                                      const char*   delimiters,
+                                      KKStr&        token,
+                                      bool&         eol
+                                     )
 {
-  eof = false;
+  token = "";
   eol = false;
 
-  const kkint32  maxTokenLen = 1024;
-  char  token[maxTokenLen];
-
   // lets skip leading white space
-  kkint32  ch = in.get (); eof = in.eof ();
-  while  ((!eof)  &&  ((ch == ' ') || (ch == '\r') || (ch == '\t'))  &&  (ch != '\n'))
-    {ch = in.get (); eof = in.eof ();}
+  while  ((next < end)  &&  ((*next == ' ')  ||  (*next == '\t')))
+    ++next;
 
-  if  (ch == '\n')
+  if  (next >= end)
   {
     eol = true;
-    if  (in.peek () == '\r')
-      in.get ();
-    return "";
+    return;
   }
 
-  if  (ch == '\r')
+  if  (*next == '|')
   {
+    // The rest of the line is meant to be a comment.
+    next = end;
     eol = true;
-    if  (in.peek () == '\n')
-      in.get ();
-    return "";
+    return;
   }
 
-  else if  (ch == '.')
+  if  ((*next == '.')  &&  (((next + 1) >= end)  ||  (strchr (" \t|", next[1]) != NULL)))
   {
-    // If next character is a white space, eol, eof, of '|' 
-    // then treat as end of entry or '\n'.
-    char nextCh = (char)in.peek (); 
-    if  (strchr (" \t\r\n|", nextCh))
-    {
-      eol = true;
-      return "";
-    }
+    // A period followed by a white space, end of line or comment is treated as end of entry.
+    next = end;
+    eol = true;
+    return;
   }
-  
-  else if  (ch == '|')
+
+  // Read till first delimiter or end of line.
+  while  (next < end)
   {
-    // The rest of the line is meant to be a comment,  
-    // we can skip all the following characters.
-    while  ((!eof)  &&  (ch != '\n')  &&  (ch != '\r'))
-      {ch = in.get (); eof = in.eof ();}
-    eol = true;
+    char  ch = *next;
+    if  (strchr (delimiters, ch))
+    {
+      ++next;
+      break;
+    }
+
+    if  (ch == '|')
+      break;
 
-    if  (!eof)
+    if  (ch == '.')
     {
-      if  ((ch == '\n')  &&  (in.peek () == '\r'))
-        in.get ();  //  I want to leave ch with '\n' in it.
+      // Dots have special meaning when at the end of the line or followed 
+      // by a white space character.  In these cases they delimit a separated entry.
+      if  (((next + 1) >= end)  ||  (next[1] == '|'))
+      {
+        // This is a period that is at end of line, in this case we discard '.' and end token.
+        ++next;
+        break;
+      }
 
-      else if  ((ch == '\r')  &&  (in.peek () == '\n'))
-        ch = in.get ();
+      if  ((next[1] == ' ')  ||  (next[1] == '\t'))
+      {
+        // This period marks the end of the entry;  leave it so that the next call
+        // to C45NextToken will treat it as end of line.
+        break;
+      }
+
+      token.Append (ch);
+      ++next;
+    }
+
+    else if  (ch == '\\')
+    {
+      // We may have an escape character that c45 Allows
+      // http://www.cs.washington.edu/dm/vfml/appendixes/c45.htm
+      ++next;
+      if  ((next < end)  &&  (strchr (",?:", *next) != NULL))
+      {
+        ch = *next;
+        ++next;
+      }
+      token.Append (ch);
+    }
+
+    else if  ((ch == ' ')  ||  (ch == '\t'))
+    {
+      // We will compress the white space characters to just one blank.
+      token.Append (' ');
+      ++next;
+      while  ((next < end)  &&  ((*next == ' ')  ||  (*next == '\t')))
+        ++next;
+    }
+
+    else
+    {
+      token.Append (ch);
+      ++next;
     }
-    eof = in.eof ();
   }
 
-  kkint32 tokenLen = 0;
+  // Remove Trailing whitespace
+  token.TrimRight (" \t");
+}  /* C45NextToken */
 
-  // Read till first delimiter or eof
-  while  ((!eof)  &&  (!strchr (delimiters, ch)))
+
+
+namespace  KKMLL
+{
+  /** @brief  Result of parsing one line of a C45 data file;  filled in by one of the parsing threads. */
+  struct  C45ParsedLine
   {
-    if  ((ch == '\n')  ||  (ch == '|'))
+    enum  class  ParseError  {None, MissingFeatures, InvalidNominal, MissingClassName};
+
+    C45ParsedLine ():
+        blank           (true),
+        className       (),
+        error           (ParseError::None),
+        errorField      (),
+        example         (NULL),
+        exampleFileName (),
+        invalidSymbolic ()
+    {}
+
+    ~C45ParsedLine ()
     {
-      in.putback ((char)ch);
-      break;
+      delete  example;
+      example = NULL;
+    }
+
+    bool              blank;
+    KKStr             className;
+    ParseError        error;
+    KKStr             errorField;
+    FeatureVectorPtr  example;
+    KKStr             exampleFileName;
+    VectorKKStr       invalidSymbolic;   /**< Symbolic values that were not defined;  reported but not an error. */
+  };  /* C45ParsedLine */
+}
+
+
+
+/** @brief  Same as 'KKStr::ToFloat' without requiring a NUL terminated copy of the field. */
+static  float  C45FieldToFloat (const KKStr&  field)
+{
+  if  (field.Empty ())
+    return 0.0f;
+
+  double  d = TextLineReader::ParseDouble (field.Str (), field.Str () + field.Len ());
+  if  (fabs (d) > FLT_MAX)
+    return field.ToFloat ();  // Will throw the same exception it always has.
+
+  return  (float)d;
+}
+
+
+
+void  FeatureFileIOC45::C45ParseLine (const TextLineReader::Line&  line,
+                                      FileDescConstPtr             fileDesc,
+                                      AttributeConstPtr*           attributeTable,
+                                      C45ParsedLine&               parsed
+                                     )
+{
+  const char*  next = line.str;
+  const char*  end  = line.str + line.len;
+
+  bool   eol = false;
+  KKStr  field;
+  C45NextToken (next, end, ",", field, eol);
+  if  (eol)
+  {
+    // We have a blank line
+    parsed.blank = true;
+    return;
+  }
+
+  parsed.blank = false;
+
+  kkint32  numOfFeatures = fileDesc->NumOfFields ();
+  FeatureVectorPtr  example = new FeatureVector (numOfFeatures);
+  parsed.example = example;
+
+  // Process all fields for this row  'numOfFeatures'
+  for  (kkint32 fieldNum = 0;  fieldNum < numOfFeatures;  fieldNum++)
+  {
+    if  (eol)
+    {
+      parsed.error = C45ParsedLine::ParseError::MissingFeatures;
+      return;
     }
 
-    else if  (ch == '.')
+    switch  (attributeTable[fieldNum]->Type ())
     {
-      // Dots have special meaning when at the end of the line or followed 
-      // by a white space character.  In these cases they delimit a separated entry.
-      char nextCh = (char)in.get (); bool nextEOF = in.eof ();
-      if  (nextEOF)
+    case AttributeType::Ignore:  
+      example->AddFeatureData (fieldNum, C45FieldToFloat (field));
+      break;
+            
+    case AttributeType::Numeric: 
+      example->AddFeatureData (fieldNum, C45FieldToFloat (field));
+      break;
+
+    case AttributeType::Nominal: 
+    {
+      kkint32  code = -1;  // Initialize to value for missing data.
+      if  (field == "?")
       {
-        // Since end of file will treat as end of line
-        in.putback (nextCh);
-        nextCh = (char)in.get (); nextEOF = in.eof ();
-        ch = ' ';
-        break;
+        // Will flag this entry as having missing data.
+        example->MissingData (true);
       }
       else
       {
-        if  (strchr (" \r\t", nextCh))
-        {
-          // Since next character is end of line, or white space them this period is 
-          // marking end of entry, will put back into stream so that next call to 
-          // C45ReadNextToken will get it next and treat as end of line.
-          in.putback ('.');
-          break;
-        }
-        else if  ((nextCh == '\n')  ||  (nextCh == '|'))
+        // This is not a missing data.
+        code = attributeTable[fieldNum]->GetNominalCode (field);
+        if  (code < 0)
         {
-          // This is a period that is at end of line, in this case
-          // we discard '.' and end token.
-          in.putback (nextCh);
-          break;
-        }
-        else
-        {
-          // This is a valid period, dot '.' character., so lets put the following
-          // character back in the stream
-          in.putback (nextCh);
+          parsed.error = C45ParsedLine::ParseError::InvalidNominal;
+          parsed.errorField = field;
+          return;
         }
       }
+
+      example->AddFeatureData (fieldNum, (float)code);
+      break;
     }
 
-    else
+    case AttributeType::Symbolic: 
     {
-      if  (ch == '\\')
+      kkint32  code = -1;  // Initialize to value for missing data.
+      if  (field == "?")
       {
-        // We may have an escape character that c45 Allows
-        // http://www.cs.washington.edu/dm/vfml/appendixes/c45.htm
-
-        char nextCh = (char)in.get (); bool nextEOF = in.eof ();
-        if  (nextEOF)
-        {
-          // Not Sure what will happen in this case,  i don't want to set eof yet,
-          // but do on the next call, so will put character back on line and re-read
-          // this way the next call to this function will get a eof.
-          in.putback (nextCh);
-          nextCh = (char)in.get (); nextEOF = in.eof ();
-        }
-        else
-        {
-          if  (strchr (",?:", nextCh))
-          {
-            ch = nextCh;
-          }
-          else
-          {
-            // not a Escape Sequence, put following character back so we get it next time.
-            in.putback (nextCh);
-          }
-        }
-      } 
-
-      else if  (strchr (" \t\r", ch))
+        // Will flag this entry as having missing data.
+        example->MissingData (true);
+      }
+      else
       {
-        // We will compress the white space characters to just one blank.
-        ch = ' ';
+        // This is not a missing data.
+        if  (attributeTable[fieldNum]->Name ().EqualIgnoreCase ("ExampleFileName"))
+          parsed.exampleFileName = field;
 
-        char nextCh = (char)in.get (); bool nextEOF = in.eof ();
-        while  ((!nextEOF)  &&  (strchr (" \t\r", nextCh)))
-        {nextCh = (char)in.get (); nextEOF = in.eof ();}
-
-        if  (nextEOF)
-        {
-          // Not Sure what will happen in this case,  i don't want to set eof yet,
-          // but do on the next call, so will put character back on line and reread
-          // this way the next call to this function will get a eof.
-          in.putback (nextCh);
-          nextCh = (char)in.get ();  nextEOF = in.eof ();
-        }
-        else
-        {
-          // This should be a valid characte, so will put back into file
-          // to read on next loop
-          in.putback (nextCh);
-        }
+        code = attributeTable[fieldNum]->GetNominalCode (field);
+        if  (code < 0)
+          parsed.invalidSymbolic.push_back (field);
       }
+
+      example->AddFeatureData (fieldNum, (float)code);
+      break;
     }
 
-    token[tokenLen] = (char)ch;
-    tokenLen++;
-    ch = in.get (); eof = in.eof ();
+    default:
+      break;
+
+    }  /* End of switch */
+
+    C45NextToken (next, end, " ,", field, eol);
   }
 
-  token[tokenLen] = 0;  // Terminating NULL character.
-  
-  // Remove Training whitespace
-  while  (tokenLen > 0)
+  // 'field' should have the class name in it
+  if  ((field.Empty ())  ||  eol)
   {
-    if  (strchr (" \r\t", token[tokenLen - 1]) == 0)
-      break;
-    tokenLen--;
-    token[tokenLen] = 0;
+    parsed.error = C45ParsedLine::ParseError::MissingClassName;
+    return;
   }
 
-
-  return  token;
-}  /* C45ReadNextToken */
+  parsed.className = field;
+}  /* C45ParseLine */
 
 
 
@@ -709,206 +786,115 @@ FeatureVectorListPtr  FeatureFileIOC45::LoadFile (const KKStr&      _fileName,
 {
   _log.Level (10) << "FeatureFileIOC45::LoadFile   FileName[" << _fileName << "]" << endl;
 
-  bool  eof = false;
-  bool  eol = false;
-
-  kkint32  numOfFeatures = _fileDesc->NumOfFields ();
-
   KKStr fileRootName = osGetRootName (_fileName);
 
   kkint32  lineCount = 0;
 
   auto  attributeTable = _fileDesc->CreateAAttributeConstTable ();  // Caller will be responsible for deleting
 
-  bool  lineIsValid = true;
-
-  KKStr  imageFileName = "";
-
   FeatureVectorListPtr  examples = new FeatureVectorList (_fileDesc, true);
 
   kkuint32 maxToLoad = (_maxCount  ? _maxCount.value () : uint32_max);
 
-  while  ((!eof)  &&  (!_cancelFlag)  &&  (examples->QueueSize () < maxToLoad))
-  {
-    lineIsValid = true;
-    imageFileName = "";
-    KKStr  field = C45ReadNextToken (_in, ",", eof, eol);
-    if  (eof)
-      break;
-
-    if  (eol)
+  // Lines are parsed in parallel;  class look-ups, error reporting and adding to 'examples' are done
+  // in file order by 'processLine' on this thread.
+  auto  parseLine = [this, _fileDesc, attributeTable] (const TextLineReader::Line&  line,  C45ParsedLine&  parsed)
     {
-      // We have a blank line
-      continue;
-    }
+      C45ParseLine (line, _fileDesc, attributeTable, parsed);
+    };
 
-    FeatureVectorPtr  example = new FeatureVector (numOfFeatures);
-    kkint32  fieldNum = 0;
+  auto  processLine = [&] (C45ParsedLine&  parsed) -> bool
+    {
+      if  (examples->QueueSize () >= maxToLoad)
+        return false;
 
-    // Process all fields for this row  'numOfFeatures'
+      if  (parsed.blank)
+        return true;
 
-    for  (fieldNum = 0;  fieldNum < numOfFeatures;  fieldNum++)
-    {
-      if  (eol  ||  eof)
+      for  (auto&  invalidValue: parsed.invalidSymbolic)
       {
-        _errorMessage << "Not all Features were accounted for on Line[" << lineCount << "].";
+        _errorMessage << "Invalid NominalValue[" << invalidValue << "]  on line[" << lineCount << "].";
         _log.Level (-1) << endl << endl
                         << "FeatureFileIOC45::LoadFile    " << _errorMessage << endl
                         << endl;
-        delete  examples;  examples = NULL;
-        delete  example;   example  = NULL;
-        return NULL;
       }
 
-      switch  (attributeTable[fieldNum]->Type ())
+      switch  (parsed.error)
       {
-      case AttributeType::Ignore:  
-        example->AddFeatureData (fieldNum, field.ToFloat ());
-        break;
-              
-      case AttributeType::Numeric: 
-        example->AddFeatureData (fieldNum, field.ToFloat ());
+      case  C45ParsedLine::ParseError::MissingFeatures:
+        _errorMessage << "Not all Features were accounted for on Line[" << lineCount << "].";
         break;
 
-      case AttributeType::Nominal: 
-      {
-        kkint32  code = -1;  // Initialize to value for missing data.
-        if  (field == "?")
-        {
-          // Will flag this entry as having missing data.
-          example->MissingData (true);
-        }
-        else
-        {
-          // This is not a missing data.
-          code = attributeTable[fieldNum]->GetNominalCode (field);
-          if  (code < 0)
-          {
-            _errorMessage << "Invalid NominalValue[" << field << "]  on line[" << lineCount << "].";
-            _log.Level (-1) << endl << endl
-                            << "FeatureFileIOC45::LoadFile    " << _errorMessage << endl
-                            << endl;
-            delete  examples;  examples = NULL;
-            delete  example;   example  = NULL;
-            return NULL;
-          }
-        }
-
-        example->AddFeatureData (fieldNum, (float)code);
+      case  C45ParsedLine::ParseError::InvalidNominal:
+        _errorMessage << "Invalid NominalValue[" << parsed.errorField << "]  on line[" << lineCount << "].";
         break;
-      }
-
-      case AttributeType::Symbolic: 
-      {
-        kkint32  code = -1;  // Initialize to value for missing data.
-        if  (field == "?")
-        {
-          // Will flag this entry as having missing data.
-          example->MissingData (true);
-        }
-        else
-        {
-          // This is not a missing data.
-
-          if  (attributeTable[fieldNum]->Name ().EqualIgnoreCase ("ExampleFileName"))
-            imageFileName = field;
 
-          code = attributeTable[fieldNum]->GetNominalCode (field);
-          if  (code < 0)
-          {
-            _errorMessage << "Invalid NominalValue[" << field << "]  on line[" << lineCount << "].";
-            _log.Level (-1) << endl << endl
-              << "FeatureFileIOC45::LoadFile    " << _errorMessage << endl
-              << endl;
-          }
-        }
-
-        example->AddFeatureData (fieldNum, (float)code);
+      case  C45ParsedLine::ParseError::MissingClassName:
+        _errorMessage << "Line[" << lineCount << "]  Missing ClassName.";
         break;
-      }
 
       default:
-        _log.Level (-1) << endl << endl
-                        << "FeatureFileIOC45::LoadFile    *** Undefined Field Type ***" << endl
-                        << endl;
         break;
+      }
 
-      }  /* End of switch */
-
-      field = C45ReadNextToken (_in, " ,", eof, eol);
-    }
-
-    // 'field' should have the class name in it
-    if  ((field.Empty ())  ||  eol)
-    {
-      _errorMessage << "Line[" << lineCount << "]  Missing ClassName.";
-      _log.Level (-1) << endl << endl 
-                      << "FeatureFileIOC45::LoadFile    " << _errorMessage << endl
-                      << endl;
-      
-      delete  examples;  examples = NULL;
-      delete  example;   example  = NULL;
-      return  NULL;
-    }
-    
-    MLClassPtr mlClass = NULL;
-
-    if  (field == "?")
-    {
-      // The class is unknown
-      mlClass = _fileDesc->LookUpUnKnownMLClass ();
-    }
-    else
-    {
-      mlClass = _fileDesc->LookUpMLClassByName (field);
-      if  (!mlClass)
+      if  (parsed.error != C45ParsedLine::ParseError::None)
       {
-        lineIsValid = false;
-        _errorMessage << "Line[" << lineCount << "]  Invalid Class[" << field << "]";
         _log.Level (-1) << endl << endl
-                        << "FeatureFileIOC45::LoadFile  " << _errorMessage << endl
+                        << "FeatureFileIOC45::LoadFile    " << _errorMessage << endl
                         << endl;
         delete  examples;  examples = NULL;
-        delete  example;   example  = NULL;
-        return  NULL;
+        return false;
+      }
+
+      MLClassPtr mlClass = NULL;
+      if  (parsed.className == "?")
+      {
+        // The class is unknown
+        mlClass = _fileDesc->LookUpUnKnownMLClass ();
+      }
+      else
+      {
+        mlClass = _fileDesc->LookUpMLClassByName (parsed.className);
+        if  (!mlClass)
+        {
+          _errorMessage << "Line[" << lineCount << "]  Invalid Class[" << parsed.className << "]";
+          _log.Level (-1) << endl << endl
+                          << "FeatureFileIOC45::LoadFile  " << _errorMessage << endl
+                          << endl;
+          delete  examples;  examples = NULL;
+          return false;
+        }
       }
-    }
 
-    example->MLClass (mlClass);
+      FeatureVectorPtr  example = parsed.example;
+      parsed.example = NULL;
 
-    if  (imageFileName.Empty ())
-      imageFileName = fileRootName + "_" + StrFormatInt (lineCount, "ZZZZZ0");
+      example->MLClass (mlClass);
 
-    example->ExampleFileName (imageFileName);
+      if  (parsed.exampleFileName.Empty ())
+        example->ExampleFileName (fileRootName + "_" + StrFormatInt (lineCount, "ZZZZZ0"));
+      else
+        example->ExampleFileName (parsed.exampleFileName);
 
-    if  (lineIsValid)
       examples->PushOnBack (example);
 
-    lineCount++;
+      lineCount++;
 
-    if  (!eof)
-    {
-      // Consume the rest of the characters in the line so that the next pass starts at
-      // the beginning of the next line.
-      kkint32  ch = _in.peek ();
-      while  ((ch != '\n')  &&  (ch != '\r')  &&  (!_in.eof ()))
-      {
-        _in.get ();
-        ch = _in.peek ();
-      }
-      if  (!_in.eof ())
-      {
-        _in.get ();
-        if  ((ch == '\n')  &&  (_in.peek () == '\r'))
-           _in.get ();
+      if  ((lineCount % 1000) == 0)
+        cout  << "Records Loaded " << lineCount << endl;
 
-        else if  ((ch == '\r')  &&  (_in.peek () == '\n'))
-           _in.get ();
-      }
-    }
+      return  true;
+    };
 
-    if  ((lineCount % 1000) == 0)
-      cout  << "Records Loaded " << lineCount << endl;
+  try
+  {
+    ParseLinesInParallel<C45ParsedLine> (_in, _cancelFlag, parseLine, processLine);
+  }
+  catch  (...)
+  {
+    delete  examples;        examples       = NULL;
+    delete[] attributeTable; attributeTable = NULL;
+    throw;
   }
 
   _log.Level (50) << "FeatureFileIOC45::LoadFile   _changesMade: " << _changesMade << "   _changesMade: " << _changesMade  << endl 
@@ -1,10 +1,14 @@
 #ifndef  _FEATUREFILEIOC45_
 #define  _FEATUREFILEIOC45_
 
+#include  "Attribute.h"
 #include  "FeatureFileIO.h"
 
 namespace KKMLL
 {
+  struct  C45ParsedLine;
+
+
 /**
  *@class  FeatureFileIOC45
  *@brief  Supports the reading and writing of feature data from C45 formated feature files.
@@ -95,11 +99,23 @@ private:
                                          KKStr&        dataFileName
                                         );
 
-  KKStr  C45ReadNextToken (istream&     in, 
-                           const char*  delimiters,
-                           bool&        eof,
-                           bool&        eol
-                          );
+  /**
+   *@brief  Extracts the next C45 token from the line [next, end);  'eol' is set when there are no more
+   * tokens because the end of the line, a comment or an entry terminating period was reached.
+   */
+  static  void  C45NextToken (const char*&  next,
+                              const char*   end,
+                              const char*   delimiters,
+                              KKStr&        token,
+                              bool&         eol
+                             );
+
+  /** @brief  Parses one line of a data file into 'parsed';  called from multiple threads by 'LoadFile'. */
+  static  void  C45ParseLine (const TextLineReader::Line&  line,
+                              FileDescConstPtr             fileDesc,
+                              AttributeConstPtr*           attributeTable,
+                              C45ParsedLine&               parsed
+                             );
 
   void  ProcessC45AttrStr (FileDescPtr  fileDesc,
                            KKStr&       attrStr,
@@ -16,6 +16,7 @@ using namespace  std;
 #include "OSservices.h"
 #include "RunLog.h"
 #include "KKStr.h"
+#include "TextLineReader.h"
 using namespace  KKB;
 
 #include "FeatureFileIOSparse.h"
@@ -40,6 +41,35 @@ FeatureFileIOSparse::~FeatureFileIOSparse ()
 
 
 
+namespace  KKMLL
+{
+  /** @brief  Result of parsing one line of a Sparse data file;  filled in by one of the parsing threads. */
+  struct  SparseParsedLine
+  {
+    SparseParsedLine ():
+        badFeatureNum        (),
+        blank                (true),
+        className            (),
+        example              (NULL),
+        featureNumOutOfRange (false)
+    {}
+
+    ~SparseParsedLine ()
+    {
+      delete  example;
+      example = NULL;
+    }
+
+    KKStr             badFeatureNum;
+    bool              blank;
+    KKStr             className;
+    FeatureVectorPtr  example;
+    bool              featureNumOutOfRange;
+  };  /* SparseParsedLine */
+}
+
+
+
 FileDescConstPtr  FeatureFileIOSparse::GetFileDesc (const KKStr&    _fileName,
                                                     istream&        _in,
                                                     MLClassListPtr  _classes,
@@ -49,8 +79,6 @@ FileDescConstPtr  FeatureFileIOSparse::GetFileDesc (const KKStr&    _fileName,
                                                    )
 {
   _log.Level (20) << "FeatureFileIOSparse::GetFileDesc     FileName[" << _fileName << "]." << endl;
-  bool  eof = false;
-  bool  eol = true;
 
   _estSize = 0;
 
@@ -59,43 +87,46 @@ FileDescConstPtr  FeatureFileIOSparse::GetFileDesc (const KKStr&    _fileName,
   kkint32  featureNumMin = int32_max;
   kkint32  featureNumMax = int32_min;
 
-  while  (!eof)
+  TextLineReader  reader (_in);
+  TextLineReader::Line  line;
+
+  while  (reader.GetLine (line))
   {
-    KKStr  className;
-    GetToken (_in, " \t", className, eof, eol);
-    if  (eof)
-      break;
+    const char*  next = line.str;
+    const char*  end  = line.str + line.len;
+    const char*  token    = NULL;
+    const char*  tokenEnd = NULL;
 
-    if  (eol)
+    if  (!TextLineReader::NextField (next, end, " \t", token, tokenEnd))
     {
       //We have a blank line; we will ignore this line.
       continue;
     }
 
-    if  (className.StartsWith ("//"))
+    if  (((tokenEnd - token) >= 2)  &&  (token[0] == '/')  &&  (token[1] == '/'))
     {
-      // We have a comment line.  We will skip to end of line
-      while  ((!eol)  &&  (!eof))
-        GetToken (_in, " \t", className, eof, eol);
+      // We have a comment line.
       continue;
     }
 
     // Calling 'GetMLClassPtr' to make sure an instance of MLClass exists for 'className'.
+    KKStr  className;
+    className.Append (token, (kkuint32)(tokenEnd - token));
     _classes->GetMLClassPtr (className);
 
-    KKStr  field;
-    GetToken (_in, " \t", field, eof, eol);
-    while  (!eol)
+    while  (TextLineReader::NextField (next, end, " \t", token, tokenEnd))
     {
-      KKStr  featureNumStr = field.ExtractToken (":");
-      kkint32 featureNum = atoi (featureNumStr.Str ());
+      // An empty field or one without a number still counts as feature number 0.
+      const char*  numStr = NULL;
+      const char*  numEnd = NULL;
+      TextLineReader::NextToken (token, tokenEnd, ":", numStr, numEnd);
+      kkint32 featureNum = TextLineReader::ParseInt32 (numStr, numEnd);
 
       if  (featureNum > featureNumMax)
         featureNumMax = featureNum;
 
       if  (featureNum < featureNumMin)
         featureNumMin = featureNum;
-     GetToken (_in, " \t", field, eof, eol);
     }
     _estSize++;
   }
@@ -137,9 +168,6 @@ FeatureVectorListPtr  FeatureFileIOSparse::LoadFile (const KKStr&      _fileName
       << "    _changesMade: " << _changesMade << endl
       << endl;
   
-  bool  eof = false;
-  bool  eol = true;
-
   KKStr  rootName = osGetRootName (_fileName);
 
   kkint32  numOfFeatures = _fileDesc->NumOfFields ();
@@ -149,70 +177,89 @@ FeatureVectorListPtr  FeatureFileIOSparse::LoadFile (const KKStr&      _fileName
   kkint32  minFeatureNum = _fileDesc->SparseMinFeatureNum ();
   kkint32  maxFeatureNum = minFeatureNum + numOfFeatures - 1;
 
-  if  (!_maxCount)
-    _maxCount = UINT32_MAX;
+  kkuint32  maxToLoad = (_maxCount  ? _maxCount.value () : uint32_max);
 
   FeatureVectorListPtr  examples = new FeatureVectorList (_fileDesc, true);
 
-  while  ((!eof)   &&  (!_cancelFlag)  &&  (examples->QueueSize () < _maxCount))
-  {
-    KKStr  className;
-    
-    GetToken (_in, " \t", className, eof, eol);
-    if  (eof)
-      break;
-
-    if  (eol)
+  auto  parseLine = [numOfFeatures, minFeatureNum, maxFeatureNum] (const TextLineReader::Line&  line,  SparseParsedLine&  parsed)
     {
-      // We have a blank line;
-      continue;
-    }
+      const char*  next = line.str;
+      const char*  end  = line.str + line.len;
+      const char*  token    = NULL;
+      const char*  tokenEnd = NULL;
 
-    if  (className.StartsWith ("//"))
-    {
-      // We have a coment line.  We will skip to end of line
-      while  ((!eol)  &&  (!eof))
-        GetToken (_in, " \t", className, eof, eol);
-      continue;
-    }
+      if  (!TextLineReader::NextField (next, end, " \t", token, tokenEnd))
+        return;   // We have a blank line;
+
+      if  (((tokenEnd - token) >= 2)  &&  (token[0] == '/')  &&  (token[1] == '/'))
+        return;   // We have a comment line.
 
-    MLClassPtr mlClass = _classes.GetMLClassPtr (className);
+      parsed.blank = false;
+      parsed.className.Append (token, (kkuint32)(tokenEnd - token));
 
-    FeatureVectorPtr  example = new FeatureVector (numOfFeatures);
-    example->MLClass (mlClass);
+      FeatureVectorPtr  example = new FeatureVector (numOfFeatures);
+      parsed.example = example;
 
-    KKStr  exampleName = rootName + "_" + StrFormatInt (lineCount, "ZZZZZZ0");
-    example->ExampleFileName (exampleName);
+      while  (TextLineReader::NextField (next, end, " \t", token, tokenEnd))
+      {
+        // Split the same way as 'KKStr::ExtractToken (":")';  the value is whatever follows the first ':' after the number.
+        const char*  numStr = NULL;
+        const char*  numEnd = NULL;
+        TextLineReader::NextToken (token, tokenEnd, ":", numStr, numEnd);
+
+        kkint32 featureNum = TextLineReader::ParseInt32 (numStr, numEnd);
+        if  ((featureNum < minFeatureNum)  ||  (featureNum > maxFeatureNum))
+        {
+          parsed.featureNumOutOfRange = true;
+          parsed.badFeatureNum.Append (numStr, (kkuint32)(numEnd - numStr));
+          return;
+        }
+
+        float  value = (float)TextLineReader::ParseDouble (token, tokenEnd);
+        example->AddFeatureData (featureNum - minFeatureNum,  value);
+      }
+    };
 
-    KKStr  field = "";
-    GetToken (_in, " \t", field, eof, eol);
-    while  ((!eol)  &&  (!eof))  
+  auto  processLine = [&] (SparseParsedLine&  parsed) -> bool
     {
-      KKStr  featureNumStr = field.ExtractToken (":");
-      kkint32 featureNum = atoi (featureNumStr.Str ());
-      
-      if  ((featureNum < minFeatureNum)  ||  (featureNum > maxFeatureNum))
+      if  (examples->QueueSize () >= maxToLoad)
+        return false;
+
+      if  (parsed.blank)
+        return true;
+
+      if  (parsed.featureNumOutOfRange)
       {
         _log << endl << endl
-             << "FeatureFileIOSparse::LoadFile  FeatureNum[" <<  featureNumStr << "] out of range." << endl
+             << "FeatureFileIOSparse::LoadFile  FeatureNum[" <<  parsed.badFeatureNum << "] out of range." << endl
              << "                               FileName["  << _fileName << "]  LineNum[" << lineCount << "]."  << endl
              << endl;
-        _errorMessage << "FeatureNum[" << featureNumStr << "]  is out of range.";
-        delete  example;   example  = NULL;
+        _errorMessage << "FeatureNum[" << parsed.badFeatureNum << "]  is out of range.";
         delete  examples;  examples = NULL;
-        return  NULL;
+        return  false;
       }
 
-      featureNum = featureNum - minFeatureNum;
+      FeatureVectorPtr  example = parsed.example;
+      parsed.example = NULL;
 
-      float  value = (float)atof (field.Str ());
-      example->AddFeatureData (featureNum,  value);
-      GetToken (_in, " \t", field, eof, eol);
-    }
+      example->MLClass (_classes.GetMLClassPtr (parsed.className));
+      example->ExampleFileName (rootName + "_" + StrFormatInt (lineCount, "ZZZZZZ0"));
+
+      examples->PushOnBack (example);
 
-    examples->PushOnBack (example);
+      lineCount++;
+      return  true;
+    };
 
-    lineCount++;
+  try
+  {
+    ParseLinesInParallel<SparseParsedLine> (_in, _cancelFlag, parseLine, processLine);
+  }
+  catch  (...)
+  {
+    delete  examples;
+    examples = NULL;
+    throw;
   }
 
   _log.Level (10) << "FeatureFileIOSparse::LoadFile  Done" << endl
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <ctype.h>
+#include <string.h>
 #include <time.h>
 #include <string>
 #include <iostream>
@@ -15,6 +16,7 @@ using namespace std;
 #include "OSservices.h"
 #include "RunLog.h"
 #include "KKStr.h"
+#include "TextLineReader.h"
 using namespace  KKB;
 
 #include "FeatureFileIOUCI.h"
@@ -39,6 +41,47 @@ FeatureFileIOUCI::~FeatureFileIOUCI ()
 
 
 
+namespace  KKMLL
+{
+  /** @brief  Result of parsing one line of a UCI data file;  filled in by one of the parsing threads. */
+  struct  UCIParsedLine
+  {
+    UCIParsedLine ():
+        blank     (true),
+        className (),
+        example   (NULL)
+    {}
+
+    ~UCIParsedLine ()
+    {
+      delete  example;
+      example = NULL;
+    }
+
+    bool              blank;
+    KKStr             className;
+    FeatureVectorPtr  example;
+  };  /* UCIParsedLine */
+}
+
+
+
+/** @brief  Returns true if 'line' is empty or a comment once leading white space is skipped. */
+static  bool  UCILineIsBlank (const TextLineReader::Line&  line)
+{
+  const char*  next = line.str;
+  const char*  end  = line.str + line.len;
+  while  ((next < end)  &&  (*next != 0)  &&  strchr ("\n\r\t ", *next))
+    ++next;
+
+  if  (next >= end)
+    return  true;
+
+  return  (((end - next) >= 2)  &&  (next[0] == '/')  &&  (next[1] == '/'));
+}
+
+
+
 FileDescConstPtr  FeatureFileIOUCI::GetFileDesc (const KKStr&    _fileName,
                                                  istream&        _in,
                                                  MLClassListPtr  _classes,
@@ -56,37 +99,54 @@ FileDescConstPtr  FeatureFileIOUCI::GetFileDesc (const KKStr&    _fileName,
   kkint32  numOfFields       = 0;
   kkint32  numFieldsThisLine = 0;
 
-  KKStr  ln;
-  bool   eof;
-
   _estSize = 0;
 
-  GetLine (_in, ln, eof);
-  while  (!eof)
+  TextLineReader  reader (_in);
+  TextLineReader::Line  line;
+
+  while  (reader.GetLine (line))
   {
-    ln.TrimLeft ();
-    ln.TrimRight ();
-    if  ((!ln.StartsWith ("//"))  &&  (!ln.Empty ()))
+    if  (UCILineIsBlank (line))
+      continue;
+
+    const char*  next = line.str;
+    const char*  end  = line.str + line.len;
+    const char*  token    = NULL;
+    const char*  tokenEnd = NULL;
+    const char*  lastToken    = NULL;
+    const char*  lastTokenEnd = NULL;
+
+    while  ((end > next)  &&  ((end[-1] == ' ')  ||  (end[-1] == '\t')))
+      --end;
+
+    // The last token on the line is the class name.
+    numFieldsThisLine = -1;
+    while  (TextLineReader::NextToken (next, end, " ,\t", token, tokenEnd))
     {
-      numFieldsThisLine = 0;
+      numFieldsThisLine++;
+      lastToken    = token;
+      lastTokenEnd = tokenEnd;
+    }
 
-      KKStr  className = ln.ExtractToken (" ,\n\r\t");
-      while (!ln.Empty ())
-      {
-        numFieldsThisLine++;
-        className = ln.ExtractToken (" ,\n\r\t");
-      }
+    if  (lastToken  &&  ((lastTokenEnd + 1) < end))
+    {
+      // More than one delimiter after the last token, ex: "1,2,,";  counted as one more field with an empty class name.
+      numFieldsThisLine++;
+      lastToken = lastTokenEnd = NULL;
+    }
 
-      if  (className.Empty ())
-        className = "UnKnown";
+    KKStr  className;
+    if  (lastToken)
+      className.Append (lastToken, (kkuint32)(lastTokenEnd - lastToken));
 
-      // make sure that 'className' exists in '_classes'.
-      _classes->GetMLClassPtr (className);
+    if  (className.Empty ())
+      className = "UnKnown";
 
-      numOfFields = Max (numOfFields, numFieldsThisLine);
-      _estSize++;
-    }
-    GetLine (_in, ln, eof);
+    // make sure that 'className' exists in '_classes'.
+    _classes->GetMLClassPtr (className);
+
+    numOfFields = Max (numOfFields, numFieldsThisLine);
+    _estSize++;
   }
 
   bool  alreadyExists = false;
@@ -122,32 +182,49 @@ FeatureVectorListPtr  FeatureFileIOUCI::LoadFile (const KKStr&      _fileName,
   kkint32  numOfFeatures = _fileDesc->NumOfFields ();
   kkint32  lineCount = 0;
 
-  KKStr  ln (256);
-  bool  eof;
-
-  if  (!_maxCount)
-    _maxCount = uint32_max;
+  kkuint32  maxToLoad = (_maxCount  ? _maxCount.value () : uint32_max);
 
   FeatureVectorListPtr  examples = new FeatureVectorList (_fileDesc, true);
 
-  GetLine (_in, ln, eof);
-  while  (!eof  &&  (examples->QueueSize () < _maxCount))
-  {
-    ln.TrimLeft ();
-    ln.TrimRight ();
-
-    if  ((!ln.StartsWith ("//"))  &&  (!ln.Empty ()))
+  auto  parseLine = [numOfFeatures] (const TextLineReader::Line&  line,  UCIParsedLine&  parsed)
     {
+      if  (UCILineIsBlank (line))
+        return;
+
+      parsed.blank = false;
+
+      const char*  next = line.str;
+      const char*  end  = line.str + line.len;
+      const char*  token    = NULL;
+      const char*  tokenEnd = NULL;
+
       FeatureVectorPtr  example = new FeatureVector (numOfFeatures);
-  
+      parsed.example = example;
+
       for  (kkint32 featureNum = 0;  featureNum < numOfFeatures;  featureNum++)
       {
-        KKStr  featureStr = ln.ExtractToken (" ,\n\r\t");
-        example->AddFeatureData (featureNum, (float)atof (featureStr.Str ()));
+        float  value = 0.0f;
+        if  (TextLineReader::NextToken (next, end, " ,\t", token, tokenEnd))
+          value = (float)TextLineReader::ParseDouble (token, tokenEnd);
+        example->AddFeatureData (featureNum, value);
       }
 
-      KKStr  className = ln.ExtractToken (" ,\n\r\t");
-      MLClassPtr mlClass = _classes.GetMLClassPtr (className);
+      if  (TextLineReader::NextToken (next, end, " ,\t", token, tokenEnd))
+        parsed.className.Append (token, (kkuint32)(tokenEnd - token));
+    };
+
+  auto  processLine = [&] (UCIParsedLine&  parsed) -> bool
+    {
+      if  (examples->QueueSize () >= maxToLoad)
+        return false;
+
+      if  (parsed.blank)
+        return true;
+
+      FeatureVectorPtr  example = parsed.example;
+      parsed.example = NULL;
+
+      MLClassPtr mlClass = _classes.GetMLClassPtr (parsed.className);
       example->MLClass (mlClass);
 
       KKStr  imageFileName = rootName + "_" + StrFormatInt (lineCount, "ZZZZZZ0");
@@ -156,8 +233,18 @@ FeatureVectorListPtr  FeatureFileIOUCI::LoadFile (const KKStr&      _fileName,
       examples->PushOnBack (example);
 
       lineCount++;
-    }
-    GetLine (_in, ln, eof);
+      return  true;
+    };
+
+  try
+  {
+    ParseLinesInParallel<UCIParsedLine> (_in, _cancelFlag, parseLine, processLine);
+  }
+  catch  (...)
+  {
+    delete  examples;
+    examples = NULL;
+    throw;
   }
 
   _log.Level (50) << "FeatureFileIOUCI::LoadFile  _changesMade: " << _changesMade << "  _cancelFlag: " << _cancelFlag << endl;
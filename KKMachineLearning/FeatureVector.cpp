@@ -39,6 +39,7 @@ FeatureVector::FeatureVector (kkuint32  _numOfFeatures):
         probability      (-1.0),
         trainWeight      (1.0f),
         validated        (false),
+        featureDataInBlock (false),
         version          (-1)
 {
   AllocateFeatureDataArray ();
@@ -58,6 +59,7 @@ FeatureVector::FeatureVector (const FeatureVector&  _example):
   probability      (_example.probability),
   trainWeight      (_example.trainWeight),
   validated        (_example.validated),
+  featureDataInBlock (false),
   version          (-1)
 {
   if  (_example.featureData)
@@ -72,7 +74,54 @@ FeatureVector::FeatureVector (const FeatureVector&  _example):
 
 FeatureVector::~FeatureVector ()
 {
-  delete[] featureData;  featureData = NULL;
+  ReleaseFeatureData ();
+}
+
+
+
+void  FeatureVector::ReleaseFeatureData ()
+{
+  if  (featureDataInBlock)
+  {
+    FeatureDataBlock::BlockContaining (featureData)->ReleaseReference ();
+    featureDataInBlock = false;
+  }
+  else
+  {
+    delete[] featureData;
+  }
+  featureData = NULL;
+}  /* ReleaseFeatureData */
+
+
+
+void  FeatureVector::MoveFeatureDataTo (FeatureDataBlockPtr  block,
+                                        kkuint32             row
+                                       )
+{
+  KKCheck ((row < block->NumRows ())  &&  (numOfFeatures <= block->NumCols ()),
+           "FeatureVector::MoveFeatureDataTo   Row: " << row << " NumRows: " << block->NumRows () << "  NumOfFeatures: " << numOfFeatures << " NumCols: " << block->NumCols ())
+
+  float*  dest = block->Row (row);
+  if  (featureData)
+  {
+    for  (kkuint32 x = 0;  x < numOfFeatures;  ++x)
+      dest[x] = featureData[x];
+  }
+
+  block->AddReference ();
+  ReleaseFeatureData ();
+  featureData        = dest;
+  featureDataInBlock = true;
+}  /* MoveFeatureDataTo */
+
+
+
+FeatureDataBlockPtr  FeatureVector::FeatureBlock ()  const
+{
+  if  (!featureDataInBlock)
+    return  NULL;
+  return  FeatureDataBlock::BlockContaining (featureData);
 }
 
 
@@ -82,7 +131,7 @@ kkMemSize  FeatureVector::MemoryConsumedEstimated ()  const
   kkMemSize  memoryConsumedEstimated = sizeof (FeatureVector)
     +  exampleFileName.MemoryConsumedEstimated ();
 
-  if  (featureData)
+  if  (featureData  &&  (!featureDataInBlock))
     memoryConsumedEstimated += sizeof (float) * numOfFeatures;
   
   return  memoryConsumedEstimated;
@@ -116,7 +165,7 @@ void  FeatureVector::ResetNumOfFeatures (kkuint32  newNumOfFeatures)
       newFeatureData[x] = 0.0f;
   }
 
-  delete  featureData;
+  ReleaseFeatureData ();
   featureData   = newFeatureData;
   numOfFeatures = newNumOfFeatures;
 }  /* ResetNumOfFeatures */
@@ -125,8 +174,7 @@ void  FeatureVector::ResetNumOfFeatures (kkuint32  newNumOfFeatures)
 
 void  FeatureVector::AllocateFeatureDataArray ()
 {
-  if  (featureData)
-    delete  featureData;
+  ReleaseFeatureData ();
 
   featureData = new float [numOfFeatures];
 
@@ -1162,6 +1210,52 @@ void  SplitImagesAmongstFolds (kkint32                numOfFolds,
 
 
 
+void  FeatureVectorList::ConsolidateFeatureData ()
+{
+  if  (QueueSize () < 1)
+    return;
+
+  kkuint32  numCols = numOfFeatures;
+  for  (auto fv: *this)
+    numCols = Max (numCols, fv->NumOfFeatures ());
+
+  FeatureDataBlockPtr  block = new FeatureDataBlock ((kkuint32)QueueSize (), numCols);
+  kkuint32  row = 0;
+  for  (auto fv: *this)
+  {
+    fv->MoveFeatureDataTo (block, row);
+    ++row;
+  }
+
+  // Each example now holds its own reference;  give up the one we were created with.
+  block->ReleaseReference ();
+}  /* ConsolidateFeatureData */
+
+
+
+FeatureDataBlockPtr  FeatureVectorList::ContiguousFeatureData ()  const
+{
+  if  (QueueSize () < 1)
+    return  NULL;
+
+  FeatureDataBlockPtr  block = (*this)[0].FeatureBlock ();
+  if  ((!block)  ||  (block->NumRows () != (kkuint32)QueueSize ())  ||  (block->NumCols () < numOfFeatures))
+    return  NULL;
+
+  // Only a member of 'block' can point at one of its rows.
+  kkuint32  row = 0;
+  for  (auto fv: *this)
+  {
+    if  (fv->FeatureData () != block->Row (row))
+      return  NULL;
+    ++row;
+  }
+
+  return  block;
+}  /* ContiguousFeatureData */
+
+
+
 void  FeatureVectorList::CalcStatsForFeatureNum (kkuint32 _featureNum,
                                                  kkint32& _count,
                                                  float&   _total,
@@ -1190,6 +1284,27 @@ void  FeatureVectorList::CalcStatsForFeatureNum (kkuint32 _featureNum,
   if  (QueueSize () == 0)
     return;
     
+  FeatureDataBlockPtr  block = ContiguousFeatureData ();
+  if  (block)
+  {
+    FeatureDataBlock::ColumnView  column = block->Column (_featureNum);
+    for  (kkuint32 row = 0;  row < column.Count ();  ++row)
+      _total += column[row];
+    _count = (kkint32)column.Count ();
+    _mean = _total / (float)_count;
+
+    float  totalSquareDelta = 0.0f;
+    for  (kkuint32 row = 0;  row < column.Count ();  ++row)
+    {
+      float  delta = column[row] - _mean;
+      totalSquareDelta += delta * delta;
+    }
+
+    _var     = totalSquareDelta / (float)_count;
+    _stdDev  = sqrt (_var);
+    return;
+  }
+
   iterator  idx;
 
   for  (idx = begin (); idx != end ();  idx++)
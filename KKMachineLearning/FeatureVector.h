@@ -23,6 +23,7 @@
 #include "RunLog.h"
 
 #include "Attribute.h"
+#include "FeatureDataBlock.h"
 #include "ClassStatistic.h"
 #include "FeatureFileIO.h"
 #include "FeatureNumList.h"
@@ -134,6 +135,17 @@ namespace KKMLL
 
     void    ResetNumOfFeatures (kkuint32  newNumOfFeatures);  /**< Used to reallocate memory for feature data. */
 
+    /** @brief  Block that holds this example's feature data;  NULL when it has an array of its own. */
+    FeatureDataBlockPtr  FeatureBlock () const;
+
+    /**
+     *@brief  Copies the feature data into row 'row' of 'block' and from then on uses that row instead of its own array.
+     *@details  Takes a reference on 'block';  see 'FeatureVectorList::ConsolidateFeatureData'.
+     */
+    void    MoveFeatureDataTo (FeatureDataBlockPtr  block,
+                               kkuint32             row
+                              );
+
     void    AddFeatureData (kkuint32  _featureNum,   /**< Indicates which feature number to update.  */
                             float     _featureData   /**< New value to assign to '_featureNum'.      */
                            );
@@ -152,6 +164,11 @@ namespace KKMLL
     kkuint32       numOfFeatures;
 
 
+  private:
+    /** @brief  Deletes 'featureData' or releases the block whose row it points to. */
+    void  ReleaseFeatureData ();
+
+
   private:
     float          breakTie;         /**< @brief The difference in probability between the two most likeliest
                                       * classes as per the classifier. 
@@ -177,6 +194,10 @@ namespace KKMLL
                                       * an expert; was introduced when the DataBase was implemented.
                                       */
 
+    bool           featureDataInBlock;  /**< @brief  'featureData' is a row of a 'FeatureDataBlock' rather than our own array;
+                                         * a flag rather than a pointer to the block so that it fits in padding.
+                                         */
+
     kkint16        version;          /**< This is the same versionNumber as in FeatureVectorList
                                       * It is related to the Feature calculation routine.  This
                                       * will assist in us changing the feature calculations in the 
@@ -314,6 +335,24 @@ namespace KKMLL
     FeatureVectorPtr  BinarySearchByName (const KKStr&  _imageFileName)  const;
 
 
+    /**
+     *@brief  Moves the feature data of every example into one contiguous 'FeatureDataBlock';  row 'x' = example 'x'.
+     *@details  The examples keep working as before, their feature data now being rows of the block.  Scans across
+     * examples such as 'CalcStatsForFeatureNum' and 'NormalizationParms' will then use the block directly for as
+     * long as the list is not reordered or added to;  call again after that to consolidate the new order.
+     * 'Model::TrainModel' does this to the copy of the training examples it normalizes.
+     */
+    void  ConsolidateFeatureData ();
+
+
+    /**
+     *@brief  Returns the block holding the feature data of every example in list order;  NULL when there is none.
+     *@details  Only true after 'ConsolidateFeatureData' and for as long as the list has not been reordered or
+     * changed;  verified on every call by comparing each example's data with its row.
+     */
+    FeatureDataBlockPtr  ContiguousFeatureData ()  const;
+
+
     void  CalcStatsForFeatureNum (kkuint32  _featureNum,
                                   kkint32&  _count,
                                   float&    _total,
@@ -5,9 +5,11 @@
 #include "FirstIncludes.h"
 
 #include <errno.h>
+#include <atomic>
 #include <istream>
 #include <iostream>
 #include <queue>
+#include <sstream>
 #include <math.h>
 #include <map>
 #include <vector>
@@ -23,6 +25,7 @@ using namespace std;
 #include "ConvexHull.h"
 #include "KKBaseTypes.h"
 #include "GlobalGoalKeeper.h"
+#include "KKThreadPool.h"
 #include "Raster.h"
 #include "RunLog.h"
 using namespace KKB;
@@ -172,31 +175,101 @@ const  KKStr  GrayScaleImagesFVProducer::featureNames[] =
 
 
 
+/**
+ *@brief  The pixel areas and row pointers behind the three work rasters that 'ComputeFeatureVector' uses.
+ *@details  Memory is only reallocated when an image needs more than the previous ones did so a run of similar
+ * sized images does not allocate anything.
+ */
+class  GrayScaleImagesFVProducer::WorkRasters
+{
+public:
+  WorkRasters ():
+      areaCapacity (0),
+      rowCapacity  (0)
+  {
+    for  (kkint32 x = 0;  x < 3;  ++x)
+    {
+      areas[x] = NULL;
+      rows[x]  = NULL;
+    }
+  }
+
+  ~WorkRasters ()
+  {
+    for  (kkint32 x = 0;  x < 3;  ++x)
+    {
+      delete[]  areas[x];  areas[x] = NULL;
+      delete[]  rows[x];   rows[x]  = NULL;
+    }
+  }
+
+  /** @brief  Makes sure the three rasters can hold 'totPixels' pixels in 'height' rows without reallocating. */
+  void  Grow (kkint32  totPixels,
+              kkint32  height
+             )
+  {
+    for  (kkint32 x = 0;  x < 3;  ++x)
+    {
+      if  (totPixels > areaCapacity)
+      {
+        delete[]  areas[x];
+        areas[x] = new uchar[totPixels];
+      }
+      if  (height > rowCapacity)
+      {
+        delete[]  rows[x];
+        rows[x] = new uchar*[height];
+      }
+    }
+    areaCapacity = Max (areaCapacity, totPixels);
+    rowCapacity  = Max (rowCapacity,  height);
+  }
+
+  /** @brief  Lays out the three rasters as 'height' x 'width';  their contents are undefined. */
+  void  Reserve (kkint32  height,
+                 kkint32  width
+                )
+  {
+    Grow (height * width, height);
+
+    for  (kkint32 x = 0;  x < 3;  ++x)
+    {
+      uchar*  wp = areas[x];
+      for  (kkint32 row = 0;  row < height;  ++row)
+      {
+        rows[x][row] = wp;
+        wp += width;
+      }
+    }
+  }
+
+  uchar*   Area (kkint32 x)  const  {return areas[x];}
+  uchar**  Rows (kkint32 x)  const  {return rows[x];}
+
+private:
+  uchar*   areas[3];
+  kkint32  areaCapacity;
+  uchar**  rows[3];
+  kkint32  rowCapacity;
+};  /* WorkRasters */
+
+
+
 GrayScaleImagesFVProducer::GrayScaleImagesFVProducer (FactoryFVProducerPtr  _factory):
     FeatureVectorProducer ("GrayScaleImages", _factory),
     totPixsForMorphOps (4000000),
-    workRaster1Area (NULL),
-    workRaster2Area (NULL),
-    workRaster3Area (NULL),
-    workRaster1Rows (NULL),
-    workRaster2Rows (NULL),
-    workRaster3Rows (NULL)
+    workRasters        ()
 {
-  workRaster1Area = new uchar[totPixsForMorphOps];
-  workRaster2Area = new uchar[totPixsForMorphOps];
-  workRaster3Area = new uchar[totPixsForMorphOps];
+  workRasters.push_back (new WorkRasters ());
 }
 
 
 
 GrayScaleImagesFVProducer::~GrayScaleImagesFVProducer ()
 {
-  delete  workRaster1Area;  workRaster1Area = NULL;
-  delete  workRaster2Area;  workRaster2Area = NULL;
-  delete  workRaster3Area;  workRaster3Area = NULL;
-  delete  workRaster1Rows;  workRaster1Rows = NULL;
-  delete  workRaster2Rows;  workRaster2Rows = NULL;
-  delete  workRaster3Rows;  workRaster3Rows = NULL;
+  for  (auto  work: workRasters)
+    delete  work;
+  workRasters.clear ();
 }
 
 
@@ -318,6 +391,104 @@ FeatureVectorPtr  GrayScaleImagesFVProducer::ComputeFeatureVector (const Raster&
                                                                    RunLog&           runLog
                                                                   )
                                                                   
+{
+  return  ComputeFeatureVector (srcImage, knownClass, intermediateImages, priorReductionFactor, *workRasters[0], runLog);
+}
+
+
+
+FeatureVectorListPtr  GrayScaleImagesFVProducer::ComputeFeatureVectors (const RasterList&  images,
+                                                                        const MLClassPtr   knownClass,
+                                                                        kkuint32           numThreads,
+                                                                        RunLog&            runLog
+                                                                       )
+{
+  kkuint32  numImages = images.QueueSize ();
+
+  // Feature extraction is CPU bound;  more threads than processors only adds switching.
+  numThreads = Min (KKThreadPool::ResolveNumThreads (numThreads), KKThreadPool::ResolveNumThreads (0));
+  numThreads = Min (numThreads, Max (numImages, (kkuint32)1));
+
+  // The work rasters are kept between calls and grown once, up front, to fit the largest image.
+  kkint32  maxTotPixels = 0;
+  kkint32  maxHeight    = 0;
+  for  (auto  image: images)
+  {
+    maxTotPixels = Max (maxTotPixels, Min (image->TotPixels (), totPixsForMorphOps));
+    maxHeight    = Max (maxHeight,    image->Height ());
+  }
+  while  (workRasters.size () < numThreads)
+    workRasters.push_back (new WorkRasters ());
+  for  (kkuint32 threadIdx = 0;  threadIdx < numThreads;  ++threadIdx)
+    workRasters[threadIdx]->Grow (maxTotPixels, maxHeight);
+
+  FeatureVectorListPtr  fvs = ManufacturFeatureVectorList (true);
+
+  if  (numThreads <= 1)
+  {
+    // Same work as calling 'ComputeFeatureVector' for each image.
+    for  (auto  image: images)
+    {
+      FeatureVectorPtr  fv = ComputeFeatureVector (*image, knownClass, NULL, 1.0f, *workRasters[0], runLog);
+      if  (fv)
+      {
+        fv->ExampleFileName (image->FileName ());
+        fvs->PushOnBack (fv);
+      }
+      else
+      {
+        runLog.Level (-1) << "GrayScaleImagesFVProducer::ComputeFeatureVectors   ***ERROR***   No FeatureVector computed for: " << image->FileName () << endl;
+      }
+    }
+    return  fvs;
+  }
+
+  // Each thread pulls the next image and keeps reusing its own work rasters;  'RunLog' is not thread safe so
+  // each thread logs to its own stream which is copied to 'runLog' afterwards.
+  vector<FeatureVectorPtr>  results (numImages, NULL);
+  vector<ostringstream>     threadMsgs (numThreads);
+  atomic<kkuint32>          nextIdx (0);
+  KKThreadPool::ParallelFor (numThreads, numThreads, [&](kkuint32 threadIdx)
+    {
+      WorkRasters&  work = *workRasters[threadIdx];
+      RunLog  threadLog (threadMsgs[threadIdx]);
+      for  (kkuint32 idx = nextIdx++;  idx < numImages;  idx = nextIdx++)
+      {
+        RasterPtr  image = images.IdxToPtr (idx);
+        FeatureVectorPtr  fv = ComputeFeatureVector (*image, knownClass, NULL, 1.0f, work, threadLog);
+        if  (fv)
+          fv->ExampleFileName (image->FileName ());
+        results[idx] = fv;
+      }
+    }
+  );
+
+  for  (auto&  msgs: threadMsgs)
+  {
+    if  (!msgs.str ().empty ())
+      runLog.Level (-1) << msgs.str ();
+  }
+
+  for  (kkuint32 idx = 0;  idx < numImages;  ++idx)
+  {
+    if  (results[idx])
+      fvs->PushOnBack (results[idx]);
+    else
+      runLog.Level (-1) << "GrayScaleImagesFVProducer::ComputeFeatureVectors   ***ERROR***   No FeatureVector computed for: " << images.IdxToPtr (idx)->FileName () << endl;
+  }
+
+  return  fvs;
+}  /* ComputeFeatureVectors */
+
+
+
+FeatureVectorPtr  GrayScaleImagesFVProducer::ComputeFeatureVector (const Raster&     srcImage,
+                                                                   const MLClassPtr  knownClass,
+                                                                   RasterListPtr     intermediateImages,
+                                                                   float             priorReductionFactor,
+                                                                   WorkRasters&      work,
+                                                                   RunLog&           runLog
+                                                                  )
 {
   FeatureVectorPtr  fv = new FeatureVector (maxNumOfFeatures);
   fv->MLClass (knownClass);
@@ -328,13 +499,7 @@ FeatureVectorPtr  GrayScaleImagesFVProducer::ComputeFeatureVector (const Raster&
   kkint32 areaBeforeReduction = 0;
   float  weighedSizeBeforeReduction = 0.0f;
 
-  kkint32 row = 0;
-
   kkuint32  intensityHistBuckets[8];
-  srcImage.CalcAreaAndIntensityFeatures (areaBeforeReduction, 
-                                         weighedSizeBeforeReduction,
-                                         intensityHistBuckets
-                                        );
 
   kkint32 srcHeight = srcImage.Height ();
   kkint32 srcWidth  = srcImage.Width  ();
@@ -357,34 +522,29 @@ FeatureVectorPtr  GrayScaleImagesFVProducer::ComputeFeatureVector (const Raster&
   float    totalReductionMultiple = priorReductionFactor * (float)reductionMultiple;
   float    totalReductionMultipleSquared = totalReductionMultiple * totalReductionMultiple;
 
-  delete  workRaster1Rows;  workRaster1Rows = new uchar*[reducedHeight];
-  delete  workRaster2Rows;  workRaster2Rows = new uchar*[reducedHeight];
-  delete  workRaster3Rows;  workRaster3Rows = new uchar*[reducedHeight];
-
-  uchar*  wp1 = workRaster1Area;
-  uchar*  wp2 = workRaster2Area;
-  uchar*  wp3 = workRaster3Area;
-
-  for  (row = 0;  row < reducedHeight; ++row)
-  {
-    workRaster1Rows[row] = wp1;
-    workRaster2Rows[row] = wp2;
-    workRaster3Rows[row] = wp3;
-    wp1 += reducedWidth;
-    wp2 += reducedWidth;
-    wp3 += reducedWidth;
-  }
+  work.Reserve (reducedHeight, reducedWidth);
 
-  Raster  workRaster1 (reducedHeight, reducedWidth, workRaster1Area, workRaster1Rows);
-  Raster  workRaster2 (reducedHeight, reducedWidth, workRaster2Area, workRaster2Rows);
-  Raster  workRaster3 (reducedHeight, reducedWidth, workRaster3Area, workRaster3Rows);
+  Raster  workRaster1 (reducedHeight, reducedWidth, work.Area (0), work.Rows (0));
+  Raster  workRaster2 (reducedHeight, reducedWidth, work.Area (1), work.Rows (1));
+  Raster  workRaster3 (reducedHeight, reducedWidth, work.Area (2), work.Rows (2));
 
   Raster const * initRaster = NULL;
   RasterPtr      wr1        = NULL;
   RasterPtr      wr2        = NULL;
 
+  float  convexf = 0.0;
+  float  centralMoments[9];
+  float  centralMomentsWeighted[9];
+
+  kkint32  pixelCountReduced = 0;
+  float    pixelCountWeightedReduced = 0.0f;
+
   if  (reductionMultiple > 1)
   {
+    srcImage.CalcAreaAndIntensityFeatures (areaBeforeReduction, 
+                                           weighedSizeBeforeReduction,
+                                           intensityHistBuckets
+                                          );
     try
     {
       ReductionByMultiple (reductionMultiple, srcImage, workRaster1);
@@ -392,6 +552,7 @@ FeatureVectorPtr  GrayScaleImagesFVProducer::ComputeFeatureVector (const Raster&
     catch  (...)
     {
       runLog.Level (-1) << endl << "GrayScaleImagesFVProducer::ComputeFeatureVector   ***ERROR***  Exception calling 'ReductionByMultiple'."  << endl << endl;
+      delete  fv;
       return NULL;
     }
     initRaster = &workRaster1;
@@ -400,6 +561,15 @@ FeatureVectorPtr  GrayScaleImagesFVProducer::ComputeFeatureVector (const Raster&
   }
   else
   {
+    // The moments are computed from the same image as the area so both come out of one pass.
+    srcImage.CalcAreaIntensityAndCentralMoments (areaBeforeReduction, 
+                                                 weighedSizeBeforeReduction,
+                                                 intensityHistBuckets,
+                                                 pixelCountReduced,
+                                                 pixelCountWeightedReduced,
+                                                 centralMoments,
+                                                 centralMomentsWeighted
+                                                );
     initRaster = &srcImage;
     wr1        = &workRaster1;
     wr2        = &workRaster2;
@@ -411,25 +581,18 @@ FeatureVectorPtr  GrayScaleImagesFVProducer::ComputeFeatureVector (const Raster&
       featureData[tp] = 9999999;
     return fv;
   }
-  
-  float  convexf = 0.0;
-  float  centralMoments[9];
-  float  centralMomentsWeighted[9];
-
-  kkint32  pixelCountReduced = 0;
-  float    pixelCountWeightedReduced = 0.0f;
 
-  initRaster->ComputeCentralMoments (pixelCountReduced, pixelCountWeightedReduced, centralMoments, centralMomentsWeighted);
+  if  (reductionMultiple > 1)
+    initRaster->ComputeCentralMoments (pixelCountReduced, pixelCountWeightedReduced, centralMoments, centralMomentsWeighted);
 
 
   float  edgeMomentf[9];
 
-  initRaster->Dilation (wr1);
-  wr1->Dilation (wr2);
+  // Dilation twice, FillHole, Erosion and Edge;  the chains on either side of FillHole are each done in one pass.
+  initRaster->DoubleDilation (wr2);
   wr2->FillHole (wr1);
 
-  wr1->Erosion (wr2);
-  wr2->Edge (wr1);
+  wr1->ErosionEdge (wr2, wr1);
   wr1->CentralMoments (edgeMomentf);
   if  (intermediateImages)
   {
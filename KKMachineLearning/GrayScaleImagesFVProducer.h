@@ -31,6 +31,21 @@ namespace KKMLL
                                                      RunLog&           runLog
                                                     );
 
+    /**
+     *@brief  Computes a FeatureVector for each image in 'images' spreading the work over 'numThreads' threads.
+     *@details  The results are in the same order as 'images' and identical to calling 'ComputeFeatureVector' on
+     * each one;  every thread has its own set of work rasters.  Each FeatureVector's 'ExampleFileName' is set to
+     * its image's 'FileName';  images that a FeatureVector could not be computed for are logged and left out.
+     * The work rasters are sized for the largest image before any is processed and kept for the next call;  with
+     * one thread the images are processed on the calling thread exactly as 'ComputeFeatureVector' would.
+     *@param[in]  numThreads  Number of threads to use, never more than one per processor;  zero indicates one per processor.
+     */
+    FeatureVectorListPtr  ComputeFeatureVectors (const RasterList&  images,
+                                                 const MLClassPtr   knownClass,
+                                                 kkuint32           numThreads,
+                                                 RunLog&            runLog
+                                                );
+
     static FileDescConstPtr  DefineFileDescStatic ();
 
     /**
@@ -52,12 +67,22 @@ namespace KKMLL
 
 
   private:
+    class  WorkRasters;
+
     void  BinarizeImageByThreshold (uchar          lower,
                                     uchar          upper,
                                     const Raster&  src,
                                     Raster&        dest
                                    );
 
+    FeatureVectorPtr  ComputeFeatureVector (const Raster&     srcImage,
+                                            const MLClassPtr  knownClass,
+                                            RasterListPtr     intermediateImages,
+                                            float             priorReductionFactor,
+                                            WorkRasters&      work,
+                                            RunLog&           runLog
+                                           );
+
     void  ReductionByMultiple (kkint32        multiple,
                                const Raster&  srcRaster,
                                Raster&        destRaster
@@ -74,12 +99,9 @@ namespace KKMLL
                                   * constraint.
                                   */
 
-    uchar*   workRaster1Area;
-    uchar*   workRaster2Area;
-    uchar*   workRaster3Area;
-    uchar**  workRaster1Rows;
-    uchar**  workRaster2Rows;
-    uchar**  workRaster3Rows;
+    std::vector<WorkRasters*>  workRasters;  /**< [0] is used by 'ComputeFeatureVector';  'ComputeFeatureVectors' gives each of
+                                              * its threads one of them.  Kept between calls so they are only grown.
+                                              */
 
     static  kkint16  maxNumOfFeatures;
     static  const    kkint32  SizeThreshold;
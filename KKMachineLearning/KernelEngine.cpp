@@ -0,0 +1,827 @@
+#include "FirstIncludes.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#if  defined(_M_X64)  ||  defined(_M_IX86)  ||  defined(__x86_64__)  ||  defined(__i386__)
+#  define  KERNELENGINE_X86
+#  if  defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#  include <immintrin.h>
+#endif
+
+#if  defined(KERNELENGINE_X86)  &&  (defined(__GNUC__)  ||  defined(__clang__))
+#  define  KERNELENGINE_TARGET_AVX2  __attribute__((target("avx2")))
+#else
+#  define  KERNELENGINE_TARGET_AVX2
+#endif
+
+
+#include "KKBaseTypes.h"
+#include "KKException.h"
+#include "KKStr.h"
+using namespace  KKB;
+
+
+#include "KernelEngine.h"
+#include "FeatureNumList.h"
+#include "FeatureVector.h"
+using namespace  KKMLL;
+
+
+
+namespace
+{
+  // Rows are padded to a multiple of 8 floats or 4 doubles (one AVX register) and aligned on 32 bytes.
+  const  kkint32  floatsPerBlock  = 8;
+  const  kkint32  doublesPerBlock = 4;
+  const  size_t   rowAlignment    = 32;
+
+
+  template<typename T>
+  T*  AlignedRows (T*  block)
+  {
+    size_t  addr = (size_t)block;
+    return  (T*)((addr + rowAlignment - 1) & ~(rowAlignment - 1));
+  }
+
+
+  double  DotScalar (const float*  x,  const float*  y,  kkint32  stride)
+  {
+    double  sum = 0.0;
+    for  (kkint32 idx = 0;  idx < stride;  ++idx)
+      sum += x[idx] * y[idx];
+    return  sum;
+  }
+
+
+  double  SquaredDistanceScalar (const float*  x,  const float*  y,  kkint32  stride)
+  {
+    double  sum = 0.0;
+    for  (kkint32 idx = 0;  idx < stride;  ++idx)
+    {
+      double  d = x[idx] - y[idx];
+      sum += d * d;
+    }
+    return  sum;
+  }
+
+
+  double  DotScalarD (const double*  x,  const double*  y,  kkint32  stride)
+  {
+    double  sum = 0.0;
+    for  (kkint32 idx = 0;  idx < stride;  ++idx)
+      sum += x[idx] * y[idx];
+    return  sum;
+  }
+
+
+  double  SquaredDistanceScalarD (const double*  x,  const double*  y,  kkint32  stride)
+  {
+    double  sum = 0.0;
+    for  (kkint32 idx = 0;  idx < stride;  ++idx)
+    {
+      double  d = x[idx] - y[idx];
+      sum += d * d;
+    }
+    return  sum;
+  }
+
+
+#if  defined(KERNELENGINE_X86)
+  double  HorizontalSumSSE2 (__m128d  v)
+  {
+    return  _mm_cvtsd_f64 (_mm_add_sd (v, _mm_unpackhi_pd (v, v)));
+  }
+
+
+  double  DotSSE2 (const float*  x,  const float*  y,  kkint32  stride)
+  {
+    __m128d  acc0 = _mm_setzero_pd ();
+    __m128d  acc1 = _mm_setzero_pd ();
+    for  (kkint32 idx = 0;  idx < stride;  idx += 4)
+    {
+      __m128  p = _mm_mul_ps (_mm_load_ps (x + idx), _mm_load_ps (y + idx));
+      acc0 = _mm_add_pd (acc0, _mm_cvtps_pd (p));
+      acc1 = _mm_add_pd (acc1, _mm_cvtps_pd (_mm_movehl_ps (p, p)));
+    }
+    return  HorizontalSumSSE2 (_mm_add_pd (acc0, acc1));
+  }
+
+
+  double  SquaredDistanceSSE2 (const float*  x,  const float*  y,  kkint32  stride)
+  {
+    __m128d  acc0 = _mm_setzero_pd ();
+    __m128d  acc1 = _mm_setzero_pd ();
+    for  (kkint32 idx = 0;  idx < stride;  idx += 4)
+    {
+      __m128   d   = _mm_sub_ps (_mm_load_ps (x + idx), _mm_load_ps (y + idx));
+      __m128d  dLo = _mm_cvtps_pd (d);
+      __m128d  dHi = _mm_cvtps_pd (_mm_movehl_ps (d, d));
+      acc0 = _mm_add_pd (acc0, _mm_mul_pd (dLo, dLo));
+      acc1 = _mm_add_pd (acc1, _mm_mul_pd (dHi, dHi));
+    }
+    return  HorizontalSumSSE2 (_mm_add_pd (acc0, acc1));
+  }
+
+
+  double  DotSSE2D (const double*  x,  const double*  y,  kkint32  stride)
+  {
+    __m128d  acc0 = _mm_setzero_pd ();
+    __m128d  acc1 = _mm_setzero_pd ();
+    for  (kkint32 idx = 0;  idx < stride;  idx += 4)
+    {
+      acc0 = _mm_add_pd (acc0, _mm_mul_pd (_mm_load_pd (x + idx),     _mm_load_pd (y + idx)));
+      acc1 = _mm_add_pd (acc1, _mm_mul_pd (_mm_load_pd (x + idx + 2), _mm_load_pd (y + idx + 2)));
+    }
+    return  HorizontalSumSSE2 (_mm_add_pd (acc0, acc1));
+  }
+
+
+  double  SquaredDistanceSSE2D (const double*  x,  const double*  y,  kkint32  stride)
+  {
+    __m128d  acc0 = _mm_setzero_pd ();
+    __m128d  acc1 = _mm_setzero_pd ();
+    for  (kkint32 idx = 0;  idx < stride;  idx += 4)
+    {
+      __m128d  d0 = _mm_sub_pd (_mm_load_pd (x + idx),     _mm_load_pd (y + idx));
+      __m128d  d1 = _mm_sub_pd (_mm_load_pd (x + idx + 2), _mm_load_pd (y + idx + 2));
+      acc0 = _mm_add_pd (acc0, _mm_mul_pd (d0, d0));
+      acc1 = _mm_add_pd (acc1, _mm_mul_pd (d1, d1));
+    }
+    return  HorizontalSumSSE2 (_mm_add_pd (acc0, acc1));
+  }
+
+
+  KERNELENGINE_TARGET_AVX2
+  double  HorizontalSumAVX2 (__m256d  v)
+  {
+    __m128d  s = _mm_add_pd (_mm256_castpd256_pd128 (v), _mm256_extractf128_pd (v, 1));
+    return  _mm_cvtsd_f64 (_mm_add_sd (s, _mm_unpackhi_pd (s, s)));
+  }
+
+
+  KERNELENGINE_TARGET_AVX2
+  double  DotAVX2 (const float*  x,  const float*  y,  kkint32  stride)
+  {
+    __m256d  acc0 = _mm256_setzero_pd ();
+    __m256d  acc1 = _mm256_setzero_pd ();
+    for  (kkint32 idx = 0;  idx < stride;  idx += 8)
+    {
+      __m256  p = _mm256_mul_ps (_mm256_load_ps (x + idx), _mm256_load_ps (y + idx));
+      acc0 = _mm256_add_pd (acc0, _mm256_cvtps_pd (_mm256_castps256_ps128 (p)));
+      acc1 = _mm256_add_pd (acc1, _mm256_cvtps_pd (_mm256_extractf128_ps (p, 1)));
+    }
+    return  HorizontalSumAVX2 (_mm256_add_pd (acc0, acc1));
+  }
+
+
+  KERNELENGINE_TARGET_AVX2
+  double  SquaredDistanceAVX2 (const float*  x,  const float*  y,  kkint32  stride)
+  {
+    __m256d  acc0 = _mm256_setzero_pd ();
+    __m256d  acc1 = _mm256_setzero_pd ();
+    for  (kkint32 idx = 0;  idx < stride;  idx += 8)
+    {
+      __m256   d   = _mm256_sub_ps (_mm256_load_ps (x + idx), _mm256_load_ps (y + idx));
+      __m256d  dLo = _mm256_cvtps_pd (_mm256_castps256_ps128 (d));
+      __m256d  dHi = _mm256_cvtps_pd (_mm256_extractf128_ps (d, 1));
+      acc0 = _mm256_add_pd (acc0, _mm256_mul_pd (dLo, dLo));
+      acc1 = _mm256_add_pd (acc1, _mm256_mul_pd (dHi, dHi));
+    }
+    return  HorizontalSumAVX2 (_mm256_add_pd (acc0, acc1));
+  }
+
+
+  // No FMA;  the product is rounded before it is added the same as the scalar loop.
+  KERNELENGINE_TARGET_AVX2
+  double  DotAVX2D (const double*  x,  const double*  y,  kkint32  stride)
+  {
+    __m256d  acc = _mm256_setzero_pd ();
+    for  (kkint32 idx = 0;  idx < stride;  idx += 4)
+      acc = _mm256_add_pd (acc, _mm256_mul_pd (_mm256_load_pd (x + idx), _mm256_load_pd (y + idx)));
+    return  HorizontalSumAVX2 (acc);
+  }
+
+
+  KERNELENGINE_TARGET_AVX2
+  double  SquaredDistanceAVX2D (const double*  x,  const double*  y,  kkint32  stride)
+  {
+    __m256d  acc = _mm256_setzero_pd ();
+    for  (kkint32 idx = 0;  idx < stride;  idx += 4)
+    {
+      __m256d  d = _mm256_sub_pd (_mm256_load_pd (x + idx), _mm256_load_pd (y + idx));
+      acc = _mm256_add_pd (acc, _mm256_mul_pd (d, d));
+    }
+    return  HorizontalSumAVX2 (acc);
+  }
+
+
+  /** Four rows at a time so each load of the query is used four times. */
+  KERNELENGINE_TARGET_AVX2
+  void  Dot4AVX2 (const float*  q,
+                  const float*  r0,  const float*  r1,  const float*  r2,  const float*  r3,
+                  kkint32       stride,
+                  double*       results
+                 )
+  {
+    __m256d  a0 = _mm256_setzero_pd ();
+    __m256d  a1 = _mm256_setzero_pd ();
+    __m256d  a2 = _mm256_setzero_pd ();
+    __m256d  a3 = _mm256_setzero_pd ();
+    __m256d  b0 = _mm256_setzero_pd ();
+    __m256d  b1 = _mm256_setzero_pd ();
+    __m256d  b2 = _mm256_setzero_pd ();
+    __m256d  b3 = _mm256_setzero_pd ();
+    for  (kkint32 idx = 0;  idx < stride;  idx += 8)
+    {
+      __m256  qv = _mm256_load_ps (q + idx);
+      __m256  p0 = _mm256_mul_ps (qv, _mm256_load_ps (r0 + idx));
+      __m256  p1 = _mm256_mul_ps (qv, _mm256_load_ps (r1 + idx));
+      __m256  p2 = _mm256_mul_ps (qv, _mm256_load_ps (r2 + idx));
+      __m256  p3 = _mm256_mul_ps (qv, _mm256_load_ps (r3 + idx));
+      a0 = _mm256_add_pd (a0, _mm256_cvtps_pd (_mm256_castps256_ps128 (p0)));
+      b0 = _mm256_add_pd (b0, _mm256_cvtps_pd (_mm256_extractf128_ps (p0, 1)));
+      a1 = _mm256_add_pd (a1, _mm256_cvtps_pd (_mm256_castps256_ps128 (p1)));
+      b1 = _mm256_add_pd (b1, _mm256_cvtps_pd (_mm256_extractf128_ps (p1, 1)));
+      a2 = _mm256_add_pd (a2, _mm256_cvtps_pd (_mm256_castps256_ps128 (p2)));
+      b2 = _mm256_add_pd (b2, _mm256_cvtps_pd (_mm256_extractf128_ps (p2, 1)));
+      a3 = _mm256_add_pd (a3, _mm256_cvtps_pd (_mm256_castps256_ps128 (p3)));
+      b3 = _mm256_add_pd (b3, _mm256_cvtps_pd (_mm256_extractf128_ps (p3, 1)));
+    }
+    results[0] = HorizontalSumAVX2 (_mm256_add_pd (a0, b0));
+    results[1] = HorizontalSumAVX2 (_mm256_add_pd (a1, b1));
+    results[2] = HorizontalSumAVX2 (_mm256_add_pd (a2, b2));
+    results[3] = HorizontalSumAVX2 (_mm256_add_pd (a3, b3));
+  }
+
+
+  bool  ProcessorSupportsAVX2 ()
+  {
+#  if  defined(_MSC_VER)
+    int  info[4];
+    __cpuid (info, 0);
+    if  (info[0] < 7)
+      return false;
+
+    __cpuid (info, 1);
+    bool  osxsave = (info[2] & (1 << 27)) != 0;
+    bool  avx     = (info[2] & (1 << 28)) != 0;
+    if  (!osxsave  ||  !avx)
+      return false;
+
+    // The OS must be saving the YMM registers on a context switch.
+    if  ((_xgetbv (0) & 6) != 6)
+      return false;
+
+    __cpuidex (info, 7, 0);
+    return  (info[1] & (1 << 5)) != 0;
+#  elif  defined(__GNUC__)  ||  defined(__clang__)
+    __builtin_cpu_init ();
+    return  __builtin_cpu_supports ("avx2") != 0;
+#  else
+    return false;
+#  endif
+  }
+#endif  /* KERNELENGINE_X86 */
+
+
+  typedef  double  (*PairFunc)  (const float*   x,  const float*   y,  kkint32  stride);
+  typedef  double  (*PairFuncD) (const double*  x,  const double*  y,  kkint32  stride);
+
+
+  KernelEngine::InstructionSet  BestSupportedInstructionSet ()
+  {
+#if  defined(KERNELENGINE_X86)
+    if  (ProcessorSupportsAVX2 ())
+      return  KernelEngine::InstructionSet::AVX2;
+    return  KernelEngine::InstructionSet::SSE2;   // Every x86 processor that can run a 64 bit OS has SSE2.
+#else
+    return  KernelEngine::InstructionSet::Scalar;
+#endif
+  }
+
+
+  std::atomic<int>  activeInstructionSet ((int)BestSupportedInstructionSet ());
+
+
+  KernelEngine::InstructionSet  ActiveIS ()
+  {
+    return  (KernelEngine::InstructionSet)activeInstructionSet.load (std::memory_order_relaxed);
+  }
+
+
+  PairFunc  DotFunc (KernelEngine::InstructionSet  is)
+  {
+#if  defined(KERNELENGINE_X86)
+    if  (is == KernelEngine::InstructionSet::AVX2)  return  DotAVX2;
+    if  (is == KernelEngine::InstructionSet::SSE2)  return  DotSSE2;
+#else
+    (void)is;
+#endif
+    return  DotScalar;
+  }
+
+
+  PairFunc  SquaredDistanceFunc (KernelEngine::InstructionSet  is)
+  {
+#if  defined(KERNELENGINE_X86)
+    if  (is == KernelEngine::InstructionSet::AVX2)  return  SquaredDistanceAVX2;
+    if  (is == KernelEngine::InstructionSet::SSE2)  return  SquaredDistanceSSE2;
+#else
+    (void)is;
+#endif
+    return  SquaredDistanceScalar;
+  }
+
+
+  PairFuncD  DotFuncD (KernelEngine::InstructionSet  is)
+  {
+#if  defined(KERNELENGINE_X86)
+    if  (is == KernelEngine::InstructionSet::AVX2)  return  DotAVX2D;
+    if  (is == KernelEngine::InstructionSet::SSE2)  return  DotSSE2D;
+#else
+    (void)is;
+#endif
+    return  DotScalarD;
+  }
+
+
+  PairFuncD  SquaredDistanceFuncD (KernelEngine::InstructionSet  is)
+  {
+#if  defined(KERNELENGINE_X86)
+    if  (is == KernelEngine::InstructionSet::AVX2)  return  SquaredDistanceAVX2D;
+    if  (is == KernelEngine::InstructionSet::SSE2)  return  SquaredDistanceSSE2D;
+#else
+    (void)is;
+#endif
+    return  SquaredDistanceScalarD;
+  }
+
+
+  template<typename Func, typename T, typename Rows>
+  void  PairOneToMany (Func            f,
+                       const T*        query,
+                       const Rows&     rows,
+                       const kkint32*  rowIdxs,
+                       kkint32         count,
+                       double*         results
+                      )
+  {
+    kkint32  stride = rows.Stride ();
+    if  (rowIdxs)
+    {
+      for  (kkint32 x = 0;  x < count;  ++x)
+        results[x] = f (query, rows.Row (rowIdxs[x]), stride);
+    }
+    else
+    {
+      for  (kkint32 x = 0;  x < count;  ++x)
+        results[x] = f (query, rows.Row (x), stride);
+    }
+  }
+}  /* namespace */
+
+
+
+PackedFeatureVectors::PackedFeatureVectors (const FeatureVectorList&  _examples,
+                                            const FeatureNumList&     _selFeatures
+                                           ):
+  data         (NULL),
+  dataBlock    (NULL),
+  numCols      (_selFeatures.NumSelFeatures ()),
+  numRows      (_examples.QueueSize ()),
+  squaredNorms (NULL),
+  stride       (StrideForNumCols (_selFeatures.NumSelFeatures ()))
+{
+  Allocate ();
+  for  (kkint32 row = 0;  row < numRows;  ++row)
+    PackRow (row, _examples[row], _selFeatures);
+}
+
+
+
+PackedFeatureVectors::PackedFeatureVectors (kkint32  _numRows,
+                                            kkint32  _numCols
+                                           ):
+  data         (NULL),
+  dataBlock    (NULL),
+  numCols      (_numCols),
+  numRows      (_numRows),
+  squaredNorms (NULL),
+  stride       (StrideForNumCols (_numCols))
+{
+  Allocate ();
+}
+
+
+
+PackedFeatureVectors::~PackedFeatureVectors ()
+{
+  delete[]  dataBlock;     dataBlock    = NULL;
+  delete[]  squaredNorms;  squaredNorms = NULL;
+  data = NULL;
+}
+
+
+
+kkint32  PackedFeatureVectors::StrideForNumCols (kkint32  numCols)
+{
+  kkint32  s = ((numCols + floatsPerBlock - 1) / floatsPerBlock) * floatsPerBlock;
+  return  (s < floatsPerBlock) ? floatsPerBlock : s;
+}
+
+
+
+void  PackedFeatureVectors::Allocate ()
+{
+  if  ((numRows < 0)  ||  (numCols < 0))
+    throw KKException ("PackedFeatureVectors::Allocate   ***ERROR***   NumRows[" + StrFromInt32 (numRows) + "]  NumCols[" + StrFromInt32 (numCols) + "] can not be negative.");
+
+  kkMemSize  numFloats = (kkMemSize)numRows * stride;
+  kkMemSize  extra     = rowAlignment / sizeof (float);
+
+  dataBlock = new float[numFloats + extra];
+  data = AlignedRows (dataBlock);
+  memset (data, 0, numFloats * sizeof (float));
+
+  squaredNorms = new double[numRows > 0 ? numRows : 1];
+  for  (kkint32 x = 0;  x < numRows;  ++x)
+    squaredNorms[x] = 0.0;
+}  /* Allocate */
+
+
+
+kkMemSize  PackedFeatureVectors::MemoryConsumedEstimated ()  const
+{
+  return  sizeof (PackedFeatureVectors) +
+          ((kkMemSize)numRows * stride + rowAlignment / sizeof (float)) * sizeof (float) +
+          (kkMemSize)numRows * sizeof (double);
+}
+
+
+
+void  PackedFeatureVectors::PackRow (kkint32                row,
+                                     const FeatureVector&   example,
+                                     const FeatureNumList&  selFeatures
+                                    )
+{
+  if  ((row < 0)  ||  (row >= numRows))
+    throw KKException ("PackedFeatureVectors::PackRow   ***ERROR***   Row[" + StrFromInt32 (row) + "] out of range;  NumRows[" + StrFromInt32 (numRows) + "].");
+
+  float*        dest = data + (kkMemSize)row * stride;
+  const float*  src  = example.FeatureData ();
+  double        sumSquares = 0.0;
+  for  (kkint32 col = 0;  col < numCols;  ++col)
+  {
+    float  v = src[selFeatures[col]];
+    dest[col] = v;
+    sumSquares += v * v;
+  }
+  squaredNorms[row] = sumSquares;
+}  /* PackRow */
+
+
+
+void  PackedFeatureVectors::PackRow (kkint32       row,
+                                     const float*  values
+                                    )
+{
+  if  ((row < 0)  ||  (row >= numRows))
+    throw KKException ("PackedFeatureVectors::PackRow   ***ERROR***   Row[" + StrFromInt32 (row) + "] out of range;  NumRows[" + StrFromInt32 (numRows) + "].");
+
+  float*  dest = data + (kkMemSize)row * stride;
+  double  sumSquares = 0.0;
+  for  (kkint32 col = 0;  col < numCols;  ++col)
+  {
+    float  v = values[col];
+    dest[col] = v;
+    sumSquares += v * v;
+  }
+  squaredNorms[row] = sumSquares;
+}  /* PackRow */
+
+
+
+KKStr  KernelEngine::InstructionSetToStr (InstructionSet  is)
+{
+  switch  (is)
+  {
+  case  InstructionSet::Scalar:  return "Scalar";
+  case  InstructionSet::SSE2:    return "SSE2";
+  case  InstructionSet::AVX2:    return "AVX2";
+  }
+  return  "";
+}
+
+
+
+KernelEngine::InstructionSet  KernelEngine::ActiveInstructionSet ()
+{
+  return  ActiveIS ();
+}
+
+
+
+void  KernelEngine::ForceInstructionSet (InstructionSet  is)
+{
+  InstructionSet  best = BestSupportedInstructionSet ();
+  if  ((int)is > (int)best)
+    is = best;
+  activeInstructionSet.store ((int)is);
+}
+
+
+
+double  KernelEngine::Dot (const float*  x,
+                           const float*  y,
+                           kkint32       stride
+                          )
+{
+  return  DotFunc (ActiveIS ()) (x, y, stride);
+}
+
+
+
+double  KernelEngine::SquaredDistance (const float*  x,
+                                       const float*  y,
+                                       kkint32       stride
+                                      )
+{
+  return  SquaredDistanceFunc (ActiveIS ()) (x, y, stride);
+}
+
+
+
+void  KernelEngine::DotOneToMany (const float*                 query,
+                                  const PackedFeatureVectors&  rows,
+                                  const kkint32*               rowIdxs,
+                                  kkint32                      count,
+                                  double*                      results
+                                 )
+{
+  InstructionSet  is = ActiveIS ();
+#if  defined(KERNELENGINE_X86)
+  if  (is == InstructionSet::AVX2)
+  {
+    kkint32  stride = rows.Stride ();
+    kkint32  x = 0;
+    for  (;  (x + 4) <= count;  x += 4)
+    {
+      if  (rowIdxs)
+        Dot4AVX2 (query, rows.Row (rowIdxs[x]), rows.Row (rowIdxs[x + 1]), rows.Row (rowIdxs[x + 2]), rows.Row (rowIdxs[x + 3]), stride, results + x);
+      else
+        Dot4AVX2 (query, rows.Row (x), rows.Row (x + 1), rows.Row (x + 2), rows.Row (x + 3), stride, results + x);
+    }
+    for  (;  x < count;  ++x)
+      results[x] = DotAVX2 (query, rows.Row (rowIdxs ? rowIdxs[x] : x), stride);
+    return;
+  }
+#endif
+  PairOneToMany (DotFunc (is), query, rows, rowIdxs, count, results);
+}  /* DotOneToMany */
+
+
+
+void  KernelEngine::SquaredDistanceOneToMany (const float*                 query,
+                                              const PackedFeatureVectors&  rows,
+                                              const kkint32*               rowIdxs,
+                                              kkint32                      count,
+                                              double*                      results
+                                             )
+{
+  PairOneToMany (SquaredDistanceFunc (ActiveIS ()), query, rows, rowIdxs, count, results);
+}
+
+
+
+namespace
+{
+  // Number of rows evaluated against all queries before moving on;  sized so a block of
+  // rows with a few hundred features stays within the L2 cache.
+  const  kkint32  manyToManyRowBlock = 64;
+}
+
+
+
+void  KernelEngine::DotManyToMany (const PackedFeatureVectors&  queries,
+                                   const PackedFeatureVectors&  rows,
+                                   double*                      results
+                                  )
+{
+  if  (queries.Stride () != rows.Stride ())
+    throw KKException ("KernelEngine::DotManyToMany   ***ERROR***   queries and rows have different strides.");
+
+  kkint32  numRows = rows.NumRows ();
+  for  (kkint32 blockStart = 0;  blockStart < numRows;  blockStart += manyToManyRowBlock)
+  {
+    kkint32  blockLen = numRows - blockStart;
+    if  (blockLen > manyToManyRowBlock)
+      blockLen = manyToManyRowBlock;
+
+    kkint32  rowIdxs[manyToManyRowBlock];
+    for  (kkint32 x = 0;  x < blockLen;  ++x)
+      rowIdxs[x] = blockStart + x;
+
+    for  (kkint32 q = 0;  q < queries.NumRows ();  ++q)
+      DotOneToMany (queries.Row (q), rows, rowIdxs, blockLen, results + (kkMemSize)q * numRows + blockStart);
+  }
+}  /* DotManyToMany */
+
+
+
+void  KernelEngine::SquaredDistanceManyToMany (const PackedFeatureVectors&  queries,
+                                               const PackedFeatureVectors&  rows,
+                                               double*                      results
+                                              )
+{
+  if  (queries.Stride () != rows.Stride ())
+    throw KKException ("KernelEngine::SquaredDistanceManyToMany   ***ERROR***   queries and rows have different strides.");
+
+  kkint32  numRows = rows.NumRows ();
+  for  (kkint32 blockStart = 0;  blockStart < numRows;  blockStart += manyToManyRowBlock)
+  {
+    kkint32  blockLen = numRows - blockStart;
+    if  (blockLen > manyToManyRowBlock)
+      blockLen = manyToManyRowBlock;
+
+    kkint32  rowIdxs[manyToManyRowBlock];
+    for  (kkint32 x = 0;  x < blockLen;  ++x)
+      rowIdxs[x] = blockStart + x;
+
+    for  (kkint32 q = 0;  q < queries.NumRows ();  ++q)
+      SquaredDistanceOneToMany (queries.Row (q), rows, rowIdxs, blockLen, results + (kkMemSize)q * numRows + blockStart);
+  }
+}  /* SquaredDistanceManyToMany */
+
+
+
+PackedDoubleVectors::PackedDoubleVectors (kkint32  _numRows,
+                                          kkint32  _numCols
+                                         ):
+  data         (NULL),
+  dataBlock    (NULL),
+  numCols      (_numCols),
+  numRows      (_numRows),
+  squaredNorms (NULL),
+  stride       (StrideForNumCols (_numCols))
+{
+  if  ((numRows < 0)  ||  (numCols < 0))
+    throw KKException ("PackedDoubleVectors   ***ERROR***   NumRows[" + StrFromInt32 (numRows) + "]  NumCols[" + StrFromInt32 (numCols) + "] can not be negative.");
+
+  kkMemSize  numDoubles = (kkMemSize)numRows * stride;
+  dataBlock = new double[numDoubles + rowAlignment / sizeof (double)];
+  data = AlignedRows (dataBlock);
+  memset (data, 0, numDoubles * sizeof (double));
+
+  squaredNorms = new double[numRows > 0 ? numRows : 1];
+  for  (kkint32 x = 0;  x < numRows;  ++x)
+    squaredNorms[x] = 0.0;
+}
+
+
+
+PackedDoubleVectors::~PackedDoubleVectors ()
+{
+  delete[]  dataBlock;     dataBlock    = NULL;
+  delete[]  squaredNorms;  squaredNorms = NULL;
+  data = NULL;
+}
+
+
+
+kkint32  PackedDoubleVectors::StrideForNumCols (kkint32  numCols)
+{
+  kkint32  s = ((numCols + doublesPerBlock - 1) / doublesPerBlock) * doublesPerBlock;
+  return  (s < doublesPerBlock) ? doublesPerBlock : s;
+}
+
+
+
+kkMemSize  PackedDoubleVectors::MemoryConsumedEstimated ()  const
+{
+  return  sizeof (PackedDoubleVectors) +
+          ((kkMemSize)numRows * stride + rowAlignment / sizeof (double)) * sizeof (double) +
+          (kkMemSize)numRows * sizeof (double);
+}
+
+
+
+void  PackedDoubleVectors::PackRow (kkint32        row,
+                                    const double*  values
+                                   )
+{
+  if  ((row < 0)  ||  (row >= numRows))
+    throw KKException ("PackedDoubleVectors::PackRow   ***ERROR***   Row[" + StrFromInt32 (row) + "] out of range;  NumRows[" + StrFromInt32 (numRows) + "].");
+
+  double*  dest = data + (kkMemSize)row * stride;
+  double   sumSquares = 0.0;
+  for  (kkint32 col = 0;  col < numCols;  ++col)
+  {
+    double  v = values[col];
+    dest[col] = v;
+    sumSquares += v * v;
+  }
+  squaredNorms[row] = sumSquares;
+}  /* PackRow */
+
+
+
+double  KernelEngine::Dot (const double*  x,
+                           const double*  y,
+                           kkint32        stride
+                          )
+{
+  return  DotFuncD (ActiveIS ()) (x, y, stride);
+}
+
+
+
+double  KernelEngine::SquaredDistance (const double*  x,
+                                       const double*  y,
+                                       kkint32        stride
+                                      )
+{
+  return  SquaredDistanceFuncD (ActiveIS ()) (x, y, stride);
+}
+
+
+
+void  KernelEngine::DotOneToMany (const double*               query,
+                                  const PackedDoubleVectors&  rows,
+                                  const kkint32*              rowIdxs,
+                                  kkint32                     count,
+                                  double*                     results
+                                 )
+{
+  PairOneToMany (DotFuncD (ActiveIS ()), query, rows, rowIdxs, count, results);
+}
+
+
+
+void  KernelEngine::SquaredDistanceOneToMany (const double*               query,
+                                              const PackedDoubleVectors&  rows,
+                                              const kkint32*              rowIdxs,
+                                              kkint32                     count,
+                                              double*                     results
+                                             )
+{
+  PairOneToMany (SquaredDistanceFuncD (ActiveIS ()), query, rows, rowIdxs, count, results);
+}
+
+
+
+void  KernelEngine::DotManyToMany (const PackedDoubleVectors&  queries,
+                                   const PackedDoubleVectors&  rows,
+                                   double*                     results
+                                  )
+{
+  if  (queries.Stride () != rows.Stride ())
+    throw KKException ("KernelEngine::DotManyToMany   ***ERROR***   queries and rows have different strides.");
+
+  kkint32  numRows = rows.NumRows ();
+  for  (kkint32 blockStart = 0;  blockStart < numRows;  blockStart += manyToManyRowBlock)
+  {
+    kkint32  blockLen = numRows - blockStart;
+    if  (blockLen > manyToManyRowBlock)
+      blockLen = manyToManyRowBlock;
+
+    kkint32  rowIdxs[manyToManyRowBlock];
+    for  (kkint32 x = 0;  x < blockLen;  ++x)
+      rowIdxs[x] = blockStart + x;
+
+    for  (kkint32 q = 0;  q < queries.NumRows ();  ++q)
+      DotOneToMany (queries.Row (q), rows, rowIdxs, blockLen, results + (kkMemSize)q * numRows + blockStart);
+  }
+}  /* DotManyToMany */
+
+
+
+void  KernelEngine::SquaredDistanceManyToMany (const PackedDoubleVectors&  queries,
+                                               const PackedDoubleVectors&  rows,
+                                               double*                     results
+                                              )
+{
+  if  (queries.Stride () != rows.Stride ())
+    throw KKException ("KernelEngine::SquaredDistanceManyToMany   ***ERROR***   queries and rows have different strides.");
+
+  kkint32  numRows = rows.NumRows ();
+  for  (kkint32 blockStart = 0;  blockStart < numRows;  blockStart += manyToManyRowBlock)
+  {
+    kkint32  blockLen = numRows - blockStart;
+    if  (blockLen > manyToManyRowBlock)
+      blockLen = manyToManyRowBlock;
+
+    kkint32  rowIdxs[manyToManyRowBlock];
+    for  (kkint32 x = 0;  x < blockLen;  ++x)
+      rowIdxs[x] = blockStart + x;
+
+    for  (kkint32 q = 0;  q < queries.NumRows ();  ++q)
+      SquaredDistanceOneToMany (queries.Row (q), rows, rowIdxs, blockLen, results + (kkMemSize)q * numRows + blockStart);
+  }
+}  /* SquaredDistanceManyToMany */
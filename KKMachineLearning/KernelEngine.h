@@ -0,0 +1,268 @@
+#if  !defined(_KERNELENGINE_)
+#define  _KERNELENGINE_
+/**
+ *@class  KKMLL::PackedFeatureVectors
+ *@brief  The selected features of a list of feature vectors copied into one contiguous aligned block of floats.
+ *@author  Kurt Kramer
+ *@details  Each vector occupies one row of 'Stride ()' floats; the first 'NumCols ()' are the selected
+ * features in the order they appear in the FeatureNumList and the remainder are zero.  Because padding is
+ * zero it contributes nothing to dot products or squared distances, so KernelEngine can process whole SIMD
+ * registers without a remainder loop.  Rows are aligned on a 32 byte boundary.
+ *
+ *@class  KKMLL::PackedDoubleVectors
+ *@brief  Same layout as PackedFeatureVectors for implementations whose scalar kernels work in double, such as
+ *        SVM233;  rows are padded to a multiple of 4 doubles.
+ *
+ *@class  KKMLL::KernelEngine
+ *@brief  Vectorized dot products and squared distances between PackedFeatureVectors rows.
+ *@details  The instruction set is chosen at run time: AVX2, SSE2 or a scalar fallback.  Products are formed in
+ * single precision the same as the original scalar loops ('fvX[fn] * fvY[fn]') and accumulated in double
+ * precision;  the only difference from the scalar loops is the order of summation.  Results therefore agree with
+ * the scalar implementations to within  1.0e-12 * sum(|x_i * y_i|)  for dot products and the equivalent
+ * expression for squared distances, for vectors of up to several thousand features.  The PackedDoubleVectors
+ * versions form their products in double, again the same as the scalar loops they replace, and agree with them
+ * to within the same tolerance.
+ *
+ * The kernel transforms (RBF, Polynomial, ...) are left to the caller since each SVM implementation has its own
+ * parameter structures.
+ */
+
+#include  "KKBaseTypes.h"
+#include  "KKStr.h"
+
+
+namespace KKMLL
+{
+  #if  !defined(_FeatureVector_Defined_)
+  class  FeatureVector;
+  typedef  FeatureVector*  FeatureVectorPtr;
+  class  FeatureVectorList;
+  typedef  FeatureVectorList*  FeatureVectorListPtr;
+  #endif
+
+  #if  !defined(_FeatureNumList_Defined_)
+  class  FeatureNumList;
+  typedef  FeatureNumList*  FeatureNumListPtr;
+  #endif
+
+
+  class  PackedFeatureVectors
+  {
+  public:
+    typedef  PackedFeatureVectors*  PackedFeatureVectorsPtr;
+
+    /** @brief  Packs the features in '_selFeatures' of every example in '_examples'; row 'x' = '_examples[x]'. */
+    PackedFeatureVectors (const FeatureVectorList&  _examples,
+                          const FeatureNumList&     _selFeatures
+                         );
+
+    /** @brief  Allocates '_numRows' rows of '_numCols' features, all zeros;  use 'PackRow' to populate. */
+    PackedFeatureVectors (kkint32  _numRows,
+                          kkint32  _numCols
+                         );
+
+    ~PackedFeatureVectors ();
+
+    kkMemSize  MemoryConsumedEstimated ()  const;
+
+    kkint32  NumCols ()  const  {return numCols;}
+    kkint32  NumRows ()  const  {return numRows;}
+    kkint32  Stride  ()  const  {return stride;}
+
+    const float*  Row (kkint32 row)  const  {return data + (kkMemSize)row * stride;}
+
+    /** @brief  Sum of the squares of the features in 'row';  computed when the row was packed. */
+    double  SquaredNorm (kkint32 row)  const  {return squaredNorms[row];}
+
+    void  PackRow (kkint32                row,
+                   const FeatureVector&   example,
+                   const FeatureNumList&  selFeatures
+                  );
+
+    /** @brief  Copies 'NumCols ()' floats from 'values' into 'row';  used to copy rows between instances. */
+    void  PackRow (kkint32       row,
+                   const float*  values
+                  );
+
+    /** @brief  Number of floats per row needed to hold 'numCols' features with padding. */
+    static  kkint32  StrideForNumCols (kkint32  numCols);
+
+  private:
+    PackedFeatureVectors (const PackedFeatureVectors&);
+    PackedFeatureVectors&  operator= (const PackedFeatureVectors&);
+
+    void  Allocate ();
+
+    float*    data;         /**< Aligned start of row 0.                                    */
+    float*    dataBlock;    /**< Block as allocated;  'data' points into it.                  */
+    kkint32   numCols;
+    kkint32   numRows;
+    double*   squaredNorms;
+    kkint32   stride;
+  };  /* PackedFeatureVectors */
+
+  typedef  PackedFeatureVectors::PackedFeatureVectorsPtr  PackedFeatureVectorsPtr;
+
+
+
+  class  PackedDoubleVectors
+  {
+  public:
+    typedef  PackedDoubleVectors*  PackedDoubleVectorsPtr;
+
+    /** @brief  Allocates '_numRows' rows of '_numCols' values, all zeros;  use 'PackRow' to populate. */
+    PackedDoubleVectors (kkint32  _numRows,
+                         kkint32  _numCols
+                        );
+
+    ~PackedDoubleVectors ();
+
+    kkMemSize  MemoryConsumedEstimated ()  const;
+
+    kkint32  NumCols ()  const  {return numCols;}
+    kkint32  NumRows ()  const  {return numRows;}
+    kkint32  Stride  ()  const  {return stride;}
+
+    const double*  Row (kkint32 row)  const  {return data + (kkMemSize)row * stride;}
+
+    /** @brief  Sum of the squares of the values in 'row', added in column order;  computed when the row was packed. */
+    double  SquaredNorm (kkint32 row)  const  {return squaredNorms[row];}
+
+    /** @brief  Copies 'NumCols ()' doubles from 'values' into 'row'. */
+    void  PackRow (kkint32        row,
+                   const double*  values
+                  );
+
+    /** @brief  Number of doubles per row needed to hold 'numCols' values with padding. */
+    static  kkint32  StrideForNumCols (kkint32  numCols);
+
+  private:
+    PackedDoubleVectors (const PackedDoubleVectors&);
+    PackedDoubleVectors&  operator= (const PackedDoubleVectors&);
+
+    double*   data;         /**< Aligned start of row 0.                                    */
+    double*   dataBlock;    /**< Block as allocated;  'data' points into it.                  */
+    kkint32   numCols;
+    kkint32   numRows;
+    double*   squaredNorms;
+    kkint32   stride;
+  };  /* PackedDoubleVectors */
+
+  typedef  PackedDoubleVectors::PackedDoubleVectorsPtr  PackedDoubleVectorsPtr;
+
+
+
+  class  KernelEngine
+  {
+  public:
+    enum class  InstructionSet: int
+    {
+      Scalar,
+      SSE2,
+      AVX2
+    };
+
+    static  KKB::KKStr  InstructionSetToStr (InstructionSet  is);
+
+    /** @brief  The instruction set currently being used;  the best one supported by the processor unless overridden. */
+    static  InstructionSet  ActiveInstructionSet ();
+
+    /**
+     *@brief  Overrides the instruction set detected at start up; meant for testing and benchmarking.
+     *@details  Requesting a set the processor does not support selects the best one it does support.
+     */
+    static  void  ForceInstructionSet (InstructionSet  is);
+
+    /** @brief  Dot product of two packed rows;  'stride' must be the Stride of the PackedFeatureVectors they came from. */
+    static  double  Dot (const float*  x,
+                         const float*  y,
+                         kkint32       stride
+                        );
+
+    static  double  SquaredDistance (const float*  x,
+                                     const float*  y,
+                                     kkint32       stride
+                                    );
+
+    /**
+     *@brief  Dot product of 'query' with 'count' rows of 'rows'.
+     *@param[in]  query    Packed query vector with the same stride as 'rows'.
+     *@param[in]  rows     Vectors to evaluate 'query' against.
+     *@param[in]  rowIdxs  If not NULL the row indexes to use;  otherwise rows 0 thru 'count - 1'.
+     *@param[in]  count    Number of rows to process.
+     *@param[out] results  'results[x]' = dot product of 'query' with row 'x' (or 'rowIdxs[x]').
+     */
+    static  void  DotOneToMany (const float*                 query,
+                                const PackedFeatureVectors&  rows,
+                                const kkint32*               rowIdxs,
+                                kkint32                      count,
+                                double*                      results
+                               );
+
+    static  void  SquaredDistanceOneToMany (const float*                 query,
+                                            const PackedFeatureVectors&  rows,
+                                            const kkint32*               rowIdxs,
+                                            kkint32                      count,
+                                            double*                      results
+                                           );
+
+    /**
+     *@brief  Dot product of every row in 'queries' with every row in 'rows'.
+     *@details  'results' must have room for  queries.NumRows () * rows.NumRows ()  entries; the result for query 'q'
+     * and row 'r' is placed in  results[q * rows.NumRows () + r].  Rows are processed in blocks so that they stay in
+     * cache while all the queries are evaluated against them.
+     */
+    static  void  DotManyToMany (const PackedFeatureVectors&  queries,
+                                 const PackedFeatureVectors&  rows,
+                                 double*                      results
+                                );
+
+    static  void  SquaredDistanceManyToMany (const PackedFeatureVectors&  queries,
+                                             const PackedFeatureVectors&  rows,
+                                             double*                      results
+                                            );
+
+
+    /** @brief  Dot product of two PackedDoubleVectors rows;  products are formed in double. */
+    static  double  Dot (const double*  x,
+                         const double*  y,
+                         kkint32        stride
+                        );
+
+    static  double  SquaredDistance (const double*  x,
+                                     const double*  y,
+                                     kkint32        stride
+                                    );
+
+    /** @brief  PackedDoubleVectors version of 'DotOneToMany';  'results[x]' is the same value 'Dot' returns for the row. */
+    static  void  DotOneToMany (const double*               query,
+                                const PackedDoubleVectors&  rows,
+                                const kkint32*              rowIdxs,
+                                kkint32                     count,
+                                double*                     results
+                               );
+
+    static  void  SquaredDistanceOneToMany (const double*               query,
+                                            const PackedDoubleVectors&  rows,
+                                            const kkint32*              rowIdxs,
+                                            kkint32                     count,
+                                            double*                     results
+                                           );
+
+    /** @brief  PackedDoubleVectors version of 'DotManyToMany';  'results[q * rows.NumRows () + r]' is the value 'DotOneToMany' gives. */
+    static  void  DotManyToMany (const PackedDoubleVectors&  queries,
+                                 const PackedDoubleVectors&  rows,
+                                 double*                     results
+                                );
+
+    static  void  SquaredDistanceManyToMany (const PackedDoubleVectors&  queries,
+                                             const PackedDoubleVectors&  rows,
+                                             double*                     results
+                                            );
+  };  /* KernelEngine */
+
+#define  _KernelEngine_Defined_
+
+}  /* KKMLL */
+
+#endif
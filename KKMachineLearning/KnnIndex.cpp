@@ -0,0 +1,502 @@
+#include "FirstIncludes.h"
+#include <stdio.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+
+#include "GlobalGoalKeeper.h"
+#include "KKBaseTypes.h"
+#include "KKException.h"
+#include "KKStr.h"
+#include "RunLog.h"
+#include "XmlStream.h"
+using namespace  KKB;
+
+
+#include "KnnIndex.h"
+#include "FeatureNumList.h"
+#include "FeatureVector.h"
+#include "KernelEngine.h"
+using namespace  KKMLL;
+
+
+
+namespace
+{
+  // Number of queries 'SearchBatch' evaluates against all the rows at a time when brute force is being used.
+  const  kkint32  queryBlockSize = 64;
+
+
+  // Orders the max-heap of candidates; ties in distance are broken by row so results do not depend on the order rows were visited.
+  bool  NeighborLess (const KnnIndex::Neighbor&  a,
+                      const KnnIndex::Neighbor&  b
+                     )
+  {
+    if  (a.distance != b.distance)
+      return  a.distance < b.distance;
+    return  a.row < b.row;
+  }
+}
+
+
+
+KnnIndex::KnnIndex ():
+  labels         (),
+  maxLeafRows    (0),
+  nodeEnd        (),
+  nodeLeft       (),
+  nodeRight      (),
+  nodeSplitDim   (),
+  nodeSplitValue (),
+  nodeStart      (),
+  points         (NULL),
+  rowIdxs        ()
+{
+}
+
+
+
+KnnIndex::KnnIndex (const FeatureVectorList&     examples,
+                    const FeatureNumList&        selFeatures,
+                    const std::vector<kkint32>&  _labels
+                   ):
+  labels         (),
+  maxLeafRows    (0),
+  nodeEnd        (),
+  nodeLeft       (),
+  nodeRight      (),
+  nodeSplitDim   (),
+  nodeSplitValue (),
+  nodeStart      (),
+  points         (NULL),
+  rowIdxs        ()
+{
+  kkint32  numRows = (kkint32)examples.QueueSize ();
+  kkint32  numCols = (kkint32)selFeatures.NumSelFeatures ();
+
+  if  ((kkint32)_labels.size () != numRows)
+    throw KKException ("KnnIndex::KnnIndex   ***ERROR***   Number of labels[" + StrFromInt32 ((kkint32)_labels.size ()) + "] does not match number of examples[" + StrFromInt32 (numRows) + "].");
+
+  PackedFeatureVectors  src (examples, selFeatures);
+
+  vector<kkint32>  order (numRows);
+  for  (kkint32 x = 0;  x < numRows;  ++x)
+    order[x] = x;
+
+  if  ((numCols <= MaxTreeDimensions)  &&  (numRows > LeafSize))
+    BuildTree (src, order, 0, numRows);
+
+  // Copy the rows in tree order so that every node covers a contiguous range of rows.
+  points = new PackedFeatureVectors (numRows, numCols);
+  labels.resize (numRows);
+  for  (kkint32 row = 0;  row < numRows;  ++row)
+  {
+    points->PackRow (row, src.Row (order[row]));
+    labels[row] = _labels[order[row]];
+  }
+
+  rowIdxs.resize (numRows);
+  for  (kkint32 x = 0;  x < numRows;  ++x)
+    rowIdxs[x] = x;
+}
+
+
+
+KnnIndex::~KnnIndex ()
+{
+  delete  points;
+  points = NULL;
+}
+
+
+
+kkMemSize  KnnIndex::MemoryConsumedEstimated ()  const
+{
+  kkMemSize  memoryConsumedEstimated = sizeof (KnnIndex) +
+        (kkMemSize)(labels.size () + nodeEnd.size () + nodeLeft.size () + nodeRight.size () + nodeSplitDim.size () + nodeStart.size () + rowIdxs.size ()) * sizeof (kkint32) +
+        (kkMemSize)nodeSplitValue.size () * sizeof (float);
+
+  if  (points)
+    memoryConsumedEstimated += points->MemoryConsumedEstimated ();
+
+  return  memoryConsumedEstimated;
+}
+
+
+
+/**
+ *@brief  Adds a node covering 'order[start]' thru 'order[end - 1]' and, unless it is a leaf, its children.
+ *@details  Splits at the median of the column with the largest spread; 'order' is rearranged so that rows
+ * less than the split value are in the first half.  The first node added is the root.
+ */
+void  KnnIndex::BuildTree (const PackedFeatureVectors&  src,
+                           std::vector<kkint32>&        order,
+                           kkint32                      start,
+                           kkint32                      end
+                          )
+{
+  kkint32  nodeIdx = NumNodes ();
+  nodeStart.push_back      (start);
+  nodeEnd.push_back        (end);
+  nodeSplitDim.push_back   (-1);
+  nodeSplitValue.push_back (0.0f);
+  nodeLeft.push_back       (-1);
+  nodeRight.push_back      (-1);
+
+  if  ((end - start) > LeafSize)
+  {
+    kkint32  splitDim = -1;
+    float    largestSpread = 0.0f;
+    for  (kkint32 col = 0;  col < src.NumCols ();  ++col)
+    {
+      float  minVal = src.Row (order[start])[col];
+      float  maxVal = minVal;
+      for  (kkint32 x = start + 1;  x < end;  ++x)
+      {
+        float  v = src.Row (order[x])[col];
+        if  (v < minVal)  minVal = v;
+        if  (v > maxVal)  maxVal = v;
+      }
+      if  ((maxVal - minVal) > largestSpread)
+      {
+        largestSpread = maxVal - minVal;
+        splitDim = col;
+      }
+    }
+
+    // When every row is identical there is nothing to split on;  the node stays a leaf.
+    if  (splitDim >= 0)
+    {
+      kkint32  mid = start + (end - start) / 2;
+      nth_element (order.begin () + start, order.begin () + mid, order.begin () + end,
+                   [&src, splitDim] (kkint32 a, kkint32 b) {return src.Row (a)[splitDim] < src.Row (b)[splitDim];}
+                  );
+
+      nodeSplitDim[nodeIdx]   = splitDim;
+      nodeSplitValue[nodeIdx] = src.Row (order[mid])[splitDim];
+
+      nodeLeft[nodeIdx] = NumNodes ();
+      BuildTree (src, order, start, mid);
+
+      nodeRight[nodeIdx] = NumNodes ();
+      BuildTree (src, order, mid, end);
+      return;
+    }
+  }
+
+  if  ((end - start) > maxLeafRows)
+    maxLeafRows = end - start;
+}  /* BuildTree */
+
+
+
+void  KnnIndex::OfferNeighbor (kkint32        k,
+                               kkint32        row,
+                               double         distance,
+                               NeighborList&  heap
+                              )
+{
+  Neighbor  n;
+  n.row = row;
+  n.distance = distance;
+
+  if  ((kkint32)heap.size () < k)
+  {
+    heap.push_back (n);
+    push_heap (heap.begin (), heap.end (), NeighborLess);
+  }
+  else if  (NeighborLess (n, heap.front ()))
+  {
+    pop_heap (heap.begin (), heap.end (), NeighborLess);
+    heap.back () = n;
+    push_heap (heap.begin (), heap.end (), NeighborLess);
+  }
+}  /* OfferNeighbor */
+
+
+
+void  KnnIndex::SortNeighbors (NeighborList&  heap)
+{
+  sort_heap (heap.begin (), heap.end (), NeighborLess);
+}
+
+
+
+void  KnnIndex::SearchNode (kkint32        nodeIdx,
+                            const float*   query,
+                            kkint32        k,
+                            double*        distBuff,
+                            NeighborList&  heap
+                           )  const
+{
+  kkint32  splitDim = nodeSplitDim[nodeIdx];
+  if  (splitDim < 0)
+  {
+    kkint32  start = nodeStart[nodeIdx];
+    kkint32  count = nodeEnd[nodeIdx] - start;
+    KernelEngine::SquaredDistanceOneToMany (query, *points, &rowIdxs[start], count, distBuff);
+    for  (kkint32 x = 0;  x < count;  ++x)
+      OfferNeighbor (k, start + x, distBuff[x], heap);
+    return;
+  }
+
+  double  diff = (double)query[splitDim] - (double)nodeSplitValue[nodeIdx];
+  kkint32  nearChild = (diff < 0.0) ? nodeLeft[nodeIdx]  : nodeRight[nodeIdx];
+  kkint32  farChild  = (diff < 0.0) ? nodeRight[nodeIdx] : nodeLeft[nodeIdx];
+
+  SearchNode (nearChild, query, k, distBuff, heap);
+
+  // Every row on the far side is at least 'diff' away along 'splitDim'.
+  if  (((kkint32)heap.size () < k)  ||  ((diff * diff) <= heap.front ().distance))
+    SearchNode (farChild, query, k, distBuff, heap);
+}  /* SearchNode */
+
+
+
+void  KnnIndex::SearchBruteForce (const float*   query,
+                                  kkint32        k,
+                                  double*        distBuff,
+                                  NeighborList&  heap
+                                 )  const
+{
+  kkint32  numPoints = NumPoints ();
+  KernelEngine::SquaredDistanceOneToMany (query, *points, NULL, numPoints, distBuff);
+  for  (kkint32 row = 0;  row < numPoints;  ++row)
+    OfferNeighbor (k, row, distBuff[row], heap);
+}  /* SearchBruteForce */
+
+
+
+void  KnnIndex::Search (const float*   query,
+                        kkint32        k,
+                        NeighborList&  neighbors
+                       )  const
+{
+  neighbors.clear ();
+  if  ((k < 1)  ||  (NumPoints () < 1))
+    return;
+
+  neighbors.reserve (k);
+
+  if  (UsesTree ())
+  {
+    vector<double>  distBuff (maxLeafRows);
+    SearchNode (0, query, k, distBuff.data (), neighbors);
+  }
+  else
+  {
+    vector<double>  distBuff (NumPoints ());
+    SearchBruteForce (query, k, distBuff.data (), neighbors);
+  }
+
+  SortNeighbors (neighbors);
+}  /* Search */
+
+
+
+void  KnnIndex::SearchBatch (const PackedFeatureVectors&  queries,
+                             kkint32                      k,
+                             std::vector<NeighborList>&   neighbors
+                            )  const
+{
+  if  (queries.NumCols () != NumCols ())
+    throw KKException ("KnnIndex::SearchBatch   ***ERROR***   queries.NumCols[" + StrFromInt32 (queries.NumCols ()) + "] does not match NumCols[" + StrFromInt32 (NumCols ()) + "].");
+
+  kkint32  numQueries = queries.NumRows ();
+  neighbors.resize (numQueries);
+
+  if  (UsesTree ()  ||  (NumPoints () < 1)  ||  (k < 1))
+  {
+    for  (kkint32 q = 0;  q < numQueries;  ++q)
+      Search (queries.Row (q), k, neighbors[q]);
+    return;
+  }
+
+  kkint32  numPoints = NumPoints ();
+  vector<double>  dists ((kkMemSize)queryBlockSize * numPoints);
+
+  for  (kkint32 blockStart = 0;  blockStart < numQueries;  blockStart += queryBlockSize)
+  {
+    kkint32  blockLen = numQueries - blockStart;
+    if  (blockLen > queryBlockSize)
+      blockLen = queryBlockSize;
+
+    PackedFeatureVectors  block (blockLen, NumCols ());
+    for  (kkint32 x = 0;  x < blockLen;  ++x)
+      block.PackRow (x, queries.Row (blockStart + x));
+
+    KernelEngine::SquaredDistanceManyToMany (block, *points, dists.data ());
+
+    for  (kkint32 x = 0;  x < blockLen;  ++x)
+    {
+      NeighborList&  heap = neighbors[blockStart + x];
+      heap.clear ();
+      heap.reserve (k);
+      const double*  queryDists = dists.data () + (kkMemSize)x * numPoints;
+      for  (kkint32 row = 0;  row < numPoints;  ++row)
+        OfferNeighbor (k, row, queryDists[row], heap);
+      SortNeighbors (heap);
+    }
+  }
+}  /* SearchBatch */
+
+
+
+void  KnnIndex::WriteXML (const KKStr&   varName,
+                          std::ostream&  o
+                         )  const
+{
+  XmlTag  startTag ("KnnIndex", XmlTag::TagTypes::tagStart);
+  if  (!varName.Empty ())
+    startTag.AddAtribute ("VarName", varName);
+  startTag.WriteXML (o);
+  o << endl;
+
+  kkint32  numPoints = NumPoints ();
+  kkint32  numCols   = NumCols ();
+
+  XmlElementInt32::WriteXML (numPoints, "NumPoints", o);
+  XmlElementInt32::WriteXML (numCols,   "NumCols",   o);
+
+  // Nine significant digits are needed for a float to survive being written out as text and read back.
+  streamsize  origPrecision = o.precision (9);
+
+  if  (points  &&  (numPoints > 0))
+  {
+    vector<float>  pointData ((kkMemSize)numPoints * numCols);
+    for  (kkint32 row = 0;  row < numPoints;  ++row)
+      copy (points->Row (row), points->Row (row) + numCols, pointData.begin () + (kkMemSize)row * numCols);
+    XmlElementArrayFloat::WriteXML ((kkuint32)pointData.size (), pointData.data (), "Points", o);
+    XmlElementArrayInt32::WriteXML ((kkuint32)labels.size (), labels.data (), "Labels", o);
+  }
+
+  if  (UsesTree ())
+  {
+    kkuint32  numNodes = (kkuint32)nodeStart.size ();
+    XmlElementArrayInt32::WriteXML (numNodes, nodeStart.data (),      "NodeStart",      o);
+    XmlElementArrayInt32::WriteXML (numNodes, nodeEnd.data (),        "NodeEnd",        o);
+    XmlElementArrayInt32::WriteXML (numNodes, nodeSplitDim.data (),   "NodeSplitDim",   o);
+    XmlElementArrayFloat::WriteXML (numNodes, nodeSplitValue.data (), "NodeSplitValue", o);
+    XmlElementArrayInt32::WriteXML (numNodes, nodeLeft.data (),       "NodeLeft",       o);
+    XmlElementArrayInt32::WriteXML (numNodes, nodeRight.data (),      "NodeRight",      o);
+  }
+
+  o.precision (origPrecision);
+
+  XmlTag  endTag ("KnnIndex", XmlTag::TagTypes::tagEnd);
+  endTag.WriteXML (o);
+  o << endl;
+}  /* WriteXML */
+
+
+
+void  KnnIndex::ReadXML (XmlStream&      s,
+                         XmlTagConstPtr  tag,
+                         VolConstBool&   cancelFlag,
+                         RunLog&         log
+                        )
+{
+  log.Level (50) << "KnnIndex::ReadXML   tag: " << tag->Name () << endl;
+
+  kkint32         numPoints = 0;
+  kkint32         numCols   = 0;
+  vector<float>   pointData;
+
+  delete  points;
+  points = NULL;
+  labels.clear ();
+  nodeStart.clear ();  nodeEnd.clear ();  nodeSplitDim.clear ();  nodeSplitValue.clear ();  nodeLeft.clear ();  nodeRight.clear ();
+
+  XmlTokenPtr  t = s.GetNextToken (cancelFlag, log);
+  while  (t  &&  (!cancelFlag))
+  {
+    if  (t->TokenType () == XmlToken::TokenTypes::tokElement)
+    {
+      XmlElementPtr  e = dynamic_cast<XmlElementPtr> (t);
+      const KKStr&  varName = e->VarName ();
+
+      XmlElementArrayInt32Ptr  intArray   = dynamic_cast<XmlElementArrayInt32Ptr> (e);
+      XmlElementArrayFloatPtr  floatArray = dynamic_cast<XmlElementArrayFloatPtr> (e);
+
+      if  (varName.EqualIgnoreCase ("NumPoints"))
+        numPoints = e->ToInt32 ();
+
+      else if  (varName.EqualIgnoreCase ("NumCols"))
+        numCols = e->ToInt32 ();
+
+      else if  (varName.EqualIgnoreCase ("Points")  &&  floatArray  &&  floatArray->Value ())
+        pointData.assign (floatArray->Value (), floatArray->Value () + floatArray->Count ());
+
+      else if  (intArray  &&  intArray->Value ())
+      {
+        const kkint32*  v = intArray->Value ();
+        kkuint32        c = intArray->Count ();
+        if       (varName.EqualIgnoreCase ("Labels"))        labels.assign       (v, v + c);
+        else if  (varName.EqualIgnoreCase ("NodeStart"))     nodeStart.assign    (v, v + c);
+        else if  (varName.EqualIgnoreCase ("NodeEnd"))       nodeEnd.assign      (v, v + c);
+        else if  (varName.EqualIgnoreCase ("NodeSplitDim"))  nodeSplitDim.assign (v, v + c);
+        else if  (varName.EqualIgnoreCase ("NodeLeft"))      nodeLeft.assign     (v, v + c);
+        else if  (varName.EqualIgnoreCase ("NodeRight"))     nodeRight.assign    (v, v + c);
+        else
+          log.Level (-1) << "KnnIndex::ReadXML   ***ERROR***   Unexpected VarName: " << varName << endl;
+      }
+
+      else if  (varName.EqualIgnoreCase ("NodeSplitValue")  &&  floatArray  &&  floatArray->Value ())
+        nodeSplitValue.assign (floatArray->Value (), floatArray->Value () + floatArray->Count ());
+
+      else
+        log.Level (-1) << "KnnIndex::ReadXML   ***ERROR***   Unexpected VarName: " << varName << endl;
+    }
+    delete  t;
+    t = s.GetNextToken (cancelFlag, log);
+  }
+  delete  t;
+  t = NULL;
+
+  if  (((kkint32)pointData.size () != numPoints * numCols)  ||  ((kkint32)labels.size () != numPoints))
+  {
+    log.Level (-1) << "KnnIndex::ReadXML   ***ERROR***   Points[" << pointData.size () << "] or Labels[" << labels.size () << "] do not agree with NumPoints[" << numPoints << "]  NumCols[" << numCols << "]." << endl;
+    numPoints = 0;
+    labels.clear ();
+  }
+
+  points = new PackedFeatureVectors (numPoints, numCols);
+  for  (kkint32 row = 0;  row < numPoints;  ++row)
+    points->PackRow (row, pointData.data () + (kkMemSize)row * numCols);
+
+  rowIdxs.resize (numPoints);
+  for  (kkint32 x = 0;  x < numPoints;  ++x)
+    rowIdxs[x] = x;
+
+  kkuint32  numNodes = (kkuint32)nodeStart.size ();
+  bool  treeValid = (nodeEnd.size () == numNodes)  &&  (nodeSplitDim.size () == numNodes)  &&  (nodeSplitValue.size () == numNodes)  &&
+                    (nodeLeft.size () == numNodes)  &&  (nodeRight.size () == numNodes);
+
+  maxLeafRows = 0;
+  for  (kkuint32 n = 0;  (n < numNodes)  &&  treeValid;  ++n)
+  {
+    if  ((nodeStart[n] < 0)  ||  (nodeEnd[n] > numPoints)  ||  (nodeStart[n] > nodeEnd[n])  ||  (nodeSplitDim[n] >= numCols))
+      treeValid = false;
+
+    else if  (nodeSplitDim[n] < 0)
+      maxLeafRows = max (maxLeafRows, nodeEnd[n] - nodeStart[n]);
+
+    else if  ((nodeLeft[n] <= (kkint32)n)  ||  (nodeLeft[n] >= (kkint32)numNodes)  ||  (nodeRight[n] <= (kkint32)n)  ||  (nodeRight[n] >= (kkint32)numNodes))
+      treeValid = false;
+  }
+
+  if  (!treeValid)
+  {
+    // Fall back to brute force rather than walk a damaged tree.
+    log.Level (-1) << "KnnIndex::ReadXML   ***ERROR***   KD-tree arrays are inconsistent;  searches will scan every point." << endl;
+    nodeStart.clear ();  nodeEnd.clear ();  nodeSplitDim.clear ();  nodeSplitValue.clear ();  nodeLeft.clear ();  nodeRight.clear ();
+    maxLeafRows = 0;
+  }
+}  /* ReadXML */
+
+
+XmlFactoryMacro(KnnIndex)
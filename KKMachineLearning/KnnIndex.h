@@ -0,0 +1,168 @@
+#if  !defined(_KNNINDEX_)
+#define  _KNNINDEX_
+/**
+ *@class  KKMLL::KnnIndex
+ *@brief  Nearest neighbor search structure used by 'ModelKnn'.
+ *@author  Kurt Kramer
+ *@details  The training examples are packed into a 'PackedFeatureVectors' instance with one row per example.
+ * When the number of features is at most 'MaxTreeDimensions' a KD-tree is built over them; each node splits
+ * its examples at the median of the feature with the largest spread and the rows are reordered so that every
+ * node covers a contiguous range of rows.  The leaves are scanned with 'KernelEngine'.  With more features
+ * than that a KD-tree prunes very little so every row is scanned with 'KernelEngine' instead.
+ *
+ * Distances are squared Euclidean distances.  The index is built once in 'ModelKnn::TrainModel' and is saved
+ * with the model so that it does not need to be rebuilt when the model is loaded.
+ */
+
+#include  <vector>
+
+#include  "KKBaseTypes.h"
+#include  "RunLog.h"
+#include  "XmlStream.h"
+
+#include  "KernelEngine.h"
+
+
+namespace KKMLL
+{
+  #if  !defined(_FeatureVector_Defined_)
+  class  FeatureVector;
+  typedef  FeatureVector*  FeatureVectorPtr;
+  class  FeatureVectorList;
+  typedef  FeatureVectorList*  FeatureVectorListPtr;
+  #endif
+
+  #if  !defined(_FeatureNumList_Defined_)
+  class  FeatureNumList;
+  typedef  FeatureNumList*  FeatureNumListPtr;
+  #endif
+
+
+  class  KnnIndex
+  {
+  public:
+    typedef  KnnIndex*  KnnIndexPtr;
+
+    /** @brief  One of the results of a search;  'row' is the row in 'Points ()' and 'distance' the squared distance to it. */
+    struct  Neighbor
+    {
+      kkint32  row;
+      double   distance;
+    };
+
+    typedef  std::vector<Neighbor>  NeighborList;
+
+    static  const kkint32  LeafSize          = 16;   /**< Maximum number of rows in a KD-tree leaf.          */
+    static  const kkint32  MaxTreeDimensions = 16;   /**< Above this number of features brute force is used. */
+
+    /** @brief  Creates an empty index;  used by 'ReadXML'. */
+    KnnIndex ();
+
+    /**
+     *@brief  Builds the index from the features in 'selFeatures' of every example in 'examples'.
+     *@param[in]  examples     Examples to index.
+     *@param[in]  selFeatures  Features to use.
+     *@param[in]  labels       'labels[x]' is the class index of 'examples[x]';  returned by 'Label'.
+     */
+    KnnIndex (const FeatureVectorList&     examples,
+              const FeatureNumList&        selFeatures,
+              const std::vector<kkint32>&  labels
+             );
+
+    ~KnnIndex ();
+
+    kkMemSize  MemoryConsumedEstimated ()  const;
+
+    kkint32  Label     (kkint32 row)  const  {return labels[row];}
+    kkint32  NumCols   ()  const  {return points ? points->NumCols () : 0;}
+    kkint32  NumNodes  ()  const  {return (kkint32)nodeStart.size ();}
+    kkint32  NumPoints ()  const  {return points ? points->NumRows () : 0;}
+    bool     UsesTree  ()  const  {return !nodeStart.empty ();}
+
+    const PackedFeatureVectors*  Points ()  const  {return points;}
+
+    /**
+     *@brief  Finds the 'k' rows nearest to 'query'.
+     *@param[in]  query      Packed vector with 'NumCols ()' features and the same stride as 'Points ()'.
+     *@param[in]  k          Number of neighbors wanted;  fewer are returned if there are fewer rows.
+     *@param[out] neighbors  Nearest neighbors ordered by increasing distance.
+     */
+    void  Search (const float*   query,
+                  kkint32        k,
+                  NeighborList&  neighbors
+                 )  const;
+
+    /**
+     *@brief  Finds the 'k' nearest rows of every row in 'queries';  'neighbors[q]' will hold the results for 'queries' row 'q'.
+     *@details  When brute force is being used the distances are computed for blocks of queries at a time with
+     * 'KernelEngine::SquaredDistanceManyToMany' so that the indexed rows stay in cache.
+     */
+    void  SearchBatch (const PackedFeatureVectors&  queries,
+                       kkint32                      k,
+                       std::vector<NeighborList>&   neighbors
+                      )  const;
+
+
+    void  ReadXML (XmlStream&      s,
+                   XmlTagConstPtr  tag,
+                   VolConstBool&   cancelFlag,
+                   RunLog&         log
+                  );
+
+    void  WriteXML (const KKStr&   varName,
+                    std::ostream&  o
+                   )  const;
+
+  private:
+    KnnIndex (const KnnIndex&);
+    KnnIndex&  operator= (const KnnIndex&);
+
+    void  BuildTree (const PackedFeatureVectors&  src,
+                     std::vector<kkint32>&        order,
+                     kkint32                      start,
+                     kkint32                      end
+                    );
+
+    void  SearchNode (kkint32        nodeIdx,
+                      const float*   query,
+                      kkint32        k,
+                      double*        distBuff,
+                      NeighborList&  heap
+                     )  const;
+
+    void  SearchBruteForce (const float*   query,
+                            kkint32        k,
+                            double*        distBuff,
+                            NeighborList&  heap
+                           )  const;
+
+    static  void  OfferNeighbor (kkint32        k,
+                                 kkint32        row,
+                                 double         distance,
+                                 NeighborList&  heap
+                                );
+
+    static  void  SortNeighbors (NeighborList&  heap);
+
+    std::vector<kkint32>   labels;
+    kkint32                maxLeafRows;     /**< Rows in the largest leaf;  size of the distance buffer a search needs. */
+    std::vector<kkint32>   nodeEnd;         /**< One past the last row covered by the node.                      */
+    std::vector<kkint32>   nodeLeft;        /**< Child with values less than the split value;  -1 for leaves.    */
+    std::vector<kkint32>   nodeRight;       /**< Child with values greater or equal to the split value.          */
+    std::vector<kkint32>   nodeSplitDim;    /**< Column the node splits on;  -1 for leaves.                      */
+    std::vector<float>     nodeSplitValue;
+    std::vector<kkint32>   nodeStart;       /**< First row covered by the node;  node 0 is the root.             */
+    PackedFeatureVectorsPtr  points;
+    std::vector<kkint32>   rowIdxs;         /**< 0 thru NumPoints () - 1;  leaves pass a slice of it to 'KernelEngine'. */
+  };  /* KnnIndex */
+
+  typedef  KnnIndex::KnnIndexPtr  KnnIndexPtr;
+
+  typedef  XmlElementTemplate<KnnIndex>  XmlElementKnnIndex;
+  typedef  XmlElementKnnIndex*  XmlElementKnnIndexPtr;
+
+#define  _KnnIndex_Defined_
+
+}  /* KKMLL */
+
+#endif
@@ -53,6 +53,7 @@ Model::Model ():
     normParms                (NULL),
     numOfClasses             (0),
     param                    (NULL),
+    predictionSource         (NULL),
     rootFileName             (),
     trainExamples            (NULL),
     validModel               (true),
@@ -80,6 +81,7 @@ Model::Model (const Model&  _model):
     normParms               (NULL),
     numOfClasses            (_model.numOfClasses),
     param                   (NULL),
+    predictionSource        (NULL),
     rootFileName            (_model.rootFileName),
     trainExamples           (NULL),
     validModel              (_model.validModel),
@@ -129,6 +131,7 @@ Model::Model (FactoryFVProducerPtr  _factoryFVProducer):
     normParms                (NULL),
     numOfClasses             (0),
     param                    (NULL),
+    predictionSource         (NULL),
     rootFileName             (),
     trainExamples            (NULL),
     validModel               (true),
@@ -170,6 +173,7 @@ Model::Model (const KKStr&          _name,
     normParms                (NULL),
     numOfClasses             (0),
     param                    (NULL),
+    predictionSource         (NULL),
     rootFileName             (),
     trainExamples            (NULL),
     validModel               (true),
@@ -197,7 +201,11 @@ Model::~Model ()
   delete  classesIndex;  classesIndex = NULL;
   delete  classes;       classes = NULL;
   delete  encoder;       encoder = NULL;
-  delete  normParms;     normParms = NULL;
+
+  // A shared instance uses the 'normParms' of the model it was made from.
+  if  (!predictionSource)
+    delete  normParms;
+  normParms = NULL;
 
   if  (weOwnTrainExamples)
   {
@@ -441,17 +449,15 @@ FeatureNumListConstPtr  Model::SelectedFeatures () const
 
 void  Model::TrainingTimeStart ()
 {
-  trainingTimeStart = osGetSystemTimeUsed ();
+  trainingTimeStart = osGetElapsedSecs ();
 }
 
 
 
 void  Model::TrainingTimeEnd ()
 {
-  double  trainingTimeEnd = osGetSystemTimeUsed ();
+  double  trainingTimeEnd = osGetElapsedSecs ();
   trainingTime = trainingTimeEnd - trainingTimeStart;
-  if  (trainingTime < 0.0)
-    trainingTime += (24.0 * 60.0 * 60.0);
 }
 
 
@@ -470,7 +476,7 @@ void  Model::TrainModel (FeatureVectorListPtr  _trainExamples,
 {
   _log.Level (10) << "Model::TrainModel   Preparing for training of Model[" << Name () << "]  Examples[" << _trainExamples->QueueSize () << "]" << endl;
 
-  double  prepStartTime = osGetSystemTimeUsed ();
+  double  prepStartTime = osGetElapsedSecs ();
 
   if  (_trainExamples == NULL)
   {
@@ -518,6 +524,10 @@ void  Model::TrainModel (FeatureVectorListPtr  _trainExamples,
       delete  trainExamples;
       trainExamples = temp;
     }
+    // The examples are now ours;  with their feature data in one block deriving the normalization parameters
+    // and normalizing run straight through memory.
+    trainExamples->ConsolidateFeatureData ();
+
     delete  normParms;
     normParms = new NormalizationParms (*param, *trainExamples, _log);
     normParms->NormalizeExamples (trainExamples, _log);
@@ -547,10 +557,8 @@ void  Model::TrainModel (FeatureVectorListPtr  _trainExamples,
 
   AllocatePredictionVariables ();
 
-  double  prepEndTime = osGetSystemTimeUsed ();
+  double  prepEndTime = osGetElapsedSecs ();
   trianingPrepTime = prepEndTime - prepStartTime;
-  if  (trianingPrepTime < 0.0)
-    trianingPrepTime += (24.0 * 60.0 * 60.0);
 
   _log.Level (40) << "Model::TrainModel   Exiting   _cancelFlag[" << _cancelFlag << "]." << endl;
 }  /* TrainModel */
@@ -574,6 +582,7 @@ FeatureVectorPtr  Model::PrepExampleForPrediction (FeatureVectorPtr  fv,
 {
   FeatureVectorPtr  oldFV = NULL;
   newExampleCreated = false;
+
   if  ((!alreadyNormalized)  &&  (normParms))
   {
     oldFV = fv;
@@ -604,6 +613,108 @@ FeatureVectorPtr  Model::PrepExampleForPrediction (FeatureVectorPtr  fv,
 
 
 
+FeatureVectorListPtr  Model::PrepExamplesForPrediction (FeatureVectorList&  examples,
+                                                        kkuint32            start,
+                                                        kkuint32            end,
+                                                        RunLog&             log
+                                                       )
+{
+  bool  normalize = ((!alreadyNormalized)  &&  (normParms != NULL));
+  if  ((!normalize)  &&  (!encoder))
+    return  NULL;
+
+  // Normalizing in place on our own copy avoids the intermediate instance 'ToNormalized' would create when
+  // both normalization and encoding are needed.
+  FileDescConstPtr  preparedFileDesc = encoder ? encoder->EncodedFileDesc () : examples.FileDesc ();
+  FeatureVectorListPtr  prepared = new FeatureVectorList (preparedFileDesc, true);
+  for  (kkuint32 x = start;  x < end;  ++x)
+  {
+    FeatureVectorPtr  fv = new FeatureVector (*(examples.IdxToPtr (x)));
+    if  (normalize)
+      normParms->NormalizeAExample (fv);
+
+    if  (encoder)
+    {
+      FeatureVectorPtr  encodedFV = encoder->EncodeAExample (fv);
+      delete  fv;
+      fv = encodedFV;
+    }
+    prepared->PushOnBack (fv);
+  }
+
+  log.Level (50) << "Model::PrepExamplesForPrediction   Prepared[" << prepared->QueueSize () << "]  examples." << endl;
+  return  prepared;
+}  /* PrepExamplesForPrediction */
+
+
+
+void  Model::ProbabilitiesByClassForBlock (FeatureVectorList&  examples,
+                                           kkuint32            start,
+                                           kkuint32            end,
+                                           const MLClassList&  mlClasses,
+                                           kkint32*            votes,
+                                           double*             probabilities,
+                                           RunLog&             log
+                                          )
+{
+  kkuint32  numClasses = mlClasses.QueueSize ();
+  for  (kkuint32 idx = start;  idx < end;  ++idx)
+  {
+    kkint32*  exampleVotes         = votes         + (kkMemSize)(idx - start) * numClasses;
+    double*   exampleProbabilities = probabilities + (kkMemSize)(idx - start) * numClasses;
+
+    ClassProbListPtr  predictions = ProbabilitiesByClass (examples.IdxToPtr (idx), log);
+    for  (kkuint32 x = 0;  x < numClasses;  ++x)
+    {
+      exampleVotes[x] = 0;
+      exampleProbabilities[x] = 0.0;
+
+      ClassProbConstPtr cp = predictions ? predictions->LookUp (mlClasses.IdxToPtr (x)) : NULL;
+      if  (cp)
+      {
+        exampleVotes[x] = (kkint32)(0.5f + cp->votes);
+        exampleProbabilities[x] = cp->probability;
+      }
+    }
+    delete  predictions;
+    predictions = NULL;
+  }
+}  /* ProbabilitiesByClassForBlock */
+
+
+
+ModelPtr  Model::ShareForPrediction ()  const
+{
+  return  NULL;
+}
+
+
+
+void  Model::ShareTrainedParts (const Model&  trainedModel)
+{
+  predictionSource  = &trainedModel;
+  alreadyNormalized = trainedModel.alreadyNormalized;
+  fileDesc          = trainedModel.fileDesc;
+  normParms         = trainedModel.normParms;
+  rootFileName      = trainedModel.rootFileName;
+  validModel        = trainedModel.validModel;
+
+  delete  classes;
+  classes = trainedModel.classes ? new MLClassList (*trainedModel.classes) : NULL;
+  numOfClasses = classes ? classes->QueueSize () : 0;
+
+  delete  classesIndex;
+  classesIndex = trainedModel.classesIndex ? new MLClassIndexList (*trainedModel.classesIndex) : NULL;
+
+  delete  encoder;
+  encoder = trainedModel.encoder ? new FeatureEncoder2 (*trainedModel.encoder) : NULL;
+
+  if  (classes)
+    AllocatePredictionVariables ();
+}  /* ShareTrainedParts */
+
+
+
 
 /**
  * Will normalize probabilities such that the sum of all equal 1.0 and no one probability will be less than 'minProbability'.
@@ -199,6 +199,8 @@ namespace KKMLL
 
     /**
      @brief  Derived classes call this method to start the clock for 'trainingTime'.
+     @details  'trainingTime' and 'trianingPrepTime' are wall clock seconds;  models are trained on several
+               threads at once by cross validation, so process CPU time would include the work of the others.
      */
     void  TrainingTimeStart ();
 
@@ -224,6 +226,30 @@ namespace KKMLL
                                                );
 
 
+    /**
+     *@brief  Batch version of 'PrepExampleForPrediction';  prepares examples 'start' thru 'end - 1' of 'examples' in one pass.
+     *@details  Returns NULL if no preparation is needed;  otherwise a new list, owned by the caller, that owns its
+     *          examples;  entry 'x' is the prepared version of 'examples[start + x]'.
+     */
+    virtual
+    FeatureVectorListPtr  PrepExamplesForPrediction (FeatureVectorList&  examples,
+                                                     kkuint32            start,
+                                                     kkuint32            end,
+                                                     RunLog&             log
+                                                    );
+
+
+    /**
+     *@brief  Creates an instance that predicts with this model's trained classifier on a different thread.
+     *@details  The trained parts are shared, not copied;  the new instance only gets its own work areas, such as
+     *          votes, probabilities and the encoded example, so it makes exactly the same predictions as this
+     *          model.  This model must outlive the new instance and must not be retrained while it exists.
+     *          Returns NULL when the derived class does not support sharing;  the default.
+     */
+    virtual
+    ModelPtr  ShareForPrediction ()  const;
+
+
     virtual  void  PredictRaw (FeatureVectorPtr  example,
                                MLClassPtr&       predClass,
                                double&           dist
@@ -302,6 +328,24 @@ namespace KKMLL
                                 double*             _probabilities,
                                 RunLog&             _log
                                ) = 0;
+
+
+    /**
+     *@brief  Block version of 'ProbabilitiesByClass' for examples 'start' thru 'end - 1' of 'examples'.
+     *@details  Example 'start + x' gets row 'x' of 'votes' and 'probabilities';  each row is 'mlClasses.QueueSize ()'
+     *          wide.  The default predicts one example at a time.  Models that can prepare the block and evaluate
+     *          their kernel for all of it at once override it;  they must give exactly the results the single
+     *          example methods give.
+     */
+    virtual
+    void  ProbabilitiesByClassForBlock (FeatureVectorList&  examples,
+                                        kkuint32            start,
+                                        kkuint32            end,
+                                        const MLClassList&  mlClasses,
+                                        kkint32*            votes,
+                                        double*             probabilities,
+                                        RunLog&             log
+                                       );
   
 
     virtual  
@@ -358,6 +402,12 @@ namespace KKMLL
 
     void  AllocatePredictionVariables ();
 
+    /**
+     *@brief  Used by 'ShareForPrediction' in the derived classes to pick up the fields of this class from 'trainedModel'.
+     *@details  'normParms' is shared with 'trainedModel';  everything else that prediction reads is copied.
+     */
+    void  ShareTrainedParts (const Model&  trainedModel);
+
 
     void  DeAllocateSpace ();
 
@@ -404,6 +454,10 @@ namespace KKMLL
 
     ModelParamPtr          param;          /**< Will own this instance,                           */
 
+    const Model*           predictionSource;  /**< Set on instances made by 'ShareForPrediction';  the model whose trained parts,
+                                               * including 'normParms', this instance uses but does not own.
+                                               */
+
     KKStr                  rootFileName;   /**< This is the root name to be used by all component objects; such as svm_model,
                                             * mlClasses, and svmParam(including selected features). Each one will have the
                                             * same rootName with a different suffix.
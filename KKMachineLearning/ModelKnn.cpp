@@ -25,24 +25,32 @@ using namespace  KKB;
 
 #include "Model.h"
 #include "ClassProb.h"
+#include "FeatureEncoder2.h"
 #include "FeatureNumList.h"
 #include "FeatureVector.h"
+#include "KernelEngine.h"
+#include "KnnIndex.h"
+#include "MLClass.h"
 #include "ModelKnn.h"
 using namespace  KKMLL;
 
 
 
 ModelKnn::ModelKnn ():
-  Model (),
-  param (NULL)
+  Model       (),
+  index       (NULL),
+  knnFeatures (NULL),
+  param       (NULL)
 {
 }
 
 
 
 ModelKnn::ModelKnn (FactoryFVProducerPtr  _factoryFVProducer):
-  Model (_factoryFVProducer),
-  param (NULL)
+  Model       (_factoryFVProducer),
+  index       (NULL),
+  knnFeatures (NULL),
+  param       (NULL)
 {
 }
 
@@ -52,17 +60,24 @@ ModelKnn::ModelKnn (const KKStr&          _name,
                     const ModelParamKnn&  _param,         // Create new model from
                     FactoryFVProducerPtr  _factoryFVProducer
                    ):
-  Model (_name, _param, _factoryFVProducer),
-  param (NULL)
+  Model       (_name, _param, _factoryFVProducer),
+  index       (NULL),
+  knnFeatures (NULL),
+  param       (NULL)
 {
   param = dynamic_cast<ModelParamKnnPtr> (Model::param);
 }
 
 
 
+/**
+ *@details  Like the other models the trained index is not copied;  use 'ShareForPrediction' for an instance that can predict.
+ */
 ModelKnn::ModelKnn (const ModelKnn&   _model):
-  Model (_model),
-  param (NULL)
+  Model       (_model),
+  index       (NULL),
+  knnFeatures (NULL),
+  param       (NULL)
 {
   param = dynamic_cast<ModelParamKnnPtr> (Model::param);
 }
@@ -71,7 +86,13 @@ ModelKnn::ModelKnn (const ModelKnn&   _model):
 
 ModelKnn::~ModelKnn ()
 {
-
+  if  (!predictionSource)
+  {
+    delete  index;
+    delete  knnFeatures;
+  }
+  index       = NULL;
+  knnFeatures = NULL;
 }
 
 
@@ -83,6 +104,30 @@ ModelKnnPtr  ModelKnn::Duplicate ()  const
 
 
 
+ModelPtr  ModelKnn::ShareForPrediction ()  const
+{
+  if  ((!index)  ||  (!knnFeatures))
+    return  NULL;
+
+  ModelKnnPtr  shared = new ModelKnn (*this);
+  shared->ShareTrainedParts (*this);
+  shared->index       = index;
+  shared->knnFeatures = knnFeatures;
+  return  shared;
+}  /* ShareForPrediction */
+
+
+
+kkMemSize  ModelKnn::MemoryConsumedEstimated ()  const
+{
+  kkMemSize  memoryConsumedEstimated = Model::MemoryConsumedEstimated () + sizeof (index) + sizeof (knnFeatures) + sizeof (param);
+  if  (index)        memoryConsumedEstimated += index->MemoryConsumedEstimated ();
+  if  (knnFeatures)  memoryConsumedEstimated += knnFeatures->MemoryConsumedEstimated ();
+  return  memoryConsumedEstimated;
+}
+
+
+
 ModelParamKnnPtr  ModelKnn::Param ()
 {
   return  param;
@@ -90,13 +135,143 @@ ModelParamKnnPtr  ModelKnn::Param ()
 
 
 
+void  ModelKnn::ValidateIndex (const char*  funcName,
+                               RunLog&      log
+                              )  const
+{
+  if  ((!index)  ||  (!knnFeatures)  ||  (!classesIndex)  ||  (!classes)  ||  (!param))
+  {
+    KKStr errMsg (128);
+    errMsg << "ModelKnn::" << funcName << "   ***ERROR***   Model has not been trained.";
+    log.Level (-1) << endl << endl << errMsg << endl << endl;
+    throw KKException (errMsg);
+  }
+}  /* ValidateIndex */
+
+
+
+void  ModelKnn::PackQuery (FeatureVectorPtr       example,
+                           PackedFeatureVectors&  query,
+                           kkint32                row
+                          )
+{
+  bool  newExampleCreated = false;
+  FeatureVectorPtr  encodedExample = PrepExampleForPrediction (example, newExampleCreated);
+
+  query.PackRow (row, *encodedExample, *knnFeatures);
+
+  if  (newExampleCreated)
+  {
+    delete encodedExample;
+    encodedExample = NULL;
+  }
+}  /* PackQuery */
+
+
+
+void  ModelKnn::TallyNeighbors (const KnnIndex::NeighborList&  neighbors,
+                                kkint32*                       classVotes,
+                                double*                        classProbs
+                               )  const
+{
+  kkuint32  numClasses = classes->QueueSize ();
+  for  (kkuint32 x = 0;  x < numClasses;  ++x)
+  {
+    classVotes[x] = 0;
+    classProbs[x] = 0.0;
+  }
+
+  double  gamma = param->Gamma ();
+  if  ((gamma <= 0.0)  &&  (index->NumCols () > 0))
+    gamma = 1.0 / (double)index->NumCols ();
+
+  bool  rbfWeighted = (param->VotingMethod () == ModelParamKnn::VotingMethodType::RbfWeighted);
+
+  double  totalWeight = 0.0;
+  for  (auto  n: neighbors)
+  {
+    kkint32  classIdx = index->Label (n.row);
+    double   weight = rbfWeighted ? exp (-gamma * n.distance) : 1.0;
+    ++(classVotes[classIdx]);
+    classProbs[classIdx] += weight;
+    totalWeight += weight;
+  }
+
+  if  (totalWeight <= 0.0)
+  {
+    // Every RBF weight underflowed;  the neighbors are all far away so fall back to one vote each.
+    totalWeight = 0.0;
+    for  (kkuint32 x = 0;  x < numClasses;  ++x)
+    {
+      classProbs[x] = (double)classVotes[x];
+      totalWeight += classProbs[x];
+    }
+  }
+
+  if  (totalWeight > 0.0)
+  {
+    for  (kkuint32 x = 0;  x < numClasses;  ++x)
+      classProbs[x] /= totalWeight;
+  }
+}  /* TallyNeighbors */
+
+
+
+void  ModelKnn::ToCallersClassOrder (const kkint32*      classVotes,
+                                     const double*       classProbs,
+                                     const MLClassList&  _mlClasses,
+                                     kkint32*            _votes,
+                                     double*             _probabilities
+                                    )  const
+{
+  for  (kkuint32 x = 0;  x < _mlClasses.QueueSize ();  ++x)
+  {
+    auto  classIdx = classesIndex->GetClassIndex (_mlClasses.IdxToPtr (x));
+    if  (classIdx.has_value ())
+    {
+      if  (_votes)  _votes[x] = classVotes[classIdx.value ()];
+      _probabilities[x] = classProbs[classIdx.value ()];
+    }
+    else
+    {
+      if  (_votes)  _votes[x] = 0;
+      _probabilities[x] = 0.0;
+    }
+  }
+}  /* ToCallersClassOrder */
+
+
+
 MLClassPtr  ModelKnn::Predict (FeatureVectorPtr  example,
                                RunLog&           log
                               )
 {
-  log.Level (-1) << "ModelKnn::Predict  ***ERROR***   Not Supported   example: " << example->ExampleFileName () << endl;
-  return NULL;
-}
+  ValidateIndex ("Predict", log);
+
+  PackedFeatureVectors  query (1, index->NumCols ());
+  PackQuery (example, query, 0);
+
+  KnnIndex::NeighborList  neighbors;
+  index->Search (query.Row (0), param->K (), neighbors);
+
+  kkuint32  numClasses = classes->QueueSize ();
+  vector<kkint32>  classVotes (numClasses);
+  vector<double>   classProbs (numClasses);
+  TallyNeighbors (neighbors, classVotes.data (), classProbs.data ());
+
+  kkint32  predIdx = -1;
+  double   predProb = -1.0;
+  for  (kkuint32 x = 0;  x < numClasses;  ++x)
+  {
+    if  (classProbs[x] > predProb)
+    {
+      predIdx  = x;
+      predProb = classProbs[x];
+    }
+  }
+
+  return  (predIdx < 0) ? NULL : classesIndex->GetMLClass (predIdx);
+}  /* Predict */
 
 
 
@@ -115,65 +290,123 @@ void  ModelKnn::Predict (FeatureVectorPtr  example,
                          RunLog&           log
                         )
 {
-  log.Level (-1) << "ModelKnn::Predict  ***ERROR***   Not Supported" << endl
-      << "example: " << example->ExampleFileName () << endl
-      << (knownClass ? 1 : 0) << (predClass1 ? 1 : 0) << (predClass2 ? 1 : 0) << endl;
-
-  predClass1Votes = 0;
-  predClass2Votes = 0;
-  probOfKnownClass = 0;
-  predClass1Prob = 0.0;
-  predClass2Prob = 0.0;
+  ValidateIndex ("Predict", log);
+
+  PackedFeatureVectors  query (1, index->NumCols ());
+  PackQuery (example, query, 0);
+
+  KnnIndex::NeighborList  neighbors;
+  index->Search (query.Row (0), param->K (), neighbors);
+
+  kkuint32  numClasses = classes->QueueSize ();
+  vector<kkint32>  classVotes (numClasses);
+  vector<double>   classProbs (numClasses);
+  TallyNeighbors (neighbors, classVotes.data (), classProbs.data ());
+
+  kkint32  pc1Idx = -1;
+  kkint32  pc2Idx = -1;
+  for  (kkuint32 x = 0;  x < numClasses;  ++x)
+  {
+    if  ((pc1Idx < 0)  ||  (classProbs[x] > classProbs[pc1Idx]))
+    {
+      pc2Idx = pc1Idx;
+      pc1Idx = x;
+    }
+    else if  ((pc2Idx < 0)  ||  (classProbs[x] > classProbs[pc2Idx]))
+    {
+      pc2Idx = x;
+    }
+  }
+
+  predClass1 = NULL;    predClass1Votes = 0;    predClass1Prob = 0.0;
+  predClass2 = NULL;    predClass2Votes = 0;    predClass2Prob = 0.0;
+
+  if  (pc1Idx >= 0)
+  {
+    predClass1      = classesIndex->GetMLClass (pc1Idx);
+    predClass1Votes = classVotes[pc1Idx];
+    predClass1Prob  = classProbs[pc1Idx];
+  }
+
+  if  (pc2Idx >= 0)
+  {
+    predClass2      = classesIndex->GetMLClass (pc2Idx);
+    predClass2Votes = classVotes[pc2Idx];
+    predClass2Prob  = classProbs[pc2Idx];
+  }
+
+  probOfKnownClass = 0.0;
+  auto  knownClassIdx = classesIndex->GetClassIndex (knownClass);
+  if  (knownClassIdx.has_value ())
+    probOfKnownClass = classProbs[knownClassIdx.value ()];
+
   numOfWinners = 0;
-  knownClassOneOfTheWinners = false;
-  breakTie = 0.0;
+  for  (kkuint32 x = 0;  x < numClasses;  ++x)
+  {
+    if  ((predClass1Prob > 0.0)  &&  (classProbs[x] == predClass1Prob))
+      ++numOfWinners;
+  }
+
+  knownClassOneOfTheWinners = (predClass1Prob > 0.0)  &&  (probOfKnownClass == predClass1Prob);
+
+  breakTie = predClass1Prob - predClass2Prob;
 }  /* Predict */
-                        
+
 
 
 ClassProbListPtr  ModelKnn::ProbabilitiesByClass (FeatureVectorPtr  example,
                                                   RunLog&           log
                                                  )
 {
-  if  (!classesIndex)
-  {
-    KKStr errMsg = "ModelKnn::ProbabilitiesByClass   ***ERROR***      (classLabelAssigments == NULL)";
-    log.Level (-1) << endl << endl << errMsg << endl << endl;
-    throw KKException (errMsg);
-  }
+  ValidateIndex ("ProbabilitiesByClass", log);
 
-  bool  newExampleCreated = false;
-  FeatureVectorPtr  encodedExample = PrepExampleForPrediction (example, newExampleCreated);
+  PackedFeatureVectors  query (1, index->NumCols ());
+  PackQuery (example, query, 0);
 
-  //  double  y = SVM289::svm_predict_probability (svmModel,  *encodedExample, classProbs, votes);
+  KnnIndex::NeighborList  neighbors;
+  index->Search (query.Row (0), param->K (), neighbors);
 
-  if  (newExampleCreated)
-  {
-    delete encodedExample;
-    encodedExample = NULL;
-  }
+  kkuint32  numClasses = classes->QueueSize ();
+  vector<kkint32>  classVotes (numClasses);
+  vector<double>   classProbs (numClasses);
+  TallyNeighbors (neighbors, classVotes.data (), classProbs.data ());
 
   ClassProbListPtr  results = new ClassProbList ();
-
-  for  (kkuint32 idx = 0;  idx < numOfClasses;  idx++)
+  for  (kkuint32 idx = 0;  idx < numClasses;  idx++)
   {
     MLClassPtr  ic = classesIndex->GetMLClass (idx);
-    results->PushOnBack (new ClassProb (ic, 0.0, 0.0f));
+    results->PushOnBack (new ClassProb (ic, classProbs[idx], (float)classVotes[idx]));
   }
 
+  results->SortByProbability (true);  // 'true' = Sort High to Low.
+
   return  results;
 }  /* ProbabilitiesByClass */
 
 
 
-void  ModelKnn::ProbabilitiesByClass (FeatureVectorPtr,
-                                      const MLClassList& ,
-                                      kkint32*,
-                                      double*,
-                                      RunLog&
+void  ModelKnn::ProbabilitiesByClass (FeatureVectorPtr    example,
+                                      const MLClassList&  _mlClasses,
+                                      kkint32*            _votes,
+                                      double*             _probabilities,
+                                      RunLog&             log
                                      )
 {
-}
+  ValidateIndex ("ProbabilitiesByClass", log);
+
+  PackedFeatureVectors  query (1, index->NumCols ());
+  PackQuery (example, query, 0);
+
+  KnnIndex::NeighborList  neighbors;
+  index->Search (query.Row (0), param->K (), neighbors);
+
+  kkuint32  numClasses = classes->QueueSize ();
+  vector<kkint32>  classVotes (numClasses);
+  vector<double>   classProbs (numClasses);
+  TallyNeighbors (neighbors, classVotes.data (), classProbs.data ());
+
+  ToCallersClassOrder (classVotes.data (), classProbs.data (), _mlClasses, _votes, _probabilities);
+}  /* ProbabilitiesByClass */
 
 
 
@@ -183,14 +416,84 @@ void  ModelKnn::ProbabilitiesByClass (FeatureVectorPtr    _example,
                                       RunLog&             log
                                      )
 {
-	log.Level (-1) << " ModelKnn::ProbabilitiesByClasss   *** NOYT IMPLEMENTED ***" << std::endl;
-	KKCheck (_example != nullptr, "_example must not be NULL!")
-	KKCheck (_probabilities != nullptr, "_probabilities must not be NULL!");
-  KKCheck (_mlClasses.QueueSize () > 0, "_mlClasses.QueueSize () must be greater than 0!")
+  KKCheck (_example != nullptr, "_example must not be NULL!")
+  KKCheck (_probabilities != nullptr, "_probabilities must not be NULL!");
+
+  ProbabilitiesByClass (_example, _mlClasses, NULL, _probabilities, log);
 }  /* ProbabilitiesByClass */
 
 
 
+void  ModelKnn::ProbabilitiesByClass (FeatureVectorList&  examples,
+                                      const MLClassList&  _mlClasses,
+                                      kkint32*            _votes,
+                                      double*             _probabilities,
+                                      RunLog&             log
+                                     )
+{
+  ValidateIndex ("ProbabilitiesByClass", log);
+
+  kkint32  numExamples = (kkint32)examples.QueueSize ();
+  if  (numExamples < 1)
+    return;
+
+  PackedFeatureVectors  queries (numExamples, index->NumCols ());
+  for  (kkint32 x = 0;  x < numExamples;  ++x)
+    PackQuery (examples.IdxToPtr (x), queries, x);
+
+  vector<KnnIndex::NeighborList>  neighbors;
+  index->SearchBatch (queries, param->K (), neighbors);
+
+  kkuint32  numClasses = classes->QueueSize ();
+  kkuint32  numCallersClasses = _mlClasses.QueueSize ();
+  vector<kkint32>  classVotes (numClasses);
+  vector<double>   classProbs (numClasses);
+
+  for  (kkint32 x = 0;  x < numExamples;  ++x)
+  {
+    TallyNeighbors (neighbors[x], classVotes.data (), classProbs.data ());
+    ToCallersClassOrder (classVotes.data (), classProbs.data (), _mlClasses,
+                         _votes ? (_votes + (kkMemSize)x * numCallersClasses) : NULL,
+                         _probabilities + (kkMemSize)x * numCallersClasses
+                        );
+  }
+}  /* ProbabilitiesByClass */
+
+
+
+void  ModelKnn::Predict (FeatureVectorList&        examples,
+                         std::vector<MLClassPtr>&  predictions,
+                         RunLog&                   log
+                        )
+{
+  ValidateIndex ("Predict", log);
+
+  kkuint32  numExamples = examples.QueueSize ();
+  kkuint32  numClasses  = classes->QueueSize ();
+
+  vector<double>  probabilities ((kkMemSize)numExamples * numClasses);
+  ProbabilitiesByClass (examples, *classes, NULL, probabilities.data (), log);
+
+  predictions.resize (numExamples);
+  for  (kkuint32 x = 0;  x < numExamples;  ++x)
+  {
+    const double*  p = probabilities.data () + (kkMemSize)x * numClasses;
+    kkint32  predIdx = -1;
+    double   predProb = -1.0;
+    for  (kkuint32 c = 0;  c < numClasses;  ++c)
+    {
+      if  (p[c] > predProb)
+      {
+        predIdx  = c;
+        predProb = p[c];
+      }
+    }
+    predictions[x] = (predIdx < 0) ? NULL : classes->IdxToPtr (predIdx);
+  }
+}  /* Predict */
+
+
+
 void  ModelKnn::TrainModel (FeatureVectorListPtr  _trainExamples,
                             bool                  _alreadyNormalized,
                             bool                  _takeOwnership,  /**< Model will take ownership of these examples */
@@ -200,6 +503,17 @@ void  ModelKnn::TrainModel (FeatureVectorListPtr  _trainExamples,
 {
   _log.Level (20) << "ModelKnn::TrainModel    alreadyNormalized[" << _alreadyNormalized << "]  _takeOwnership[" << _takeOwnership << "]." << endl;
 
+  if  (param == NULL)
+  {
+    validModel = false;
+    KKStr  errMsg = "ModelKnn::TrainModel   (param == NULL)";
+    _log.Level (-1) << endl << endl << errMsg << endl << endl;
+    throw KKException (errMsg);
+  }
+
+  delete  index;        index       = NULL;
+  delete  knnFeatures;  knnFeatures = NULL;
+
   try
   {
     Model::TrainModel (_trainExamples, _alreadyNormalized, _takeOwnership, _cancelFlag, _log);
@@ -209,6 +523,40 @@ void  ModelKnn::TrainModel (FeatureVectorListPtr  _trainExamples,
     validModel = false;
     throw e;
   }
+
+  if  (_cancelFlag)
+    return;
+
+  // 'Model::TrainModel' will have normalized and encoded 'trainExamples';  when they were encoded every
+  // feature of the encoded examples came from a selected feature.
+  if  (encoder)
+    knnFeatures = new FeatureNumList (FeatureNumList::AllFeatures (encoder->EncodedFileDesc ()));
+  else if  (param->SelectedFeatures ())
+    knnFeatures = new FeatureNumList (*(param->SelectedFeatures ()));
+  else
+    knnFeatures = new FeatureNumList (FeatureNumList::AllFeatures (fileDesc));
+
+  vector<kkint32>  labels (trainExamples->QueueSize ());
+  for  (kkuint32 x = 0;  x < trainExamples->QueueSize ();  ++x)
+  {
+    auto  label = classesIndex->GetClassIndex (trainExamples->IdxToPtr (x)->MLClass ());
+    if  (!label.has_value ())
+    {
+      validModel = false;
+      KKStr  errMsg = "ModelKnn::TrainModel   ***ERROR***   Example with class not in 'classesIndex';  should not be able to happen.";
+      _log.Level (-1) << endl << endl << errMsg << endl << endl;
+      throw KKException (errMsg);
+    }
+    labels[x] = label.value ();
+  }
+
+  TrainingTimeStart ();
+  index = new KnnIndex (*trainExamples, *knnFeatures, labels);
+  TrainingTimeEnd ();
+
+  _log.Level (20) << "ModelKnn::TrainModel   Points[" << index->NumPoints () << "]  Features[" << index->NumCols () << "]  "
+                  << (index->UsesTree () ? "KD-Tree Nodes[" + StrFromInt32 (index->NumNodes ()) + "]" : KKStr ("Brute Force"))
+                  << "  K[" << param->K () << "]  Voting[" << ModelParamKnn::VotingMethodToStr (param->VotingMethod ()) << "]" << endl;
 }  /* TrainModel */
 
 
@@ -217,7 +565,7 @@ void  ModelKnn::WriteXML (const KKStr&  varName,
                           ostream&      o
                          )  const
 {
-  XmlTag  startTag ("ModelParamDual",  XmlTag::TagTypes::tagStart);
+  XmlTag  startTag ("ModelKnn",  XmlTag::TagTypes::tagStart);
   if  (!varName.Empty ())
     startTag.AddAtribute ("VarName", varName);
   startTag.WriteXML (o);
@@ -227,7 +575,13 @@ void  ModelKnn::WriteXML (const KKStr&  varName,
   if  (param)
     param->WriteXML ("Param", o);
 
-  XmlTag  endTag ("ModelParamDual", XmlTag::TagTypes::tagEnd);
+  if  (knnFeatures)
+    knnFeatures->WriteXML ("KnnFeatures", o);
+
+  if  (index)
+    index->WriteXML ("Index", o);
+
+  XmlTag  endTag ("ModelKnn", XmlTag::TagTypes::tagEnd);
   endTag.WriteXML (o);
   o << endl;
 }  /* WriteXML */
@@ -254,6 +608,18 @@ void  ModelKnn::ReadXML (XmlStream&      s,
         delete  param;
         param = dynamic_cast<XmlElementModelParamKnnPtr> (t)->TakeOwnership ();
       }
+
+      else if  ((varName.EqualIgnoreCase ("KnnFeatures"))  &&  (typeid (*t) == typeid (XmlElementFeatureNumList)))
+      {
+        delete  knnFeatures;
+        knnFeatures = dynamic_cast<XmlElementFeatureNumListPtr> (t)->TakeOwnership ();
+      }
+
+      else if  ((varName.EqualIgnoreCase ("Index"))  &&  (typeid (*t) == typeid (XmlElementKnnIndex)))
+      {
+        delete  index;
+        index = dynamic_cast<XmlElementKnnIndexPtr> (t)->TakeOwnership ();
+      }
       else
       {
         KKStr  errMsg (256);
@@ -293,7 +659,46 @@ void  ModelKnn::ReadXML (XmlStream&      s,
     param = dynamic_cast<ModelParamKnnPtr> (Model::param);
   }
 
+  if  ((!index)  ||  (!knnFeatures))
+  {
+    KKStr errMsg = "ModelKnn::ReadXML  ***ERROR***  'Index' or 'KnnFeatures' not defined.";
+    AddErrorMsg (errMsg, 0);
+    log.Level (-1) << endl << errMsg << endl << endl;
+  }
+
+  else if  ((kkint32)knnFeatures->NumSelFeatures () != index->NumCols ())
+  {
+    KKStr errMsg (128);
+    errMsg << "ModelKnn::ReadXML  ***ERROR***  KnnFeatures[" << knnFeatures->NumSelFeatures () << "] does not agree with Index NumCols[" << index->NumCols () << "].";
+    AddErrorMsg (errMsg, 0);
+    log.Level (-1) << endl << errMsg << endl << endl;
+  }
+
   ReadXMLModelPost (log);
+
+  if  (index  &&  classes)
+  {
+    // 'TallyNeighbors' uses the stored labels to index per class arrays;  a mismatched model file must not get that far.
+    kkint32  numClasses = (kkint32)classes->QueueSize ();
+    for  (kkint32 row = 0;  row < index->NumPoints ();  ++row)
+    {
+      kkint32  label = index->Label (row);
+      if  ((label < 0)  ||  (label >= numClasses))
+      {
+        KKStr errMsg (128);
+        errMsg << "ModelKnn::ReadXML  ***ERROR***  Index Label[" << label << "] at row[" << row << "] is outside of the class list[" << numClasses << "].";
+        log.Level (-1) << endl << errMsg << endl << endl;
+        throw KKException (errMsg);
+      }
+    }
+  }
+
+  // The index was built from encoded examples so examples to be predicted need to be encoded the same way.
+  if  (param  &&  fileDesc  &&  (!encoder)  &&
+       (param->EncodingMethod () != ModelParam::EncodingMethodType::Null)  &&
+       (param->EncodingMethod () != ModelParam::EncodingMethodType::NoEncoding)
+      )
+    encoder = new FeatureEncoder2 (*param, fileDesc);
 }  /* ReadXML */
 
 
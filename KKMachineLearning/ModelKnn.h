@@ -2,11 +2,21 @@
 #define  _MODELKNN_
 
 #include "FeatureVector.h"
+#include "KnnIndex.h"
 #include "Model.h"
 #include "ModelParamKnn.h"
 
 namespace  KKMLL
 {
+  /**
+   *@class  ModelKnn
+   *@brief  k-nearest-neighbor classifier.
+   *@details  'TrainModel' packs the selected features of the training examples into a 'KnnIndex'; a KD-tree when
+   * there are few features, otherwise a brute force scan using 'KernelEngine'.  A prediction finds the 'K' nearest
+   * training examples and lets them vote for their class, either one vote each or weighted by an RBF of their
+   * distance;  see 'ModelParamKnn::VotingMethodType'.  The probability of a class is its share of the total vote.
+   * The index is saved with the model by 'WriteXML'.
+   */
   class  ModelKnn: public Model
   {
   public:
@@ -29,8 +39,14 @@ namespace  KKMLL
     virtual
     ModelKnnPtr  Duplicate ()  const;
 
+    /** @brief  Shares the trained 'KnnIndex';  searching it does not change it. */
+    virtual
+    ModelPtr     ShareForPrediction ()  const;
+
     virtual ModelTypes   ModelType ()  const  {return ModelTypes::KNN;}
 
+    virtual kkMemSize    MemoryConsumedEstimated ()  const;
+
 
     ModelParamKnnPtr   Param ();
 
@@ -93,6 +109,27 @@ namespace  KKMLL
                                );
 
 
+    /**
+     *@brief  Batch version of 'ProbabilitiesByClass'; all the examples are searched for in one pass over the index.
+     *@details  '_votes' and '_probabilities' must have room for  examples.QueueSize () * _mlClasses.QueueSize ()
+     * entries;  the results for 'examples[e]' and '_mlClasses[c]' are placed in entry  e * _mlClasses.QueueSize () + c.
+     * '_votes' may be NULL.
+     */
+    void  ProbabilitiesByClass (FeatureVectorList&  examples,
+                                const MLClassList&  _mlClasses,
+                                kkint32*            _votes,
+                                double*             _probabilities,
+                                RunLog&             log
+                               );
+
+
+    /** @brief  Batch version of 'Predict';  'predictions[x]' will be the class predicted for 'examples[x]'. */
+    void  Predict (FeatureVectorList&        examples,
+                   std::vector<MLClassPtr>&  predictions,
+                   RunLog&                   log
+                  );
+
+
     virtual  void  TrainModel (FeatureVectorListPtr  _trainExamples,
                                bool                  _alreadyNormalized,
                                bool                  _takeOwnership,  /**< Model will take ownership of these examples */
@@ -114,7 +151,38 @@ namespace  KKMLL
 
 
   private:
-    ModelParamKnnPtr   param;   /**<   We will NOT own this instance; it will point to same instance defined in parent class Model.  */
+    /** @brief  Packs the features the index was built from of 'example', preparing it first if needed, into 'query' row 'row'. */
+    void  PackQuery (FeatureVectorPtr       example,
+                     PackedFeatureVectors&  query,
+                     kkint32                row
+                    );
+
+    /**
+     *@brief  Converts the neighbors found for one example into per class results.
+     *@param[in]  neighbors      Result of a 'KnnIndex' search.
+     *@param[out] classVotes     Number of neighbors in each class;  indexed by 'classesIndex'.
+     *@param[out] classProbs     Share of the total vote for each class;  indexed by 'classesIndex'.
+     */
+    void  TallyNeighbors (const KnnIndex::NeighborList&  neighbors,
+                          kkint32*                       classVotes,
+                          double*                        classProbs
+                         )  const;
+
+    /** @brief  Maps results indexed by 'classesIndex' to the order of '_mlClasses';  '_votes' may be NULL. */
+    void  ToCallersClassOrder (const kkint32*      classVotes,
+                               const double*       classProbs,
+                               const MLClassList&  _mlClasses,
+                               kkint32*            _votes,
+                               double*             _probabilities
+                              )  const;
+
+    void  ValidateIndex (const char*  funcName,
+                         RunLog&      log
+                        )  const;
+
+    KnnIndexPtr        index;         /**< Not owned by instances made by 'ShareForPrediction';  nor is 'knnFeatures'. */
+    FeatureNumListPtr  knnFeatures;   /**< Features of prepared examples that 'index' was built from.  */
+    ModelParamKnnPtr   param;         /**<   We will NOT own this instance; it will point to same instance defined in parent class Model.  */
   };  /* ModelKnn */
 
   typedef  ModelKnn::ModelKnnPtr  ModelKnnPtr;
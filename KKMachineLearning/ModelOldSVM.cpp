@@ -110,6 +110,23 @@ ModelOldSVMPtr  ModelOldSVM::Duplicate ()  const
 
 
 
+ModelPtr  ModelOldSVM::ShareForPrediction ()  const
+{
+  if  (!svmModel)
+    return  NULL;
+
+  SVMModelPtr  sharedSvmModel = svmModel->ShareForPrediction ();
+  if  (!sharedSvmModel)
+    return  NULL;
+
+  ModelOldSVMPtr  shared = new ModelOldSVM (*this);
+  shared->ShareTrainedParts (*this);
+  shared->svmModel = sharedSvmModel;
+  return  shared;
+}  /* ShareForPrediction */
+
+
+
 KKStr  ModelOldSVM::Description ()  const
 {
   KKStr  result = "SVM(" + Name () + ")";
@@ -347,6 +364,46 @@ void  ModelOldSVM::ProbabilitiesByClass (FeatureVectorPtr    example,
 
 
 
+void  ModelOldSVM::ProbabilitiesByClassForBlock (FeatureVectorList&  examples,
+                                                 kkuint32            start,
+                                                 kkuint32            end,
+                                                 const MLClassList&  mlClasses,
+                                                 kkint32*            votes,
+                                                 double*             probabilities,
+                                                 RunLog&             log
+                                                )
+{
+  if  (!svmModel)
+  {
+    KKStr  errMsg = "ModelOldSVM::ProbabilitiesByClassForBlock   ***ERROR***      (svmModel == NULL)";
+    log.Level (-1) << endl << errMsg << endl;
+    throw KKException (errMsg);
+  }
+
+  FeatureVectorListPtr  prepared = PrepExamplesForPrediction (examples, start, end, log);
+  if  (!prepared)
+  {
+    prepared = new FeatureVectorList (examples.FileDesc (), false);
+    for  (kkuint32 x = start;  x < end;  ++x)
+      prepared->PushOnBack (examples.IdxToPtr (x));
+  }
+
+  // 'SVMModel' leaves the entries of classes it does not know about alone.
+  kkMemSize  numCells = (kkMemSize)(end - start) * mlClasses.QueueSize ();
+  for  (kkMemSize x = 0;  x < numCells;  ++x)
+  {
+    votes[x] = 0;
+    probabilities[x] = 0.0;
+  }
+
+  svmModel->ProbabilitiesByClass (*prepared, mlClasses, votes, probabilities, log);
+
+  delete  prepared;
+  prepared = NULL;
+}  /* ProbabilitiesByClassForBlock */
+
+
+
 vector<KKStr>  ModelOldSVM::SupportVectorNames (MLClassPtr  c1,
                                                 MLClassPtr  c2
                                                )  const
@@ -454,7 +511,7 @@ void  ModelOldSVM::TrainModel (FeatureVectorListPtr  _trainExamples,
   try
   {
     TrainingTimeStart ();
-    svmModel = new SVMModel (*svmParam, *trainExamples, *assignments, fileDesc, _log);
+    svmModel = new SVMModel (*svmParam, *trainExamples, *assignments, fileDesc, _cancelFlag, _log);
     TrainingTimeEnd ();
   }
   catch (...)
@@ -481,6 +538,7 @@ FeatureVectorPtr  ModelOldSVM::PrepExampleForPrediction (FeatureVectorPtr  fv,
 {
   FeatureVectorPtr  oldFV = NULL;
   newExampleCreated = false;
+
   if  ((!alreadyNormalized)  &&  (normParms))
   {
     oldFV = fv;
@@ -500,6 +558,25 @@ FeatureVectorPtr  ModelOldSVM::PrepExampleForPrediction (FeatureVectorPtr  fv,
 
 
 
+FeatureVectorListPtr  ModelOldSVM::PrepExamplesForPrediction (FeatureVectorList&  examples,
+                                                              kkuint32            start,
+                                                              kkuint32            end,
+                                                              RunLog&             log
+                                                             )
+{
+  if  ((alreadyNormalized)  ||  (!normParms))
+    return  NULL;
+
+  FeatureVectorListPtr  prepared = new FeatureVectorList (examples.FileDesc (), true);
+  for  (kkuint32 x = start;  x < end;  ++x)
+    prepared->PushOnBack (normParms->ToNormalized (examples.IdxToPtr (x)));
+
+  log.Level (50) << "ModelOldSVM::PrepExamplesForPrediction   Prepared[" << prepared->QueueSize () << "]  examples." << endl;
+  return  prepared;
+}  /* PrepExamplesForPrediction */
+
+
+
 void  ModelOldSVM::WriteXML (const KKStr&  varName,
                              ostream&      o
                             )  const
@@ -59,6 +59,10 @@ namespace KKMLL
     virtual
     ModelOldSVMPtr  Duplicate ()  const;
 
+    /** @brief  Shares the trained 'SVMModel' through 'SVMModel::ShareForPrediction'. */
+    virtual
+    ModelPtr  ShareForPrediction ()  const;
+
     virtual ModelTypes       ModelType () const  {return ModelTypes::OldSVM;}
 
     const ClassAssignments&  Assignments () const;
@@ -170,6 +174,21 @@ namespace KKMLL
                                );
 
 
+    /**
+     *@brief  Normalizes the block with 'PrepExamplesForPrediction' and passes it to 'SVMModel::ProbabilitiesByClass'
+     *        which evaluates the kernel for all of it at once.
+     */
+    virtual
+    void  ProbabilitiesByClassForBlock (FeatureVectorList&  examples,
+                                        kkuint32            start,
+                                        kkuint32            end,
+                                        const MLClassList&  mlClasses,
+                                        kkint32*            votes,
+                                        double*             probabilities,
+                                        RunLog&             log
+                                       );
+
+
 
     /**
      *@brief  For a given two class pair return the names of the 'numToFind' worst S/V's.
@@ -216,7 +235,17 @@ namespace KKMLL
     FeatureVectorPtr   PrepExampleForPrediction (FeatureVectorPtr  fv,
                                                  bool&             newExampleCreated
                                                 );    
-    
+
+
+    /** @brief  ModelOldSVM Specific 'PrepExamplesForPrediction';  like 'PrepExampleForPrediction' will only normalize data. */
+    virtual
+    FeatureVectorListPtr  PrepExamplesForPrediction (FeatureVectorList&  examples,
+                                                     kkuint32            start,
+                                                     kkuint32            end,
+                                                     RunLog&             log
+                                                    );
+
+
     std::vector<KKStr>  SupportVectorNames ()  const;
 
 
@@ -22,16 +22,18 @@ using namespace KKMLL;
 
 
 ModelParamKnn::ModelParamKnn  ():
-  ModelParam (),
-  k(1)
+  ModelParam   (),
+  k            (1),
+  votingMethod (VotingMethodType::Majority)
 {
 }
 
 
 
 ModelParamKnn::ModelParamKnn  (const ModelParamKnn&  _param):
-    ModelParam (_param),
-    k          (_param.k)
+    ModelParam   (_param),
+    k            (_param.k),
+    votingMethod (_param.votingMethod)
 {
 }
 
@@ -50,11 +52,44 @@ ModelParamKnnPtr  ModelParamKnn::Duplicate ()  const
 
 
 
-KKStr  ModelParamKnn::ToCmdLineStr (RunLog&  log)  const
+KKStr  ModelParamKnn::VotingMethodToStr (VotingMethodType  votingMethod)
 {
-  log.Level(50) << "ModelParamKnn::ToCmdLineStr" << endl;
-  return  ModelParam::ToCmdLineStr () + "  -K " + StrFormatInt (k, "###0");
-}
+  if  (votingMethod == VotingMethodType::Majority)
+    return  "Majority";
+
+  else if  (votingMethod == VotingMethodType::RbfWeighted)
+    return  "RbfWeighted";
+
+  else
+    return  "Null";
+}  /* VotingMethodToStr */
+
+
+
+ModelParamKnn::VotingMethodType  ModelParamKnn::VotingMethodFromStr (const KKStr&  votingMethodStr)
+{
+  KKStr  votingMethodUpper = votingMethodStr.ToUpper ();
+
+  if  ((votingMethodUpper == "MAJORITY")  ||  (votingMethodUpper == "EUCLIDEAN"))
+    return  VotingMethodType::Majority;
+
+  if  ((votingMethodUpper == "RBFWEIGHTED")  ||  (votingMethodUpper == "RBF"))
+    return  VotingMethodType::RbfWeighted;
+
+  return  VotingMethodType::Null;
+}  /* VotingMethodFromStr */
+
+
+
+KKStr  ModelParamKnn::ToCmdLineStr ()  const
+{
+  KKStr  cmdStr = ModelParam::ToCmdLineStr ();
+  cmdStr << "  -K " << k
+         << "  -Voting " << VotingMethodToStr (votingMethod);
+  if  (votingMethod == VotingMethodType::RbfWeighted)
+    cmdStr << "  -Gamma " << Gamma ();
+  return  cmdStr;
+}  /* ToCmdLineStr */
 
 
 
@@ -72,9 +107,21 @@ void  ModelParamKnn::ParseCmdLineParameter (const KKStr&  parameter,
     if  ((k < 1)  ||  (k > 1000))
     {
       log.Level (-1) << "ModelParamKnn::ParseCmdLineParameter  ***ERROR***     Invalid -K parameter[" << value << "]" << endl;
-      validParam = false;
+      ValidParam (false);
     }
   }
+
+  else if  (parameter.EqualIgnoreCase ("-Voting")  ||  parameter.EqualIgnoreCase ("-VotingMethod"))
+  {
+    votingMethod = VotingMethodFromStr (value);
+    if  (votingMethod == VotingMethodType::Null)
+    {
+      log.Level (-1) << "ModelParamKnn::ParseCmdLineParameter  ***ERROR***     Invalid -Voting parameter[" << value << "]  expected 'Majority' or 'RbfWeighted'." << endl;
+      votingMethod = VotingMethodType::Majority;
+      ValidParam (false);
+    }
+  }
+
   else
   {
     parameterUsed = false;
@@ -87,7 +134,7 @@ void  ModelParamKnn::WriteXML (const KKStr&  varName,
                                ostream&      o
                               )  const
 {
-  XmlTag  startTag ("ModelParamDual",  XmlTag::TagTypes::tagStart);
+  XmlTag  startTag ("ModelParamKnn",  XmlTag::TagTypes::tagStart);
   if  (!varName.Empty ())
     startTag.AddAtribute ("VarName", varName);
   startTag.WriteXML (o);
@@ -95,7 +142,10 @@ void  ModelParamKnn::WriteXML (const KKStr&  varName,
 
   WriteXMLFields (o);
 
-  XmlTag  endTag ("ModelParamDual", XmlTag::TagTypes::tagEnd);
+  XmlElementInt32::WriteXML (k, "k", o);
+  VotingMethodToStr (votingMethod).WriteXML ("VotingMethod", o);
+
+  XmlTag  endTag ("ModelParamKnn", XmlTag::TagTypes::tagEnd);
   endTag.WriteXML (o);
   o << endl;
 }  /* WriteXML */
@@ -118,10 +168,14 @@ void  ModelParamKnn::ReadXML (XmlStream&      s,
       const KKStr&  varName = t->VarName ();
 
       if  (varName.EqualIgnoreCase ("k"))
-        k = dynamic_cast<XmlElementInt32Ptr> (t)->Value ();
-
-      else if  (varName.EqualIgnoreCase ("fileName"))
-        fileName = *(dynamic_cast<XmlElementKKStrPtr> (t)->Value ());
+        k = dynamic_cast<XmlElementPtr> (t)->ToInt32 ();
+
+      else if  (varName.EqualIgnoreCase ("VotingMethod"))
+      {
+        votingMethod = VotingMethodFromStr (dynamic_cast<XmlElementPtr> (t)->ToKKStr ());
+        if  (votingMethod == VotingMethodType::Null)
+          votingMethod = VotingMethodType::Majority;
+      }
     }
 
     delete  t;
@@ -10,6 +10,22 @@ namespace KKMLL
   public:
     typedef  ModelParamKnn*  ModelParamKnnPtr;
 
+    /**
+     *@brief  How the 'k' nearest neighbors vote for their class.
+     *@details  'Majority' gives each neighbor one vote.  'RbfWeighted' weights each neighbor by exp (-Gamma * d^2)
+     * where d is its Euclidean distance and Gamma comes from the '-Gamma' parameter;  when Gamma is not
+     * positive 1 / (number of features) is used.
+     */
+    enum  class  VotingMethodType: int
+    {
+      Null,
+      Majority,
+      RbfWeighted
+    };
+
+    static  KKStr             VotingMethodToStr   (VotingMethodType  votingMethod);
+    static  VotingMethodType  VotingMethodFromStr (const KKStr&      votingMethodStr);
+
     ModelParamKnn  ();
 
 
@@ -25,11 +41,17 @@ namespace KKMLL
 
     virtual ModelParamTypes  ModelParamType () const {return ModelParamTypes::KNN;}
 
+    kkint32           K            ()  const  {return k;}
+    VotingMethodType  VotingMethod ()  const  {return votingMethod;}
+
+    void  K            (kkint32           _k)             {k            = _k;}
+    void  VotingMethod (VotingMethodType  _votingMethod)  {votingMethod = _votingMethod;}
+
     /*! 
      @brief Creates a Command Line String that represents these parameters.
      */
     virtual
-    KKStr   ToCmdLineStr (RunLog&  log)  const;
+    KKStr   ToCmdLineStr ()  const;
 
 
     virtual  void  ReadXML (XmlStream&      s,
@@ -53,14 +75,9 @@ namespace KKMLL
                                 );
 
 
-
-    FileDescPtr              fileDesc;
-
-    KKStr                    fileName;
-
     kkint32                  k;                 /**< The number of nearest neighbors to process. */
 
-    bool                     validParam;
+    VotingMethodType         votingMethod;
   };  /* ModelParamKnn */
 
   typedef  ModelParamKnn::ModelParamKnnPtr  ModelParamKnnPtr;
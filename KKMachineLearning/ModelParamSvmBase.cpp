@@ -140,7 +140,7 @@ void  ModelParamSvmBase::WriteXML (const KKStr&  varName,
                                    ostream&      o
                                   )  const
 {
-  XmlTag  startTag ("ModelParamOldSVM",  XmlTag::TagTypes::tagStart);
+  XmlTag  startTag ("ModelParamSvmBase",  XmlTag::TagTypes::tagStart);
   if  (!varName.Empty ())
     startTag.AddAtribute ("VarName", varName);
   startTag.WriteXML (o);
@@ -150,7 +150,7 @@ void  ModelParamSvmBase::WriteXML (const KKStr&  varName,
   
   svmParam.ToTabDelStr ().WriteXML ("SvmParam", o);
 
-  XmlTag  endTag ("ModelParamOldSVM", XmlTag::TagTypes::tagEnd);
+  XmlTag  endTag ("ModelParamSvmBase", XmlTag::TagTypes::tagEnd);
   endTag.WriteXML (o);
   o << endl;
 }  /* WriteXML */
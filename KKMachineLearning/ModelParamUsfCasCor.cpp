@@ -28,7 +28,8 @@ ModelParamUsfCasCor::ModelParamUsfCasCor  ():
   number_of_rounds (-1),
   number_of_trials (1),
   random_seed      (0),
-  useCache         (false)
+  useCache         (false),
+  numThreads       (1)
 {
 }
 
@@ -47,7 +48,8 @@ ModelParamUsfCasCor::ModelParamUsfCasCor  (int      _in_limit,
       number_of_rounds (_number_of_rounds),
       number_of_trials (_number_of_trials),
       random_seed      (_random_seed),
-      useCache         (_useCache)
+      useCache         (_useCache),
+      numThreads       (1)
 {}
   
 
@@ -117,6 +119,11 @@ void  ModelParamUsfCasCor::ParseCmdLineParameter (const KKStr&  parameter,
       useCache = value.ToBool ();
   }
 
+  else if  (parameter.EqualIgnoreCase ("-NumThreads")  ||
+            parameter.EqualIgnoreCase ("-Threads")
+      )
+    numThreads = (kkuint32)value.ToInt ();
+
   else
     parameterUsed = false;
 }  /* ParseCmdLineParameter */
@@ -154,6 +161,9 @@ KKStr   ModelParamUsfCasCor::ToCmdLineStr () const
 
   cmdStr << " -UseCache " << (useCache ? "Yes" : "No");
 
+  if  (numThreads != 1)
+    cmdStr << " -Threads " << numThreads;
+
   return  cmdStr;
 }  /* ToCmdLineStr */
 
@@ -177,6 +187,7 @@ void  ModelParamUsfCasCor::WriteXML (const KKStr&  varName,
   XmlElementInt32::WriteXML (number_of_trials,  "number_of_trials", o);
   XmlElementInt64::WriteXML (random_seed,       "random_seed",      o);
   XmlElementBool::WriteXML  (useCache,          "useCache",         o);
+  XmlElementUInt32::WriteXML (numThreads,       "numThreads",       o);
   
   XmlTag  endTag ("ModelParamUsfCasCor", XmlTag::TagTypes::tagEnd);
   endTag.WriteXML (o);
@@ -216,6 +227,9 @@ void  ModelParamUsfCasCor::ReadXML (XmlStream&      s,
       else if  (varName.EqualIgnoreCase ("useCache"))
         useCache =  dynamic_cast<XmlElementBoolPtr> (e)->Value ();
 
+      else if  (varName.EqualIgnoreCase ("numThreads"))
+        numThreads =  dynamic_cast<XmlElementUInt32Ptr> (e)->Value ();
+
       else
       {
         log.Level (-1) << endl
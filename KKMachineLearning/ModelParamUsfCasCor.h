@@ -41,6 +41,7 @@ namespace KKMLL
     int      Number_of_trials () const {return number_of_trials;}
     kkint64  Random_seed      () const {return random_seed;}
     bool     UseCache         () const {return useCache;}
+    kkuint32 NumThreads       () const {return numThreads;}
 
 
     // Member update method  s
@@ -50,6 +51,7 @@ namespace KKMLL
     void  Number_of_trials (int      _number_of_trials) {number_of_trials  = _number_of_trials;}
     void  Random_seed      (kkint64  _random_seed)      {random_seed       = _random_seed;}
     void  UseCache         (bool     _useCache)         {useCache          = _useCache;}
+    void  NumThreads       (kkuint32 _numThreads)       {numThreads        = _numThreads;}
 
 
     /**
@@ -86,6 +88,7 @@ namespace KKMLL
     int      number_of_trials;
     kkint64  random_seed;
     bool     useCache;
+    kkuint32 numThreads;   /**< Threads used to train candidates;  1 = serial, 0 = one per processor. */
   };  /* ModelParamUsfCasCor */
 
   typedef  ModelParamUsfCasCor*   ModelParamUsfCasCorPtr;
@@ -31,8 +31,12 @@ using namespace  KKMLL;
 
 ModelSvmBase::ModelSvmBase ():
   Model (),
-  param     (NULL),
-  svmModel  (NULL)
+  decValues        (),
+  pairwiseProbData (),
+  pairwiseProb     (),
+  probEstimates    (),
+  param            (NULL),
+  svmModel         (NULL)
 {
 }
 
@@ -40,8 +44,12 @@ ModelSvmBase::ModelSvmBase ():
 
 ModelSvmBase::ModelSvmBase (FactoryFVProducerPtr  _factoryFVProducer):
   Model (_factoryFVProducer),
-  param     (NULL),
-  svmModel  (NULL)
+  decValues        (),
+  pairwiseProbData (),
+  pairwiseProb     (),
+  probEstimates    (),
+  param            (NULL),
+  svmModel         (NULL)
 {
 }
 
@@ -52,8 +60,12 @@ ModelSvmBase::ModelSvmBase (const KKStr&             _name,
                             FactoryFVProducerPtr     _factoryFVProducer
                            ):
   Model (_name, _param, _factoryFVProducer),
-  param     (NULL),
-  svmModel  (NULL)
+  decValues        (),
+  pairwiseProbData (),
+  pairwiseProb     (),
+  probEstimates    (),
+  param            (NULL),
+  svmModel         (NULL)
 {
   param = dynamic_cast<ModelParamSvmBasePtr> (Model::param);
 }
@@ -63,8 +75,12 @@ ModelSvmBase::ModelSvmBase (const KKStr&             _name,
 
 ModelSvmBase::ModelSvmBase (const ModelSvmBase&   _model):
   Model (_model),
-  param     (NULL),
-  svmModel  (NULL)
+  decValues        (),
+  pairwiseProbData (),
+  pairwiseProb     (),
+  probEstimates    (),
+  param            (NULL),
+  svmModel         (NULL)
 {
   param = dynamic_cast<ModelParamSvmBasePtr> (Model::param);
   if  (_model.svmModel)
@@ -82,7 +98,12 @@ ModelSvmBase::~ModelSvmBase ()
 {
   // The base class owns param,  so we do not delete it.
   // delete  param;
-  if  (svmModel)
+  if  (predictionSource)
+  {
+    // Belongs to the model this instance was shared from.
+    svmModel = NULL;
+  }
+  else if  (svmModel)
   {
     svm_destroy_model (svmModel);   // 'svm_destroy_model'  will also delete  'svmModel'.
     delete  svmModel;
@@ -112,6 +133,37 @@ ModelSvmBasePtr  ModelSvmBase::Duplicate ()  const
 
 
 
+ModelPtr  ModelSvmBase::ShareForPrediction ()  const
+{
+  if  ((!svmModel)  ||  (!param))
+    return  NULL;
+
+  ModelSvmBasePtr  shared = new ModelSvmBase (Name (), *param, factoryFVProducer);
+  shared->ShareTrainedParts (*this);
+  shared->svmModel = svmModel;
+  return  shared;
+}  /* ShareForPrediction */
+
+
+
+void  ModelSvmBase::PredictProbabilities (const FeatureVector&  encodedExample)
+{
+  kkuint32  nr_class = svmModel->nr_class;
+  if  (pairwiseProb.size () != nr_class)
+  {
+    decValues.assign (nr_class * (nr_class - 1) / 2, 0.0);
+    probEstimates.assign (nr_class, 0.0);
+    pairwiseProbData.assign (nr_class * nr_class, 0.0);
+    pairwiseProb.assign (nr_class, NULL);
+    for  (kkuint32 x = 0;  x < nr_class;  ++x)
+      pairwiseProb[x] = pairwiseProbData.data () + x * nr_class;
+  }
+
+  SVM289_MFS::svm_predict_probability (svmModel, encodedExample, classProbs, votes, decValues.data (), pairwiseProb.data (), probEstimates.data ());
+}  /* PredictProbabilities */
+
+
+
 KKStr  ModelSvmBase::Description ()  const
 {
   KKStr  result = "SvmBase(" + Name () + ")";
@@ -304,7 +356,7 @@ void  ModelSvmBase::Predict (FeatureVectorPtr  example,
   bool  newExampleCreated = false;
   FeatureVectorPtr  encodedExample = PrepExampleForPrediction (example, newExampleCreated);
 
-  SVM289_MFS::svm_predict_probability (svmModel,  *encodedExample, classProbs, votes);
+  PredictProbabilities (*encodedExample);
 
   if  (newExampleCreated)
   {
@@ -398,7 +450,7 @@ ClassProbListPtr  ModelSvmBase::ProbabilitiesByClass (FeatureVectorPtr  example,
   bool  newExampleCreated = false;
   FeatureVectorPtr  encodedExample = PrepExampleForPrediction (example, newExampleCreated);
 
-  SVM289_MFS::svm_predict_probability (svmModel,  *encodedExample, classProbs, votes);
+  PredictProbabilities (*encodedExample);
 
   if  (newExampleCreated)
   {
@@ -445,7 +497,7 @@ void  ModelSvmBase::ProbabilitiesByClass (FeatureVectorPtr    example,
   bool  newExampleCreated = false;
   FeatureVectorPtr  encodedExample = PrepExampleForPrediction (example, newExampleCreated);
 
-  SVM289_MFS::svm_predict_probability (svmModel,  *encodedExample, classProbs, votes);
+  PredictProbabilities (*encodedExample);
 
   if  (newExampleCreated)
   {
@@ -501,7 +553,7 @@ void   ModelSvmBase::ProbabilitiesByClass (FeatureVectorPtr    _example,
   bool  newExampleCreated = false;
   FeatureVectorPtr  encodedExample = PrepExampleForPrediction (_example, newExampleCreated);
 
-  SVM289_MFS::svm_predict_probability (svmModel,  *encodedExample, classProbs, votes);
+  PredictProbabilities (*encodedExample);
 
   if  (newExampleCreated)
   {
@@ -559,9 +611,10 @@ void  ModelSvmBase::RetrieveCrossProbTable (MLClassList&  _classes,
       _crossProbTable[idx1][idx2] = 0.0;
   }
 
-  double** pairWiseProb = svmModel->PairwiseProb ();
-  if  (!pairWiseProb)
+  // Nothing has been predicted yet.
+  if  (pairwiseProb.empty ())
     return;
+  double*const*  pairWiseProb = pairwiseProb.data ();
 
   for  (idx1 = 0;  idx1 < (_classes.size () - 1);  idx1++)
   {
@@ -53,6 +53,9 @@ typedef  ClassProbList*  ClassProbListPtr;
 
     virtual  ModelSvmBasePtr    Duplicate ()  const;
 
+    /** @brief  Shares 'svmModel';  the new instance has its own work areas for 'svm_predict_probability'. */
+    virtual  ModelPtr     ShareForPrediction ()  const;
+
     virtual  kkMemSize    MemoryConsumedEstimated ()  const;
 
     virtual ModelTypes    ModelType () const  {return ModelTypes::SvmBase;}
@@ -150,8 +153,18 @@ typedef  ClassProbList*  ClassProbListPtr;
 
 
   protected:
+    /** @brief  Calls 'svm_predict_probability' with this instance's work areas;  fills in 'classProbs' and 'votes'. */
+    void  PredictProbabilities (const FeatureVector&  encodedExample);
+
+    VectorDouble            decValues;         /**< Work areas of 'PredictProbabilities';  per instance rather than in 'svmModel'
+                                                * so that instances made by 'ShareForPrediction' can predict at the same time.
+                                                */
+    VectorDouble            pairwiseProbData;
+    std::vector<double*>    pairwiseProb;      /**< Rows of 'pairwiseProbData';  pair-wise probabilities of the last prediction. */
+    VectorDouble            probEstimates;
+
     ModelParamSvmBasePtr    param;   /*!<   We will NOT own this instance. It will point to same instance defined in parent class Model.  */
-    SVM289_MFS::Svm_Model*  svmModel;
+    SVM289_MFS::Svm_Model*  svmModel;  /**< Not owned by instances made by 'ShareForPrediction'. */
   };  /* ModelSvmBase */
   
   typedef  ModelSvmBase::ModelSvmBasePtr  ModelSvmBasePtr;
@@ -177,6 +177,7 @@ void  ModelUsfCasCor::TrainModel (FeatureVectorListPtr  _trainExamples,
                                            param->Number_of_trials (),
                                            param->Random_seed      (),
                                            param->UseCache         (),
+                                           param->NumThreads       (),
                                            trainExamples,
                                            SelectedFeatures (),
                                            _cancelFlag,
@@ -163,6 +163,54 @@ void  NormalizationParms::DeriveNormalizationParameters (FeatureVectorList&  _ex
 
   FeatureVectorList::iterator imageIDX;
 
+  FeatureDataBlockPtr  block = _examples.ContiguousFeatureData ();
+  if  (block)
+  {
+    // Decide which examples to use in one pass;  the sums then run through the block one row after another.
+    vector<bool>  useRow (block->NumRows (), false);
+    kkuint32  row = 0;
+    for  (imageIDX = _examples.begin ();  imageIDX != _examples.end ();  ++imageIDX, ++row)
+    {
+      image = *imageIDX;
+      useRow[row] = (!image->MLClass ()->UnDefined ())  &&  (!image->MissingData ())  &&  image->FeatureDataValid ();
+      if  (useRow[row])
+        numOfExamples++;
+    }
+
+    for  (row = 0;  row < block->NumRows ();  ++row)
+    {
+      if  (!useRow[row])
+        continue;
+      const float*  rowData = block->Row (row);
+      for  (kkuint32 i = 0;  i < numOfFeatures;  ++i)
+        total[i] += double (rowData[i]);
+    }
+
+    for  (kkuint32 i = 0;  i < numOfFeatures;  ++i)
+      mean[i] = total[i] / double (numOfExamples);
+
+    for  (row = 0;  row < block->NumRows ();  ++row)
+    {
+      if  (!useRow[row])
+        continue;
+      const float*  rowData = block->Row (row);
+      for  (kkuint32 i = 0;  i < numOfFeatures;  ++i)
+      {
+        double  delta = double (rowData[i]) - mean[i];
+        sigmaTot[i] += delta * delta;
+      }
+    }
+
+    for  (kkuint32 i = 0;  i < numOfFeatures;  ++i)
+      sigma[i] = sqrt (sigmaTot[i] / numOfExamples);
+
+    delete[]  sigmaTot;  sigmaTot = NULL;
+    delete[]  total;     total    = NULL;
+
+    ConstructNormalizeFeatureVector ();
+    return;
+  }
+
   for  (imageIDX = _examples.begin ();  imageIDX != _examples.end ();  imageIDX++)
   {
     image = *imageIDX;
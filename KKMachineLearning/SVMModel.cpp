@@ -8,6 +8,7 @@
 #include <sstream>
 #include <iomanip>
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include "MemoryDebug.h"
 using namespace  std;
@@ -164,7 +165,10 @@ void  SVMModel::GreaterVotes (bool     useProbability,
 SVMModel::SVMModel ():
   assignments              (),
   binaryFeatureEncoders    (NULL),
+  binaryComboDistances     (),
+  binaryComboKValues       (),
   binaryParameters         (NULL),
+  callerCancelFlag         (NULL),
   cancelFlag               (false),
   cardinality_table        (),
   classIdxTable            (NULL),
@@ -172,7 +176,10 @@ SVMModel::SVMModel ():
   crossClassProbTableSize  (0),
   featureEncoder           (NULL),
   fileDesc                 (NULL),
+  kernelCacheHits          (0),
+  kernelCacheMisses        (0),
   models                   (NULL),
+  modelSharedSVGroup       (),
   numOfClasses             (0),
   numOfModels              (0),
   oneVsAllAssignment       (),
@@ -182,6 +189,8 @@ SVMModel::SVMModel ():
   probabilities            (NULL),
   rootFileName             (),
   selectedFeatures         (NULL),
+  sharedModel              (NULL),
+  sharedSVGroups           (),
   svmParam                 (NULL),
   trainingTime             (0.0),
   type_table               (),
@@ -199,12 +208,16 @@ SVMModel::SVMModel (const SVMparam&     _svmParam,      // Create new model from
                     FeatureVectorList&  _examples,      // Training data.
                     ClassAssignments&   _assignmnets,
                     FileDescConstPtr    _fileDesc,
+                    VolConstBool&       _cancelFlag,
                     RunLog&             _log
                    )
 :
   assignments              (_assignmnets),
   binaryFeatureEncoders    (NULL),
+  binaryComboDistances     (),
+  binaryComboKValues       (),
   binaryParameters         (NULL),
+  callerCancelFlag         (&_cancelFlag),
   cancelFlag               (false),
   cardinality_table        (),
   classIdxTable            (NULL),
@@ -212,7 +225,10 @@ SVMModel::SVMModel (const SVMparam&     _svmParam,      // Create new model from
   crossClassProbTableSize  (0),
   featureEncoder           (NULL),
   fileDesc                 (_fileDesc),
+  kernelCacheHits          (0),
+  kernelCacheMisses        (0),
   models                   (NULL),
+  modelSharedSVGroup       (),
   numOfClasses             (0),
   numOfModels              (0),
   oneVsAllAssignment       (),
@@ -222,6 +238,8 @@ SVMModel::SVMModel (const SVMparam&     _svmParam,      // Create new model from
   probabilities            (NULL),
   rootFileName             (),
   selectedFeatures         (NULL),
+  sharedModel              (NULL),
+  sharedSVGroups           (),
   svmParam                 (new SVMparam (_svmParam)),
   trainingTime             (0.0),
   type_table               (),
@@ -237,6 +255,7 @@ SVMModel::SVMModel (const SVMparam&     _svmParam,      // Create new model from
                     << "SVMModel  **** ERROR ****      NO EXAMPLES TO TRAIN WITH." << endl
                     << endl;
     validModel = false;
+    callerCancelFlag = NULL;
     return;
   }
 
@@ -283,8 +302,9 @@ SVMModel::SVMModel (const SVMparam&     _svmParam,      // Create new model from
     validModel = false;
   }
 
-  if  (cancelFlag)
+  if  (cancelFlag  ||  _cancelFlag)
     validModel = false;
+  callerCancelFlag = NULL;
 
   if  (!validModel)
     return;
@@ -295,8 +315,85 @@ SVMModel::SVMModel (const SVMparam&     _svmParam,      // Create new model from
 
 
 
+SVMModel::SVMModel (const SVMModel*  _sharedModel):
+  assignments              (_sharedModel->assignments),
+  binaryFeatureEncoders    (_sharedModel->binaryFeatureEncoders),
+  binaryComboDistances     (_sharedModel->numOfModels, 0.0),
+  binaryComboKValues       (_sharedModel->binaryComboKValues.size (), 0.0),
+  binaryParameters         (_sharedModel->binaryParameters),
+  callerCancelFlag         (NULL),
+  cancelFlag               (false),
+  cardinality_table        (_sharedModel->cardinality_table),
+  classIdxTable            (NULL),
+  crossClassProbTable      (NULL),
+  crossClassProbTableSize  (0),
+  featureEncoder           (_sharedModel->featureEncoder),
+  fileDesc                 (_sharedModel->fileDesc),
+  kernelCacheHits          (_sharedModel->kernelCacheHits),
+  kernelCacheMisses        (_sharedModel->kernelCacheMisses),
+  models                   (_sharedModel->models),
+  modelSharedSVGroup       (_sharedModel->modelSharedSVGroup),
+  numOfClasses             (_sharedModel->numOfClasses),
+  numOfModels              (_sharedModel->numOfModels),
+  oneVsAllAssignment       (_sharedModel->oneVsAllAssignment),
+  oneVsAllClassAssignments (_sharedModel->oneVsAllClassAssignments),
+  predictXSpace            (NULL),
+  predictXSpaceWorstCase   (_sharedModel->predictXSpaceWorstCase),
+  probabilities            (NULL),
+  rootFileName             (_sharedModel->rootFileName),
+  selectedFeatures         (_sharedModel->selectedFeatures),
+  sharedModel              (_sharedModel),
+  sharedSVGroups           (),
+  svmParam                 (_sharedModel->svmParam),
+  trainingTime             (_sharedModel->trainingTime),
+  type_table               (_sharedModel->type_table),
+  validModel               (_sharedModel->validModel),
+  votes                    (NULL),
+  xSpaces                  (_sharedModel->xSpaces),
+  xSpacesTotalAllocated    (_sharedModel->xSpacesTotalAllocated)
+{
+  BuildClassIdxTable ();
+  BuildCrossClassProbTable ();
+  if  (predictXSpaceWorstCase > 0)
+    predictXSpace = new svm_node[predictXSpaceWorstCase];
+}
+
+
+
+SVMModel*  SVMModel::ShareForPrediction ()  const
+{
+  if  ((!validModel)  ||  (svmParam == NULL)  ||  (models == NULL))
+    return  NULL;
+
+  // The source of a shared instance is the only one that owns the trained parts.
+  if  (sharedModel)
+    return  sharedModel->ShareForPrediction ();
+
+  // 'ProbClassPairs' is filled in on first use;  do it now rather than from several threads at once.
+  if  (svmParam->ProbClassPairs ().size () < 1)
+    svmParam->ProbClassPairsInitialize (assignments);
+
+  return  new SVMModel (this);
+}  /* ShareForPrediction */
+
+
+
 SVMModel::~SVMModel ()
 {
+  if  (sharedModel)
+  {
+    // These belong to 'sharedModel'.
+    binaryFeatureEncoders    = NULL;
+    binaryParameters         = NULL;
+    featureEncoder           = NULL;
+    models                   = NULL;
+    oneVsAllClassAssignments = NULL;
+    selectedFeatures         = NULL;
+    svmParam                 = NULL;
+    xSpaces                  = NULL;
+    sharedModel              = NULL;
+  }
+
   DeleteModels ();
   DeleteXSpaces ();
 
@@ -360,6 +457,10 @@ SVMModel::~SVMModel ()
 
 void  SVMModel::DeleteModels ()
 {
+  // They point into the models.
+  sharedSVGroups.clear ();
+  modelSharedSVGroup.clear ();
+
   if  (models)
   {
     for  (kkuint32  x = 0;  x < numOfModels;  x++)
@@ -753,6 +854,20 @@ double   SVMModel::DistanceFromDecisionBoundary (FeatureVectorPtr  example,
 
 
 
+void  SVMModel::BinaryComboDistances (FeatureVectorPtr  example,
+                                     VectorDouble&     distances
+                                    )
+{
+  distances.clear ();
+  if  ((svmParam->MachineType () != SVM_MachineType::BinaryCombos)  ||  (!models))
+    return;
+
+  PredictBinaryComboDistances (example);
+  distances = binaryComboDistances;
+}  /* BinaryComboDistances */
+
+
+
 void  SVMModel::InializeProbClassPairs ()
 {
   if  (svmParam->ProbClassPairs ().size () < 1)
@@ -1172,6 +1287,8 @@ void  SVMModel::PredictByBinaryCombos (FeatureVectorPtr  example,
     probabilities[x] = 1.0f;
   }
 
+  PredictBinaryComboDistances (example);
+
   for  (kkuint32  class1IDX = 0;  class1IDX < (numOfClasses - 1);  class1IDX++)
   {
     MLClassPtr  class1  = classIdxTable [class1IDX];
@@ -1183,21 +1300,7 @@ void  SVMModel::PredictByBinaryCombos (FeatureVectorPtr  example,
     {
       BinaryClassParmsPtr  thisComboPrameters = binaryParameters[modelIDX];
 
-      kkint32  xSpaceUsed;
-
-      if  (binaryFeatureEncoders[modelIDX] == NULL)
-      {
-        KKStr  errMsg;
-        errMsg << "SVMModel::PredictByBinaryCombos   ***ERROR***   No feature encoder for model[" << modelIDX << "]";
-        cerr << endl << errMsg << endl << endl;
-        throw KKException (errMsg);
-      }
-
-      binaryFeatureEncoders[modelIDX]->EncodeAExample (example, predictXSpace, xSpaceUsed);
-
-      double  distance = 0.0;
-
-      svm_predictTwoClasses (models[modelIDX][0], predictXSpace, distance, -1);
+      double  distance = binaryComboDistances[modelIDX];
       probability = (1.0 / (1.0 + exp (-1.0 * (thisComboPrameters->Param ().A) * distance)));
       probability = AdjProb (probability);  // KAK 2011-06-10
 
@@ -1334,7 +1437,6 @@ void  SVMModel::ProbabilitiesByClass (FeatureVectorPtr    example,
 
   double   breakTie                = 0.0f;
 
-  MLClassPtr  predictedClass  = NULL;
   XSpacePtr   xSpace          = NULL;
 
   xSpace = featureEncoder->EncodeAExample (example);
@@ -1370,11 +1472,27 @@ void  SVMModel::ProbabilitiesByClass (FeatureVectorPtr    example,
                    breakTie
                   );
 
+  ProbabilitiesInCallersOrder (_mlClasses, _votes, _probabilities, _log);
+
+  delete  xSpace;  
+  xSpace = NULL;
+
+  return;
+}  /* ProbabilitiesByClass */
+
+
+
+void  SVMModel::ProbabilitiesInCallersOrder (const MLClassList&  _mlClasses,
+                                             kkint32*            _votes,
+                                             double*             _probabilities,
+                                             RunLog&             _log
+                                            )
+{
   // We have  to do it this way, so that we pass back the probabilities in the 
   // same order that the user indicated with mlClasses being passed in.
   for  (kkuint32  x = 0;  x < numOfClasses;  x++)
   {
-    predictedClass = assignments.GetMLClass ((kkint16)x);
+    MLClassPtr  predictedClass = assignments.GetMLClass ((kkint16)x);
     if  (predictedClass)
     {
       auto y = _mlClasses.PtrToIdx (predictedClass);
@@ -1393,11 +1511,106 @@ void  SVMModel::ProbabilitiesByClass (FeatureVectorPtr    example,
       }
     }
   }
+}  /* ProbabilitiesInCallersOrder */
 
-  delete  xSpace;  
-  xSpace = NULL;
 
-  return;
+
+void  SVMModel::ProbabilitiesByClass (FeatureVectorList&  examples,
+                                      const MLClassList&  _mlClasses,
+                                      kkint32*            _votes,
+                                      double*             _probabilities,
+                                      RunLog&             _log
+                                     )
+{
+  kkuint32  numExamples = examples.QueueSize ();
+  kkMemSize  rowWidth = _mlClasses.QueueSize ();
+  if  (numExamples < 1)
+    return;
+
+  InializeProbClassPairs ();
+
+  if  (svmParam->MachineType () == SVM_MachineType::BinaryCombos)
+  {
+    VectorDouble  blockDistances;
+    PredictBinaryComboDistances (examples, blockDistances);
+    for  (kkuint32 e = 0;  e < numExamples;  ++e)
+    {
+      ProbabilitiesFromBinaryComboDistances (blockDistances.data () + (kkMemSize)e * numOfModels, _mlClasses,
+                                             _votes + e * rowWidth, _probabilities + e * rowWidth, _log
+                                            );
+    }
+    return;
+  }
+
+  const SvmModel233*    model = models[0][0];
+  const svm_parameter&  param = model->param;
+  if  ((param.dimSelect > 0)  ||  ((param.svm_type != C_SVC)  &&  (param.svm_type != NU_SVC)))
+  {
+    for  (kkuint32 e = 0;  e < numExamples;  ++e)
+      ProbabilitiesByClass (examples.IdxToPtr (e), _mlClasses, _votes + e * rowWidth, _probabilities + e * rowWidth, _log);
+    return;
+  }
+
+  // Each example is encoded into its own slice of 'xSpace' so that the kernel can be evaluated for all of them at once.
+  kkMemSize  xSpacePerExample = featureEncoder->XSpaceNeededPerExample ();
+  vector<svm_node>         xSpace (numExamples * xSpacePerExample);
+  vector<const svm_node*>  xs (numExamples, NULL);
+  kkint32  xSpaceUsed = 0;
+  for  (kkuint32 e = 0;  e < numExamples;  ++e)
+  {
+    svm_node*  row = xSpace.data () + e * xSpacePerExample;
+    featureEncoder->EncodeAExample (examples.IdxToPtr (e), row, xSpaceUsed);
+    xs[e] = row;
+  }
+
+  const PackedDoubleVectors&  svs = model->PackedSVs ();
+  kkMemSize  numSVs = svs.NumRows ();
+  VectorDouble  kvalues (numExamples * numSVs);
+  svm_kernelValuesBlock (param, xs.data (), (kkint32)numExamples, svs, kvalues.data ());
+
+  vector<kkint32>  winners;
+  for  (kkuint32 e = 0;  e < numExamples;  ++e)
+  {
+    kkint32*  exampleVotes         = _votes         + e * rowWidth;
+    double*   exampleProbabilities = _probabilities + e * rowWidth;
+
+    kkint32  predClass1Votes   = -1;
+    kkint32  predClass2Votes   = -1;
+    double   predClass1Prob    = 0.0;
+    double   predClass2Prob    = 0.0;
+    double   probOfKnownClass  = 0.0;
+    double   breakTie          = 0.0f;
+    kkint32  knownClassNum     = 0;
+    kkint32  prediction        = 0;
+    kkint32  prediction2       = 0;
+
+    for  (kkuint32 x = 0;  x < numOfClasses;  x++)
+    {
+      probabilities       [x] = 0.0;
+      exampleProbabilities[x] = 0.0;
+      exampleVotes        [x] = 0;
+    }
+
+    SvmPredictClassFromKernel (*svmParam,
+                               models[0],
+                               kvalues.data () + e * numSVs,
+                               votes,
+                               probabilities, 
+                               knownClassNum, 
+                               prediction,
+                               prediction2,
+                               predClass1Votes,
+                               predClass2Votes,
+                               predClass1Prob,
+                               predClass2Prob,
+                               probOfKnownClass,
+                               winners,
+                               crossClassProbTable,
+                               breakTie
+                              );
+
+    ProbabilitiesInCallersOrder (_mlClasses, exampleVotes, exampleProbabilities, _log);
+  }
 }  /* ProbabilitiesByClass */
 
 
@@ -1411,6 +1624,19 @@ void  SVMModel::PredictProbabilitiesByBinaryCombos (FeatureVectorPtr    example,
 {
   InializeProbClassPairs ();
 
+  PredictBinaryComboDistances (example);
+  ProbabilitiesFromBinaryComboDistances (binaryComboDistances.data (), _mlClasses, _votes, _probabilities, _log);
+}  /* PredictProbabilitiesByBinaryCombos */
+
+
+
+void  SVMModel::ProbabilitiesFromBinaryComboDistances (const double*       distances,
+                                                       const MLClassList&  _mlClasses,
+                                                       kkint32*            _votes,
+                                                       double*             _probabilities,
+                                                       RunLog&             _log
+                                                      )
+{
   double  probability = -1.0;
 
   kkuint32 modelIDX = 0;
@@ -1425,13 +1651,12 @@ void  SVMModel::PredictProbabilitiesByBinaryCombos (FeatureVectorPtr    example,
   if  (numOfClasses != crossClassProbTableSize)
   {
     _log.Level (-1) << endl << endl 
-                   << "SVMModel::PredictProbabilitiesByBinaryCombos                     ***ERROR***" << endl
+                   << "SVMModel::ProbabilitiesFromBinaryComboDistances                  ***ERROR***" << endl
                    << "                      numfClasses != crossClassProbTableSize"                 << endl       
                    << endl;
     return;
   }
 
-
   for  (kkuint32  class1IDX = 0;  class1IDX < (numOfClasses - 1);  class1IDX++)
   {
 
@@ -1439,20 +1664,7 @@ void  SVMModel::PredictProbabilitiesByBinaryCombos (FeatureVectorPtr    example,
     {
       BinaryClassParmsPtr  thisComboPrameters = binaryParameters[modelIDX];
 
-      if  (binaryFeatureEncoders[modelIDX] == NULL)
-      {
-        KKStr  errMsg;
-        errMsg << "SVMModel::PredictProbabilitiesByBinaryCombos   ***ERROR***   No feature encoder for model[" << modelIDX << "]";
-        _log.Level (-1) << endl << endl << errMsg << endl << endl;
-        throw KKException (errMsg);
-      }
-
-      kkint32  xSpaceUsed;
-      binaryFeatureEncoders[modelIDX]->EncodeAExample (example, predictXSpace, xSpaceUsed);
-
-      double  distance = 0.0;
-
-      svm_predictTwoClasses (models[modelIDX][0], predictXSpace, distance, -1);
+      double  distance = distances[modelIDX];
       probability = (1.0 / (1.0 + exp (-1.0 * (thisComboPrameters->Param ().A) * distance)));
       probability = AdjProb (probability);  // KAK 2011-06-10
 
@@ -1497,7 +1709,7 @@ void  SVMModel::PredictProbabilitiesByBinaryCombos (FeatureVectorPtr    example,
         // For what ever reason the MLClass instance in '_mlClasses' provided by caller
         // is not one of the classes that this model was built for.
         _log.Level (-1) << endl 
-          << "SVMModel::PredictProbabilitiesByBinaryCombos   ***WARNING***    MLClass[" << (*idx)->Name () << "] is not one of the classes in SVMModel."  << endl
+          << "SVMModel::ProbabilitiesFromBinaryComboDistances   ***WARNING***    MLClass[" << (*idx)->Name () << "] is not one of the classes in SVMModel."  << endl
           << endl;
         _votes        [callersIdx] = 0;
         _probabilities[callersIdx] = 0.0;
@@ -1512,7 +1724,7 @@ void  SVMModel::PredictProbabilitiesByBinaryCombos (FeatureVectorPtr    example,
   }
 
   return;
-}  /* PredictByBinaryCombos */
+}  /* ProbabilitiesFromBinaryComboDistances */
 
 
 
@@ -1923,11 +2135,26 @@ void SVMModel::ConstructOneVsOneModel (FeatureVectorListPtr  examples,
 
   //**** End of new compression replacement code.
   // train the model using the svm_problem built above
-  double  startTrainingTime = osGetSystemTimeUsed ();
-  models[0] = SvmTrainModel (svmParam->Param (), prob);
-  double  endTrainingTime = osGetSystemTimeUsed ();
+  // All the binary classifiers are built from the same encoded examples and kernel so they can share one cache.
+  SharedKernelCachePtr  kernelCache = NULL;
+  if  ((svmParam->KernelCacheMB () > 0)  &&  (numOfClasses > 2)  &&  (svmParam->Param ().dimSelect <= 0))
+    kernelCache = new SharedKernelCache (prob.l, svmParam->KernelCacheMB ());
+
+  double  startTrainingTime = osGetElapsedSecs ();
+  models[0] = SvmTrainModel (svmParam->Param (), prob, svmParam->NumThreads (), svmParam->TrainingMemoryMB (), kernelCache, NULL, callerCancelFlag);
+  double  endTrainingTime = osGetElapsedSecs ();
   trainingTime = endTrainingTime - startTrainingTime;
 
+  if  (kernelCache)
+  {
+    kernelCacheHits   = kernelCache->Hits   ();
+    kernelCacheMisses = kernelCache->Misses ();
+    log.Level (20) << "SVMModel::ConstructOneVsOneModel   KernelCache  Hits: " << kernelCacheHits << "  Misses: " << kernelCacheMisses
+                   << "  Evictions: " << kernelCache->Evictions () << endl;
+    delete  kernelCache;
+    kernelCache = NULL;
+  }
+
   // free the memory for the svm_problem
   delete[] prob.index;  prob.index = NULL;
   free (prob.y);        prob.y = NULL;
@@ -1983,7 +2210,7 @@ void SVMModel::ConstructOneVsAllModel (FeatureVectorListPtr examples,
   }
 
   // build the models
-  for (kkuint32 assignmentIDX = 0;  assignmentIDX < numOfModels;  ++assignmentIDX)
+  for (kkuint32 assignmentIDX = 0;  (assignmentIDX < numOfModels)  &&  (!(*callerCancelFlag));  ++assignmentIDX)
   {
     auto  assignmentNum = assignmentNums[assignmentIDX];
     oneVsAllAssignment.push_back (assignmentNum);
@@ -2001,9 +2228,9 @@ void SVMModel::ConstructOneVsAllModel (FeatureVectorListPtr examples,
 
     // train the model using the svm_problem built above
 
-    double  trainTimeStart = osGetSystemTimeUsed ();
-    models[modelIDX] = SvmTrainModel (svmParam->Param (), prob);
-    double  trainTimeEnd   = osGetSystemTimeUsed ();
+    double  trainTimeStart = osGetElapsedSecs ();
+    models[modelIDX] = SvmTrainModel (svmParam->Param (), prob, 1, 0, NULL, NULL, callerCancelFlag);
+    double  trainTimeEnd   = osGetElapsedSecs ();
     trainingTime += (trainTimeEnd - trainTimeStart);
 
     // free the memory for the svm_problem
@@ -2054,20 +2281,24 @@ void SVMModel::ConstructBinaryCombosModel (FeatureVectorListPtr  examples,
   // NOTE: compression is performed in the BuildProblemBinaryCombos() function since
   // we can do the compression on just the example for those two classes - KNS
 
-  // build a model for each possible 2-class combination
-  for (kkuint32 class1IDX = 0;  (class1IDX < (numOfClasses - 1))  &&  (!cancelFlag);  class1IDX++)
+  // The problems for every 2-class combination are built first, in order, since building them updates shared
+  // parameters;  the models are then trained by 'svm_train_scheduled' which may run several at the same time.
+  vector<svm_problem>  probs (numOfModels);
+  vector<kkint32>      probSizes;
+  vector<kkuint32>     probClass1 (numOfModels, 0);
+  vector<kkuint32>     probClass2 (numOfModels, 0);
+  vector<FeatureNumListConstPtr>  probFeatures (numOfModels, NULL);
+
+  for (kkuint32 class1IDX = 0;  (class1IDX < (numOfClasses - 1))  &&  (!(*callerCancelFlag));  class1IDX++)
   {
     MLClassPtr  class1 = assignments.GetMLClassByIndex (class1IDX);
 
-    for  (kkuint32 class2IDX = class1IDX + 1;   (class2IDX < numOfClasses)   &&  (!cancelFlag);   class2IDX++)
+    for  (kkuint32 class2IDX = class1IDX + 1;   (class2IDX < numOfClasses)   &&  (!(*callerCancelFlag));   class2IDX++)
     {
       MLClassPtr  class2 = assignments.GetMLClassByIndex (class2IDX);
 
       log.Level (20) << "ConstructBinaryCombosModel  Class1[" << class1->Name () << "]  Class2[" << class2->Name () << "]" << endl;
 
-      struct svm_problem  prob;
-      //memset (&prob, 0, sizeof(svm_problem));  kak
-
       binaryParameters      [modelIDX] = NULL;
       binaryFeatureEncoders [modelIDX] = NULL;
       xSpaces               [modelIDX] = NULL;
@@ -2077,7 +2308,7 @@ void SVMModel::ConstructBinaryCombosModel (FeatureVectorListPtr  examples,
                                 examplesByClass[class2IDX],
                                 binaryParameters      [modelIDX],
                                 binaryFeatureEncoders [modelIDX],
-                                prob, 
+                                probs                 [modelIDX], 
                                 xSpaces               [modelIDX], 
                                 class1, 
                                 class2, 
@@ -2085,23 +2316,59 @@ void SVMModel::ConstructBinaryCombosModel (FeatureVectorListPtr  examples,
                                );
 
       maxXSpaceNeededPerExample = Max (maxXSpaceNeededPerExample, binaryFeatureEncoders [modelIDX]->XSpaceNeededPerExample ());
-
-      // train the model
-      double  startTrainingTime = osGetSystemTimeUsed ();
-      models[modelIDX] = SvmTrainModel (binaryParameters[modelIDX]->Param (), prob);
-      double  endTrainingTime = osGetSystemTimeUsed ();
-      trainingTime += (endTrainingTime - startTrainingTime);
-
-      // free the memory for the svm_problem
-      delete  [] prob.index;  prob.index = NULL;
-      free (prob.y);      prob.y     = NULL;
-      free (prob.x);      prob.x     = NULL;
-      delete[] prob.W;
+      probSizes.push_back (probs[modelIDX].l);
+      probClass1[modelIDX]   = class1IDX;
+      probClass2[modelIDX]   = class2IDX;
+      probFeatures[modelIDX] = svmParam->GetFeatureNums (fileDesc, class1, class2);
 
       modelIDX++;   
     }
   }
 
+  vector<SharedKernelCachePtr>  probKernelCaches (modelIDX, NULL);
+  vector<VectorInt32>           probCacheKeys    (modelIDX);
+  if  (svmParam->KernelCacheMB () > 0)
+    BuildSharedKernelCaches (examplesByClass, modelIDX, probClass1, probClass2, probFeatures, probKernelCaches, probCacheKeys);
+
+  // train the models
+  double  startTrainingTime = osGetElapsedSecs ();
+  svm_train_scheduled (probSizes, svmParam->Param ().cache_size, svmParam->NumThreads (), svmParam->TrainingMemoryMB (), callerCancelFlag,
+                       [&](kkint32 idx)
+                       {
+                         models[idx] = SvmTrainModel (binaryParameters[idx]->Param (), probs[idx], 1, 0,
+                                                      probKernelCaches[idx],
+                                                      probKernelCaches[idx] ? &(probCacheKeys[idx][0]) : NULL
+                                                     );
+                       }
+                      );
+  double  endTrainingTime = osGetElapsedSecs ();
+  trainingTime += (endTrainingTime - startTrainingTime);
+
+  {
+    // Several problems point to the same cache;  each one is only counted and deleted once.
+    set<SharedKernelCachePtr>  kernelCaches (probKernelCaches.begin (), probKernelCaches.end ());
+    kernelCaches.erase (NULL);
+    for  (auto kernelCache: kernelCaches)
+    {
+      kernelCacheHits   += kernelCache->Hits   ();
+      kernelCacheMisses += kernelCache->Misses ();
+      log.Level (20) << "SVMModel::ConstructBinaryCombosModel   KernelCache  Hits: " << kernelCache->Hits () << "  Misses: " << kernelCache->Misses ()
+                     << "  Evictions: " << kernelCache->Evictions () << endl;
+      delete  kernelCache;
+    }
+    probKernelCaches.clear ();
+  }
+
+  // free the memory for the svm_problems
+  for  (kkuint32 x = 0;  x < modelIDX;  ++x)
+  {
+    svm_problem&  prob = probs[x];
+    delete  [] prob.index;  prob.index = NULL;
+    free (prob.y);      prob.y     = NULL;
+    free (prob.x);      prob.x     = NULL;
+    delete[] prob.W;    prob.W     = NULL;
+  }
+
   {
     for  (kkint32 x = 0;  x < (kkint32)assignments.size ();  x++)
       delete  examplesByClass[x];
@@ -2123,11 +2390,320 @@ void SVMModel::ConstructBinaryCombosModel (FeatureVectorListPtr  examples,
 
   delete  compressedExamples;
 
+  BuildSharedSupportVectors ();
+
   log.Level (10) << "SVMModel::ConstructBinaryCombosModel  Done." << endl;
 }  /* ConstructBinaryCombosModel */
 
 
 
+/** @brief  True when two models compute the same kernel between the same pair of encoded examples. */
+static  bool  SameKernel (const svm_parameter&  left,
+                          const svm_parameter&  right
+                         )
+{
+  return  (left.svm_type    == right.svm_type)      &&
+          (left.kernel_type == right.kernel_type)   &&
+          (left.dimSelect   == right.dimSelect)     &&
+          (left.degree      == right.degree)        &&
+          (left.gamma       == right.gamma)         &&
+          (left.coef0       == right.coef0);
+}  /* SameKernel */
+
+
+
+void  SVMModel::BuildSharedKernelCaches (FeatureVectorListPtr*                  examplesByClass,
+                                         kkuint32                               numProbs,
+                                         const vector<kkuint32>&                probClass1,
+                                         const vector<kkuint32>&                probClass2,
+                                         const vector<FeatureNumListConstPtr>&  probFeatures,
+                                         vector<SharedKernelCachePtr>&          probKernelCaches,
+                                         vector<VectorInt32>&                   probCacheKeys
+                                        )
+{
+  // Every example gets a key from its position in 'examplesByClass';  'BuildProblemBinaryCombos' encodes the
+  // examples of the first class followed by those of the second so the keys of a problem follow the same order.
+  VectorInt32  classFirstKey (numOfClasses, 0);
+  kkint32  numKeys = 0;
+  for  (kkuint32 x = 0;  x < numOfClasses;  ++x)
+  {
+    classFirstKey[x] = numKeys;
+    numKeys += examplesByClass[x]->QueueSize ();
+  }
+
+  // Problems can only share kernel values when they encode the same features and use the same kernel.
+  vector<VectorInt32>  groups;
+  for  (kkuint32 idx = 0;  idx < numProbs;  ++idx)
+  {
+    const svm_parameter&  param = binaryParameters[idx]->Param ();
+    if  ((param.svm_type != C_SVC)  ||  (param.dimSelect > 0))
+      continue;
+
+    auto  sameKernel = [&](kkint32 other) -> bool
+      {
+        return  (*probFeatures[other] == *probFeatures[idx])  &&  SameKernel (binaryParameters[other]->Param (), param);
+      };
+
+    auto  group = groups.begin ();
+    while  ((group != groups.end ())  &&  (!sameKernel ((*group)[0])))
+      ++group;
+    if  (group == groups.end ())
+      groups.push_back (VectorInt32 (1, idx));
+    else
+      group->push_back (idx);
+  }
+
+  // A problem on its own gains nothing;  the memory is split between the groups that share.
+  kkuint32  numSharingGroups = 0;
+  for  (auto& group: groups)
+  {
+    if  (group.size () > 1)
+      ++numSharingGroups;
+  }
+
+  for  (auto& group: groups)
+  {
+    if  (group.size () < 2)
+      continue;
+
+    SharedKernelCachePtr  kernelCache = new SharedKernelCache (numKeys, (double)svmParam->KernelCacheMB () / (double)numSharingGroups);
+    for  (auto idx: group)
+    {
+      VectorInt32&  keys = probCacheKeys[idx];
+      keys.clear ();
+      for  (auto classIdx: {probClass1[idx], probClass2[idx]})
+      {
+        kkint32  count = examplesByClass[classIdx]->QueueSize ();
+        for  (kkint32 x = 0;  x < count;  ++x)
+          keys.push_back (classFirstKey[classIdx] + x);
+      }
+      probKernelCaches[idx] = kernelCache;
+    }
+  }
+}  /* BuildSharedKernelCaches */
+
+
+
+/** @brief  Number of nodes in the sparse vector 'x' not counting the terminating node with index -1. */
+static  kkint32  SvmNodeCount (const svm_node*  x)
+{
+  kkint32  count = 0;
+  while  (x[count].index != -1)
+    ++count;
+  return  count;
+}
+
+
+
+void  SVMModel::BuildSharedSupportVectors ()
+{
+  sharedSVGroups.clear ();
+  modelSharedSVGroup.assign (numOfModels, -1);
+  binaryComboDistances.assign (numOfModels, 0.0);
+
+  if  ((!models)  ||  (!binaryParameters)  ||  (!binaryFeatureEncoders))
+    return;
+
+  // One table per group finds the support vectors already added;  keyed by a hash of their contents.
+  vector<unordered_multimap<size_t, kkint32>>  svsByHash;
+  vector<FeatureNumListConstPtr>               groupFeatures;
+
+  kkuint32  maxGroupSVs = 0;
+
+  for  (kkuint32 modelIdx = 0;  modelIdx < numOfModels;  ++modelIdx)
+  {
+    const SvmModel233*  model = models[modelIdx] ? models[modelIdx][0] : NULL;
+    if  ((!model)  ||  (!binaryParameters[modelIdx])  ||  (!binaryFeatureEncoders[modelIdx]))
+      continue;
+
+    const svm_parameter&  param = model->param;
+    if  (((param.svm_type != C_SVC)  &&  (param.svm_type != NU_SVC))  ||  (param.dimSelect > 0)  ||  (model->nr_class != 2))
+      continue;
+
+    FeatureNumListConstPtr  features = svmParam->GetFeatureNums (fileDesc, binaryParameters[modelIdx]->Class1 (), binaryParameters[modelIdx]->Class2 ());
+
+    kkuint32  groupIdx = 0;
+    while  (groupIdx < sharedSVGroups.size ())
+    {
+      if  (SameKernel (*(sharedSVGroups[groupIdx].param), param)  &&  (*(groupFeatures[groupIdx]) == *features))
+        break;
+      ++groupIdx;
+    }
+
+    if  (groupIdx >= sharedSVGroups.size ())
+    {
+      sharedSVGroups.push_back (SharedSVGroup ());
+      sharedSVGroups.back ().encoder = binaryFeatureEncoders[modelIdx];
+      sharedSVGroups.back ().param   = &(model->param);
+      svsByHash.push_back (unordered_multimap<size_t, kkint32> ());
+      groupFeatures.push_back (features);
+    }
+
+    SharedSVGroup&  group = sharedSVGroups[groupIdx];
+    auto&  groupSVsByHash = svsByHash[groupIdx];
+
+    group.modelIdxs.push_back (modelIdx);
+    group.svKeys.push_back (VectorInt32 (model->l, 0));
+    VectorInt32&  keys = group.svKeys.back ();
+
+    for  (kkint32 svIdx = 0;  svIdx < model->l;  ++svIdx)
+    {
+      const svm_node*  sv = model->SV[svIdx];
+      kkint32  svLen = SvmNodeCount (sv);
+
+      size_t  hash = (size_t)svLen;
+      for  (kkint32 x = 0;  x < svLen;  ++x)
+      {
+        hash = hash * 31 + std::hash<kkint32> () (sv[x].index);
+        hash = hash * 31 + std::hash<double>  () (sv[x].value);
+      }
+
+      kkint32  key = -1;
+      auto  range = groupSVsByHash.equal_range (hash);
+      for  (auto idx = range.first;  (idx != range.second)  &&  (key < 0);  ++idx)
+      {
+        const svm_node*  other = group.svs[idx->second];
+        kkint32  x = 0;
+        while  ((x < svLen)  &&  (other[x].index == sv[x].index)  &&  (other[x].value == sv[x].value))
+          ++x;
+        if  ((x == svLen)  &&  (other[x].index == -1))
+          key = idx->second;
+      }
+
+      if  (key < 0)
+      {
+        key = (kkint32)group.svs.size ();
+        group.svs.push_back (sv);
+        groupSVsByHash.insert (pair<size_t, kkint32> (hash, key));
+      }
+      keys[svIdx] = key;
+    }
+
+    modelSharedSVGroup[modelIdx] = (kkint32)groupIdx;
+    maxGroupSVs = Max (maxGroupSVs, (kkuint32)group.svs.size ());
+  }
+
+  for  (auto&  group: sharedSVGroups)
+  {
+    group.packedSVs.reset (svm_PackNodes (group.svs.data (), (kkint32)group.svs.size ()));
+
+    // So that 'svm_predictTwoClasses' adds up each RBF distance in the same order as the shared kernel values.
+    for  (auto  modelIdx: group.modelIdxs)
+      models[modelIdx][0]->PackedSVsMinNumCols (group.packedSVs->NumCols ());
+  }
+
+  binaryComboKValues.assign (maxGroupSVs, 0.0);
+}  /* BuildSharedSupportVectors */
+
+
+
+void  SVMModel::PredictBinaryComboDistances (FeatureVectorPtr  example)
+{
+  if  ((!sharedModel)  &&  (modelSharedSVGroup.size () != numOfModels))
+    BuildSharedSupportVectors ();
+
+  const vector<SharedSVGroup>&  groups = sharedModel ? sharedModel->sharedSVGroups : sharedSVGroups;
+
+  kkint32  xSpaceUsed = 0;
+
+  for  (auto&  group: groups)
+  {
+    group.encoder->EncodeAExample (example, predictXSpace, xSpaceUsed);
+    svm_kernelValues (*(group.param), predictXSpace, *(group.packedSVs), binaryComboKValues.data ());
+
+    for  (kkuint32 x = 0;  x < group.modelIdxs.size ();  ++x)
+    {
+      kkuint32  modelIdx = group.modelIdxs[x];
+      svm_predictTwoClassesFromKernel (models[modelIdx][0], binaryComboKValues.data (), group.svKeys[x].data (), binaryComboDistances[modelIdx]);
+    }
+  }
+
+  // Models that can not share kernel values with any other.
+  for  (kkuint32 modelIdx = 0;  modelIdx < numOfModels;  ++modelIdx)
+  {
+    if  (modelSharedSVGroup[modelIdx] >= 0)
+      continue;
+
+    if  (binaryFeatureEncoders[modelIdx] == NULL)
+    {
+      KKStr  errMsg;
+      errMsg << "SVMModel::PredictBinaryComboDistances   ***ERROR***   No feature encoder for model[" << modelIdx << "]";
+      cerr << endl << errMsg << endl << endl;
+      throw KKException (errMsg);
+    }
+
+    binaryFeatureEncoders[modelIdx]->EncodeAExample (example, predictXSpace, xSpaceUsed);
+    svm_predictTwoClasses (models[modelIdx][0], predictXSpace, binaryComboDistances[modelIdx], -1);
+  }
+}  /* PredictBinaryComboDistances */
+
+
+
+void  SVMModel::PredictBinaryComboDistances (FeatureVectorList&  examples,
+                                             VectorDouble&       blockDistances
+                                            )
+{
+  if  ((!sharedModel)  &&  (modelSharedSVGroup.size () != numOfModels))
+    BuildSharedSupportVectors ();
+
+  const vector<SharedSVGroup>&  groups = sharedModel ? sharedModel->sharedSVGroups : sharedSVGroups;
+
+  kkMemSize  numExamples = examples.QueueSize ();
+  blockDistances.assign (numExamples * numOfModels, 0.0);
+
+  vector<svm_node>         xSpace (numExamples * predictXSpaceWorstCase);
+  vector<const svm_node*>  xs (numExamples, NULL);
+  VectorDouble             kvalues;
+  kkint32  xSpaceUsed = 0;
+
+  for  (auto&  group: groups)
+  {
+    for  (kkMemSize e = 0;  e < numExamples;  ++e)
+    {
+      svm_node*  row = xSpace.data () + e * predictXSpaceWorstCase;
+      group.encoder->EncodeAExample (examples.IdxToPtr ((kkuint32)e), row, xSpaceUsed);
+      xs[e] = row;
+    }
+
+    kkMemSize  numSVs = group.packedSVs->NumRows ();
+    kvalues.resize (numExamples * numSVs);
+    svm_kernelValuesBlock (*(group.param), xs.data (), (kkint32)numExamples, *(group.packedSVs), kvalues.data ());
+
+    for  (kkMemSize e = 0;  e < numExamples;  ++e)
+    {
+      double*  distances = blockDistances.data () + e * numOfModels;
+      for  (kkuint32 x = 0;  x < group.modelIdxs.size ();  ++x)
+      {
+        kkuint32  modelIdx = group.modelIdxs[x];
+        svm_predictTwoClassesFromKernel (models[modelIdx][0], kvalues.data () + e * numSVs, group.svKeys[x].data (), distances[modelIdx]);
+      }
+    }
+  }
+
+  // Models that can not share kernel values with any other are predicted one example at a time.
+  for  (kkuint32 modelIdx = 0;  modelIdx < numOfModels;  ++modelIdx)
+  {
+    if  (modelSharedSVGroup[modelIdx] >= 0)
+      continue;
+
+    if  (binaryFeatureEncoders[modelIdx] == NULL)
+    {
+      KKStr  errMsg;
+      errMsg << "SVMModel::PredictBinaryComboDistances   ***ERROR***   No feature encoder for model[" << modelIdx << "]";
+      cerr << endl << errMsg << endl << endl;
+      throw KKException (errMsg);
+    }
+
+    for  (kkMemSize e = 0;  e < numExamples;  ++e)
+    {
+      binaryFeatureEncoders[modelIdx]->EncodeAExample (examples.IdxToPtr ((kkuint32)e), predictXSpace, xSpaceUsed);
+      svm_predictTwoClasses (models[modelIdx][0], predictXSpace, blockDistances[e * numOfModels + modelIdx], -1);
+    }
+  }
+}  /* PredictBinaryComboDistances */
+
+
+
 FeatureVectorListPtr*   SVMModel::BreakDownExamplesByClass (FeatureVectorListPtr  examples)
 {
   FeatureVectorListPtr* examplesByClass = new FeatureVectorListPtr[numOfClasses];
@@ -2574,6 +3150,9 @@ void  SVMModel::ReadXML (XmlStream&      s,
 
     CalculatePredictXSpaceNeeded (log);
 
+    if  (svmParam->MachineType () == SVM_MachineType::BinaryCombos)
+      BuildSharedSupportVectors ();
+
     if  ((svmParam->MachineType () ==  SVM_MachineType::OneVsOne)  ||  (svmParam->MachineType () == SVM_MachineType::OneVsAll))
     {
       delete  featureEncoder;
@@ -12,6 +12,7 @@
 //***********************************************************************
 
 
+#include <memory>
 #include "KKStr.h"
 #include "ClassAssignments.h"
 #include "FileDesc.h"
@@ -93,12 +94,14 @@ namespace KKMLL
      *            predictions are done by SVM it return a number, _assignments will 
      *            then be used to map back-to the correct class.
      *@param[in] _fileDesc  File-Description that describes the training data.
+     *@param[in] _cancelFlag  Monitored while training;  if it turns true training stops and the model will not be valid.
      *@param[out] _log Log file to log messages to.
      */
     SVMModel (const SVMparam&     _svmParam,
               FeatureVectorList&  _examples,
               ClassAssignments&   _assignments,
               FileDescConstPtr    _fileDesc,
+              VolConstBool&       _cancelFlag,
               RunLog&             _log
              );
 
@@ -108,6 +111,14 @@ namespace KKMLL
      */
     virtual ~SVMModel ();
 
+
+    /**
+     *@brief  Creates an instance that predicts with this model's trained classifiers on a different thread.
+     *@details  The SvmModel233's, encoders and parameters are shared, not copied;  the new instance gets its own
+     * encoded example, votes and probabilities.  This model must outlive it.  Returns NULL if this model is not valid.
+     */
+    SVMModel*  ShareForPrediction ()  const;
+
     virtual  void   CancelFlag (bool  _cancelFlag);
 
     FeatureNumListConstPtr   GetFeatureNums ()  const;
@@ -124,6 +135,12 @@ namespace KKMLL
 
     //kkint32              DuplicateDataCount () const {return duplicateCount;}
 
+    /** @brief  Kernel values found in the shared kernel cache during training;  see 'SVMparam::KernelCacheMB'. */
+    kkint64            KernelCacheHits         () const {return kernelCacheHits;}
+
+    /** @brief  Kernel values computed and added to the shared kernel cache during training. */
+    kkint64            KernelCacheMisses       () const {return kernelCacheMisses;}
+
     kkMemSize          MemoryConsumedEstimated ()  const;
 
     virtual
@@ -149,6 +166,16 @@ namespace KKMLL
     bool               ValidModel              () const {return validModel;}
 
 
+    /**
+     *@brief  Distance from the decision boundary of 'example' for every 2-class model of a BinaryCombos machine.
+     *@details  Models are in the order they were trained in,  class pairs (0,1), (0,2), ... (1,2), ... of 'Assignments'.
+     * Computed from the kernel values the models share;  each is exactly what 'DistanceFromDecisionBoundary'
+     * returns for the model's pair of classes.  Empty for other machine types.
+     */
+    void  BinaryComboDistances (FeatureVectorPtr  example,
+                                VectorDouble&     distances
+                               );
+
     double   DistanceFromDecisionBoundary (FeatureVectorPtr  example,
                                            MLClassPtr        class1,
                                            MLClassPtr        class2
@@ -216,6 +243,20 @@ namespace KKMLL
                                );
 
 
+    /**
+     *@brief  Block version of the one above;  example 'x' of 'examples' gets row 'x' of '_votes' and '_probabilities'.
+     *@details  Each row is '_mlClasses.QueueSize ()' wide.  The examples are encoded once and the kernel between all of
+     * them and each support vector is evaluated while that support vector is in cache;  see 'SVM233::svm_kernelValuesBlock'.
+     * The results are exactly the ones the single example version gives.
+     */
+    void  ProbabilitiesByClass (FeatureVectorList&  examples,
+                                const MLClassList&  _mlClasses,
+                                kkint32*            _votes,
+                                double*             _probabilities,
+                                RunLog&             _log
+                               );
+
+
 
     /**
      *@brief  For a given two class pair return the names of the 'numToFind' worst S/V's.
@@ -290,6 +331,10 @@ namespace KKMLL
   private:
     typedef  struct SvmModel233**   ModelPtr;
 
+    /** @brief  Used by 'ShareForPrediction';  shares the trained parts of '_sharedModel'. */
+    SVMModel (const SVMModel*  _sharedModel);
+
+
     FeatureVectorListPtr*   BreakDownExamplesByClass (FeatureVectorListPtr  examples);
 
 
@@ -361,6 +406,46 @@ namespace KKMLL
                                    );
 
 
+    /**
+     *@brief  Creates the kernel caches shared by the 2-class problems of 'ConstructBinaryCombosModel'.
+     *@details  Problems that encode the same features and use the same kernel share one cache, keyed by the
+     * position of each example in 'examplesByClass';  'SVMparam::KernelCacheMB' is split between the caches.
+     * Problems that share with no other are left with a NULL cache.
+     *@param[out] probKernelCaches  Cache of each problem;  one cache is shared by several problems.
+     *@param[out] probCacheKeys     Key of each example of each problem in its cache.
+     */
+    void  BuildSharedKernelCaches (FeatureVectorListPtr*                       examplesByClass,
+                                   kkuint32                                    numProbs,
+                                   const std::vector<kkuint32>&                probClass1,
+                                   const std::vector<kkuint32>&                probClass2,
+                                   const std::vector<FeatureNumListConstPtr>&  probFeatures,
+                                   std::vector<SharedKernelCachePtr>&          probKernelCaches,
+                                   std::vector<VectorInt32>&                   probCacheKeys
+                                  );
+
+
+    /**
+     *@brief  Groups the 2-class models of a BinaryCombos machine that can share kernel values at prediction time.
+     *@details  Models that encode the same features and use the same kernel are put in one 'SharedSVGroup';  support
+     * vectors with identical contents are kept once per group.  Called once the models are trained or loaded.
+     */
+    void  BuildSharedSupportVectors ();
+
+
+    /**
+     *@brief  Computes the distance from the decision boundary of 'example' for every 2-class model into 'binaryComboDistances'.
+     *@details  The example is encoded once per 'SharedSVGroup' and the kernel is evaluated once against each
+     * unique support vector of the group;  the distances are the same as calling 'svm_predictTwoClasses' per model.
+     */
+    void  PredictBinaryComboDistances (FeatureVectorPtr  example);
+
+
+    /** @brief  Block version of the one above;  the distances for 'examples[x]' go in row 'x' of 'blockDistances', 'numOfModels' wide. */
+    void  PredictBinaryComboDistances (FeatureVectorList&  examples,
+                                       VectorDouble&       blockDistances
+                                      );
+
+
     void  PredictProbabilitiesByBinaryCombos (FeatureVectorPtr    example,  
                                               const MLClassList&  _mlClasses,
                                               kkint32*            _votes,
@@ -368,6 +453,21 @@ namespace KKMLL
                                               RunLog&             _log
                                              );
 
+    /** @brief  Votes and probabilities of a BinaryCombos machine from the 'distances' of its 2-class models;  see 'PredictBinaryComboDistances'. */
+    void  ProbabilitiesFromBinaryComboDistances (const double*       distances,
+                                                 const MLClassList&  _mlClasses,
+                                                 kkint32*            _votes,
+                                                 double*             _probabilities,
+                                                 RunLog&             _log
+                                                );
+
+    /** @brief  Copies 'votes' and 'probabilities', which are in 'assignments' order, into the order of '_mlClasses'. */
+    void  ProbabilitiesInCallersOrder (const MLClassList&  _mlClasses,
+                                       kkint32*            _votes,
+                                       double*             _probabilities,
+                                       RunLog&             _log
+                                      );
+
 
 
     /**
@@ -380,6 +480,8 @@ namespace KKMLL
 
     /**
      *@brief Builds a BinaryCombo svm model
+     *@details  The binary classifiers are trained 'SVMparam::NumThreads' at a time within 'SVMparam::TrainingMemoryMB'
+     * of kernel cache, largest first;  the resulting model is the same as when they are trained one after another.
      *@param[in] examples The examples to use when training the new model
      */
     void ConstructBinaryCombosModel (FeatureVectorListPtr  examples,
@@ -480,13 +582,31 @@ namespace KKMLL
                                 );
 
 
+    /** @brief  2-class models of a BinaryCombos machine that share the kernel values of their support vectors. */
+    struct  SharedSVGroup
+    {
+      FeatureEncoderPtr              encoder;      /**< Encoder of the first model in the group;  not owned.        */
+      const svm_parameter*           param;        /**< Kernel parameters of the first model in the group.          */
+      std::vector<kkuint32>          modelIdxs;
+      std::vector<VectorInt32>       svKeys;       /**< Per model, the index in 'svs' of each of its support vectors. */
+      std::vector<const svm_node*>   svs;          /**< Unique support vectors;  point into the models' own.        */
+      std::shared_ptr<PackedDoubleVectors>  packedSVs;  /**< 'svs' packed for KernelEngine.                     */
+    };
+
+
     ClassAssignments       assignments;
 
     FeatureEncoderPtr*     binaryFeatureEncoders;
 
+    std::vector<double>    binaryComboDistances;  /**< Set by 'PredictBinaryComboDistances', indexed by model. */
+
+    std::vector<double>    binaryComboKValues;    /**< Kernel values of a 'SharedSVGroup', used by 'PredictBinaryComboDistances'. */
+
     BinaryClassParmsPtr*   binaryParameters;      /**< only used when doing Classification with diff Feature 
                                                    * Selection by 2 class combo's
                                                    */
+    VolConstBool*          callerCancelFlag;      /**< The '_cancelFlag' passed to the constructor;  only set while training. */
+
     volatile bool          cancelFlag;
 
     VectorInt32            cardinality_table;
@@ -505,8 +625,14 @@ namespace KKMLL
                                                    */
     FileDescConstPtr       fileDesc;
 
+    kkint64                kernelCacheHits;
+    kkint64                kernelCacheMisses;
+
     ModelPtr*              models;
 
+    VectorInt32            modelSharedSVGroup;    /**< Index in 'sharedSVGroups' of each model;  -1 = predicted on its own. */
+
+
     kkuint32               numOfClasses;          /**< Number of Classes defined in crossClassProbTable.  */
     kkuint32               numOfModels;
 
@@ -530,9 +656,15 @@ namespace KKMLL
 
     FeatureNumListPtr      selectedFeatures;
 
+    const SVMModel*        sharedModel;           /**< Set by 'ShareForPrediction';  the model that owns the trained parts this one
+                                                   * points to:  'models', 'xSpaces', the encoders, 'svmParam' and 'sharedSVGroups'.
+                                                   */
+
+    std::vector<SharedSVGroup>  sharedSVGroups;   /**< Empty in a shared instance;  the ones of 'sharedModel' are used. */
+
     SVMparamPtr            svmParam;
 
-    double                 trainingTime;
+    double                 trainingTime;          /**< Wall clock seconds spent in svm_train;  CPU time would count every training thread. */
 
     KKMLL::AttributeTypeVector  type_table;
 
@@ -33,11 +33,14 @@ SVMparam::SVMparam  (KKStr&                 _cmdLineStr,
   binaryParmsList           (NULL),
   encodingMethod            (SVM_EncodingMethod::NoEncoding),
   fileName                  (),
+  kernelCacheMB             (0),
+  numThreads                (1),
   param                     (),
   probClassPairs             (),
   samplingRate              (0.0f),
   selectedFeatures          (), 
   selectionMethod           (SVM_SelectionMethod::Voting),
+  trainingMemoryMB          (0),
   useProbabilityToBreakTies (false),
   validParam                (false)
 {
@@ -53,12 +56,15 @@ SVMparam::SVMparam  ():
   binaryParmsList           (NULL),
   encodingMethod            (SVM_EncodingMethod::NoEncoding),
   fileName                  (),
+  kernelCacheMB             (0),
   machineType               (SVM_MachineType::OneVsOne),
+  numThreads                (1),
   param                     (),
   probClassPairs            (),
   samplingRate              (0.0f),
   selectedFeatures          (NULL), 
   selectionMethod           (SVM_SelectionMethod::Voting),
+  trainingMemoryMB          (0),
   useProbabilityToBreakTies (false),
   validParam                (false)
 {
@@ -71,12 +77,15 @@ SVMparam::SVMparam  (const SVMparam&  _svmParam):
   binaryParmsList            (NULL),
   encodingMethod             (_svmParam.encodingMethod),
   fileName                   (_svmParam.fileName),
+  kernelCacheMB              (_svmParam.kernelCacheMB),
   machineType                (_svmParam.machineType),
+  numThreads                 (_svmParam.numThreads),
   param                      (_svmParam.param),
   probClassPairs             (_svmParam.probClassPairs),
   samplingRate               (_svmParam.samplingRate),
   selectedFeatures           (_svmParam.selectedFeatures),
   selectionMethod            (_svmParam.selectionMethod),
+  trainingMemoryMB           (_svmParam.trainingMemoryMB),
   useProbabilityToBreakTies  (_svmParam.useProbabilityToBreakTies),
   validParam                 (_svmParam.validParam)
 {
@@ -256,6 +265,21 @@ void  SVMparam::ParseCmdLineParameter (const KKStr&  parameter,
     useProbabilityToBreakTies = true;
   }
 
+  else if  ((field == "-THREADS")  ||  (field == "-NUMTHREADS"))
+  {
+    numThreads = (kkuint32)value.ToInt ();
+  }
+
+  else if  ((field == "-TM")  ||  (field == "-TRAININGMEMORY"))
+  {
+    trainingMemoryMB = (kkuint32)value.ToInt ();
+  }
+
+  else if  ((field == "-KC")  ||  (field == "-KERNELCACHE"))
+  {
+    kernelCacheMB = (kkuint32)value.ToInt ();
+  }
+
   else
   {
     parameterUsed = false;
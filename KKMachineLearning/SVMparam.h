@@ -146,12 +146,21 @@ namespace KKMLL
 
     double                   Gamma                      () const {return param.Gamma ();}
 
+    /**
+     *@brief  Megabytes of kernel values shared by the binary classifiers that use the same kernel and features;
+     *  0 = each binary classifier computes its own.
+     */
+    kkuint32                 KernelCacheMB              () const {return kernelCacheMB;}
+
     SVM_KernalType           KernalType                 () const {return (SVM_KernalType)param.KernalType ();}
 
     SVM_MachineType          MachineType                () const {return machineType;}
 
     kkMemSize                MemoryConsumedEstimated    () const;
 
+    /** @brief  Number of threads used to train the binary classifiers of a 'BinaryCombos' machine; 0 = one per processor. */
+    kkuint32                 NumThreads                 () const {return numThreads;}
+
     kkint32                  NumOfFeaturesAfterEncoding (FileDescConstPtr  fileDesc) const;
 
     const svm_parameter&     Param                      () const {return param;}
@@ -166,6 +175,12 @@ namespace KKMLL
 
     SVM_SelectionMethod      SelectionMethod            () const {return selectionMethod;}
 
+    /**
+     *@brief  Megabytes of kernel cache that binary classifiers being trained at the same time may use together;
+     *  0 = no limit other than 'NumThreads'.
+     */
+    kkuint32                 TrainingMemoryMB           () const {return trainingMemoryMB;}
+
     bool                     UseProbabilityToBreakTies  () const {return useProbabilityToBreakTies;}
 
 
@@ -181,8 +196,10 @@ namespace KKMLL
     void  Gamma              (double                  _gamma)              {param.Gamma (_gamma);}
     void  Gamma_Param        (double                  _gamma)              {Gamma (_gamma);}
     void  KernalType         (SVM_KernalType          _kernalType)         {param.KernalType ((int)_kernalType);}
+    void  KernelCacheMB      (kkuint32                _kernelCacheMB)      {kernelCacheMB      = _kernelCacheMB;}
 
     void  MachineType        (SVM_MachineType         _machineType)        {machineType        = _machineType;}
+    void  NumThreads         (kkuint32                _numThreads)         {numThreads         = _numThreads;}
     void  SamplingRate       (float                   _samplingRate)       {samplingRate       = _samplingRate;}
     void  SelectedFeatures   (FeatureNumListConst&    _selectedFeatures);
     void  SelectedFeatures   (FeatureNumListConstPtr  _selectedFeatures);
@@ -215,6 +232,8 @@ namespace KKMLL
 
     void  SelectionMethod   (SVM_SelectionMethod   _selectionMethod)  {selectionMethod  = _selectionMethod;}
 
+    void  TrainingMemoryMB  (kkuint32              _trainingMemoryMB) {trainingMemoryMB = _trainingMemoryMB;}
+
 
     // Other Methods
     KKStr  SvmParamToString (const  svm_parameter&  _param)  const;
@@ -260,8 +279,12 @@ namespace KKMLL
 
     KKStr                    fileName;
 
+    kkuint32                 kernelCacheMB;     /**< Like 'numThreads' not saved with the model. */
+
     SVM_MachineType          machineType;
 
+    kkuint32                 numThreads;        /**< Only affects how training is scheduled so it is not saved with the model. */
+
     svm_parameter            param;             // From SVMlib2
 
     VectorFloat              probClassPairs;   
@@ -273,6 +296,8 @@ namespace KKMLL
 
     SVM_SelectionMethod      selectionMethod;
 
+    kkuint32                 trainingMemoryMB;  /**< Like 'numThreads' not saved with the model. */
+
     bool                     useProbabilityToBreakTies;  //  When true use the probability function to break
                                                          //  voting ties.
 
@@ -333,43 +333,41 @@ void  ComputeProb  (kkint32            numClasses,             // Number of Clas
 
 
 struct SvmModel233**  KKMLL::SvmTrainModel (const struct svm_parameter&  param,
-                                            struct       svm_problem&    subprob
+                                            struct       svm_problem&    subprob,
+                                            kkuint32                     numThreads,
+                                            kkuint32                     trainingMemoryMB,
+                                            SharedKernelCachePtr         kernelCache,
+                                            const kkint32*               cacheKeys,
+                                            VolConstBool*                cancelFlag
                                            )
 { 
   struct SvmModel233 **submodel;
   kkint32 numSVM = param.numSVM;
   submodel = new SvmModel233* [numSVM];
-  submodel[0] = svm_train (&subprob,  &param);
+  submodel[0] = svm_train (&subprob,  &param, numThreads, trainingMemoryMB, kernelCache, cacheKeys, cancelFlag);
   return  submodel;
 }  /* SvmTrainModel */
 
 
 
-void   KKMLL::SvmPredictClass (SVMparam&               svmParam,
-                               struct SvmModel233**    subModel,
-                               const struct svm_node*  unknownClassFeatureData, 
-                               kkint32*                votes,
-                               double*                 probabilities,
-                               kkint32                 knownClass,
-                               kkint32&                predClass1,
-                               kkint32&                predClass2,
-                               kkint32&                predClass1Votes,
-                               kkint32&                predClass2Votes,
-                               double&                 predClass1Prob,
-                               double&                 predClass2Prob,
-                               double&                 probOfKnownClass,
-                               Ivector&                winners,
-                               double**                crossClassProbTable,
-                               double&                 breakTie
-                              )
+/** @brief  The part of 'SvmPredictClass' that follows 'svm_predict';  turns the distances of the class pairs into votes and probabilities. */
+static  void   SvmPredictClassFromDist (SVMparam&   svmParam,
+                                        kkint32     NUMCLASS,
+                                        Dvector&    dist,
+                                        kkint32*    votes,
+                                        double*     probabilities,
+                                        kkint32     knownClass,
+                                        kkint32&    predClass1,
+                                        kkint32&    predClass2,
+                                        kkint32&    predClass1Votes,
+                                        kkint32&    predClass2Votes,
+                                        double&     predClass1Prob,
+                                        double&     predClass2Prob,
+                                        double&     probOfKnownClass,
+                                        double**    crossClassProbTable,
+                                        double&     breakTie
+                                       )
 {
-  kkint32  NUMCLASS = subModel[0][0].nr_class;
-
-  kkint32 numBinary = (NUMCLASS * (NUMCLASS - 1)) / 2;
-  Dvector dist (numBinary, 0);
-
-  svm_predict (subModel[0], unknownClassFeatureData, dist, winners, -1);
-
   ComputeProb  (NUMCLASS,
                 svmParam.ProbClassPairs (),
                 dist,                   // Distances for each binary classifier from decision boundary.
@@ -402,10 +400,84 @@ void   KKMLL::SvmPredictClass (SVMparam&               svmParam,
     probOfKnownClass   = probabilities[knownClass];
 
   breakTie = (predClass1Prob - predClass2Prob);
+}  /* SvmPredictClassFromDist */
+
+
+
+void   KKMLL::SvmPredictClass (SVMparam&               svmParam,
+                               struct SvmModel233**    subModel,
+                               const struct svm_node*  unknownClassFeatureData, 
+                               kkint32*                votes,
+                               double*                 probabilities,
+                               kkint32                 knownClass,
+                               kkint32&                predClass1,
+                               kkint32&                predClass2,
+                               kkint32&                predClass1Votes,
+                               kkint32&                predClass2Votes,
+                               double&                 predClass1Prob,
+                               double&                 predClass2Prob,
+                               double&                 probOfKnownClass,
+                               Ivector&                winners,
+                               double**                crossClassProbTable,
+                               double&                 breakTie
+                              )
+{
+  kkint32  NUMCLASS = subModel[0][0].nr_class;
+
+  kkint32 numBinary = (NUMCLASS * (NUMCLASS - 1)) / 2;
+  Dvector dist (numBinary, 0);
+
+  svm_predict (subModel[0], unknownClassFeatureData, dist, winners, -1);
+
+  SvmPredictClassFromDist (svmParam, NUMCLASS, dist, votes, probabilities, knownClass,
+                           predClass1,      predClass2,
+                           predClass1Votes, predClass2Votes,
+                           predClass1Prob,  predClass2Prob,
+                           probOfKnownClass,
+                           crossClassProbTable,
+                           breakTie
+                          );
 }  /* SvmPredictClass */
 
 
 
+void   KKMLL::SvmPredictClassFromKernel (SVMparam&             svmParam,
+                                         struct SvmModel233**  subModel,
+                                         const double*         kvalues,
+                                         kkint32*              votes,
+                                         double*               probabilities,
+                                         kkint32               knownClass,
+                                         kkint32&              predClass1,
+                                         kkint32&              predClass2,
+                                         kkint32&              predClass1Votes,
+                                         kkint32&              predClass2Votes,
+                                         double&               predClass1Prob,
+                                         double&               predClass2Prob,
+                                         double&               probOfKnownClass,
+                                         Ivector&              winners,
+                                         double**              crossClassProbTable,
+                                         double&               breakTie
+                                        )
+{
+  kkint32  NUMCLASS = subModel[0][0].nr_class;
+
+  kkint32 numBinary = (NUMCLASS * (NUMCLASS - 1)) / 2;
+  Dvector dist (numBinary, 0);
+
+  svm_predictFromKernel (subModel[0], kvalues, dist, winners);
+
+  SvmPredictClassFromDist (svmParam, NUMCLASS, dist, votes, probabilities, knownClass,
+                           predClass1,      predClass2,
+                           predClass1Votes, predClass2Votes,
+                           predClass1Prob,  predClass2Prob,
+                           probOfKnownClass,
+                           crossClassProbTable,
+                           breakTie
+                          );
+}  /* SvmPredictClassFromKernel */
+
+
+
 kkint32  KKMLL::SvmPredictTwoClass (const svm_parameter&  param,
                                     SvmModel233**         submodel, 
                                     const svm_node*       unKnownData, 
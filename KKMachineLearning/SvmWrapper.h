@@ -29,8 +29,20 @@ namespace KKMLL
                                        );
 
 
+  /**
+   *@param[in] numThreads        Number of binary classifiers of a multi-class problem to train at the same time; 0 = one per processor.
+   *@param[in] trainingMemoryMB  Limit on the kernel cache used by the binary classifiers being trained at the same time; 0 = no limit.
+   *@param[in] kernelCache       Kernel values shared with other problems;  see 'SVM233::svm_train'.
+   *@param[in] cacheKeys         Key in 'kernelCache' of each example in 'subprob';  NULL = its position in 'subprob'.
+   *@param[in] cancelFlag        Monitored while training;  if it turns true the returned sub-model will be NULL.
+   */
   struct  SvmModel233**   SvmTrainModel (const struct svm_parameter&  param,
-                                         struct svm_problem&          subprob
+                                         struct svm_problem&          subprob,
+                                         kkuint32                     numThreads = 1,
+                                         kkuint32                     trainingMemoryMB = 0,
+                                         SharedKernelCachePtr         kernelCache = NULL,
+                                         const kkint32*               cacheKeys = NULL,
+                                         VolConstBool*                cancelFlag = NULL
                                         );
 
   void  EncodeProblem (const struct svm_paramater&  param, 
@@ -82,6 +94,29 @@ namespace KKMLL
                          );
 
 
+  /**
+   *@brief  Same as 'SvmPredictClass' but with the kernel values between the example and the support vectors of
+   *        'subModel[0]' already computed;  see 'SVM233::svm_kernelValuesBlock'.
+   */
+  void   SvmPredictClassFromKernel (SVMparam&             svmParam,
+                                    struct SvmModel233**  subModel,
+                                    const double*         kvalues,
+                                    kkint32*              votes,
+                                    double*               probabilities,
+                                    kkint32               knownClass,
+                                    kkint32&              predClass1,
+                                    kkint32&              predClass2,
+                                    kkint32&              predClass1Votes,
+                                    kkint32&              predClass2Votes,
+                                    double&               predClass1Prob,
+                                    double&               predClass2Prob,
+                                    double&               probOfKnownClass,
+                                    Ivector&              winners,
+                                    double**              crossClassProbTable,
+                                    double&               breakTie
+                                   );
+
+
 
   kkint32  SvmPredictTwoClass (const struct svm_parameter&   param,
                                SvmModel233**                 submodel, 
@@ -28,11 +28,11 @@ TrainingClass::TrainingClass ():
      mlClass              (NULL),
      subClassifier        (NULL),
      weight               (0.0f),
-     classNameLineNum     (-1),
-     countFactorLineNum   (-1),
-     dirLineNum           (-1),
-     subClassifierLineNum (-1),
-     weightLineNum        (-1)
+     classNameLineNum     (),
+     countFactorLineNum   (),
+     dirLineNum           (),
+     subClassifierLineNum (),
+     weightLineNum        ()
 {
 }
 
@@ -51,11 +51,11 @@ TrainingClass::TrainingClass (const VectorKKStr&        _directories,
                 mlClass              (NULL),
                 subClassifier        (_subClassifier),
                 weight               (_weight),
-                classNameLineNum     (-1),
-                countFactorLineNum   (-1),
-                dirLineNum           (-1),
-                subClassifierLineNum (-1),
-                weightLineNum        (-1)
+                classNameLineNum     (),
+                countFactorLineNum   (),
+                dirLineNum           (),
+                subClassifierLineNum (),
+                weightLineNum        ()
  
 {
   featureFileName << ".data";   // Will be equal to ClassName + ".data".     ex:  "Copepods.data"
@@ -259,6 +259,17 @@ void  TrainingClass::WriteXML (const KKStr&  varName,
 
 
 
+/** @brief  Line number attributes are written empty by 'XmlTag::AddAtribute' when the setting was not in the configuration file. */
+static
+OptionUInt32  AttributeLineNum (const KKStr&  v)
+{
+  if  (v.Empty ())
+    return  {};
+  return  v.ToUint32 ();
+}
+
+
+
 void  TrainingClass::ReadXML (XmlStream&      s,
                               XmlTagConstPtr  tag,
                               VolConstBool&   cancelFlag,
@@ -287,19 +298,19 @@ void  TrainingClass::ReadXML (XmlStream&      s,
       SubClassifierName (v);
 
     else if (n.EqualIgnoreCase ("ClassNameLineNum"))
-      ClassNameLineNum (v.ToInt32());
+      ClassNameLineNum (AttributeLineNum (v));
 
     else if (n.EqualIgnoreCase ("CountFactorLineNum"))
-      CountFactorLineNum (v.ToInt32 ());
+      CountFactorLineNum (AttributeLineNum (v));
 
     else if (n.EqualIgnoreCase ("DirLineNum"))
-      DirLineNum (v.ToInt32 ());
+      DirLineNum (AttributeLineNum (v));
 
     else if (n.EqualIgnoreCase ("SubClassifierLineNum"))
-      SubClassifierLineNum (v.ToInt32 ());
+      SubClassifierLineNum (AttributeLineNum (v));
 
     else if (n.EqualIgnoreCase ("WeightLineNum"))
-      WeightLineNum (v.ToInt32 ());
+      WeightLineNum (AttributeLineNum (v));
   }
 
   XmlTokenPtr  t = s.GetNextToken (cancelFlag, log);
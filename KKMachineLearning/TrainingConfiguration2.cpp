@@ -641,6 +641,14 @@ void  TrainingConfiguration2::Save (const KKStr& saveFileName)  const
 } /* Save */
 
 
+void   TrainingConfiguration2::ConfigFileNameSpecified (const KKStr&  _configFileName)
+{
+  configFileNameSpecified = _configFileName;
+  configRootName          = KKB::osGetRootName (_configFileName);
+}
+
+
+
 void   TrainingConfiguration2::RootDir (const KKStr& _rootDir)
 {
   rootDir = _rootDir;
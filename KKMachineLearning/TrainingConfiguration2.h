@@ -242,6 +242,12 @@ namespace KKMLL
                    double      cParam
                   );
 
+    /**
+     *@brief  Names a configuration that was built in memory rather than loaded;  'SaveTrainingProcess' and
+     * 'LoadExistingTrainingProcess' derive the save file names from it.
+     */
+    void  ConfigFileNameSpecified (const KKStr&      _configFileName);
+
     void  EncodingMethod     (SVM_EncodingMethod     _encodingMethod);
     void  ExamplesPerClass   (kkint32                _examplesPerClass);
     void  Gamma              (double                 _gamma);
@@ -17,12 +17,14 @@
 using namespace  std;
 
 
+#include "BinaryContainer.h"
 #include "GlobalGoalKeeper.h"
 #include "KKBaseTypes.h"
 #include "KKException.h"
 #include "KKStr.h"
 #include "OSservices.h"
 #include "RBTree.h"
+#include "TokenBuffer.h"
 using namespace  KKB;
 
 
@@ -54,12 +56,29 @@ TrainingProcess2Ptr  TrainingProcess2::LoadExistingTrainingProcess (const KKStr&
                                                                     RunLog&        log
                                                                    )
 {
-  TrainingProcess2Ptr  trainer = NULL;
-
   KKStr  configFileFullName = TrainingConfiguration2::GetEffectiveConfigFileName (configRootName);
 
   KKStr  savedModelName = osRemoveExtension (configFileFullName) + ".Save";
-  if  (!osFileExists (savedModelName))
+  KKStr  binFileName    = osRemoveExtension (configFileFullName) + ".SaveBin";
+
+  bool  xmlExists = osFileExists (savedModelName);
+  if  (osFileExists (binFileName))
+  {
+    if  ((!xmlExists)  ||  (osGetFileDateTime (binFileName) >= osGetFileDateTime (savedModelName)))
+    {
+      TrainingProcess2Ptr  trainer = LoadBinaryTrainingProcess (binFileName, cancelFlag, log);
+      if  (trainer  ||  (!xmlExists))
+        return  trainer;
+
+      log.Level (-1) << "TrainingProcess2::LoadExistingTrainingProcess   Falling back to SaveFile[" << savedModelName << "]." << endl;
+    }
+    else
+    {
+      log.Level (10) << "TrainingProcess2::LoadExistingTrainingProcess   Ignoring out of date [" << binFileName << "]." << endl;
+    }
+  }
+
+  if  (!xmlExists)
   {
     log.Level (-1) << endl
       << "TrainingProcess2::LoadExistingTrainingProcess   ***ERROR***    SaveFile[" << savedModelName << "]  does not exist." << endl
@@ -67,22 +86,137 @@ TrainingProcess2Ptr  TrainingProcess2::LoadExistingTrainingProcess (const KKStr&
     return NULL;
   }
 
-  XmlStreamPtr  stream = new XmlStream (savedModelName, log);
-  XmlTokenPtr  t = stream->GetNextToken (cancelFlag, log);
+  return  LoadXmlTrainingProcess (savedModelName, cancelFlag, log);
+}  /* LoadExistingTrainingProcess */
+
+
+
+TrainingProcess2Ptr  TrainingProcess2::ReadTrainingProcess (XmlStream&     stream,
+                                                            VolConstBool&  cancelFlag,
+                                                            RunLog&        log
+                                                           )
+{
+  TrainingProcess2Ptr  trainer = NULL;
+
+  XmlTokenPtr  t = stream.GetNextToken (cancelFlag, log);
   while  (t  &&  (typeid (*t)  !=  typeid (XmlElementTrainingProcess2)))
   {
     delete  t;
-    t = stream->GetNextToken (cancelFlag, log);
+    t = stream.GetNextToken (cancelFlag, log);
   }
 
   if  (t)
     trainer = dynamic_cast<XmlElementTrainingProcess2Ptr> (t)->TakeOwnership ();
 
+  delete  t;
+  t = NULL;
+
+  return  trainer;
+}  /* ReadTrainingProcess */
+
+
+
+TrainingProcess2Ptr  TrainingProcess2::LoadXmlTrainingProcess (const KKStr&   savedModelName,
+                                                               VolConstBool&  cancelFlag,
+                                                               RunLog&        log
+                                                              )
+{
+  XmlStreamPtr  stream = new XmlStream (savedModelName, log);
+  TrainingProcess2Ptr  trainer = ReadTrainingProcess (*stream, cancelFlag, log);
+  delete  stream;  stream = NULL;
+  return  trainer;
+}  /* LoadXmlTrainingProcess */
+
+
+
+TrainingProcess2Ptr  TrainingProcess2::LoadBinaryTrainingProcess (const KKStr&   binFileName,
+                                                                  VolConstBool&  cancelFlag,
+                                                                  RunLog&        log
+                                                                 )
+{
+  BinaryContainerPtr  container = NULL;
+  try
+  {
+    container = new BinaryContainer (binFileName);
+  }
+  catch  (const KKException&  e)
+  {
+    log.Level (-1) << endl
+      << "TrainingProcess2::LoadBinaryTrainingProcess   ***ERROR***   " << e.ToString () << endl
+      << endl;
+    return NULL;
+  }
+
+  const BinaryContainer::SectionEntry*  xmlSection = container->LookUp ("Xml");
+  if  (!xmlSection)
+  {
+    log.Level (-1) << endl
+      << "TrainingProcess2::LoadBinaryTrainingProcess   ***ERROR***   [" << binFileName << "] has no 'Xml' section." << endl
+      << endl;
+    BinaryContainer::Release (container);
+    return NULL;
+  }
+
+  // Everything but the arrays is in the 'Xml' section;  arrays refer to the other sections by name.
+  istringstream  xmlText (string ((const char*)container->SectionData (*xmlSection), (size_t)xmlSection->count));
+  TokenBufferStream  tokenBuffer (&xmlText);
+
+  XmlStreamPtr  stream = new XmlStream (new XmlTokenizer (&tokenBuffer));
+  stream->Container (container);
+  BinaryContainer::Release (container);
+
+  TrainingProcess2Ptr  trainer = NULL;
+  try
+  {
+    trainer = ReadTrainingProcess (*stream, cancelFlag, log);
+  }
+  catch  (const KKException&  e)
+  {
+    log.Level (-1) << endl
+      << "TrainingProcess2::LoadBinaryTrainingProcess   ***ERROR***   [" << binFileName << "]  " << e.ToString () << endl
+      << endl;
+    delete  trainer;
+    trainer = NULL;
+  }
+
   delete  stream;  stream = NULL;
-  delete  t;       t      = NULL;
 
   return  trainer;
-}  /* LoadExistingTrainingProcess */
+}  /* LoadBinaryTrainingProcess */
+
+
+
+bool  TrainingProcess2::ConvertSavedModelToBinary (const KKStr&   configRootName,
+                                                   VolConstBool&  cancelFlag,
+                                                   RunLog&        log
+                                                  )
+{
+  KKStr  configFileFullName = TrainingConfiguration2::GetEffectiveConfigFileName (configRootName);
+  KKStr  savedModelName = osRemoveExtension (configFileFullName) + ".Save";
+  if  (!osFileExists (savedModelName))
+  {
+    log.Level (-1) << endl
+      << "TrainingProcess2::ConvertSavedModelToBinary   ***ERROR***    SaveFile[" << savedModelName << "]  does not exist." << endl
+      << endl;
+    return false;
+  }
+
+  TrainingProcess2Ptr  trainer = LoadXmlTrainingProcess (savedModelName, cancelFlag, log);
+  if  ((!trainer)  ||  trainer->Abort ()  ||  cancelFlag)
+  {
+    log.Level (-1) << endl
+      << "TrainingProcess2::ConvertSavedModelToBinary   ***ERROR***    Could not load SaveFile[" << savedModelName << "]." << endl
+      << endl;
+    delete  trainer;
+    return false;
+  }
+
+  trainer->SaveTrainingProcessBinary (log);
+  delete  trainer;
+  trainer = NULL;
+
+  return  true;
+}  /* ConvertSavedModelToBinary */
 
 
 
@@ -550,6 +684,44 @@ void  TrainingProcess2::SaveTrainingProcess (RunLog&  log)
 
 
 
+void  TrainingProcess2::SaveTrainingProcessBinary (RunLog&  log)
+{
+  configFileName = TrainingConfiguration2::GetEffectiveConfigFileName (config->ConfigFileNameSpecified ());
+  KKStr  binFileName = osRemoveExtension (configFileName) + ".SaveBin";
+  log.Level (20) << "TrainingProcess2::SaveTrainingProcessBinary  Saving trained model: " << binFileName << endl;
+
+  try
+  {
+    BinaryContainerWriter  writer (binFileName);
+
+    // Arrays are diverted to sections of 'writer' as they are written.
+    ostringstream  xmlText;
+    BinaryContainerWriter::Attach (xmlText, &writer);
+    this->WriteXML ("TrainingProcess2", xmlText);
+    BinaryContainerWriter::Attach (xmlText, NULL);
+
+    string  xmlStr = xmlText.str ();
+    writer.AddSection ("Xml", "Xml", 1, xmlStr.size (), xmlStr.data ());
+    writer.Close ();
+  }
+  catch  (const KKException&  e)
+  {
+    log.Level (-1) << endl
+      << "TrainingProcess2::SaveTrainingProcessBinary   ***ERROR***   " << e.ToString () << endl
+      << endl;
+    osDeleteFile (binFileName);
+    return;
+  }
+
+  if  (subTrainingProcesses)
+  {
+    for  (auto  tp: *subTrainingProcesses)
+      tp->SaveTrainingProcessBinary (log);
+  }
+}  /* SaveTrainingProcessBinary */
+
+
+
 ModelOldSVMPtr  TrainingProcess2::OldSVMModel ()  const
 {
   if  (model->ModelType () == Model::ModelTypes::OldSVM)
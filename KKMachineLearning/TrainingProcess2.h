@@ -192,6 +192,8 @@ namespace KKMLL
 
     /**
      *@brief  Loads an existing TrainingProcess; if one does not exist will return NULL.
+     *@details  If a binary save file ('.SaveBin') exists that is not older than the XML save file ('.Save')
+     * it is loaded instead;  see 'SaveTrainingProcessBinary'.
      *@param[in]  configRootName  Root name of training model; 
      *@param[in]  cancelFlag  Will monitor if it ever is set to true will stop processing at earliest convenience 
      *                        and return to caller.
@@ -204,6 +206,18 @@ namespace KKMLL
                                                      );
 
 
+    /**
+     *@brief  Loads the XML save file of 'configRootName' and writes it, along with those of its
+     * sub-classifiers, as binary save files;  see 'SaveTrainingProcessBinary'.
+     *@returns  true if the model was loaded and written.
+     */
+    static
+    bool  ConvertSavedModelToBinary (const KKStr&   configRootName,
+                                     VolConstBool&  cancelFlag,
+                                     RunLog&        log
+                                    );
+
+
 
     /**
      *@brief  The default constructor; What will be used when creating an instance while reading in
@@ -298,6 +312,15 @@ namespace KKMLL
      */
     void  SaveTrainingProcess (RunLog&  log);
 
+    /**
+     *@brief  Saves the built training model and those of its sub-classifiers into binary save files ('.SaveBin').
+     *@details  A binary save file is a 'BinaryContainer' holding the same XML that 'SaveTrainingProcess' writes
+     * except that arrays, such as support vectors and normalization parameters, are stored as aligned sections
+     * of the container.  When loaded the container is memory mapped so those arrays are copied or used in place
+     * instead of being parsed.  The loaded model predicts the same as one loaded from the XML save file.
+     */
+    void  SaveTrainingProcessBinary (RunLog&  log);
+
     void  SupportVectorStatistics (kkint32&  numSVs,
                                    kkint32&  totalNumSVs
                                   );
@@ -350,6 +373,25 @@ namespace KKMLL
                                            RunLog&                         log
                                           );
 
+    /** @brief  Returns the first 'TrainingProcess2' instance in 'stream' or NULL if there is none. */
+    static
+    TrainingProcess2Ptr  ReadTrainingProcess (XmlStream&     stream,
+                                              VolConstBool&  cancelFlag,
+                                              RunLog&        log
+                                             );
+
+    static
+    TrainingProcess2Ptr  LoadBinaryTrainingProcess (const KKStr&   binFileName,
+                                                    VolConstBool&  cancelFlag,
+                                                    RunLog&        log
+                                                   );
+
+    static
+    TrainingProcess2Ptr  LoadXmlTrainingProcess (const KKStr&   savedModelName,
+                                                 VolConstBool&  cancelFlag,
+                                                 RunLog&        log
+                                                );
+
 
 
     //************************************************************
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
+#include <functional>
 #if  defined(WIN32)
 #include <LIMITS.H>
 #include <FLOAT.H>
@@ -22,6 +23,7 @@ using namespace  std;
 
 #include "GlobalGoalKeeper.h"
 #include "KKBaseTypes.h"
+#include "KKThreadPool.h"
 #include "OSservices.h"
 #include "XmlStream.h"
 using namespace  KKB;
@@ -247,6 +249,7 @@ UsfCasCor::UsfCasCor ():
   feature_type            (NULL),
 
   the_random_seed         (0),
+  randomSequence          (0),
 
   load_weights            (false),
 
@@ -323,7 +326,7 @@ UsfCasCor::UsfCasCor ():
   /* net and their input weights.                                            */
   /***************************************************************************/
   Values                  (NULL),
-  ValuesCache             (NULL),
+  ValuesCache             (),
   ExtraValues             (NULL),
   Nconnections            (NULL),
   Connections             (NULL),
@@ -335,12 +338,12 @@ UsfCasCor::UsfCasCor ():
   /***************************************************************************/
   Outputs                 (NULL),
   Errors                  (NULL),
-  ErrorsCache             (NULL),
+  ErrorsCache             (),
   ExtraErrors             (NULL),
-  OutputWeights           (NULL),
-  OutputDeltas            (NULL),
-  OutputSlopes            (NULL),
-  OutputPrevSlopes        (NULL),
+  OutputWeights           (),
+  OutputDeltas            (),
+  OutputSlopes            (),
+  OutputPrevSlopes        (),
 
   /***************************************************************************/
   /* The following arrays have one entry for each candidate unit in the      */
@@ -348,12 +351,12 @@ UsfCasCor::UsfCasCor ():
   /***************************************************************************/
   CandValues              (NULL),
   CandSumValues           (NULL),
-  CandCor                 (NULL),
-  CandPrevCor             (NULL),
-  CandWeights             (NULL),
-  CandDeltas              (NULL),
-  CandSlopes              (NULL),
-  CandPrevSlopes          (NULL),
+  CandCor                 (),
+  CandPrevCor             (),
+  CandWeights             (),
+  CandDeltas              (),
+  CandSlopes              (),
+  CandPrevSlopes          (),
 
   /***************************************************************************/
   /* This saves memory if each candidate unit receives a connection from     */
@@ -379,6 +382,9 @@ UsfCasCor::UsfCasCor ():
   /***************************************************************************/
   WeightFile              (NULL),
   InterruptPending        (false),
+  numThreads              (1),
+  pool                    (NULL),
+  shards                  (),
   classes                 (NULL),
   selectedFeatures        (NULL)
 
@@ -430,29 +436,17 @@ void  UsfCasCor::CleanUpMemory ()
 
   delete  Outputs;         Outputs = NULL;
 
-  Delete2DArray (OutputWeights,    Noutputs);
-  Delete2DArray (OutputDeltas,     Noutputs);
-  Delete2DArray (OutputSlopes,     Noutputs);
-  Delete2DArray (OutputPrevSlopes, Noutputs);
-
   delete  CandValues;     CandValues    = NULL;
   delete  CandSumValues;  CandSumValues = NULL;
 
-  Delete2DArray (CandCor,         Ncandidates);
-  Delete2DArray (CandPrevCor,     Ncandidates);
-  Delete2DArray (CandWeights,     Ncandidates);
-  Delete2DArray (CandDeltas,      Ncandidates);
-  Delete2DArray (CandSlopes,      Ncandidates);
-  Delete2DArray (CandPrevSlopes,  Ncandidates);
   Delete2DArray (TrainingInputs,  NTrainingPatterns);
   Delete2DArray (TrainingOutputs, NTrainingPatterns);
   Delete2DArray (TestInputs,      NTestPatterns);
   Delete2DArray (TestOutputs,     NTestPatterns);
-  Delete2DArray (ValuesCache,     MaxCases);
-  Delete2DArray (ErrorsCache,     MaxCases);
 
   delete  feature_type;    feature_type   = NULL;
   delete  AllConnections;  AllConnections = NULL;
+  delete  pool;            pool           = NULL;
 }  /* CleanUpMemory */
 
 
@@ -480,26 +474,36 @@ kkMemSize  UsfCasCor::MemoryConsumedEstimated ()  const
   
   if  (ExtraValues)       memoryConsumedEstimated += MaxUnits          * sizeof (float);
   if  (example_weight)    memoryConsumedEstimated += NTrainingPatterns * sizeof (float);
-  if  (ValuesCache)       memoryConsumedEstimated += MaxCases * MaxUnits  * sizeof (float);
-  if  (ErrorsCache)       memoryConsumedEstimated += MaxCases * Noutputs  * sizeof (float);
   if  (Outputs)           memoryConsumedEstimated += Noutputs * sizeof (float);
 
-
-  if  (OutputWeights)     memoryConsumedEstimated += MaxCases * Noutputs  * sizeof (float);
-  if  (OutputDeltas)      memoryConsumedEstimated += MaxCases * Noutputs  * sizeof (float);
-  if  (OutputSlopes)      memoryConsumedEstimated += MaxCases * Noutputs  * sizeof (float);
-  if  (OutputPrevSlopes)  memoryConsumedEstimated += MaxCases * Noutputs  * sizeof (float);
+  memoryConsumedEstimated += ValuesCache.MemoryConsumedEstimated ()
+                          +  ErrorsCache.MemoryConsumedEstimated ()
+                          +  OutputWeights.MemoryConsumedEstimated ()
+                          +  OutputDeltas.MemoryConsumedEstimated ()
+                          +  OutputSlopes.MemoryConsumedEstimated ()
+                          +  OutputPrevSlopes.MemoryConsumedEstimated ();
 
   if  (ExtraErrors)       memoryConsumedEstimated += Noutputs * sizeof (float);
-  if  (CandValues)        memoryConsumedEstimated += Noutputs * sizeof (float);
-  if  (CandSumValues)     memoryConsumedEstimated += Noutputs * sizeof (float);
+  if  (CandValues)        memoryConsumedEstimated += Ncandidates * sizeof (float);
+  if  (CandSumValues)     memoryConsumedEstimated += Ncandidates * sizeof (float);
+
+  memoryConsumedEstimated += CandCor.MemoryConsumedEstimated ()
+                          +  CandPrevCor.MemoryConsumedEstimated ()
+                          +  CandWeights.MemoryConsumedEstimated ()
+                          +  CandDeltas.MemoryConsumedEstimated ()
+                          +  CandSlopes.MemoryConsumedEstimated ()
+                          +  CandPrevSlopes.MemoryConsumedEstimated ();
+
+  for  (auto&  shard: shards)
+  {
+    memoryConsumedEstimated += sizeof (CaseShard)
+                            +  (shard.sumErrors.size () + shard.candSumValues.size () + shard.values.size () + shard.outputs.size () + shard.errors.size ()) * sizeof (float)
+                            +  shard.candCor.MemoryConsumedEstimated ()
+                            +  shard.slopes.MemoryConsumedEstimated ();
+  }
 
-  if  (CandCor)           memoryConsumedEstimated += Ncandidates * Noutputs  * sizeof (float);
-  if  (CandPrevCor)       memoryConsumedEstimated += Ncandidates * Noutputs  * sizeof (float);
-  if  (CandWeights)       memoryConsumedEstimated += Ncandidates * MaxUnits  * sizeof (float);
-  if  (CandDeltas)        memoryConsumedEstimated += Ncandidates * MaxUnits  * sizeof (float);
-  if  (CandSlopes)        memoryConsumedEstimated += Ncandidates * MaxUnits  * sizeof (float);
-  if  (CandPrevSlopes)    memoryConsumedEstimated += Ncandidates * MaxUnits  * sizeof (float);
+  if  (pool)
+    memoryConsumedEstimated += pool->MemoryConsumedEstimated ();
 
   return  memoryConsumedEstimated;
 }  /* MemoryConsumedEstimated */
@@ -534,7 +538,7 @@ MLClassPtr  UsfCasCor::PredictClass (FeatureVectorPtr  example)
   int i = 0;
   {
     Goal = TestOutputs[i];
-    FULL_FORWARD_PASS (TestInputs[i]);
+    FULL_FORWARD_PASS (TestInputs[i], Values, Outputs);
     
     /* Find max. output (predicted class) */
     kkuint32  max_pred = 0;
@@ -602,7 +606,7 @@ void  UsfCasCor::PredictConfidences (FeatureVectorPtr    example,
   int i = 0;
   {
     Goal = TestOutputs[i];
-    FULL_FORWARD_PASS (TestInputs[i]);
+    FULL_FORWARD_PASS (TestInputs[i], Values, Outputs);
     
     /* Find max. output (predicted class) */
 
@@ -691,7 +695,7 @@ ClassProbListPtr  UsfCasCor::PredictClassConfidences (FeatureVectorPtr  example)
   int i = 0;
   {
     Goal = TestOutputs[i];
-    FULL_FORWARD_PASS (TestInputs[i]);
+    FULL_FORWARD_PASS (TestInputs[i], Values, Outputs);
     for  (int j = 0;  j < Noutputs;  j++)
       totalDelta += (Outputs[j] - SigmoidMin);
   } 
@@ -735,6 +739,7 @@ void  UsfCasCor::TrainNewClassifier (kkint32                 _in_limit,
                                      kkint32                 _number_of_trials,
                                      kkint64                 _the_random_seed,
                                      bool                    _useCache,
+                                     kkuint32                _numThreads,
                                      FeatureVectorListPtr    _trainData,
                                      FeatureNumListConstPtr  _selectedFeatures,
                                      VolConstBool&           _cancelFlag,
@@ -766,6 +771,7 @@ void  UsfCasCor::TrainNewClassifier (kkint32                 _in_limit,
     UseCache = true;
   else
     UseCache = false;
+  numThreads       = _numThreads;
 
   /* First, load the data and configuration */
   setup_network (filteredTrainData, _log);
@@ -848,12 +854,14 @@ void  UsfCasCor::setup_network (FeatureVectorListPtr  trainExamples,
   if  (NonRandomSeed) 
      the_random_seed = 1;
 
+  /* Only a seed taken from the clock is mixed with the process id;  a  */
+  /* seed that was asked for has to reproduce the same network.          */
   if (the_random_seed <= 0)
-     the_random_seed = time(NULL);
+     the_random_seed = time(NULL) + GetProcessId ();
 
-  the_random_seed += GetProcessId () + my_mpi_rank;
+  the_random_seed += my_mpi_rank;
 
-  SRand48 (the_random_seed);
+  randomSequence = ((((kkuint64)the_random_seed) << 16) | 0x330E) & 0xFFFFFFFFFFFFULL;
   log.Level (10) << "Starting seed " << ((NonRandomSeed)?"fixed":"random") << " at " << the_random_seed << endl;
 
   /* Initialize the network variables */
@@ -889,9 +897,16 @@ void UsfCasCor::train_network (VolConstBool&  cancelFlag,
                  << "Ilim[" << in_limit << "] "
                  << "Olim [" << MaxUnits << "]  "
                  << "NumberOfRounds[" << number_of_rounds << "]  "
-                 << "NumberOfTrials[" << number_of_trials << "]."
+                 << "NumberOfTrials[" << number_of_trials << "]  "
+                 << "NumThreads[" << numThreads << "]."
                  << endl;
 
+  /* Passes over the training cases are split across the pool's threads;  with one thread there are no workers
+   * and 'ParallelFor' runs them on this thread.
+   */
+  delete  pool;
+  pool = new KKThreadPool ("UsfCasCor", numThreads);
+
   for  (i = 0; (i < number_of_trials)  &&  (!cancelFlag); i++)
   {
     Trial = i + 1;
@@ -946,6 +961,9 @@ void UsfCasCor::train_network (VolConstBool&  cancelFlag,
                  << "Max: " << max_units
                  << endl;
 
+  delete  pool;
+  pool = NULL;
+
   return;
 }  /* train_network */
 
@@ -997,20 +1015,21 @@ void  UsfCasCor::allocate_network (RunLog&  log)
   DummySumErrors = new float[Noutputs];
   Errors         = ExtraErrors;
   
-  Outputs          = new float[Noutputs];
-  OutputWeights    = new float*[Noutputs];
-  OutputDeltas     = new float*[Noutputs];
-  OutputSlopes     = new float*[Noutputs];
-  OutputPrevSlopes = new float*[Noutputs];
-
-  CandValues     = new float[Ncandidates];
-  CandSumValues  = new float[Ncandidates];
-  CandCor        = new float*[Ncandidates];
-  CandPrevCor    = new float*[Ncandidates];
-  CandWeights    = new float*[Ncandidates];
-  CandDeltas     = new float*[Ncandidates];
-  CandSlopes     = new float*[Ncandidates];
-  CandPrevSlopes = new float*[Ncandidates];
+  /* Per unit data arrays are each one contiguous block with a row per output or candidate. */
+  Outputs = new float[Noutputs];
+  OutputWeights.ReSize    (Noutputs, MaxUnits);
+  OutputDeltas.ReSize     (Noutputs, MaxUnits);
+  OutputSlopes.ReSize     (Noutputs, MaxUnits);
+  OutputPrevSlopes.ReSize (Noutputs, MaxUnits);
+
+  CandValues    = new float[Ncandidates];
+  CandSumValues = new float[Ncandidates];
+  CandCor.ReSize        (Ncandidates, Noutputs);
+  CandPrevCor.ReSize    (Ncandidates, Noutputs);
+  CandWeights.ReSize    (Ncandidates, MaxUnits);
+  CandDeltas.ReSize     (Ncandidates, MaxUnits);
+  CandSlopes.ReSize     (Ncandidates, MaxUnits);
+  CandPrevSlopes.ReSize (Ncandidates, MaxUnits);
  
   TrainingInputs  = new float*[NTrainingPatterns];
   TrainingOutputs = new float*[NTrainingPatterns];
@@ -1030,34 +1049,11 @@ void  UsfCasCor::allocate_network (RunLog&  log)
   /* Only create the caches if UseCache is on -- may not always have room. */
   if  (UseCache)
   {
-    ValuesCache = new float*[MaxCases];
-    ErrorsCache = new float*[MaxCases];
-    for  (i = 0;  i < MaxCases;  i++)
-    {
-      ValuesCache[i] = new float[MaxUnits];
-      ErrorsCache[i] = new float[Noutputs];
-    }
-  }
-
-  /* Allocate per unit data arrays */
-  for  (i = 0;  i < Noutputs;  i++)
-  {
-    OutputWeights   [i] = new float[MaxUnits];
-    OutputDeltas    [i] = new float[MaxUnits];
-    OutputSlopes    [i] = new float[MaxUnits];
-    OutputPrevSlopes[i] = new float[MaxUnits];
+    ValuesCache.ReSize (MaxCases, MaxUnits);
+    ErrorsCache.ReSize (MaxCases, Noutputs);
   }
 
-  for  (i = 0; i < Ncandidates; i++)
-  {
-    CandCor[i]        = new float[Noutputs];
-    CandPrevCor[i]    = new float[Noutputs];
-
-    CandWeights[i]    = new float[MaxUnits];
-    CandDeltas[i]     = new float[MaxUnits];
-    CandSlopes[i]     = new float[MaxUnits];
-    CandPrevSlopes[i] = new float[MaxUnits];
-  }
+  AllocateShards ();
 
   /* Allocate per case data arrays */
   for  (i = 0; i < NTrainingPatterns; i++)
@@ -1078,6 +1074,147 @@ void  UsfCasCor::allocate_network (RunLog&  log)
   return;
 }  /* allocate_network */
 
+
+
+const int  UsfCasCor::CaseShardSize = 256;
+
+
+
+/* Split the training cases into shards of CaseShardSize cases.  The    */
+/* shard boundaries do not depend on the number of threads so neither   */
+/* does the order in which the per shard sums are added together.       */
+void  UsfCasCor::AllocateShards ()
+{
+  int  numShards = (Ncases + CaseShardSize - 1) / CaseShardSize;
+  int  slopeRows = (Noutputs > Ncandidates) ? Noutputs : Ncandidates;
+
+  shards.clear ();
+  shards.resize (numShards);
+  for  (int x = 0;  x < numShards;  ++x)
+  {
+    CaseShard&  shard = shards[x];
+    shard.firstCase = FirstCase + x * CaseShardSize;
+    shard.endCase   = shard.firstCase + CaseShardSize;
+    if  (shard.endCase > (FirstCase + Ncases))
+      shard.endCase = FirstCase + Ncases;
+
+    shard.sumErrors.assign     (Noutputs,    0.0f);
+    shard.candSumValues.assign (Ncandidates, 0.0f);
+    shard.candCor.ReSize (Ncandidates, Noutputs);
+    shard.slopes.ReSize  (slopeRows,   MaxUnits);
+    shard.values.assign  (MaxUnits, 0.0f);
+    shard.outputs.assign (Noutputs, 0.0f);
+    shard.errors.assign  (Noutputs, 0.0f);
+  }
+}  /* AllocateShards */
+
+
+
+void  UsfCasCor::ZeroShardErrors (CaseShard&  shard)
+{
+  shard.errorBits = 0;
+  shard.errorMisclassifications = 0;
+  shard.trueError = 0.0f;
+  shard.sumSqError = 0.0f;
+  for  (int o = 0;  o < Noutputs;  ++o)
+    shard.sumErrors[o] = 0.0f;
+}  /* ZeroShardErrors */
+
+
+
+void  UsfCasCor::ZeroShardCandidates (CaseShard&  shard,
+                                      bool        slopes
+                                     )
+{
+  for  (int u = 0;  u < Ncandidates;  ++u)
+  {
+    shard.candSumValues[u] = 0.0f;
+
+    float*  cc = shard.candCor.DataNotConst ()[u];
+    for  (int o = 0;  o < Noutputs;  ++o)
+      cc[o] = 0.0f;
+
+    if  (slopes)
+    {
+      float*  cs = shard.slopes.DataNotConst ()[u];
+      for  (int i = 0;  i < Nunits;  ++i)
+        cs[i] = 0.0f;
+    }
+  }
+}  /* ZeroShardCandidates */
+
+
+
+void  UsfCasCor::SumShardErrors (bool  sumErrors)
+{
+  ErrorBits = 0;
+  ErrorMisclassifications = 0;
+  TrueError = 0.0f;
+  if  (sumErrors)
+  {
+    for  (int o = 0;  o < Noutputs;  ++o)
+      SumErrors[o] = 0.0f;
+    SumSqError = 0.0f;
+  }
+
+  for  (const auto&  shard: shards)
+  {
+    ErrorBits               += shard.errorBits;
+    ErrorMisclassifications += shard.errorMisclassifications;
+    TrueError               += shard.trueError;
+    if  (sumErrors)
+    {
+      for  (int o = 0;  o < Noutputs;  ++o)
+        SumErrors[o] += shard.sumErrors[o];
+      SumSqError += shard.sumSqError;
+    }
+  }
+}  /* SumShardErrors */
+
+
+
+void  UsfCasCor::SumShardOutputSlopes ()
+{
+  /* Each output's slopes are independent of the other outputs. */
+  pool->ParallelFor ((kkuint32)Noutputs, [this] (int j)
+    {
+      float*  os = OutputSlopes.DataNotConst ()[j];
+      for  (const auto&  shard: shards)
+      {
+        const float*  ss = shard.slopes.Data ()[j];
+        for  (int i = 0;  i < Nunits;  ++i)
+          os[i] += ss[i];
+      }
+    }
+  );
+}  /* SumShardOutputSlopes */
+
+
+
+void  UsfCasCor::SumShardCandidate (int   u,
+                                    bool  slopes
+                                   )
+{
+  float*  cc = CandCor.DataNotConst ()[u];
+  float*  cs = CandSlopes.DataNotConst ()[u];
+
+  for  (const auto&  shard: shards)
+  {
+    CandSumValues[u] += shard.candSumValues[u];
+
+    const float*  scc = shard.candCor.Data ()[u];
+    for  (int o = 0;  o < Noutputs;  ++o)
+      cc[o] += scc[o];
+
+    if  (slopes)
+    {
+      const float*  ss = shard.slopes.Data ()[u];
+      for  (int i = 0;  i < Nunits;  ++i)
+        cs[i] += ss[i];
+    }
+  }
+}  /* SumShardCandidate */
+
   
 
 
@@ -1278,9 +1415,13 @@ Boolean  UsfCasCor::_boolean_convert (char *input)
 
 
 
+/* Same sequence as 'lrand48' but private to this instance;  the shared  */
+/* generator would make the weights depend on whoever else is using it.  */
 float  UsfCasCor::random_weight ()
 {
-  return ( (float) (WeightRange * (LRand48 () % 1000 / 500.0)) - WeightRange);
+  randomSequence = (0x5DEECE66DULL * randomSequence + 0xBULL) & 0xFFFFFFFFFFFFULL;
+  kkint32  r = (kkint32)(randomSequence >> 17);
+  return ( (float) (WeightRange * (r % 1000 / 500.0)) - WeightRange);
 }
 
 
@@ -1592,14 +1733,16 @@ void  UsfCasCor::QUICKPROP_UPDATE (int i,
 /* Set up all the inputs from the INPUT vector as the first few entries in
    in the values vector.
 */
-void  UsfCasCor::SETUP_INPUTS (float inputs[])
+void  UsfCasCor::SETUP_INPUTS (float  inputs[],
+                               float  values[]
+                              )
 {
   int i;
   /*********/
 
-  Values[0] = 1.0;		/* bias unit */
+  values[0] = 1.0;		/* bias unit */
   for(i=0;  i < Ninputs;  i++)
-    Values[i+1] = inputs[i];
+    values[i+1] = inputs[i];
 }
 
 
@@ -1608,26 +1751,28 @@ void  UsfCasCor::SETUP_INPUTS (float inputs[])
 /* Assume the values vector has been set up.  Just compute the output
    values.
 */
-void  UsfCasCor::OUTPUT_FORWARD_PASS ()
+void  UsfCasCor::OUTPUT_FORWARD_PASS (const float  values[],
+                                      float        outputs[]
+                                     )
 {
   int i,j;
   float sum;
-  float *ow;
+  const float *ow;
 /********/
 
   for  (j = 0;  j < Noutputs;  j++)
   {
     sum = 0.0;
-    ow  = OutputWeights[j];
+    ow  = OutputWeights.Data ()[j];
 
     for(i=0; i<Nunits; i++)
-      sum += Values[i] * ow[i];
+      sum += values[i] * ow[i];
 
 #ifdef CONNX
       conx += Nunits;
 #endif
 
-    Outputs[j] = OUTPUT_FUNCTION(sum);
+    outputs[j] = OUTPUT_FUNCTION(sum);
   }
 }  /* OUTPUT_FORWARD_PASS */
 
@@ -1637,7 +1782,9 @@ void  UsfCasCor::OUTPUT_FORWARD_PASS ()
 /* Assume that values vector has been set up for units with index less
    than J.  Compute and record the value for unit J.
 */
-void  UsfCasCor::COMPUTE_UNIT_VALUE (int j)
+void  UsfCasCor::COMPUTE_UNIT_VALUE (int    j,
+                                     float  values[]
+                                    )
 {
   int   i;
   int   *c;		/* pointer to unit's connections array */
@@ -1649,13 +1796,13 @@ void  UsfCasCor::COMPUTE_UNIT_VALUE (int j)
   w = Weights[j];
 
   for  (i = 0;  i < Nconnections[j];  i++)
-    sum += Values[c[i]] * w[i];
+    sum += values[c[i]] * w[i];
 
 #ifdef CONNX
     conx += Nconnections[j];
 #endif
 
-  Values[j] = ACTIVATION (sum);
+  values[j] = ACTIVATION (sum);
 }  /* COMPUTE_UNIT_VALUE */
 
 
@@ -1664,20 +1811,23 @@ void  UsfCasCor::COMPUTE_UNIT_VALUE (int j)
 /* Set up the inputs from the INPUT vector, then propagate activation values
    forward through all hidden units and output units.
 */
-void  UsfCasCor::FULL_FORWARD_PASS (float input[])
+void  UsfCasCor::FULL_FORWARD_PASS (float  input[],
+                                    float  values[],
+                                    float  outputs[]
+                                   )
 {
   int j;
   /********/
 
-  SETUP_INPUTS (input);
+  SETUP_INPUTS (input, values);
 
   /* Unit values must be calculated in order because the activations */
   /* cascade down through the hidden layers */
 
   for  (j = 1 + Ninputs;  j < Nunits;  j++) /* For each hidden unit J, compute the */
-    COMPUTE_UNIT_VALUE (j);	                /* activation value.                   */
+    COMPUTE_UNIT_VALUE (j, values);         /* activation value.                   */
 
-  OUTPUT_FORWARD_PASS ();	/* Now compute outputs. */
+  OUTPUT_FORWARD_PASS (values, outputs);	/* Now compute outputs. */
 }  /* FULL_FORWARD_PASS */
 
 
@@ -1687,12 +1837,16 @@ void  UsfCasCor::FULL_FORWARD_PASS (float input[])
  *  record the output errors for the current training case.  Record error
  *  values and related statistics.  If output_slopesp is TRUE, then use errors
  *  to compute slopes for output weights.  If statsp is TRUE, accumulate error
- *  statistics. 
+ *  statistics.  Statistics and slopes are accumulated in 'shard'.
  */
-void  UsfCasCor::COMPUTE_ERRORS (float    goal[], 
-                                 Boolean  output_slopesp, 
-                                 Boolean  statsp, 
-                                 int      xw
+void  UsfCasCor::COMPUTE_ERRORS (CaseShard&    shard,
+                                 float         goal[], 
+                                 const float   values[],
+                                 const float   outputs[],
+                                 float         errors[],
+                                 Boolean       output_slopesp, 
+                                 Boolean       statsp, 
+                                 int           xw
                                 )
 {
   int     i;
@@ -1710,7 +1864,7 @@ void  UsfCasCor::COMPUTE_ERRORS (float    goal[],
 
   for  (i = 1;  i < Noutputs;  i++)
   {
-    if ( Outputs[output_winner] < Outputs[i]) 
+    if ( outputs[output_winner] < outputs[i]) 
       output_winner=i;
 
     if ( goal[goal_winner] < goal[i] )
@@ -1718,33 +1872,33 @@ void  UsfCasCor::COMPUTE_ERRORS (float    goal[],
   }
 
   if  (goal_winner != output_winner) 
-    ErrorMisclassifications++;
+    shard.errorMisclassifications++;
 
   for  (j = 0;  j < Noutputs;  j++)
   {
-    out = Outputs[j];
+    out = outputs[j];
     dif = out - goal[j];
     if  (load_weights  &&  xw >= 0  &&  example_weight[xw] != 1.0 ) 
       dif *= example_weight[xw];
 
     err_prime = dif * OUTPUT_PRIME(out);
-    os = OutputSlopes[j];
+    os = shard.slopes.DataNotConst ()[j];
 
-    Errors[j] = err_prime;
+    errors[j] = err_prime;
 
     if  (statsp)
     {
       if  (fabs(dif) > ScoreThreshold)
-        ErrorBits++;
-      TrueError += dif * dif;
-      SumErrors[j] += err_prime;
-      SumSqError += err_prime * err_prime;
+        shard.errorBits++;
+      shard.trueError += dif * dif;
+      shard.sumErrors[j] += err_prime;
+      shard.sumSqError += err_prime * err_prime;
     }
 
     if  (output_slopesp)
     {
       for  (i = 0;  i < Nunits;  i++)
-        os[i] += err_prime * Values[i];
+        os[i] += err_prime * values[i];
     }
   }				/* end for unit j */
 
@@ -1767,10 +1921,10 @@ void  UsfCasCor::UPDATE_OUTPUT_WEIGHTS ()
   for  (j = 0;  j < Noutputs;  j++)
     for  (i = 0;  i < Nunits;  i++)
       QUICKPROP_UPDATE (i, 
-                        OutputWeights[j], 
-                        OutputDeltas[j],
-                        OutputSlopes[j], 
-                        OutputPrevSlopes[j], 
+                        OutputWeights.DataNotConst    ()[j], 
+                        OutputDeltas.DataNotConst     ()[j],
+                        OutputSlopes.DataNotConst     ()[j], 
+                        OutputPrevSlopes.DataNotConst ()[j], 
                         eps,
                         OutputDecay, 
                         OutputMu, 
@@ -1791,44 +1945,50 @@ void  UsfCasCor::UPDATE_OUTPUT_WEIGHTS ()
 
 /* Perform forward propagation once for each set of weights in the
  * training vectors, computing errors and slopes.  Then update the output
- * weights.
+ * weights.  The shards of training cases are processed concurrently and
+ * their error accumulators and slopes summed afterwards.
  */
 void  UsfCasCor::TRAIN_OUTPUTS_EPOCH ()
 {
-  int i;
-/********/
-
-  /* zero error accumulators */
-  ErrorBits = 0;
-  TrueError = 0.0;
-  ErrorMisclassifications = 0;
-  for  (i = 0;  i < Noutputs;  i++)
-  {
-    SumErrors[i] = 0.0;
-  }
-  SumSqError = 0.0;
-
   /* User may have changed mu between epochs, so fix shrink-factor. */
   OutputShrinkFactor = OutputMu / (1.0f + OutputMu);
 
-  for  (i= FirstCase; i < (FirstCase+Ncases); i++)
-  {
-    Goal = TrainingOutputs[i];
-
-    if  (UseCache)
+  pool->ParallelFor ((kkuint32)shards.size (), [this] (int x)
     {
-      Values = ValuesCache[i];
-      Errors = ErrorsCache[i];
-      OUTPUT_FORWARD_PASS();
-    }
-    else
-    {
-      Values = ExtraValues;
-      Errors = ExtraErrors;
-      FULL_FORWARD_PASS(TrainingInputs[i]);
+      CaseShard&  shard = shards[x];
+
+      /* zero error accumulators */
+      ZeroShardErrors (shard);
+      for  (int j = 0;  j < Noutputs;  j++)
+      {
+        float*  os = shard.slopes.DataNotConst ()[j];
+        for  (int i = 0;  i < Nunits;  i++)
+          os[i] = 0.0f;
+      }
+
+      for  (int i = shard.firstCase;  i < shard.endCase;  i++)
+      {
+        float*  values = NULL;
+        float*  errors = NULL;
+        if  (UseCache)
+        {
+          values = ValuesCache.DataNotConst ()[i];
+          errors = ErrorsCache.DataNotConst ()[i];
+          OUTPUT_FORWARD_PASS (values, shard.outputs.data ());
+        }
+        else
+        {
+          values = shard.values.data ();
+          errors = shard.errors.data ();
+          FULL_FORWARD_PASS (TrainingInputs[i], values, shard.outputs.data ());
+        }
+        COMPUTE_ERRORS (shard, TrainingOutputs[i], values, shard.outputs.data (), errors, true, true, i);
+      }
     }
-    COMPUTE_ERRORS (Goal, true, true, i);
-  }
+  );
+
+  SumShardErrors (true);
+  SumShardOutputSlopes ();
  
   switch (ErrorMeasure)
   {
@@ -1981,7 +2141,7 @@ void  UsfCasCor::INSTALL_NEW_UNIT (RunLog&  log)
   int i,o;
   float wm;			/* temporary weight multiplier */
   float *w;			/* temporary weight array */
-  float *cw;
+  const float *cw;
 /********/
 
   if  (Nunits >= MaxUnits)
@@ -1996,7 +2156,7 @@ void  UsfCasCor::INSTALL_NEW_UNIT (RunLog&  log)
   Connections[Nunits] = AllConnections;
   /* Set up the weight vector for the new unit. */
   w =  new float[Nunits];
-  cw = CandWeights[BestCandidate];
+  cw = CandWeights.Data ()[BestCandidate];
   for  (i = 0;  i < Nunits;  i++)
     w[i] = cw[i];
   Weights[Nunits] = w;
@@ -2019,11 +2179,14 @@ void  UsfCasCor::INSTALL_NEW_UNIT (RunLog&  log)
 
   /* If using cache, run an epoch to compute this unit's values.        */
   if  (UseCache)
-    for  (i = 0;  i < NTrainingPatterns;  i++)
-    {
-      Values = ValuesCache[i];
-      COMPUTE_UNIT_VALUE(Nunits);
-    }
+  {
+    pool->ParallelFor ((kkuint32)shards.size (), [this] (int x)
+      {
+        for  (int i = shards[x].firstCase;  i < shards[x].endCase;  i++)
+          COMPUTE_UNIT_VALUE (Nunits, ValuesCache.DataNotConst ()[i]);
+      }
+    );
+  }
 
   /* Reinitialize candidate units with random weights.                  */
   Nunits++;
@@ -2057,30 +2220,37 @@ void  UsfCasCor::INSTALL_NEW_UNIT (RunLog&  log)
 /* For the current training pattern, compute the value of each candidate
  * unit and begin to compute the correlation between that unit's value and
  * the error at each output.  We have already done a forward-prop and
- * computed the error values for active units.
+ * computed the error values for active units.  The sums are accumulated
+ * in 'shard'.
  */
-void  UsfCasCor::COMPUTE_CORRELATIONS ()
+void  UsfCasCor::COMPUTE_CORRELATIONS (CaseShard&   shard,
+                                       const float  values[],
+                                       const float  errors[]
+                                      )
 {
   int i,o,u;
   float sum=0.0;
   float v=0.0;
+  const float *cw;
+  float *cc;
 /*********/
 
   for(u=0; u<Ncandidates; u++){
     sum = 0.0;
     v = 0.0;
+    cw = CandWeights.Data ()[u];
+    cc = shard.candCor.DataNotConst ()[u];
     /* Determine activation value of each candidate unit. */
     for(i=0; i<Nunits; i++)
-      sum += CandWeights[u][i] * Values[i];
+      sum += cw[i] * values[i];
 #ifdef CONNX
     conx += Nunits;
 #endif
     v = ACTIVATION(sum);
-    CandValues[u] = v;
-    CandSumValues[u] += v;
+    shard.candSumValues[u] += v;
     /* Accumulate value of each unit times error at each output. */
     for(o=0; o<Noutputs; o++)
-      CandCor[u][o] += v * Errors[o];
+      cc[o] += v * errors[o];
   }
 }  /* COMPUTE_CORRELATIONS */
 
@@ -2108,8 +2278,8 @@ void  UsfCasCor::ADJUST_CORRELATIONS ()
     avg_value = CandSumValues[u] / Ncases;
     cor = 0.0;
     score = 0.0;
-    cc = CandCor[u];
-    cpc = CandPrevCor[u];
+    cc = CandCor.DataNotConst ()[u];
+    cpc = CandPrevCor.DataNotConst ()[u];
     for(o=0; o<Noutputs; o++)
     {
       cor = (cc[o] - avg_value * SumErrors[o]) / SumSqError;
@@ -2134,11 +2304,17 @@ void  UsfCasCor::ADJUST_CORRELATIONS ()
 
 /* After the correlations have been computed, we do a second pass over
  * the training set and adjust the input weights of all candidate units.
+ * The sums are accumulated in 'shard'.
  */
-void  UsfCasCor::COMPUTE_SLOPES ()
+void  UsfCasCor::COMPUTE_SLOPES (CaseShard&   shard,
+                                 const float  values[],
+                                 const float  errors[]
+                                )
 {
   int i,o,u;
   float sum, value, actprime, direction, error, change;
+  const float *cw, *cpc;
+  float *cc, *cs;
 /*********/
 
   for  (u=0; u<Ncandidates; u++)
@@ -2148,25 +2324,29 @@ void  UsfCasCor::COMPUTE_SLOPES ()
     actprime = 0.0;
     direction = 0.0;
     change = 0.0;
+    cw  = CandWeights.Data ()[u];
+    cpc = CandPrevCor.Data ()[u];
+    cc  = shard.candCor.DataNotConst ()[u];
+    cs  = shard.slopes.DataNotConst ()[u];
     /* Forward pass through each candidate unit to compute activation-prime. */
     for(i=0; i<Nunits; i++)
-      sum += CandWeights[u][i] * Values[i];
+      sum += cw[i] * values[i];
 #ifdef CONNX
     conx += Nunits;
 #endif
     value = ACTIVATION(sum);
     actprime = ACTIVATION_PRIME(value, sum);
-    CandSumValues[u] += value;
+    shard.candSumValues[u] += value;
     /* Now try to adjust the inputs so as to maximize the absolute value */
     /* of the correlation. */
     for(o=0; o<Noutputs; o++){
-      error = Errors[o];
-      direction = (CandPrevCor[u][o] < 0.0f) ? -1.0f : 1.0f;
+      error = errors[o];
+      direction = (cpc[o] < 0.0f) ? -1.0f : 1.0f;
       change -= direction * actprime *((error -SumErrors[o])/SumSqError);
-      CandCor[u][o] += error * value;
+      cc[o] += error * value;
     }
     for(i=0; i<Nunits; i++)
-       CandSlopes[u][i] += change * Values[i];
+       cs[i] += change * values[i];
   }
 }  /* COMPUTE_SLOPES */
 
@@ -2174,26 +2354,28 @@ void  UsfCasCor::COMPUTE_SLOPES ()
 
 
 /* Update the input weights, using the pre-computed slopes, prev-slopes,
- * and delta values.
+ * and delta values.  The candidates do not depend on each other so each
+ * one sums its slopes and correlations from the shards and is updated
+ * concurrently with the others.
  */
 void  UsfCasCor::UPDATE_INPUT_WEIGHTS ()
 {
-  int i,u;
   float eps;
-  float *cw, *cd, *cs, *cp;
 /*********/
 
   eps = InputEpsilon / (float)(Ncases * Nunits);
-  for(u=0; u<Ncandidates; u++)
-  {
-    cw = CandWeights[u];
-    cd = CandDeltas[u];
-    cs = CandSlopes[u];
-    cp = CandPrevSlopes[u];
-    for(i=0; i<Nunits; i++)
-      QUICKPROP_UPDATE(i, cw, cd, cs, cp, eps, InputDecay, InputMu, 
-		       InputShrinkFactor);
-  }
+  pool->ParallelFor ((kkuint32)Ncandidates, [this, eps] (int u)
+    {
+      SumShardCandidate (u, true);
+
+      float*  cw = CandWeights.DataNotConst    ()[u];
+      float*  cd = CandDeltas.DataNotConst     ()[u];
+      float*  cs = CandSlopes.DataNotConst     ()[u];
+      float*  cp = CandPrevSlopes.DataNotConst ()[u];
+      for  (int i = 0;  i < Nunits;  i++)
+        QUICKPROP_UPDATE (i, cw, cd, cs, cp, eps, InputDecay, InputMu, InputShrinkFactor);
+    }
+  );
 }  /* UPDATE_INPUT_WEIGHTS */
 
 
@@ -2206,24 +2388,32 @@ void  UsfCasCor::UPDATE_INPUT_WEIGHTS ()
 
 void  UsfCasCor::TRAIN_INPUTS_EPOCH ()
 {
-  int i;
-/********/
+  pool->ParallelFor ((kkuint32)shards.size (), [this] (int x)
+    {
+      CaseShard&  shard = shards[x];
+      ZeroShardCandidates (shard, true);
 
-  for(i=FirstCase; i<(Ncases+FirstCase); i++)
-  {
-    Goal = TrainingOutputs[i];
-    if(UseCache){
-      Values = ValuesCache[i];
-      Errors = ErrorsCache[i];
+      for  (int i = shard.firstCase;  i < shard.endCase;  i++)
+      {
+        float*  values = NULL;
+        float*  errors = NULL;
+        if  (UseCache)
+        {
+          values = ValuesCache.DataNotConst ()[i];
+          errors = ErrorsCache.DataNotConst ()[i];
+        }
+        else
+        {
+          values = shard.values.data ();
+          errors = shard.errors.data ();
+          FULL_FORWARD_PASS (TrainingInputs[i], values, shard.outputs.data ());
+          COMPUTE_ERRORS (shard, TrainingOutputs[i], values, shard.outputs.data (), errors, false, false, i);
+        }
+        COMPUTE_SLOPES (shard, values, errors);
+      }
     }
-    else {
-      Values = ExtraValues;
-      Errors = ExtraErrors;
-      FULL_FORWARD_PASS(TrainingInputs[i]);
-      COMPUTE_ERRORS (Goal, false, false, i);
-     }
-    COMPUTE_SLOPES();
-  }
+  );
+
   /*  User may have changed mu between epochs, so fix shrink-factor.*/
   InputShrinkFactor = InputMu / (1.0f + InputMu);
 
@@ -2244,26 +2434,34 @@ void  UsfCasCor::TRAIN_INPUTS_EPOCH ()
  */
 void  UsfCasCor::CORRELATIONS_EPOCH ()
 {
-  int i;
-/********/
-
-  for  (i=FirstCase; i<(Ncases+FirstCase); i++)
-  {
-    Goal = TrainingOutputs[i];
-    if  (UseCache)
-    {
-      Values = ValuesCache[i];
-      Errors = ErrorsCache[i];
-    }
-    else 
+  pool->ParallelFor ((kkuint32)shards.size (), [this] (int x)
     {
-      Values = ExtraValues;
-      Errors = ExtraErrors;
-      FULL_FORWARD_PASS(TrainingInputs[i]);
-      COMPUTE_ERRORS(Goal, false, false, i);
+      CaseShard&  shard = shards[x];
+      ZeroShardCandidates (shard, false);
+
+      for  (int i = shard.firstCase;  i < shard.endCase;  i++)
+      {
+        float*  values = NULL;
+        float*  errors = NULL;
+        if  (UseCache)
+        {
+          values = ValuesCache.DataNotConst ()[i];
+          errors = ErrorsCache.DataNotConst ()[i];
+        }
+        else 
+        {
+          values = shard.values.data ();
+          errors = shard.errors.data ();
+          FULL_FORWARD_PASS (TrainingInputs[i], values, shard.outputs.data ());
+          COMPUTE_ERRORS (shard, TrainingOutputs[i], values, shard.outputs.data (), errors, false, false, i);
+        }
+        COMPUTE_CORRELATIONS (shard, values, errors);
+      }
     }
-    COMPUTE_CORRELATIONS();
-  }
+  );
+
+  pool->ParallelFor ((kkuint32)Ncandidates, [this] (int u) {SumShardCandidate (u, false);});
+
   /*  Fix up the correlation values for the next epoch. */
   ADJUST_CORRELATIONS();
   Epoch++;
@@ -2374,10 +2572,7 @@ int  UsfCasCor::TRAIN (int            outlimit,
 
   if  (UseCache)
     for(i=0; i<NTrainingPatterns; i++)
-    {
-      Values = ValuesCache[i];
-      SETUP_INPUTS(TrainingInputs[i]);
-    }
+      SETUP_INPUTS (TrainingInputs[i], ValuesCache.DataNotConst ()[i]);
 
   for  (r = 0;  (r < rounds)  &&  (!cancelFlag);  r++)
   {
@@ -2465,8 +2660,6 @@ void  UsfCasCor::TEST_EPOCH (double   test_threshold,
                              RunLog&  log
                             )
 {
-  int i;
-
   /* Globals must be saved from the last training phase. If they are not  */
   /* saved then the next unit will be training to correlate with the test */
   /* set error. */
@@ -2482,8 +2675,6 @@ void  UsfCasCor::TEST_EPOCH (double   test_threshold,
   ScoreThreshold = (float)test_threshold;
   UseCache = false;
 
-  Values = ExtraValues;
-  Errors = ExtraErrors;
   /* If no separate test inputs, use training inputs. */
   //if  (NTestPatterns == 0)
   //{
@@ -2492,20 +2683,22 @@ void  UsfCasCor::TEST_EPOCH (double   test_threshold,
   //  NTestPatterns = NTrainingPatterns;
   //}
 
-  /* Zero some accumulators. */
-  ErrorBits = 0;
-  ErrorMisclassifications=0;
-  TrueError = 0.0;
-  SumErrors = DummySumErrors;
-  SumSqError = 0.0;
+  /* Now run all test patterns and report the results;  the shards cover */
+  /* all of the training patterns.                                        */
+  pool->ParallelFor ((kkuint32)shards.size (), [this] (int x)
+    {
+      CaseShard&  shard = shards[x];
+      ZeroShardErrors (shard);
+      for  (int i = shard.firstCase;  i < shard.endCase;  i++)
+      {
+        FULL_FORWARD_PASS (TrainingInputs[i], shard.values.data (), shard.outputs.data ());
+        COMPUTE_ERRORS (shard, TrainingOutputs[i], shard.values.data (), shard.outputs.data (), shard.errors.data (), false, true, -1);
+      }
+    }
+  );
 
-  /* Now run all test patterns and report the results. */
-  for  (i = 0; i < NTrainingPatterns;  ++i)
-  {
-    Goal = TrainingOutputs[i];
-    FULL_FORWARD_PASS (TrainingInputs[i]);
-    COMPUTE_ERRORS (Goal, false, true, -1);
-  } 
+  /* SumErrors and SumSqError are left alone. */
+  SumShardErrors (false);
 
   if  (ErrorMeasure == INDEX)
     ErrorIndex = ERROR_INDEX (TestStdDev, NtestOutputValues);
@@ -2815,6 +3008,28 @@ void  UsfCasCor::_load_test_data (FeatureVectorPtr  example)
 
 
 
+VectorFloat  UsfCasCor::NetworkWeights ()  const
+{
+  VectorFloat  weights;
+  if  (Weights  &&  Nconnections)
+  {
+    for  (int u = 0;  u < Nunits;  ++u)
+    {
+      if  (Weights[u])
+        weights.insert (weights.end (), Weights[u], Weights[u] + Nconnections[u]);
+    }
+  }
+
+  for  (kkuint32 row = 0;  row < OutputWeights.NumOfRows ();  ++row)
+  {
+    const float*  rowData = OutputWeights.Data ()[row];
+    weights.insert (weights.end (), rowData, rowData + OutputWeights.NumOfCols ());
+  }
+  return  weights;
+}  /* NetworkWeights */
+
+
+
 void  UsfCasCor::WriteXML (const KKStr&  varName,
                            ostream&      o
                           )  const
@@ -2928,8 +3143,8 @@ void  UsfCasCor::WriteXML (const KKStr&  varName,
   if  (ExtraValues)    XmlElementArrayFloat::WriteXML (MaxUnits, ExtraValues, "ExtraValues", o);
   if  (Outputs)        XmlElementArrayFloat::WriteXML (Noutputs, Outputs,     "Outputs",     o);
 
-  if  (OutputWeights)
-    XmlElementArrayFloat2D::WriteXML (Noutputs, MaxUnits, OutputWeights, "OutputWeights", o);
+  if  (OutputWeights.NumOfRows () > 0)
+    XmlElementArrayFloat2D::WriteXML (Noutputs, MaxUnits, const_cast<float**> (OutputWeights.Data ()), "OutputWeights", o);
 
   if  (ExtraErrors) XmlElementArrayFloat::WriteXML (Noutputs, ExtraErrors, "ExtraErrors", o);
 
@@ -2950,9 +3165,6 @@ void  UsfCasCor::ReadXML (XmlStream&      s,
   if  (Weights)
     Delete2DArray (Weights, MaxUnits);
 
-  if  (OutputWeights)
-    Delete2DArray (OutputWeights, Noutputs);
-
   XmlTokenPtr  t = s.GetNextToken (cancelFlag, log);
   while  (t  &&  (!cancelFlag))
   {
@@ -3169,8 +3381,11 @@ void  UsfCasCor::ReadXML (XmlStream&      s,
         }
         else
         {
-          delete  OutputWeights;
-          OutputWeights = array2D->TakeOwnership ();
+          OutputWeights.ReSize (owHeight, owWidth);
+          float**  ow = OutputWeights.DataNotConst ();
+          for  (kkint32 row = 0;  row < owHeight;  ++row)
+            for  (kkint32 col = 0;  col < owWidth;  ++col)
+              ow[row][col] = array2D->Value ()[row][col];
         }
       }
     }
@@ -3221,26 +3436,18 @@ void  UsfCasCor::ReadXML (XmlStream&      s,
         * command line, then Cache was not allocated. We look for NULL
         * value and allocate storage here. 
         */
-       if  (ValuesCache == NULL )
+       if  (ValuesCache.NumOfRows () < (kkuint32)MaxCases)
        {
-         ValuesCache = new float*[MaxCases];     //(float **)CALLOC(MaxCases, sizeof(float *));
-         ErrorsCache = new float*[MaxCases];
-
-         for  (kkint32 i = 0;  i < MaxCases;  i++)
-         {
-           ValuesCache[i] = new float[MaxUnits];
-           ErrorsCache[i] = new float[Noutputs];
-         }
+         ValuesCache.ReSize (MaxCases, MaxUnits);
+         ErrorsCache.ReSize (MaxCases, Noutputs);
        }
 
       for  (kkint32 i = 0;  i < NTrainingPatterns;  i++)
       {
-        Values = ValuesCache[i];
-      
         /* Unit values must be calculated in order because the activations */
         /* cascade down through the hidden layers */
         for  (kkint32 j = 1 + Ninputs;  j < Nunits;  j++) 
-           COMPUTE_UNIT_VALUE(j);
+           COMPUTE_UNIT_VALUE (j, ValuesCache.DataNotConst ()[i]);
       }
     }
   }
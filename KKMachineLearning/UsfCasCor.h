@@ -251,9 +251,18 @@ typedef  bool  Boolean;
 #endif
 
 #include "KKBaseTypes.h"
+#include "Matrix.h"
 #include "RunLog.h"
 #include "XmlStream.h"
 
+#if  !defined(_KKThreadPool_Defined_)
+namespace KKB
+{
+  class  KKThreadPool;
+  typedef  KKThreadPool*  KKThreadPoolPtr;
+}
+#endif
+
 #include "MLClass.h"
 #include "FeatureVector.h"
 
@@ -291,12 +300,18 @@ namespace KKMLL
     kkMemSize  MemoryConsumedEstimated ()  const;
 
 
+    /**
+     *@param[in]  _numThreads  Number of threads that share the passes over the training examples;  1 = serial,
+     *            0 = one per processor.  The network trained for a given '_the_random_seed' is the same
+     *            regardless of the number of threads.
+     */
     void  TrainNewClassifier (kkint32                 _in_limit,
                               kkint32                 _out_limit,
                               kkint32                 _number_of_rounds,
                               kkint32                 _number_of_trials,
                               kkint64                 _the_random_seed,
                               bool                    _useCache,
+                              kkuint32                _numThreads,
                               FeatureVectorListPtr    _trainData,
                               FeatureNumListConstPtr  _selectedFeatures,
                               VolConstBool&           _cancelFlag,
@@ -320,6 +335,13 @@ namespace KKMLL
     ClassProbListPtr  PredictClassConfidences (FeatureVectorPtr  example);
 
 
+    /**
+     *@brief  Weights of the network;  the incoming weights of each unit in unit order followed by the output weights,
+     * one row of 'MaxUnits' per output.  Empty before the network has been trained or read.
+     */
+    VectorFloat  NetworkWeights ()  const;
+
+
     void  WriteXML (const KKStr&  varName,
                     ostream&      o
                    )  const;
@@ -364,6 +386,58 @@ namespace KKMLL
     typedef parmentry PARMS;
 
 
+    /**
+     *@brief  Accumulators and scratch vectors for one block of consecutive training cases.
+     *@details  A pass over the training cases is made one shard at a time, possibly on several threads.  Each
+     * shard sums its errors, slopes and correlations separately and the shards are then added together in
+     * shard order;  this way the network trained does not depend on the number of threads.
+     */
+    struct  CaseShard
+    {
+      CaseShard (): firstCase (0), endCase (0), errorBits (0), errorMisclassifications (0), trueError (0.0f), sumSqError (0.0f)  {}
+
+      int          firstCase;
+      int          endCase;                  /**< One past the last case in this shard. */
+      int          errorBits;
+      int          errorMisclassifications;
+      float        trueError;
+      float        sumSqError;
+      VectorFloat  sumErrors;                /**< [Noutputs]    */
+      VectorFloat  candSumValues;            /**< [Ncandidates] */
+      MatrixF      candCor;                  /**< [Ncandidates][Noutputs] */
+      MatrixF      slopes;                   /**< Output slopes [Noutputs][MaxUnits] or candidate slopes [Ncandidates][MaxUnits]. */
+      VectorFloat  values;                   /**< Unit values of the current case when the cache is not in use. */
+      VectorFloat  outputs;
+      VectorFloat  errors;                   /**< Errors of the current case when the cache is not in use. */
+    };
+
+    static  const int  CaseShardSize;        /**< Number of training cases in each shard. */
+
+    void  AllocateShards ();
+
+    /** @brief  Zeros the error statistics of 'shard'. */
+    void  ZeroShardErrors (CaseShard&  shard);
+
+    /** @brief  Zeros the candidate correlations, summed values and, if 'slopes' is true, the candidate slopes of 'shard'. */
+    void  ZeroShardCandidates (CaseShard&  shard,
+                               bool        slopes
+                              );
+
+    /**
+     *@brief  Sums the error statistics of all the shards in shard order into ErrorBits, ErrorMisclassifications, TrueError
+     * and, if 'sumErrors' is true, SumErrors and SumSqError.
+     */
+    void  SumShardErrors (bool  sumErrors);
+
+    /** @brief  Adds the output slopes of all the shards, in shard order, to OutputSlopes. */
+    void  SumShardOutputSlopes ();
+
+    /** @brief  Adds the correlations, summed values and, if 'slopes' is true, the slopes of candidate 'u' from all the shards. */
+    void  SumShardCandidate (int   u,
+                             bool  slopes
+                            );
+
+
     FeatureVectorListPtr  FilterOutExtremeExamples (FeatureVectorListPtr  trainExamples);
 
 
@@ -462,19 +536,32 @@ namespace KKMLL
                             float shrink_factor
                            );
     
-    void  SETUP_INPUTS (float inputs[]);
+    void  SETUP_INPUTS (float  inputs[],
+                        float  values[]
+                       );
 
-    void  OUTPUT_FORWARD_PASS ();
+    void  OUTPUT_FORWARD_PASS (const float  values[],
+                               float        outputs[]
+                              );
 
-    void  COMPUTE_UNIT_VALUE (int j);
+    void  COMPUTE_UNIT_VALUE (int    j,
+                              float  values[]
+                             );
 
-    void  FULL_FORWARD_PASS (float input[]);
+    void  FULL_FORWARD_PASS (float  input[],
+                             float  values[],
+                             float  outputs[]
+                            );
 
 
-    void  COMPUTE_ERRORS (float    goal[], 
-                          Boolean  output_slopesp, 
-                          Boolean  statsp, 
-                          int      xw
+    void  COMPUTE_ERRORS (CaseShard&    shard,
+                          float         goal[], 
+                          const float   values[],
+                          const float   outputs[],
+                          float         errors[],
+                          Boolean       output_slopesp, 
+                          Boolean       statsp, 
+                          int           xw
                          );
 
     void  UPDATE_OUTPUT_WEIGHTS ();
@@ -490,11 +577,17 @@ namespace KKMLL
 
     void  INSTALL_NEW_UNIT (RunLog&  log);
 
-    void  COMPUTE_CORRELATIONS ();
+    void  COMPUTE_CORRELATIONS (CaseShard&   shard,
+                                const float  values[],
+                                const float  errors[]
+                               );
 
     void ADJUST_CORRELATIONS ();
 
-    void  COMPUTE_SLOPES ();
+    void  COMPUTE_SLOPES (CaseShard&   shard,
+                          const float  values[],
+                          const float  errors[]
+                         );
 
     void  UPDATE_INPUT_WEIGHTS ();
 
@@ -562,7 +655,8 @@ namespace KKMLL
     int      line_length;
     int*     feature_type;
 
-    kkint64  the_random_seed;
+    kkint64   the_random_seed;
+    kkuint64  randomSequence;   /**< State of the 'lrand48' style generator used by 'random_weight';  seeded from 'the_random_seed'. */
 
 
     /* Flags */
@@ -686,7 +780,7 @@ namespace KKMLL
     /* net and their input weights.                                            */
     /***************************************************************************/
     float*   Values;   	          /**< Current activation value for each unit */
-    float**  ValuesCache;         /**< Holds a distinct Values array for each of the MaxCases training cases. */
+    MatrixF  ValuesCache;         /**< Holds a distinct Values array for each of the MaxCases training cases. */
     float*   ExtraValues;	        /**< Extra Values vector to use when no cache. */
     int*     Nconnections;        /**< # of INCOMING connections per unit */
     int**    Connections;         /**< C[i][j] lists jth unit projecting to unit i */
@@ -698,12 +792,12 @@ namespace KKMLL
     /***************************************************************************/
     float*   Outputs;             /**< Network output values */
     float*   Errors;              /**< Final error value for each unit */
-    float**  ErrorsCache;         /**< Holds a distinct Errors array for each of the MaxCases training cases. */
+    MatrixF  ErrorsCache;         /**< Holds a distinct Errors array for each of the MaxCases training cases. */
     float*   ExtraErrors;         /**< Extra Errors vector to use when no cache. */
-    float**  OutputWeights;       /**< OW[i][j] holds the weight from hidden unit i to output unit j */
-    float**  OutputDeltas;        /**< Change between previous OW and current one */
-    float**  OutputSlopes;        /**< Partial derivative of TotalError wrt OW[i][j] */
-    float**  OutputPrevSlopes;    /**< Previous value of OutputSlopes[i][j] */
+    MatrixF  OutputWeights;       /**< OW[i][j] holds the weight from hidden unit i to output unit j */
+    MatrixF  OutputDeltas;        /**< Change between previous OW and current one */
+    MatrixF  OutputSlopes;        /**< Partial derivative of TotalError wrt OW[i][j] */
+    MatrixF  OutputPrevSlopes;    /**< Previous value of OutputSlopes[i][j] */
 
     /***************************************************************************/
     /* The following arrays have one entry for each candidate unit in the      */
@@ -711,12 +805,12 @@ namespace KKMLL
     /***************************************************************************/
     float*   CandValues;         /**< Current output value of each candidate unit.   */
     float*   CandSumValues;      /**< Output value of each candidate unit, summed over an entire training set. */
-    float**  CandCor;            /**< Correlation between unit & residual error at   each output, computed over a whole epoch.      */
-    float**  CandPrevCor;        /**< Holds the CandCor values from last epoch.      */
-    float**  CandWeights;        /**< Current input weights for each candidate unit. */
-    float**  CandDeltas;         /**< Input weights deltas for each candidate unit.  */
-    float**  CandSlopes;         /**< Input weights slopes for each candidate unit.  */
-    float**  CandPrevSlopes;     /**< Holds the previous values of CandSlopes.       */
+    MatrixF  CandCor;            /**< Correlation between unit & residual error at   each output, computed over a whole epoch.      */
+    MatrixF  CandPrevCor;        /**< Holds the CandCor values from last epoch.      */
+    MatrixF  CandWeights;        /**< Current input weights for each candidate unit. */
+    MatrixF  CandDeltas;         /**< Input weights deltas for each candidate unit.  */
+    MatrixF  CandSlopes;         /**< Input weights slopes for each candidate unit.  */
+    MatrixF  CandPrevSlopes;     /**< Holds the previous values of CandSlopes.       */
 
     /***************************************************************************/
     /* This saves memory if each candidate unit receives a connection from       */
@@ -743,6 +837,10 @@ namespace KKMLL
 
     Boolean  InterruptPending;         /**< TRUE => user has pressed Control-C */
 
+    kkuint32                numThreads;   /**< Threads that share the passes over the training cases;  0 = one per processor. */
+    KKThreadPoolPtr         pool;         /**< Only exists while training. */
+    std::vector<CaseShard>  shards;       /**< The training cases split into blocks of 'CaseShardSize' cases. */
+
     MLClassListPtr  classes;            /**<  Classes that the training data consisted of.  */
 
     FeatureNumListPtr  selectedFeatures;   /**< The selected features that are to be used from the source training data. */
@@ -8,14 +8,21 @@
 #include <stdarg.h>
 #include <vector>
 #include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include "MemoryDebug.h"
 using namespace std;
 
+#include "BinaryContainer.h"
 #include "GlobalGoalKeeper.h"
 #include "KKBaseTypes.h"
 #include "KKException.h"
 #include "KKStrParser.h"
+#include "KKThreadPool.h"
 #include "OSservices.h"
 using namespace KKB;
 
@@ -48,7 +55,6 @@ SvmModel233::SvmModel233 ()
   SV            = NULL;
   sv_coef       = NULL;
   rho           = NULL;
-  kValueTable   = NULL;
   nr_class      = 0;
   l             = -1;
   numNonSV      = -1;
@@ -56,7 +62,11 @@ SvmModel233::SvmModel233 ()
   dim           = -1;
   valid         = true;
   weOwnXspace   = false;
+  weOwnSvCoef   = true;
   xSpace        = NULL;
+  mappedContainer = NULL;
+  packedSVs     = NULL;
+  packedSVsMinNumCols = 0;
 }
 
 
@@ -79,23 +89,57 @@ kkMemSize  SvmModel233::MemoryConsumedEstimated ()  const
   if  (label)          memoryConsumedEstimated  += nr_class * sizeof (kkint32);
   if  (nSV)            memoryConsumedEstimated  += nr_class * sizeof (kkint32);
   if  (featureWeight)  memoryConsumedEstimated  += dim * sizeof (double);
-  if  (kValueTable)    memoryConsumedEstimated  += sizeof (double) * l;
   if  ((xSpace != NULL) &&  weOwnXspace)  
     memoryConsumedEstimated  += sizeof (svm_node) * l;
 
+  PackedDoubleVectorsPtr  p = packedSVs.load (std::memory_order_acquire);
+  if  (p)
+    memoryConsumedEstimated  += p->MemoryConsumedEstimated ();
+
   return  memoryConsumedEstimated;
 }
 
 
+const PackedDoubleVectors&  SvmModel233::PackedSVs ()  const
+{
+  PackedDoubleVectorsPtr  p = packedSVs.load (std::memory_order_acquire);
+  if  (p)
+    return  *p;
+
+  std::lock_guard<std::mutex>  lock (packedSVsMutex);
+  p = packedSVs.load (std::memory_order_relaxed);
+  if  (!p)
+  {
+    p = svm_PackNodes (SV, l, packedSVsMinNumCols);
+    packedSVs.store (p, std::memory_order_release);
+  }
+  return  *p;
+}  /* PackedSVs */
+
+
+
+void  SvmModel233::PackedSVsMinNumCols (kkint32  minNumCols)
+{
+  if  (minNumCols == packedSVsMinNumCols)
+    return;
+
+  packedSVsMinNumCols = minNumCols;
+  delete  packedSVs.exchange (NULL);
+}  /* PackedSVsMinNumCols */
+
+
+
 void  SvmModel233::Dispose ()
 {
+  delete  packedSVs.exchange (NULL);
+
   if  (weOwnXspace)
   {
     delete  xSpace;  
     xSpace = NULL;
   }
 
-  if  (sv_coef)
+  if  (sv_coef  &&  weOwnSvCoef)
   {
     for  (kkuint32 i = 0;  i < (nr_class - 1);  i++)
     {
@@ -104,8 +148,15 @@ void  SvmModel233::Dispose ()
     }
   }
 
+  if  (mappedContainer)
+  {
+    xSpace = NULL;
+    BinaryContainer::Release (mappedContainer);
+  }
+
   free (SV);       SV      = NULL;
   free (sv_coef);  sv_coef = NULL;
+  weOwnSvCoef = true;
   free (rho);      rho     = NULL;
   free (label);    label   = NULL;
   free (nSV);      nSV     = NULL;
@@ -120,11 +171,6 @@ void  SvmModel233::Dispose ()
   free (SVIndex);     SVIndex    = NULL;
   free (nonSVIndex);  nonSVIndex = NULL;
   delete[]  margin;   margin     = NULL;
-
-  if  (kValueTable)
-  {
-    delete[]  kValueTable;  kValueTable = NULL;
-  }
 }
 
 
@@ -201,8 +247,52 @@ void  SvmModel233::WriteXML (const KKStr&  varName,
     XmlElementInt32::WriteXML (totalNumOfElements, "totalNumOfElements", o);
   }
 
+  BinaryContainerWriterPtr  binWriter = BinaryContainerWriter::AttachedTo (o);
+  if  (binWriter)
+  {
+    // Support vectors go to the container as one block of 'svm_node' that 'ReadXML' can use in place.
+    if  (!exampleNames.empty ())
+      exampleNames.WriteXML ("exampleNames", o);
+
+    // The coefficients as one block of 'nr_class - 1' rows of 'l' doubles so that 'ReadXML' can point 'sv_coef' into it.
+    std::vector<double>  svCoefs;
+    svCoefs.reserve ((nr_class - 1) * totalNumSVs);
+    for  (kkuint32 j = 0;  j < nr_class - 1;  ++j)
+      svCoefs.insert (svCoefs.end (), sv_coef[j], sv_coef[j] + totalNumSVs);
+    binWriter->AddArray ("double", sizeof (double), svCoefs.size (), svCoefs.data ()).WriteXML ("SvCoefs", o);
+
+    kkint32  totalNumOfElements = 0;
+    for  (kkint32 i = 0;  i < totalNumSVs;  ++i)
+    {
+      for  (const svm_node* p = SV[i];  p->index != -1;  ++p)
+        ++totalNumOfElements;
+      ++totalNumOfElements;
+    }
+
+    // Zero filled so that the padding in 'svm_node' is written consistently.
+    std::vector<char>  nodeBuff (totalNumOfElements * sizeof (svm_node), 0);
+    svm_node*  nodes = reinterpret_cast<svm_node*> (nodeBuff.data ());
+    kkint32  nodeIdx = 0;
+    for  (kkint32 i = 0;  i < totalNumSVs;  ++i)
+    {
+      const svm_node*  p = SV[i];
+      while  (p->index != -1)
+      {
+        nodes[nodeIdx].index = p->index;
+        nodes[nodeIdx].value = p->value;
+        ++nodeIdx;
+        ++p;
+      }
+      nodes[nodeIdx].index = -1;
+      nodes[nodeIdx].value = 0.0;
+      ++nodeIdx;
+    }
+
+    binWriter->AddArray ("svm_node", sizeof (svm_node), totalNumOfElements, nodes).WriteXML ("SVNodes", o);
+  }
+
   // The Support Vector Information will be written in the Contents portion of SvmModel233
-  for  (kkint32 i = 0;  i < totalNumSVs;  i++)
+  for  (kkint32 i = 0;  (i < totalNumSVs)  &&  (!binWriter);  i++)
   {
     if  ((kkint32)exampleNames.size () > i)
       o << "SuportVectorNamed"  << "\t" << exampleNames[i];
@@ -251,6 +341,20 @@ void  SvmModel233::ReadXML (XmlStream&      s,
   delete  nSV;      nSV     = NULL;
   delete  label;    label   = NULL;
   delete  SV;       SV      = NULL;
+  delete  packedSVs.exchange (NULL);
+
+  if  (!weOwnSvCoef)
+  {
+    free (sv_coef);
+    sv_coef = NULL;
+    weOwnSvCoef = true;
+  }
+
+  if  (mappedContainer)
+  {
+    xSpace = NULL;
+    BinaryContainer::Release (mappedContainer);
+  }
 
   bool  errorsFound = false;
   valid = true;
@@ -388,14 +492,99 @@ void  SvmModel233::ReadXML (XmlStream&      s,
           kkint32 m = nr_class - 1;
           // kint32 l = model->l;
         
-          delete  sv_coef;
-          sv_coef = new double*[l];
+          free (sv_coef);
+          sv_coef = (double**)malloc (m * sizeof (double*));
           for (kkint32 i = 0;  i < m;  i++)
-            sv_coef[i] = new double[l];
+            sv_coef[i] = (double*)malloc (l * sizeof (double));
 
           SV = new svm_node*[l];
-          xSpace = new svm_node[totalNumOfElements];
-          weOwnXspace = true;
+        }
+      }
+
+      else if  (varName.EqualIgnoreCase ("exampleNames")  &&  (typeid (*e) == typeid (XmlElementVectorKKStr)))
+      {
+        const VectorKKStr*  names = dynamic_cast<XmlElementVectorKKStrPtr> (e)->Value ();
+        exampleNames.assign (names->begin (), names->end ());
+      }
+
+      else if  (varName.EqualIgnoreCase ("SvCoefs")  &&  (typeid (*e) == typeid (XmlElementKKStr)))
+      {
+        // Coefficients are used in place from the memory mapped container, the same as 'SVNodes'.
+        BinaryContainerConstPtr  container = s.Container ();
+        const BinaryContainer::SectionEntry*  section = NULL;
+        if  (container)
+          section = container->LookUp (*(dynamic_cast<XmlElementKKStrPtr> (e)->Value ()));
+
+        if  ((!section)  ||  (!sv_coef)  ||  (!weOwnSvCoef)  ||  (section->elementSize != sizeof (double))  ||
+             (section->count != (kkuint64)(nr_class - 1) * (kkuint64)l)
+            )
+        {
+          log.Level (-1) << endl
+            << "SvmModel233::ReadXML   ***ERROR***   'SvCoefs' section missing or does not match 'nr_class' and 'totalNumSVs'." << endl
+            << endl;
+          errorsFound = true;
+        }
+        else
+        {
+          if  (!mappedContainer)
+          {
+            container->Reference ();
+            mappedContainer = container;
+          }
+
+          double*  svCoefs = const_cast<double*> (static_cast<const double*> (container->SectionData (*section)));
+          for  (kkuint32 j = 0;  j < nr_class - 1;  ++j)
+          {
+            free (sv_coef[j]);
+            sv_coef[j] = svCoefs + j * l;
+          }
+          weOwnSvCoef = false;
+        }
+      }
+
+      else if  (varName.EqualIgnoreCase ("SVNodes")  &&  (typeid (*e) == typeid (XmlElementKKStr)))
+      {
+        // Support vectors are used in place from the memory mapped container.
+        BinaryContainerConstPtr  container = s.Container ();
+        const BinaryContainer::SectionEntry*  section = NULL;
+        if  (container)
+          section = container->LookUp (*(dynamic_cast<XmlElementKKStrPtr> (e)->Value ()));
+
+        if  ((!section)  ||  (!SV)  ||  (section->elementSize != sizeof (svm_node))  ||  (section->count != (kkuint64)totalNumOfElements))
+        {
+          log.Level (-1) << endl
+            << "SvmModel233::ReadXML   ***ERROR***   'SVNodes' section missing or does not match 'totalNumOfElements'." << endl
+            << endl;
+          errorsFound = true;
+        }
+        else
+        {
+          if  (!mappedContainer)
+          {
+            container->Reference ();
+            mappedContainer = container;
+          }
+          xSpace = const_cast<svm_node*> (static_cast<const svm_node*> (container->SectionData (*section)));
+          weOwnXspace = false;
+
+          numElementsLoaded = 0;
+          numSVsLoaded = 0;
+          while  ((numSVsLoaded < totalNumSVs)  &&  (numElementsLoaded < totalNumOfElements))
+          {
+            SV[numSVsLoaded] = &(xSpace[numElementsLoaded]);
+            while  ((numElementsLoaded < totalNumOfElements)  &&  (xSpace[numElementsLoaded].index != -1))
+              ++numElementsLoaded;
+            ++numElementsLoaded;
+            ++numSVsLoaded;
+          }
+
+          if  (numElementsLoaded != totalNumOfElements)
+          {
+            log.Level (-1) << endl
+              << "SvmModel233::ReadXML   ***ERROR***   'SVNodes' does not hold " << totalNumSVs << " terminated support vectors." << endl
+              << endl;
+            errorsFound = true;
+          }
         }
       }
     }
@@ -427,6 +616,12 @@ void  SvmModel233::ReadXML (XmlStream&      s,
         errorsFound = true;
       }
 
+      else if  (!xSpace)
+      {
+        xSpace = new svm_node[totalNumOfElements];
+        weOwnXspace = true;
+      }
+
       if  (!errorsFound)
       {
         if  (lineName.EqualIgnoreCase ("SuportVectorNamed"))
@@ -484,10 +679,12 @@ void  SvmModel233::ReadXML (XmlStream&      s,
       errorsFound= true;
     }
 
-    else
+    else if  (mappedContainer  &&  weOwnSvCoef)
     {
-      delete  kValueTable;
-      kValueTable = new double[l];
+      log.Level (-1) << endl
+        << "SvmModel233::ReadXML   ***ERROR***   'SVNodes' came from the binary container but 'SvCoefs' did not." << endl
+        << endl;
+      errorsFound= true;
     }
   }
 
@@ -616,14 +813,18 @@ XmlFactoryMacro(SvmModel233)
                             double*                alpha, 
                             Solver::SolutionInfo*  si, 
                             double                 Cp, 
-                            double                 Cn
+                            double                 Cn,
+                            SharedKernelCachePtr   kernelCache = NULL,
+                            const kkint32*         cacheKeys = NULL
                            );
 
   static void  solve_c_svc (const svm_problem*     prob, 
                             const svm_parameter*   param,
                             double*                alpha, 
                             Solver::SolutionInfo*  si, 
-                            double*                C_
+                            double*                C_,
+                            SharedKernelCachePtr   kernelCache = NULL,
+                            const kkint32*         cacheKeys = NULL
                            );
 
   static void  solve_nu_svc (const svm_problem*    prob, 
@@ -658,14 +859,18 @@ XmlFactoryMacro(SvmModel233)
 
 
   decision_function  svm_train_one (const svm_problem*    prob, 
-                                    const svm_parameter*  param
+                                    const svm_parameter*  param,
+                                    SharedKernelCachePtr  kernelCache = NULL,
+                                    const kkint32*        cacheKeys = NULL
                                     );
 
   decision_function  svm_train_one (const svm_problem*    prob, 
                                     const svm_parameter*  param,
                                     double                Cp, 
                                     double                Cn, 
-                                    std::set<kkint32>&      BSVIndex
+                                    std::set<kkint32>&      BSVIndex,
+                                    SharedKernelCachePtr  kernelCache = NULL,
+                                    const kkint32*        cacheKeys = NULL
                                    );
 
 
@@ -1331,6 +1536,146 @@ svm_problem::~svm_problem ()
 
 
 
+struct  SVM233::SharedKernelCache::Row
+{
+  Row (kkint32  numKeys):
+      lruPos (),
+      users  (0),
+      values (numKeys, std::numeric_limits<float>::quiet_NaN ())
+  {}
+
+  std::mutex                    lock;     /**< Held by the thread the row was given to by 'AcquireRow'. */
+  std::list<kkint32>::iterator  lruPos;
+  kkint32                       users;
+  std::vector<float>            values;
+};
+
+
+
+SVM233::SharedKernelCache::SharedKernelCache (kkint32  _numKeys,
+                                              double   _cacheSizeMB
+                                             ):
+    cacheSizeBytes ((kkint64)(_cacheSizeMB * (1 << 20))),
+    evictions      (0),
+    hits           (0),
+    lock           (),
+    lru            (),
+    memoryUsed     (0),
+    misses         (0),
+    numKeys        (_numKeys),
+    rows           (_numKeys, NULL)
+{
+}
+
+
+
+SVM233::SharedKernelCache::~SharedKernelCache ()
+{
+  for  (auto row: rows)
+    delete  row;
+}
+
+
+
+kkint64  SVM233::SharedKernelCache::Evictions () const
+{
+  std::lock_guard<std::mutex>  guard (lock);
+  return  evictions;
+}
+
+
+
+kkint64  SVM233::SharedKernelCache::Hits () const
+{
+  std::lock_guard<std::mutex>  guard (lock);
+  return  hits;
+}
+
+
+
+kkint64  SVM233::SharedKernelCache::MemoryUsed () const
+{
+  std::lock_guard<std::mutex>  guard (lock);
+  return  memoryUsed;
+}
+
+
+
+kkint64  SVM233::SharedKernelCache::Misses () const
+{
+  std::lock_guard<std::mutex>  guard (lock);
+  return  misses;
+}
+
+
+
+float*  SVM233::SharedKernelCache::AcquireRow (kkint32  key)
+{
+  KKCheck ((key >= 0)  &&  (key < numKeys), "SharedKernelCache::AcquireRow   key: " << key << " out of range;  NumKeys: " << numKeys)
+
+  Row*  row = NULL;
+  {
+    std::lock_guard<std::mutex>  guard (lock);
+    row = rows[key];
+    if  (row)
+    {
+      lru.erase (row->lruPos);
+    }
+    else
+    {
+      row = new Row (numKeys);
+      rows[key] = row;
+      memoryUsed += (kkint64)sizeof (Row) + (kkint64)numKeys * (kkint64)sizeof (float);
+    }
+    row->lruPos = lru.insert (lru.end (), key);
+    ++(row->users);
+    EvictRows ();
+  }
+
+  row->lock.lock ();
+  return  &(row->values[0]);
+}  /* AcquireRow */
+
+
+
+void  SVM233::SharedKernelCache::ReleaseRow (kkint32  key,
+                                             kkint64  rowHits,
+                                             kkint64  rowMisses
+                                            )
+{
+  std::lock_guard<std::mutex>  guard (lock);
+  Row*  row = rows[key];
+  row->lock.unlock ();
+  --(row->users);
+  hits   += rowHits;
+  misses += rowMisses;
+  EvictRows ();
+}  /* ReleaseRow */
+
+
+
+/** @brief  Drops the least recently used rows that are not in use until within 'cacheSizeBytes';  'lock' must be held. */
+void  SVM233::SharedKernelCache::EvictRows ()
+{
+  auto  idx = lru.begin ();
+  while  ((memoryUsed > cacheSizeBytes)  &&  (idx != lru.end ()))
+  {
+    Row*  row = rows[*idx];
+    if  (row->users > 0)
+    {
+      ++idx;
+      continue;
+    }
+    rows[*idx] = NULL;
+    idx = lru.erase (idx);
+    memoryUsed -= (kkint64)sizeof (Row) + (kkint64)numKeys * (kkint64)sizeof (float);
+    ++evictions;
+    delete  row;
+  }
+}  /* EvictRows */
+
+
+
 //
 // Kernel Cache
 //
@@ -1526,6 +1871,7 @@ public:
   virtual void swap_index(kkint32 i, kkint32 j) const  // no so const...
   {
     Swap (x[i],x[j]);
+    if  (packedIdx)  Swap (packedIdx[i], packedIdx[j]);
     if(x_square) Swap(x_square[i],x_square[j]);
   }
 
@@ -1533,10 +1879,36 @@ protected:
 
   double (Kernel::*kernel_function)(kkint32 i, kkint32 j) const;
 
+  /**
+   *@brief  Computes the kernel of example 'i' against examples 'start' thru 'len - 1' in one pass.
+   *@details  When the examples are packed, 'param.dimSelect' not > 0, KernelEngine evaluates the whole row at
+   * once;  'results[j - start]' is set to the same value 'kernel_function (i, j)' returns, to within the tolerance
+   * documented in KernelEngine.h.
+   */
+  void  KernelRow (kkint32  i,
+                   kkint32  start,
+                   kkint32  len,
+                   double*  results
+                  )  const;
+
+  /**
+   *@brief  Same as 'KernelRow' for the 'count' examples listed in 'js';  'results[k]' is the kernel of 'i' and 'js[k]'.
+   *@details  Gives exactly the values 'KernelRow' does for the same pairs.
+   */
+  void  KernelValues (kkint32         i,
+                      const kkint32*  js,
+                      kkint32         count,
+                      double*         results
+                     )  const;
+
 private:
   const svm_node **x;
   double*        x_square;
 
+  PackedDoubleVectorsPtr  packed;     /**< 'x' packed for KernelEngine;  NULL for subspace kernels.  Rows are never moved. */
+  kkint32*                packedIdx;  /**< packedIdx[i] = row in 'packed' of example currently at index 'i'.           */
+  kkint32*                packedWork; /**< Rows in 'packed' of the examples given to 'KernelValues'.                  */
+
   // svm_parameter
   const kkint32 kernel_type;
   const double degree;
@@ -1549,9 +1921,14 @@ private:
   static double dot(const svm_node *px, const svm_node *py);
   static double dotSubspace(const svm_node *px, const svm_node *py, const double *featureWeight);
 
+  double packedDot (kkint32 i, kkint32 j) const
+  {
+    return  KernelEngine::Dot (packed->Row (packedIdx[i]), packed->Row (packedIdx[j]), packed->Stride ());
+  }
+
   double kernel_linear (kkint32 i, kkint32 j) const
   {
-    return dot(x[i],x[j]);
+    return packedDot (i, j);
   }
   double kernel_linear_subspace(kkint32 i, kkint32 j) const
   {
@@ -1559,7 +1936,7 @@ private:
   }
   double kernel_poly (kkint32 i, kkint32 j) const
   {
-    return pow(gamma*dot(x[i],x[j])+coef0,degree);
+    return pow(gamma*packedDot(i,j)+coef0,degree);
   }
   double kernel_poly_subspace(kkint32 i, kkint32 j) const
   {
@@ -1567,7 +1944,7 @@ private:
   }
   double kernel_rbf (kkint32 i, kkint32 j) const
   {
-    return exp(-gamma*(x_square[i]+x_square[j]-2*dot(x[i],x[j])));
+    return exp(-gamma*(x_square[i]+x_square[j]-2*packedDot(i,j)));
   }
   double kernel_rbf_subspace(kkint32 i, kkint32 j) const
   {
@@ -1575,7 +1952,7 @@ private:
   }
   double kernel_sigmoid(kkint32 i, kkint32 j) const
   {
-    return tanh(gamma*dot(x[i],x[j])+coef0);
+    return tanh(gamma*packedDot(i,j)+coef0);
   }
   double kernel_sigmoid_subspace(kkint32 i, kkint32 j) const
   {
@@ -1590,6 +1967,10 @@ SVM233::Kernel::Kernel  (kkint32                 l,
                          const svm_parameter&  param
                         )
  :
+   x_square     (NULL),
+   packed       (NULL),
+   packedIdx    (NULL),
+   packedWork   (NULL),
    kernel_type  (param.kernel_type), 
    degree       (param.degree),
    gamma        (param.gamma), 
@@ -1637,6 +2018,15 @@ SVM233::Kernel::Kernel  (kkint32                 l,
 
   clone (x, x_,  l);
 
+  if  (param.dimSelect <= 0)
+  {
+    packed = svm_PackNodes (x, l);
+    packedIdx  = new kkint32[l];
+    packedWork = new kkint32[l];
+    for  (kkint32 i = 0;  i < l;  ++i)
+      packedIdx[i] = i;
+  }
+
   if  (kernel_type == RBF)
   {
     x_square = new double[l];
@@ -1645,7 +2035,7 @@ SVM233::Kernel::Kernel  (kkint32                 l,
       if(param.dimSelect > 0)
         x_square[i] = dotSubspace(x[i],x[i],featureWeight);
       else
-        x_square[i] = dot(x[i],x[i]);
+        x_square[i] = packed->SquaredNorm (i);
     }
   }
   else
@@ -1658,10 +2048,107 @@ SVM233::Kernel::~Kernel()
     delete[] featureWeight;
   delete[] x;
   delete[] x_square;
+  delete[] packedIdx;
+  delete[] packedWork;
+  delete   packed;
 }
 
 
 
+void  SVM233::Kernel::KernelRow (kkint32  i,
+                                 kkint32  start,
+                                 kkint32  len,
+                                 double*  results
+                                )  const
+{
+  kkint32  count = len - start;
+  if  (count <= 0)
+    return;
+
+  if  (!packed)
+  {
+    for  (kkint32 j = start;  j < len;  ++j)
+      results[j - start] = (this->*kernel_function)(i, j);
+    return;
+  }
+
+  KernelEngine::DotOneToMany (packed->Row (packedIdx[i]), *packed, packedIdx + start, count, results);
+
+  switch  (kernel_type)
+  {
+  case  POLY:
+    for  (kkint32 k = 0;  k < count;  ++k)
+      results[k] = pow (gamma * results[k] + coef0, degree);
+    break;
+
+  case  RBF:
+    {
+      double  xsi = x_square[i];
+      for  (kkint32 k = 0;  k < count;  ++k)
+        results[k] = exp (-gamma * (xsi + x_square[start + k] - 2 * results[k]));
+    }
+    break;
+
+  case  SIGMOID:
+    for  (kkint32 k = 0;  k < count;  ++k)
+      results[k] = tanh (gamma * results[k] + coef0);
+    break;
+
+  default:
+    break;
+  }
+}  /* KernelRow */
+
+
+
+void  SVM233::Kernel::KernelValues (kkint32         i,
+                                    const kkint32*  js,
+                                    kkint32         count,
+                                    double*         results
+                                   )  const
+{
+  if  (count <= 0)
+    return;
+
+  if  (!packed)
+  {
+    for  (kkint32 k = 0;  k < count;  ++k)
+      results[k] = (this->*kernel_function)(i, js[k]);
+    return;
+  }
+
+  for  (kkint32 k = 0;  k < count;  ++k)
+    packedWork[k] = packedIdx[js[k]];
+
+  KernelEngine::DotOneToMany (packed->Row (packedIdx[i]), *packed, packedWork, count, results);
+
+  switch  (kernel_type)
+  {
+  case  POLY:
+    for  (kkint32 k = 0;  k < count;  ++k)
+      results[k] = pow (gamma * results[k] + coef0, degree);
+    break;
+
+  case  RBF:
+    {
+      double  xsi = x_square[i];
+      for  (kkint32 k = 0;  k < count;  ++k)
+        results[k] = exp (-gamma * (xsi + x_square[js[k]] - 2 * results[k]));
+    }
+    break;
+
+  case  SIGMOID:
+    for  (kkint32 k = 0;  k < count;  ++k)
+      results[k] = tanh (gamma * results[k] + coef0);
+    break;
+
+  default:
+    break;
+  }
+}  /* KernelValues */
+
+
+
 double SVM233::Kernel::dot(const svm_node *px, const svm_node *py)
 {
   double sum = 0;
@@ -2623,14 +3110,31 @@ double SVM233::Solver_NU::calculate_rho ()
 class  SVM233::SVC_Q: public Kernel
 { 
 public:
+  /**
+   *@param[in]  _sharedCache  When not NULL kernel values missing from this problem's own cache are looked up here
+   *                          before being computed;  'cacheKeys' gives the key of each example.
+   */
   SVC_Q (const svm_problem&    prob,
          const svm_parameter&  param,
-         const schar *y_
+         const schar *y_,
+         SharedKernelCachePtr  _sharedCache = NULL,
+         const kkint32*        _cacheKeys = NULL
         )
-    :Kernel (prob.l, prob.x, param)
+    :Kernel (prob.l, prob.x, param),
+     missing     (NULL),
+     cacheKeys   (NULL),
+     sharedCache (_sharedCache)
   {
     clone(y,y_,prob.l);
     cache = new Cache(prob.l,(kkint32)(param.cache_size*(1<<20)));
+    kernelRow = new double[prob.l];
+    if  (sharedCache)
+    {
+      missing   = new kkint32[prob.l];
+      cacheKeys = new kkint32[prob.l];
+      for  (kkint32 k = 0;  k < prob.l;  ++k)
+        cacheKeys[k] = _cacheKeys ? _cacheKeys[k] : k;
+    }
   }
 
   Qfloat *get_Q(kkint32 i, kkint32 len) const
@@ -2639,9 +3143,35 @@ public:
     kkint32 start;
     if  ((start = cache->get_data (i, &data, len)) < len)
     {
-      for  (kkint32 j = start;  j < len;  j++)
-        data[j] = (Qfloat)(y[i] * y[j] * (this->*kernel_function)(i,j));
-      //luo add data[j] = (Qfloat)(w[i]*w[j]*y[i]*y[j]*(this->*kernel_function)(i,j));
+      if  (sharedCache)
+      {
+        // The values missing from the shared row are computed together by 'KernelValues',  the same way 'KernelRow'
+        // computes them without a shared cache.  The kernel is rounded to a Qfloat before the sign is applied;  same
+        // result as rounding afterwards.
+        float*  row = sharedCache->AcquireRow (cacheKeys[i]);
+        kkint32  misses = 0;
+        for  (kkint32 j = start;  j < len;  j++)
+        {
+          if  (std::isnan (row[cacheKeys[j]]))
+            missing[misses++] = j;
+        }
+
+        KernelValues (i, missing, misses, kernelRow);
+        for  (kkint32 k = 0;  k < misses;  ++k)
+          row[cacheKeys[missing[k]]] = (Qfloat)kernelRow[k];
+
+        for  (kkint32 j = start;  j < len;  j++)
+          data[j] = y[i] * y[j] * row[cacheKeys[j]];
+
+        sharedCache->ReleaseRow (cacheKeys[i], (len - start) - misses, misses);
+      }
+      else
+      {
+        KernelRow (i, start, len, kernelRow);
+        for  (kkint32 j = start;  j < len;  j++)
+          data[j] = (Qfloat)(y[i] * y[j] * kernelRow[j - start]);
+        //luo add data[j] = (Qfloat)(w[i]*w[j]*y[i]*y[j]*(this->*kernel_function)(i,j));
+      }
     }
     return data;
   }
@@ -2651,17 +3181,26 @@ public:
     cache->swap_index(i,j);
     Kernel::swap_index(i,j);
     Swap(y[i],y[j]);
+    if  (cacheKeys)
+      Swap (cacheKeys[i], cacheKeys[j]);
   }
 
   ~SVC_Q()
   {
     delete[] y;
+    delete[] missing;
+    delete[] cacheKeys;
+    delete[] kernelRow;
     delete cache;
   }
 
 private:
   schar *y;
   Cache *cache;
+  double*               kernelRow;     /**< Work area for 'KernelRow' and 'KernelValues'. */
+  kkint32*              missing;       /**< Examples whose kernel values are not in the shared row yet. */
+  kkint32*              cacheKeys;     /**< Key in 'sharedCache' of each example;  swapped along with them. */
+  SharedKernelCachePtr  sharedCache;
 };
 
 
@@ -2676,6 +3215,7 @@ public:
     :Kernel (prob.l, prob.x, param)
   {
     cache = new Cache(prob.l,(kkint32)(param.cache_size*(1<<20)));
+    kernelRow = new double[prob.l];
   }
 
   Qfloat *get_Q(kkint32 i, kkint32 len) const
@@ -2684,8 +3224,9 @@ public:
     kkint32 start;
     if((start = cache->get_data(i,&data,len)) < len)
     {
+      KernelRow (i, start, len, kernelRow);
       for(kkint32 j=start;j<len;j++)
-        data[j] = (Qfloat)(this->*kernel_function)(i,j);
+        data[j] = (Qfloat)kernelRow[j - start];
     }
     return data;
   }
@@ -2700,10 +3241,12 @@ public:
   ~ONE_CLASS_Q()
   {
     delete cache;
+    delete[] kernelRow;
   }
 
 private:
   Cache *cache;
+  double *kernelRow;   /**< Work area for 'KernelRow'. */
 };
 
 
@@ -2730,6 +3273,7 @@ public:
     buffer[0] = new Qfloat[2*l];
     buffer[1] = new Qfloat[2*l];
     next_buffer = 0;
+    kernelRow = new double[l];
   }
 
   void swap_index(kkint32 i, kkint32 j) const
@@ -2745,8 +3289,9 @@ public:
     kkint32 real_i = index[i];
     if(cache->get_data(real_i,&data,l) < l)
     {
+      KernelRow (real_i, 0, l, kernelRow);
       for(kkint32 j=0;j<l;j++)
-        data[j] = (Qfloat)(this->*kernel_function)(real_i,j);
+        data[j] = (Qfloat)kernelRow[j];
     }
 
     // reorder and copy
@@ -2765,6 +3310,7 @@ public:
     delete[] index;
     delete[] buffer[0];
     delete[] buffer[1];
+    delete[] kernelRow;
   }
 private:
   kkint32 l;
@@ -2773,6 +3319,7 @@ private:
   kkint32 *index;
   mutable kkint32 next_buffer;
   Qfloat* buffer[2];
+  double* kernelRow;   /**< Work area for 'KernelRow'. */
 };
 
 
@@ -2786,7 +3333,9 @@ static void  SVM233::solve_c_svc (const svm_problem*     prob,
                                   double*                alpha, 
                                   Solver::SolutionInfo*  si, 
                                   double                 Cp, 
-                                  double                 Cn
+                                  double                 Cn,
+                                  SharedKernelCachePtr   kernelCache,
+                                  const kkint32*         cacheKeys
                                  )
 {
   kkint32 l = prob->l;
@@ -2807,7 +3356,7 @@ static void  SVM233::solve_c_svc (const svm_problem*     prob,
 
   Solver s;
   s.Solve (l, 
-           SVC_Q(*prob,*param,y), 
+           SVC_Q(*prob,*param,y,kernelCache,cacheKeys), 
            minus_ones, 
            y,
            alpha, 
@@ -2838,7 +3387,9 @@ static void  SVM233::solve_c_svc (const svm_problem*     prob,
                                   const svm_parameter*   param,
                                   double*                alpha, 
                                   Solver::SolutionInfo*  si, 
-                                  double*                C_
+                                  double*                C_,
+                                  SharedKernelCachePtr   kernelCache,
+                                  const kkint32*         cacheKeys
                                  )
 {
   kkint32 l = prob->l;
@@ -2859,7 +3410,7 @@ static void  SVM233::solve_c_svc (const svm_problem*     prob,
 
   Solver s;
   s.Solve (l, 
-           SVC_Q (*prob, *param, y), 
+           SVC_Q (*prob, *param, y, kernelCache, cacheKeys), 
            minus_ones, 
            y,
            alpha, 
@@ -3079,7 +3630,9 @@ static void  SVM233::solve_nu_svr (const svm_problem*     prob,
 
 
 decision_function  SVM233::svm_train_one (const svm_problem*    prob, 
-                                          const svm_parameter*  param
+                                          const svm_parameter*  param,
+                                          SharedKernelCachePtr  kernelCache,
+                                          const kkint32*        cacheKeys
                                          )
 {
   double *alpha = Malloc(double,prob->l);
@@ -3087,7 +3640,7 @@ decision_function  SVM233::svm_train_one (const svm_problem*    prob,
   switch(param->svm_type)
   {
   case C_SVC:
-    solve_c_svc (prob, param, alpha, &si, prob->W);
+    solve_c_svc (prob, param, alpha, &si, prob->W, kernelCache, cacheKeys);
     break;
   }
 
@@ -3129,7 +3682,9 @@ decision_function  SVM233::svm_train_one (const svm_problem*    prob,
                                           const svm_parameter*  param,
                                           double                Cp, 
                                           double                Cn, 
-                                          std::set<kkint32>&        BSVIndex
+                                          std::set<kkint32>&        BSVIndex,
+                                          SharedKernelCachePtr  kernelCache,
+                                          const kkint32*        cacheKeys
                                          )
 {
   double *alpha = Malloc (double, prob->l);
@@ -3137,7 +3692,7 @@ decision_function  SVM233::svm_train_one (const svm_problem*    prob,
   switch(param->svm_type)
   {
   case C_SVC:
-    solve_c_svc (prob, param, alpha, &si, Cp, Cn);
+    solve_c_svc (prob, param, alpha, &si, Cp, Cn, kernelCache, cacheKeys);
     break;
 
   case NU_SVC:
@@ -3248,7 +3803,12 @@ decision_function  SVM233::svm_train_one (const svm_problem*    prob,
 //
 
 SvmModel233* SVM233::svm_train (const svm_problem*    prob,
-                                const svm_parameter*  param
+                                const svm_parameter*  param,
+                                kkuint32              numThreads,
+                                kkuint32              trainingMemoryMB,
+                                SharedKernelCachePtr  kernelCache,
+                                const kkint32*        cacheKeys,
+                                VolConstBool*         cancelFlag
                                )
 {
   //SvmModel233 *model = Malloc(SvmModel233,1);
@@ -3372,11 +3932,16 @@ SvmModel233* SVM233::svm_train (const svm_problem*    prob,
     if (prob->W != NULL)
       W = Malloc(double, l);
     std::vector<kkint32> reindex(l);
+    std::vector<kkint32> groupedKeys;
+    if  (kernelCache)
+      groupedKeys.resize (l);
 
     for  (i = 0;  i < l;  i++)
     {
       x[start[index[i]]] = prob->x[i];
       reindex[start[index[i]]] = prob->index[i];
+      if  (kernelCache)
+        groupedKeys[start[index[i]]] = cacheKeys ? cacheKeys[i] : i;
       if  (W != NULL)
         W[start[index[i]]] = prob->W[i];
       ++start[index[i]];
@@ -3406,19 +3971,38 @@ SvmModel233* SVM233::svm_train (const svm_problem*    prob,
         weighted_C[j] *= param->weight[i];
     }
 
-    // train n*(n-1)/2 models
+    // train n*(n-1)/2 models;  each one only depends on its own pair of classes so they can be trained in any
+    // order.  Each gets its own set of bounded support vectors which are merged once they are all done.
 
     bool *nonzero = Malloc(bool,l);
     for(i=0;i<l;i++)
       nonzero[i] = false;
 
-    decision_function *f = Malloc(decision_function,nr_class*(nr_class-1)/2);
+    kkint32  numPairs = nr_class * (nr_class - 1) / 2;
+    decision_function *f = Malloc(decision_function,numPairs);
+    for  (kkint32 p = 0;  p < numPairs;  ++p)
+      f[p].alpha = NULL;
 
-    kkint32 p = 0;
-    for(i=0;i<nr_class;i++)
+    std::vector<kkint32>  pairClass1;
+    std::vector<kkint32>  pairClass2;
+    std::vector<kkint32>  pairSizes;
+    for  (i = 0;  i < nr_class;  i++)
     {
-      for(kkint32 j=i+1;j<nr_class;j++)
+      for  (kkint32 j = i + 1;  j < nr_class;  j++)
       {
+        pairClass1.push_back (i);
+        pairClass2.push_back (j);
+        pairSizes.push_back  (count[i] + count[j]);
+      }
+    }
+
+    std::vector<std::set<kkint32> >  pairBSVIndex (numPairs);
+
+    kkint32  numPairsTrained = svm_train_scheduled (pairSizes, param->cache_size, numThreads, trainingMemoryMB, cancelFlag, [&](kkint32 p)
+      {
+        kkint32 i = pairClass1[p];
+        kkint32 j = pairClass2[p];
+
         svm_problem   sub_prob;
         //memset(&sub_prob, 0, sizeof(sub_prob));   // kak
 
@@ -3430,6 +4014,13 @@ SvmModel233* SVM233::svm_train (const svm_problem*    prob,
         if (W != NULL)
           sub_prob.W = Malloc(double, sub_prob.l);
         sub_prob.index = Malloc(kkint32, sub_prob.l);
+        std::vector<kkint32>  subKeys;
+        if  (kernelCache)
+        {
+          subKeys.insert (subKeys.end (), groupedKeys.begin () + si, groupedKeys.begin () + si + ci);
+          subKeys.insert (subKeys.end (), groupedKeys.begin () + sj, groupedKeys.begin () + sj + cj);
+        }
+        const kkint32*  subCacheKeys = kernelCache ? &subKeys[0] : NULL;
 
         kkint32 k;
         for(k=0;k<ci;k++)
@@ -3450,39 +4041,65 @@ SvmModel233* SVM233::svm_train (const svm_problem*    prob,
         }
 
         if (W != NULL)
-          f[p] = svm_train_one(&sub_prob, param);
+          f[p] = svm_train_one(&sub_prob, param, kernelCache, subCacheKeys);
         else
-          f[p] = svm_train_one(&sub_prob,param,weighted_C[i],weighted_C[j],model->BSVIndex);
+          f[p] = svm_train_one(&sub_prob,param,weighted_C[i],weighted_C[j],pairBSVIndex[p],kernelCache,subCacheKeys);
 
         //printf ("svm  Training Classes %d[%d] and %d[%d]\n",
         //  label[i], count[i],
         //  label[j], count[j]
         //  );
 
-          fflush (stdout);
+        fflush (stdout);
 
-          // KNS - I believe this line is what was causing the training time to double
-          //  f[p] = svm_train_one(&sub_prob,param,weighted_C[i],weighted_C[j],model->BSVIndex);
+        // KNS - I believe this line is what was causing the training time to double
+        //  f[p] = svm_train_one(&sub_prob,param,weighted_C[i],weighted_C[j],model->BSVIndex);
 
-          for  (k = 0;  k < ci;  k++)
-          {
-            if(!nonzero[si+k] && fabs(f[p].alpha[k]) > 0)
-              nonzero[si+k] = true;
-          }
+        free(sub_prob.x);
+        free(sub_prob.y);
+        if (sub_prob.W != NULL)
+          free(sub_prob.W);
+        free(sub_prob.index);
+      }
+    );
 
-          for  (k = 0;  k < cj;  k++)
-          {
-            if  (!nonzero[sj+k] && fabs(f[p].alpha[ci+k]) > 0)
-              nonzero[sj+k] = true;
-          }
+    if  (numPairsTrained < numPairs)
+    {
+      // Cancelled before every binary classifier started;  there is no complete model to build.
+      free(label);
+      free(count);
+      free(index);
+      free(start);
+      if (W != NULL)
+        free(W);
+      free(x);
+      free(weighted_C);
+      free(nonzero);
+      for  (kkint32 p = 0;  p < numPairs;  ++p)
+        free(f[p].alpha);
+      free(f);
+      svm_destroy_model (model);
+      return NULL;
+    }
+
+    for  (kkint32 p = 0;  p < numPairs;  ++p)
+    {
+      kkint32 si = start[pairClass1[p]], sj = start[pairClass2[p]];
+      kkint32 ci = count[pairClass1[p]], cj = count[pairClass2[p]];
+      kkint32 k;
+      for  (k = 0;  k < ci;  k++)
+      {
+        if(!nonzero[si+k] && fabs(f[p].alpha[k]) > 0)
+          nonzero[si+k] = true;
+      }
 
-          free(sub_prob.x);
-          free(sub_prob.y);
-          if (sub_prob.W != NULL)
-            free(sub_prob.W);
-          free(sub_prob.index);
-          ++p;
+      for  (k = 0;  k < cj;  k++)
+      {
+        if  (!nonzero[sj+k] && fabs(f[p].alpha[ci+k]) > 0)
+          nonzero[sj+k] = true;
       }
+
+      model->BSVIndex.insert (pairBSVIndex[p].begin (), pairBSVIndex[p].end ());
     }
     // build output
 
@@ -3538,7 +4155,7 @@ SvmModel233* SVM233::svm_train (const svm_problem*    prob,
     //model->rest=Malloc(svm_node *, model->numRest);
     //luo
 
-    p = 0;
+    kkint32 p = 0;
     for  (i = 0;  i < l;  i++)
     {
       if  (nonzero[i])
@@ -3631,8 +4248,6 @@ SvmModel233* SVM233::svm_train (const svm_problem*    prob,
 
     // KNS - this was commecnted out in the pre-BR svm
     // svm_margin(model);
-
-    model->kValueTable = new double[model->l];
   }
 
   //svm_margin (model);
@@ -3641,6 +4256,84 @@ SvmModel233* SVM233::svm_train (const svm_problem*    prob,
 
 
 
+kkint32  SVM233::svm_train_scheduled (const std::vector<kkint32>&    problemSizes,
+                                      double                         cacheSizeMB,
+                                      kkuint32                       numThreads,
+                                      kkuint32                       trainingMemoryMB,
+                                      VolConstBool*                  cancelFlag,
+                                      std::function<void (kkint32)>  train
+                                     )
+{
+  kkint32  numProblems = (kkint32)problemSizes.size ();
+  numThreads = Min (KKThreadPool::ResolveNumThreads (numThreads), (kkuint32)Max (numProblems, 1));
+
+  if  (numThreads <= 1)
+  {
+    kkint32  x = 0;
+    for  (x = 0;  (x < numProblems)  &&  !(cancelFlag  &&  *cancelFlag);  ++x)
+      train (x);
+    return  x;
+  }
+
+  std::vector<kkint32>  order (numProblems);
+  for  (kkint32 x = 0;  x < numProblems;  ++x)
+    order[x] = x;
+  std::stable_sort (order.begin (), order.end (), [&](kkint32 left, kkint32 right) {return problemSizes[left] > problemSizes[right];});
+
+  const kkMemSize  budget    = (kkMemSize)trainingMemoryMB << 20;
+  const kkMemSize  cacheSize = (kkMemSize)(cacheSizeMB * (1 << 20));
+
+  std::mutex               mutex;
+  std::condition_variable  memoryReleased;
+  kkMemSize                memoryInUse = 0;
+  std::atomic<kkint32>     numTrained (0);
+
+  KKThreadPool  pool ("svm_train_scheduled", numThreads);
+  for  (kkint32 problemIdx: order)
+  {
+    kkMemSize  l = (kkMemSize)problemSizes[problemIdx];
+    kkMemSize  memoryNeeded = Min (cacheSize, l * l * sizeof (Qfloat));
+
+    pool.AddTask ([&, problemIdx, memoryNeeded] ()
+      {
+        {
+          std::unique_lock<std::mutex>  lock (mutex);
+          memoryReleased.wait (lock, [&] () {return (budget == 0)  ||  (memoryInUse == 0)  ||  (memoryInUse + memoryNeeded <= budget);});
+          memoryInUse += memoryNeeded;
+        }
+
+        auto  release = [&] ()
+          {
+            {
+              std::lock_guard<std::mutex>  lock (mutex);
+              memoryInUse -= memoryNeeded;
+            }
+            memoryReleased.notify_all ();
+          };
+
+        try
+        {
+          if  (!(cancelFlag  &&  *cancelFlag))
+          {
+            train (problemIdx);
+            ++numTrained;
+          }
+        }
+        catch  (...)
+        {
+          release ();
+          throw;
+        }
+        release ();
+      }
+    );
+  }
+  pool.WaitForAllTasks ();
+  return  numTrained;
+}  /* svm_train_scheduled */
+
+
+
 
 
 
@@ -4004,9 +4697,6 @@ struct SvmModel233*  SVM233::Svm_Load_Model (istream&  f,
     }
   }
 
-  if  (model)
-    model->kValueTable = new double[model->l];
-
 
   delete[]  buff;
   buff = NULL;
@@ -4036,15 +4726,25 @@ double  SVM233::svm_predict (const SvmModel233*     model,
     double*  sv_coef = model->sv_coef[0];
     double   sum = 0;
 
-    for  (kkint32 i=0; i < model->l; i++)
+    if  (dimSelect > 0)
     {
-      if  (i == excludeSupportVectorIDX)
-        continue;
-
-      if  (dimSelect>0)
+      for  (kkint32 i=0; i < model->l; i++)
+      {
+        if  (i == excludeSupportVectorIDX)
+          continue;
         sum += sv_coef[i] * Kernel::k_function_subspace (x, model->SV[i], model->param, model->featureWeight);
-      else
-        sum += sv_coef[i] * Kernel::k_function (x, model->SV[i], model->param);
+      }
+    }
+    else
+    {
+      std::vector<double>  kvalue (model->l);
+      svm_kernelValues (model->param, x, model->PackedSVs (), kvalue.data ());
+      for  (kkint32 i=0; i < model->l; i++)
+      {
+        if  (i == excludeSupportVectorIDX)
+          continue;
+        sum += sv_coef[i] * kvalue[i];
+      }
     }
 
     sum -= model->rho[0];
@@ -4061,132 +4761,146 @@ double  SVM233::svm_predict (const SvmModel233*     model,
   }
   else
   {
-    kkuint32 nr_class = model->nr_class;
-
-    std::vector<kkint32>  voteTable (nr_class * nr_class, 0);
     kkint32 l = model->l;
 
 
-    double*  kvalue = model->kValueTable;
+    // Local so that several threads can predict with the same model.
+    std::vector<double>  kvalue (l);
 
     // Precompute S/V's for all classes.
-    for  (kkint32 i = 0; i<l; i++)
+    if  (dimSelect > 0)
     {
-      if  (i == excludeSupportVectorIDX)
-      {
-        kvalue[i] = 0.0;
-      }
-      else
+      for  (kkint32 i = 0; i<l; i++)
       {
-        if  (dimSelect > 0)
-          kvalue[i] = Kernel::k_function_subspace (x, model->SV[i], model->param, model->featureWeight);
+        if  (i == excludeSupportVectorIDX)
+          kvalue[i] = 0.0;
         else
-          kvalue[i] = Kernel::k_function (x, model->SV[i], model->param);
+          kvalue[i] = Kernel::k_function_subspace (x, model->SV[i], model->param, model->featureWeight);
       }
     }
+    else
+    {
+      svm_kernelValues (model->param, x, model->PackedSVs (), kvalue.data ());
+      if  ((excludeSupportVectorIDX >= 0)  &&  (excludeSupportVectorIDX < l))
+        kvalue[excludeSupportVectorIDX] = 0.0;
+    }
 
+    return  svm_predictFromKernel (model, kvalue.data (), dist, winners);
+  }
+}  /* svm_predict */
 
-    // 'start'  will be built to point to the beginning of the list of S'V's for each class.
-    kkint32 *start = Malloc (kkint32, nr_class);
-    start[0] = 0;
-    for  (kkuint32 i = 1;  i < nr_class;  i++)
-      start[i] = start[i-1] + model->nSV[i-1];
 
-    kkint32 *vote = Malloc (kkint32, nr_class);
 
-    for  (kkuint32 i = 0;  i < nr_class;  i++)
-      vote[i] = 0;
+double  SVM233::svm_predictFromKernel (const SvmModel233*     model,
+                                       const double*          kvalue,
+                                       std::vector<double>&   dist,
+                                       std::vector<kkint32>&  winners
+                                      )
+{
+  kkuint32 nr_class = model->nr_class;
 
-    kkint32 p = 0;
+  std::vector<kkint32>  voteTable (nr_class * nr_class, 0);
 
-    std::vector<double>  distTable (nr_class * nr_class, 0);
+  // 'start'  will be built to point to the beginning of the list of S'V's for each class.
+  kkint32 *start = Malloc (kkint32, nr_class);
+  start[0] = 0;
+  for  (kkuint32 i = 1;  i < nr_class;  i++)
+    start[i] = start[i-1] + model->nSV[i-1];
 
-    for  (kkuint32 i = 0;  i < nr_class;  i++)
-    {
-      for  (kkuint32 j = i + 1;  j < nr_class;  j++)
-      {
-        double sum = 0;
-        kkint32 si = start[i];
-        kkint32 sj = start[j];
-        kkint32 ci = model->nSV[i];
-        kkint32 cj = model->nSV[j];
+  kkint32 *vote = Malloc (kkint32, nr_class);
 
-        kkint32 k;
-        double *coef1 = model->sv_coef[j-1];
-        double *coef2 = model->sv_coef[i];
+  for  (kkuint32 i = 0;  i < nr_class;  i++)
+    vote[i] = 0;
 
-        for  (k = 0;  k < ci;  k++)
-          sum += coef1[si + k] * kvalue[si + k];
+  kkint32 p = 0;
 
-        for  (k = 0;  k < cj;  k++)
-          sum += coef2[sj + k] * kvalue[sj + k];
+  std::vector<double>  distTable (nr_class * nr_class, 0);
 
-        sum -= model->rho[p];
+  for  (kkuint32 i = 0;  i < nr_class;  i++)
+  {
+    for  (kkuint32 j = i + 1;  j < nr_class;  j++)
+    {
+      double sum = 0;
+      kkint32 si = start[i];
+      kkint32 sj = start[j];
+      kkint32 ci = model->nSV[i];
+      kkint32 cj = model->nSV[j];
 
-        if  (sum > 0)
-        {
-          voteTable[i * nr_class + j]++; // i vs. j
-          ++vote[i];
-        }
-        else
-        {
-          voteTable[j * nr_class + i]++; // j vs. i
-          ++vote[j];
-        }
+      kkint32 k;
+      double *coef1 = model->sv_coef[j-1];
+      double *coef2 = model->sv_coef[i];
 
-        kkint32 row = model->label[i];
-        kkint32 col = model->label[j];
+      for  (k = 0;  k < ci;  k++)
+        sum += coef1[si + k] * kvalue[si + k];
 
-        distTable[row * nr_class + col] = sum;
-        distTable[col * nr_class + row] = (-1.0 * sum);
+      for  (k = 0;  k < cj;  k++)
+        sum += coef2[sj + k] * kvalue[sj + k];
 
-        //dist[p] = sum;
-        p++;
+      sum -= model->rho[p];
+
+      if  (sum > 0)
+      {
+        voteTable[i * nr_class + j]++; // i vs. j
+        ++vote[i];
+      }
+      else
+      {
+        voteTable[j * nr_class + i]++; // j vs. i
+        ++vote[j];
       }
-    }
 
-    p=0;
+      kkint32 row = model->label[i];
+      kkint32 col = model->label[j];
 
-    {  // kk:  jun-06-2003
+      distTable[row * nr_class + col] = sum;
+      distTable[col * nr_class + row] = (-1.0 * sum);
 
-      for (kkuint32 i = 0;  i < nr_class - 1; i++)
-      {
-        for (kkuint32 j=i+1; j< nr_class; j++)
-        {
-          dist[p++] = distTable[i * nr_class + j];
-        }
-      }
+      //dist[p] = sum;
+      p++;
+    }
+  }
 
-    }  // kk:  jun-06-2003
+  p=0;
 
-    winners.erase (winners.begin (), winners.end ());
-    kkint32 vote_max_idx = 0;
-    kkint32 winningAmt   = vote[0];
-    winners.push_back (model->label[0]);
+  {  // kk:  jun-06-2003
 
-    for  (kkuint32 i = 1;  i < nr_class;  i++)
+    for (kkuint32 i = 0;  i < nr_class - 1; i++)
     {
-      if  (vote[i] > winningAmt)
-      {
-        winners.erase (winners.begin (), winners.end ());
-        vote_max_idx = i;
-        winningAmt   = vote[i];
-        winners.push_back (model->label[i]);
-      }
-      else if  (vote[i] == winningAmt)
+      for (kkuint32 j=i+1; j< nr_class; j++)
       {
-        winners.push_back (model->label[i]);
+        dist[p++] = distTable[i * nr_class + j];
       }
     }
 
-    free (start);
-    free (vote);
+  }  // kk:  jun-06-2003
 
-    kkint32  winningLabel = model->label[vote_max_idx];
+  winners.erase (winners.begin (), winners.end ());
+  kkint32 vote_max_idx = 0;
+  kkint32 winningAmt   = vote[0];
+  winners.push_back (model->label[0]);
 
-    return  winningLabel;
+  for  (kkuint32 i = 1;  i < nr_class;  i++)
+  {
+    if  (vote[i] > winningAmt)
+    {
+      winners.erase (winners.begin (), winners.end ());
+      vote_max_idx = i;
+      winningAmt   = vote[i];
+      winners.push_back (model->label[i]);
+    }
+    else if  (vote[i] == winningAmt)
+    {
+      winners.push_back (model->label[i]);
+    }
   }
-}  /* svm_predict */
+
+  free (start);
+  free (vote);
+
+  kkint32  winningLabel = model->label[vote_max_idx];
+
+  return  winningLabel;
+}  /* svm_predictFromKernel */
 
 
 
@@ -4208,15 +4922,25 @@ double  SVM233::svm_predictTwoClasses (const SvmModel233*  model,
     double*  sv_coef = model->sv_coef[0];
     double   sum = 0;
 
-    for  (kkint32 i=0; i < model->l; i++)
+    if  (dimSelect > 0)
     {
-      if  (i == excludeSupportVectorIDX)
-        continue;
-
-      if  (dimSelect > 0)
+      for  (kkint32 i=0; i < model->l; i++)
+      {
+        if  (i == excludeSupportVectorIDX)
+          continue;
         sum += sv_coef[i] * Kernel::k_function_subspace (x, model->SV[i],model->param, model->featureWeight);
-      else
-        sum += sv_coef[i] * Kernel::k_function (x, model->SV[i], model->param);
+      }
+    }
+    else
+    {
+      std::vector<double>  kvalue (model->l);
+      svm_kernelValues (model->param, x, model->PackedSVs (), kvalue.data ());
+      for  (kkint32 i=0; i < model->l; i++)
+      {
+        if  (i == excludeSupportVectorIDX)
+          continue;
+        sum += sv_coef[i] * kvalue[i];
+      }
     }
 
     sum -= model->rho[0];
@@ -4244,9 +4968,8 @@ double  SVM233::svm_predictTwoClasses (const SvmModel233*  model,
     }
 
     kkint32 l = model->l;
-    //double *kvalue = Malloc (double, l);
-
-    double* kvalue = model->kValueTable;
+    // Local so that several threads can predict with the same model.
+    std::vector<double>  kvalue (l);
 
     if  (dimSelect > 0)
     {
@@ -4260,13 +4983,9 @@ double  SVM233::svm_predictTwoClasses (const SvmModel233*  model,
     }
     else
     {
-      for  (i = 0;  i < l;  i++)
-      {
-        if  (i == excludeSupportVectorIDX)
-          kvalue[i] = 0.0;
-        else
-          kvalue[i] = Kernel::k_function (x, model->SV[i], model->param);
-      }
+      svm_kernelValues (model->param, x, model->PackedSVs (), kvalue.data ());
+      if  ((excludeSupportVectorIDX >= 0)  &&  (excludeSupportVectorIDX < l))
+        kvalue[excludeSupportVectorIDX] = 0.0;
     }
 
     kkint32 start[2];
@@ -4321,6 +5040,212 @@ double  SVM233::svm_predictTwoClasses (const SvmModel233*  model,
 
 
 
+void  SVM233::svm_kernelValues (const svm_parameter&     param,
+                                const svm_node*          x,
+                                const svm_node* const*   svs,
+                                kkint32                  count,
+                                double*                  kvalues
+                               )
+{
+  PackedDoubleVectorsPtr  packed = svm_PackNodes (svs, count);
+  svm_kernelValues (param, x, *packed, kvalues);
+  delete  packed;
+}  /* svm_kernelValues */
+
+
+
+/**
+ *@brief  Packs the sparse vector 'x' into row 'row' of 'queries'.
+ *@details  Features of 'x' past the last column of 'queries' are 0.0 in every support vector;  they only add to
+ * RBF distances so the sum of their squares is returned.  'dense' must have 'queries.NumCols ()' zeros and is left
+ * that way.
+ */
+static  double  PackQuery (const svm_node*        x,
+                           PackedDoubleVectors&   queries,
+                           kkint32                row,
+                           std::vector<double>&   dense
+                          )
+{
+  kkint32  numCols = queries.NumCols ();
+  double  tailSquares = 0.0;
+  for  (const svm_node* n = x;  n->index != -1;  ++n)
+  {
+    if  (n->index < numCols)
+      dense[n->index] = n->value;
+    else
+      tailSquares += n->value * n->value;
+  }
+
+  queries.PackRow (row, dense.data ());
+
+  for  (const svm_node* n = x;  n->index != -1;  ++n)
+  {
+    if  (n->index < numCols)
+      dense[n->index] = 0.0;
+  }
+  return  tailSquares;
+}  /* PackQuery */
+
+
+
+/** @brief  Turns the dot products or squared distances KernelEngine computed for one query into kernel values. */
+static  void  ApplyKernelFunction (const svm_parameter&  param,
+                                   double                tailSquares,
+                                   kkint32               count,
+                                   double*               kvalues
+                                  )
+{
+  switch  (param.kernel_type)
+  {
+  case  LINEAR:
+    break;
+
+  case  POLY:
+    for  (kkint32 i = 0;  i < count;  ++i)
+      kvalues[i] = pow (param.gamma * kvalues[i] + param.coef0, param.degree);
+    break;
+
+  case  RBF:
+    for  (kkint32 i = 0;  i < count;  ++i)
+      kvalues[i] = exp (-param.gamma * (kvalues[i] + tailSquares));
+    break;
+
+  case  SIGMOID:
+    for  (kkint32 i = 0;  i < count;  ++i)
+      kvalues[i] = tanh (param.gamma * kvalues[i] + param.coef0);
+    break;
+
+  default:
+    for  (kkint32 i = 0;  i < count;  ++i)
+      kvalues[i] = 0.0;
+    break;
+  }
+}  /* ApplyKernelFunction */
+
+
+
+void  SVM233::svm_kernelValues (const svm_parameter&        param,
+                                const svm_node*             x,
+                                const PackedDoubleVectors&  svs,
+                                double*                     kvalues
+                               )
+{
+  kkint32  numCols = svs.NumCols ();
+  kkint32  count   = svs.NumRows ();
+
+  std::vector<double>  dense (numCols + 1, 0.0);
+  PackedDoubleVectors  query (1, numCols);
+  double  tailSquares = PackQuery (x, query, 0, dense);
+
+  if  (param.kernel_type == RBF)
+    KernelEngine::SquaredDistanceOneToMany (query.Row (0), svs, NULL, count, kvalues);
+  else
+    KernelEngine::DotOneToMany (query.Row (0), svs, NULL, count, kvalues);
+
+  ApplyKernelFunction (param, tailSquares, count, kvalues);
+}  /* svm_kernelValues */
+
+
+
+void  SVM233::svm_kernelValuesBlock (const svm_parameter&        param,
+                                     const svm_node* const*      xs,
+                                     kkint32                     numXs,
+                                     const PackedDoubleVectors&  svs,
+                                     double*                     kvalues
+                                    )
+{
+  kkint32  numCols = svs.NumCols ();
+  kkint32  count   = svs.NumRows ();
+
+  std::vector<double>  dense (numCols + 1, 0.0);
+  std::vector<double>  tailSquares (numXs, 0.0);
+  PackedDoubleVectors  queries (numXs, numCols);
+  for  (kkint32 q = 0;  q < numXs;  ++q)
+    tailSquares[q] = PackQuery (xs[q], queries, q, dense);
+
+  if  (param.kernel_type == RBF)
+    KernelEngine::SquaredDistanceManyToMany (queries, svs, kvalues);
+  else
+    KernelEngine::DotManyToMany (queries, svs, kvalues);
+
+  for  (kkint32 q = 0;  q < numXs;  ++q)
+    ApplyKernelFunction (param, tailSquares[q], count, kvalues + (kkMemSize)q * count);
+}  /* svm_kernelValuesBlock */
+
+
+
+double  SVM233::svm_kernelValue (const svm_parameter&  param,
+                                 const svm_node*       x,
+                                 const svm_node*       y
+                                )
+{
+  return  Kernel::k_function (x, y, param);
+}
+
+
+
+PackedDoubleVectorsPtr  SVM233::svm_PackNodes (const svm_node* const*  x,
+                                               kkint32                 count,
+                                               kkint32                 minNumCols
+                                              )
+{
+  kkint32  numCols = Max (minNumCols, (kkint32)0);
+  for  (kkint32 i = 0;  i < count;  ++i)
+  {
+    for  (const svm_node* n = x[i];  n->index != -1;  ++n)
+    {
+      if  (n->index >= numCols)
+        numCols = n->index + 1;
+    }
+  }
+
+  PackedDoubleVectorsPtr  packed = new PackedDoubleVectors (count, numCols);
+  std::vector<double>  dense (numCols + 1, 0.0);
+  for  (kkint32 i = 0;  i < count;  ++i)
+  {
+    for  (const svm_node* n = x[i];  n->index != -1;  ++n)
+      dense[n->index] = n->value;
+
+    packed->PackRow (i, dense.data ());
+
+    for  (const svm_node* n = x[i];  n->index != -1;  ++n)
+      dense[n->index] = 0.0;
+  }
+  return  packed;
+}  /* svm_PackNodes */
+
+
+
+double  SVM233::svm_predictTwoClassesFromKernel (const SvmModel233*  model,
+                                                 const double*       kvalues,
+                                                 const kkint32*      svKeys,
+                                                 double&             dist
+                                                )
+{
+  KKCheck (model->nr_class == 2, "svm_predictTwoClassesFromKernel   nr_class[" << model->nr_class << "] != 2")
+
+  // Same sums in the same order as 'svm_predictTwoClasses' so the distance is identical given the same kernel values.
+  kkint32  ci = model->nSV[0];
+  kkint32  cj = model->nSV[1];
+  double*  coef1 = model->sv_coef[0];
+
+  double sum = 0;
+  for  (kkint32 k = 0;  k < ci;  k++)
+    sum += coef1[k] * kvalues[svKeys[k]];
+
+  for  (kkint32 k = 0;  k < cj;  k++)
+    sum += coef1[ci + k] * kvalues[svKeys[ci + k]];
+
+  sum -= model->rho[0];
+
+  dist = sum;
+
+  kkint32  winner = (sum > 0) ? 0 : 1;
+  return  (double)model->label[winner];
+}  /* svm_predictTwoClassesFromKernel */
+
+
+
 
 
 
@@ -4,11 +4,16 @@
 
 //#pragma warning (disable:4786)
 
+#include <atomic>
+#include <functional>
+#include <list>
+#include <mutex>
 #include <set>
 #include <vector>
 
 #include "KKException.h"
 #include "KKStr.h"
+#include "KernelEngine.h"
 #include "RunLog.h"
 #include "XmlStream.h"
 
@@ -162,14 +167,16 @@ struct SvmModel233
   double*            featureWeight;
   //luo
 
-  double*            kValueTable;
-
   svm_node*          xSpace;    // Needed when we load from data file.
 
+  BinaryContainerConstPtr  mappedContainer;  /**< When loaded from a binary container 'xSpace' and the 'sv_coef' rows point into its mapping. */
+
   bool               valid;     /**< Set to false if model is InValid;  example look at ReadXML */
 
   bool               weOwnXspace;
 
+  bool               weOwnSvCoef;  /**< false when the 'sv_coef' rows point into 'mappedContainer'. */
+
   SvmModel233 ();
 
   virtual ~SvmModel233 ();
@@ -185,6 +192,23 @@ struct SvmModel233
   kkMemSize  MemoryConsumedEstimated ()  const;
   
 
+  /**
+   *@brief  The support vectors packed densely for KernelEngine;  built the first time it is called.
+   *@details  Safe to call from several threads at the same time;  see 'svm_PackNodes'.
+   */
+  const KKMLL::PackedDoubleVectors&  PackedSVs ()  const;
+
+
+  /**
+   *@brief  From now on 'PackedSVs' has at least 'minNumCols' columns.
+   *@details  KernelEngine adds up an RBF distance in an order that depends on how many columns the support vectors
+   * are packed with.  Models that share kernel values through one PackedDoubleVectors are packed to its width so
+   * that 'svm_predictTwoClasses' gives exactly the distance computed from the shared values.  Must not be called
+   * while another thread is predicting with the model.
+   */
+  void  PackedSVsMinNumCols (kkint32  minNumCols);
+
+
   KKStr  SupportVectorName (kkint32 svIDX);
 
 
@@ -202,6 +226,10 @@ struct SvmModel233
 
 private:
   void  Dispose ();
+
+  mutable std::atomic<KKMLL::PackedDoubleVectorsPtr>  packedSVs;           /**< Built by 'PackedSVs'.              */
+  mutable std::mutex                                 packedSVsMutex;      /**< Held while 'packedSVs' is built.   */
+  kkint32                                            packedSVsMinNumCols; /**< See 'PackedSVsMinNumCols'.         */
 };  /* SvmModel233 */
 
 
@@ -211,11 +239,105 @@ typedef  XmlElementSvmModel233*  XmlElementSvmModel233Ptr;
 
 
 
+/**
+ *@class  SharedKernelCache
+ *@brief  Kernel values shared by several C-SVC problems so that a value needed by more than one is computed once.
+ *@details  Every example is identified by a key from 0 to 'numKeys' - 1.  The same key must stand for the same
+ * encoded example in every problem that uses the cache and all of them must use the same kernel parameters;  it
+ * is up to the caller to only share a cache between such problems.  The values are kept in rows, one per key,
+ * each holding the kernel between that example and every other key;  rows are created as they are needed and
+ * when they would take more than 'cacheSizeMB' the least recently used ones that are not in use are dropped.  It
+ * may be used from several threads at the same time.
+ */
+class  SharedKernelCache
+{
+public:
+  SharedKernelCache (kkint32  _numKeys,
+                     double   _cacheSizeMB
+                    );
+
+  ~SharedKernelCache ();
+
+  kkint64  Evictions   () const;    /**< Rows dropped to stay within the memory limit.   */
+  kkint64  Hits        () const;    /**< Kernel values that were found already computed. */
+  kkint64  MemoryUsed  () const;    /**< Bytes held by the rows currently in memory.     */
+  kkint64  Misses      () const;    /**< Kernel values that had to be computed.          */
+  kkint32  NumKeys     () const  {return numKeys;}
+
+  /**
+   *@brief  Locks and returns the row for 'key';  entries that have not been computed yet are NaN.
+   *@details  The row is not dropped and no other thread can get it until it is given back with 'ReleaseRow'.
+   */
+  float*  AcquireRow (kkint32  key);
+
+  /** @brief  Gives back a row returned by 'AcquireRow' and adds to the hit and miss counts. */
+  void  ReleaseRow (kkint32  key,
+                    kkint64  rowHits,
+                    kkint64  rowMisses
+                   );
+
+private:
+  struct  Row;
+
+  void  EvictRows ();
+
+  kkint64             cacheSizeBytes;
+  kkint64             evictions;
+  kkint64             hits;
+  mutable std::mutex  lock;           /**< Protects everything but the values of a row that is in use. */
+  std::list<kkint32>  lru;            /**< Keys of the rows in memory, least recently used first.      */
+  kkint64             memoryUsed;
+  kkint64             misses;
+  kkint32             numKeys;
+  std::vector<Row*>   rows;
+};  /* SharedKernelCache */
+
+typedef  SharedKernelCache*  SharedKernelCachePtr;
+
+
+
+/**
+ *@brief  Trains a model;  the binary classifiers of a multi-class problem are trained 'numThreads' at a time.
+ *@details  The model is the same no matter how many threads are used;  see 'svm_train_scheduled' for how the
+ * binary classifiers are scheduled.
+ *@param[in]  numThreads        Number of binary classifiers to train at the same time;  0 = one per processor.
+ *@param[in]  trainingMemoryMB  Limit on the kernel cache used by all the binary classifiers being trained; 0 = no limit.
+ *@param[in]  kernelCache       When not NULL C-SVC problems get their kernel values from here so that the binary
+ *                              classifiers share them;  it is not included in 'trainingMemoryMB'.
+ *@param[in]  cacheKeys         Key in 'kernelCache' of each example in 'prob';  NULL = the example's position in 'prob'.
+ *@param[in]  cancelFlag        When not NULL and it turns true the binary classifiers not yet started are skipped;
+ *                              if any were, NULL is returned instead of a model.
+ */
 struct SvmModel233*  svm_train  (const struct svm_problem*   prob, 
-                                 const struct svm_parameter* param
+                                 const struct svm_parameter* param,
+                                 kkuint32                    numThreads = 1,
+                                 kkuint32                    trainingMemoryMB = 0,
+                                 SharedKernelCachePtr        kernelCache = NULL,
+                                 const kkint32*              cacheKeys = NULL,
+                                 VolConstBool*               cancelFlag = NULL
                                 );
 
 
+/**
+ *@brief  Calls 'train' once for every index into 'problemSizes', running up to 'numThreads' of them at the same time.
+ *@details  Each problem is expected to use a kernel cache of whichever is smaller, 'cacheSizeMB' or a full
+ * 'l' x 'l' kernel matrix where 'l' is its entry in 'problemSizes'.  A problem is not started while its cache
+ * together with those of the problems already running would exceed 'trainingMemoryMB', unless nothing else is
+ * running.  The largest problems are started first so that a big one is not left running on its own at the end.
+ * With one thread the problems are trained in index order on the calling thread.  Once 'cancelFlag' is set the
+ * problems that have not started yet are skipped.
+ *@returns  The number of problems 'train' was called for;  less than 'problemSizes.size ()' only when some were
+ *          skipped.
+ */
+kkint32  svm_train_scheduled (const std::vector<kkint32>&    problemSizes,
+                              double                         cacheSizeMB,
+                              kkuint32                       numThreads,
+                              kkuint32                       trainingMemoryMB,
+                              VolConstBool*                  cancelFlag,
+                              std::function<void (kkint32)>  train
+                             );
+
+
 
 struct SvmModel233*  Svm_Load_Model (std::istream&  f,
                                      RunLog&        log
@@ -270,6 +392,17 @@ double  svm_predict  (const struct SvmModel233*  model,
                      );
 
 
+/**
+ *@brief  Same as 'svm_predict' for a C-SVC or NU-SVC model but with the kernel values between the example and the support vectors already computed.
+ *@param[in]  kvalue  'kvalue[i]' is the kernel value for support vector 'i';  see 'svm_kernelValuesBlock'.
+ */
+double  svm_predictFromKernel (const SvmModel233*     model,
+                               const double*          kvalue,
+                               std::vector<double>&   dist,
+                               std::vector<kkint32>&  winners
+                              );
+
+
 /**
  *@param[in]  model   A previously trained model.
  *@param[in]  x       Example that we want to make prediction on.
@@ -283,6 +416,79 @@ double  svm_predictTwoClasses (const SvmModel233*  model,
                                kkint32           excludeSupportVectorIDX
                               );
 
+/**
+ *@brief  Computes the kernel between 'x' and each of 'svs';  'kvalues[i]' is what 'svm_predictTwoClasses' would use for 'svs[i]'.
+ *@details  Lets several two class models that use the same kernel parameters share the kernel values of the
+ * support vectors they have in common;  see 'svm_predictTwoClassesFromKernel'.  'param.dimSelect' must not be > 0.
+ * Both are evaluated with KernelEngine.  The values are exactly the ones 'svm_predictTwoClasses' uses once the
+ * model's support vectors are packed with as many columns as 'svs' are;  see 'SvmModel233::PackedSVsMinNumCols'.
+ * With fewer columns an RBF value may differ in the last bits since the distance is added up in a different order.
+ */
+void  svm_kernelValues (const svm_parameter&     param,
+                        const svm_node*          x,
+                        const svm_node* const*   svs,
+                        kkint32                  count,
+                        double*                  kvalues
+                       );
+
+
+/**
+ *@brief  Same as above with the support vectors already packed by 'svm_PackNodes';  'kvalues[i]' is for row 'i'.
+ *@details  Evaluated with KernelEngine;  agrees with 'Kernel::k_function' to within the tolerance given in KernelEngine.h.
+ */
+void  svm_kernelValues (const svm_parameter&                param,
+                        const svm_node*                     x,
+                        const KKMLL::PackedDoubleVectors&   svs,
+                        double*                             kvalues
+                       );
+
+
+/**
+ *@brief  Block version of the one above;  computes the kernel between each of the 'numXs' examples in 'xs' and every row of 'svs'.
+ *@details  'kvalues' must have room for  numXs * svs.NumRows ()  values;  those for 'xs[q]' start at  kvalues[q * svs.NumRows ()].
+ * Each row of 'svs' is evaluated against all of 'xs' while it is in cache.  The values are exactly the ones the
+ * single example version gives.
+ */
+void  svm_kernelValuesBlock (const svm_parameter&                param,
+                             const svm_node* const*              xs,
+                             kkint32                             numXs,
+                             const KKMLL::PackedDoubleVectors&   svs,
+                             double*                             kvalues
+                            );
+
+
+/** @brief  The kernel between 'x' and 'y' computed one feature at a time the way libSVM does;  the reference for 'svm_kernelValues'. */
+double  svm_kernelValue (const svm_parameter&  param,
+                         const svm_node*       x,
+                         const svm_node*       y
+                        );
+
+
+/**
+ *@brief  Copies 'count' sparse vectors into one dense PackedDoubleVectors, one row each.
+ *@details  Column 'c' holds the value of feature index 'c';  features that are missing are 0.0.  There are as many
+ * columns as the largest feature index plus one, or 'minNumCols' if that is more.
+ */
+KKMLL::PackedDoubleVectorsPtr  svm_PackNodes (const svm_node* const*  x,
+                                              kkint32                 count,
+                                              kkint32                 minNumCols = 0
+                                             );
+
+
+/**
+ *@brief  Same as 'svm_predictTwoClasses' but with the kernel values between the example and the support vectors already computed.
+ *@param[in]  model    A C-SVC or NU-SVC model with two classes.
+ *@param[in]  kvalues  Kernel values computed by 'svm_kernelValues'.
+ *@param[in]  svKeys   Index in 'kvalues' of each support vector of 'model'.
+ *@param[out] dist     Distance from decision boundary.
+ */
+double  svm_predictTwoClassesFromKernel (const SvmModel233*  model,
+                                         const double*       kvalues,
+                                         const kkint32*      svKeys,
+                                         double&             dist
+                                        );
+
+
 svm_problem*  svm_BuildProbFromTwoClassModel (const SvmModel233*  model,
                                               kkint32           excludeSupportVectorIDX
                                              );
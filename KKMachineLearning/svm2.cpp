@@ -18,6 +18,7 @@
 #include  "MemoryDebug.h"
 using namespace  std;
 
+#include "BinaryContainer.h"
 #include "GlobalGoalKeeper.h"
 #include "KKException.h"
 #include "KKStr.h"
@@ -67,6 +68,12 @@ namespace  SVM289_MFS
                                 double*   classProb       /**< Class Probability        */
                                );
 
+  /** @brief  What 'Svm_Model::NormalizeProbability' does with the tables passed in rather than the model's own. */
+  void  NormalizePairwiseProbability (kkuint32  nr_class,
+                                      double**  pairwise_prob,
+                                      double*   prob_estimates
+                                     );
+
   // Stratified cross validation
   void  svm_cross_validation (const svm_problem&    prob, 
                               const svm_parameter&  param, 
@@ -837,6 +844,7 @@ public:
   {
     //swap (x[i], x[j]);
     x->SwapIndexes (i, j);
+    swap (packedIdx[i], packedIdx[j]);
     if  (x_square) 
       swap (x_square[i], x_square[j]);
   }
@@ -844,14 +852,28 @@ public:
 protected:
   double (Kernel::*kernel_function) (kkint32 i, kkint32 j) const;
 
+  /**
+   *@brief  Computes the kernel of example 'i' against examples 'start' thru 'len - 1' in one pass.
+   *@details  Uses KernelEngine to evaluate the whole row at once; 'results[j - start]' is set to the
+   * same value 'kernel_function (i, j)' returns, to within the tolerance documented in KernelEngine.h.
+   */
+  void  KernelRow (kkint32  i,
+                   kkint32  start,
+                   kkint32  len,
+                   double*  results
+                  )  const;
+
 private:
-  kkint32               l;
-  kkint32               numSelFeatures;
-  kkint32*              selFeatures;
-  FeatureVectorListPtr  x;
-  double*               x_square;
+  kkint32                  l;
+  kkint32                  numSelFeatures;
+  kkint32*                 selFeatures;
+  FeatureVectorListPtr     x;
+  double*                  x_square;
 
-  float**               preComputed;
+  PackedFeatureVectorsPtr  packed;     /**< Selected features of 'x' packed for KernelEngine;  rows are never moved. */
+  kkint32*                 packedIdx;  /**< packedIdx[i] = row in 'packed' of example currently at index 'i'.      */
+
+  float**                  preComputed;
 
   // svm_parameter
   const Kernel_Type     kernel_type;
@@ -859,36 +881,37 @@ private:
   const double          gamma;
   const double          coef0;
 
-  double  dot (const FeatureVector&  px, 
-               const FeatureVector&  py
-              )  const;
+  double  dot (kkint32 i, kkint32 j) const
+  {
+    return  KernelEngine::Dot (packed->Row (packedIdx[i]), packed->Row (packedIdx[j]), packed->Stride ());
+  }
 
 
 
   double kernel_linear (kkint32 i, kkint32 j) const
   {
-    return dot ((*x)[i], (*x)[j]);
+    return dot (i, j);
   }
 
 
 
   double  kernel_poly (kkint32 i, kkint32 j) const
   {
-    return  powi (gamma * dot((*x)[i], (*x)[j]) + coef0, degree);
+    return  powi (gamma * dot (i, j) + coef0, degree);
   }
 
 
 
   double  kernel_rbf (kkint32 i, kkint32 j) const
   {
-    return exp (-gamma * (x_square[i] + x_square[j] - 2 * dot ((*x)[i], (*x)[j])));
+    return exp (-gamma * (x_square[i] + x_square[j] - 2 * dot (i, j)));
   }
 
 
 
   double kernel_sigmoid (kkint32 i, kkint32 j) const
   {
-    return tanh (gamma * dot ((*x)[i], (*x)[j]) + coef0);
+    return tanh (gamma * dot (i, j) + coef0);
   }
 
 
@@ -915,6 +938,8 @@ SVM289_MFS::Kernel::Kernel (const FeatureVectorList&  _x,
    selFeatures    (nullptr),
    x              (nullptr),
    x_square       (nullptr),
+   packed         (nullptr),
+   packedIdx      (nullptr),
    preComputed    (nullptr),
    kernel_type    (_param.kernel_type), 
    degree         (_param.degree),
@@ -929,6 +954,11 @@ SVM289_MFS::Kernel::Kernel (const FeatureVectorList&  _x,
   for  (kkint32 zed = 0;  zed < numSelFeatures;  ++zed)
     selFeatures[zed] = _selFeatures[zed];
 
+  packed = new PackedFeatureVectors (*x, _selFeatures);
+  packedIdx = new kkint32[l];
+  for  (kkint32 zed = 0;  zed < l;  ++zed)
+    packedIdx[zed] = zed;
+
   switch  (kernel_type)
   {
     case Kernel_Type::LINEAR:  kernel_function = &Kernel::kernel_linear;    break;
@@ -961,7 +991,7 @@ SVM289_MFS::Kernel::Kernel (const FeatureVectorList&  _x,
   {
     x_square = new double[l];
     for  (kkint32 i = 0;  i < l;  i++)
-      x_square[i] = dot ((*x)[i], (*x)[i]);
+      x_square[i] = packed->SquaredNorm (i);
   }
 
   else
@@ -976,6 +1006,8 @@ SVM289_MFS::Kernel::~Kernel()
 {
   delete[] selFeatures;    selFeatures = NULL;
   delete[] x_square;       x_square    = NULL;
+  delete[] packedIdx;      packedIdx   = NULL;
+  delete   packed;         packed      = NULL;
 
   if  (preComputed)
   {
@@ -991,25 +1023,52 @@ SVM289_MFS::Kernel::~Kernel()
 
 
 
-double  SVM289_MFS::Kernel::dot (const FeatureVector&  px, 
-                                 const FeatureVector&  py
-                                )  const
+void  SVM289_MFS::Kernel::KernelRow (kkint32  i,
+                                     kkint32  start,
+                                     kkint32  len,
+                                     double*  results
+                                    )  const
 {
-  double  sum = 0;
-  kkint32  fn = 0;
-  kkint32  idx = 0;
-
-  const float*  fvX  = px.FeatureData ();
-  const float*  fvY  = py.FeatureData ();
+  kkint32  count = len - start;
+  if  (count <= 0)
+    return;
 
-  for  (idx = 0;  idx < numSelFeatures;  idx++)
+  if  (kernel_type == Kernel_Type::PRECOMPUTED)
   {
-    fn = selFeatures[idx];
-    sum += fvX[fn] * fvY[fn];
+    for  (kkint32 j = start;  j < len;  ++j)
+      results[j - start] = kernel_precomputed (i, j);
+    return;
   }
 
-  return sum;
-}  /* dot */
+  KernelEngine::DotOneToMany (packed->Row (packedIdx[i]), *packed, packedIdx + start, count, results);
+
+  switch  (kernel_type)
+  {
+  case  Kernel_Type::LINEAR:
+    break;
+
+  case  Kernel_Type::POLY:
+    for  (kkint32 k = 0;  k < count;  ++k)
+      results[k] = powi (gamma * results[k] + coef0, degree);
+    break;
+
+  case  Kernel_Type::RBF:
+    {
+      double  xsi = x_square[i];
+      for  (kkint32 k = 0;  k < count;  ++k)
+        results[k] = exp (-gamma * (xsi + x_square[start + k] - 2 * results[k]));
+    }
+    break;
+
+  case  Kernel_Type::SIGMOID:
+    for  (kkint32 k = 0;  k < count;  ++k)
+      results[k] = tanh (gamma * results[k] + coef0);
+    break;
+
+  default:
+    break;
+  }
+}  /* KernelRow */
 
 
 
@@ -2143,6 +2202,7 @@ public:
                        (kkint32)(param.cache_size * (1 << 20))
                       );
     QD = new Qfloat[prob.numTrainExamples];
+    kernelRow = new double[prob.numTrainExamples];
 
     for  (kkint32 i = 0;  i < prob.numTrainExamples;  ++i)
       QD[i] = (Qfloat)(this->*kernel_function)(i, i);
@@ -2155,8 +2215,9 @@ public:
     kkint32 start, j;
     if  ((start = cache->get_data(i,&data,len)) < len)
     {
+      KernelRow (i, start, len, kernelRow);
       for  (j = start;  j < len;  j++)
-        data[j] = (Qfloat)(y[i] * y[j] * (this->*kernel_function)(i, j));
+        data[j] = (Qfloat)(y[i] * y[j] * kernelRow[j - start]);
     }
     return data;
   }
@@ -2183,12 +2244,14 @@ public:
     delete[] y;
     delete cache;
     delete[] QD;
+    delete[] kernelRow;
   }
 
 private:
-  schar*  y;
-  Cache*  cache;
-  Qfloat* QD;
+  schar*   y;
+  Cache*   cache;
+  Qfloat*  QD;
+  double*  kernelRow;   /**< Work area for 'KernelRow'. */
 };  /* SVC_Q */
 
 
@@ -2206,6 +2269,7 @@ public:
   {
     cache = new Cache (prob.numTrainExamples, (kkint32)(param.cache_size * (1<<20)));
     QD = new Qfloat[prob.numTrainExamples];
+    kernelRow = new double[prob.numTrainExamples];
     for  (kkint32 i = 0;  i < prob.numTrainExamples;  i++)
       QD[i]= (Qfloat)(this->*kernel_function)(i, i);
   }
@@ -2217,8 +2281,9 @@ public:
     kkint32 start, j;
     if  ((start = cache->get_data(i,&data,len)) < len)
     {
+      KernelRow (i, start, len, kernelRow);
       for  (j=start;  j < len;  j++)
-        data[j] = (Qfloat)(this->*kernel_function)(i,j);
+        data[j] = (Qfloat)kernelRow[j - start];
     }
     return data;
   }
@@ -2242,11 +2307,13 @@ public:
   {
     delete cache;
     delete[] QD;
+    delete[] kernelRow;
   }
 
 private:
   Cache *cache;
   Qfloat *QD;
+  double *kernelRow;   /**< Work area for 'KernelRow'. */
 
 };  /* ONE_CLASS_Q */
 
@@ -2282,6 +2349,7 @@ public:
     buffer [0] = new Qfloat [2 * l];
     buffer [1] = new Qfloat [2 * l];
     next_buffer = 0;
+    kernelRow = new double[l];
   }
 
 
@@ -2301,8 +2369,9 @@ public:
 
     if  (cache->get_data (real_i, &data, l) < l)
     {
+      KernelRow (real_i, 0, l, kernelRow);
       for  (j = 0;  j < l;  j++)
-        data[j] = (Qfloat)(this->*kernel_function)(real_i, j);
+        data[j] = (Qfloat)kernelRow[j];
     }
 
     // reorder and copy
@@ -2330,6 +2399,7 @@ public:
     delete[] buffer[0];
     delete[] buffer[1];
     delete[] QD;
+    delete[] kernelRow;
   }
 
 
@@ -2341,6 +2411,7 @@ private:
   mutable kkint32  next_buffer;
   Qfloat*      buffer[2];
   Qfloat*      QD;
+  double*      kernelRow;   /**< Work area for 'KernelRow'. */
 };   /* SVR_Q */
 
 
@@ -3800,11 +3871,68 @@ double svm_get_svr_probability (const Svm_Model *model)
 
 
 
+void  SVM289_MFS::svm_kernel_values (const Svm_Model*      model,
+                                     const FeatureVector&  x,
+                                     double*               kvalue
+                                    )
+{
+  const svm_parameter&  param = model->param;
+  kkint32  numSVs = (kkint32)model->numSVs;
+
+  if  (param.kernel_type == Kernel_Type::PRECOMPUTED)
+  {
+    for  (kkint32 i = 0;  i < numSVs;  i++)
+      kvalue[i] = Kernel::k_function (x, model->SV[i], param, model->selFeatures);
+    return;
+  }
+
+  const PackedFeatureVectors&  svs = model->PackedSVs ();
+
+  PackedFeatureVectors  query (1, svs.NumCols ());
+  query.PackRow (0, x, model->selFeatures);
+
+  if  (param.kernel_type == Kernel_Type::RBF)
+  {
+    KernelEngine::SquaredDistanceOneToMany (query.Row (0), svs, NULL, numSVs, kvalue);
+    for  (kkint32 i = 0;  i < numSVs;  i++)
+      kvalue[i] = exp (-param.gamma * kvalue[i]);
+    return;
+  }
+
+  KernelEngine::DotOneToMany (query.Row (0), svs, NULL, numSVs, kvalue);
+  if  (param.kernel_type == Kernel_Type::POLY)
+  {
+    for  (kkint32 i = 0;  i < numSVs;  i++)
+      kvalue[i] = powi (param.gamma * kvalue[i] + param.coef0, param.degree);
+  }
+  else if  (param.kernel_type == Kernel_Type::SIGMOID)
+  {
+    for  (kkint32 i = 0;  i < numSVs;  i++)
+      kvalue[i] = tanh (param.gamma * kvalue[i] + param.coef0);
+  }
+}  /* svm_kernel_values */
+
+
+
+double  SVM289_MFS::svm_kernel_value (const FeatureVector&   x,
+                                      const FeatureVector&   y,
+                                      const svm_parameter&   param,
+                                      const FeatureNumList&  selFeatures
+                                     )
+{
+  return  Kernel::k_function (x, y, param, selFeatures);
+}
+
+
+
 void  SVM289_MFS::svm_predict_values (const Svm_Model*      model, 
                                       const FeatureVector&  x, 
                                       double*               dec_values
                                      )
 {
+  double *kvalue = new double[model->numSVs];
+  svm_kernel_values (model, x, kvalue);
+
   if  (model->param.svm_type == SVM_Type::ONE_CLASS    ||
        model->param.svm_type == SVM_Type::EPSILON_SVR  ||
        model->param.svm_type == SVM_Type::NU_SVR
@@ -3813,22 +3941,13 @@ void  SVM289_MFS::svm_predict_values (const Svm_Model*      model,
     double *sv_coef = model->sv_coef[0];
     double sum = 0;
     for  (kkuint32 i = 0;  i < model->numSVs;  i++)
-      sum += sv_coef[i] * Kernel::k_function (x, 
-                                              model->SV[i], 
-                                              model->param, 
-                                              model->selFeatures
-                                             );
+      sum += sv_coef[i] * kvalue[i];
     sum -= model->rho[0];
     *dec_values = sum;
   }
   else
   {
     kkuint32 nr_class = model->nr_class;
-    kkuint32 numSVs   = model->numSVs;
-    
-    double *kvalue = new double[numSVs];
-    for  (kkuint32 i = 0;  i < numSVs;  i++)
-      kvalue[i] = Kernel::k_function (x, model->SV[i], model->param, model->selFeatures);
 
     kkint32 *start = new kkint32[nr_class];
     start[0] = 0;
@@ -3862,9 +3981,10 @@ void  SVM289_MFS::svm_predict_values (const Svm_Model*      model,
       }
     }
 
-    delete  kvalue;   kvalue = NULL;
-    delete  start;    start  = NULL;
+    delete[]  start;    start  = NULL;
   }
+
+  delete[]  kvalue;   kvalue = NULL;
 }  /* svm_predict_values */
 
 
@@ -3930,6 +4050,20 @@ double  SVM289_MFS::svm_predict_probability (Svm_Model*            model,
                                              double*               classProbabilities,
                                              kkint32*              votes
                                             )
+{
+  return  svm_predict_probability (model, x, classProbabilities, votes, model->DecValues (), model->PairwiseProb (), model->ProbEstimates ());
+}  /* svm_predict_probability */
+
+
+
+double  SVM289_MFS::svm_predict_probability (const Svm_Model*      model, 
+                                             const FeatureVector&  x, 
+                                             double*               classProbabilities,
+                                             kkint32*              votes,
+                                             double*               dec_values,
+                                             double**              pairwise_prob,
+                                             double*               prob_estimates
+                                            )
 {
   double  probParam = model->param.probParam;
 
@@ -3940,10 +4074,6 @@ double  SVM289_MFS::svm_predict_probability (Svm_Model*            model,
     kkint32   i;
     kkint32   nr_class = model->nr_class;
 
-    double*  prob_estimates = model->ProbEstimates ();
-    double*  dec_values     = model->DecValues     ();
-    double** pairwise_prob  = model->PairwiseProb  ();
-
     for  (i = 0;  i < nr_class;  ++i)
       votes[i] = 0;
 
@@ -3977,10 +4107,7 @@ double  SVM289_MFS::svm_predict_probability (Svm_Model*            model,
       }
     }
 
-    // The 'pairwise_prob' and 'prob_estimates' variables are actually located
-    // in 'model'.  So by calling 'NormalizeProbability'  we normalize 
-    // 'prob_estimates'.
-    model->NormalizeProbability (); 
+    NormalizePairwiseProbability (model->nr_class, pairwise_prob, prob_estimates);
 
     //multiclass_probability (nr_class, pairwise_prob, prob_estimates);
 
@@ -4020,7 +4147,8 @@ SVM289_MFS::Svm_Model::Svm_Model ():
   weOwnSupportVectors (true),
   dec_values          (NULL),
   pairwise_prob       (NULL),
-  prob_estimates      (NULL)
+  prob_estimates      (NULL),
+   packedSVs           (NULL)
 {
 }
 
@@ -4044,7 +4172,8 @@ SVM289_MFS::Svm_Model::Svm_Model (const Svm_Model&  _model,
   weOwnSupportVectors (_model.weOwnSupportVectors),
   dec_values          (NULL),
   pairwise_prob       (NULL),
-  prob_estimates      (NULL)
+  prob_estimates      (NULL),
+   packedSVs           (NULL)
 {
   if  (nr_class < 1)
   {
@@ -4136,7 +4265,8 @@ SVM289_MFS::Svm_Model::Svm_Model (FileDescConstPtr _fileDesc):
    weOwnSupportVectors (false),
    dec_values          (NULL),
    pairwise_prob       (NULL),
-   prob_estimates      (NULL)
+   prob_estimates      (NULL),
+   packedSVs           (NULL)
 {
 }
 
@@ -4160,7 +4290,8 @@ SVM289_MFS::Svm_Model::Svm_Model (const svm_parameter&  _param,
    weOwnSupportVectors (false),
    dec_values          (NULL),
    pairwise_prob       (NULL),
-   prob_estimates      (NULL)
+   prob_estimates      (NULL),
+   packedSVs           (NULL)
 {
 }
 
@@ -4209,9 +4340,36 @@ void SVM289_MFS::Svm_Model::CleanUpMemory ()
   dec_values = NULL;
   delete  prob_estimates;
   prob_estimates = NULL;
+
+  DeletePackedSVs ();
 }  /* CleanUpMemory */
 
 
+
+void  SVM289_MFS::Svm_Model::DeletePackedSVs ()
+{
+  delete  packedSVs.exchange (NULL);
+}
+
+
+
+const PackedFeatureVectors&  SVM289_MFS::Svm_Model::PackedSVs ()  const
+{
+  PackedFeatureVectorsPtr  p = packedSVs.load (std::memory_order_acquire);
+  if  (p)
+    return  *p;
+
+  std::lock_guard<std::mutex>  lock (packedSVsMutex);
+  p = packedSVs.load (std::memory_order_relaxed);
+  if  (!p)
+  {
+    p = new PackedFeatureVectors (SV, selFeatures);
+    packedSVs.store (p, std::memory_order_release);
+  }
+  return  *p;
+}  /* PackedSVs */
+
+
 kkMemSize  SVM289_MFS::Svm_Model::MemoryConsumedEstimated ()  const
 {
   kkuint32   numBinaryClassCombos = nr_class * (nr_class - 1) / 2;
@@ -4306,9 +4464,35 @@ void  SVM289_MFS::Svm_Model::WriteXML (const KKStr&  varName,
   if  (nSV)
       XmlElementArrayUInt32::WriteXML (nr_class, nSV, "nSV", o);
 
+  // With a binary container attached the support vectors are written as arrays when they all have the
+  // same number of features; otherwise one 'SupportVector' line each.
+  kkuint32  svNumFeatures = (numSVs > 0) ? SV[0].NumOfFeatures () : 0;
+  bool  svsAsArrays = (BinaryContainerWriter::AttachedTo (o) != NULL)  &&  (param.kernel_type != Kernel_Type::PRECOMPUTED);
+  for  (kkuint32 i = 0;  (i < numSVs)  &&  svsAsArrays;  ++i)
+    svsAsArrays = (SV[i].NumOfFeatures () == svNumFeatures);
+
+  if  (svsAsArrays)
+  {
+    VectorKKStr  svNames;
+    vector<float>  svFeatureData;
+    svFeatureData.reserve (numSVs * svNumFeatures);
+    for  (kkuint32 i = 0;  i < numSVs;  ++i)
+    {
+      const  FeatureVector&  p = SV[i];
+      svNames.push_back (p.ExampleFileName ());
+      svFeatureData.insert (svFeatureData.end (), p.FeatureData (), p.FeatureData () + svNumFeatures);
+    }
+
+    svNames.WriteXML ("SvNames", o);
+    for  (kkuint32 j = 0;  j < nr_class - 1;  j++)
+      XmlElementArrayDouble::WriteXML (numSVs, sv_coef[j], "SvCoef", o);
+    XmlElementUInt32::WriteXML (svNumFeatures, "SvNumFeatures", o);
+    XmlElementArrayFloat::WriteXML ((kkuint32)svFeatureData.size (), svFeatureData.data (), "SvFeatureData", o);
+  }
+
   char buff[128];
 
-  for  (kkuint32 i = 0;  i < numSVs;  ++i)
+  for  (kkuint32 i = 0;  (i < numSVs)  &&  (!svsAsArrays);  ++i)
   {
     const  FeatureVector&  p = SV[i];
 
@@ -4355,6 +4539,10 @@ void  SVM289_MFS::Svm_Model::ReadXML (XmlStream&      s,
   weOwnSupportVectors = true;
 
   KKStr  svmParametersStr;
+  VectorKKStr  svNames;
+  kkuint32     svNumFeatures   = 0;
+  kkuint32     numSvCoefLoaded = 0;
+
   XmlTokenPtr  t = s.GetNextToken (cancelFlag, log);
   while  (t  &&  (!cancelFlag))
   {
@@ -4445,6 +4633,48 @@ void  SVM289_MFS::Svm_Model::ReadXML (XmlStream&      s,
           nSV = nSVXml->ToUnit32Array();
         }
 
+        else if  (varName.EqualIgnoreCase ("SvNames")  &&  (typeid (*e) == typeid (XmlElementVectorKKStr)))
+        {
+          const VectorKKStr*  names = dynamic_cast<XmlElementVectorKKStrPtr> (e)->Value ();
+          svNames.assign (names->begin (), names->end ());
+        }
+
+        else if  (varName.EqualIgnoreCase ("SvCoef")  &&  (typeid (*e) == typeid (XmlElementArrayDouble)))
+        {
+          XmlElementArrayDoublePtr  coefArray = dynamic_cast<XmlElementArrayDoublePtr> (e);
+          KKCheck((numSvCoefLoaded < nr_class - 1)  &&  (coefArray->Count () == numSVs),
+                  "SVM289_MFS::Svm_Model::ReadXML  Unexpected SvCoef;  Count: " << coefArray->Count () << " numSVs: " << numSVs)
+          if  (!sv_coef)
+          {
+            sv_coef = new double*[nr_class - 1];
+            for  (kkuint32 j = 0;  j < nr_class - 1;  ++j)
+              sv_coef[j] = NULL;
+          }
+          sv_coef[numSvCoefLoaded] = coefArray->TakeOwnership ();
+          ++numSvCoefLoaded;
+        }
+
+        else if  (varName.EqualIgnoreCase ("SvNumFeatures"))
+        {
+          svNumFeatures = valueUint32.value_or (valueInt32.value_or (0));
+        }
+
+        else if  (varName.EqualIgnoreCase ("SvFeatureData")  &&  (typeid (*e) == typeid (XmlElementArrayFloat)))
+        {
+          XmlElementArrayFloatPtr  featureData = dynamic_cast<XmlElementArrayFloatPtr> (e);
+          KKCheck((featureData->Count () == numSVs * svNumFeatures)  &&  (svNames.size () == numSVs)  &&  (SV.QueueSize () == 0),
+                  "SVM289_MFS::Svm_Model::ReadXML  SvFeatureData Count: " << featureData->Count () << " does not match numSVs: " << numSVs << " SvNumFeatures: " << svNumFeatures)
+          const float*  row = featureData->Value ();
+          for  (kkuint32 i = 0;  i < numSVs;  ++i, row += svNumFeatures)
+          {
+            FeatureVectorPtr  fv = new FeatureVector (svNumFeatures);
+            fv->ExampleFileName (svNames[i]);
+            if  (svNumFeatures > 0)
+              memcpy (fv->FeatureDataAlter (), row, svNumFeatures * sizeof (float));
+            SV.PushOnBack (fv);
+          }
+        }
+
         else if  (varName.EqualIgnoreCase ("SupportVector"))
         {
           kkint32 m = nr_class - 1;
@@ -4474,9 +4704,11 @@ void  SVM289_MFS::Svm_Model::ReadXML (XmlStream&      s,
             kkint32  numOffeatures  = p.GetNextTokenInt ("\t");
 
             FeatureVectorPtr  fv = new FeatureVector (numOffeatures);
+            fv->ExampleFileName (imageFileName);
 
+            kkuint32  svIdx = SV.QueueSize ();
             for  (kkuint32  j = 0;  (j < (nr_class - 1))  &&  p.MoreTokens ();  ++j)
-              sv_coef[j][i] = p.GetNextTokenDouble ("\t");
+              sv_coef[j][svIdx] = p.GetNextTokenDouble ("\t");
 
             if  (param.kernel_type == Kernel_Type::PRECOMPUTED)
             {
@@ -4517,6 +4749,16 @@ void  SVM289_MFS::Svm_Model::NormalizeProbability ()
   if  (pairwise_prob == NULL)
     return;
 
+  NormalizePairwiseProbability (nr_class, pairwise_prob, prob_estimates);
+}  /* NormalizeProbability */
+
+
+
+void  SVM289_MFS::NormalizePairwiseProbability (kkuint32  nr_class,
+                                                double**  pairwise_prob,
+                                                double*   prob_estimates
+                                               )
+{
   double  totalProb = 0.0;
 
   for  (kkuint32 x = 0;  x < nr_class;  x++)
@@ -4533,7 +4775,7 @@ void  SVM289_MFS::Svm_Model::NormalizeProbability ()
 
   for  (kkuint32 x = 0;  x < nr_class;  x++)
     prob_estimates[x] /= totalProb;
-}  /* NormalizeProbability */
+}  /* NormalizePairwiseProbability */
 
 
 
@@ -1,6 +1,8 @@
 #ifndef _SVM2_
 #define _SVM2_
 
+#include <atomic>
+#include <mutex>
 #include <string.h>
 #include <string>
 
@@ -12,6 +14,7 @@
 #include "KKMLLTypes.h"
 #include "FeatureNumList.h"
 #include "FeatureVector.h"
+#include "KernelEngine.h"
 
 using namespace KKMLL;
 
@@ -182,6 +185,13 @@ namespace  SVM289_MFS
 
     void  NormalizeProbability ();
 
+    /**
+     *@brief  Selected features of the support vectors packed for KernelEngine; built the first time it is needed.
+     *@details  Safe to call from more than one thread at the same time; must not be called while 'SV' is being
+     * modified.
+     */
+    const PackedFeatureVectors&  PackedSVs ()  const;
+
 
     virtual  void  ReadXML (XmlStream&      s,
                             XmlTagConstPtr  tag,
@@ -219,6 +229,12 @@ namespace  SVM289_MFS
     double*    dec_values;
     double**   pairwise_prob;
     double*    prob_estimates;
+
+  private:
+    void  DeletePackedSVs ();
+
+    mutable std::atomic<PackedFeatureVectorsPtr>  packedSVs;
+    mutable std::mutex                            packedSVsMutex;
   };
 
   typedef  XmlElementTemplate<Svm_Model>  XmlElementSvm_Model;
@@ -241,6 +257,23 @@ namespace  SVM289_MFS
   double  svm_get_svr_probability (const struct Svm_Model *model);
 
 
+  /**
+   *@brief  Computes the kernel between 'x' and every support vector in 'model' using KernelEngine.
+   *@details  'kvalue[i]' will equal 'svm_kernel_value (x, model->SV[i], model->param, model->selFeatures)' to
+   * within the tolerance documented in KernelEngine.h.
+   */
+  void  svm_kernel_values (const Svm_Model*      model,
+                           const FeatureVector&  x,
+                           double*               kvalue
+                          );
+
+  /** @brief  The kernel between 'x' and 'y' evaluated one feature at a time;  the reference for 'svm_kernel_values'. */
+  double  svm_kernel_value (const FeatureVector&   x,
+                            const FeatureVector&   y,
+                            const svm_parameter&   param,
+                            const FeatureNumList&  selFeatures
+                           );
+
   void  svm_predict_values  (const Svm_Model*      model, 
                              const FeatureVector&  x,
                              double*               dec_values
@@ -258,6 +291,22 @@ namespace  SVM289_MFS
                                   kkint32*              votes
                                  );
 
+  /**
+   *@brief  Same as above except that the work areas are supplied by the caller rather than taken from 'model'.
+   *@details  Lets several threads predict with one 'model' at the same time.
+   *@param[out] dec_values      'nr_class * (nr_class - 1) / 2' decision values.
+   *@param[out] pairwise_prob   'nr_class' rows of 'nr_class';  the pair-wise probabilities of this prediction.
+   *@param[out] prob_estimates  'nr_class' probabilities indexed the same as 'model->label'.
+   */
+  double svm_predict_probability (const Svm_Model*      model, 
+                                  const FeatureVector&  x, 
+                                  double*               classProbabilities,
+                                  kkint32*              votes,
+                                  double*               dec_values,
+                                  double**              pairwise_prob,
+                                  double*               prob_estimates
+                                 );
+
   void svm_destroy_model (struct Svm_Model*&  model);
 
 
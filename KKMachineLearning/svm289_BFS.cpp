@@ -855,6 +855,7 @@ public:
   {
     //swap (x[i], x[j]);
     x->SwapIndexes (i, j);
+    swap (packedIdx[i], packedIdx[j]);
     if  (x_square) 
       swap (x_square[i], x_square[j]);
   }
@@ -862,14 +863,28 @@ public:
 protected:
   double (Kernel::*kernel_function) (kkint32 i, kkint32 j) const;
 
+  /**
+   *@brief  Computes the kernel of example 'i' against examples 'start' thru 'len - 1' in one pass.
+   *@details  Uses KernelEngine to evaluate the whole row at once; 'results[j - start]' is set to the
+   * same value 'kernel_function (i, j)' returns, to within the tolerance documented in KernelEngine.h.
+   */
+  void  KernelRow (kkint32  i,
+                   kkint32  start,
+                   kkint32  len,
+                   double*  results
+                  )  const;
+
 private:
-  kkint32               l;
-  kkint32               numSelFeatures;
-  kkint32               *selFeatures;
-  FeatureVectorListPtr  x;
-  double*               x_square;
+  kkint32                  l;
+  kkint32                  numSelFeatures;
+  kkint32                  *selFeatures;
+  FeatureVectorListPtr     x;
+  double*                  x_square;
 
-  float                 **preComputed;
+  PackedFeatureVectorsPtr  packed;     /**< Selected features of 'x' packed for KernelEngine;  rows are never moved. */
+  kkint32*                 packedIdx;  /**< packedIdx[i] = row in 'packed' of example currently at index 'i'.      */
+
+  float                    **preComputed;
 
   // svm_parameter
   const Kernel_Type     kernel_type;
@@ -882,31 +897,36 @@ private:
               )  const;
 
 
+  double  dot (kkint32 i, kkint32 j) const
+  {
+    return  KernelEngine::Dot (packed->Row (packedIdx[i]), packed->Row (packedIdx[j]), packed->Stride ());
+  }
+
 
   double kernel_linear (kkint32 i, kkint32 j) const
   {
-    return dot ((*x)[i], (*x)[j]);
+    return dot (i, j);
   }
 
 
 
   double  kernel_poly (kkint32 i, kkint32 j) const
   {
-    return  powi (gamma * dot((*x)[i], (*x)[j]) + coef0, degree);
+    return  powi (gamma * dot (i, j) + coef0, degree);
   }
 
 
 
   double  kernel_rbf (kkint32 i, kkint32 j) const
   {
-    return exp (-gamma * (x_square[i] + x_square[j] - 2 * dot ((*x)[i], (*x)[j])));
+    return exp (-gamma * (x_square[i] + x_square[j] - 2 * dot (i, j)));
   }
 
 
 
   double kernel_sigmoid (kkint32 i, kkint32 j) const
   {
-    return tanh (gamma * dot ((*x)[i], (*x)[j]) + coef0);
+    return tanh (gamma * dot (i, j) + coef0);
   }
 
 
@@ -931,6 +951,8 @@ SVM289_BFS::Kernel::Kernel (const FeatureVectorList&  _x,
    selFeatures    (nullptr),
    x              (nullptr),
    x_square       (nullptr),
+   packed         (nullptr),
+   packedIdx      (nullptr),
    preComputed    (nullptr),
    kernel_type    (_param.kernel_type), 
    degree         (_param.degree),
@@ -945,6 +967,11 @@ SVM289_BFS::Kernel::Kernel (const FeatureVectorList&  _x,
   for  (kkint32 zed = 0;  zed < numSelFeatures;  zed++)
     selFeatures[zed] = _selFeatures[zed];
 
+  packed = new PackedFeatureVectors (*x, _selFeatures);
+  packedIdx = new kkint32[l];
+  for  (kkint32 zed = 0;  zed < l;  zed++)
+    packedIdx[zed] = zed;
+
   switch  (kernel_type)
   {
     case SVM289_BFS::Kernel_Type::LINEAR:
@@ -988,7 +1015,7 @@ SVM289_BFS::Kernel::Kernel (const FeatureVectorList&  _x,
   {
     x_square = new double[l];
     for  (kkint32 i = 0;  i < l;  i++)
-      x_square[i] = dot ((*x)[i], (*x)[i]);
+      x_square[i] = packed->SquaredNorm (i);
   }
 
   else
@@ -1003,6 +1030,8 @@ SVM289_BFS::Kernel::~Kernel()
 {
   delete[] selFeatures;    selFeatures = NULL;
   delete[] x_square;       x_square    = NULL;
+  delete[] packedIdx;      packedIdx   = NULL;
+  delete   packed;         packed      = NULL;
 
   if  (preComputed)
   {
@@ -1042,6 +1071,55 @@ double  SVM289_BFS::Kernel::dot (const FeatureVector&  px,
 
 
 
+void  SVM289_BFS::Kernel::KernelRow (kkint32  i,
+                                     kkint32  start,
+                                     kkint32  len,
+                                     double*  results
+                                    )  const
+{
+  kkint32  count = len - start;
+  if  (count <= 0)
+    return;
+
+  if  (kernel_type == Kernel_Type::PRECOMPUTED)
+  {
+    for  (kkint32 j = start;  j < len;  ++j)
+      results[j - start] = kernel_precomputed (i, j);
+    return;
+  }
+
+  KernelEngine::DotOneToMany (packed->Row (packedIdx[i]), *packed, packedIdx + start, count, results);
+
+  switch  (kernel_type)
+  {
+  case  Kernel_Type::LINEAR:
+    break;
+
+  case  Kernel_Type::POLY:
+    for  (kkint32 k = 0;  k < count;  ++k)
+      results[k] = powi (gamma * results[k] + coef0, degree);
+    break;
+
+  case  Kernel_Type::RBF:
+    {
+      double  xsi = x_square[i];
+      for  (kkint32 k = 0;  k < count;  ++k)
+        results[k] = exp (-gamma * (xsi + x_square[start + k] - 2 * results[k]));
+    }
+    break;
+
+  case  Kernel_Type::SIGMOID:
+    for  (kkint32 k = 0;  k < count;  ++k)
+      results[k] = tanh (gamma * results[k] + coef0);
+    break;
+
+  default:
+    break;
+  }
+}  /* KernelRow */
+
+
+
 double  SVM289_BFS::Kernel::DotStatic (const FeatureVector&   px, 
                                        const FeatureVector&   py,
                                        const FeatureNumList&  selFeatures
@@ -2177,6 +2255,7 @@ public:
     clone (y, y_, prob.l);
     cache = new Cache (prob.l, (kkint32)(param.cache_size * (1 << 20)));
     QD = new Qfloat[prob.l];
+    kernelRow = new double[prob.l];
 
     for  (kkint32 i = 0;  i < prob.l;  i++)
       QD[i] = (Qfloat)(this->*kernel_function)(i, i);
@@ -2189,8 +2268,9 @@ public:
     kkint32 start, j;
     if  ((start = cache->get_data(i,&data,len)) < len)
     {
+      KernelRow (i, start, len, kernelRow);
       for  (j = start;  j < len;  j++)
-        data[j] = (Qfloat)(y[i] * y[j] * (this->*kernel_function)(i, j));
+        data[j] = (Qfloat)(y[i] * y[j] * kernelRow[j - start]);
     }
     return data;
   }
@@ -2219,12 +2299,14 @@ public:
     delete[] y;
     delete cache;
     delete[] QD;
+    delete[] kernelRow;
   }
 
 private:
-  schar*  y;
-  Cache*  cache;
-  Qfloat* QD;
+  schar*   y;
+  Cache*   cache;
+  Qfloat*  QD;
+  double*  kernelRow;   /**< Work area for 'KernelRow'. */
 };  /* SVC_Q */
 
 
@@ -2241,6 +2323,7 @@ public:
   {
     cache = new Cache (prob.l, (kkint32)(param.cache_size * (1<<20)));
     QD = new Qfloat[prob.l];
+    kernelRow = new double[prob.l];
     for  (kkint32 i = 0;  i < prob.l;  i++)
       QD[i]= (Qfloat)(this->*kernel_function)(i, i);
   }
@@ -2253,8 +2336,9 @@ public:
     kkint32 start, j;
     if  ((start = cache->get_data(i,&data,len)) < len)
     {
+      KernelRow (i, start, len, kernelRow);
       for  (j=start;  j < len;  j++)
-        data[j] = (Qfloat)(this->*kernel_function)(i,j);
+        data[j] = (Qfloat)kernelRow[j - start];
     }
     return data;
   }
@@ -2281,12 +2365,14 @@ public:
   {
     delete cache;
     delete[] QD;
+    delete[] kernelRow;
   }
 
 
 private:
   Cache *cache;
   Qfloat *QD;
+  double *kernelRow;   /**< Work area for 'KernelRow'. */
 
 };  /* ONE_CLASS_Q */
 
@@ -2321,6 +2407,7 @@ public:
     buffer [0] = new Qfloat [2 * l];
     buffer [1] = new Qfloat [2 * l];
     next_buffer = 0;
+    kernelRow = new double[l];
   }
 
 
@@ -2341,8 +2428,9 @@ public:
 
     if  (cache->get_data (real_i, &data, l) < l)
     {
+      KernelRow (real_i, 0, l, kernelRow);
       for  (j = 0;  j < l;  j++)
-        data[j] = (Qfloat)(this->*kernel_function)(real_i, j);
+        data[j] = (Qfloat)kernelRow[j];
     }
 
     // reorder and copy
@@ -2371,6 +2459,7 @@ public:
     delete[] buffer[0];
     delete[] buffer[1];
     delete[] QD;
+    delete[] kernelRow;
   }
 
 
@@ -2383,6 +2472,7 @@ private:
   mutable kkint32  next_buffer;
   Qfloat*        buffer[2];
   Qfloat*        QD;
+  double*        kernelRow;   /**< Work area for 'KernelRow'. */
 };   /* SVR_Q */
 
 
@@ -3839,11 +3929,72 @@ double svm_get_svr_probability (const svm_model *model)
 
 
 
+namespace  SVM289_BFS
+{
+  /**
+   *@brief  Computes the kernel between 'x' and every support vector in 'model' using KernelEngine.
+   *@details  'kvalue[i]' will equal 'Kernel::k_function (x, model->SV[i], ...)' to within the tolerance
+   * documented in KernelEngine.h.
+   */
+  void  svm_kernel_values (const svm_model*      model,
+                           const FeatureVector&  x,
+                           double*               kvalue
+                          );
+}
+
+
+
+void  SVM289_BFS::svm_kernel_values (const svm_model*      model,
+                                     const FeatureVector&  x,
+                                     double*               kvalue
+                                    )
+{
+  const svm_parameter&  param = model->param;
+  kkint32  l = model->l;
+
+  if  (param.kernel_type == Kernel_Type::PRECOMPUTED)
+  {
+    for  (kkint32 i = 0;  i < l;  i++)
+      kvalue[i] = Kernel::k_function (x, model->SV[i], param, model->selFeatures);
+    return;
+  }
+
+  const PackedFeatureVectors&  svs = model->PackedSVs ();
+
+  PackedFeatureVectors  query (1, svs.NumCols ());
+  query.PackRow (0, x, model->selFeatures);
+
+  if  (param.kernel_type == Kernel_Type::RBF)
+  {
+    KernelEngine::SquaredDistanceOneToMany (query.Row (0), svs, NULL, l, kvalue);
+    for  (kkint32 i = 0;  i < l;  i++)
+      kvalue[i] = exp (-param.gamma * kvalue[i]);
+    return;
+  }
+
+  KernelEngine::DotOneToMany (query.Row (0), svs, NULL, l, kvalue);
+  if  (param.kernel_type == Kernel_Type::POLY)
+  {
+    for  (kkint32 i = 0;  i < l;  i++)
+      kvalue[i] = powi (param.gamma * kvalue[i] + param.coef0, param.degree);
+  }
+  else if  (param.kernel_type == Kernel_Type::SIGMOID)
+  {
+    for  (kkint32 i = 0;  i < l;  i++)
+      kvalue[i] = tanh (param.gamma * kvalue[i] + param.coef0);
+  }
+}  /* svm_kernel_values */
+
+
+
 void  SVM289_BFS::svm_predict_values (const svm_model*      model, 
                                       const FeatureVector&  x, 
                                       double*               dec_values
                                      )
 {
+  double *kvalue = new double[model->l];
+  svm_kernel_values (model, x, kvalue);
+
   if  (model->param.svm_type == SVM_Type::ONE_CLASS    ||
        model->param.svm_type == SVM_Type::EPSILON_SVR  ||
        model->param.svm_type == SVM_Type::NU_SVR
@@ -3852,11 +4003,7 @@ void  SVM289_BFS::svm_predict_values (const svm_model*      model,
     double *sv_coef = model->sv_coef[0];
     double sum = 0;
     for  (kkuint32 i = 0;  i < model->l;  i++)
-      sum += sv_coef[i] * Kernel::k_function (x, 
-                                              model->SV[i], 
-                                              model->param, 
-                                              model->selFeatures
-                                             );
+      sum += sv_coef[i] * kvalue[i];
     sum -= model->rho[0];
     *dec_values = sum;
   }
@@ -3864,11 +4011,6 @@ void  SVM289_BFS::svm_predict_values (const svm_model*      model,
   {
     kkint32 i;
     kkint32 nr_class = model->nr_class;
-    kkint32 l = model->l;
-    
-    double *kvalue = new double[l];
-    for  (i = 0;  i < l;  i++)
-      kvalue[i] = Kernel::k_function (x, model->SV[i], model->param, model->selFeatures);
 
     kkint32 *start = new kkint32[nr_class];
     start[0] = 0;
@@ -3902,9 +4044,10 @@ void  SVM289_BFS::svm_predict_values (const svm_model*      model,
       }
     }
 
-    delete  kvalue;   kvalue = NULL;
-    delete  start;    start  = NULL;
+    delete[]  start;    start  = NULL;
   }
+
+  delete[]  kvalue;   kvalue = NULL;
 }  /* svm_predict_values */
 
 
@@ -4062,7 +4205,8 @@ SVM289_BFS::svm_model::svm_model (const svm_model&  _model,
   weOwnSupportVectors (_model.weOwnSupportVectors),
   dec_values          (NULL),
   pairwise_prob       (NULL),
-  prob_estimates      (NULL)
+  prob_estimates      (NULL),
+  packedSVs           (NULL)
 {
   _log.Level (50) << "SVM289_BFS::svm_model::svm_model" << endl;
   kkint32  m = nr_class - 1;
@@ -4149,7 +4293,8 @@ SVM289_BFS::svm_model::svm_model (FileDescConstPtr  _fileDesc,
    weOwnSupportVectors (false),
    dec_values          (NULL),
    pairwise_prob       (NULL),
-   prob_estimates      (NULL)
+   prob_estimates      (NULL),
+   packedSVs           (NULL)
 {
   _log.Level (50) << "SVM289_BFS::svm_model::svm_model" << endl;
 }
@@ -4175,7 +4320,8 @@ SVM289_BFS::svm_model::svm_model (const svm_parameter&  _param,
    weOwnSupportVectors (false),
    dec_values          (NULL),
    pairwise_prob       (NULL),
-   prob_estimates      (NULL)
+   prob_estimates      (NULL),
+   packedSVs           (NULL)
 
 {
   _log.Level (50) << "SVM289_BFS::svm_model::svm_model" << endl;
@@ -4201,7 +4347,8 @@ SVM289_BFS::svm_model::svm_model (istream&          _in,
    weOwnSupportVectors (false),
    dec_values          (NULL),
    pairwise_prob       (NULL),
-   prob_estimates      (NULL)
+   prob_estimates      (NULL),
+   packedSVs           (NULL)
 {
   Read (_in, _fileDesc, _log);
 }
@@ -4244,10 +4391,37 @@ SVM289_BFS::svm_model::~svm_model ()
   dec_values = NULL;
   delete  prob_estimates;
   prob_estimates = NULL;
+
+  DeletePackedSVs ();
 }
 
 
 
+void  SVM289_BFS::svm_model::DeletePackedSVs ()
+{
+  delete  packedSVs.exchange (NULL);
+}
+
+
+
+const PackedFeatureVectors&  SVM289_BFS::svm_model::PackedSVs ()  const
+{
+  PackedFeatureVectorsPtr  p = packedSVs.load (std::memory_order_acquire);
+  if  (p)
+    return  *p;
+
+  std::lock_guard<std::mutex>  lock (packedSVsMutex);
+  p = packedSVs.load (std::memory_order_relaxed);
+  if  (!p)
+  {
+    p = new PackedFeatureVectors (SV, selFeatures);
+    packedSVs.store (p, std::memory_order_release);
+  }
+  return  *p;
+}  /* PackedSVs */
+
+
+
 double*  SVM289_BFS::svm_model::DecValues () 
 {
   if  (!dec_values)
@@ -4387,6 +4561,7 @@ void  SVM289_BFS::svm_model::Read (istream&          in,
   delete  label;  label = NULL;
   delete  nSV;    nSV   = NULL;
 
+  DeletePackedSVs ();
   SV.DeleteContents ();
 
   kkint32  buffLen = 80 * 1024;
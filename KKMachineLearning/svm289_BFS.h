@@ -3,8 +3,12 @@
 
 #define LIBSVM_VERSION 289
 
+#include  <atomic>
+#include  <mutex>
+
 #include  "FeatureNumList.h"
 #include  "FeatureVector.h"
+#include  "KernelEngine.h"
 #include  "KKStr.h"
 
 using namespace KKMLL;
@@ -191,6 +195,13 @@ namespace  SVM289_BFS
 
     void  NormalizeProbability ();
 
+    /**
+     *@brief  Selected features of the support vectors packed for KernelEngine; built the first time it is needed.
+     *@details  Safe to call from more than one thread at the same time; must not be called while 'SV' is being
+     * modified.
+     */
+    const PackedFeatureVectors&  PackedSVs ()  const;
+
 
     svm_parameter      param;      // parameter
     kkuint32           nr_class;   /**< number of classes, = 2 in regression/one class svm           */
@@ -216,6 +227,12 @@ namespace  SVM289_BFS
     double*    dec_values;
     double**   pairwise_prob;
     double*    prob_estimates;
+
+  private:
+    void  DeletePackedSVs ();
+
+    mutable std::atomic<PackedFeatureVectorsPtr>  packedSVs;
+    mutable std::mutex                            packedSVsMutex;
   };
 
 
@@ -0,0 +1,121 @@
+#include "FirstIncludes.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include "MemoryDebug.h"
+using namespace std;
+
+#if  !defined(WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "KKBaseTypes.h"
+#include "KKException.h"
+#include "KKStr.h"
+#include "OSservices.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "KKJobCoordinator.h"
+using namespace KKJobManagment;
+
+#include "KKJobCoordinatorTest.h"
+
+
+namespace  JobManagerTest
+{
+  KKJobCoordinatorTest::KKJobCoordinatorTest ()
+  {
+  }
+
+
+
+  KKJobCoordinatorTest::~KKJobCoordinatorTest ()
+  {
+  }
+
+
+
+  void  KKJobCoordinatorTest::TestStaleSegment (const KKStr&  testName,
+                                                bool          sized
+                                               )
+  {
+#if  !defined(WIN32)
+    RunLog  log;
+    log.SetLevel (-1);
+
+    KKStr  statusFileName = "KKJobCoordinatorTest_" + testName + ".Status";
+    KKStr  lockFileName   = "KKJobCoordinatorTest_" + testName + ".Lock";
+    KKStr  segmentName = KKJobCoordinator::SharedMemorySegmentName (statusFileName);
+    shm_unlink (segmentName.Str ());
+
+    // What a process that died right after 'shm_open' or 'ftruncate' leaves behind.
+    int  fd = shm_open (segmentName.Str (), O_RDWR | O_CREAT | O_EXCL, 0666);
+    Assert (fd >= 0, testName + "-CreateStale");
+    if  (fd < 0)
+      return;
+    if  (sized)
+      Assert (ftruncate (fd, 4096) == 0, testName + "-SizeStale");
+    close (fd);
+
+    KKJobCoordinatorPtr  first = NULL;
+    KKJobCoordinatorPtr  second = NULL;
+    try
+    {
+      first = KKJobCoordinator::Create (KKJobCoordinator::Backend::SharedMemory, lockFileName, statusFileName, 1, log);
+      second = KKJobCoordinator::Create (KKJobCoordinator::Backend::SharedMemory, lockFileName, statusFileName, 2, log);
+    }
+    catch  (const KKException&  e)
+    {
+      Assert (false, testName + "-Recreated", e.ToString ());
+    }
+
+    if  (first  &&  second)
+    {
+      Assert (first->BackendUsed () == KKJobCoordinator::Backend::SharedMemory, testName + "-Backend");
+
+      // Both have to be on the same initialized segment;  a change reported through one wakes up the other
+      // well before its wait times out.
+      auto  startTime = chrono::steady_clock::now ();
+      std::thread  notifier ([first] ()
+        {
+          std::this_thread::sleep_for (chrono::milliseconds (200));
+          first->Lock ();
+          first->NotifyChange ();
+          first->Unlock ();
+        });
+      second->WaitForChange (30.0f);
+      double  waitedSecs = chrono::duration<double> (chrono::steady_clock::now () - startTime).count ();
+      notifier.join ();
+
+      KKStr  msg;
+      msg << "Waited[" << waitedSecs << "] secs.";
+      Assert (waitedSecs < 10.0, testName + "-SharedSegment", msg);
+
+      second->Lock ();
+      second->Unlock ();
+    }
+
+    delete  first;   first = NULL;
+    delete  second;  second = NULL;
+    shm_unlink (segmentName.Str ());
+#else
+    (void)testName;
+    (void)sized;
+#endif
+  }
+
+
+
+  bool  KKJobCoordinatorTest::RunTests ()
+  {
+    TestStaleSegment ("NeverSized", false);
+    TestStaleSegment ("NeverReady", true);
+    return  FailedCount () == 0;
+  }
+}
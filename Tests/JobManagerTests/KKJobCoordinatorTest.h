@@ -0,0 +1,32 @@
+#pragma once
+#include "KKTest.h"
+#include "KKJobCoordinator.h"
+using namespace KKJobManagment;
+
+namespace  JobManagerTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks that the 'SharedMemory' backend of 'KKJobCoordinator' recovers from a segment whose creator
+   * died before initializing it.
+   *@details  Both a segment that was never sized and one that was sized but never marked ready have to be
+   * replaced with a working one that a second coordinator then shares.
+   */
+  class KKJobCoordinatorTest : public KKTest
+  {
+  public:
+    KKJobCoordinatorTest ();
+
+    virtual ~KKJobCoordinatorTest ();
+
+    virtual const char*  TestName () const { return "KKJobCoordinator"; }
+
+    bool  RunTests () override;
+
+  private:
+    void  TestStaleSegment (const KKStr&  testName,
+                            bool          sized
+                           );
+  };
+}
@@ -0,0 +1,416 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <math.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "OSservices.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "KKJob.h"
+#include "KKJobManager.h"
+using namespace KKJobManagment;
+
+#include "RunInProcessTest.h"
+
+
+namespace
+{
+  /** Shared by every 'TestJob' instance;  'RunInProcess' calls 'ProcessNode' on duplicates from worker threads. */
+  class  JobRecorder
+  {
+  public:
+    static  void  Reset ()
+    {
+      lock_guard<std::mutex>  lock (mutex);
+      completed.clear ();
+      runCounts.clear ();
+      orderViolations = 0;
+    }
+
+    /** For jobs that a previous run had already finished. */
+    static  void  MarkCompleted (kkint32  jobId)
+    {
+      lock_guard<std::mutex>  lock (mutex);
+      completed.insert (jobId);
+    }
+
+    static  void  Started (const KKJob&  j)
+    {
+      lock_guard<std::mutex>  lock (mutex);
+      for  (auto  p: j.Prerequisites ())
+      {
+        if  (completed.count (p) == 0)
+          ++orderViolations;
+      }
+      ++(runCounts[j.JobId ()]);
+    }
+
+    static  void  Finished (const KKJob&  j)
+    {
+      lock_guard<std::mutex>  lock (mutex);
+      completed.insert (j.JobId ());
+    }
+
+    static  kkint32  RunCount (kkint32  jobId)
+    {
+      lock_guard<std::mutex>  lock (mutex);
+      auto  idx = runCounts.find (jobId);
+      return  (idx == runCounts.end ()) ? 0 : idx->second;
+    }
+
+    static  kkuint32  NumJobsRun ()  {lock_guard<std::mutex>  lock (mutex);  return (kkuint32)runCounts.size ();}
+
+    static  kkint32   OrderViolations ()  {lock_guard<std::mutex>  lock (mutex);  return orderViolations;}
+
+  private:
+    static  set<kkint32>         completed;
+    static  std::mutex           mutex;
+    static  kkint32              orderViolations;
+    static  map<kkint32,kkint32> runCounts;
+  };
+
+  set<kkint32>          JobRecorder::completed;
+  std::mutex            JobRecorder::mutex;
+  kkint32               JobRecorder::orderViolations = 0;
+  map<kkint32,kkint32>  JobRecorder::runCounts;
+
+
+
+  class  TestJob:  public  KKJob
+  {
+  public:
+    TestJob (JobManagerPtr  _manager,
+             kkint32        _jobId,
+             RunLog&        _log
+            ):
+        KKJob (_manager, _jobId, -1, 1, _log)
+    {}
+
+    TestJob (JobManagerPtr  _manager):
+        KKJob (_manager)
+    {}
+
+    TestJob (const TestJob&  j):
+        KKJob (j)
+    {}
+
+    static  KKJobPtr  Create (JobManagerPtr  _manager)  {return  new TestJob (_manager);}
+
+    KKJobPtr  Duplicate ()  const  override  {return  new TestJob (*this);}
+
+    const char*  JobType ()  const  override  {return  "TestJob";}
+
+    void  ProcessNode ()  override
+    {
+      JobRecorder::Started (*this);
+
+      // Enough work that the thread's CPU clock moves.
+      volatile double  total = 0.0;
+      for  (kkint32 x = 1;  x < 100000;  ++x)
+        total = total + sqrt ((double)x);
+
+      JobRecorder::Finished (*this);
+      status = jsDone;
+    }
+  };
+
+
+
+  /**
+   * Initial set:  a root job with 'numChains' chains of 'chainLen' jobs hanging off it.  If 'fanOut' is greater than
+   * zero the first expansion adds a job with 'fanOut' jobs waiting on it and one more job waiting on all of those.
+   */
+  class  TestJobManager:  public  KKJobManager
+  {
+  public:
+    TestJobManager (const KKStr&  _managerName,
+                    kkint32       _numChains,
+                    kkint32       _chainLen,
+                    kkint32       _fanOut,
+                    RunLog&       _log
+                   ):
+        KKJobManager (NULL, -1, -1, 1, _managerName, 1, _log),
+        chainLen                   (_chainLen),
+        expanded                   (false),
+        fanOut                     (_fanOut),
+        finalResultsReportGenerated (false),
+        numChains                  (_numChains),
+        rootJobId                  (-1)
+    {}
+
+    TestJobManager (const TestJobManager&  m):
+        KKJobManager (m),
+        chainLen                   (m.chainLen),
+        expanded                   (m.expanded),
+        fanOut                     (m.fanOut),
+        finalResultsReportGenerated (m.finalResultsReportGenerated),
+        numChains                  (m.numChains),
+        rootJobId                  (m.rootJobId)
+    {}
+
+    KKJobPtr  Duplicate ()  const  override  {return  new TestJobManager (*this);}
+
+    bool     FinalResultsReportGenerated () const  {return finalResultsReportGenerated;}
+    kkint32  RootJobId                   () const  {return rootJobId;}
+
+    kkuint32  NumJobsExpected () const
+    {
+      return  (kkuint32)(1 + numChains * chainLen + ((fanOut > 0) ? (fanOut + 2) : 0));
+    }
+
+  private:
+    KKJobListPtr  JobsCreateInitialSet ()  override
+    {
+      KKJobListPtr  initialSet = new KKJobList (this);
+      TestJob*  root = new TestJob (this, AllocateNextJobId (), Log ());
+      rootJobId = root->JobId ();
+      initialSet->PushOnBack (root);
+
+      for  (kkint32 c = 0;  c < numChains;  ++c)
+      {
+        kkint32  prevJobId = rootJobId;
+        for  (kkint32 x = 0;  x < chainLen;  ++x)
+        {
+          TestJob*  j = new TestJob (this, AllocateNextJobId (), Log ());
+          j->AddPrerequisites (prevJobId);
+          prevJobId = j->JobId ();
+          initialSet->PushOnBack (j);
+        }
+      }
+      return  initialSet;
+    }
+
+    KKJobListPtr  JobsExpandNextSetOfJobs (const KKJobListPtr  jobsJustCompletd)  override
+    {
+      (void)jobsJustCompletd;
+      if  (expanded  ||  (fanOut <= 0))
+        return  NULL;
+      expanded = true;
+
+      KKJobListPtr  expansion = new KKJobList (this);
+      TestJob*  head = new TestJob (this, AllocateNextJobId (), Log ());
+      expansion->PushOnBack (head);
+
+      VectorInt  fanOutJobIds;
+      for  (kkint32 x = 0;  x < fanOut;  ++x)
+      {
+        TestJob*  j = new TestJob (this, AllocateNextJobId (), Log ());
+        j->AddPrerequisites (head->JobId ());
+        fanOutJobIds.push_back (j->JobId ());
+        expansion->PushOnBack (j);
+      }
+
+      TestJob*  tail = new TestJob (this, AllocateNextJobId (), Log ());
+      tail->AddPrerequisites (fanOutJobIds);
+      expansion->PushOnBack (tail);
+      return  expansion;
+    }
+
+    void  GenerateFinalResultsReport ()  override  {finalResultsReportGenerated = true;}
+
+    void  LoadRunTimeData ()  override  {}
+
+    void  StatusFileInitialize (ostream&  o)  override  {(void)o;}
+
+    kkint32  chainLen;
+    bool     expanded;
+    kkint32  fanOut;
+    bool     finalResultsReportGenerated;
+    kkint32  numChains;
+    kkint32  rootJobId;
+  };
+}  /* namespace */
+
+
+
+namespace  JobManagerTest
+{
+  RunInProcessTest::RunInProcessTest ()
+  {
+    KKJob::RegisterConstructor ("TestJob", TestJob::Create);
+  }
+
+
+
+  RunInProcessTest::~RunInProcessTest ()
+  {
+  }
+
+
+
+  void  RunInProcessTest::DeleteJobSetFiles (const KKStr&  managerName)
+  {
+    osDeleteFile (managerName + ".Status");
+    osDeleteFile (managerName + ".Lock");
+  }
+
+
+
+  void  RunInProcessTest::CheckReload (const KKStr&  testName,
+                                       const KKStr&  managerName,
+                                       kkuint32      numJobs,
+                                       double        cpuTimeTotalUsed
+                                      )
+  {
+    RunLog  log;
+    log.SetLevel (-1);
+    TestJobManager  reloaded (managerName, 0, 0, 0, log);
+    bool  successful = false;
+    reloaded.InitilizeJobManager (successful);
+
+    bool  allDone = successful  &&  (reloaded.Jobs ()->QueueSize () == numJobs)  &&  reloaded.Jobs ()->AreAllJobsDone ();
+    KKStr  msg;
+    msg << "Jobs[" << reloaded.Jobs ()->QueueSize () << "]  Expected[" << numJobs << "]";
+    Assert (allDone, testName + "-ReloadAllDone", msg);
+    Assert (reloaded.Status () == KKJob::jsDone, testName + "-ReloadStatusDone");
+
+    // The journal writes CPU time with 6 significant digits.
+    double  diff = fabs (reloaded.CpuTimeTotalUsed () - cpuTimeTotalUsed);
+    msg = "";
+    msg << "Reloaded[" << reloaded.CpuTimeTotalUsed () << "]  InProcess[" << cpuTimeTotalUsed << "]";
+    Assert (diff <= 1.0e-4 * cpuTimeTotalUsed + 1.0e-6, testName + "-ReloadCpuTimeTotalUsed", msg);
+  }
+
+
+
+  void  RunInProcessTest::TestDependencyOrder (kkuint32  numThreads)
+  {
+    KKStr  testName;
+    testName << "DependencyOrder-Threads" << numThreads;
+
+    KKStr  managerName = "RunInProcessTest_Order" + StrFromUint32 (numThreads);
+    DeleteJobSetFiles (managerName);
+    JobRecorder::Reset ();
+
+    RunLog  log;
+    log.SetLevel (-1);
+    double  cpuTimeTotalUsed = 0.0;
+    kkuint32  numJobsExpected = 0;
+    {
+      TestJobManager  manager (managerName, 100, 4, 200, log);
+      numJobsExpected = manager.NumJobsExpected ();
+
+      bool  successful = false;
+      manager.InitilizeJobManager (successful);
+      Assert (successful, testName + "-Initialize");
+
+      manager.RunInProcess (numThreads);
+
+      Assert (JobRecorder::OrderViolations () == 0, testName + "-PrerequisitesDoneFirst");
+      Assert (JobRecorder::NumJobsRun () == numJobsExpected, testName + "-AllJobsRan");
+
+      bool     eachOnce = true;
+      bool     cpuTimeRecorded = true;
+      double   sumOfJobs = 0.0;
+      for  (auto  j: *(manager.Jobs ()))
+      {
+        eachOnce = eachOnce  &&  (JobRecorder::RunCount (j->JobId ()) == 1)  &&  (j->Status () == KKJob::jsDone);
+        cpuTimeRecorded = cpuTimeRecorded  &&  (j->CpuTimeUsed () > 0.0);
+        sumOfJobs += j->CpuTimeUsed ();
+      }
+      Assert (manager.Jobs ()->QueueSize () == numJobsExpected, testName + "-ExpansionAdded");
+      Assert (eachOnce, testName + "-EachJobOnceAndDone");
+      Assert (cpuTimeRecorded, testName + "-JobCpuTimeUsed");
+
+      cpuTimeTotalUsed = manager.CpuTimeTotalUsed ();
+      KKStr  msg;
+      msg << "SumOfJobs[" << sumOfJobs << "]  CpuTimeTotalUsed[" << cpuTimeTotalUsed << "]";
+      Assert (fabs (sumOfJobs - cpuTimeTotalUsed) <= 1.0e-9 * sumOfJobs, testName + "-CpuTimeTotalUsed", msg);
+
+      Assert (manager.FinalResultsReportGenerated ()  &&  (manager.Status () == KKJob::jsDone), testName + "-FinalReport");
+    }
+
+    CheckReload (testName, managerName, numJobsExpected, cpuTimeTotalUsed);
+    DeleteJobSetFiles (managerName);
+  }
+
+
+
+  void  RunInProcessTest::TestReopenStarted ()
+  {
+    KKStr  testName = "ReopenStarted";
+    KKStr  managerName = "RunInProcessTest_Reopen";
+    DeleteJobSetFiles (managerName);
+    JobRecorder::Reset ();
+
+    RunLog  log;
+    log.SetLevel (-1);
+
+    kkint32   rootJobId = -1;
+    kkint32   startedJobId = -1;
+    kkuint32  numJobsExpected = 0;
+    {
+      TestJobManager  first (managerName, 3, 3, 0, log);
+      bool  successful = false;
+      first.InitilizeJobManager (successful);
+      Assert (successful, testName + "-Initialize");
+      rootJobId = first.RootJobId ();
+      numJobsExpected = first.NumJobsExpected ();
+
+      // What a run that was killed part way through leaves behind:  the root job finished and the first job of
+      // a chain started but never reported back.
+      KKJobPtr  root = first.Jobs ()->LookUpByJobId (rootJobId);
+      KKJobPtr  started = first.Jobs ()->LookUpByJobId (rootJobId + 1);
+      startedJobId = started->JobId ();
+      root->Status (KKJob::jsDone);
+
+      ofstream  statusFile ((managerName + ".Status").Str (), ios::app);
+      statusFile << "KKJob" << "\t" << root->JobType () << "\t" << root->ToStatusStr () << endl
+                 << "JobStatusChange" << "\t" << startedJobId << "\t" << "Started" << endl;
+    }
+    JobRecorder::MarkCompleted (rootJobId);
+
+    {
+      TestJobManager  second (managerName, 3, 3, 0, log);
+      bool  successful = false;
+      second.InitilizeJobManager (successful);
+      Assert (successful, testName + "-Load");
+
+      KKJobPtr  started = second.Jobs ()->LookUpByJobId (startedJobId);
+      Assert ((second.Jobs ()->QueueSize () == numJobsExpected)  &&  started  &&  (started->Status () == KKJob::jsStarted),
+              testName + "-LoadedAsStarted"
+             );
+
+      second.RunInProcess (4);
+
+      Assert (JobRecorder::RunCount (rootJobId) == 0, testName + "-DoneJobNotRerun");
+      Assert (JobRecorder::RunCount (startedJobId) == 1, testName + "-StartedJobReopenedAndRun");
+      Assert (JobRecorder::NumJobsRun () == numJobsExpected - 1, testName + "-OthersRan");
+      Assert (JobRecorder::OrderViolations () == 0, testName + "-PrerequisitesDoneFirst");
+      Assert (second.Jobs ()->AreAllJobsDone ()  &&  (second.Status () == KKJob::jsDone), testName + "-AllDone");
+
+      // The reopen has to be in the journal so that a reload does not see the job as still running.
+      ifstream  statusFile ((managerName + ".Status").Str ());
+      KKStr  expectedLine = "JobStatusChange\t" + StrFromInt32 (startedJobId) + "\tOpen";
+      bool   reopenJournaled = false;
+      string  ln;
+      while  (getline (statusFile, ln))
+        reopenJournaled = reopenJournaled  ||  (expectedLine == ln.c_str ());
+      Assert (reopenJournaled, testName + "-ReopenJournaled");
+
+      CheckReload (testName, managerName, numJobsExpected, second.CpuTimeTotalUsed ());
+    }
+
+    DeleteJobSetFiles (managerName);
+  }
+
+
+
+  bool  RunInProcessTest::RunTests ()
+  {
+    TestDependencyOrder (1);
+    TestDependencyOrder (8);
+    TestReopenStarted ();
+    return  FailedCount () == 0;
+  }
+}
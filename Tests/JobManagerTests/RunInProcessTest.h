@@ -0,0 +1,43 @@
+#pragma once
+#include "KKTest.h"
+#include "KKJobManager.h"
+using namespace KKJobManagment;
+
+namespace  JobManagerTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Runs a 'KKJobManager' job set through 'RunInProcess'.
+   *@details  Chains of jobs hanging off one root job, followed by an expansion that fans out from one job and
+   * back in to another, have to run exactly once each and never before their prerequisites are done;  'CpuTimeUsed'
+   * of the jobs has to add up to 'CpuTimeTotalUsed'.  A job set left with a 'Started' job by a run that did not
+   * finish has that job reopened and run.  In both cases the status file written has to load back with every
+   * job done.
+   */
+  class RunInProcessTest : public KKTest
+  {
+  public:
+    RunInProcessTest ();
+
+    virtual ~RunInProcessTest ();
+
+    virtual const char*  TestName () const { return "RunInProcess"; }
+
+    bool  RunTests () override;
+
+  private:
+    void  TestDependencyOrder (kkuint32  numThreads);
+
+    void  TestReopenStarted ();
+
+    /** @brief  Loads the status file of 'managerName' into a new manager and checks that all 'numJobs' are done. */
+    void  CheckReload (const KKStr&  testName,
+                       const KKStr&  managerName,
+                       kkuint32      numJobs,
+                       double        cpuTimeTotalUsed
+                      );
+
+    static  void  DeleteJobSetFiles (const KKStr&  managerName);
+  };
+}
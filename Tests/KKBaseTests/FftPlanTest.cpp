@@ -0,0 +1,247 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "FftPlan.h"
+#include "kku_fftw.h"
+#include "KKStr.h"
+using namespace KKB;
+
+#include "FftPlanTest.h"
+
+
+namespace  KKBaseTest
+{
+  /** Tolerance on 'RelativeError';  double precision transforms of these lengths come in around 1.0e-14. */
+  const double  fftTolerance = 1.0e-10;
+
+
+
+  FftPlanTest::FftPlanTest ()
+  {
+  }
+
+
+
+  FftPlanTest::~FftPlanTest ()
+  {
+  }
+
+
+
+  double  FftPlanTest::RelativeError (const vector<Complex>&  a,
+                                      const vector<Complex>&  b
+                                     )
+  {
+    double  largest = 0.0;
+    for  (auto z: b)
+      largest = Max (largest, std::abs (z));
+
+    double  largestDiff = 0.0;
+    for  (size_t k = 0;  k < b.size ();  ++k)
+      largestDiff = Max (largestDiff, std::abs (a[k] - b[k]));
+
+    return  (largest > 0.0) ? (largestDiff / largest) : largestDiff;
+  }
+
+
+
+  vector<FftPlanTest::Complex>  FftPlanTest::DirectDft (const vector<Complex>&  src,
+                                                        bool                    forwardTransform
+                                                       )
+  {
+    const double  twoPi = 6.283185307179586476925286766559;
+    size_t  n = src.size ();
+    double  sign = forwardTransform ? -1.0 : 1.0;
+    vector<Complex>  dest (n, Complex (0.0, 0.0));
+    for  (size_t k = 0;  k < n;  ++k)
+    {
+      Complex  sum (0.0, 0.0);
+      for  (size_t j = 0;  j < n;  ++j)
+      {
+        // (j * k) mod n keeps the angle small so that the reference itself does not lose precision.
+        double  angle = sign * twoPi * (double)((j * k) % n) / (double)n;
+        sum += src[j] * Complex (cos (angle), sin (angle));
+      }
+      dest[k] = sum;
+    }
+    return  dest;
+  }
+
+
+
+  vector<FftPlanTest::Complex>  FftPlanTest::RandomSequence (kkuint32  size,
+                                                             kkuint32  seed
+                                                            )
+  {
+    vector<Complex>  seq (size);
+    kkuint32  state = seed;
+    auto  next = [&state] () -> double
+      {
+        state = state * 1664525u + 1013904223u;
+        return  (double)(state >> 8) / (double)(1u << 24) - 0.5;
+      };
+
+    for  (auto& z: seq)
+    {
+      double  re = next ();
+      double  im = next ();
+      z = Complex (re, im);
+    }
+    return  seq;
+  }
+
+
+
+  void  FftPlanTest::TestOneD (kkuint32  size)
+  {
+    vector<Complex>  src = RandomSequence (size, size);
+
+    for  (bool forwardTransform: {true, false})
+    {
+      FftPlan<double>::FftPlanConstPtr  plan = FftPlan<double>::GetPlan (size, forwardTransform);
+      vector<Complex>  work (plan->WorkSize ());
+      vector<Complex>  dest (size);
+      plan->Transform (&src[0], &dest[0], &work[0]);
+
+      vector<Complex>  expected = DirectDft (src, forwardTransform);
+      double  err = RelativeError (dest, expected);
+
+      KKStr  testName;
+      testName << "FftPlan " << (forwardTransform ? "Forward" : "Reverse") << " Size " << size << (plan->UsesBluestein () ? " Bluestein" : "");
+      KKStr  msg;
+      msg << "RelativeError: " << err;
+      Assert (err < fftTolerance, testName, msg);
+    }
+  }
+
+
+
+  void  FftPlanTest::TestReal (kkuint32  size)
+  {
+    vector<Complex>  seq = RandomSequence (size, 7 * size + 1);
+    vector<double>  a (size);
+    vector<double>  b (size);
+    vector<Complex>  aComplex (size);
+    vector<Complex>  bComplex (size);
+    for  (kkuint32 k = 0;  k < size;  ++k)
+    {
+      a[k] = seq[k].real ();
+      b[k] = seq[k].imag ();
+      aComplex[k] = Complex (a[k], 0.0);
+      bComplex[k] = Complex (b[k], 0.0);
+    }
+
+    FftPlan<double>::FftPlanConstPtr  plan = FftPlan<double>::GetPlan (size, true);
+    vector<Complex>  work (plan->WorkSize () + size);
+    vector<Complex>  destA (size);
+    vector<Complex>  destB (size);
+    plan->TransformReal (&a[0], &b[0], &destA[0], &destB[0], &work[0]);
+
+    double  err = Max (RelativeError (destA, DirectDft (aComplex, true)), RelativeError (destB, DirectDft (bComplex, true)));
+
+    KKStr  testName;
+    testName << "FftPlan TransformReal Size " << size;
+    KKStr  msg;
+    msg << "RelativeError: " << err;
+    Assert (err < fftTolerance, testName, msg);
+  }
+
+
+
+  void  FftPlanTest::TestTwoD (kkint32  height,
+                               kkint32  width
+                              )
+  {
+    vector<uchar>   pixels (height * width);
+    vector<uchar*>  rows (height);
+    kkuint32  state = (kkuint32)(height * 31 + width);
+    for  (kkint32 r = 0;  r < height;  ++r)
+    {
+      rows[r] = &pixels[r * width];
+      for  (kkint32 c = 0;  c < width;  ++c)
+      {
+        state = state * 1664525u + 1013904223u;
+        rows[r][c] = (uchar)(state >> 24);
+      }
+    }
+
+    // Direct transform of every row and then of every column.
+    vector<Complex>  expected (height * width);
+    for  (kkint32 r = 0;  r < height;  ++r)
+    {
+      vector<Complex>  row (width);
+      for  (kkint32 c = 0;  c < width;  ++c)
+        row[c] = Complex ((double)rows[r][c], 0.0);
+      row = DirectDft (row, true);
+      for  (kkint32 c = 0;  c < width;  ++c)
+        expected[r * width + c] = row[c];
+    }
+    for  (kkint32 c = 0;  c < width;  ++c)
+    {
+      vector<Complex>  col (height);
+      for  (kkint32 r = 0;  r < height;  ++r)
+        col[r] = expected[r * width + c];
+      col = DirectDft (col, true);
+      for  (kkint32 r = 0;  r < height;  ++r)
+        expected[r * width + c] = col[r];
+    }
+
+    kkuint32  oldNumThreads = FftNumThreads ();
+    for  (kkuint32 numThreads: {1u, 4u})
+    {
+      FftSetNumThreads (numThreads);
+
+      KK_DFT2D_Double  dft (height, width, true);
+      Complex*   destArea = NULL;
+      Complex**  dest     = NULL;
+      dft.AllocateArray (destArea, dest);
+      dft.Transform (&rows[0], dest);
+
+      vector<Complex>  found (height * width);
+      for  (kkint32 r = 0;  r < height;  ++r)
+        for  (kkint32 c = 0;  c < width;  ++c)
+          found[r * width + c] = dest[r][c];
+      dft.DestroyArray (destArea, dest);
+
+      double  err = RelativeError (found, expected);
+
+      KKStr  testName;
+      testName << "KK_DFT2D " << height << "x" << width << " Threads " << numThreads;
+      KKStr  msg;
+      msg << "RelativeError: " << err;
+      Assert (err < fftTolerance, testName, msg);
+    }
+    FftSetNumThreads (oldNumThreads);
+  }
+
+
+
+  bool  FftPlanTest::RunTests ()
+  {
+    Assert (FftNumThreads () == 1, "FftNumThreads Default", "Transforms run on the callers thread unless asked otherwise");
+
+    // Stockham lengths (only factors of 2, 3 and 5) followed by lengths that need Bluestein.
+    kkuint32  sizes[] = {1, 2, 3, 4, 5, 6, 8, 9, 12, 15, 16, 25, 27, 30, 60, 64, 100, 128, 243, 250,
+                         7, 11, 13, 17, 97, 101, 127, 210
+                        };
+    for  (auto size: sizes)
+      TestOneD (size);
+
+    for  (kkuint32 size: {1u, 2u, 7u, 16u, 30u, 97u})
+      TestReal (size);
+
+    // The larger images are big enough for 'FftParallelFor' to use threads when more than one is asked for.
+    TestTwoD (7, 10);
+    TestTwoD (256, 300);
+    TestTwoD (243, 257);
+
+    return  FailedCount () == 0;
+  }
+}
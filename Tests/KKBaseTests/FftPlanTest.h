@@ -0,0 +1,48 @@
+#pragma once
+#include <complex>
+#include <vector>
+#include "KKTest.h"
+
+namespace  KKBaseTest
+{
+  /**
+   *@brief  Compares 'FftPlan' and 'KK_DFT2D' against a direct O(N^2) evaluation of the Discrete Fourier Transform.
+   *@details  Covers the radix 2, 3, 4 and 5 Stockham lengths, Bluestein lengths, the two real sequences at a time
+   * transform and the two dimensional transform of an image with the row and column work spread across threads.
+   */
+  class FftPlanTest : public KKTest
+  {
+  public:
+    typedef  std::complex<double>  Complex;
+
+    FftPlanTest ();
+
+    virtual ~FftPlanTest ();
+
+    virtual const char*  TestName () const { return "FftPlan"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  Largest magnitude of the difference between 'a' and 'b' relative to the largest magnitude in 'b'. */
+    static  double  RelativeError (const std::vector<Complex>&  a,
+                                   const std::vector<Complex>&  b
+                                  );
+
+    static  std::vector<Complex>  DirectDft (const std::vector<Complex>&  src,
+                                             bool                         forwardTransform
+                                            );
+
+    static  std::vector<Complex>  RandomSequence (kkuint32  size,
+                                                  kkuint32  seed
+                                                 );
+
+    void  TestOneD (kkuint32  size);
+
+    void  TestReal (kkuint32  size);
+
+    void  TestTwoD (kkint32  height,
+                    kkint32  width
+                   );
+  };
+}
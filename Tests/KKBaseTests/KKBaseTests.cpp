@@ -10,11 +10,16 @@
 using namespace std;
 
 #include "DateTimeTest.h"
+#include "FftPlanTest.h"
 #include "KKQueueTest.h"
 #include "KKHeapTest.h"
 #include "KKStrTest.h"
 #include "KKTest.h"
+#include "KKWorkStealingPoolTest.h"
+#include "MorphologyTest.h"
 #include "OptionTest.h"
+#include "RasterBufferTest.h"
+#include "SegmentorOTSUTest.h"
 using namespace KKBaseTest;
 
   int main()
@@ -23,8 +28,13 @@ using namespace KKBaseTest;
     //tests.PushOnBack (new KKHeapTest   ());
     //tests.PushOnBack (new DateTimeTest ());
     tests.PushOnBack (new OptionTest   ());
+    tests.PushOnBack (new FftPlanTest  ());
+    tests.PushOnBack (new MorphologyTest ());
+    tests.PushOnBack (new SegmentorOTSUTest ());
+    tests.PushOnBack (new RasterBufferTest ());
+    tests.PushOnBack (new KKWorkStealingPoolTest ());
     //tests.PushOnBack (new KKQueueTest  ());
-    //tests.PushOnBack (new KKStrTest    ());
+    tests.PushOnBack (new KKStrTest    ());
 
     kkuint32 failedCount = 0;
 
@@ -1,5 +1,7 @@
 #include "FirstIncludes.h"
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <map>
 #include <vector>
@@ -33,6 +35,7 @@ namespace KKBaseTest
   {
     ExtractQuotedStr ();
     FormatDouble ();
+    StrFromInt32 ();
     return true;
   }
 
@@ -56,6 +59,20 @@ namespace KKBaseTest
 
 
 
+  bool  KKStrTest::StrFromInt32 ()
+  {
+    // Both used to pass 32 bit values to '%ld' / '%lu';  on LP64 -1 came out as 4294967295.
+    AssertAreEqual ("-1",          KKB::StrFromInt32 (-1),          "KKStrTest::StrFromInt32");
+    AssertAreEqual ("-2147483648", KKB::StrFromInt32 (INT32_MIN),   "KKStrTest::StrFromInt32");
+    AssertAreEqual ("2147483647",  KKB::StrFromInt32 (INT32_MAX),   "KKStrTest::StrFromInt32");
+    AssertAreEqual ("4294967295",  KKB::StrFromUint32 (UINT32_MAX), "KKStrTest::StrFromUint32");
+
+    Assert (KKB::StrFromInt32 (-12345).ToInt32 () == -12345, "KKStrTest::StrFromInt32", "-12345 does not read back with ToInt32");
+    return true;
+  }
+
+
+
   bool  KKStrTest::ExtractQuotedStr ()
   {
     KKStr s = "TokenOne, Token;Two,'Token Three',\"\\\"Token Four\\\"\",\"Token\\tFive\"";
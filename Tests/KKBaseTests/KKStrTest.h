@@ -19,5 +19,7 @@ namespace KKBaseTest
     bool  ExtractQuotedStr ();
 
     bool  FormatDouble ();
+
+    bool  StrFromInt32 ();
   };
 }
@@ -0,0 +1,198 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKException.h"
+#include "KKStr.h"
+#include "KKWorkStealingPool.h"
+using namespace KKB;
+
+#include "KKWorkStealingPoolTest.h"
+
+
+namespace  KKBaseTest
+{
+  KKWorkStealingPoolTest::KKWorkStealingPoolTest ()
+  {
+  }
+
+
+
+  KKWorkStealingPoolTest::~KKWorkStealingPoolTest ()
+  {
+  }
+
+
+
+  void  KKWorkStealingPoolTest::TestFlatTasks (kkuint32  numThreads)
+  {
+    const kkuint32  numTasks = 20000;
+
+    KKStr  testName;
+    testName << "FlatTasks-Threads" << numThreads;
+
+    KKWorkStealingPool  pool ("FlatTasks", numThreads);
+
+    vector<atomic<kkint32> >  runCounts (numTasks);
+    for  (auto&  c: runCounts)
+      c = 0;
+
+    // Uneven task lengths so that idle workers have something to steal.
+    for  (kkuint32 x = 0;  x < numTasks;  ++x)
+    {
+      pool.AddTask ([&runCounts, x] ()
+        {
+          volatile kkuint32  spin = 0;
+          for  (kkuint32 y = 0;  y < (x % 64) * 50;  ++y)
+            spin = spin + y;
+          ++(runCounts[x]);
+        });
+    }
+    pool.WaitForAllTasks ();
+
+    bool  eachOnce = true;
+    for  (auto&  c: runCounts)
+      eachOnce = eachOnce  &&  (c.load () == 1);
+    Assert (eachOnce, testName + "-EachTaskRanOnce");
+
+    // The pool can be used again once 'WaitForAllTasks' has returned.
+    atomic<kkint32>  secondRound (0);
+    for  (kkuint32 x = 0;  x < 1000;  ++x)
+      pool.AddTask ([&secondRound] () {++secondRound;});
+    pool.WaitForAllTasks ();
+    Assert (secondRound.load () == 1000, testName + "-Reuse");
+  }
+
+
+
+  void  KKWorkStealingPoolTest::TestNestedTasks (kkuint32  numThreads)
+  {
+    KKStr  testName;
+    testName << "NestedTasks-Threads" << numThreads;
+
+    KKWorkStealingPool  pool ("NestedTasks", numThreads);
+
+    // A binary tree of tasks where each task adds its two children;  'WaitForAllTasks' has to wait for the ones
+    // added by workers as well.
+    const kkint32    depth = 14;
+    atomic<kkint32>  numRun (0);
+    std::function<void (kkint32)>  node = [&] (kkint32  level)
+      {
+        ++numRun;
+        if  (level < depth)
+        {
+          pool.AddTask ([&node, level] () {node (level + 1);});
+          pool.AddTask ([&node, level] () {node (level + 1);});
+        }
+      };
+
+    pool.AddTask ([&node] () {node (0);});
+    pool.WaitForAllTasks ();
+
+    kkint32  expected = (1 << (depth + 1)) - 1;
+    KKStr  msg;
+    msg << "Expected[" << expected << "]  Ran[" << numRun.load () << "]  Steals[" << pool.NumSteals () << "]";
+    Assert (numRun.load () == expected, testName + "-AllRan", msg);
+  }
+
+
+
+  void  KKWorkStealingPoolTest::TestExceptions (kkuint32  numThreads)
+  {
+    KKStr  testName;
+    testName << "Exceptions-Threads" << numThreads;
+
+    KKWorkStealingPool  pool ("Exceptions", numThreads);
+
+    atomic<kkint32>  numRun (0);
+    for  (kkint32 x = 0;  x < 500;  ++x)
+    {
+      pool.AddTask ([&numRun, x] ()
+        {
+          ++numRun;
+          if  (x == 100)
+            throw KKException ("Task100");
+          if  (x == 300)
+            throw std::runtime_error ("Task300");
+        });
+    }
+
+    bool   thrown = false;
+    KKStr  errMsg;
+    try
+    {
+      pool.WaitForAllTasks ();
+    }
+    catch  (const KKException&  e)
+    {
+      thrown = true;
+      errMsg = e.ToString ();
+    }
+
+    Assert (thrown, testName + "-Rethrown");
+    Assert (numRun.load () == 500, testName + "-OthersStillRan");
+    Assert (errMsg.Contains ("Task100")  ||  errMsg.Contains ("Task300"), testName + "-Message", errMsg);
+
+    // The exception is cleared once reported.
+    pool.AddTask ([] () {});
+    bool  thrownAgain = false;
+    try
+    {
+      pool.WaitForAllTasks ();
+    }
+    catch  (const KKException&)
+    {
+      thrownAgain = true;
+    }
+    Assert (!thrownAgain, testName + "-Cleared");
+  }
+
+
+
+  void  KKWorkStealingPoolTest::TestSerialPool ()
+  {
+    KKWorkStealingPool  pool ("Serial", 1);
+    Assert (pool.NumThreads () == 1, "Serial-NumThreads");
+
+    std::thread::id  ranOn;
+    pool.AddTask ([&ranOn] () {ranOn = std::this_thread::get_id ();});
+    Assert (ranOn == std::this_thread::get_id (), "Serial-RunsOnCallersThread");
+
+    pool.AddTask ([] () {throw KKException ("Serial");});
+    bool  thrown = false;
+    try
+    {
+      pool.WaitForAllTasks ();
+    }
+    catch  (const KKException&)
+    {
+      thrown = true;
+    }
+    Assert (thrown, "Serial-ExceptionRethrown");
+
+    KKWorkStealingPool  perProcessor ("PerProcessor", 0);
+    Assert (perProcessor.NumThreads () >= 1, "ZeroThreads-OnePerProcessor");
+  }
+
+
+
+  bool  KKWorkStealingPoolTest::RunTests ()
+  {
+    TestSerialPool ();
+    for  (kkuint32 numThreads: {2u, 4u, 8u})
+    {
+      TestFlatTasks   (numThreads);
+      TestNestedTasks (numThreads);
+      TestExceptions  (numThreads);
+    }
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "KKTest.h"
+#include "KKWorkStealingPool.h"
+
+namespace  KKBaseTest
+{
+  /**
+   *@brief  Checks that 'KKWorkStealingPool' runs every task exactly once.
+   *@details  Covers tasks added from outside the pool, tasks that add further tasks from inside a worker,
+   * 'WaitForAllTasks' rethrowing the first exception once everything has finished, the single thread pool
+   * running tasks on the callers thread, and a pool being reused after 'WaitForAllTasks'.
+   */
+  class KKWorkStealingPoolTest : public KKTest
+  {
+  public:
+    KKWorkStealingPoolTest ();
+
+    virtual ~KKWorkStealingPoolTest ();
+
+    virtual const char*  TestName () const { return "KKWorkStealingPool"; }
+
+    bool  RunTests () override;
+
+  private:
+    void  TestFlatTasks (kkuint32  numThreads);
+
+    void  TestNestedTasks (kkuint32  numThreads);
+
+    void  TestExceptions (kkuint32  numThreads);
+
+    void  TestSerialPool ();
+  };
+}
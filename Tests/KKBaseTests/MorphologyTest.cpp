@@ -0,0 +1,499 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "MorphOp.h"
+#include "Raster.h"
+using namespace KKB;
+
+#include "MorphologyTest.h"
+
+
+namespace  KKBaseTest
+{
+  MorphologyTest::MorphologyTest ()
+  {
+  }
+
+
+
+  MorphologyTest::~MorphologyTest ()
+  {
+  }
+
+
+
+  RasterPtr  MorphologyTest::RandomImage (kkint32  height,
+                                          kkint32  width,
+                                          double   density,
+                                          bool     invertedBackground,
+                                          kkuint32 seed
+                                         )
+  {
+    kkuint32  state = seed * 2654435761u + 1u;
+    auto  next = [&state] () -> kkuint32
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      };
+
+    RasterPtr  image = new Raster (height, width, false);
+    if  (invertedBackground)
+    {
+      image->BackgroundPixelValue (255);
+      image->ForegroundPixelValue (0);
+      image->BackgroundPixelTH    (200);
+    }
+
+    uchar*  area = image->GreenArea ();
+    for  (kkint32 x = 0;  x < image->TotPixels ();  ++x)
+    {
+      // Blobs rather than salt and pepper:  a pixel is likely to take the side of the one above it.
+      bool  foreground = ((double)(next () % 1000) / 1000.0) < density;
+      if  ((x >= width)  &&  ((next () % 3) != 0))
+        foreground = Foreground (*image, area[x - width]);
+
+      // Any value on the right side of the threshold, including the threshold itself on the background side.
+      kkuint32  v = next () % 256;
+      if  (invertedBackground)
+        area[x] = (uchar)(foreground ? (v % 200) : (200 + v % 56));
+      else
+        area[x] = (uchar)(foreground ? (image->BackgroundPixelTH () + 1 + v % (255 - image->BackgroundPixelTH ())) : (v % (image->BackgroundPixelTH () + 1)));
+    }
+    return  image;
+  }
+
+
+
+  RasterPtr  MorphologyTest::BlankLike (const Raster&  src)
+  {
+    return  new Raster (src.Height (), src.Width (), false);
+  }
+
+
+
+  bool  MorphologyTest::Foreground (const Raster&  src,
+                                    uchar          pixel
+                                   )
+  {
+    if  (src.BackgroundPixelValue () < 125)
+      return  pixel > src.BackgroundPixelTH ();
+    else
+      return  pixel < src.BackgroundPixelTH ();
+  }
+
+
+
+  RasterPtr  MorphologyTest::ReferenceDilation3x3 (const Raster&  src)
+  {
+    // The 3x3 operators compare against 'backgroundPixelTH' directly, leave the corners empty and do not look
+    // at the centre pixel of the bottom row.
+    kkint32  height = src.Height ();
+    kkint32  width  = src.Width ();
+    uchar    th     = src.BackgroundPixelTH ();
+    uchar**  s      = src.Green ();
+
+    RasterPtr  dest = BlankLike (src);
+    uchar**  d = dest->Green ();
+    kkint32  count = 0;
+
+    auto  on = [&] (kkint32 r, kkint32 c) {return s[r][c] > th;};
+
+    for  (kkint32 c = 1;  c < (width - 1);  ++c)
+    {
+      if  (on (0, c - 1) || on (0, c) || on (0, c + 1) || on (1, c - 1) || on (1, c) || on (1, c + 1))
+        {d[0][c] = 255;  ++count;}
+
+      kkint32  b0 = height - 1;
+      kkint32  b1 = height - 2;
+      if  (on (b0, c - 1) || on (b0, c + 1) || on (b1, c - 1) || on (b1, c) || on (b1, c + 1))
+        {d[b0][c] = 255;  ++count;}
+    }
+
+    for  (kkint32 r = 1;  r < (height - 1);  ++r)
+    {
+      if  (on (r - 1, 0) || on (r - 1, 1) || on (r, 0) || on (r, 1) || on (r + 1, 0) || on (r + 1, 1))
+        {d[r][0] = 255;  ++count;}
+
+      kkint32  l0 = width - 1;
+      kkint32  l1 = width - 2;
+      if  (on (r - 1, l0) || on (r - 1, l1) || on (r, l0) || on (r, l1) || on (r + 1, l0) || on (r + 1, l1))
+        {d[r][l0] = 255;  ++count;}
+
+      for  (kkint32 c = 1;  c < (width - 1);  ++c)
+      {
+        bool  any = false;
+        for  (kkint32 dr = -1;  dr <= 1;  ++dr)
+          for  (kkint32 dc = -1;  dc <= 1;  ++dc)
+            any = any  ||  on (r + dr, c + dc);
+        if  (any)
+          {d[r][c] = 255;  ++count;}
+      }
+    }
+
+    dest->ForegroundPixelCount (count);
+    return  dest;
+  }
+
+
+
+  RasterPtr  MorphologyTest::ReferenceErosion3x3 (const Raster&  src)
+  {
+    kkint32  height = src.Height ();
+    kkint32  width  = src.Width ();
+    uchar    th     = src.BackgroundPixelTH ();
+    uchar**  s      = src.Green ();
+
+    RasterPtr  dest = BlankLike (src);
+    uchar**  d = dest->Green ();
+    kkint32  count = 0;
+
+    auto  on = [&] (kkint32 r, kkint32 c) {return s[r][c] > th;};
+
+    for  (kkint32 c = 1;  c < (width - 1);  ++c)
+    {
+      if  (on (0, c - 1) && on (0, c) && on (0, c + 1) && on (1, c - 1) && on (1, c) && on (1, c + 1))
+        {d[0][c] = 255;  ++count;}
+
+      kkint32  b0 = height - 1;
+      kkint32  b1 = height - 2;
+      if  (on (b0, c - 1) && on (b0, c + 1) && on (b1, c - 1) && on (b1, c) && on (b1, c + 1))
+        {d[b0][c] = 255;  ++count;}
+    }
+
+    for  (kkint32 r = 1;  r < (height - 1);  ++r)
+    {
+      if  (on (r - 1, 0) && on (r - 1, 1) && on (r, 0) && on (r, 1) && on (r + 1, 0) && on (r + 1, 1))
+        {d[r][0] = 255;  ++count;}
+
+      kkint32  l0 = width - 1;
+      kkint32  l1 = width - 2;
+      if  (on (r - 1, l0) && on (r - 1, l1) && on (r, l0) && on (r, l1) && on (r + 1, l0) && on (r + 1, l1))
+        {d[r][l0] = 255;  ++count;}
+
+      for  (kkint32 c = 1;  c < (width - 1);  ++c)
+      {
+        bool  all = true;
+        for  (kkint32 dr = -1;  dr <= 1;  ++dr)
+          for  (kkint32 dc = -1;  dc <= 1;  ++dc)
+            all = all  &&  on (r + dr, c + dc);
+        if  (all)
+          {d[r][c] = 255;  ++count;}
+      }
+    }
+
+    dest->ForegroundPixelCount (count);
+    return  dest;
+  }
+
+
+
+  RasterPtr  MorphologyTest::ReferenceDilation (const Raster&       src,
+                                                MorphOp::MaskTypes  mask
+                                               )
+  {
+    // 'IsThereANeighbor' for every pixel;  the structure is clipped to the image.
+    kkint32  height = src.Height ();
+    kkint32  width  = src.Width ();
+    kkint32  bias   = MorphOp::Biases (mask);
+    bool     square = MorphOp::MaskShapes (mask) == MorphOp::StructureType::stSquare;
+    uchar**  s      = src.Green ();
+
+    RasterPtr  dest = BlankLike (src);
+    kkint32  count = 0;
+    for  (kkint32 row = 0;  row < height;  ++row)
+    {
+      for  (kkint32 col = 0;  col < width;  ++col)
+      {
+        kkint32  rStart = Max (row - bias, 0),  rEnd = Min (row + bias, height - 1);
+        kkint32  cStart = Max (col - bias, 0),  cEnd = Min (col + bias, width - 1);
+        bool  any = false;
+        for  (kkint32 r = rStart;  r <= rEnd;  ++r)
+          for  (kkint32 c = cStart;  c <= cEnd;  ++c)
+            if  (square  ||  (r == row)  ||  (c == col))
+              any = any  ||  Foreground (src, s[r][c]);
+        if  (any)
+        {
+          dest->GreenArea ()[row * width + col] = 255;
+          ++count;
+        }
+      }
+    }
+    dest->ForegroundPixelCount (count);
+    return  dest;
+  }
+
+
+
+  RasterPtr  MorphologyTest::ReferenceErosion (const Raster&       src,
+                                               MorphOp::MaskTypes  mask
+                                              )
+  {
+    // A foreground pixel stays when 'Fit' is true;  the structure is clipped to the image.
+    kkint32  height = src.Height ();
+    kkint32  width  = src.Width ();
+    kkint32  bias   = MorphOp::Biases (mask);
+    bool     square = MorphOp::MaskShapes (mask) == MorphOp::StructureType::stSquare;
+    uchar**  s      = src.Green ();
+
+    RasterPtr  dest = BlankLike (src);
+    kkint32  count = 0;
+    for  (kkint32 row = 0;  row < height;  ++row)
+    {
+      for  (kkint32 col = 0;  col < width;  ++col)
+      {
+        if  (!Foreground (src, s[row][col]))
+          continue;
+
+        kkint32  rStart = Max (row - bias, 0),  rEnd = Min (row + bias, height - 1);
+        kkint32  cStart = Max (col - bias, 0),  cEnd = Min (col + bias, width - 1);
+        bool  fit = true;
+        for  (kkint32 r = rStart;  r <= rEnd;  ++r)
+          for  (kkint32 c = cStart;  c <= cEnd;  ++c)
+            if  (square  ||  (r == row)  ||  (c == col))
+              fit = fit  &&  Foreground (src, s[r][c]);
+        if  (fit)
+        {
+          dest->GreenArea ()[row * width + col] = 255;
+          ++count;
+        }
+      }
+    }
+    dest->ForegroundPixelCount (count);
+    return  dest;
+  }
+
+
+
+  RasterPtr  MorphologyTest::ReferenceEdge (const Raster&  src)
+  {
+    // Interior foreground pixels whose 3x3 neighbourhood is all foreground become background;  the border and
+    // the background pixels of 'dest' are left alone.
+    kkint32  height = src.Height ();
+    kkint32  width  = src.Width ();
+    uchar**  s      = src.Green ();
+
+    RasterPtr  dest = BlankLike (src);
+    uchar**  d = dest->Green ();
+    kkint32  count = 0;
+    for  (kkint32 r = 1;  r < (height - 1);  ++r)
+    {
+      for  (kkint32 c = 1;  c < (width - 1);  ++c)
+      {
+        if  (!Foreground (src, s[r][c]))
+          continue;
+
+        bool  all = true;
+        for  (kkint32 dr = -1;  dr <= 1;  ++dr)
+          for  (kkint32 dc = -1;  dc <= 1;  ++dc)
+            all = all  &&  Foreground (src, s[r + dr][c + dc]);
+        if  (all)
+        {
+          d[r][c] = src.BackgroundPixelValue ();
+        }
+        else
+        {
+          d[r][c] = src.ForegroundPixelValue ();
+          ++count;
+        }
+      }
+    }
+    dest->ForegroundPixelCount (count);
+    return  dest;
+  }
+
+
+
+  RasterPtr  MorphologyTest::ReferenceFillHole (Raster&  src)
+  {
+    // Border background pixels are flagged 1 and the flag is spread through 4 connected background pixels by
+    // scanning forward and backward until nothing changes;  what is left at 0 is a hole.
+    kkint32  height    = src.Height ();
+    kkint32  width     = src.Width ();
+    kkint32  totPixels = src.TotPixels ();
+    uchar*   srcArea   = src.GreenArea ();
+
+    RasterPtr  mask = BlankLike (src);
+    uchar**  m = mask->Green ();
+    uchar*   maskArea = mask->GreenArea ();
+
+    for  (kkint32 x = 0;  x < totPixels;  ++x)
+      maskArea[x] = (srcArea[x] > src.BackgroundPixelTH ()) ? 255 : 0;
+
+    for  (kkint32 r = 0;  r < height;  ++r)
+      for  (kkint32 c = 0;  c < width;  ++c)
+        if  (((r == 0)  ||  (r == height - 1)  ||  (c == 0)  ||  (c == width - 1))  &&  (m[r][c] == 0))
+          m[r][c] = 1;
+
+    auto  reachable = [&] (kkint32 r, kkint32 c)
+      {
+        return  (m[r - 1][c] == 1)  ||  (m[r][c - 1] == 1)  ||  (m[r][c + 1] == 1)  ||  (m[r + 1][c] == 1);
+      };
+
+    bool  changed = true;
+    while  (changed)
+    {
+      changed = false;
+      for  (kkint32 r = 1;  r < (height - 1);  ++r)
+        for  (kkint32 c = 1;  c < (width - 1);  ++c)
+          if  ((m[r][c] == 0)  &&  reachable (r, c))
+            {m[r][c] = 1;  changed = true;}
+
+      for  (kkint32 r = height - 2;  r > 0;  --r)
+        for  (kkint32 c = width - 2;  c > 0;  --c)
+          if  ((m[r][c] == 0)  &&  reachable (r, c))
+            {m[r][c] = 1;  changed = true;}
+    }
+
+    kkint32  count = src.ForegroundPixelCount ();
+    for  (kkint32 x = 0;  x < totPixels;  ++x)
+    {
+      if  (maskArea[x] == 0)
+      {
+        srcArea[x] = src.ForegroundPixelValue ();
+        ++count;
+      }
+    }
+    src.ForegroundPixelCount (count);
+    return  mask;
+  }
+
+
+
+  bool  MorphologyTest::SameImage (const Raster&  a,
+                                   const Raster&  b
+                                  )
+  {
+    return  (a.Height () == b.Height ())  &&
+            (a.Width  () == b.Width  ())  &&
+            (a.ForegroundPixelCount () == b.ForegroundPixelCount ())  &&
+            (memcmp (a.GreenArea (), b.GreenArea (), a.TotPixels ()) == 0);
+  }
+
+
+
+  void  MorphologyTest::TestImage (kkint32  height,
+                                   kkint32  width,
+                                   double   density,
+                                   bool     invertedBackground,
+                                   kkuint32 seed
+                                  )
+  {
+    RasterPtr  src = RandomImage (height, width, density, invertedBackground, seed);
+
+    KKStr  imageDesc;
+    imageDesc << height << "x" << width << " Density " << density << (invertedBackground ? " Inverted" : "");
+
+    auto  check = [&] (const char* opName, const Raster& found, const Raster& expected)
+      {
+        KKStr  testName;
+        testName << opName << " " << imageDesc;
+        KKStr  msg;
+        msg << "ForegroundPixelCount: " << found.ForegroundPixelCount () << " Expected: " << expected.ForegroundPixelCount ();
+        Assert (SameImage (found, expected), testName, msg);
+      };
+
+    // The 3x3 operators and Edge read two rows and columns on each side of the border.
+    if  ((height >= 2)  &&  (width >= 2))
+    {
+      RasterPtr  expected = ReferenceDilation3x3 (*src);
+      RasterPtr  found = BlankLike (*src);
+      src->Dilation (found);
+      check ("Dilation", *found, *expected);
+
+      RasterPtr  expected2 = ReferenceDilation3x3 (*expected);
+      RasterPtr  found2 = BlankLike (*src);
+      src->DoubleDilation (found2);
+      check ("DoubleDilation", *found2, *expected2);
+      delete  expected;   delete  found;
+      delete  expected2;  delete  found2;
+
+      expected = ReferenceErosion3x3 (*src);
+      found = BlankLike (*src);
+      src->Erosion (found);
+      check ("Erosion", *found, *expected);
+
+      expected2 = ReferenceEdge (*expected);
+      RasterPtr  foundEroded = BlankLike (*src);
+      found2 = BlankLike (*src);
+      src->ErosionEdge (foundEroded, found2);
+      check ("ErosionEdge Eroded", *foundEroded, *expected);
+      check ("ErosionEdge Edge",   *found2,      *expected2);
+      delete  expected;   delete  found;
+      delete  expected2;  delete  found2;
+      delete  foundEroded;
+
+      expected = ReferenceEdge (*src);
+      found = BlankLike (*src);
+      src->Edge (found);
+      check ("Edge", *found, *expected);
+      delete  expected;  delete  found;
+    }
+
+    MorphOp::MaskTypes  masks[] = {MorphOp::MaskTypes::CROSS3,  MorphOp::MaskTypes::CROSS5,   MorphOp::MaskTypes::SQUARE3,
+                                   MorphOp::MaskTypes::SQUARE5, MorphOp::MaskTypes::SQUARE7,  MorphOp::MaskTypes::SQUARE9,
+                                   MorphOp::MaskTypes::SQUARE11
+                                  };
+    const char*  maskNames[] = {"CROSS3", "CROSS5", "SQUARE3", "SQUARE5", "SQUARE7", "SQUARE9", "SQUARE11"};
+    for  (kkuint32 maskIdx = 0;  maskIdx < (sizeof (masks) / sizeof (masks[0]));  ++maskIdx)
+    {
+      MorphOp::MaskTypes  mask = masks[maskIdx];
+      KKStr  maskName = maskNames[maskIdx];
+
+      RasterPtr  expected = ReferenceDilation (*src, mask);
+      RasterPtr  found = BlankLike (*src);
+      src->Dilation (found, mask);
+      check (("Dilation " + maskName).Str (), *found, *expected);
+      delete  expected;  delete  found;
+
+      expected = ReferenceErosion (*src, mask);
+      found = BlankLike (*src);
+      src->Erosion (found, mask);
+      check (("Erosion " + maskName).Str (), *found, *expected);
+      delete  expected;  delete  found;
+    }
+
+    {
+      Raster  expected (*src);
+      RasterPtr  expectedMask = ReferenceFillHole (expected);
+
+      Raster  found (*src);
+      RasterPtr  foundMask = BlankLike (*src);
+      found.FillHole (foundMask);
+      check ("FillHole", found, expected);
+
+      KKStr  testName;
+      testName << "FillHole Mask " << imageDesc;
+      Assert (memcmp (foundMask->GreenArea (), expectedMask->GreenArea (), src->TotPixels ()) == 0, testName);
+      delete  expectedMask;
+      delete  foundMask;
+    }
+
+    delete  src;
+  }
+
+
+
+  bool  MorphologyTest::RunTests ()
+  {
+    kkuint32  seed = 1;
+    kkint32  sizes[][2] = {{2, 2}, {2, 9}, {9, 2}, {3, 3}, {5, 17}, {16, 16}, {17, 33}, {31, 64}, {100, 37}, {64, 129}};
+    for  (auto& size: sizes)
+    {
+      for  (double density: {0.05, 0.5, 0.9})
+      {
+        TestImage (size[0], size[1], density, false, seed++);
+        TestImage (size[0], size[1], density, true,  seed++);
+      }
+    }
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "KKTest.h"
+#include "MorphOp.h"
+#include "Raster.h"
+
+namespace  KKBaseTest
+{
+  /**
+   *@brief  Checks the binary morphology of 'Raster' against the pixel by pixel implementations it replaced.
+   *@details  'Dilation', 'Erosion', their 'MaskTypes' variants, 'Edge', 'FillHole (mask)' and the fused
+   * 'DoubleDilation' and 'ErosionEdge' have to give the same pixels and foreground pixel counts, for normal and
+   * inverted backgrounds and images as small as 2 x 2.
+   */
+  class MorphologyTest : public KKTest
+  {
+  public:
+    MorphologyTest ();
+
+    virtual ~MorphologyTest ();
+
+    virtual const char*  TestName () const { return "Morphology"; }
+
+    bool  RunTests () override;
+
+  private:
+    static  RasterPtr  RandomImage (kkint32  height,
+                                    kkint32  width,
+                                    double   density,
+                                    bool     invertedBackground,
+                                    kkuint32 seed
+                                   );
+
+    /** @brief  Empty image of the same size as 'src' that has the default background settings. */
+    static  RasterPtr  BlankLike (const Raster&  src);
+
+    static  bool  Foreground (const Raster&  src,
+                              uchar          pixel
+                             );
+
+    static  RasterPtr  ReferenceDilation3x3 (const Raster&  src);
+
+    static  RasterPtr  ReferenceErosion3x3 (const Raster&  src);
+
+    static  RasterPtr  ReferenceDilation (const Raster&      src,
+                                          MorphOp::MaskTypes  mask
+                                         );
+
+    static  RasterPtr  ReferenceErosion (const Raster&      src,
+                                         MorphOp::MaskTypes  mask
+                                        );
+
+    static  RasterPtr  ReferenceEdge (const Raster&  src);
+
+    /** @brief  Fills the holes of 'src' and returns the work mask the way 'FillHole (mask)' used to. */
+    static  RasterPtr  ReferenceFillHole (Raster&  src);
+
+    /** @brief  Same size, same pixels and same 'ForegroundPixelCount'. */
+    static  bool  SameImage (const Raster&  a,
+                             const Raster&  b
+                            );
+
+    void  TestImage (kkint32  height,
+                     kkint32  width,
+                     double   density,
+                     bool     invertedBackground,
+                     kkuint32 seed
+                    );
+  };
+}
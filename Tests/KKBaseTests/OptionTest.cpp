@@ -1,5 +1,6 @@
 #include "FirstIncludes.h"
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <map>
 #include <vector>
@@ -58,7 +59,7 @@ namespace KKBaseTest
 
     try
     {
-      auto zed = y + 2;
+      [[maybe_unused]] auto zed = y + 2;
       Assert (false, "OptionUInt32", "y = None + 2 Should throw exception!");
     }
     catch (const std::exception& e)
@@ -0,0 +1,218 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "Raster.h"
+#include "RasterBuffer.h"
+using namespace KKB;
+
+#include "RasterBufferTest.h"
+
+
+namespace  KKBaseTest
+{
+  RasterBufferTest::RasterBufferTest ()
+  {
+  }
+
+
+
+  RasterBufferTest::~RasterBufferTest ()
+  {
+  }
+
+
+
+  void  RasterBufferTest::TagFrame (Raster&  raster,  kkint32  frameNum)
+  {
+    raster.GreenArea ()[0] = (uchar)(frameNum % 256);
+    raster.GreenArea ()[1] = (uchar)(frameNum / 256);
+  }
+
+
+
+  kkint32  RasterBufferTest::FrameTag (const Raster&  raster)
+  {
+    return  raster.GreenArea ()[0] + 256 * raster.GreenArea ()[1];
+  }
+
+
+
+  void  RasterBufferTest::TestBackPressure ()
+  {
+    const kkint32  numFrames = 2000;
+
+    RasterBuffer  buffer ("BackPressure", 4);
+    buffer.Policy (RasterBuffer::FullPolicy::BackPressure);
+
+    std::thread  producer ([&buffer, numFrames] ()
+      {
+        for  (kkint32 frameNum = 0;  frameNum < numFrames;  ++frameNum)
+        {
+          RasterPtr  r = buffer.AllocateRaster (8, 8, false);
+          TagFrame (*r, frameNum);
+          buffer.AddRaster (r);
+        }
+        buffer.Close ();
+      });
+
+    vector<kkint32>  received;
+    while  (true)
+    {
+      RasterPtr  r = buffer.GetNextRaster (-1.0f);
+      if  (!r)
+        break;
+      received.push_back (FrameTag (*r));
+      buffer.RecycleRaster (r);
+    }
+    producer.join ();
+
+    bool  inOrder = (received.size () == (size_t)numFrames);
+    for  (kkint32 x = 0;  (x < (kkint32)received.size ())  &&  inOrder;  ++x)
+      inOrder = (received[x] == x);
+
+    KKStr  msg;
+    msg << "Received[" << (kkint32)received.size () << "]  RastersAllocated[" << buffer.RastersAllocated () << "]";
+    Assert (inOrder, "BackPressure-AllFramesInOrder", msg);
+    Assert (buffer.RastersDropped () == 0, "BackPressure-NoneDropped");
+
+    // Never more than the queue, plus the one the producer is filling and the one the consumer is holding;  after
+    // that every frame comes off the free list.
+    Assert (buffer.RastersAllocated () <= buffer.MaxNumOfBuffers () + 2, "BackPressure-SteadyStateAllocatesNothing", msg);
+    Assert (buffer.RastersAllocated () + buffer.RastersReused () == numFrames, "BackPressure-AllocatedPlusReused");
+  }
+
+
+
+  void  RasterBufferTest::TestDropOldest ()
+  {
+    RasterBuffer  buffer ("DropOldest", 3);
+    Assert (buffer.Policy () == RasterBuffer::FullPolicy::DropOldest, "DropOldest-IsDefault");
+
+    for  (kkint32 frameNum = 0;  frameNum < 10;  ++frameNum)
+    {
+      RasterPtr  r = buffer.AllocateRaster (4, 4, false);
+      TagFrame (*r, frameNum);
+      buffer.AddRaster (r);
+    }
+
+    KKStr  msg;
+    msg << "RastersDropped[" << buffer.RastersDropped () << "]";
+    Assert (buffer.RastersDropped () == 7, "DropOldest-RastersDropped", msg);
+    Assert (buffer.NumPopulated () == 3, "DropOldest-NumPopulated");
+
+    // Dropped rasters go on the free list, so later frames reuse them.
+    Assert (buffer.RastersReused () > 0, "DropOldest-DroppedAreRecycled");
+
+    bool  newestKept = true;
+    for  (kkint32 frameNum = 7;  frameNum < 10;  ++frameNum)
+    {
+      RasterPtr  r = buffer.GetNextRaster ();
+      newestKept = newestKept  &&  (r != NULL)  &&  (FrameTag (*r) == frameNum);
+      delete  r;
+    }
+    Assert (newestKept, "DropOldest-NewestKept");
+    Assert (buffer.GetNextRaster () == NULL, "DropOldest-EmptyReturnsNull");
+  }
+
+
+
+  void  RasterBufferTest::TestCloseWakesWaiters ()
+  {
+    {
+      RasterBuffer  buffer ("CloseConsumer", 2);
+      RasterPtr  result = NULL;
+      bool       returned = false;
+      std::thread  consumer ([&] () {result = buffer.GetNextRaster (-1.0f);  returned = true;});
+
+      std::this_thread::sleep_for (std::chrono::milliseconds (50));
+      buffer.Close ();
+      consumer.join ();
+      Assert (returned  &&  (result == NULL), "Close-WakesConsumer");
+    }
+
+    {
+      RasterBuffer  buffer ("CloseProducer", 1);
+      buffer.Policy (RasterBuffer::FullPolicy::BackPressure);
+      buffer.AddRaster (new Raster (4, 4, false));
+
+      RasterPtr  blocked = new Raster (4, 4, false);
+      bool       added = true;
+      std::thread  producer ([&] () {added = buffer.AddRaster (blocked, -1.0f);});
+
+      std::this_thread::sleep_for (std::chrono::milliseconds (50));
+      buffer.Close ();
+      producer.join ();
+      Assert (!added, "Close-WakesProducer");
+      delete  blocked;
+
+      // What was queued before 'Close' can still be taken.
+      RasterPtr  r = buffer.GetNextRaster (-1.0f);
+      Assert (r != NULL, "Close-QueuedStillAvailable");
+      delete  r;
+      Assert (buffer.GetNextRaster (-1.0f) == NULL, "Close-EmptyDoesNotWait");
+    }
+  }
+
+
+
+  void  RasterBufferTest::TestTimedWaits ()
+  {
+    RasterBuffer  buffer ("Timed", 1);
+    buffer.Policy (RasterBuffer::FullPolicy::BackPressure);
+
+    Assert (buffer.GetNextRaster (0.05f) == NULL, "Timed-GetNextRasterTimesOut");
+
+    Assert (buffer.AddRaster (new Raster (4, 4, false), 0.05f), "Timed-AddRasterWithRoom");
+
+    RasterPtr  extra = new Raster (4, 4, false);
+    Assert (!buffer.AddRaster (extra, 0.05f), "Timed-AddRasterTimesOut");
+    Assert (buffer.RastersDropped () == 0, "Timed-NothingDropped");
+    Assert (buffer.ProducerWaitSecs () > 0.0, "Timed-ProducerWaitCounted");
+    Assert (buffer.ConsumerWaitSecs () > 0.0, "Timed-ConsumerWaitCounted");
+    delete  extra;
+  }
+
+
+
+  void  RasterBufferTest::TestRecycledPixels ()
+  {
+    RasterBuffer  buffer ("Recycle", 2);
+
+    RasterPtr  r = buffer.AllocateRaster (6, 5, false);
+    TagFrame (*r, 1234);
+    buffer.RecycleRaster (r);
+
+    RasterPtr  other = buffer.AllocateRaster (5, 6, false);
+    Assert (other != r, "Recycle-DimensionsMustMatch");
+
+    RasterPtr  again = buffer.AllocateRaster (6, 5, false);
+    Assert (again == r, "Recycle-SameInstance");
+
+    // Documented in 'AllocateRaster':  the previous frame's pixels are still there.
+    Assert (FrameTag (*again) == 1234, "Recycle-PixelsNotCleared");
+
+    Assert ((buffer.RastersAllocated () == 2)  &&  (buffer.RastersReused () == 1), "Recycle-Counts");
+    delete  other;
+    delete  again;
+  }
+
+
+
+  bool  RasterBufferTest::RunTests ()
+  {
+    TestBackPressure ();
+    TestDropOldest ();
+    TestCloseWakesWaiters ();
+    TestTimedWaits ();
+    TestRecycledPixels ();
+    return  FailedCount () == 0;
+  }
+}
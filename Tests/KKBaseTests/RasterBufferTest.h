@@ -0,0 +1,41 @@
+#pragma once
+#include "KKTest.h"
+#include "Raster.h"
+#include "RasterBuffer.h"
+
+namespace  KKBaseTest
+{
+  /**
+   *@brief  Runs 'RasterBuffer' as a producer / consumer queue.
+   *@details  Under 'BackPressure' every frame has to arrive, in order, with 'RastersAllocated' staying flat once
+   * the pipeline is running;  'DropOldest' has to count what it throws out;  'Close' and the timed variants of
+   * 'AddRaster' and 'GetNextRaster' must not leave a thread waiting.
+   */
+  class RasterBufferTest : public KKTest
+  {
+  public:
+    RasterBufferTest ();
+
+    virtual ~RasterBufferTest ();
+
+    virtual const char*  TestName () const { return "RasterBuffer"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  Stamps 'frameNum' into the first two pixels of 'raster'. */
+    static  void     TagFrame (Raster&  raster,  kkint32  frameNum);
+
+    static  kkint32  FrameTag (const Raster&  raster);
+
+    void  TestBackPressure ();
+
+    void  TestDropOldest ();
+
+    void  TestCloseWakesWaiters ();
+
+    void  TestTimedWaits ();
+
+    void  TestRecycledPixels ();
+  };
+}
@@ -0,0 +1,823 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <string.h>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "Raster.h"
+#include "RunLog.h"
+#include "SegmentorOTSU.h"
+using namespace KKB;
+
+#include "SegmentorOTSUTest.h"
+
+
+namespace  KKBaseTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+    private:
+      kkuint32  state;
+    };
+  }
+
+
+
+  SegmentorOTSUTest::SegmentorOTSUTest ()
+  {
+  }
+
+
+
+  SegmentorOTSUTest::~SegmentorOTSUTest ()
+  {
+  }
+
+
+
+  RasterPtr  SegmentorOTSUTest::RandomImage (kkint32  height,
+                                             kkint32  width,
+                                             kkint32  numLevels,
+                                             double   zeroFraction,
+                                             bool     color,
+                                             kkuint32 seed
+                                            )
+  {
+    TestRandom  rand (seed);
+
+    // Distinct gray levels;  the pixels are drawn mostly from two or three clumps of them.
+    vector<uchar>  levels;
+    while  ((kkint32)levels.size () < numLevels)
+    {
+      uchar  level = (uchar)(1 + rand.Next () % 255);
+      bool  found = false;
+      for  (auto l: levels)
+        found = found  ||  (l == level);
+      if  (!found)
+        levels.push_back (level);
+    }
+
+    RasterPtr  image = new Raster (height, width, color);
+    for  (kkint32 r = 0;  r < height;  ++r)
+    {
+      for  (kkint32 c = 0;  c < width;  ++c)
+      {
+        uchar  g = 0;
+        if  (rand.NextDouble () >= zeroFraction)
+        {
+          double  u = rand.NextDouble ();
+          kkint32  idx = (kkint32)(u * u * numLevels);
+          if  ((r * 3 + c) % 5 == 0)
+            idx = numLevels - 1 - idx;
+          g = levels[Min (idx, numLevels - 1)];
+        }
+
+        if  (color)
+        {
+          uchar  red  = (uchar)Min (255u, (kkuint32)g + rand.Next () % 40);
+          uchar  blue = (uchar)((g * 3u / 4u) + rand.Next () % 30);
+          image->SetPixelValue (r, c, red, g, blue);
+        }
+        else
+        {
+          image->SetPixelValue (r, c, g);
+        }
+      }
+    }
+    return  image;
+  }
+
+
+
+  RasterPtr  SegmentorOTSUTest::RandomMask (kkint32  height,
+                                            kkint32  width,
+                                            kkuint32 seed
+                                           )
+  {
+    TestRandom  rand (seed);
+    RasterPtr  mask = new Raster (height, width, false);
+    for  (kkint32 r = 0;  r < height;  ++r)
+    {
+      for  (kkint32 c = 0;  c < width;  ++c)
+      {
+        // A filled ellipse with some noise along its edge.
+        double  dr = (r - height / 2.0) / (height / 2.0);
+        double  dc = (c - width  / 2.0) / (width  / 2.0);
+        bool  inside = (dr * dr + dc * dc) < (0.7 + 0.2 * rand.NextDouble ());
+        mask->SetPixelValue (r, c, (uchar)(inside ? 255 : 0));
+      }
+    }
+    return  mask;
+  }
+
+
+
+  RasterPtr  SegmentorOTSUTest::ReferenceTwoClasses (const Raster&  srcImage,
+                                                     const Raster*  mask,
+                                                     bool           segmentImage,
+                                                     uchar&         threshold,
+                                                     double&        sep
+                                                    )
+  {
+    kkint32  totPixels = srcImage.TotPixels ();
+    const uchar*  srcArea  = srcImage.GreenArea ();
+    const uchar*  maskArea = mask ? mask->GreenArea () : NULL;
+    uchar         maskTh   = mask ? mask->BackgroundPixelTH () : 0;
+
+    kkint32  pixelsCounted = 0;
+    vector<kkint32>  counts (256, 0);
+    if  (segmentImage)
+    {
+      // 'SegmentImage' counted the non zero pixels starting with the second one.
+      for  (kkint32 x = 1;  x < totPixels;  ++x)
+        if  (srcArea[x] >= 1)
+          ++pixelsCounted;
+      for  (kkint32 x = 0;  x < totPixels;  ++x)
+        counts[srcArea[x]]++;
+    }
+    else
+    {
+      pixelsCounted = mask ? mask->TotalBackgroundPixels () : totPixels;
+      for  (kkint32 x = 0;  x < totPixels;  ++x)
+        if  ((!maskArea)  ||  (maskArea[x] > maskTh))
+          counts[srcArea[x]]++;
+    }
+
+    vector<kkint32>  pixval;
+    vector<kkint32>  histo;
+    for  (kkint32 x = (segmentImage ? 1 : 0);  x < 256;  ++x)
+    {
+      if  (counts[x] > 0)
+      {
+        pixval.push_back (x);
+        histo.push_back (counts[x]);
+      }
+    }
+
+    kkint32  nbins = (kkint32)pixval.size ();
+    RasterPtr  result = new Raster (srcImage.Height (), srcImage.Width (), false);
+    uchar*  resultArea = result->GreenArea ();
+
+    if  (nbins <= 2)
+    {
+      for  (kkint32 x = 0;  x < totPixels;  ++x)
+      {
+        resultArea[x] = 0;
+        if  (maskArea  &&  (maskArea[x] <= maskTh))
+          continue;
+        for  (kkint32 b = 0;  b < nbins;  ++b)
+          if  (srcArea[x] == pixval[b])
+            resultArea[x] = (uchar)b;
+      }
+      sep = 1;
+      return  result;
+    }
+
+    vector<double>  P (nbins), w (nbins), mu (nbins);
+    for  (kkint32 x = 0;  x < nbins;  ++x)
+      P[x] = (double)histo[x] / (double)pixelsCounted;
+    w[0]  = P[0];
+    mu[0] = P[0];
+    for  (kkint32 x = 1;  x < nbins;  ++x)
+    {
+      w[x]  = w[x - 1] + P[x];
+      mu[x] = mu[x - 1] + (x + 1) * P[x];
+    }
+    double  muEnd = mu[nbins - 1];
+
+    // sigma2B = (mu(end) * w(2:end-1) - mu(2:end-1)).^2 ./ w(2:end-1)./(1-w(2:end-1));  [maxsig,k] = max(sigma2B);
+    double   maxSig = 0.0;
+    kkint32  k = 0;
+    for  (kkint32 x = 1;  x < (nbins - 1);  ++x)
+    {
+      double  sig = pow (muEnd * w[x] - mu[x], 2.0) / (w[x] / (1.0 - w[x]));
+      if  ((x == 1)  ||  (sig > maxSig))
+      {
+        maxSig = sig;
+        k = x;
+      }
+    }
+
+    kkint32  th = pixval[k];
+    while  (true)
+    {
+      kkint32  numClass2Pixs = 0;
+      for  (kkint32 x = 0;  x < totPixels;  ++x)
+      {
+        if  (maskArea  &&  (maskArea[x] <= maskTh))
+        {
+          resultArea[x] = 0;
+        }
+        else if  (srcArea[x] > th)
+        {
+          resultArea[x] = 2;
+          ++numClass2Pixs;
+        }
+        else
+        {
+          resultArea[x] = 1;
+        }
+      }
+
+      // Only 'SegmentImage' lowered the threshold.
+      if  ((!segmentImage)  ||  (th < 1)  ||  (numClass2Pixs > 100))
+        break;
+      --th;
+    }
+    threshold = (uchar)th;
+
+    // Only the last term of 'sum(((1:nbins)-mu(end)).^2.*P)' was kept.
+    sep = maxSig / (pow ((double)nbins - muEnd, 2.0) * P[nbins - 1]);
+    return  result;
+  }
+
+
+
+  RasterPtr  SegmentorOTSUTest::ReferenceThreeClasses (const Raster&  srcImage,
+                                                       const Raster*  mask,
+                                                       bool           segmentImage,
+                                                       uchar&         threshold1,
+                                                       uchar&         threshold2,
+                                                       double&        sep
+                                                      )
+  {
+    kkint32  totPixels = srcImage.TotPixels ();
+    const uchar*  srcArea  = srcImage.GreenArea ();
+    const uchar*  maskArea = mask ? mask->GreenArea () : NULL;
+    uchar         maskTh   = mask ? mask->BackgroundPixelTH () : 0;
+
+    kkint32  pixelsCounted = 0;
+    vector<kkint32>  counts (256, 0);
+    for  (kkint32 x = 0;  x < totPixels;  ++x)
+    {
+      if  ((!maskArea)  ||  (maskArea[x] > maskTh))
+        counts[srcArea[x]]++;
+      if  (segmentImage  &&  (x > 0)  &&  (srcArea[x] >= 1))
+        ++pixelsCounted;
+    }
+    if  (!segmentImage)
+      pixelsCounted = mask ? mask->TotalBackgroundPixels () : totPixels;
+
+    vector<kkint32>  pixval;
+    vector<double>   P;
+    for  (kkint32 x = (segmentImage ? 1 : 0);  x < 256;  ++x)
+    {
+      if  (counts[x] > 0)
+      {
+        pixval.push_back (x);
+        P.push_back ((double)counts[x] / (double)pixelsCounted);
+      }
+    }
+
+    kkint32  nbins = (kkint32)pixval.size ();
+    RasterPtr  result = new Raster (srcImage.Height (), srcImage.Width (), false);
+    uchar*  resultArea = result->GreenArea ();
+    threshold1 = threshold2 = 0;
+
+    if  (nbins <= 3)
+    {
+      for  (kkint32 x = 0;  x < totPixels;  ++x)
+      {
+        resultArea[x] = 0;
+        if  (maskArea  &&  (maskArea[x] <= maskTh))
+          continue;
+        for  (kkint32 b = 0;  b < nbins;  ++b)
+          if  (srcArea[x] == pixval[b])
+            resultArea[x] = (uchar)b;
+      }
+      sep = 1;
+      return  result;
+    }
+
+    // w = cumsum(P);  mu = cumsum((1:nbins).*P);
+    vector<double>  w (nbins), mu (nbins);
+    w[0]  = P[0];
+    mu[0] = P[0];
+    for  (kkint32 x = 1;  x < nbins;  ++x)
+    {
+      w[x]  = w[x - 1] + P[x];
+      mu[x] = mu[x - 1] + (x + 1) * P[x];
+    }
+    double  muEnd = mu[nbins - 1];
+
+    // w2 = fliplr(cumsum(fliplr(P)));  mu2 = fliplr(cumsum(fliplr((1:nbins).*P)) ./ cumsum(fliplr(P)));  mu0 = mu./w;
+    // Division by zero gave 0.
+    vector<double>  revP, revIdxP;
+    for  (kkint32 x = nbins - 1;  x >= 0;  --x)
+    {
+      revP.push_back    (P[x]);
+      revIdxP.push_back ((double)(x + 1) * P[x]);
+    }
+    vector<double>  w2 (nbins), mu2 (nbins), mu0 (nbins);
+    double  cumP = 0.0, cumIdxP = 0.0;
+    for  (kkint32 x = 0;  x < nbins;  ++x)
+    {
+      cumP    += revP[x];
+      cumIdxP += revIdxP[x];
+      w2 [nbins - 1 - x] = cumP;
+      mu2[nbins - 1 - x] = (cumP == 0.0) ? 0.0 : cumIdxP / cumP;
+    }
+    for  (kkint32 x = 0;  x < nbins;  ++x)
+      mu0[x] = (w[x] == 0.0) ? 0.0 : mu[x] / w[x];
+
+    // [w0,w2] = ndgrid(w0,w2);  [mu0,mu2] = ndgrid(mu0,mu2);  w1 = 1-w0-w2;  w1(w1<=0) = NaN, which was 0.
+    typedef  vector<vector<double>>  Grid;
+    Grid  w0M (nbins, vector<double> (nbins)), w2M = w0M, mu0M = w0M, mu2M = w0M, w1M = w0M, sigma2B = w0M;
+    for  (kkint32 r = 0;  r < nbins;  ++r)
+    {
+      for  (kkint32 c = 0;  c < nbins;  ++c)
+      {
+        w0M [r][c] = w[r];
+        w2M [r][c] = w2[c];
+        mu0M[r][c] = mu0[r];
+        mu2M[r][c] = mu2[c];
+      }
+    }
+    for  (kkint32 r = 0;  r < nbins;  ++r)
+    {
+      for  (kkint32 c = 0;  c < nbins;  ++c)
+      {
+        w1M[r][c] = (1.0 - w0M[r][c]) - w2M[r][c];
+        if  (w1M[r][c] <= 0.0)
+          w1M[r][c] = 0.0;
+      }
+    }
+
+    // sigma2B = w0.*(mu0-mu(end)).^2 + w2.*(mu2-mu(end)).^2 + (w0.*(mu0-mu(end)) + w2.*(mu2-mu(end))).^2./w1;
+    // sigma2B(isnan(sigma2B)) = 0;
+    for  (kkint32 r = 0;  r < nbins;  ++r)
+    {
+      for  (kkint32 c = 0;  c < nbins;  ++c)
+      {
+        double  p1 = w0M[r][c] * pow (mu0M[r][c] - muEnd, 2.0) + w2M[r][c] * pow (mu2M[r][c] - muEnd, 2.0);
+        double  p2 = pow (w0M[r][c] * (mu0M[r][c] - muEnd) + w2M[r][c] * (mu2M[r][c] - muEnd), 2.0) / w1M[r][c];
+        sigma2B[r][c] = p1 + p2;
+        if  (std::isnan (sigma2B[r][c]))
+          sigma2B[r][c] = 0.0;
+      }
+    }
+
+    // 'Matrix::FindMaxValue';  the first largest cell scanning row by row.
+    double   maxSig = sigma2B[0][0];
+    kkint32  k1 = 0, k2 = 0;
+    for  (kkint32 r = 0;  r < nbins;  ++r)
+    {
+      for  (kkint32 c = 0;  c < nbins;  ++c)
+      {
+        if  (sigma2B[r][c] > maxSig)
+        {
+          maxSig = sigma2B[r][c];
+          k1 = r;
+          k2 = c;
+        }
+      }
+    }
+
+    threshold1 = (uchar)pixval[k1];
+    threshold2 = (uchar)pixval[k2];
+    for  (kkint32 x = 0;  x < totPixels;  ++x)
+    {
+      if  (maskArea  &&  (maskArea[x] <= maskTh))
+        resultArea[x] = 0;
+      else if  (srcArea[x] <= threshold1)
+        resultArea[x] = 1;
+      else if  (srcArea[x] <= threshold2)
+        resultArea[x] = 2;
+      else
+        resultArea[x] = 3;
+    }
+
+    // sep = maxsig / sum (((1:nbins)-mu(end)).^2.*P);
+    double  sum = 0.0;
+    for  (kkint32 x = 0;  x < nbins;  ++x)
+      sum += pow ((double)(x + 1) - muEnd, 2.0) * P[x];
+    sep = maxSig / sum;
+    return  result;
+  }
+
+
+
+  double  SegmentorOTSUTest::Criterion (const vector<kkint32>&  counts,
+                                        const vector<kkint32>&  ends
+                                       )
+  {
+    double  total = 0.0;
+    double  w  = 0.0;
+    double  mu = 0.0;
+    kkint32  pos = 0;
+    size_t   classIdx = 0;
+    for  (kkint32 level = 0;  level < 256;  ++level)
+    {
+      if  (counts[level] > 0)
+      {
+        ++pos;
+        w  += counts[level];
+        mu += (double)pos * counts[level];
+      }
+
+      if  ((classIdx < ends.size ())  &&  (level == ends[classIdx]))
+      {
+        if  (w > 0.0)
+          total += mu * mu / w;
+        w  = 0.0;
+        mu = 0.0;
+        ++classIdx;
+      }
+    }
+    return  total;
+  }
+
+
+
+  double  SegmentorOTSUTest::ExhaustiveBest (const vector<kkint32>&  counts,
+                                             kkint32                 numClasses
+                                            )
+  {
+    vector<kkint32>  levels;
+    for  (kkint32 level = 0;  level < 256;  ++level)
+      if  (counts[level] > 0)
+        levels.push_back (level);
+
+    kkint32  nbins = (kkint32)levels.size ();
+    vector<kkint32>  ends (numClasses);
+    ends[numClasses - 1] = levels[nbins - 1];
+
+    double  best = 0.0;
+    std::function<void (kkint32, kkint32)>  search = [&] (kkint32 classIdx, kkint32 firstBin)
+      {
+        if  (classIdx == (numClasses - 1))
+        {
+          best = Max (best, Criterion (counts, ends));
+          return;
+        }
+
+        // Leave at least one bin for each of the classes that follow.
+        for  (kkint32 b = firstBin;  b <= (nbins - (numClasses - classIdx));  ++b)
+        {
+          ends[classIdx] = levels[b];
+          search (classIdx + 1, b + 1);
+        }
+      };
+    search (0, 0);
+    return  best;
+  }
+
+
+
+  void  SegmentorOTSUTest::TestTwoClasses (kkint32  height,
+                                           kkint32  width,
+                                           kkint32  numLevels,
+                                           double   zeroFraction,
+                                           kkuint32 seed
+                                          )
+  {
+    RunLog  log;
+    SegmentorOTSU  segmentor (log);
+
+    RasterPtr  image = RandomImage (height, width, numLevels, zeroFraction, false, seed);
+    RasterPtr  mask  = RandomMask  (height, width, seed);
+
+    KKStr  imageDesc;
+    imageDesc << height << "x" << width << " Levels " << numLevels << " Zeros " << zeroFraction;
+
+    for  (kkint32 variant = 0;  variant < 3;  ++variant)
+    {
+      bool  segmentImage = (variant == 0);
+      RasterPtr  useMask = (variant == 2) ? mask : NULL;
+
+      uchar   expectedTh  = 0;
+      double  expectedSep = 0.0;
+      RasterPtr  expected = ReferenceTwoClasses (*image, useMask, segmentImage, expectedTh, expectedSep);
+
+      double  sep = 0.0;
+      RasterPtr  result = segmentImage ? segmentor.SegmentImage (image, 2, sep)
+                                       : segmentor.SegmentMaskedImage (image, useMask, 2, sep);
+
+      bool  sameLabels = (result != NULL)  &&  (memcmp (result->GreenArea (), expected->GreenArea (), image->TotPixels ()) == 0);
+      bool  sameTh     = (!segmentImage)  ||  (segmentor.Threshold1 () == expectedTh);
+      bool  sameSep    = fabs (sep - expectedSep) <= 1.0e-12 * Max (1.0, fabs (expectedSep));
+
+      KKStr  testName;
+      testName << (segmentImage ? "SegmentImage" : (useMask ? "SegmentMaskedImage" : "SegmentMaskedImage NoMask")) << " 2 Classes " << imageDesc;
+      KKStr  msg;
+      msg << "Threshold1: " << (kkint32)segmentor.Threshold1 () << " Expected: " << (kkint32)expectedTh
+          << "  sep: " << sep << " Expected: " << expectedSep << "  Labels " << (sameLabels ? "match" : "DIFFER");
+      Assert (sameLabels  &&  sameTh  &&  sameSep, testName, msg);
+
+      delete  result;
+      delete  expected;
+    }
+
+    delete  image;
+    delete  mask;
+  }
+
+
+
+  void  SegmentorOTSUTest::TestColor (kkint32  height,
+                                      kkint32  width,
+                                      kkuint32 seed
+                                     )
+  {
+    RunLog  log;
+    SegmentorOTSU  segmentor (log);
+
+    RasterPtr  image = RandomImage (height, width, 40, 0.2, true, seed);
+    RasterPtr  mask  = RandomMask  (height, width, seed + 1);
+
+    for  (bool masked: {false, true})
+    {
+      RasterPtr  gray = masked ? image->CreateGrayScaleKLTOnMaskedArea (*mask) : image->CreateGrayScaleKLT ();
+
+      for  (kkint32 numClasses: {2, 3})
+      {
+        double  graySep = 0.0;
+        double  colorSep = 0.0;
+        RasterPtr  fromGray  = masked ? segmentor.SegmentMaskedImage (gray,  mask, numClasses, graySep)
+                                      : segmentor.SegmentImage       (gray,        numClasses, graySep);
+        RasterPtr  fromColor = masked ? segmentor.SegmentMaskedImage (image, mask, numClasses, colorSep)
+                                      : segmentor.SegmentImage       (image,       numClasses, colorSep);
+
+        bool  same = (fromGray != NULL)  &&  (fromColor != NULL)  &&
+                     (memcmp (fromGray->GreenArea (), fromColor->GreenArea (), image->TotPixels ()) == 0)  &&
+                     (graySep == colorSep);
+
+        KKStr  testName;
+        testName << (masked ? "SegmentMaskedImage" : "SegmentImage") << " Color vs KLT Gray-Scale " << numClasses << " Classes " << height << "x" << width;
+        KKStr  msg;
+        msg << "sep: " << colorSep << " Gray-Scale sep: " << graySep;
+        Assert (same, testName, msg);
+
+        delete  fromGray;
+        delete  fromColor;
+      }
+      delete  gray;
+    }
+
+    delete  image;
+    delete  mask;
+  }
+
+
+
+  void  SegmentorOTSUTest::TestThreeClassesLegacy (kkint32  height,
+                                                   kkint32  width,
+                                                   kkint32  numLevels,
+                                                   double   zeroFraction,
+                                                   kkuint32 seed
+                                                  )
+  {
+    RunLog  log;
+    SegmentorOTSU  segmentor (log);
+
+    RasterPtr  image = RandomImage (height, width, numLevels, zeroFraction, false, seed);
+    RasterPtr  mask  = RandomMask  (height, width, seed);
+
+    KKStr  imageDesc;
+    imageDesc << height << "x" << width << " Levels " << numLevels << " Zeros " << zeroFraction;
+
+    for  (kkint32 variant = 0;  variant < 3;  ++variant)
+    {
+      bool  segmentImage = (variant == 0);
+      RasterPtr  useMask = (variant == 2) ? mask : NULL;
+
+      uchar   expectedTh1 = 0, expectedTh2 = 0;
+      double  expectedSep = 0.0;
+      RasterPtr  expected = ReferenceThreeClasses (*image, useMask, segmentImage, expectedTh1, expectedTh2, expectedSep);
+
+      double  sep = 0.0;
+      RasterPtr  result = segmentImage ? segmentor.SegmentImage (image, 3, sep)
+                                       : segmentor.SegmentMaskedImage (image, useMask, 3, sep);
+
+      bool  sameLabels = (result != NULL)  &&  (memcmp (result->GreenArea (), expected->GreenArea (), image->TotPixels ()) == 0);
+      bool  sameTh     = (segmentor.Threshold1 () == expectedTh1)  &&  (segmentor.Threshold2 () == expectedTh2);
+      bool  sameSep    = (sep == expectedSep)  ||  (std::isnan (sep)  &&  std::isnan (expectedSep));
+
+      KKStr  testName;
+      testName << (segmentImage ? "SegmentImage" : (useMask ? "SegmentMaskedImage" : "SegmentMaskedImage NoMask")) << " 3 Classes Legacy " << imageDesc;
+      KKStr  msg;
+      msg << "Thresholds: " << (kkint32)segmentor.Threshold1 () << "," << (kkint32)segmentor.Threshold2 ()
+          << " Expected: " << (kkint32)expectedTh1 << "," << (kkint32)expectedTh2
+          << "  sep: " << sep << " Expected: " << expectedSep << "  Labels " << (sameLabels ? "match" : "DIFFER");
+      Assert (sameLabels  &&  sameTh  &&  sameSep, testName, msg);
+
+      delete  result;
+      delete  expected;
+    }
+
+    delete  image;
+    delete  mask;
+  }
+
+
+
+  void  SegmentorOTSUTest::TestThreeClassesGolden ()
+  {
+    // Recorded from the 'MatrixD' implementation of 'SegmentImage' and 'SegmentMaskedImage';  'variant' is as in
+    // 'TestTwoClasses'.  'hash' folds the labels in pixel order:  hash = hash * 31 + label.  The earlier
+    // 'SegmentMaskedImage' did not set the thresholds so they are only recorded for 'SegmentImage'.
+    struct  Golden
+    {
+      kkint32   height, width, numLevels;
+      double    zeroFraction;
+      bool      color;
+      kkuint32  seed;
+      kkint32   variant;
+      kkint32   threshold1, threshold2;
+      double    sep;
+      kkuint32  counts[4];
+      kkuint32  hash;
+    };
+
+    const double  inf = HUGE_VAL;
+    const Golden  goldens[] =
+    {
+      {17, 23,  12, 0.0, false, 101, 0, 14, 14, inf, {   0,  18, 0,  373}, 2440669731u},
+      {17, 23,  12, 0.0, false, 101, 1, -1, -1, inf, {   0,  18, 0,  373}, 2440669731u},
+      {17, 23,  12, 0.0, false, 101, 2, -1, -1, inf, { 151,  12, 0,  228}, 1289471774u},
+      {64, 50,  60, 0.3, false, 102, 0,  4,  4, inf, {   0, 986, 0, 2214},  135844140u},
+      {64, 50,  60, 0.3, false, 102, 1, -1, -1, inf, {   0, 957, 0, 2243},  587232814u},
+      {64, 50,  60, 0.3, false, 102, 2, -1, -1, inf, {1204, 591, 0, 1405}, 3596601004u},
+      {30, 30, 200, 0.6, false, 103, 0,  1,  1, inf, {   0, 540, 0,  360}, 1672085020u},
+      {30, 30, 200, 0.6, false, 103, 1, -1, -1, inf, {   0, 539, 0,  361}, 3238842970u},
+      {30, 30, 200, 0.6, false, 103, 2, -1, -1, inf, { 333, 342, 0,  225}, 1428707801u},
+      {31, 29,  40, 0.2, true,  104, 0,  1,  1, inf, {   0,  11, 0,  888},  884647853u},
+      {31, 29,  40, 0.2, true,  104, 1, -1, -1, inf, {   0,   2, 0,  897}, 3176385055u},
+      {31, 29,  40, 0.2, true,  104, 2, -1, -1, inf, { 331,   2, 0,  566}, 3428169658u},
+      { 9, 11,   3, 0.0, false, 105, 0, -1, -1, 1.0, {  43,  24, 32,   0},  107101300u},
+      { 9, 11,   3, 0.0, false, 105, 1, -1, -1, 1.0, {  43,  24, 32,   0},  107101300u},
+      { 9, 11,   3, 0.0, false, 105, 2, -1, -1, 1.0, {  63,  18, 18,   0}, 2714853826u},
+    };
+
+    RunLog  log;
+    for  (const Golden&  g: goldens)
+    {
+      RasterPtr  image = RandomImage (g.height, g.width, g.numLevels, g.zeroFraction, g.color, g.seed);
+      RasterPtr  mask  = RandomMask  (g.height, g.width, g.seed);
+
+      SegmentorOTSU  segmentor (log);
+      double  sep = 0.0;
+      RasterPtr  result = (g.variant == 0) ? segmentor.SegmentImage (image, 3, sep)
+                                           : segmentor.SegmentMaskedImage (image, (g.variant == 2) ? mask : NULL, 3, sep);
+
+      kkuint32  counts[4] = {0, 0, 0, 0};
+      kkuint32  hash = 0;
+      if  (result)
+      {
+        for  (kkint32 x = 0;  x < image->TotPixels ();  ++x)
+        {
+          uchar  label = result->GreenArea ()[x];
+          if  (label < 4)
+            counts[label]++;
+          hash = hash * 31u + label;
+        }
+      }
+
+      bool  sameTh = (g.threshold1 < 0)  ||  ((segmentor.Threshold1 () == g.threshold1)  &&  (segmentor.Threshold2 () == g.threshold2));
+      bool  same = (result != NULL)  &&  sameTh  &&  (sep == g.sep)  &&  (hash == g.hash)  &&
+                   (memcmp (counts, g.counts, sizeof (counts)) == 0);
+
+      KKStr  testName;
+      testName << "3 Classes Golden " << g.height << "x" << g.width << " Levels " << g.numLevels << " Seed " << g.seed << " Variant " << g.variant;
+      KKStr  msg;
+      msg << "Thresholds: " << (kkint32)segmentor.Threshold1 () << "," << (kkint32)segmentor.Threshold2 ()
+          << "  sep: " << sep << "  hash: " << hash;
+      Assert (same, testName, msg);
+
+      delete  result;
+      delete  image;
+      delete  mask;
+    }
+
+    // More than 3 classes was never implemented;  only 'OptimalThresholds' supports it.
+    RasterPtr  image = RandomImage (20, 20, 30, 0.0, false, 106);
+    SegmentorOTSU  segmentor (log);
+    double  sep = 0.0;
+    RasterPtr  result = segmentor.SegmentImage (image, 4, sep);
+    Assert (result == NULL, "4 Classes Legacy", "Expected NULL");
+    delete  result;
+
+    segmentor.OptimalThresholds (true);
+    result = segmentor.SegmentImage (image, 4, sep);
+    Assert (result != NULL, "4 Classes OptimalThresholds", "Returned NULL");
+    delete  result;
+    delete  image;
+  }
+
+
+
+  void  SegmentorOTSUTest::TestMultiClass (kkint32  numClasses,
+                                           kkint32  numLevels,
+                                           kkuint32 seed
+                                          )
+  {
+    RunLog  log;
+    SegmentorOTSU  segmentor (log);
+    segmentor.OptimalThresholds (true);
+
+    RasterPtr  image = RandomImage (40, 37, numLevels, 0.0, false, seed);
+    kkint32  totPixels = image->TotPixels ();
+    const uchar*  srcArea = image->GreenArea ();
+
+    double  sep = 0.0;
+    RasterPtr  result = segmentor.SegmentImage (image, numClasses, sep);
+
+    vector<kkint32>  counts (256, 0);
+    vector<kkint32>  labelOfLevel (256, -1);
+    bool  consistent = (result != NULL);
+    for  (kkint32 x = 0;  (x < totPixels)  &&  consistent;  ++x)
+    {
+      uchar  level = srcArea[x];
+      uchar  label = result->GreenArea ()[x];
+      counts[level]++;
+      if  (labelOfLevel[level] < 0)
+        labelOfLevel[level] = label;
+      consistent = (labelOfLevel[level] == label)  &&  (label >= 1)  &&  (label <= numClasses);
+    }
+
+    // Labels have to increase with the gray level;  the last level of each class is where the next one starts.
+    vector<kkint32>  ends;
+    kkint32  prevLabel = 0;
+    kkint32  prevLevel = -1;
+    for  (kkint32 level = 0;  (level < 256)  &&  consistent;  ++level)
+    {
+      if  (labelOfLevel[level] < 0)
+        continue;
+      consistent = (labelOfLevel[level] >= prevLabel);
+      if  ((labelOfLevel[level] > prevLabel)  &&  (prevLevel >= 0))
+        ends.push_back (prevLevel);
+      prevLabel = labelOfLevel[level];
+      prevLevel = level;
+    }
+    ends.push_back (prevLevel);
+    consistent = consistent  &&  ((kkint32)ends.size () == numClasses);
+
+    double  found = consistent ? Criterion (counts, ends) : 0.0;
+    double  best  = ExhaustiveBest (counts, numClasses);
+
+    KKStr  testName;
+    testName << "SegmentImage " << numClasses << " Classes Levels " << numLevels << " Seed " << seed;
+    KKStr  msg;
+    msg << "Criterion: " << found << " Exhaustive: " << best << "  sep: " << sep << (consistent ? "" : "  Labels not ordered by gray level");
+    Assert (consistent  &&  (fabs (found - best) <= 1.0e-9 * best)  &&  (sep >= 0.0)  &&  (sep <= 1.0 + 1.0e-12), testName, msg);
+
+    delete  result;
+    delete  image;
+  }
+
+
+
+  bool  SegmentorOTSUTest::RunTests ()
+  {
+    kkuint32  seed = 1;
+    for  (kkint32 numLevels: {3, 4, 12, 60, 200})
+    {
+      TestTwoClasses (2,   3,   numLevels, 0.0,  seed++);
+      TestTwoClasses (17,  23,  numLevels, 0.0,  seed++);
+      TestTwoClasses (64,  50,  numLevels, 0.3,  seed++);
+      TestTwoClasses (120, 97,  numLevels, 0.6,  seed++);
+      TestTwoClasses (30,  30,  numLevels, 0.95, seed++);
+    }
+
+    TestColor (31, 29, 5);
+    TestColor (80, 64, 6);
+
+    for  (kkint32 numLevels: {3, 4, 12, 60, 200})
+    {
+      TestThreeClassesLegacy (2,   3,   numLevels, 0.0,  seed++);
+      TestThreeClassesLegacy (17,  23,  numLevels, 0.0,  seed++);
+      TestThreeClassesLegacy (64,  50,  numLevels, 0.3,  seed++);
+      TestThreeClassesLegacy (30,  30,  numLevels, 0.95, seed++);
+    }
+    TestThreeClassesGolden ();
+
+    for  (kkint32 numClasses: {3, 4})
+    {
+      for  (kkint32 numLevels: {5, 12, 25})
+        TestMultiClass (numClasses, numLevels, seed++);
+    }
+
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "Raster.h"
+
+namespace  KKBaseTest
+{
+  /**
+   *@brief  Checks 'SegmentorOTSU' against the results it gave before the thresholds were searched for on the histogram.
+   *@details  Two class segmentation is compared with a transcription of the earlier implementation, labels,
+   * 'Threshold1' and 'sep';  color images against segmenting their KLT gray-scale version.  Three classes by
+   * default against a transcription of the earlier 'MatrixD' implementation and against results recorded from
+   * it;  with 'OptimalThresholds' three and four classes against an exhaustive search over every set of thresholds.
+   */
+  class SegmentorOTSUTest : public KKTest
+  {
+  public:
+    SegmentorOTSUTest ();
+
+    virtual ~SegmentorOTSUTest ();
+
+    virtual const char*  TestName () const { return "SegmentorOTSU"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  Gray-scale image whose pixels come from 'numLevels' random gray levels;  'zeroFraction' of them are 0. */
+    static  RasterPtr  RandomImage (kkint32  height,
+                                    kkint32  width,
+                                    kkint32  numLevels,
+                                    double   zeroFraction,
+                                    bool     color,
+                                    kkuint32 seed
+                                   );
+
+    static  RasterPtr  RandomMask (kkint32  height,
+                                   kkint32  width,
+                                   kkuint32 seed
+                                  );
+
+    /**
+     *@brief  The two class case of 'SegmentImage' ('mask' == NULL) and 'SegmentMaskedImage' as they were
+     *        implemented before;  'srcImage' has to be gray-scale.
+     */
+    static  RasterPtr  ReferenceTwoClasses (const Raster&  srcImage,
+                                            const Raster*  mask,
+                                            bool           segmentImage,
+                                            uchar&         threshold,
+                                            double&        sep
+                                           );
+
+    /**
+     *@brief  The three class case of 'SegmentImage' ('mask' == NULL) and 'SegmentMaskedImage' as they were
+     *        implemented before;  the 'sigma2B' grid is built one MatLab step at a time.
+     */
+    static  RasterPtr  ReferenceThreeClasses (const Raster&  srcImage,
+                                              const Raster*  mask,
+                                              bool           segmentImage,
+                                              uchar&         threshold1,
+                                              uchar&         threshold2,
+                                              double&        sep
+                                             );
+
+    /**
+     *@brief  Sum over the classes of the square of their first moment over their zeroth moment;  the quantity
+     *        the thresholds maximize.
+     *@param[in]  counts  Number of pixels at each gray level that take part.
+     *@param[in]  ends    Last gray level of each class.
+     */
+    static  double  Criterion (const std::vector<kkint32>&  counts,
+                               const std::vector<kkint32>&  ends
+                              );
+
+    /** @brief  Largest 'Criterion' over every way of splitting the levels that occur in 'counts' into 'numClasses'. */
+    static  double  ExhaustiveBest (const std::vector<kkint32>&  counts,
+                                    kkint32                      numClasses
+                                   );
+
+    void  TestTwoClasses (kkint32  height,
+                          kkint32  width,
+                          kkint32  numLevels,
+                          double   zeroFraction,
+                          kkuint32 seed
+                         );
+
+    void  TestColor (kkint32  height,
+                     kkint32  width,
+                     kkuint32 seed
+                    );
+
+    /** @brief  Three classes without 'OptimalThresholds' against 'ReferenceThreeClasses'. */
+    void  TestThreeClassesLegacy (kkint32  height,
+                                  kkint32  width,
+                                  kkint32  numLevels,
+                                  double   zeroFraction,
+                                  kkuint32 seed
+                                 );
+
+    /** @brief  Three classes without 'OptimalThresholds' against results recorded from the earlier implementation. */
+    void  TestThreeClassesGolden ();
+
+    void  TestMultiClass (kkint32  numClasses,
+                          kkint32  numLevels,
+                          kkuint32 seed
+                         );
+  };
+}
@@ -0,0 +1,30 @@
+// KKLineScannerTests.cpp : This file contains the 'main' function. Program execution begins and ends there.
+//
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKTest.h"
+using namespace KKBaseTest;
+
+#include "ScannerFileTest.h"
+using namespace KKLineScannerTest;
+
+  int main ()
+  {
+    KKQueue<KKTest> tests;
+    tests.PushOnBack (new ScannerFileTest ());
+
+    kkuint32 failedCount = 0;
+
+    for (auto test: tests)
+    {
+      test->RunTests ();
+      failedCount += test->FailedCount ();
+    }
+
+    return failedCount;
+  }
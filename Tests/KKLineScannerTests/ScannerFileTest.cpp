@@ -0,0 +1,324 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "MemoryMappedFile.h"
+#include "OSservices.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "ScannerFile.h"
+using namespace KKLSC;
+
+#include "ScannerFileTest.h"
+
+
+namespace  KKLineScannerTest
+{
+  ScannerFileTest::ScannerFileTest ()
+  {
+    log.SetLevel (-1);
+  }
+
+
+
+  ScannerFileTest::~ScannerFileTest ()
+  {
+  }
+
+
+
+  KKStr  ScannerFileTest::TestFileName (ScannerFile::Format  format)
+  {
+    return  "ScannerFileTest_" + ScannerFile::ScannerFileFormatToStr (format) + ".lsc";
+  }
+
+
+
+  void  ScannerFileTest::DeleteTestFile (const KKStr&  fileName)
+  {
+    osDeleteFile (fileName);
+    osDeleteFile (osRemoveExtension (fileName) + ".idx");
+  }
+
+
+
+  ScannerFileTest::ScanLines  ScannerFileTest::TestScanLines ()
+  {
+    ScanLines  scanLines;
+    for  (kkuint32 l = 0;  l < numScanLines;  ++l)
+    {
+      vector<uchar>  line (pixelsPerScanLine);
+      for  (kkuint32 x = 0;  x < pixelsPerScanLine;  ++x)
+      {
+        if  (((l % 50) == 7)  ||  ((((x / 37) + (l / 5)) % 3) == 0))
+          line[x] = 0;
+        else
+          line[x] = (uchar)(((x * 7 + l * 13) ^ (l >> 2)) & 0xFF);
+      }
+      scanLines.push_back (line);
+    }
+    return  scanLines;
+  }
+
+
+
+  void  ScannerFileTest::WriteTestFile (const KKStr&         fileName,
+                                        ScannerFile::Format  format,
+                                        const ScanLines&     scanLines
+                                       )
+  {
+    DeleteTestFile (fileName);
+
+    ScannerFilePtr  sf = ScannerFile::CreateScannerFileForOutput (fileName, format, pixelsPerScanLine, frameHeight, log);
+    if  (!sf)
+      return;
+    sf->InitiateWritting ();
+    for  (auto&  line: scanLines)
+      sf->WriteScanLine (line.data (), (kkuint32)line.size ());
+    sf->Close ();
+    delete  sf;
+    sf = NULL;
+  }
+
+
+
+  ScannerFileTest::ScanLines  ScannerFileTest::ReadRemainingLines (ScannerFilePtr  sf)
+  {
+    ScanLines  lines;
+    vector<uchar>     line (pixelsPerScanLine);
+    vector<kkuint32>  colCount (pixelsPerScanLine, 0);
+    while  (true)
+    {
+      kkuint32  lineSize = 0;
+      kkuint32  pixelsInRow = 0;
+      sf->GetNextLine (line.data (), pixelsPerScanLine, lineSize, colCount.data (), pixelsInRow);
+      if  (sf->Eof ())
+        break;
+      lines.push_back (vector<uchar> (line.begin (), line.begin () + lineSize));
+    }
+    return  lines;
+  }
+
+
+
+  ScannerFileTest::Frames  ScannerFileTest::ReadRemainingFrames (ScannerFilePtr  sf)
+  {
+    Frames  frames;
+    while  (true)
+    {
+      kkuint32  numScanLines = 0;
+      const uchar*  frame = sf->GetNextFrame (numScanLines);
+      if  ((!frame)  ||  (numScanLines == 0))
+        break;
+      ScanLines  lines;
+      for  (kkuint32 l = 0;  l < numScanLines;  ++l)
+        lines.push_back (vector<uchar> (frame + l * pixelsPerScanLine, frame + (l + 1) * pixelsPerScanLine));
+      frames.push_back (lines);
+    }
+    return  frames;
+  }
+
+
+
+  kkuint32  ScannerFileTest::CountPixelMismatches (const ScanLines&  written,
+                                                   const ScanLines&  read,
+                                                   bool              lossless
+                                                  )
+  {
+    kkuint32  mismatches = 0;
+    for  (size_t l = 0;  (l < written.size ())  &&  (l < read.size ());  ++l)
+    {
+      if  (written[l].size () != read[l].size ())
+      {
+        mismatches += (kkuint32)written[l].size ();
+        continue;
+      }
+      for  (size_t x = 0;  x < written[l].size ();  ++x)
+      {
+        if  (lossless ? (written[l][x] != read[l][x]) : ((written[l][x] == 0)  &&  (read[l][x] != 0)))
+          ++mismatches;
+      }
+    }
+    return  mismatches;
+  }
+
+
+
+  kkuint32  ScannerFileTest::CountMismatches (ScannerFilePtr    sf,
+                                              const ScanLines&  expected,
+                                              kkuint32          scanLine,
+                                              kkuint32          count
+                                             )
+  {
+    kkuint32  mismatches = 0;
+    vector<uchar>     line (pixelsPerScanLine);
+    vector<kkuint32>  colCount (pixelsPerScanLine, 0);
+    for  (kkuint32 l = scanLine;  (l < scanLine + count)  &&  (l < expected.size ());  ++l)
+    {
+      kkuint32  lineSize = 0;
+      kkuint32  pixelsInRow = 0;
+      sf->GetNextLine (line.data (), pixelsPerScanLine, lineSize, colCount.data (), pixelsInRow);
+      if  (sf->Eof ()  ||  (vector<uchar> (line.begin (), line.begin () + lineSize) != expected[l]))
+        ++mismatches;
+    }
+    return  mismatches;
+  }
+
+
+
+  void  ScannerFileTest::TestMemoryMapped (ScannerFile::Format  format)
+  {
+    KKStr  testName = "MemoryMapped-" + ScannerFile::ScannerFileFormatToStr (format);
+    KKStr  fileName = TestFileName (format);
+    ScanLines  written = TestScanLines ();
+    WriteTestFile (fileName, format, written);
+    if  (format == ScannerFile::Format::sfSimple)
+    {
+      while  ((written.size () % frameHeight) != 0)
+        written.push_back (vector<uchar> (pixelsPerScanLine, 0));
+    }
+
+    ScannerFilePtr  buffered = ScannerFile::CreateScannerFile (fileName, log);
+    ScannerFilePtr  mapped   = ScannerFile::CreateScannerFile (fileName, log);
+    Assert (buffered  &&  mapped  &&  (buffered->FileFormat () == format), testName + "-Open");
+    if  ((!buffered)  ||  (!mapped))
+    {
+      delete  buffered;
+      delete  mapped;
+      DeleteTestFile (fileName);
+      return;
+    }
+
+    Assert (mapped->MemoryMap (MemoryMappedFile::AccessPattern::Random), testName + "-MemoryMap");
+
+    ScanLines  expected = ReadRemainingLines (buffered);
+    KKStr  msg;
+    kkuint32  pixelMismatches = CountPixelMismatches (written, expected, format == ScannerFile::Format::sfSimple);
+    msg << "Read[" << (kkuint32)expected.size () << "]  Written[" << (kkuint32)written.size () << "]  "
+        << "PixelMismatches[" << pixelMismatches << "]";
+    Assert ((expected.size () == written.size ())  &&  (pixelMismatches == 0), testName + "-AllLinesRead", msg);
+
+    Assert (ReadRemainingLines (mapped) == expected, testName + "-PlayThrough");
+
+    // Jump around, backwards as well as forwards, including into the partial last frame.
+    bool  cancelFlag = false;
+    buffered->BuildFrameOffsets (cancelFlag);
+    mapped->BuildFrameOffsets (cancelFlag);
+
+    vector<kkuint32>  seekTo = {(kkuint32)expected.size () - 1, 0, frameHeight - 1, frameHeight, 3 * frameHeight + 17, 5, numScanLines - 23};
+    kkuint32  rnd = 12345;
+    for  (kkuint32 x = 0;  x < 40;  ++x)
+    {
+      rnd = rnd * 1103515245 + 12345;
+      seekTo.push_back ((rnd >> 8) % (kkuint32)expected.size ());
+    }
+
+    kkuint32  bufferedMismatches = 0;
+    kkuint32  mappedMismatches   = 0;
+    for  (auto  scanLine: seekTo)
+    {
+      buffered->SkipToScanLine (scanLine);
+      mapped->SkipToScanLine (scanLine);
+      bufferedMismatches += CountMismatches (buffered, expected, scanLine, 3);
+      mappedMismatches   += CountMismatches (mapped,   expected, scanLine, 3);
+    }
+    msg = "";
+    msg << "Mismatches  Buffered[" << bufferedMismatches << "]  Mapped[" << mappedMismatches << "]";
+    Assert ((bufferedMismatches == 0)  &&  (mappedMismatches == 0), testName + "-SkipToScanLine", msg);
+
+    kkuint32  frameMismatches = 0;
+    kkuint32  numFrames = ((kkuint32)expected.size () + frameHeight - 1) / frameHeight;
+    for  (kkuint32 frameNum = numFrames;  frameNum > 0;  --frameNum)
+    {
+      bool  found = false;
+      mapped->FrameRead (frameNum - 1, found);
+      if  (!found)
+        ++frameMismatches;
+      else
+        frameMismatches += CountMismatches (mapped, expected, (frameNum - 1) * frameHeight, frameHeight);
+    }
+    msg = "";
+    msg << "Mismatches[" << frameMismatches << "]";
+    Assert (frameMismatches == 0, testName + "-FrameRead", msg);
+
+    delete  buffered;  buffered = NULL;
+    delete  mapped;    mapped = NULL;
+    DeleteTestFile (fileName);
+  }
+
+
+
+  void  ScannerFileTest::TestReadAhead (ScannerFile::Format  format)
+  {
+    KKStr  testName = "ReadAhead-" + ScannerFile::ScannerFileFormatToStr (format);
+    KKStr  fileName = TestFileName (format);
+    WriteTestFile (fileName, format, TestScanLines ());
+
+    ScannerFilePtr  sequential       = ScannerFile::CreateScannerFile (fileName, log);
+    ScannerFilePtr  readAhead        = ScannerFile::CreateScannerFile (fileName, log);
+    ScannerFilePtr  framesSequential = ScannerFile::CreateScannerFile (fileName, log);
+    ScannerFilePtr  framesReadAhead  = ScannerFile::CreateScannerFile (fileName, log);
+    bool  allOpened = sequential  &&  readAhead  &&  framesSequential  &&  framesReadAhead;
+    Assert (allOpened, testName + "-Open");
+    if  (!allOpened)
+    {
+      delete  sequential;
+      delete  readAhead;
+      delete  framesSequential;
+      delete  framesReadAhead;
+      DeleteTestFile (fileName);
+      return;
+    }
+
+    // Frame offsets have to be known for frames to be decoded ahead of the reader.
+    bool  cancelFlag = false;
+    readAhead->BuildFrameOffsets (cancelFlag);
+    framesReadAhead->BuildFrameOffsets (cancelFlag);
+    Assert (readAhead->ReadAheadStart (3, 4)  &&  framesReadAhead->ReadAheadStart (3, 4), testName + "-Start");
+
+    ScanLines  expected = ReadRemainingLines (sequential);
+    ScanLines  lines    = ReadRemainingLines (readAhead);
+    KKStr  msg;
+    msg << "Sequential[" << (kkuint32)expected.size () << "]  ReadAhead[" << (kkuint32)lines.size () << "]";
+    Assert ((expected.size () == numScanLines)  &&  (lines == expected), testName + "-GetNextLine", msg);
+
+    Frames  expectedFrames = ReadRemainingFrames (framesSequential);
+    Frames  frames         = ReadRemainingFrames (framesReadAhead);
+    kkuint32  numFrames = (numScanLines + frameHeight - 1) / frameHeight;
+    bool  lastFramePartial = (expectedFrames.size () == numFrames)  &&  (expectedFrames.back ().size () == numScanLines % frameHeight);
+    msg = "";
+    msg << "Sequential[" << (kkuint32)expectedFrames.size () << "]  ReadAhead[" << (kkuint32)frames.size () << "]";
+    Assert (lastFramePartial  &&  (frames == expectedFrames), testName + "-GetNextFrame", msg);
+
+    delete  sequential;        sequential       = NULL;
+    delete  readAhead;         readAhead        = NULL;
+    delete  framesSequential;  framesSequential = NULL;
+    delete  framesReadAhead;   framesReadAhead  = NULL;
+    DeleteTestFile (fileName);
+  }
+
+
+
+  bool  ScannerFileTest::RunTests ()
+  {
+    for  (auto  format: {ScannerFile::Format::sfSimple,
+                         ScannerFile::Format::sf2BitEncoded,
+                         ScannerFile::Format::sf3BitEncoded,
+                         ScannerFile::Format::sf4BitEncoded,
+                         ScannerFile::Format::sfZlib3BitEncoded
+                        }
+        )
+    {
+      TestMemoryMapped (format);
+      if  (format != ScannerFile::Format::sfSimple)
+        TestReadAhead (format);
+    }
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "RunLog.h"
+#include "ScannerFile.h"
+using namespace KKLSC;
+
+namespace  KKLineScannerTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Reads scanner files of every format back through the different access paths of 'ScannerFile'.
+   *@details  Each file is written with a partial final frame;  read back through buffered file IO it has to
+   * return as many scan lines as were written, the 'Simple' format padding the last frame out with blank scan
+   * lines.  'Simple' has to return the pixels written;  the encoded formats reduce them to 4, 8 or 16 gray levels
+   * but have to keep the background as background.  The scan lines read back are the reference;  a memory mapped instance has to return the same lines, both played through and after
+   * 'SkipToScanLine' and 'FrameRead' to arbitrary positions.
+   */
+  class ScannerFileTest : public KKTest
+  {
+  public:
+    ScannerFileTest ();
+
+    virtual ~ScannerFileTest ();
+
+    virtual const char*  TestName () const { return "ScannerFile"; }
+
+    bool  RunTests () override;
+
+  private:
+    typedef  std::vector<std::vector<uchar> >  ScanLines;
+    typedef  std::vector<ScanLines>            Frames;
+
+    static  const kkuint32  frameHeight       = 64;
+    static  const kkuint32  numScanLines      = 5 * frameHeight + 23;
+    static  const kkuint32  pixelsPerScanLine = 512;
+
+    static  KKStr  TestFileName (ScannerFile::Format  format);
+
+    static  void  DeleteTestFile (const KKStr&  fileName);
+
+    /** @brief  Runs of background between particles of varying intensity, and now and then a blank scan line. */
+    static  ScanLines  TestScanLines ();
+
+    void  WriteTestFile (const KKStr&         fileName,
+                         ScannerFile::Format  format,
+                         const ScanLines&     scanLines
+                        );
+
+    /** @brief  Scan lines returned by 'GetNextLine' from the current position to the end of the file. */
+    ScanLines  ReadRemainingLines (ScannerFilePtr  sf);
+
+    /** @brief  Frames returned by 'GetNextFrame' from the current position to the end of the file. */
+    Frames  ReadRemainingFrames (ScannerFilePtr  sf);
+
+    /** @brief  Number of pixels that are background in 'written' but not in 'read';  exact compare when 'lossless'. */
+    static  kkuint32  CountPixelMismatches (const ScanLines&  written,
+                                            const ScanLines&  read,
+                                            bool              lossless
+                                           );
+
+    /** @brief  Number of the next 'count' lines from 'sf' that do not match 'expected' starting at 'scanLine'. */
+    kkuint32  CountMismatches (ScannerFilePtr    sf,
+                               const ScanLines&  expected,
+                               kkuint32          scanLine,
+                               kkuint32          count
+                              );
+
+    void  TestMemoryMapped (ScannerFile::Format  format);
+
+    void  TestReadAhead (ScannerFile::Format  format);
+
+    RunLog  log;
+  };
+}
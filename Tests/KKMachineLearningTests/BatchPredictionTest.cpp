@@ -0,0 +1,236 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "Classifier2.h"
+#include "ClassProb.h"
+#include "FeatureVector.h"
+#include "FeatureNumList.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "Model.h"
+#include "ModelParamSvmBase.h"
+#include "TrainingConfiguration2.h"
+#include "TrainingProcess2.h"
+using namespace KKMLL;
+
+#include "BatchPredictionTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+      /** @brief  Uniform in [-scale, scale). */
+      double  Symmetric (double  scale)  {return  (NextDouble () * 2.0 - 1.0) * scale;}
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const  kkuint32  numFeatures = 8;
+
+    /** @brief  Enough that 4 threads each get more than the 64 examples 'Classifier2' gives a thread at least. */
+    const  kkuint32  numTestExamples = 400;
+
+    const  kkuint32  numThreads = 4;
+  }
+
+
+
+  BatchPredictionTest::BatchPredictionTest ():
+    fileDesc  (NULL),
+    mlClasses ()
+  {
+    VectorKKStr  fieldNames;
+    for  (kkuint32 x = 0;  x < numFeatures;  ++x)
+      fieldNames.push_back ("Field_" + StrFromUint32 (x));
+    fileDesc = FileDesc::NewContinuousDataOnly (fieldNames);
+
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BatchPrediction_A"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BatchPrediction_B"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BatchPrediction_C"));
+  }
+
+
+
+  BatchPredictionTest::~BatchPredictionTest ()
+  {
+  }
+
+
+
+  FeatureVectorListPtr  BatchPredictionTest::RandomExamples (kkuint32  count,
+                                                             kkuint32  seed
+                                                            )
+  {
+    TestRandom  r (seed);
+    kkuint32  numClasses = mlClasses.QueueSize ();
+
+    FeatureVectorListPtr  examples = new FeatureVectorList (fileDesc, true);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      kkuint32  classIdx = x % numClasses;
+      FeatureVectorPtr  fv = new FeatureVector (numFeatures);
+      float*  featureData = fv->FeatureDataAlter ();
+      // The clouds overlap a little so that some examples get split votes and probabilities away from 0 and 1.
+      for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+        featureData[f] = (float)(((f % numClasses) == classIdx ? 3.0 : 0.0) + r.Symmetric (2.0));
+      fv->MLClass (mlClasses.IdxToPtr (classIdx));
+      fv->ExampleFileName ("Example_" + StrFromUint32 (seed) + "_" + StrFromUint32 (x) + ".bmp");
+      examples->PushOnBack (fv);
+    }
+    return  examples;
+  }
+
+
+
+  void  BatchPredictionTest::TestModel (const KKStr&               modelName,
+                                        TrainingConfiguration2Ptr  config,
+                                        RunLog&                    log
+                                       )
+  {
+    bool  cancelFlag = false;
+    FeatureVectorListPtr  trainingExamples = RandomExamples (150, 1);
+    TrainingProcess2Ptr  trainer = TrainingProcess2::CreateTrainingProcessFromTrainingExamples
+                                       (config, trainingExamples, true, false, cancelFlag, log);
+    Assert (trainer != NULL  &&  !trainer->Abort (), modelName, "Training failed");
+    if  (trainer == NULL  ||  trainer->Abort ())
+    {
+      delete  trainer;
+      return;
+    }
+
+    // If the model could not be shared the batch methods would quietly predict on one thread.
+    ModelPtr  shared = trainer->TrainedModel ()->ShareForPrediction ();
+    Assert (shared != NULL, modelName, "ShareForPrediction returned NULL");
+    delete  shared;
+    shared = NULL;
+
+    Classifier2Ptr  classifier = new Classifier2 (trainer, log);
+
+    kkuint32  numClasses = mlClasses.QueueSize ();
+    kkuint32  numCells = numTestExamples * numClasses;
+
+    // 'ClassifyExamples' assigns the predicted class to each example so every call gets its own copy.
+    FeatureVectorListPtr  examples1 = RandomExamples (numTestExamples, 2);
+    FeatureVectorListPtr  examplesN = RandomExamples (numTestExamples, 2);
+
+    vector<MLClassPtr>  predictions1, predictionsN;
+    classifier->ClassifyExamples (*examples1, predictions1, 1);
+    classifier->ClassifyExamples (*examplesN, predictionsN, numThreads);
+
+    kkuint32  classMismatches = 0, correct = 0;
+    for  (kkuint32 x = 0;  x < numTestExamples;  ++x)
+    {
+      if  (predictions1[x] != predictionsN[x])
+        ++classMismatches;
+      if  (predictions1[x] == mlClasses.IdxToPtr (x % numClasses))
+        ++correct;
+    }
+    Assert (classMismatches == 0, modelName, "ClassifyExamples  " + StrFromUint32 (classMismatches) + " predictions differ between 1 and " + StrFromUint32 (numThreads) + " threads");
+
+    // A model that predicts nothing useful would pass the comparisons trivially.
+    Assert (correct * 2 > numTestExamples, modelName, "Only " + StrFromUint32 (correct) + " of " + StrFromUint32 (numTestExamples) + " predicted correctly");
+
+    vector<kkint32>  votes1 (numCells), votesN (numCells);
+    vector<double>   probs1 (numCells), probsN (numCells);
+    classifier->ProbabilitiesByClass (mlClasses, *examples1, votes1.data (), probs1.data (), 1);
+    classifier->ProbabilitiesByClass (mlClasses, *examplesN, votesN.data (), probsN.data (), numThreads);
+
+    kkuint32  voteMismatches = 0, probMismatches = 0;
+    for  (kkuint32 x = 0;  x < numCells;  ++x)
+    {
+      if  (votes1[x] != votesN[x])
+        ++voteMismatches;
+      if  (probs1[x] != probsN[x])
+        ++probMismatches;
+    }
+    Assert (voteMismatches == 0, modelName, "ProbabilitiesByClass  " + StrFromUint32 (voteMismatches) + " votes differ between 1 and " + StrFromUint32 (numThreads) + " threads");
+    Assert (probMismatches == 0, modelName, "ProbabilitiesByClass  " + StrFromUint32 (probMismatches) + " probabilities differ between 1 and " + StrFromUint32 (numThreads) + " threads");
+
+    // The batch is predicted a block of examples at a time;  it has to agree with predicting one example at a time.
+    vector<kkint32>  singleVotes (numClasses);
+    vector<double>   singleProbs (numClasses);
+    kkuint32  singleMismatches = 0;
+    for  (kkuint32 x = 0;  x < numTestExamples;  ++x)
+    {
+      classifier->ProbabilitiesByClass (mlClasses, examples1->IdxToPtr (x), singleVotes.data (), singleProbs.data ());
+      for  (kkuint32 c = 0;  c < numClasses;  ++c)
+      {
+        if  ((votes1[x * numClasses + c] != singleVotes[c])  ||  (probs1[x * numClasses + c] != singleProbs[c]))
+          ++singleMismatches;
+      }
+    }
+    Assert (singleMismatches == 0, modelName, "ProbabilitiesByClass  " + StrFromUint32 (singleMismatches) + " votes or probabilities differ from predicting one example at a time");
+
+    delete  examples1;   examples1  = NULL;
+    delete  examplesN;   examplesN  = NULL;
+    delete  classifier;  classifier = NULL;
+    delete  trainer;     trainer    = NULL;
+  }  /* TestModel */
+
+
+
+  bool  BatchPredictionTest::RunTests ()
+  {
+    RunLog  log;
+    log.SetLoggingLevel (-1);
+
+    {
+      FeatureVectorListPtr  examples = RandomExamples (150, 1);
+      TrainingConfiguration2Ptr  config = TrainingConfiguration2::CreateFromFeatureVectorList
+          (*examples, fileDesc, "-m 200 -s 0 -n 0.11 -t 2 -g 0.05  -c 10  -u 100  -up  -mt OneVsOne  -sm P", log);
+      TestModel ("OldSVM", config, log);
+      delete  config;    config   = NULL;
+      delete  examples;  examples = NULL;
+    }
+
+    {
+      FeatureVectorListPtr  examples = RandomExamples (150, 1);
+      TrainingConfiguration2Ptr  config = TrainingConfiguration2::CreateFromFeatureVectorList
+          (*examples, fileDesc, "-m 200 -s 0 -n 0.11 -t 2 -g 0.05  -c 10  -u 100  -up  -mt Binary  -sm P", log);
+      TestModel ("OldSVM BinaryCombos", config, log);
+      delete  config;    config   = NULL;
+      delete  examples;  examples = NULL;
+    }
+
+    {
+      // 'ModelSvmBase' predicts from probability estimates so they have to be trained.
+      bool  validFormat = false;
+      ModelParamSvmBase*  parms = new ModelParamSvmBase ();
+      parms->ParseCmdLine ("-s 0 -t 2 -g 0.05 -c 10 -b 1", validFormat, log);
+      Assert (validFormat, "SvmBase", "Parameters not valid");
+      TrainingConfiguration2Ptr  config = new TrainingConfiguration2 (&mlClasses, fileDesc, parms, log);
+      config->SetFeatureNums (FeatureNumList::AllFeatures (fileDesc));
+      TestModel ("SvmBase", config, log);
+      delete  config;  config = NULL;
+    }
+
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "Classifier2.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "RunLog.h"
+#include "TrainingConfiguration2.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks that 'Classifier2' batch predictions do not depend on the number of threads.
+   *@details  Each thread after the first predicts with an instance made by 'Model::ShareForPrediction';  the
+   * predictions, votes and probabilities returned for several threads have to be exactly the ones returned for
+   * a single thread, which predicts with the trained model itself.  The probabilities are predicted a block of
+   * examples at a time and have to be exactly the ones predicted one example at a time.  Done for OldSVM models
+   * with OneVsOne and BinaryCombos machines and a SvmBase model.
+   */
+  class BatchPredictionTest : public KKTest
+  {
+  public:
+    BatchPredictionTest ();
+
+    virtual ~BatchPredictionTest ();
+
+    virtual const char*  TestName () const { return "BatchPrediction"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  'count' examples spread over 'mlClasses', each class a cloud of points around its own center. */
+    FeatureVectorListPtr  RandomExamples (kkuint32  count,
+                                          kkuint32  seed
+                                         );
+
+    /** @brief  Trains a classifier with 'config' and compares batch predictions on 1 thread with several threads. */
+    void  TestModel (const KKStr&               modelName,
+                     TrainingConfiguration2Ptr  config,
+                     RunLog&                    log
+                    );
+
+    FileDescConstPtr  fileDesc;
+    MLClassList       mlClasses;
+  };
+}
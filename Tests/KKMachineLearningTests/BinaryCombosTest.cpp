@@ -0,0 +1,237 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "ClassAssignments.h"
+#include "FeatureNumList.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "SVMModel.h"
+#include "SVMparam.h"
+using namespace KKMLL;
+
+#include "BinaryCombosTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+      /** @brief  Uniform in [-scale, scale). */
+      double  Symmetric (double  scale)  {return  (NextDouble () * 2.0 - 1.0) * scale;}
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const  kkuint32  numFeatures = 9;
+
+    /** @brief  Features the first two classes leave at 0;  they are left out when encoded. */
+    const  kkuint32  numNarrowFeatures = 6;
+
+    /**
+     * Features are floats so their squared differences are exact doubles;  without scales this far apart most
+     * RBF distances would come out the same whatever order they are added up in.
+     */
+    const  double  featureScales[] = {8.0, 1.0, 0.125};
+  }
+
+
+
+  BinaryCombosTest::BinaryCombosTest ():
+    fileDesc  (NULL),
+    mlClasses ()
+  {
+    VectorKKStr  fieldNames;
+    for  (kkuint32 x = 0;  x < numFeatures;  ++x)
+      fieldNames.push_back ("Field_" + StrFromUint32 (x));
+    fileDesc = FileDesc::NewContinuousDataOnly (fieldNames);
+
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BinaryCombos_A"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BinaryCombos_B"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BinaryCombos_C"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BinaryCombos_D"));
+  }
+
+
+
+  BinaryCombosTest::~BinaryCombosTest ()
+  {
+  }
+
+
+
+  FeatureVectorListPtr  BinaryCombosTest::RandomExamples (kkuint32  count,
+                                                          kkuint32  seed
+                                                         )
+  {
+    TestRandom  r (seed);
+    kkuint32  numClasses = mlClasses.QueueSize ();
+
+    FeatureVectorListPtr  examples = new FeatureVectorList (fileDesc, true);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      kkuint32  classIdx = x % numClasses;
+      kkuint32  classFeatures = (classIdx < 2) ? numNarrowFeatures : numFeatures;
+      FeatureVectorPtr  fv = new FeatureVector (numFeatures);
+      float*  featureData = fv->FeatureDataAlter ();
+      for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+      {
+        if  (f < classFeatures)
+          featureData[f] = (float)((((f % numClasses) == classIdx ? 2.0 : 0.0) + r.Symmetric (2.0)) * featureScales[f % 3]);
+        else
+          featureData[f] = 0.0f;
+      }
+      fv->MLClass (mlClasses.IdxToPtr (classIdx));
+      fv->ExampleFileName ("Example_" + StrFromUint32 (seed) + "_" + StrFromUint32 (x) + ".bmp");
+      examples->PushOnBack (fv);
+    }
+    return  examples;
+  }
+
+
+
+  void  BinaryCombosTest::TestKernel (const KKStr&  kernelName,
+                                      const KKStr&  cmdLine
+                                     )
+  {
+    RunLog  log;
+    log.SetLoggingLevel (-1);
+
+    bool  cancelFlag  = false;
+    bool  validFormat = false;
+    KKStr  cmd = cmdLine;
+    FeatureNumList  features = FeatureNumList::AllFeatures (fileDesc);
+    SVMparam  svmParam (cmd, &features, validFormat, log);
+    Assert (validFormat, kernelName, "Parameters not valid: " + cmdLine);
+
+    FeatureVectorListPtr  trainingExamples = RandomExamples (160, 1);
+    ClassAssignments  assignments (mlClasses);
+    SVMModel  model (svmParam, *trainingExamples, assignments, fileDesc, cancelFlag, log);
+    Assert (model.ValidModel (), kernelName, "Training failed");
+    if  (!model.ValidModel ())
+    {
+      delete  trainingExamples;
+      return;
+    }
+
+    kkuint32  numClasses = mlClasses.QueueSize ();
+    kkuint32  numModels  = numClasses * (numClasses - 1) / 2;
+
+    FeatureVectorListPtr  examples = RandomExamples (200, 2);
+
+    // An instance made by 'ShareForPrediction' uses the shared support vectors of 'model' from another thread.
+    SVMModelPtr  shared = model.ShareForPrediction ();
+    Assert (shared != NULL, kernelName, "ShareForPrediction returned NULL");
+    vector<VectorDouble>  sharedDistances (examples->QueueSize ());
+    thread  sharedThread ([shared, examples, &sharedDistances] ()
+      {
+        if  (shared)
+        {
+          for  (kkuint32 x = 0;  x < examples->QueueSize ();  ++x)
+            shared->BinaryComboDistances (examples->IdxToPtr (x), sharedDistances[x]);
+        }
+      }
+    );
+
+    kkuint32  sizeMismatches = 0;
+    kkuint32  differences    = 0;
+    VectorDouble  distances;
+    for  (auto  example: *examples)
+    {
+      model.BinaryComboDistances (example, distances);
+      if  (distances.size () != numModels)
+      {
+        ++sizeMismatches;
+        continue;
+      }
+
+      kkuint32  modelIdx = 0;
+      for  (kkuint32 class1Idx = 0;  class1Idx < numClasses;  ++class1Idx)
+      {
+        for  (kkuint32 class2Idx = class1Idx + 1;  class2Idx < numClasses;  ++class2Idx)
+        {
+          double  reference = model.DistanceFromDecisionBoundary (example, assignments.GetMLClassByIndex (class1Idx), assignments.GetMLClassByIndex (class2Idx));
+          if  (distances[modelIdx] != reference)
+            ++differences;
+          ++modelIdx;
+        }
+      }
+    }
+
+    Assert (sizeMismatches == 0, kernelName, StrFromUint32 (sizeMismatches) + " examples without one distance per model");
+    Assert (differences == 0,    kernelName, StrFromUint32 (differences) + " distances differ from DistanceFromDecisionBoundary");
+
+    sharedThread.join ();
+    if  (shared)
+    {
+      kkuint32  sharedDifferences = 0;
+      for  (kkuint32 x = 0;  x < examples->QueueSize ();  ++x)
+      {
+        model.BinaryComboDistances (examples->IdxToPtr (x), distances);
+        if  (sharedDistances[x] != distances)
+          ++sharedDifferences;
+      }
+      Assert (sharedDifferences == 0, kernelName, StrFromUint32 (sharedDifferences) + " examples with different distances from the shared instance");
+    }
+    delete  shared;
+    shared = NULL;
+
+    // The block version evaluates the kernel for all the examples at once.
+    kkuint32  numCells = examples->QueueSize () * numClasses;
+    vector<kkint32>  blockVotes (numCells), singleVotes (numClasses);
+    vector<double>   blockProbs (numCells), singleProbs (numClasses);
+    model.ProbabilitiesByClass (*examples, mlClasses, blockVotes.data (), blockProbs.data (), log);
+
+    kkuint32  blockDifferences = 0;
+    for  (kkuint32 x = 0;  x < examples->QueueSize ();  ++x)
+    {
+      model.ProbabilitiesByClass (examples->IdxToPtr (x), mlClasses, singleVotes.data (), singleProbs.data (), log);
+      for  (kkuint32 c = 0;  c < numClasses;  ++c)
+      {
+        if  ((blockVotes[x * numClasses + c] != singleVotes[c])  ||  (blockProbs[x * numClasses + c] != singleProbs[c]))
+          ++blockDifferences;
+      }
+    }
+    Assert (blockDifferences == 0, kernelName, StrFromUint32 (blockDifferences) + " votes or probabilities differ between the block and one example at a time");
+
+    delete  examples;
+    delete  trainingExamples;
+  }  /* TestKernel */
+
+
+
+  bool  BinaryCombosTest::RunTests ()
+  {
+    TestKernel ("RBF",        "-MT Binary  -s 0 -t 2 -g 0.01 -c 10");
+    TestKernel ("Linear",     "-MT Binary  -s 0 -t 0 -c 1");
+    TestKernel ("Polynomial", "-MT Binary  -s 0 -t 1 -g 0.01 -r 1 -d 2 -c 1");
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks that a BinaryCombos 'SVMModel' predicts with shared support vector kernels exactly as it would per model.
+   *@details  'SVMModel::BinaryComboDistances' computes the kernel values of the support vectors the 2-class models
+   * have in common once;  each distance has to be exactly the one 'DistanceFromDecisionBoundary' gets from
+   * 'svm_predictTwoClasses' for that pair of classes.  Two of the classes never have their last features set so
+   * the support vectors of their model are narrower than those shared by the others.  An instance made by
+   * 'SVMModel::ShareForPrediction' has to get the same distances on another thread.
+   */
+  class BinaryCombosTest : public KKTest
+  {
+  public:
+    BinaryCombosTest ();
+
+    virtual ~BinaryCombosTest ();
+
+    virtual const char*  TestName () const { return "BinaryCombos"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  'count' examples spread over 'mlClasses';  the first two classes leave the last features at 0. */
+    FeatureVectorListPtr  RandomExamples (kkuint32  count,
+                                          kkuint32  seed
+                                         );
+
+    void  TestKernel (const KKStr&  kernelName,
+                      const KKStr&  cmdLine
+                     );
+
+    FileDescConstPtr  fileDesc;
+    MLClassList       mlClasses;
+  };
+}
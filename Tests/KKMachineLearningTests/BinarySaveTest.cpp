@@ -0,0 +1,271 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "OSservices.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "Classifier2.h"
+#include "FeatureNumList.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "ModelParamSvmBase.h"
+#include "ModelParamUsfCasCor.h"
+#include "TrainingConfiguration2.h"
+#include "TrainingProcess2.h"
+using namespace KKMLL;
+
+#include "BinarySaveTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+      /** @brief  Uniform in [-scale, scale). */
+      double  Symmetric (double  scale)  {return  (NextDouble () * 2.0 - 1.0) * scale;}
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const  kkuint32  numFeatures = 8;
+
+    const  kkuint32  numTrainExamples = 150;
+
+    const  kkuint32  numTestExamples = 200;
+  }
+
+
+
+  BinarySaveTest::BinarySaveTest ():
+    fileDesc        (NULL),
+    heldOutExamples (NULL),
+    mlClasses       ()
+  {
+    VectorKKStr  fieldNames;
+    for  (kkuint32 x = 0;  x < numFeatures;  ++x)
+      fieldNames.push_back ("Field_" + StrFromUint32 (x));
+    fileDesc = FileDesc::NewContinuousDataOnly (fieldNames);
+
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BinarySave_A"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BinarySave_B"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("BinarySave_C"));
+  }
+
+
+
+  BinarySaveTest::~BinarySaveTest ()
+  {
+    delete  heldOutExamples;
+    heldOutExamples = NULL;
+  }
+
+
+
+  FeatureVectorListPtr  BinarySaveTest::RandomExamples (kkuint32  count,
+                                                        kkuint32  seed
+                                                       )
+  {
+    TestRandom  r (seed);
+    kkuint32  numClasses = mlClasses.QueueSize ();
+
+    FeatureVectorListPtr  examples = new FeatureVectorList (fileDesc, true);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      kkuint32  classIdx = x % numClasses;
+      FeatureVectorPtr  fv = new FeatureVector (numFeatures);
+      float*  featureData = fv->FeatureDataAlter ();
+      // The clouds overlap a little so that some examples get split votes and probabilities away from 0 and 1.
+      for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+        featureData[f] = (float)(((f % numClasses) == classIdx ? 3.0 : 0.0) + r.Symmetric (2.0));
+      fv->MLClass (mlClasses.IdxToPtr (classIdx));
+      fv->ExampleFileName ("Example_" + StrFromUint32 (seed) + "_" + StrFromUint32 (x) + ".bmp");
+      examples->PushOnBack (fv);
+    }
+    return  examples;
+  }
+
+
+
+  void  BinarySaveTest::ComparePredictions (const KKStr&         testName,
+                                            TrainingProcess2Ptr  expected,
+                                            TrainingProcess2Ptr  loaded,
+                                            RunLog&              log
+                                           )
+  {
+    Assert (loaded != NULL  &&  !loaded->Abort (), testName, "Saved model could not be loaded");
+    if  (loaded == NULL  ||  loaded->Abort ())
+      return;
+
+    kkuint32  numClasses = mlClasses.QueueSize ();
+    kkuint32  numCells = numTestExamples * numClasses;
+
+    vector<kkint32>  expectedVotes (numCells), loadedVotes (numCells);
+    vector<double>   expectedProbs (numCells), loadedProbs (numCells);
+
+    Classifier2Ptr  expectedClassifier = new Classifier2 (expected, log);
+    expectedClassifier->ProbabilitiesByClass (mlClasses, *heldOutExamples, expectedVotes.data (), expectedProbs.data (), 1);
+    delete  expectedClassifier;
+    expectedClassifier = NULL;
+
+    Classifier2Ptr  loadedClassifier = new Classifier2 (loaded, log);
+    loadedClassifier->ProbabilitiesByClass (mlClasses, *heldOutExamples, loadedVotes.data (), loadedProbs.data (), 1);
+    delete  loadedClassifier;
+    loadedClassifier = NULL;
+
+    kkuint32  voteMismatches = 0, probMismatches = 0, correct = 0;
+    for  (kkuint32 x = 0;  x < numCells;  ++x)
+    {
+      if  (expectedVotes[x] != loadedVotes[x])
+        ++voteMismatches;
+      if  (expectedProbs[x] != loadedProbs[x])
+        ++probMismatches;
+    }
+
+    for  (kkuint32 x = 0;  x < numTestExamples;  ++x)
+    {
+      const double*  probs = &(expectedProbs[x * numClasses]);
+      kkuint32  bestIdx = 0;
+      for  (kkuint32 c = 1;  c < numClasses;  ++c)
+      {
+        if  (probs[c] > probs[bestIdx])
+          bestIdx = c;
+      }
+      if  (bestIdx == (x % numClasses))
+        ++correct;
+    }
+
+    Assert (voteMismatches == 0, testName, StrFromUint32 (voteMismatches) + " votes differ");
+    Assert (probMismatches == 0, testName, StrFromUint32 (probMismatches) + " probabilities differ");
+
+    // A model that predicts nothing useful would pass the comparisons trivially.
+    Assert (correct * 2 > numTestExamples, testName, "Only " + StrFromUint32 (correct) + " of " + StrFromUint32 (numTestExamples) + " predicted correctly");
+  }  /* ComparePredictions */
+
+
+
+  void  BinarySaveTest::DeleteSaveFiles (const KKStr&  configName)
+  {
+    KKStr  rootName = osRemoveExtension (TrainingConfiguration2::GetEffectiveConfigFileName (configName));
+    osDeleteFile (rootName + ".Save");
+    osDeleteFile (rootName + ".SaveBin");
+  }
+
+
+
+  void  BinarySaveTest::TestModel (const KKStr&               modelName,
+                                   TrainingConfiguration2Ptr  config,
+                                   RunLog&                    log
+                                  )
+  {
+    bool  cancelFlag = false;
+
+    KKStr  configName = "BinarySaveTest_" + modelName;
+    KKStr  rootName = osRemoveExtension (TrainingConfiguration2::GetEffectiveConfigFileName (configName));
+    config->ConfigFileNameSpecified (configName);
+    DeleteSaveFiles (configName);
+
+    TrainingProcess2Ptr  trainer = TrainingProcess2::CreateTrainingProcessFromTrainingExamples
+                                       (config, RandomExamples (numTrainExamples, 1), true, false, cancelFlag, log);
+    Assert (trainer != NULL  &&  !trainer->Abort (), modelName, "Training failed");
+    if  (trainer == NULL  ||  trainer->Abort ())
+    {
+      delete  trainer;
+      return;
+    }
+
+    // Only the '.Save' file exists so this is loaded from the XML.
+    trainer->SaveTrainingProcess (log);
+    TrainingProcess2Ptr  xmlTrainer = TrainingProcess2::LoadExistingTrainingProcess (configName, cancelFlag, log);
+    Assert (xmlTrainer != NULL  &&  !xmlTrainer->Abort (), modelName, "XML save file could not be loaded");
+
+    // The conversion tool reads the '.Save' file so its '.SaveBin' holds exactly what the XML loaded model holds.
+    bool  converted = TrainingProcess2::ConvertSavedModelToBinary (configName, cancelFlag, log);
+    Assert (converted  &&  osFileExists (rootName + ".SaveBin"), modelName, "ConvertSavedModelToBinary failed");
+
+    // Without the '.Save' file to fall back to 'LoadExistingTrainingProcess' can only load the '.SaveBin'.
+    osDeleteFile (rootName + ".Save");
+    TrainingProcess2Ptr  convertedTrainer = TrainingProcess2::LoadExistingTrainingProcess (configName, cancelFlag, log);
+    if  (xmlTrainer)
+      ComparePredictions (modelName + "  XML vs Converted", xmlTrainer, convertedTrainer, log);
+
+    DeleteSaveFiles (configName);
+    trainer->SaveTrainingProcessBinary (log);
+    TrainingProcess2Ptr  binTrainer = TrainingProcess2::LoadExistingTrainingProcess (configName, cancelFlag, log);
+    ComparePredictions (modelName + "  Trained vs SaveBin", trainer, binTrainer, log);
+
+    DeleteSaveFiles (configName);
+
+    delete  binTrainer;        binTrainer       = NULL;
+    delete  convertedTrainer;  convertedTrainer = NULL;
+    delete  xmlTrainer;        xmlTrainer       = NULL;
+    delete  trainer;           trainer          = NULL;
+  }  /* TestModel */
+
+
+
+  bool  BinarySaveTest::RunTests ()
+  {
+    RunLog  log;
+    log.SetLoggingLevel (-1);
+
+    heldOutExamples = RandomExamples (numTestExamples, 2);
+
+    {
+      FeatureVectorListPtr  examples = RandomExamples (numTrainExamples, 1);
+      TrainingConfiguration2Ptr  config = TrainingConfiguration2::CreateFromFeatureVectorList
+          (*examples, fileDesc, "-m 200 -s 0 -n 0.11 -t 2 -g 0.05  -c 10  -u 100  -up  -mt OneVsOne  -sm P", log);
+      TestModel ("OldSVM", config, log);
+      delete  config;    config   = NULL;
+      delete  examples;  examples = NULL;
+    }
+
+    {
+      bool  validFormat = false;
+      ModelParamSvmBase*  parms = new ModelParamSvmBase ();
+      parms->ParseCmdLine ("-s 0 -t 2 -g 0.05 -c 10 -b 1", validFormat, log);
+      Assert (validFormat, "SvmBase", "Parameters not valid");
+      TrainingConfiguration2Ptr  config = new TrainingConfiguration2 (&mlClasses, fileDesc, parms, log);
+      config->SetFeatureNums (FeatureNumList::AllFeatures (fileDesc));
+      TestModel ("SvmBase", config, log);
+      delete  config;  config = NULL;
+    }
+
+    {
+      bool  validFormat = false;
+      ModelParamUsfCasCor*  parms = new ModelParamUsfCasCor ();
+      parms->ParseCmdLine ("-InLimit 30 -OutLimit 30 -R 4 -T 1 -S 17", validFormat, log);
+      Assert (validFormat, "UsfCasCor", "Parameters not valid");
+      TrainingConfiguration2Ptr  config = new TrainingConfiguration2 (&mlClasses, fileDesc, parms, log);
+      config->SetFeatureNums (FeatureNumList::AllFeatures (fileDesc));
+      TestModel ("UsfCasCor", config, log);
+      delete  config;  config = NULL;
+    }
+
+    return  FailedCount () == 0;
+  }
+}
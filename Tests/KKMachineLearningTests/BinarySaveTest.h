@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "Classifier2.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "RunLog.h"
+#include "TrainingConfiguration2.h"
+#include "TrainingProcess2.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks that a model loaded from a binary save file ('.SaveBin') predicts exactly as the model it was saved from.
+   *@details  A model is trained and saved as XML ('.Save');  'ConvertSavedModelToBinary' converts that file and the
+   * model loaded from the conversion has to give exactly the same predictions, votes and probabilities as the one
+   * loaded from the XML.  The trained model is also saved straight to a binary file;  as the arrays are not written
+   * as text the model loaded from it has to predict exactly as the trained model itself.  Done for an OldSVM, a
+   * SvmBase and a UsfCasCor model.
+   */
+  class BinarySaveTest : public KKTest
+  {
+  public:
+    BinarySaveTest ();
+
+    virtual ~BinarySaveTest ();
+
+    virtual const char*  TestName () const { return "BinarySave"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  'count' examples spread over 'mlClasses', each class a cloud of points around its own center. */
+    FeatureVectorListPtr  RandomExamples (kkuint32  count,
+                                          kkuint32  seed
+                                         );
+
+    /** @brief  Compares the predictions of 'expected' and 'loaded' on the held out examples bit for bit. */
+    void  ComparePredictions (const KKStr&         testName,
+                              TrainingProcess2Ptr  expected,
+                              TrainingProcess2Ptr  loaded,
+                              RunLog&              log
+                             );
+
+    /** @brief  Deletes the configuration's '.Save' and '.SaveBin' files. */
+    void  DeleteSaveFiles (const KKStr&  configName);
+
+    /**
+     *@brief  Trains a model with 'config', saves and reloads it both ways and compares predictions.
+     *@param[in]  config  Is given the name 'BinarySaveTest_<modelName>' which the save files are named after.
+     */
+    void  TestModel (const KKStr&               modelName,
+                     TrainingConfiguration2Ptr  config,
+                     RunLog&                    log
+                    );
+
+    FileDescConstPtr      fileDesc;
+    FeatureVectorListPtr  heldOutExamples;
+    MLClassList           mlClasses;
+  };
+}
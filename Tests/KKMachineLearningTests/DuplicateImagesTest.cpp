@@ -0,0 +1,424 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "OSservices.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "DuplicateImages.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+using namespace KKMLL;
+
+#include "DuplicateImagesTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const  kkuint32  numFeatures = 4;
+  }
+
+
+
+  DuplicateImagesTest::DuplicateImagesTest ():
+    fileDesc (NULL)
+  {
+    VectorKKStr  fieldNames;
+    for  (kkuint32 x = 0;  x < numFeatures;  ++x)
+      fieldNames.push_back ("Field_" + StrFromUint32 (x));
+    fileDesc = FileDesc::NewContinuousDataOnly (fieldNames);
+  }
+
+
+
+  DuplicateImagesTest::~DuplicateImagesTest ()
+  {
+  }
+
+
+
+  FeatureVectorListPtr  DuplicateImagesTest::RandomExamples (FileDescConstPtr  fileDesc,
+                                                             kkuint32          count,
+                                                             kkuint32          seed
+                                                            )
+  {
+    TestRandom  r (seed);
+    FeatureVectorListPtr  examples = new FeatureVectorList (fileDesc, true);
+
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      FeatureVectorPtr  fv = NULL;
+      if  ((x > 0)  &&  (r.NextDouble () < 0.2))
+      {
+        fv = new FeatureVector (*(examples->IdxToPtr (r.Next () % x)));
+      }
+      else
+      {
+        // Only four values per feature so that unrelated examples also end up with the same data.
+        fv = new FeatureVector (numFeatures);
+        float*  featureData = fv->FeatureDataAlter ();
+        for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+        {
+          float   v = (float)(r.Next () % 4);
+          double  q = r.NextDouble ();
+          if  (q < 0.03)
+            v = std::numeric_limits<float>::quiet_NaN ();
+          else if  ((q < 0.3)  &&  (v == 0.0f))
+            v = -0.0f;
+          featureData[f] = v;
+        }
+      }
+
+      KKStr   name;
+      double  n = r.NextDouble ();
+      if  (n < 0.1)
+      {
+        name = "";
+      }
+      else if  ((x > 0)  &&  (n < 0.25))
+      {
+        KKStr  rootName = osGetRootName (examples->IdxToPtr (r.Next () % x)->ExampleFileName ());
+        if  (rootName.Empty ())
+          rootName = "Image_" + StrFromUint32 (x);
+        name = "OtherDir" + StrFromUint32 (r.Next () % 3) + "/" + rootName + ".bmp";
+      }
+      else
+      {
+        name = "Dir" + StrFromUint32 (r.Next () % 3) + "/Image_" + StrFromUint32 (x) + ".bmp";
+      }
+      fv->ExampleFileName (name);
+
+      examples->PushOnBack (fv);
+    }
+
+    return  examples;
+  }  /* RandomExamples */
+
+
+
+  bool  DuplicateImagesTest::ReferenceSameData (const FeatureVector&  left,
+                                                const FeatureVector&  right
+                                               )
+  {
+    const float*  f1 = left.FeatureData ();
+    const float*  f2 = right.FeatureData ();
+    for  (kkuint32 x = 0;  x < left.NumOfFeatures ();  ++x)
+    {
+      if  (isnan (f1[x])  ||  isnan (f2[x]))
+      {
+        if  (!(isnan (f1[x])  &&  isnan (f2[x])))
+          return false;
+      }
+      else if  (f1[x] != f2[x])
+      {
+        return false;
+      }
+    }
+    return true;
+  }  /* ReferenceSameData */
+
+
+
+  DuplicateImagesTest::SetVector  DuplicateImagesTest::ReferenceSets (const FeatureVectorList&  examples,
+                                                                      kkint32&                  duplicateCount,
+                                                                      kkint32&                  duplicateDataCount,
+                                                                      kkint32&                  duplicateNameCount
+                                                                     )
+  {
+    duplicateCount     = 0;
+    duplicateDataCount = 0;
+    duplicateNameCount = 0;
+
+    SetVector  sets;
+
+    auto  locate = [&sets](FeatureVectorPtr  example) -> kkint32
+      {
+        for  (kkuint32 s = 0;  s < sets.size ();  ++s)
+        {
+          for  (auto e: sets[s])
+            if  (e == example)
+              return (kkint32)s;
+        }
+        return -1;
+      };
+
+    auto  record = [&sets, &locate](FeatureVectorPtr  existing, FeatureVectorPtr  example)
+      {
+        kkint32  s = locate (existing);
+        if  (s < 0)
+          sets.push_back ({existing, example});
+        else
+          sets[s].push_back (example);
+      };
+
+    vector<KKStr>  rootNames;
+    for  (auto fv: examples)
+      rootNames.push_back (fv->ExampleFileName ().Empty () ? KKStr ("") : osGetRootName (fv->ExampleFileName ()));
+
+    for  (kkuint32 x = 0;  x < examples.QueueSize ();  ++x)
+    {
+      FeatureVectorPtr  example = examples.IdxToPtr (x);
+
+      FeatureVectorPtr  existingName = NULL;
+      if  (!example->ExampleFileName ().Empty ())
+      {
+        for  (kkuint32 y = 0;  (y < x)  &&  (!existingName);  ++y)
+        {
+          if  ((!examples.IdxToPtr (y)->ExampleFileName ().Empty ())  &&  (rootNames[y] == rootNames[x]))
+            existingName = examples.IdxToPtr (y);
+        }
+      }
+
+      FeatureVectorPtr  existingData = NULL;
+      for  (kkuint32 y = 0;  (y < x)  &&  (!existingData);  ++y)
+      {
+        if  (ReferenceSameData (*example, *(examples.IdxToPtr (y))))
+          existingData = examples.IdxToPtr (y);
+      }
+
+      if  (existingName  ||  existingData)
+        ++duplicateCount;
+
+      if  (existingName)
+      {
+        ++duplicateNameCount;
+        record (existingName, example);
+      }
+
+      if  (existingData)
+      {
+        ++duplicateDataCount;
+        if  (existingData != existingName)
+          record (existingData, example);
+      }
+    }
+
+    return  sets;
+  }  /* ReferenceSets */
+
+
+
+  DuplicateImagesTest::SetVector  DuplicateImagesTest::ToSets (DuplicateImageList&  dupList)
+  {
+    SetVector  sets;
+    for  (auto dupSet: dupList)
+      sets.push_back (vector<FeatureVectorPtr> (dupSet->DuplicatedImages ()->begin (), dupSet->DuplicatedImages ()->end ()));
+    return  sets;
+  }
+
+
+
+  void  DuplicateImagesTest::CheckLocate (DuplicateImageList&       dupList,
+                                          const FeatureVectorList&  examples,
+                                          const KKStr&              step
+                                         )
+  {
+    kkuint32  mismatches = 0;
+    for  (auto example: examples)
+    {
+      DuplicateImagePtr  expected = NULL;
+      for  (auto dupSet: dupList)
+      {
+        if  (dupSet->AlreadyHaveExample (example))
+        {
+          expected = dupSet;
+          break;
+        }
+      }
+
+      if  (dupList.LocateByImage (example) != expected)
+        ++mismatches;
+    }
+
+    Assert (mismatches == 0, "LocateByImage after " + step, "Mismatches: " + StrFromUint32 (mismatches));
+  }  /* CheckLocate */
+
+
+
+  void  DuplicateImagesTest::TestFindDuplicates (kkuint32  count,
+                                                 kkuint32  seed
+                                                )
+  {
+    RunLog  log;
+    FeatureVectorListPtr  examples = RandomExamples (fileDesc, count, seed);
+
+    kkint32  refCount = 0, refDataCount = 0, refNameCount = 0;
+    SetVector  expected = ReferenceSets (*examples, refCount, refDataCount, refNameCount);
+
+    KKStr  testName = "FindDuplicates count: " + StrFromUint32 (count);
+
+    DuplicateImages  fromList (examples, log);
+    Assert (fromList.DuplicateCount     () == refCount,     testName, "DuplicateCount");
+    Assert (fromList.DuplicateDataCount () == refDataCount, testName, "DuplicateDataCount");
+    Assert (fromList.DuplicateNameCount () == refNameCount, testName, "DuplicateNameCount");
+    Assert (ToSets (*fromList.DupExamples ()) == expected,  testName, "Duplicate sets differ from reference.");
+
+    DuplicateImages  oneAtATime (fileDesc, log);
+    for  (auto example: *examples)
+      oneAtATime.AddSingleExample (example);
+
+    testName = "AddSingleExample count: " + StrFromUint32 (count);
+    Assert (oneAtATime.DuplicateCount     () == refCount,     testName, "DuplicateCount");
+    Assert (oneAtATime.DuplicateDataCount () == refDataCount, testName, "DuplicateDataCount");
+    Assert (oneAtATime.DuplicateNameCount () == refNameCount, testName, "DuplicateNameCount");
+    Assert (ToSets (*oneAtATime.DupExamples ()) == expected,  testName, "Duplicate sets differ from reference.");
+
+    for  (auto example: *examples)
+    {
+      bool  inDetector = oneAtATime.ExampleInDetector (example);
+      if  (!inDetector)
+      {
+        Assert (false, testName, "ExampleInDetector false for " + example->ExampleFileName ());
+        break;
+      }
+    }
+
+    delete  examples;
+  }  /* TestFindDuplicates */
+
+
+
+  void  DuplicateImagesTest::TestListChanges (kkuint32  seed)
+  {
+    FeatureVectorListPtr  examples = RandomExamples (fileDesc, 400, seed);
+
+    kkint32  refCount = 0, refDataCount = 0, refNameCount = 0;
+    SetVector  sets = ReferenceSets (*examples, refCount, refDataCount, refNameCount);
+    if  (sets.size () < 6)
+    {
+      Assert (false, "ListChanges", "Too few duplicate sets to test with.");
+      delete  examples;
+      return;
+    }
+
+    DuplicateImageList  dupList (true);
+    for  (auto& s: sets)
+    {
+      DuplicateImagePtr  dupSet = new DuplicateImage (fileDesc, s[0], s[1]);
+      dupList.AddDuplicateSet (dupSet);
+      for  (kkuint32 x = 2;  x < s.size ();  ++x)
+        dupList.AddToDuplicateSet (dupSet, s[x]);
+    }
+    CheckLocate (dupList, *examples, "AddDuplicateSet");
+
+    // The same number of sets as before, but not the same sets.
+    DuplicateImagePtr  removed = dupList.IdxToPtr (1);
+    dupList.DeleteEntry (removed);
+    dupList.PushOnBack (new DuplicateImage (fileDesc, removed->FirstExampleAdded (), examples->IdxToPtr (0)));
+    delete  removed;
+    CheckLocate (dupList, *examples, "DeleteEntry and PushOnBack");
+
+    dupList.AddDuplicateSet (new DuplicateImage (fileDesc, examples->IdxToPtr (2), examples->IdxToPtr (3)));
+    CheckLocate (dupList, *examples, "AddDuplicateSet on a changed list");
+
+    dupList.AddToDuplicateSet (dupList.IdxToPtr (0), examples->IdxToPtr (4));
+    CheckLocate (dupList, *examples, "AddToDuplicateSet");
+
+    dupList.SwapIndexes (0, dupList.QueueSize () - 1);
+    CheckLocate (dupList, *examples, "SwapIndexes");
+
+    delete  dupList.PopFromFront ();
+    CheckLocate (dupList, *examples, "PopFromFront");
+
+    delete  dupList.IdxToPtr (2);
+    dupList.DeleteEntry ((size_t)2);
+    CheckLocate (dupList, *examples, "DeleteEntry by index");
+
+    DuplicateImagePtr  replaced = dupList.IdxToPtr (0);
+    dupList.SetIdxToPtr (0, new DuplicateImage (fileDesc, examples->IdxToPtr (5), examples->IdxToPtr (6)));
+    delete  replaced;
+    CheckLocate (dupList, *examples, "SetIdxToPtr");
+
+    dupList.PushOnFront (new DuplicateImage (fileDesc, examples->IdxToPtr (7), examples->IdxToPtr (8)));
+    CheckLocate (dupList, *examples, "PushOnFront");
+
+    dupList.RandomizeOrder ((kkint64)seed);
+    CheckLocate (dupList, *examples, "RandomizeOrder");
+
+    dupList.push_back (new DuplicateImage (fileDesc, examples->IdxToPtr (9), examples->IdxToPtr (10)));
+    CheckLocate (dupList, *examples, "std::vector::push_back");
+
+    dupList.DeleteContents ();
+    CheckLocate (dupList, *examples, "DeleteContents");
+
+    delete  examples;
+  }  /* TestListChanges */
+
+
+
+  void  DuplicateImagesTest::TestNaN ()
+  {
+    RunLog  log;
+    float  nan = std::numeric_limits<float>::quiet_NaN ();
+
+    float  data[][numFeatures] = {{1.0f,  nan,  2.0f, 0.0f},
+                                  {1.0f,  nan,  2.0f, -0.0f},   // Same as the first.
+                                  {1.0f,  3.0f, 2.0f, 0.0f},    // NaN does not match a value.
+                                  {1.0f,  nan,  nan,  0.0f},
+                                  {1.0f,  nan,  nan,  0.0f}     // Same as the fourth.
+                                 };
+
+    FeatureVectorList  examples (fileDesc, true);
+    for  (kkuint32 x = 0;  x < 5;  ++x)
+    {
+      FeatureVectorPtr  fv = new FeatureVector (numFeatures);
+      for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+        fv->FeatureDataAlter ()[f] = data[x][f];
+      examples.PushOnBack (fv);
+    }
+
+    DuplicateImages  dups (&examples, log);
+    DuplicateImageListPtr  dupList = dups.DupExamples ();
+
+    Assert (dups.DuplicateDataCount () == 2,  "NaN", "DuplicateDataCount: " + StrFromInt32 (dups.DuplicateDataCount ()));
+    Assert (dupList->QueueSize () == 2,       "NaN", "Number of sets");
+    if  (dupList->QueueSize () == 2)
+    {
+      Assert (dupList->IdxToPtr (0)->AlreadyHaveExample (examples.IdxToPtr (1)), "NaN", "NaN and -0.0 in the same positions");
+      Assert (dupList->IdxToPtr (1)->AlreadyHaveExample (examples.IdxToPtr (4)), "NaN", "Two NaN's in the same positions");
+    }
+    Assert (dupList->LocateByImage (examples.IdxToPtr (2)) == NULL, "NaN", "NaN matched a value");
+  }  /* TestNaN */
+
+
+
+  bool  DuplicateImagesTest::RunTests ()
+  {
+    TestFindDuplicates (300,  1);
+    TestFindDuplicates (2500, 2);
+    TestListChanges (3);
+    TestListChanges (4);
+    TestNaN ();
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "DuplicateImages.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks 'DuplicateImages' and 'DuplicateImageList' against a linear search over the examples.
+   *@details  The duplicate sets found from a list, which are computed on several threads, and the ones found
+   * adding the examples one at a time are both compared with a reference that scans every earlier example the
+   * way the red-black trees were searched before.  'LocateByImage' is checked after each kind of change to
+   * the list, and feature data containing NaN's, 0.0 and -0.0 is checked explicitly.
+   */
+  class DuplicateImagesTest : public KKTest
+  {
+  public:
+    DuplicateImagesTest ();
+
+    virtual ~DuplicateImagesTest ();
+
+    virtual const char*  TestName () const { return "DuplicateImages"; }
+
+    bool  RunTests () override;
+
+  private:
+    typedef  std::vector<std::vector<FeatureVectorPtr>>  SetVector;
+
+    /**
+     *@brief  List of 'count' examples where some repeat the feature data of an earlier example, some the root
+     *        name, some both;  a few features are NaN or -0.0.
+     */
+    static  FeatureVectorListPtr  RandomExamples (FileDescConstPtr  fileDesc,
+                                                  kkuint32          count,
+                                                  kkuint32          seed
+                                                 );
+
+    /** @brief  The duplicate sets and counts 'DuplicateImages' should report for 'examples', in order. */
+    static  SetVector  ReferenceSets (const FeatureVectorList&  examples,
+                                      kkint32&                  duplicateCount,
+                                      kkint32&                  duplicateDataCount,
+                                      kkint32&                  duplicateNameCount
+                                     );
+
+    static  bool  ReferenceSameData (const FeatureVector&  left,
+                                     const FeatureVector&  right
+                                    );
+
+    static  SetVector  ToSets (DuplicateImageList&  dupList);
+
+    /** @brief  'LocateByImage' for every example of 'examples' has to agree with searching the list. */
+    void  CheckLocate (DuplicateImageList&       dupList,
+                       const FeatureVectorList&  examples,
+                       const KKStr&              step
+                      );
+
+    void  TestFindDuplicates (kkuint32  count,
+                              kkuint32  seed
+                             );
+
+    void  TestListChanges (kkuint32  seed);
+
+    void  TestNaN ();
+
+    FileDescConstPtr  fileDesc;
+  };
+}
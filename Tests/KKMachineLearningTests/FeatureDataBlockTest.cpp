@@ -0,0 +1,284 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "FeatureDataBlock.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "NormalizationParms.h"
+using namespace KKMLL;
+
+#include "FeatureDataBlockTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+      /** @brief  Uniform in [-scale, scale). */
+      double  Symmetric (double  scale)  {return  (NextDouble () * 2.0 - 1.0) * scale;}
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const  kkuint32  numFeatures = 13;
+
+    /** @brief  Equal, counting two NaN's as equal;  a feature with no spread normalizes to NaN. */
+    bool  SameValue (double  left,
+                     double  right
+                    )
+    {
+      return  (left == right)  ||  (isnan (left)  &&  isnan (right));
+    }
+  }
+
+
+
+  FeatureDataBlockTest::FeatureDataBlockTest ():
+    fileDesc  (NULL),
+    mlClasses ()
+  {
+    VectorKKStr  fieldNames;
+    for  (kkuint32 x = 0;  x < numFeatures;  ++x)
+      fieldNames.push_back ("Field_" + StrFromUint32 (x));
+    fileDesc = FileDesc::NewContinuousDataOnly (fieldNames);
+
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("FeatureDataBlock_A"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("FeatureDataBlock_B"));
+    mlClasses.PushOnBack (MLClass::GetUnKnownClassStatic ());
+  }
+
+
+
+  FeatureDataBlockTest::~FeatureDataBlockTest ()
+  {
+  }
+
+
+
+  FeatureVectorListPtr  FeatureDataBlockTest::RandomExamples (kkuint32  count,
+                                                              kkuint32  seed
+                                                             )
+  {
+    TestRandom  r (seed);
+    FeatureVectorListPtr  examples = new FeatureVectorList (fileDesc, true);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      FeatureVectorPtr  fv = new FeatureVector (numFeatures);
+      float*  featureData = fv->FeatureDataAlter ();
+      // Features of very different scales so that the order of the sums shows in the last bits.
+      for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+        featureData[f] = (float)(r.Symmetric (1.0) * pow (10.0, (double)(f % 7) - 3.0) + (double)f);
+
+      kkuint32  kind = r.Next () % 16;
+      if  (kind == 0)
+        fv->MLClass (mlClasses.IdxToPtr (2));
+      else
+        fv->MLClass (mlClasses.IdxToPtr (kind % 2));
+
+      if  (kind == 1)
+        fv->MissingData (true);
+
+      fv->ExampleFileName ("Example_" + StrFromUint32 (x) + ".bmp");
+      examples->PushOnBack (fv);
+    }
+    return  examples;
+  }
+
+
+
+  bool  FeatureDataBlockTest::SameFeatureData (const FeatureVectorList&  left,
+                                               const FeatureVectorList&  right
+                                              )
+  {
+    if  (left.QueueSize () != right.QueueSize ())
+      return  false;
+
+    for  (kkuint32 x = 0;  x < (kkuint32)left.QueueSize ();  ++x)
+    {
+      const FeatureVector&  l = left[x];
+      const FeatureVector&  r = right[x];
+      if  (l.NumOfFeatures () != r.NumOfFeatures ())
+        return  false;
+      for  (kkuint32 f = 0;  f < l.NumOfFeatures ();  ++f)
+      {
+        if  (!SameValue (l.FeatureData ()[f], r.FeatureData ()[f]))
+          return  false;
+      }
+    }
+    return  true;
+  }
+
+
+
+  void  FeatureDataBlockTest::TestStats ()
+  {
+    FeatureVectorListPtr  examples     = RandomExamples (1001, 1);
+    FeatureVectorListPtr  consolidated = RandomExamples (1001, 1);
+    consolidated->ConsolidateFeatureData ();
+
+    FeatureDataBlockPtr  block = consolidated->ContiguousFeatureData ();
+    Assert (block != NULL, "Stats", "ContiguousFeatureData returned NULL after ConsolidateFeatureData");
+    Assert (examples->ContiguousFeatureData () == NULL, "Stats", "ContiguousFeatureData not NULL for a list that was not consolidated");
+    Assert (SameFeatureData (*examples, *consolidated), "Stats", "Feature data changed by ConsolidateFeatureData");
+
+    if  (block)
+    {
+      bool  aligned = (((size_t)block->Row (0) % 32) == 0)  &&  ((block->Stride () % 8) == 0);
+      Assert (aligned, "Stats", "Rows not aligned on 32 bytes");
+      Assert (block->NumRows () == 1001  &&  block->NumCols () == numFeatures, "Stats", "Block dimensions");
+    }
+
+    kkuint32  mismatches = 0;
+    for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+    {
+      kkint32  count1 = 0,    count2 = 0;
+      float    total1 = 0.0f, total2 = 0.0f;
+      float    mean1  = 0.0f, mean2  = 0.0f;
+      float    var1   = 0.0f, var2   = 0.0f;
+      float    std1   = 0.0f, std2   = 0.0f;
+      examples->CalcStatsForFeatureNum     (f, count1, total1, mean1, var1, std1);
+      consolidated->CalcStatsForFeatureNum (f, count2, total2, mean2, var2, std2);
+      if  ((count1 != count2)  ||  !SameValue (total1, total2)  ||  !SameValue (mean1, mean2)  ||  !SameValue (var1, var2)  ||  !SameValue (std1, std2))
+        ++mismatches;
+    }
+    Assert (mismatches == 0, "Stats", "CalcStatsForFeatureNum differs for " + StrFromUint32 (mismatches) + " features");
+
+    delete  consolidated;  consolidated = NULL;
+    delete  examples;      examples     = NULL;
+  }  /* TestStats */
+
+
+
+  void  FeatureDataBlockTest::TestNormalization ()
+  {
+    RunLog  log;
+    log.SetLoggingLevel (-1);
+
+    FeatureVectorListPtr  examples     = RandomExamples (777, 2);
+    FeatureVectorListPtr  consolidated = RandomExamples (777, 2);
+    consolidated->ConsolidateFeatureData ();
+
+    NormalizationParms  parms1 (false, *examples,     log);
+    NormalizationParms  parms2 (false, *consolidated, log);
+
+    kkuint32  mismatches = 0;
+    for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+    {
+      if  ((parms1.Mean ()[f] != parms2.Mean ()[f])  ||  (parms1.Sigma ()[f] != parms2.Sigma ()[f]))
+        ++mismatches;
+    }
+    Assert (mismatches == 0, "Normalization", "Mean or Sigma differs for " + StrFromUint32 (mismatches) + " features");
+
+    parms1.NormalizeExamples (examples,     log);
+    parms2.NormalizeExamples (consolidated, log);
+    Assert (SameFeatureData (*examples, *consolidated), "Normalization", "Normalized feature data differs");
+    Assert (consolidated->ContiguousFeatureData () != NULL, "Normalization", "Block no longer used after normalizing in place");
+
+    delete  consolidated;  consolidated = NULL;
+    delete  examples;      examples     = NULL;
+  }  /* TestNormalization */
+
+
+
+  void  FeatureDataBlockTest::TestListChanges ()
+  {
+    FeatureVectorListPtr  examples     = RandomExamples (300, 3);
+    FeatureVectorListPtr  consolidated = RandomExamples (300, 3);
+    consolidated->ConsolidateFeatureData ();
+
+    consolidated->SortByImageFileName ();
+    examples->SortByImageFileName ();
+    Assert (consolidated->ContiguousFeatureData () == NULL, "ListChanges", "Block still used after sorting");
+
+    kkint32  count1 = 0,    count2 = 0;
+    float    total1 = 0.0f, total2 = 0.0f, mean1 = 0.0f, mean2 = 0.0f, var1 = 0.0f, var2 = 0.0f, std1 = 0.0f, std2 = 0.0f;
+    examples->CalcStatsForFeatureNum     (5, count1, total1, mean1, var1, std1);
+    consolidated->CalcStatsForFeatureNum (5, count2, total2, mean2, var2, std2);
+    Assert ((count1 == count2)  &&  SameValue (total1, total2)  &&  SameValue (var1, var2), "ListChanges", "CalcStatsForFeatureNum differs after sorting");
+
+    consolidated->ConsolidateFeatureData ();
+    Assert (consolidated->ContiguousFeatureData () != NULL, "ListChanges", "ConsolidateFeatureData after sorting");
+
+    FeatureVectorPtr  added = new FeatureVector (consolidated->IdxToPtr (0)->NumOfFeatures ());
+    added->MLClass (mlClasses.IdxToPtr (0));
+    consolidated->PushOnBack (added);
+    Assert (consolidated->ContiguousFeatureData () == NULL, "ListChanges", "Block still used after PushOnBack");
+
+    // A resized example gets an array of its own again.
+    FeatureVectorPtr  resized = consolidated->IdxToPtr (10);
+    resized->ResetNumOfFeatures (numFeatures + 2);
+    Assert (resized->FeatureBlock () == NULL, "ListChanges", "Resized example still in the block");
+    Assert (SameValue (resized->FeatureData ()[4], examples->IdxToPtr (10)->FeatureData ()[4]), "ListChanges", "Resized example lost its feature data");
+
+    delete  consolidated;  consolidated = NULL;
+    delete  examples;      examples     = NULL;
+  }  /* TestListChanges */
+
+
+
+  void  FeatureDataBlockTest::TestLifeTime ()
+  {
+    FeatureVectorListPtr  examples     = RandomExamples (50, 4);
+    FeatureVectorListPtr  consolidated = RandomExamples (50, 4);
+    consolidated->ConsolidateFeatureData ();
+
+    FeatureVectorPtr  last = consolidated->PopFromBack ();
+    const float*  lastRow = last->FeatureData ();
+    Assert (FeatureDataBlock::BlockContaining (lastRow) != NULL, "LifeTime", "BlockContaining did not find the block");
+    Assert (last->FeatureBlock () == FeatureDataBlock::BlockContaining (lastRow), "LifeTime", "FeatureBlock differs from BlockContaining");
+
+    // The block has to outlive the list for as long as 'last' points into it.
+    delete  consolidated;  consolidated = NULL;
+    Assert (last->FeatureBlock () != NULL, "LifeTime", "Block released while an example still used it");
+
+    FeatureVectorPtr  original = examples->PopFromBack ();
+    bool  same = true;
+    for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+      same = same  &&  SameValue (last->FeatureData ()[f], original->FeatureData ()[f]);
+    Assert (same, "LifeTime", "Feature data changed after the list was deleted");
+
+    delete  last;  last = NULL;
+    Assert (FeatureDataBlock::BlockContaining (lastRow) == NULL, "LifeTime", "Block not deleted with its last example");
+
+    delete  original;  original = NULL;
+    delete  examples;  examples = NULL;
+  }  /* TestLifeTime */
+
+
+
+  bool  FeatureDataBlockTest::RunTests ()
+  {
+    TestStats ();
+    TestNormalization ();
+    TestListChanges ();
+    TestLifeTime ();
+    return  FailedCount () == 0;
+  }
+}
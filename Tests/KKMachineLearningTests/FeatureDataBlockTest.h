@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "FeatureDataBlock.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks 'FeatureVectorList::ConsolidateFeatureData' against the same examples left with arrays of their own.
+   *@details  'CalcStatsForFeatureNum' and 'NormalizationParms' scan the block when there is one;  their results
+   * have to be exactly those of the per example path.  The block has to stop being used once the list changes
+   * and has to live for as long as any example still points into it.
+   */
+  class FeatureDataBlockTest : public KKTest
+  {
+  public:
+    FeatureDataBlockTest ();
+
+    virtual ~FeatureDataBlockTest ();
+
+    virtual const char*  TestName () const { return "FeatureDataBlock"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  'count' random examples;  a few belong to an undefined class or are missing data so normalization skips them. */
+    FeatureVectorListPtr  RandomExamples (kkuint32  count,
+                                          kkuint32  seed
+                                         );
+
+    /** @brief  True when both lists have identical feature data, example by example. */
+    static  bool  SameFeatureData (const FeatureVectorList&  left,
+                                   const FeatureVectorList&  right
+                                  );
+
+    void  TestLifeTime ();
+
+    void  TestListChanges ();
+
+    void  TestNormalization ();
+
+    void  TestStats ();
+
+    FileDescConstPtr  fileDesc;
+    MLClassList       mlClasses;
+  };
+}
@@ -0,0 +1,1206 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "OSservices.h"
+#include "RunLog.h"
+#include "TextLineReader.h"
+using namespace KKB;
+
+#include "FeatureFileIO.h"
+#include "FeatureFileIOC45.h"
+#include "FeatureFileIOSparse.h"
+#include "FeatureFileIOUCI.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+using namespace KKMLL;
+
+#include "FeatureFileIOTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      kkuint32  Next (kkuint32  n)  {return  Next () % n;}
+
+      /** @brief  One of the 'count' strings in 'choices'. */
+      const char*  Pick (const char* const*  choices,
+                         kkuint32            count
+                        )
+      {
+        return  choices[Next (count)];
+      }
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const char* const  terminators[] = {"\n", "\r\n", "\n\r", "\r"};
+
+
+    /** @brief  A number the way a data file would have it, including some that 'TextLineReader::ParseDouble' hands to 'atof'. */
+    KKStr  RandomNumber (TestRandom&  r)
+    {
+      switch  (r.Next (8))
+      {
+      case 0:   return  StrFromInt32 ((kkint32)r.Next (1000) - 500);
+      case 1:   return  "-0." + StrFromUint32 (r.Next (100000));
+      case 2:   return  StrFromUint32 (r.Next (10)) + "." + StrFromUint32 (r.Next (1000)) + "e-" + StrFromUint32 (r.Next (12));
+      case 3:   return  "0.12345678901234567890123" + StrFromUint32 (r.Next (10));
+      case 4:   return  "." + StrFromUint32 (r.Next (100));
+      default:  return  StrFromUint32 (r.Next (100)) + "." + StrFromUint32 (r.Next (1000));
+      }
+    }
+
+
+
+    /** @brief  'FeatureFileIO::GetLine' as it was when it read one character at a time. */
+    void  ReferenceGetLine (istream&  _in,
+                            KKStr&    _line,
+                            bool&     _eof
+                           )
+    {
+      _line = "";
+      if  (_in.eof ())
+      {
+        _eof = true;
+        return;
+      }
+
+      kkint32  ch = _in.peek ();
+      while  ((ch != '\n')  &&  (ch != '\r')  &&  (!_in.eof ()))
+      {
+        ch = _in.get ();
+        _line.Append ((char)ch);
+        ch = _in.peek ();
+      }
+
+      if  (!_in.eof ())
+      {
+        _in.get ();
+        if  (ch == '\n')
+        {
+          ch = _in.peek ();
+          if  (ch == '\r')
+            _in.get ();
+        }
+        else if  (ch  == '\r')
+        {
+          ch = _in.peek ();
+          if  (ch == '\n')
+            _in.get ();
+        }
+      }
+
+      _eof = false;
+    }  /* ReferenceGetLine */
+
+
+
+    /** @brief  'FeatureFileIO::GetToken' as it was when it read one character at a time. */
+    void  ReferenceGetToken (istream&     _in,
+                             const char*  _delimiters,
+                             KKStr&       _token,
+                             bool&        _eof,
+                             bool&        _eol
+                            )
+    {
+      _token = "";
+      _eof = false;
+      _eol = false;
+
+      if  (_in.eof ())
+      {
+        _eof = true;
+        _eol = true;
+        return;
+      }
+
+      kkint32  ch = _in.peek ();
+      while  ((ch == ' ')  &&  (!_in.eof ()))
+      {
+        _in.get ();
+        ch = _in.peek ();
+      }
+
+      if  (_in.eof ())
+      {
+        _eof = true;
+        _eol = true;
+        return;
+      }
+
+      if  (ch == '\n')
+      {
+        _eol = true;
+        _in.get ();
+        if  (_in.peek () == '\r')
+          _in.get ();
+        return;
+      }
+
+      if  (ch == '\r')
+      {
+        _eol = true;
+        _in.get ();
+        if  (_in.peek () == '\n')
+          _in.get ();
+        return;
+      }
+
+      while  ((!_in.eof ())  &&  (ch != '\n')  &&  (ch != '\r')  &&  (strchr (_delimiters, ch) == NULL))
+      {
+        _in.get ();
+        _token.Append ((char)ch);
+        ch = _in.peek ();
+      }
+
+      if  (strchr (_delimiters, ch) != NULL)
+        _in.get ();
+    }  /* ReferenceGetToken */
+
+
+
+    /** @brief  'FeatureFileIOC45::C45ReadNextToken' as it was when it read one character at a time. */
+    KKStr  ReferenceC45ReadNextToken (istream&     in,
+                                      const char*  delimiters,
+                                      bool&        eof,
+                                      bool&        eol
+                                     )
+    {
+      eof = false;
+      eol = false;
+
+      const kkint32  maxTokenLen = 1024;
+      char  token[maxTokenLen];
+
+      kkint32  ch = in.get (); eof = in.eof ();
+      while  ((!eof)  &&  ((ch == ' ') || (ch == '\r') || (ch == '\t'))  &&  (ch != '\n'))
+        {ch = in.get (); eof = in.eof ();}
+
+      if  (ch == '\n')
+      {
+        eol = true;
+        if  (in.peek () == '\r')
+          in.get ();
+        return "";
+      }
+
+      if  (ch == '\r')
+      {
+        eol = true;
+        if  (in.peek () == '\n')
+          in.get ();
+        return "";
+      }
+
+      else if  (ch == '.')
+      {
+        char nextCh = (char)in.peek ();
+        if  (strchr (" \t\r\n|", nextCh))
+        {
+          eol = true;
+          return "";
+        }
+      }
+
+      else if  (ch == '|')
+      {
+        while  ((!eof)  &&  (ch != '\n')  &&  (ch != '\r'))
+          {ch = in.get (); eof = in.eof ();}
+        eol = true;
+
+        if  (!eof)
+        {
+          if  ((ch == '\n')  &&  (in.peek () == '\r'))
+            in.get ();
+
+          else if  ((ch == '\r')  &&  (in.peek () == '\n'))
+            ch = in.get ();
+        }
+        eof = in.eof ();
+      }
+
+      kkint32 tokenLen = 0;
+
+      while  ((!eof)  &&  (!strchr (delimiters, ch)))
+      {
+        if  ((ch == '\n')  ||  (ch == '|'))
+        {
+          in.putback ((char)ch);
+          break;
+        }
+
+        else if  (ch == '.')
+        {
+          char nextCh = (char)in.get (); bool nextEOF = in.eof ();
+          if  (nextEOF)
+          {
+            in.putback (nextCh);
+            nextCh = (char)in.get (); nextEOF = in.eof ();
+            ch = ' ';
+            break;
+          }
+          else
+          {
+            if  (strchr (" \r\t", nextCh))
+            {
+              in.putback ('.');
+              break;
+            }
+            else if  ((nextCh == '\n')  ||  (nextCh == '|'))
+            {
+              in.putback (nextCh);
+              break;
+            }
+            else
+            {
+              in.putback (nextCh);
+            }
+          }
+        }
+
+        else
+        {
+          if  (ch == '\\')
+          {
+            char nextCh = (char)in.get (); bool nextEOF = in.eof ();
+            if  (nextEOF)
+            {
+              in.putback (nextCh);
+              nextCh = (char)in.get (); nextEOF = in.eof ();
+            }
+            else
+            {
+              if  (strchr (",?:", nextCh))
+                ch = nextCh;
+              else
+                in.putback (nextCh);
+            }
+          }
+
+          else if  (strchr (" \t\r", ch))
+          {
+            ch = ' ';
+
+            char nextCh = (char)in.get (); bool nextEOF = in.eof ();
+            while  ((!nextEOF)  &&  (strchr (" \t\r", nextCh)))
+            {nextCh = (char)in.get (); nextEOF = in.eof ();}
+
+            if  (nextEOF)
+            {
+              in.putback (nextCh);
+              nextCh = (char)in.get ();  nextEOF = in.eof ();
+            }
+            else
+            {
+              in.putback (nextCh);
+            }
+          }
+        }
+
+        token[tokenLen] = (char)ch;
+        tokenLen++;
+        // As in 'ReferenceC45Load' a 'putback' at the end of the file leaves the stream failed without 'eof'
+        // set;  test for EOF itself or a trailing '\\' or blank would run off the end of 'token'.
+        ch = in.get (); eof = (ch == EOF);
+      }
+
+      token[tokenLen] = 0;
+
+      while  (tokenLen > 0)
+      {
+        if  (strchr (" \r\t", token[tokenLen - 1]) == 0)
+          break;
+        tokenLen--;
+        token[tokenLen] = 0;
+      }
+
+      return  token;
+    }  /* ReferenceC45ReadNextToken */
+
+
+
+    /** @brief  'FeatureFileIOSparse::GetFileDesc' as it was;  returns the feature number range and the number of examples. */
+    void  ReferenceSparseFileDesc (istream&      _in,
+                                   MLClassList&  _classes,
+                                   kkint32&      featureNumMin,
+                                   kkint32&      featureNumMax,
+                                   kkint32&      estSize
+                                  )
+    {
+      bool  eof = false;
+      bool  eol = false;
+      featureNumMin = int32_max;
+      featureNumMax = int32_min;
+      estSize = 0;
+
+      while  (!eof)
+      {
+        KKStr  className;
+        ReferenceGetToken (_in, " \t", className, eof, eol);
+        if  (eof)
+          break;
+
+        if  (eol)
+          continue;
+
+        if  (className.StartsWith ("//"))
+        {
+          while  ((!eol)  &&  (!eof))
+            ReferenceGetToken (_in, " \t", className, eof, eol);
+          continue;
+        }
+
+        _classes.GetMLClassPtr (className);
+
+        KKStr  field;
+        ReferenceGetToken (_in, " \t", field, eof, eol);
+        while  (!eol)
+        {
+          KKStr  featureNumStr = field.ExtractToken (":");
+          kkint32 featureNum = atoi (featureNumStr.Str ());
+          if  (featureNum > featureNumMax)
+            featureNumMax = featureNum;
+          if  (featureNum < featureNumMin)
+            featureNumMin = featureNum;
+          ReferenceGetToken (_in, " \t", field, eof, eol);
+        }
+        estSize++;
+      }
+    }  /* ReferenceSparseFileDesc */
+
+
+
+    /** @brief  'FeatureFileIOSparse::LoadFile' as it was. */
+    FeatureFileIOTest::LoadResult  ReferenceSparseLoad (istream&       _in,
+                                                        const KKStr&   _fileName,
+                                                        kkint32        minFeatureNum,
+                                                        kkint32        numOfFeatures,
+                                                        OptionUInt32   _maxCount
+                                                       )
+    {
+      FeatureFileIOTest::LoadResult  result;
+      bool  eof = false;
+      bool  eol = true;
+      KKStr  rootName = osGetRootName (_fileName);
+      kkint32  lineCount = 0;
+      kkint32  maxFeatureNum = minFeatureNum + numOfFeatures - 1;
+      kkuint32  maxToLoad = (_maxCount  ? _maxCount.value () : uint32_max);
+
+      while  ((!eof)  &&  (result.examples.size () < maxToLoad))
+      {
+        KKStr  className;
+        ReferenceGetToken (_in, " \t", className, eof, eol);
+        if  (eof)
+          break;
+
+        if  (eol)
+          continue;
+
+        if  (className.StartsWith ("//"))
+        {
+          while  ((!eol)  &&  (!eof))
+            ReferenceGetToken (_in, " \t", className, eof, eol);
+          continue;
+        }
+
+        FeatureFileIOTest::LoadedExample  example;
+        example.className       = className;
+        example.exampleFileName = rootName + "_" + StrFormatInt (lineCount, "ZZZZZZ0");
+        example.features.assign (numOfFeatures, 0.0f);
+        example.missingData     = false;
+
+        KKStr  field = "";
+        ReferenceGetToken (_in, " \t", field, eof, eol);
+        while  ((!eol)  &&  (!eof))
+        {
+          KKStr  featureNumStr = field.ExtractToken (":");
+          kkint32 featureNum = atoi (featureNumStr.Str ());
+          if  ((featureNum < minFeatureNum)  ||  (featureNum > maxFeatureNum))
+          {
+            result.errorMessage << "FeatureNum[" << featureNumStr << "]  is out of range.";
+            result.examples.clear ();
+            return  result;
+          }
+
+          example.features[featureNum - minFeatureNum] = (float)atof (field.Str ());
+          ReferenceGetToken (_in, " \t", field, eof, eol);
+        }
+
+        result.examples.push_back (example);
+        lineCount++;
+      }
+
+      result.loaded = true;
+      return  result;
+    }  /* ReferenceSparseLoad */
+
+
+
+    /** @brief  'FeatureFileIOUCI::GetFileDesc' as it was;  returns the number of fields and examples. */
+    void  ReferenceUCIFileDesc (istream&      _in,
+                                MLClassList&  _classes,
+                                kkint32&      numOfFields,
+                                kkint32&      estSize
+                               )
+    {
+      KKStr  ln (256);
+      bool   eof = false;
+      numOfFields = 0;
+      estSize = 0;
+
+      ReferenceGetLine (_in, ln, eof);
+      while  (!eof)
+      {
+        ln.TrimLeft ();
+        ln.TrimRight ();
+        if  ((!ln.StartsWith ("//"))  &&  (!ln.Empty ()))
+        {
+          kkint32  numFieldsThisLine = 0;
+          KKStr  className = ln.ExtractToken (" ,\n\r\t");
+          while (!ln.Empty ())
+          {
+            numFieldsThisLine++;
+            className = ln.ExtractToken (" ,\n\r\t");
+          }
+
+          if  (className.Empty ())
+            className = "UnKnown";
+
+          _classes.GetMLClassPtr (className);
+          numOfFields = Max (numOfFields, numFieldsThisLine);
+          estSize++;
+        }
+        ReferenceGetLine (_in, ln, eof);
+      }
+    }  /* ReferenceUCIFileDesc */
+
+
+
+    /** @brief  'FeatureFileIOUCI::LoadFile' as it was. */
+    FeatureFileIOTest::LoadResult  ReferenceUCILoad (istream&      _in,
+                                                     const KKStr&  _fileName,
+                                                     kkint32       numOfFeatures,
+                                                     OptionUInt32  _maxCount
+                                                    )
+    {
+      FeatureFileIOTest::LoadResult  result;
+      KKStr  rootName = osGetRootName (_fileName);
+      kkint32  lineCount = 0;
+      kkuint32  maxToLoad = (_maxCount  ? _maxCount.value () : uint32_max);
+
+      KKStr  ln (256);
+      bool  eof = false;
+
+      ReferenceGetLine (_in, ln, eof);
+      while  (!eof  &&  (result.examples.size () < maxToLoad))
+      {
+        ln.TrimLeft ();
+        ln.TrimRight ();
+
+        if  ((!ln.StartsWith ("//"))  &&  (!ln.Empty ()))
+        {
+          FeatureFileIOTest::LoadedExample  example;
+          for  (kkint32 featureNum = 0;  featureNum < numOfFeatures;  featureNum++)
+          {
+            KKStr  featureStr = ln.ExtractToken (" ,\n\r\t");
+            example.features.push_back ((float)atof (featureStr.Str ()));
+          }
+
+          example.className       = ln.ExtractToken (" ,\n\r\t");
+          example.exampleFileName = rootName + "_" + StrFormatInt (lineCount, "ZZZZZZ0");
+          example.missingData     = false;
+          result.examples.push_back (example);
+          lineCount++;
+        }
+        ReferenceGetLine (_in, ln, eof);
+      }
+
+      result.loaded = true;
+      return  result;
+    }  /* ReferenceUCILoad */
+
+
+
+    /** @brief  'FeatureFileIOC45::LoadFile' as it was. */
+    FeatureFileIOTest::LoadResult  ReferenceC45Load (istream&          _in,
+                                                     const KKStr&      _fileName,
+                                                     FileDescConstPtr  _fileDesc,
+                                                     OptionUInt32      _maxCount
+                                                    )
+    {
+      FeatureFileIOTest::LoadResult  result;
+
+      bool  eof = false;
+      bool  eol = false;
+
+      kkint32  numOfFeatures = _fileDesc->NumOfFields ();
+      KKStr fileRootName = osGetRootName (_fileName);
+      kkint32  lineCount = 0;
+      auto  attributeTable = _fileDesc->CreateAAttributeConstTable ();
+      kkuint32 maxToLoad = (_maxCount  ? _maxCount.value () : uint32_max);
+
+      while  ((!eof)  &&  (result.examples.size () < maxToLoad))
+      {
+        KKStr  imageFileName = "";
+        KKStr  field = ReferenceC45ReadNextToken (_in, ",", eof, eol);
+        if  (eof)
+          break;
+
+        if  (eol)
+          continue;
+
+        FeatureFileIOTest::LoadedExample  example;
+        example.missingData = false;
+
+        for  (kkint32 fieldNum = 0;  fieldNum < numOfFeatures;  fieldNum++)
+        {
+          if  (eol  ||  eof)
+          {
+            result.errorMessage << "Not all Features were accounted for on Line[" << lineCount << "].";
+            result.examples.clear ();
+            delete[]  attributeTable;
+            return  result;
+          }
+
+          switch  (attributeTable[fieldNum]->Type ())
+          {
+          case AttributeType::Ignore:
+          case AttributeType::Numeric:
+            example.features.push_back (field.ToFloat ());
+            break;
+
+          case AttributeType::Nominal:
+          {
+            kkint32  code = -1;
+            if  (field == "?")
+            {
+              example.missingData = true;
+            }
+            else
+            {
+              code = attributeTable[fieldNum]->GetNominalCode (field);
+              if  (code < 0)
+              {
+                result.errorMessage << "Invalid NominalValue[" << field << "]  on line[" << lineCount << "].";
+                result.examples.clear ();
+                delete[]  attributeTable;
+                return  result;
+              }
+            }
+            example.features.push_back ((float)code);
+            break;
+          }
+
+          case AttributeType::Symbolic:
+          {
+            kkint32  code = -1;
+            if  (field == "?")
+            {
+              example.missingData = true;
+            }
+            else
+            {
+              if  (attributeTable[fieldNum]->Name ().EqualIgnoreCase ("ExampleFileName"))
+                imageFileName = field;
+
+              code = attributeTable[fieldNum]->GetNominalCode (field);
+              if  (code < 0)
+                result.errorMessage << "Invalid NominalValue[" << field << "]  on line[" << lineCount << "].";
+            }
+            example.features.push_back ((float)code);
+            break;
+          }
+
+          default:
+            example.features.push_back (0.0f);
+            break;
+          }
+
+          field = ReferenceC45ReadNextToken (_in, " ,", eof, eol);
+        }
+
+        if  ((field.Empty ())  ||  eol)
+        {
+          result.errorMessage << "Line[" << lineCount << "]  Missing ClassName.";
+          result.examples.clear ();
+          delete[]  attributeTable;
+          return  result;
+        }
+
+        MLClassPtr  mlClass = NULL;
+        if  (field == "?")
+        {
+          mlClass = _fileDesc->LookUpUnKnownMLClass ();
+        }
+        else
+        {
+          mlClass = _fileDesc->LookUpMLClassByName (field);
+          if  (!mlClass)
+          {
+            result.errorMessage << "Line[" << lineCount << "]  Invalid Class[" << field << "]";
+            result.examples.clear ();
+            delete[]  attributeTable;
+            return  result;
+          }
+        }
+
+        example.className = (mlClass ? mlClass->Name () : KKStr ("<NULL>"));
+
+        if  (imageFileName.Empty ())
+          imageFileName = fileRootName + "_" + StrFormatInt (lineCount, "ZZZZZ0");
+        example.exampleFileName = imageFileName;
+
+        result.examples.push_back (example);
+        lineCount++;
+
+        if  (!eof)
+        {
+          // A 'putback' at the end of the file leaves the stream failed without 'eof' set;  'peek' then keeps
+          // returning EOF, so test for that rather than for 'eof' or this would never return.
+          kkint32  ch = _in.peek ();
+          while  ((ch != '\n')  &&  (ch != '\r')  &&  (ch != EOF))
+          {
+            _in.get ();
+            ch = _in.peek ();
+          }
+          if  (ch != EOF)
+          {
+            _in.get ();
+            if  ((ch == '\n')  &&  (_in.peek () == '\r'))
+               _in.get ();
+
+            else if  ((ch == '\r')  &&  (_in.peek () == '\n'))
+               _in.get ();
+          }
+        }
+      }
+
+      delete[]  attributeTable;
+      result.loaded = true;
+      return  result;
+    }  /* ReferenceC45Load */
+  }  /* namespace */
+
+
+
+  FeatureFileIOTest::FeatureFileIOTest ():
+    c45FileDesc (NULL)
+  {
+  }
+
+
+
+  FeatureFileIOTest::~FeatureFileIOTest ()
+  {
+  }
+
+
+
+  FeatureFileIOTest::LoadResult  FeatureFileIOTest::ToLoadResult (FeatureVectorListPtr  examples,
+                                                                  const KKStr&          errorMessage
+                                                                 )
+  {
+    LoadResult  result;
+    result.errorMessage = errorMessage;
+    result.loaded = (examples != NULL);
+    if  (!examples)
+      return  result;
+
+    for  (auto  fv: *examples)
+    {
+      LoadedExample  example;
+      example.className       = (fv->MLClass () ? fv->MLClass ()->Name () : KKStr ("<NULL>"));
+      example.exampleFileName = fv->ExampleFileName ();
+      example.features.assign (fv->FeatureData (), fv->FeatureData () + fv->NumOfFeatures ());
+      example.missingData     = fv->MissingData ();
+      result.examples.push_back (example);
+    }
+    return  result;
+  }  /* ToLoadResult */
+
+
+
+  void  FeatureFileIOTest::CompareLoads (const KKStr&       section,
+                                         const LoadResult&  expected,
+                                         const LoadResult&  actual
+                                        )
+  {
+    Assert (expected.loaded == actual.loaded, section, KKStr ("Expected ") + (expected.loaded ? "a list" : "NULL") + "  Error: " + actual.errorMessage);
+    Assert (expected.errorMessage == actual.errorMessage, section, "Error message[" + actual.errorMessage + "]  expected[" + expected.errorMessage + "]");
+    if  (!expected.loaded  ||  !actual.loaded)
+      return;
+
+    Assert (expected.examples.size () == actual.examples.size (), section,
+            "Loaded " + StrFromUint64 (actual.examples.size ()) + " examples;  expected " + StrFromUint64 (expected.examples.size ()));
+
+    kkuint32  differences = 0;
+    KKStr     firstDifference;
+    for  (size_t idx = 0;  (idx < expected.examples.size ())  &&  (idx < actual.examples.size ());  ++idx)
+    {
+      const LoadedExample&  e = expected.examples[idx];
+      const LoadedExample&  a = actual.examples[idx];
+      bool  same = (e.className       == a.className)        &&
+                   (e.exampleFileName == a.exampleFileName)  &&
+                   (e.missingData     == a.missingData)      &&
+                   (e.features.size () == a.features.size ())  &&
+                   (memcmp (e.features.data (), a.features.data (), e.features.size () * sizeof (float)) == 0);
+      if  (!same)
+      {
+        if  (differences == 0)
+          firstDifference = "Example " + StrFromUint64 (idx) + "  class[" + a.className + "] expected[" + e.className + "]  name[" +
+                            a.exampleFileName + "] expected[" + e.exampleFileName + "]";
+        ++differences;
+      }
+    }
+    Assert (differences == 0, section, StrFromUint32 (differences) + " examples differ;  " + firstDifference);
+  }  /* CompareLoads */
+
+
+
+  void  FeatureFileIOTest::TestLineReader ()
+  {
+    const char*  pieces[] = {"a", "bc", " ", "\t", "\n", "\r", "0123456789abcdefghij"};
+
+    for  (kkuint32 seed = 1;  seed <= 20;  ++seed)
+    {
+      TestRandom  r (seed);
+      KKStr  text;
+      kkuint32  len = 1 + r.Next (6000);
+      while  (text.Len () < len)
+        text << r.Pick (pieces, 7);
+
+      vector<KKStr>  expected;
+      {
+        istringstream  in (text.Str ());
+        KKStr  ln;
+        bool   eof = false;
+        ReferenceGetLine (in, ln, eof);
+        while  (!eof)
+        {
+          expected.push_back (ln);
+          ReferenceGetLine (in, ln, eof);
+        }
+
+        // The old reader returned one more, empty, line when the stream ended with a two character terminator;
+        // every reader skips blank lines.
+        if  ((text.Len () >= 2)  &&  (text[text.Len () - 2] != text[text.Len () - 1])  &&
+             strchr ("\n\r", text[text.Len () - 1])  &&  strchr ("\n\r", text[text.Len () - 2])  &&
+             (!expected.empty ())  &&  expected.back ().Empty ())
+          expected.pop_back ();
+      }
+
+      KKStr  section = "LineReader seed: " + StrFromUint32 (seed);
+
+      // The smallest block is 1024 characters so these files cross several block boundaries.
+      {
+        istringstream  in (text.Str ());
+        TextLineReader  reader (in, 1024);
+        TextLineReader::Line  line;
+        vector<KKStr>  lines;
+        while  (reader.GetLine (line))
+        {
+          KKStr  s;
+          s.Append (line.str, line.len);
+          lines.push_back (s);
+        }
+        Assert (lines == expected, section, "GetLine: " + StrFromUint64 (lines.size ()) + " lines;  expected " + StrFromUint64 (expected.size ()));
+      }
+
+      {
+        istringstream  in (text.Str ());
+        TextLineReader  reader (in, 1024);
+        TextLineReader::LineList  block;
+        vector<KKStr>  lines;
+        while  (reader.GetBlockOfLines (block) > 0)
+        {
+          for  (auto&  line: block)
+          {
+          KKStr  s;
+          s.Append (line.str, line.len);
+          lines.push_back (s);
+        }
+        }
+        Assert (lines == expected, section, "GetBlockOfLines: " + StrFromUint64 (lines.size ()) + " lines;  expected " + StrFromUint64 (expected.size ()));
+      }
+    }
+  }  /* TestLineReader */
+
+
+
+  void  FeatureFileIOTest::TestSparseFile (const KKStr&  section,
+                                           const KKStr&  text,
+                                           const KKStr&  descText,
+                                           OptionUInt32  maxCount
+                                          )
+  {
+    RunLog  log;
+    FeatureFileIOPtr  driver = FeatureFileIOSparse::Driver ();
+    const KKStr  fileName = "SparseTest.data";
+
+    MLClassList  refClasses;
+    kkint32  featureNumMin = 0, featureNumMax = 0, refEstSize = 0;
+    {
+      istringstream  in (descText.Str ());
+      ReferenceSparseFileDesc (in, refClasses, featureNumMin, featureNumMax, refEstSize);
+    }
+
+    MLClassList  classes;
+    kkint32  estSize = 0;
+    KKStr    errorMessage;
+    istringstream  descIn (descText.Str ());
+    FileDescConstPtr  fileDesc = driver->GetFileDesc (fileName, descIn, &classes, estSize, errorMessage, log);
+
+    kkint32  expectedNumFields = (featureNumMax >= featureNumMin) ? (featureNumMax - featureNumMin + 1) : 0;
+    Assert (fileDesc->SparseMinFeatureNum () == featureNumMin, section, "SparseMinFeatureNum: " + StrFromInt32 (fileDesc->SparseMinFeatureNum ()) + "  expected: " + StrFromInt32 (featureNumMin));
+    Assert ((kkint32)fileDesc->NumOfFields () == expectedNumFields, section, "NumOfFields: " + StrFromUint32 (fileDesc->NumOfFields ()) + "  expected: " + StrFromInt32 (expectedNumFields));
+    Assert (estSize == refEstSize, section, "estSize: " + StrFromInt32 (estSize) + "  expected: " + StrFromInt32 (refEstSize));
+    Assert (classes.ToCommaDelimitedStr () == refClasses.ToCommaDelimitedStr (), section, "Classes[" + classes.ToCommaDelimitedStr () + "]  expected[" + refClasses.ToCommaDelimitedStr () + "]");
+
+    LoadResult  expected;
+    {
+      istringstream  in (text.Str ());
+      expected = ReferenceSparseLoad (in, fileName, fileDesc->SparseMinFeatureNum (), (kkint32)fileDesc->NumOfFields (), maxCount);
+    }
+
+    kkuint32  savedLoadThreads = FeatureFileIO::LoadThreads ();
+    kkuint32  threadCounts[] = {1, 3};
+    for  (kkuint32 numThreads: threadCounts)
+    {
+      FeatureFileIO::LoadThreads (numThreads);
+      istringstream  in (text.Str ());
+      bool   cancelFlag  = false;
+      bool   changesMade = false;
+      KKStr  loadError;
+      FeatureVectorListPtr  examples = driver->LoadFile (fileName, fileDesc, classes, in, maxCount, cancelFlag, changesMade, loadError, log);
+      CompareLoads (section + "  threads: " + StrFromUint32 (numThreads), expected, ToLoadResult (examples, loadError));
+      delete  examples;
+    }
+    FeatureFileIO::LoadThreads (savedLoadThreads);
+  }  /* TestSparseFile */
+
+
+
+  void  FeatureFileIOTest::TestSparse ()
+  {
+    const char*  classNames[] = {"alpha", "beta", "g", "//x"};
+    const char*  separators[] = {" ", "\t", "  ", " \t", "\t\t", "\t "};
+
+    for  (kkuint32 seed = 1;  seed <= 25;  ++seed)
+    {
+      TestRandom  r (seed);
+      KKStr  text;
+      kkuint32  numLines = 1 + r.Next (300);
+      for  (kkuint32 lineNum = 0;  lineNum < numLines;  ++lineNum)
+      {
+        kkuint32  kind = r.Next (20);
+        if  (kind == 0)
+          text << r.Pick (separators, 6);
+        else if  (kind == 1)
+          text << "// comment " << StrFromUint32 (r.Next (100));
+        else
+        {
+          if  (r.Next (10) == 0)
+            text << r.Pick (separators, 6);
+          text << r.Pick (classNames, 3);
+          kkuint32  numFields = r.Next (8);
+          for  (kkuint32 f = 0;  f < numFields;  ++f)
+          {
+            text << r.Pick (separators, 6);
+            KKStr  featureNum = StrFromInt32 ((kkint32)r.Next (14) - 1);
+            switch  (r.Next (12))
+            {
+            case 0:   text << ":" << featureNum << ":" << RandomNumber (r);                       break;
+            case 1:   text << featureNum;                                                          break;
+            case 2:   text << featureNum << "::" << RandomNumber (r);                              break;
+            case 3:   text << featureNum << ":" << RandomNumber (r) << ":" << RandomNumber (r);  break;
+            case 4:   text << featureNum << ":";                                                   break;
+            default:  text << featureNum << ":" << RandomNumber (r);                              break;
+            }
+          }
+          if  (r.Next (8) == 0)
+            text << r.Pick (separators, 6);
+        }
+
+        if  ((lineNum + 1 < numLines)  ||  (r.Next (2) == 0))
+          text << r.Pick (terminators, 4);
+      }
+
+      OptionUInt32  maxCount;
+      if  (seed % 5 == 0)
+        maxCount = r.Next (numLines + 1);
+
+      TestSparseFile ("Sparse seed: " + StrFromUint32 (seed), text, text, maxCount);
+    }
+
+    // Edge cases;  an empty field between two delimiters and a field that is only ":..." are feature number 0.
+    const char*  edgeCases[] = {
+      "a 1:1.5 2:2.5\n\tb 1:3\n",
+      "a 1:1 \t2:2\nb\t\t3:3\n",
+      "a :2:0.5 1::7 3:1:9\r\nb 2\r\n",
+      "// only a comment",
+      "a 1:1\n   \n\n\r\rb 2:2",
+      "a 5:1 3:2 5:9\n\rb 4:4\n\r",
+      "a\n",
+      "a -3:1 2:2\nb 1e1:4 0x10:5\n",
+    };
+    kkuint32  edgeNum = 0;
+    for  (auto  edgeCase: edgeCases)
+      TestSparseFile ("Sparse edge case: " + StrFromUint32 (edgeNum++), edgeCase, edgeCase, OptionUInt32 ());
+
+    // A feature number beyond what the FileDesc was built from.
+    TestSparseFile ("Sparse out of range", "a 1:1 2:2\nb 1:1 7:7\n", "a 1:1 3:3\n", OptionUInt32 ());
+  }  /* TestSparse */
+
+
+
+  void  FeatureFileIOTest::TestUCIFile (const KKStr&  section,
+                                        const KKStr&  text,
+                                        OptionUInt32  maxCount
+                                       )
+  {
+    RunLog  log;
+    FeatureFileIOPtr  driver = FeatureFileIOUCI::Driver ();
+    const KKStr  fileName = "UCITest.data";
+
+    MLClassList  refClasses;
+    kkint32  refNumOfFields = 0, refEstSize = 0;
+    {
+      istringstream  in (text.Str ());
+      ReferenceUCIFileDesc (in, refClasses, refNumOfFields, refEstSize);
+    }
+
+    MLClassList  classes;
+    kkint32  estSize = 0;
+    KKStr    errorMessage;
+    istringstream  descIn (text.Str ());
+    FileDescConstPtr  fileDesc = driver->GetFileDesc (fileName, descIn, &classes, estSize, errorMessage, log);
+
+    Assert ((kkint32)fileDesc->NumOfFields () == refNumOfFields, section, "NumOfFields: " + StrFromUint32 (fileDesc->NumOfFields ()) + "  expected: " + StrFromInt32 (refNumOfFields));
+    Assert (estSize == refEstSize, section, "estSize: " + StrFromInt32 (estSize) + "  expected: " + StrFromInt32 (refEstSize));
+    Assert (classes.ToCommaDelimitedStr () == refClasses.ToCommaDelimitedStr (), section, "Classes[" + classes.ToCommaDelimitedStr () + "]  expected[" + refClasses.ToCommaDelimitedStr () + "]");
+
+    LoadResult  expected;
+    {
+      istringstream  in (text.Str ());
+      expected = ReferenceUCILoad (in, fileName, (kkint32)fileDesc->NumOfFields (), maxCount);
+    }
+
+    kkuint32  savedLoadThreads = FeatureFileIO::LoadThreads ();
+    kkuint32  threadCounts[] = {1, 3};
+    for  (kkuint32 numThreads: threadCounts)
+    {
+      FeatureFileIO::LoadThreads (numThreads);
+      istringstream  in (text.Str ());
+      bool   cancelFlag  = false;
+      bool   changesMade = false;
+      KKStr  loadError;
+      FeatureVectorListPtr  examples = driver->LoadFile (fileName, fileDesc, classes, in, maxCount, cancelFlag, changesMade, loadError, log);
+      CompareLoads (section + "  threads: " + StrFromUint32 (numThreads), expected, ToLoadResult (examples, loadError));
+      delete  examples;
+    }
+    FeatureFileIO::LoadThreads (savedLoadThreads);
+  }  /* TestUCIFile */
+
+
+
+  void  FeatureFileIOTest::TestUCI ()
+  {
+    const char*  classNames[] = {"alpha", "beta", "g"};
+    const char*  separators[] = {",", ", ", " ", "\t", " , ", ",,"};
+    const char*  trailers[]   = {"", " ", ",", ",,", "\t", ", ,", " \t "};
+
+    for  (kkuint32 seed = 1;  seed <= 25;  ++seed)
+    {
+      TestRandom  r (seed);
+      KKStr  text;
+      kkuint32  numLines = 1 + r.Next (300);
+      for  (kkuint32 lineNum = 0;  lineNum < numLines;  ++lineNum)
+      {
+        kkuint32  kind = r.Next (20);
+        if  (kind == 0)
+          text << r.Pick (trailers, 7);
+        else if  (kind == 1)
+          text << ((r.Next (2) == 0) ? "// comment" : "  // indented comment");
+        else
+        {
+          if  (r.Next (10) == 0)
+            text << " \t";
+          kkuint32  numFields = 2 + r.Next (4);
+          for  (kkuint32 f = 0;  f < numFields;  ++f)
+            text << RandomNumber (r) << r.Pick (separators, 6);
+          text << r.Pick (classNames, 3) << r.Pick (trailers, 7);
+        }
+
+        if  ((lineNum + 1 < numLines)  ||  (r.Next (2) == 0))
+          text << r.Pick (terminators, 4);
+      }
+
+      OptionUInt32  maxCount;
+      if  (seed % 5 == 0)
+        maxCount = r.Next (numLines + 1);
+
+      TestUCIFile ("UCI seed: " + StrFromUint32 (seed), text, maxCount);
+    }
+
+    const char*  edgeCases[] = {
+      "1,2,a\n3,4,b,,\n",
+      "1,2,3,a\n4,b\n",
+      ",,,\n1,2,a\n",
+      "\v\n1,2,a\r\n",
+      "  1 2 a  \n\t3\t4\tb\t\n",
+      "1,2,a",
+    };
+    kkuint32  edgeNum = 0;
+    for  (auto  edgeCase: edgeCases)
+      TestUCIFile ("UCI edge case: " + StrFromUint32 (edgeNum++), edgeCase, OptionUInt32 ());
+  }  /* TestUCI */
+
+
+
+  void  FeatureFileIOTest::TestC45File (const KKStr&  section,
+                                        const KKStr&  text,
+                                        OptionUInt32  maxCount
+                                       )
+  {
+    RunLog  log;
+    FeatureFileIOPtr  driver = FeatureFileIOC45::Driver ();
+    const KKStr  fileName = "C45Test.data";
+
+    LoadResult  expected;
+    {
+      // A 'stringstream' so that putting back a different character works the way it does on a file.
+      stringstream  in (text.Str ());
+      expected = ReferenceC45Load (in, fileName, c45FileDesc, maxCount);
+    }
+
+    kkuint32  savedLoadThreads = FeatureFileIO::LoadThreads ();
+    kkuint32  threadCounts[] = {1, 3};
+    for  (kkuint32 numThreads: threadCounts)
+    {
+      FeatureFileIO::LoadThreads (numThreads);
+      istringstream  in (text.Str ());
+      bool   cancelFlag  = false;
+      bool   changesMade = false;
+      KKStr  loadError;
+      MLClassList  classes;
+      FeatureVectorListPtr  examples = driver->LoadFile (fileName, c45FileDesc, classes, in, maxCount, cancelFlag, changesMade, loadError, log);
+      CompareLoads (section + "  threads: " + StrFromUint32 (numThreads), expected, ToLoadResult (examples, loadError));
+      delete  examples;
+    }
+    FeatureFileIO::LoadThreads (savedLoadThreads);
+  }  /* TestC45File */
+
+
+
+  void  FeatureFileIOTest::TestC45 ()
+  {
+    RunLog  log;
+    {
+      const char*  names = "good, bad, ugly.   | the classes\n"
+                           "\n"
+                           "size:  continuous.\n"
+                           "color: red, green, blue.\n"
+                           "ExampleFileName: symbolic.\n"
+                           "weight: continuous.  skip: ignore.\n";
+      MLClassList  classes;
+      kkint32  estSize = 0;
+      KKStr    errorMessage;
+      istringstream  in (names);
+      c45FileDesc = FeatureFileIOC45::Driver ()->GetFileDesc ("C45Test.names", in, &classes, estSize, errorMessage, log);
+    }
+    Assert (c45FileDesc != NULL, "C45", "Names file was not read");
+    if  (!c45FileDesc)
+      return;
+
+    const char*  colors[]     = {"red", "green", "blue", "?"};
+    const char*  classNames[] = {"good", "bad", "ugly", "?", "good."};
+    const char*  separators[] = {",", ", ", " , ", ",  "};
+    const char*  trailers[]   = {"", ".", " .", " | comment", ". | comment", "  ", "\t"};
+    // The old reader took a carriage return for white space in the middle of a line so lines end in "\n" or "\r\n".
+    const char*  c45Terminators[] = {"\n", "\r\n"};
+
+    for  (kkuint32 seed = 1;  seed <= 25;  ++seed)
+    {
+      TestRandom  r (seed);
+      KKStr  text;
+      kkuint32  numLines = 1 + r.Next (300);
+      for  (kkuint32 lineNum = 0;  lineNum < numLines;  ++lineNum)
+      {
+        kkuint32  kind = r.Next (20);
+        if  (kind == 0)
+          text << ((r.Next (2) == 0) ? "" : "  ");
+        else if  (kind == 1)
+          text << "| a comment line";
+        else
+        {
+          text << ((r.Next (10) == 0) ? KKStr ("?") : RandomNumber (r)) << r.Pick (separators, 4);
+          text << r.Pick (colors, 4) << r.Pick (separators, 4);
+          switch  (r.Next (4))
+          {
+          case 0:   text << "?";                                           break;
+          case 1:   text << "img\\," << StrFromUint32 (r.Next (1000));     break;
+          default:  text << "img_" << StrFromUint32 (r.Next (1000));       break;
+          }
+          text << r.Pick (separators, 4) << RandomNumber (r) << r.Pick (separators, 4) << RandomNumber (r);
+          text << r.Pick (separators, 4) << r.Pick (classNames, 5) << r.Pick (trailers, 7);
+        }
+
+        if  ((lineNum + 1 < numLines)  ||  (r.Next (2) == 0))
+          text << r.Pick (c45Terminators, 2);
+      }
+
+      OptionUInt32  maxCount;
+      if  (seed % 5 == 0)
+        maxCount = r.Next (numLines + 1);
+
+      TestC45File ("C45 seed: " + StrFromUint32 (seed), text, maxCount);
+    }
+
+    const char*  edgeCases[] = {
+      "1,red,img_1,2,3,good\n1,purple,img_2,2,3,bad\n",
+      "1,red,img_1,2,3,good\n1,red,img_2\n",
+      "1,red,img_1,2,3,good\n1,red,img_2,2,3,\n",
+      "1,red,img_1,2,3,good\n1,red,img_2,2,3,awful\n",
+      "1.5.,red,x,2,3,good\n",
+      "1,red,img_1,2,3,good | comment\r\n\r\n  | comment\r\n2,blue,img_2,2,3,ugly.",
+      "1,red,img_1,2,3,good",
+    };
+    kkuint32  edgeNum = 0;
+    for  (auto  edgeCase: edgeCases)
+      TestC45File ("C45 edge case: " + StrFromUint32 (edgeNum++), edgeCase, OptionUInt32 ());
+  }  /* TestC45 */
+
+
+
+  bool  FeatureFileIOTest::RunTests ()
+  {
+    TestLineReader ();
+    TestSparse ();
+    TestUCI ();
+    TestC45 ();
+    return  FailedCount () == 0;
+  }
+}
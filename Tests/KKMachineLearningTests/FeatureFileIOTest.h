@@ -0,0 +1,87 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "KKBaseTypes.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks that the Sparse, UCI and C45 readers load exactly what they loaded when they read their
+   * stream one character at a time.
+   *@details  The old 'GetLine', 'GetToken' and 'C45ReadNextToken' and the loops that used them are transcribed
+   * here as the reference.  Random files and hand written edge cases, ex: empty fields between two tabs, leading
+   * ':', the four kinds of line terminator and a last line with no terminator, are loaded by both and every
+   * feature value, class, example name and error has to match, on 1 and several load threads.  'TextLineReader'
+   * has to split a stream into the same lines as the old 'GetLine' across block boundaries.
+   */
+  class FeatureFileIOTest : public KKTest
+  {
+  public:
+    FeatureFileIOTest ();
+
+    virtual ~FeatureFileIOTest ();
+
+    virtual const char*  TestName () const { return "FeatureFileIO"; }
+
+    bool  RunTests () override;
+
+    struct  LoadedExample
+    {
+      KKStr               className;
+      KKStr               exampleFileName;
+      std::vector<float>  features;
+      bool                missingData;
+    };
+
+    /** @brief  What one load produced;  'loaded' is false when the reader returned NULL. */
+    struct  LoadResult
+    {
+      LoadResult (): errorMessage (), examples (), loaded (false)  {}
+
+      KKStr                       errorMessage;
+      std::vector<LoadedExample>  examples;
+      bool                        loaded;
+    };
+
+  private:
+    void  CompareLoads (const KKStr&       section,
+                        const LoadResult&  expected,
+                        const LoadResult&  actual
+                       );
+
+    static  LoadResult  ToLoadResult (FeatureVectorListPtr  examples,
+                                      const KKStr&          errorMessage
+                                     );
+
+    void  TestC45 ();
+
+    void  TestC45File (const KKStr&   section,
+                       const KKStr&   text,
+                       OptionUInt32   maxCount
+                      );
+
+    void  TestLineReader ();
+
+    void  TestSparse ();
+
+    void  TestSparseFile (const KKStr&  section,
+                          const KKStr&  text,
+                          const KKStr&  descText,
+                          OptionUInt32  maxCount
+                         );
+
+    void  TestUCI ();
+
+    void  TestUCIFile (const KKStr&  section,
+                       const KKStr&  text,
+                       OptionUInt32  maxCount
+                      );
+
+    FileDescConstPtr  c45FileDesc;
+  };
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "KKBaseTypes.h"
+#include "Raster.h"
+
+namespace  KKMachineLearningTest
+{
+  /**
+   *@brief  Reports how many images per second 'GrayScaleImagesFVProducer' computes features for.
+   *@details  Run with "KKMachineLearningTests -Benchmark [numImages] [numThreads]";  not part of the tests.  The
+   * random images of 'GrayScaleImagesFVProducerTest' are timed through
+   *  -# the area, intensity and central moment step done by the separate passes 'ComputeFeatureVector' used to
+   *     make and by the fused 'Raster::CalcAreaIntensityAndCentralMoments' it makes now;
+   *  -# 'ComputeFeatureVector' one image at a time;
+   *  -# 'ComputeFeatureVectors' on 1 thread and on 'numThreads' threads.
+   *
+   * Each figure is the best of a few runs.
+   */
+  class GrayScaleFeaturesBenchmark
+  {
+  public:
+    /** @brief  Runs the benchmark writing the results to 'cout';  'numThreads' of zero means one per processor. */
+    static  void  Run (kkuint32  numImages,
+                       kkuint32  numThreads
+                      );
+
+  private:
+    /** @brief  Best of 'repetitions' runs of the area, intensity and moment step over 'images';  seconds. */
+    static  double  TimeMoments (const KKB::RasterList&  images,
+                                 bool                    fused,
+                                 kkuint32                repetitions
+                                );
+  };
+}
@@ -0,0 +1,227 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <string.h>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "Raster.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "FeatureVector.h"
+#include "GrayScaleImagesFVProducer.h"
+#include "MLClass.h"
+using namespace KKMLL;
+
+#include "GrayScaleImagesFVProducerTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+    private:
+      kkuint32  state;
+    };
+  }
+
+
+
+  GrayScaleImagesFVProducerTest::GrayScaleImagesFVProducerTest ():
+    mlClass (NULL)
+  {
+    mlClass = MLClass::CreateNewMLClass ("GrayScaleImagesFVProducer");
+  }
+
+
+
+  GrayScaleImagesFVProducerTest::~GrayScaleImagesFVProducerTest ()
+  {
+  }
+
+
+
+  RasterPtr  GrayScaleImagesFVProducerTest::RandomImage (kkint32   height,
+                                                         kkint32   width,
+                                                         kkuint32  seed
+                                                        )
+  {
+    TestRandom  r (seed);
+    RasterPtr  image = new Raster (height, width, false);
+    image->FileName ("Image_" + StrFromUint32 (seed) + ".bmp");
+
+    kkint32  numBlobs = 1 + (kkint32)(r.Next () % 5);
+    for  (kkint32 b = 0;  b < numBlobs;  ++b)
+    {
+      kkint32  centerRow = (kkint32)(r.Next () % (kkuint32)height);
+      kkint32  centerCol = (kkint32)(r.Next () % (kkuint32)width);
+      kkint32  radius    = 1 + (kkint32)(r.Next () % (kkuint32)Max (1, Min (height, width) / 3));
+      kkint32  hole      = (kkint32)(r.Next () % (kkuint32)(radius + 1)) / 2;
+      for  (kkint32 row = Max (0, centerRow - radius);  row < Min (height, centerRow + radius);  ++row)
+      {
+        for  (kkint32 col = Max (0, centerCol - radius);  col < Min (width, centerCol + radius);  ++col)
+        {
+          kkint32  dr = row - centerRow;
+          kkint32  dc = col - centerCol;
+          kkint32  d2 = dr * dr + dc * dc;
+          if  ((d2 <= (radius * radius))  &&  (d2 >= hole * hole))
+            image->SetPixelValue (row, col, (uchar)(1 + r.Next () % 255));
+        }
+      }
+    }
+    return  image;
+  }  /* RandomImage */
+
+
+
+  RasterListPtr  GrayScaleImagesFVProducerTest::RandomImages (kkuint32  count,
+                                                              kkuint32  seed
+                                                             )
+  {
+    TestRandom  r (seed);
+    RasterListPtr  images = new RasterList (true);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      kkint32  height = 20 + (kkint32)(r.Next () % 381);
+      kkint32  width  = 20 + (kkint32)(r.Next () % 381);
+      images->PushOnBack (RandomImage (height, width, seed * 1000 + x));
+    }
+    return  images;
+  }  /* RandomImages */
+
+
+
+  bool  GrayScaleImagesFVProducerTest::SameFeatures (const FeatureVector&  left,
+                                                     const FeatureVector&  right
+                                                    )
+  {
+    if  (left.NumOfFeatures () != right.NumOfFeatures ())
+      return  false;
+    return  memcmp (left.FeatureData (), right.FeatureData (), left.NumOfFeatures () * sizeof (float)) == 0;
+  }
+
+
+
+  void  GrayScaleImagesFVProducerTest::TestBatch (const RasterList&  images,
+                                                  kkuint32           numThreads
+                                                 )
+  {
+    KKStr  section = "Batch threads: " + StrFromUint32 (numThreads);
+
+    RunLog  log;
+    log.SetLoggingLevel (-1);
+
+    GrayScaleImagesFVProducerPtr  producer = GrayScaleImagesFVProducerFactory::Factory (&log)->ManufactureInstance (log);
+
+    // The single image path reuses the producer's own work rasters from one image to the next.
+    vector<FeatureVectorPtr>  singles;
+    for  (auto  image: images)
+    {
+      FeatureVectorPtr  fv = producer->ComputeFeatureVector (*image, mlClass, NULL, 1.0f, log);
+      if  (fv)
+        fv->ExampleFileName (image->FileName ());
+      singles.push_back (fv);
+    }
+
+    FeatureVectorListPtr  batch = producer->ComputeFeatureVectors (images, mlClass, numThreads, log);
+
+    kkuint32  batchIdx = 0;
+    kkuint32  mismatches = 0;
+    kkuint32  missing = 0;
+    for  (auto  single: singles)
+    {
+      if  (!single)
+        continue;
+
+      if  (batchIdx >= (kkuint32)batch->QueueSize ())
+      {
+        ++missing;
+        continue;
+      }
+
+      const FeatureVector&  fromBatch = (*batch)[batchIdx];
+      ++batchIdx;
+      if  ((fromBatch.ExampleFileName () != single->ExampleFileName ())  ||  (fromBatch.MLClass () != mlClass)  ||  !SameFeatures (fromBatch, *single))
+        ++mismatches;
+    }
+
+    Assert (missing == 0  &&  batchIdx == (kkuint32)batch->QueueSize (), section, "Batch and single image paths computed a different number of FeatureVectors");
+    Assert (mismatches == 0, section, StrFromUint32 (mismatches) + " FeatureVectors differ between the batch and single image paths");
+
+    for  (auto  single: singles)
+      delete  single;
+    delete  batch;     batch    = NULL;
+    delete  producer;  producer = NULL;
+  }  /* TestBatch */
+
+
+
+  void  GrayScaleImagesFVProducerTest::TestFusedMoments (const RasterList&  images)
+  {
+    kkuint32  mismatches = 0;
+    for  (auto  image: images)
+    {
+      kkint32   area1 = 0, area2 = 0;
+      float     weightedSize1 = 0.0f, weightedSize2 = 0.0f;
+      kkuint32  hist1[8], hist2[8];
+      kkint32   count1 = 0, count2 = 0;
+      float     weighted1 = 0.0f, weighted2 = 0.0f;
+      float     central1[9], central2[9];
+      float     centralWeighted1[9], centralWeighted2[9];
+
+      image->CalcAreaAndIntensityFeatures (area1, weightedSize1, hist1);
+      image->ComputeCentralMoments (count1, weighted1, central1, centralWeighted1);
+
+      image->CalcAreaIntensityAndCentralMoments (area2, weightedSize2, hist2, count2, weighted2, central2, centralWeighted2);
+
+      bool  same = (area1 == area2)  &&  (count1 == count2)
+               &&  (memcmp (&weightedSize1, &weightedSize2, sizeof (float)) == 0)
+               &&  (memcmp (&weighted1,     &weighted2,     sizeof (float)) == 0)
+               &&  (memcmp (hist1,            hist2,            sizeof (hist1))    == 0)
+               &&  (memcmp (central1,         central2,         sizeof (central1)) == 0)
+               &&  (memcmp (centralWeighted1, centralWeighted2, sizeof (centralWeighted1)) == 0);
+      if  (!same)
+        ++mismatches;
+    }
+    Assert (mismatches == 0, "FusedMoments", StrFromUint32 (mismatches) + " images where CalcAreaIntensityAndCentralMoments differs from the separate passes");
+  }  /* TestFusedMoments */
+
+
+
+  bool  GrayScaleImagesFVProducerTest::RunTests ()
+  {
+    RasterListPtr  images = RandomImages (24, 1);
+
+    // Over the 4,000,000 pixels 'GrayScaleImagesFVProducer' reduces images by before the morphology passes.
+    images->PushOnBack (RandomImage (2100, 2050, 2));
+    images->PushOnBack (RandomImage (3, 5, 3));
+
+    RasterPtr  blank = new Raster (40, 60, false);
+    blank->FileName ("Blank.bmp");
+    images->PushOnBack (blank);
+
+    TestFusedMoments (*images);
+    TestBatch (*images, 1);
+    TestBatch (*images, 3);
+
+    delete  images;
+    images = NULL;
+    return  FailedCount () == 0;
+  }
+}
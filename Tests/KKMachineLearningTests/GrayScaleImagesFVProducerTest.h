@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "Raster.h"
+#include "FeatureVector.h"
+#include "MLClass.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks that 'GrayScaleImagesFVProducer::ComputeFeatureVectors' returns exactly what 'ComputeFeatureVector'
+   *        does for each image.
+   *@details  Done for 1 and several threads on images of many sizes, including one large enough to be reduced
+   * before the morphology passes, a tiny one and a blank one.  'Raster::CalcAreaIntensityAndCentralMoments' is
+   * also compared with the separate 'CalcAreaAndIntensityFeatures' and 'ComputeCentralMoments' it replaced.
+   */
+  class GrayScaleImagesFVProducerTest : public KKTest
+  {
+  public:
+    GrayScaleImagesFVProducerTest ();
+
+    virtual ~GrayScaleImagesFVProducerTest ();
+
+    virtual const char*  TestName () const { return "GrayScaleImagesFVProducer"; }
+
+    bool  RunTests () override;
+
+    /** @brief  Gray-scale image with a few random blobs, some with holes, named "Image_<seed>.bmp". */
+    static  RasterPtr  RandomImage (kkint32   height,
+                                    kkint32   width,
+                                    kkuint32  seed
+                                   );
+
+    /** @brief  'count' random images of 20 to 400 pixels a side. */
+    static  RasterListPtr  RandomImages (kkuint32  count,
+                                         kkuint32  seed
+                                        );
+
+  private:
+    /** @brief  Bit for bit,  so that NaN's compare equal to themselves. */
+    static  bool  SameFeatures (const FeatureVector&  left,
+                                const FeatureVector&  right
+                               );
+
+    void  TestBatch (const RasterList&  images,
+                     kkuint32           numThreads
+                    );
+
+    void  TestFusedMoments (const RasterList&  images);
+
+    MLClassPtr  mlClass;
+  };
+}
@@ -0,0 +1,74 @@
+// KKMachineLearningTests.cpp : This file contains the 'main' function. Program execution begins and ends there.
+//
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKTest.h"
+using namespace KKBaseTest;
+
+#include "BatchPredictionTest.h"
+#include "BinaryCombosTest.h"
+#include "BinarySaveTest.h"
+#include "DuplicateImagesTest.h"
+#include "FeatureDataBlockTest.h"
+#include "FeatureFileIOTest.h"
+#include "GrayScaleFeaturesBenchmark.h"
+#include "GrayScaleImagesFVProducerTest.h"
+#include "KernelEngineTest.h"
+#include "ModelParamXmlTest.h"
+#include "PredictionBenchmark.h"
+#include "ReSinkTest.h"
+#include "SvmTrainingTest.h"
+#include "UsfCasCorTrainingTest.h"
+using namespace KKMachineLearningTest;
+
+  int main (int argc, char** argv)
+  {
+    // "-Benchmark [numImages] [numThreads]" times feature extraction instead of running the tests.
+    if  ((argc > 1)  &&  (KKStr (argv[1]).EqualIgnoreCase ("-Benchmark")))
+    {
+      kkuint32  numImages  = (argc > 2) ? KKStr (argv[2]).ToUint32 () : 200;
+      kkuint32  numThreads = (argc > 3) ? KKStr (argv[3]).ToUint32 () : 0;
+      GrayScaleFeaturesBenchmark::Run (numImages, numThreads);
+      return 0;
+    }
+
+    // "-PredictionBenchmark [numExamples] [numThreads]" times SVM predictions instead of running the tests.
+    if  ((argc > 1)  &&  (KKStr (argv[1]).EqualIgnoreCase ("-PredictionBenchmark")))
+    {
+      kkuint32  numExamples = (argc > 2) ? KKStr (argv[2]).ToUint32 () : 2000;
+      kkuint32  numThreads  = (argc > 3) ? KKStr (argv[3]).ToUint32 () : 0;
+      PredictionBenchmark::Run (numExamples, numThreads);
+      return 0;
+    }
+
+    KKQueue<KKTest> tests;
+    tests.PushOnBack (new BatchPredictionTest ());
+    tests.PushOnBack (new BinaryCombosTest ());
+    tests.PushOnBack (new BinarySaveTest ());
+    tests.PushOnBack (new DuplicateImagesTest ());
+    tests.PushOnBack (new FeatureDataBlockTest ());
+    tests.PushOnBack (new FeatureFileIOTest ());
+    tests.PushOnBack (new GrayScaleImagesFVProducerTest ());
+    tests.PushOnBack (new KernelEngineTest ());
+    tests.PushOnBack (new ModelParamXmlTest ());
+    tests.PushOnBack (new ReSinkTest ());
+    tests.PushOnBack (new SvmTrainingTest ());
+    tests.PushOnBack (new UsfCasCorTrainingTest ());
+
+    kkuint32 failedCount = 0;
+
+    for (auto test: tests)
+    {
+      test->RunTests ();
+      failedCount += test->FailedCount ();
+    }
+
+    return failedCount;
+  }
@@ -0,0 +1,378 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+using namespace KKB;
+
+#include "FeatureNumList.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "KernelEngine.h"
+#include "svm.h"
+#include "svm2.h"
+using namespace KKMLL;
+
+#include "KernelEngineTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+      /** @brief  Uniform in [-scale, scale). */
+      double  Symmetric (double  scale)  {return  (NextDouble () * 2.0 - 1.0) * scale;}
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const  kkuint32  numFeatures = 37;
+
+    /** @brief  Tolerance KernelEngine.h documents for a sum whose terms have absolute values adding up to 'sumAbs'. */
+    double  SumTolerance (double  sumAbs)
+    {
+      return  1.0e-12 * sumAbs + 1.0e-300;
+    }
+
+    /** @brief  For kernel values after the RBF, Polynomial or Sigmoid transform. */
+    bool  CloseKernel (double  computed,
+                       double  reference
+                      )
+    {
+      return  fabs (computed - reference) <= 1.0e-10 * Max (1.0, fabs (reference));
+    }
+  }
+
+
+
+  KernelEngineTest::KernelEngineTest ():
+    fileDesc (NULL)
+  {
+    VectorKKStr  fieldNames;
+    for  (kkuint32 x = 0;  x < numFeatures;  ++x)
+      fieldNames.push_back ("Field_" + StrFromUint32 (x));
+    fileDesc = FileDesc::NewContinuousDataOnly (fieldNames);
+  }
+
+
+
+  KernelEngineTest::~KernelEngineTest ()
+  {
+  }
+
+
+
+  FeatureVectorListPtr  KernelEngineTest::RandomExamples (kkuint32  count,
+                                                          double    scale,
+                                                          kkuint32  seed
+                                                         )
+  {
+    TestRandom  r (seed);
+    FeatureVectorListPtr  examples = new FeatureVectorList (fileDesc, true);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      FeatureVectorPtr  fv = new FeatureVector (numFeatures);
+      float*  featureData = fv->FeatureDataAlter ();
+      for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+        featureData[f] = (float)r.Symmetric (scale);
+      examples->PushOnBack (fv);
+    }
+    return  examples;
+  }
+
+
+
+  FeatureNumList  KernelEngineTest::SomeFeatures ()  const
+  {
+    FeatureNumList  features;
+    for  (kkuint32 f = 0;  f < numFeatures;  f += 2)
+      features.AddFeature ((FeatureNumList::IntType)f);
+    features.AddFeature ((FeatureNumList::IntType)(numFeatures - 1));
+    return  features;
+  }
+
+
+
+  void  KernelEngineTest::TestFloat (const KKStr&  isName)
+  {
+    FeatureVectorListPtr  examples = RandomExamples (23, 10.0, 11);
+    FeatureNumList  features = SomeFeatures ();
+    PackedFeatureVectors  packed (*examples, features);
+
+    kkint32  numRows = packed.NumRows ();
+    vector<double>  dots (numRows);
+    vector<double>  dists (numRows);
+
+    kkint32  dotFailures = 0, distFailures = 0, oneToManyFailures = 0;
+
+    for  (kkint32 i = 0;  i < numRows;  ++i)
+    {
+      KernelEngine::DotOneToMany             (packed.Row (i), packed, NULL, numRows, dots.data ());
+      KernelEngine::SquaredDistanceOneToMany (packed.Row (i), packed, NULL, numRows, dists.data ());
+
+      const float*  fvX = examples->IdxToPtr (i)->FeatureData ();
+      for  (kkint32 j = 0;  j < numRows;  ++j)
+      {
+        const float*  fvY = examples->IdxToPtr (j)->FeatureData ();
+
+        // The loops KernelEngine replaced;  products and differences are formed in float.
+        double  refDot = 0.0, sumAbs = 0.0, refDist = 0.0;
+        for  (kkint32 idx = 0;  idx < (kkint32)features.NumSelFeatures ();  ++idx)
+        {
+          kkint32  fn = features[idx];
+          refDot += fvX[fn] * fvY[fn];
+          sumAbs += fabs (fvX[fn] * fvY[fn]);
+          double  d = fvX[fn] - fvY[fn];
+          refDist += d * d;
+        }
+
+        double  dot  = KernelEngine::Dot             (packed.Row (i), packed.Row (j), packed.Stride ());
+        double  dist = KernelEngine::SquaredDistance (packed.Row (i), packed.Row (j), packed.Stride ());
+
+        if  (fabs (dot - refDot) > SumTolerance (sumAbs))       ++dotFailures;
+        if  (fabs (dist - refDist) > SumTolerance (refDist))    ++distFailures;
+        if  ((dots[j] != dot)  ||  (dists[j] != dist))          ++oneToManyFailures;
+      }
+
+      if  (fabs (packed.SquaredNorm (i) - dots[i]) > SumTolerance (dots[i]))
+        ++dotFailures;
+    }
+
+    Assert (dotFailures == 0,       "Float Dot " + isName,             "Failures: " + StrFromInt32 (dotFailures));
+    Assert (distFailures == 0,      "Float SquaredDistance " + isName, "Failures: " + StrFromInt32 (distFailures));
+    Assert (oneToManyFailures == 0, "Float OneToMany " + isName,       "Failures: " + StrFromInt32 (oneToManyFailures));
+
+    delete  examples;
+  }  /* TestFloat */
+
+
+
+  void  KernelEngineTest::TestDouble (const KKStr&  isName)
+  {
+    TestRandom  r (12);
+
+    // Column counts that leave every amount of padding.
+    kkint32  numColsList[] = {1, 2, 3, 4, 5, 38};
+    kkint32  dotFailures = 0, distFailures = 0, oneToManyFailures = 0;
+
+    for  (kkint32 numCols: numColsList)
+    {
+      kkint32  numRows = 9;
+      PackedDoubleVectors  packed (numRows, numCols);
+      vector<vector<double>>  values (numRows, vector<double> (numCols));
+      for  (kkint32 row = 0;  row < numRows;  ++row)
+      {
+        for  (kkint32 col = 0;  col < numCols;  ++col)
+          values[row][col] = r.Symmetric (100.0);
+        packed.PackRow (row, values[row].data ());
+      }
+
+      vector<double>  dots (numRows);
+      vector<double>  dists (numRows);
+      kkint32  rowIdxs[] = {8, 0, 3, 3, 7};
+
+      for  (kkint32 i = 0;  i < numRows;  ++i)
+      {
+        KernelEngine::DotOneToMany             (packed.Row (i), packed, rowIdxs, 5, dots.data ());
+        KernelEngine::SquaredDistanceOneToMany (packed.Row (i), packed, rowIdxs, 5, dists.data ());
+        for  (kkint32 k = 0;  k < 5;  ++k)
+        {
+          if  ((dots[k]  != KernelEngine::Dot             (packed.Row (i), packed.Row (rowIdxs[k]), packed.Stride ()))  ||
+               (dists[k] != KernelEngine::SquaredDistance (packed.Row (i), packed.Row (rowIdxs[k]), packed.Stride ()))
+              )
+            ++oneToManyFailures;
+        }
+
+        for  (kkint32 j = 0;  j < numRows;  ++j)
+        {
+          double  refDot = 0.0, sumAbs = 0.0, refDist = 0.0;
+          for  (kkint32 col = 0;  col < numCols;  ++col)
+          {
+            refDot += values[i][col] * values[j][col];
+            sumAbs += fabs (values[i][col] * values[j][col]);
+            double  d = values[i][col] - values[j][col];
+            refDist += d * d;
+          }
+
+          double  dot  = KernelEngine::Dot             (packed.Row (i), packed.Row (j), packed.Stride ());
+          double  dist = KernelEngine::SquaredDistance (packed.Row (i), packed.Row (j), packed.Stride ());
+          if  (fabs (dot - refDot) > SumTolerance (sumAbs))     ++dotFailures;
+          if  (fabs (dist - refDist) > SumTolerance (refDist))  ++distFailures;
+        }
+      }
+    }
+
+    Assert (dotFailures == 0,       "Double Dot " + isName,             "Failures: " + StrFromInt32 (dotFailures));
+    Assert (distFailures == 0,      "Double SquaredDistance " + isName, "Failures: " + StrFromInt32 (distFailures));
+    Assert (oneToManyFailures == 0, "Double OneToMany " + isName,       "Failures: " + StrFromInt32 (oneToManyFailures));
+  }  /* TestDouble */
+
+
+
+  void  KernelEngineTest::TestSvm233 (const KKStr&  isName)
+  {
+    TestRandom  r (13);
+
+    // Sparse vectors as 'FeatureEncoder' builds them;  indexes start at 1 and zeros are left out.
+    kkint32  numSVs = 17;
+    vector<vector<SVM233::svm_node>>  nodes (numSVs + 1);
+    for  (kkint32 x = 0;  x <= numSVs;  ++x)
+    {
+      // The last one is the query;  it has features past the highest index of any support vector.
+      kkint32  maxIndex = (x < numSVs) ? 30 : 34;
+      for  (kkint32 index = 1;  index <= maxIndex;  ++index)
+      {
+        if  (r.NextDouble () < 0.3)
+          continue;
+        SVM233::svm_node  n;
+        n.index = (kkint16)index;
+        n.value = r.Symmetric (2.0);
+        nodes[x].push_back (n);
+      }
+      nodes[x].push_back (SVM233::svm_node ());
+    }
+
+    vector<const SVM233::svm_node*>  svs;
+    for  (kkint32 x = 0;  x < numSVs;  ++x)
+      svs.push_back (nodes[x].data ());
+    const SVM233::svm_node*  query = nodes[numSVs].data ();
+
+    PackedDoubleVectorsPtr  packed = SVM233::svm_PackNodes (svs.data (), numSVs);
+
+    kkint32  kernelTypes[] = {SVM233::LINEAR, SVM233::POLY, SVM233::RBF, SVM233::SIGMOID};
+    const char*  kernelNames[] = {"linear", "polynomial", "rbf", "sigmoid"};
+    for  (kkint32 kernelType: kernelTypes)
+    {
+      SVM233::svm_parameter  param;
+      param.kernel_type = kernelType;
+      param.gamma  = 0.05;
+      param.coef0  = 0.5;
+      param.degree = 3;
+
+      vector<double>  kvalues (numSVs);
+      SVM233::svm_kernelValues (param, query, *packed, kvalues.data ());
+
+      vector<double>  unpacked (numSVs);
+      SVM233::svm_kernelValues (param, query, svs.data (), numSVs, unpacked.data ());
+
+      kkint32  failures = 0;
+      for  (kkint32 i = 0;  i < numSVs;  ++i)
+      {
+        double  reference = SVM233::svm_kernelValue (param, query, svs[i]);
+        if  (!CloseKernel (kvalues[i], reference)  ||  (unpacked[i] != kvalues[i]))
+          ++failures;
+      }
+
+      Assert (failures == 0, KKStr ("SVM233 kernel ") + kernelNames[kernelType] + " " + isName, "Failures: " + StrFromInt32 (failures));
+
+      // Every node vector as a query;  the block version has to give exactly what the single query version does.
+      vector<const SVM233::svm_node*>  queries (svs);
+      queries.push_back (query);
+      kkint32  numQueries = (kkint32)queries.size ();
+      vector<double>  blockValues ((kkMemSize)numQueries * numSVs);
+      SVM233::svm_kernelValuesBlock (param, queries.data (), numQueries, *packed, blockValues.data ());
+
+      kkint32  blockFailures = 0;
+      for  (kkint32 q = 0;  q < numQueries;  ++q)
+      {
+        SVM233::svm_kernelValues (param, queries[q], *packed, kvalues.data ());
+        for  (kkint32 i = 0;  i < numSVs;  ++i)
+        {
+          if  (blockValues[(kkMemSize)q * numSVs + i] != kvalues[i])
+            ++blockFailures;
+        }
+      }
+
+      Assert (blockFailures == 0, KKStr ("SVM233 kernel block ") + kernelNames[kernelType] + " " + isName, "Failures: " + StrFromInt32 (blockFailures));
+    }
+
+    delete  packed;
+  }  /* TestSvm233 */
+
+
+
+  void  KernelEngineTest::TestSvm289 (const KKStr&  isName)
+  {
+    FeatureVectorListPtr  examples = RandomExamples (20, 2.0, 14);
+    FeatureNumList  features = SomeFeatures ();
+
+    SVM289_MFS::Kernel_Type  kernelTypes[] = {SVM289_MFS::Kernel_Type::LINEAR, SVM289_MFS::Kernel_Type::POLY,
+                                              SVM289_MFS::Kernel_Type::RBF,    SVM289_MFS::Kernel_Type::SIGMOID
+                                             };
+    for  (auto kernelType: kernelTypes)
+    {
+      SVM289_MFS::svm_parameter  param;
+      param.kernel_type = kernelType;
+      param.gamma  = 0.05;
+      param.coef0  = 0.5;
+      param.degree = 3;
+
+      SVM289_MFS::Svm_Model  model (param, features, fileDesc);
+      for  (kkuint32 x = 1;  x < examples->QueueSize ();  ++x)
+        model.SV.PushOnBack (examples->IdxToPtr (x));
+      model.numSVs = model.SV.QueueSize ();
+
+      const FeatureVector&  query = *(examples->IdxToPtr (0));
+      vector<double>  kvalues (model.numSVs);
+      SVM289_MFS::svm_kernel_values (&model, query, kvalues.data ());
+
+      kkint32  failures = 0;
+      for  (kkuint32 i = 0;  i < model.numSVs;  ++i)
+      {
+        double  reference = SVM289_MFS::svm_kernel_value (query, *(model.SV.IdxToPtr (i)), param, features);
+        if  (!CloseKernel (kvalues[i], reference))
+          ++failures;
+      }
+
+      Assert (failures == 0, "SVM289_MFS kernel " + SVM289_MFS::Kernel_Type_ToStr (kernelType) + " " + isName, "Failures: " + StrFromInt32 (failures));
+    }
+
+    delete  examples;
+  }  /* TestSvm289 */
+
+
+
+  bool  KernelEngineTest::RunTests ()
+  {
+    KernelEngine::InstructionSet  original = KernelEngine::ActiveInstructionSet ();
+
+    KernelEngine::InstructionSet  instructionSets[] = {KernelEngine::InstructionSet::Scalar,
+                                                       KernelEngine::InstructionSet::SSE2,
+                                                       KernelEngine::InstructionSet::AVX2
+                                                      };
+    for  (auto is: instructionSets)
+    {
+      // When the processor does not support 'is' the best one it does is tested again.
+      KernelEngine::ForceInstructionSet (is);
+      KKStr  isName = KernelEngine::InstructionSetToStr (KernelEngine::ActiveInstructionSet ());
+      TestFloat  (isName);
+      TestDouble (isName);
+      TestSvm233 (isName);
+      TestSvm289 (isName);
+    }
+
+    KernelEngine::ForceInstructionSet (original);
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "FeatureNumList.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "KernelEngine.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks 'KernelEngine' and the SVM kernels built on it against the scalar loops they replaced.
+   *@details  Every instruction set the processor supports is forced in turn.  Dot products and squared distances
+   * have to agree with a scalar loop to within  1.0e-12 * sum(|x_i * y_i|), the tolerance documented in
+   * KernelEngine.h, and the one-to-many versions have to return exactly what the one-to-one versions do.  The
+   * kernel values that SVM233 and SVM289_MFS predict with are compared with their 'k_function' the same way.
+   */
+  class KernelEngineTest : public KKTest
+  {
+  public:
+    KernelEngineTest ();
+
+    virtual ~KernelEngineTest ();
+
+    virtual const char*  TestName () const { return "KernelEngine"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  'count' examples of uniform random features in [-scale, scale). */
+    FeatureVectorListPtr  RandomExamples (kkuint32  count,
+                                          double    scale,
+                                          kkuint32  seed
+                                         );
+
+    /** @brief  Every other feature plus the last one;  so that packing has to skip some. */
+    FeatureNumList  SomeFeatures ()  const;
+
+    void  TestDouble (const KKStr&  isName);
+
+    void  TestFloat (const KKStr&  isName);
+
+    void  TestSvm233 (const KKStr&  isName);
+
+    void  TestSvm289 (const KKStr&  isName);
+
+    FileDescConstPtr  fileDesc;
+  };
+}
@@ -0,0 +1,102 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <sstream>
+#include <typeinfo>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKException.h"
+#include "KKStr.h"
+#include "RunLog.h"
+#include "TokenBuffer.h"
+#include "XmlStream.h"
+using namespace KKB;
+
+#include "ModelParam.h"
+#include "ModelParamOldSVM.h"
+#include "ModelParamSvmBase.h"
+using namespace KKMLL;
+
+#include "ModelParamXmlTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  ModelParamXmlTest::ModelParamXmlTest ()
+  {
+  }
+
+
+
+  ModelParamXmlTest::~ModelParamXmlTest ()
+  {
+  }
+
+
+
+  template<class  XmlElementT>
+  void  ModelParamXmlTest::TestRoundTrip (const KKStr&   testName,
+                                          ModelParamPtr  param,
+                                          const KKStr&   cmdLine,
+                                          RunLog&        log
+                                         )
+  {
+    bool  validFormat = false;
+    param->ParseCmdLine (cmdLine, validFormat, log);
+    Assert (validFormat, testName, "Parameters not valid: " + cmdLine);
+
+    ostringstream  o;
+    param->WriteXML ("Param", o);
+
+    istringstream  xmlText (o.str ());
+    TokenBufferStream  tokenBuffer (&xmlText);
+    XmlStreamPtr  stream = new XmlStream (new XmlTokenizer (&tokenBuffer));
+
+    bool  cancelFlag = false;
+    XmlTokenPtr  t = NULL;
+    KKStr  errMsg;
+    try
+    {
+      t = stream->GetNextToken (cancelFlag, log);
+    }
+    catch  (const KKException&  e)
+    {
+      errMsg = e.ToString ();
+    }
+    Assert (errMsg.Empty (), testName, "Reading the XML back threw: " + errMsg);
+
+    XmlElementT*  e = dynamic_cast<XmlElementT*> (t);
+    Assert (e != NULL, testName, "Read back as " + KKStr (t ? typeid (*t).name () : "nothing") + "\n" + o.str ());
+
+    if  (e)
+    {
+      ModelParamPtr  reread = e->TakeOwnership ();
+      Assert (reread != NULL  &&  reread->ToCmdLineStr () == param->ToCmdLineStr (), testName,
+              "Expected[" + param->ToCmdLineStr () + "]  Found[" + (reread ? reread->ToCmdLineStr () : KKStr ("NULL")) + "]"
+             );
+      delete  reread;
+      reread = NULL;
+    }
+
+    delete  t;       t      = NULL;
+    delete  stream;  stream = NULL;
+    delete  param;   param  = NULL;
+  }  /* TestRoundTrip */
+
+
+
+  bool  ModelParamXmlTest::RunTests ()
+  {
+    RunLog  log;
+    log.SetLoggingLevel (-1);
+
+    TestRoundTrip<XmlElementModelParamOldSVM> ("OldSVM", new ModelParamOldSVM (),
+                                               "-m 200 -s 0 -n 0.11 -t 2 -g 0.05  -c 10  -u 100  -up  -mt OneVsOne  -sm P", log);
+
+    TestRoundTrip<XmlElementModelParamSvmBase> ("SvmBase", new ModelParamSvmBase (), "-s 0 -t 2 -g 0.05 -c 10 -b 1", log);
+
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "KKTest.h"
+#include "ModelParam.h"
+#include "RunLog.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks that model parameters written with 'WriteXML' read back as the same class with the same settings.
+   *@details  'ModelParamSvmBase' used to be written under the 'ModelParamOldSVM' tag so it read back as the wrong
+   * class;  'ModelParamOldSVM' could not be read back on LP64 because 'StrFromInt32' wrote its dimSelect of -1 as
+   * 4294967295.
+   */
+  class ModelParamXmlTest : public KKTest
+  {
+  public:
+    ModelParamXmlTest ();
+
+    virtual ~ModelParamXmlTest ();
+
+    virtual const char*  TestName () const { return "ModelParamXml"; }
+
+    bool  RunTests () override;
+
+  private:
+    /**
+     *@brief  Parses 'cmdLine' into 'param', writes it as XML, reads it back and compares the two.
+     *@param[in]  param  Takes ownership.
+     */
+    template<class  XmlElementT>
+    void  TestRoundTrip (const KKStr&   testName,
+                         ModelParamPtr  param,
+                         const KKStr&   cmdLine,
+                         RunLog&        log
+                        );
+  };
+}
@@ -0,0 +1,190 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "KKThreadPool.h"
+#include "OSservices.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "Classifier2.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "TrainingConfiguration2.h"
+#include "TrainingProcess2.h"
+using namespace KKMLL;
+
+#include "PredictionBenchmark.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+      /** @brief  Uniform in [-scale, scale). */
+      double  Symmetric (double  scale)  {return  (NextDouble () * 2.0 - 1.0) * scale;}
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const  kkuint32  numFeatures = 60;
+
+    const  kkuint32  numClasses = 5;
+
+    const  kkuint32  numTrainExamples = 1000;
+  }
+
+
+
+  FeatureVectorListPtr  PredictionBenchmark::RandomExamples (FileDescConstPtr  fileDesc,
+                                                             MLClassList&      mlClasses,
+                                                             kkuint32          count,
+                                                             kkuint32          seed
+                                                            )
+  {
+    TestRandom  r (seed);
+    FeatureVectorListPtr  examples = new FeatureVectorList (fileDesc, true);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      kkuint32  classIdx = x % numClasses;
+      FeatureVectorPtr  fv = new FeatureVector (numFeatures);
+      float*  featureData = fv->FeatureDataAlter ();
+      // The clouds overlap so that a good share of the training examples end up as support vectors.
+      for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+        featureData[f] = (float)(((f % numClasses) == classIdx ? 1.0 : 0.0) + r.Symmetric (2.0));
+      fv->MLClass (mlClasses.IdxToPtr (classIdx));
+      fv->ExampleFileName ("Example_" + StrFromUint32 (seed) + "_" + StrFromUint32 (x) + ".bmp");
+      examples->PushOnBack (fv);
+    }
+    return  examples;
+  }  /* RandomExamples */
+
+
+
+  void  PredictionBenchmark::TimeModel (const KKStr&        name,
+                                        const KKStr&        cmdLine,
+                                        FileDescConstPtr    fileDesc,
+                                        MLClassList&        mlClasses,
+                                        FeatureVectorList&  examples,
+                                        kkuint32            numThreads,
+                                        RunLog&             log
+                                       )
+  {
+    bool  cancelFlag = false;
+    FeatureVectorListPtr  trainingExamples = RandomExamples (fileDesc, mlClasses, numTrainExamples, 1);
+    TrainingConfiguration2Ptr  config = TrainingConfiguration2::CreateFromFeatureVectorList (*trainingExamples, fileDesc, cmdLine, log);
+    TrainingProcess2Ptr  trainer = TrainingProcess2::CreateTrainingProcessFromTrainingExamples
+                                       (config, trainingExamples, true, false, cancelFlag, log);
+    if  ((trainer == NULL)  ||  trainer->Abort ())
+    {
+      cout << name << "   Training failed." << endl << endl;
+      delete  trainer;
+      delete  config;
+      return;
+    }
+
+    Classifier2Ptr  classifier = new Classifier2 (trainer, log);
+
+    kkuint32  numExamples = examples.QueueSize ();
+    vector<kkint32>  votes ((kkMemSize)numExamples * numClasses);
+    vector<double>   probabilities ((kkMemSize)numExamples * numClasses);
+
+    vector<kkuint32>  threadCounts;
+    threadCounts.push_back (1);
+    if  (numThreads > 1)
+      threadCounts.push_back (numThreads);
+
+    // The repetitions of the single example loop and of each batch size are interleaved so that whatever else the
+    // machine is doing slows them down alike;  the best time of each is reported.
+    const  kkuint32  repetitions = 3;
+    double          single = 0.0;
+    vector<double>  batch (threadCounts.size (), 0.0);
+    for  (kkuint32 rep = 0;  rep < repetitions;  ++rep)
+    {
+      double  startTime = osGetElapsedSecs ();
+      for  (kkuint32 x = 0;  x < numExamples;  ++x)
+        classifier->ProbabilitiesByClass (mlClasses, examples.IdxToPtr (x), votes.data () + (kkMemSize)x * numClasses, probabilities.data () + (kkMemSize)x * numClasses);
+      double  elapsed = osGetElapsedSecs () - startTime;
+      if  ((rep == 0)  ||  (elapsed < single))
+        single = elapsed;
+
+      for  (size_t t = 0;  t < threadCounts.size ();  ++t)
+      {
+        startTime = osGetElapsedSecs ();
+        classifier->ProbabilitiesByClass (mlClasses, examples, votes.data (), probabilities.data (), threadCounts[t]);
+        elapsed = osGetElapsedSecs () - startTime;
+        if  ((rep == 0)  ||  (elapsed < batch[t]))
+          batch[t] = elapsed;
+      }
+    }
+
+    cout << name << "   Support vectors: " << trainer->NumOfSupportVectors () << endl
+         << "  one example at a time:               " << setw (10) << (double)numExamples / single << " examples/sec" << endl;
+    for  (size_t t = 0;  t < threadCounts.size ();  ++t)
+      cout << "  blocks of examples     threads: " << setw (3) << threadCounts[t] << "  " << setw (10) << (double)numExamples / batch[t] << " examples/sec" << endl;
+    cout << endl;
+
+    delete  classifier;  classifier = NULL;
+    delete  trainer;     trainer    = NULL;
+    delete  config;      config     = NULL;
+  }  /* TimeModel */
+
+
+
+  void  PredictionBenchmark::Run (kkuint32  numExamples,
+                                  kkuint32  numThreads
+                                 )
+  {
+    numThreads = KKThreadPool::ResolveNumThreads (numThreads);
+
+    RunLog  log;
+    log.SetLoggingLevel (-1);
+
+    VectorKKStr  fieldNames;
+    for  (kkuint32 x = 0;  x < numFeatures;  ++x)
+      fieldNames.push_back ("Field_" + StrFromUint32 (x));
+    FileDescConstPtr  fileDesc = FileDesc::NewContinuousDataOnly (fieldNames);
+
+    MLClassList  mlClasses;
+    for  (kkuint32 x = 0;  x < numClasses;  ++x)
+      mlClasses.PushOnBack (MLClass::CreateNewMLClass ("PredictionBenchmark_" + StrFromUint32 (x)));
+
+    FeatureVectorListPtr  examples = RandomExamples (fileDesc, mlClasses, numExamples, 2);
+
+    cout << endl
+         << "Classifier2::ProbabilitiesByClass benchmark   Examples: " << numExamples << "  Features: " << numFeatures
+         << "  Classes: " << numClasses << "  Training examples: " << numTrainExamples << endl
+         << endl;
+
+    cout << fixed << setprecision (1);
+
+    TimeModel ("OldSVM OneVsOne",     "-m 200 -s 0 -n 0.11 -t 2 -g 0.02  -c 10  -u 100  -up  -mt OneVsOne  -sm P", fileDesc, mlClasses, *examples, numThreads, log);
+    TimeModel ("OldSVM BinaryCombos", "-m 200 -s 0 -n 0.11 -t 2 -g 0.02  -c 10  -u 100  -up  -mt Binary  -sm P",   fileDesc, mlClasses, *examples, numThreads, log);
+
+    delete  examples;
+    examples = NULL;
+  }  /* Run */
+}
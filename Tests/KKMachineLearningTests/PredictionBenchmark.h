@@ -0,0 +1,46 @@
+#pragma once
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "RunLog.h"
+
+namespace  KKMachineLearningTest
+{
+  /**
+   *@brief  Reports how many examples per second 'Classifier2' predicts probabilities for.
+   *@details  Run with "KKMachineLearningTests -PredictionBenchmark [numExamples] [numThreads]";  not part of the tests.
+   * OldSVM models with OneVsOne and BinaryCombos machines are trained on random examples and timed through
+   *  -# 'ProbabilitiesByClass' one example at a time, which evaluates the kernel one example at a time;
+   *  -# the batch 'ProbabilitiesByClass', which evaluates it for a block of examples at once, on 1 thread and on
+   *     'numThreads' threads.
+   *
+   * Each figure is the best of a few runs.
+   */
+  class PredictionBenchmark
+  {
+  public:
+    /** @brief  Runs the benchmark writing the results to 'cout';  'numThreads' of zero means one per processor. */
+    static  void  Run (kkuint32  numExamples,
+                       kkuint32  numThreads
+                      );
+
+  private:
+    static  KKMLL::FeatureVectorListPtr  RandomExamples (KKMLL::FileDescConstPtr  fileDesc,
+                                                         KKMLL::MLClassList&      mlClasses,
+                                                         kkuint32                 count,
+                                                         kkuint32                 seed
+                                                        );
+
+    /** @brief  Trains a model with 'cmdLine' and times its predictions on 'examples'. */
+    static  void  TimeModel (const KKStr&                name,
+                             const KKStr&                cmdLine,
+                             KKMLL::FileDescConstPtr     fileDesc,
+                             KKMLL::MLClassList&         mlClasses,
+                             KKMLL::FeatureVectorList&   examples,
+                             kkuint32                    numThreads,
+                             KKB::RunLog&                log
+                            );
+  };
+}
@@ -0,0 +1,391 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <string.h>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "BMPImage.h"
+#include "KKStr.h"
+#include "OSservices.h"
+#include "Raster.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "FeatureCache.h"
+#include "FeatureFileIO.h"
+#include "FeatureVector.h"
+#include "GrayScaleImagesFVProducer.h"
+#include "MLClass.h"
+using namespace KKMLL;
+
+#include "ReSinkTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+    private:
+      kkuint32  state;
+    };
+  }
+
+
+
+  ReSinkTest::ReSinkTest ():
+    mlClasses (),
+    rootDir   ()
+  {
+    rootDir = osAddSlash (KKStr (std::filesystem::temp_directory_path ().string ())) + "KKMachineLearningTests_ReSink_" + StrFromInt32 (osGetProcessId ());
+  }
+
+
+
+  ReSinkTest::~ReSinkTest ()
+  {
+    std::error_code  ec;
+    std::filesystem::remove_all (rootDir.Str (), ec);
+  }
+
+
+
+  RasterPtr  ReSinkTest::RandomImage (kkint32   height,
+                                      kkint32   width,
+                                      kkuint32  seed
+                                     )
+  {
+    TestRandom  r (seed);
+    RasterPtr  image = new Raster (height, width, false);
+    kkint32  numBlobs = 1 + (kkint32)(r.Next () % 4);
+    for  (kkint32 b = 0;  b < numBlobs;  ++b)
+    {
+      kkint32  centerRow = (kkint32)(r.Next () % (kkuint32)height);
+      kkint32  centerCol = (kkint32)(r.Next () % (kkuint32)width);
+      kkint32  radius    = 2 + (kkint32)(r.Next () % (kkuint32)(Min (height, width) / 3));
+      for  (kkint32 row = Max (0, centerRow - radius);  row < Min (height, centerRow + radius);  ++row)
+      {
+        for  (kkint32 col = Max (0, centerCol - radius);  col < Min (width, centerCol + radius);  ++col)
+        {
+          kkint32  dr = row - centerRow;
+          kkint32  dc = col - centerCol;
+          if  ((dr * dr + dc * dc) <= (radius * radius))
+            image->SetPixelValue (row, col, (uchar)(1 + r.Next () % 255));
+        }
+      }
+    }
+    return  image;
+  }  /* RandomImage */
+
+
+
+  void  ReSinkTest::SaveImage (const Raster&  image,
+                               const KKStr&   fileName
+                              )
+  {
+    BmpImage  bmp (image);
+    bmp.Save (fileName);
+  }
+
+
+
+  void  ReSinkTest::WriteImages (const KKStr&  dirName,
+                                 kkuint32      count,
+                                 kkuint32      seed
+                                )
+  {
+    osCreateDirectoryPath (dirName);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      RasterPtr  image = RandomImage (20 + (kkint32)((seed + x * 7) % 40), 20 + (kkint32)((seed + x * 13) % 50), seed * 1000 + x);
+      SaveImage (*image, osAddSlash (dirName) + "Image_" + StrFormatInt ((kkint32)x, "000") + ".bmp");
+      delete  image;
+    }
+  }  /* WriteImages */
+
+
+
+  FeatureVectorListPtr  ReSinkTest::ReSink (const KKStr&  dirName,
+                                            kkuint32      loadThreads,
+                                            kkuint32&     numComputed,
+                                            RunLog&       log
+                                           )
+  {
+    FactoryFVProducerPtr  factory = GrayScaleImagesFVProducerFactory::Factory (&log);
+
+    numComputed = 0;
+    kkuint32  priorLoadThreads = FeatureFileIO::LoadThreads ();
+    FeatureFileIO::ReSinkProgress ([&numComputed](const KKStr&, kkuint32, kkuint32) {++numComputed;});
+    FeatureFileIO::LoadThreads (loadThreads);
+
+    volatile bool  cancelFlag  = false;
+    bool           changesMade = false;
+    DateTime       timeStamp;
+    FeatureVectorListPtr  examples
+      = factory->DefaultFeatureFileIO ()->FeatureDataReSink (factory,
+                                                             dirName,
+                                                             osGetRootNameOfDirectory (dirName) + ".data",
+                                                             mlClasses.GetMLClassPtr ("ReSinkClass"),
+                                                             true,
+                                                             mlClasses,
+                                                             cancelFlag,
+                                                             changesMade,
+                                                             timeStamp,
+                                                             log
+                                                            );
+
+    FeatureFileIO::ReSinkProgress (FeatureFileIO::ReSinkProgressFunc ());
+    FeatureFileIO::LoadThreads (priorLoadThreads);
+    return  examples;
+  }  /* ReSink */
+
+
+
+  bool  ReSinkTest::SameFeatures (const FeatureVector&  left,
+                                  const FeatureVector&  right
+                                 )
+  {
+    if  (left.NumOfFeatures () != right.NumOfFeatures ())
+      return  false;
+    return  memcmp (left.FeatureDataConst (), right.FeatureDataConst (), left.NumOfFeatures () * sizeof (float)) == 0;
+  }
+
+
+
+  FeatureVectorPtr  ReSinkTest::FindExample (FeatureVectorList&  examples,
+                                             const KKStr&        rootName
+                                            )
+  {
+    for  (auto  example: examples)
+    {
+      if  (osGetRootName (example->ExampleFileName ()) == rootName)
+        return  example;
+    }
+    return  NULL;
+  }
+
+
+
+  bool  ReSinkTest::SameExamples (const FeatureVectorList&  left,
+                                  const FeatureVectorList&  right,
+                                  KKStr&                    diff
+                                 )
+  {
+    if  (left.QueueSize () != right.QueueSize ())
+    {
+      diff = "Sizes " + StrFromUint32 (left.QueueSize ()) + " and " + StrFromUint32 (right.QueueSize ());
+      return  false;
+    }
+
+    for  (kkuint32 x = 0;  x < left.QueueSize ();  ++x)
+    {
+      const FeatureVector&  l = *(left.IdxToPtr (x));
+      const FeatureVector&  r = *(right.IdxToPtr (x));
+      if  (l.ExampleFileName () != r.ExampleFileName ())
+      {
+        diff = "Entry " + StrFromUint32 (x) + " names " + l.ExampleFileName () + " and " + r.ExampleFileName ();
+        return  false;
+      }
+      if  (!SameFeatures (l, r))
+      {
+        diff = "Features of " + l.ExampleFileName ();
+        return  false;
+      }
+    }
+    return  true;
+  }  /* SameExamples */
+
+
+
+  void  ReSinkTest::TestOrder ()
+  {
+    // Separate directories so that the second run can not use what the first one wrote.
+    KKStr  dirOne  = osAddSlash (rootDir) + "OrderOne";
+    KKStr  dirFour = osAddSlash (rootDir) + "OrderFour";
+    WriteImages (dirOne,  60, 11);
+    WriteImages (dirFour, 60, 11);
+
+    RunLog  log;
+    kkuint32  computedOne = 0, computedFour = 0;
+    FeatureVectorListPtr  one  = ReSink (dirOne,  1, computedOne,  log);
+    FeatureCache::FinalCleanUp ();
+    FeatureVectorListPtr  four = ReSink (dirFour, 4, computedFour, log);
+
+    KKStr  diff;
+    Assert (computedOne  == 60, "Order", "One thread computed: "   + StrFromUint32 (computedOne));
+    Assert (computedFour == 60, "Order", "Four threads computed: " + StrFromUint32 (computedFour));
+    Assert (SameExamples (*one, *four, diff), "Order", "1 vs 4 LoadThreads: " + diff);
+
+    bool  sorted = true;
+    for  (kkuint32 x = 1;  x < one->QueueSize ();  ++x)
+      sorted = sorted  &&  (one->IdxToPtr (x - 1)->ExampleFileName () < one->IdxToPtr (x)->ExampleFileName ());
+    Assert (sorted, "Order", "Examples are not in directory order.");
+
+    delete  one;
+    delete  four;
+  }  /* TestOrder */
+
+
+
+  void  ReSinkTest::TestSideCar ()
+  {
+    KKStr  dirName = osAddSlash (rootDir) + "Cache";
+    WriteImages (dirName, 30, 23);
+    FeatureCache::FinalCleanUp ();
+
+    RunLog  log;
+    kkuint32  computed = 0;
+    FeatureVectorListPtr  first = ReSink (dirName, 2, computed, log);
+    Assert (computed == 30, "SideCar", "First run computed: " + StrFromUint32 (computed));
+
+    // Unchanged directory, both with the index populated and as a new process would see it.
+    for  (int pass = 0;  pass < 2;  ++pass)
+    {
+      KKStr  passName = (pass == 0) ? "Unchanged" : "Unchanged after FinalCleanUp";
+      if  (pass == 1)
+        FeatureCache::FinalCleanUp ();
+
+      ostringstream  logText;
+      RunLog  captureLog (logText);
+      captureLog.SetLevel (20);
+      FeatureVectorListPtr  again = ReSink (dirName, 2, computed, captureLog);
+      KKStr  diff;
+      Assert (computed == 0, "SideCar", passName + " computed: " + StrFromUint32 (computed));
+      Assert (logText.str ().find ("examples from side car") != string::npos, "SideCar", passName + " parsed the feature file.");
+      Assert (SameExamples (*first, *again, diff), "SideCar", passName + ": " + diff);
+      delete  again;
+    }
+    delete  first;
+  }  /* TestSideCar */
+
+
+
+  void  ReSinkTest::TestRenameAndModify ()
+  {
+    KKStr  dirName = osAddSlash (rootDir) + "Changes";
+    WriteImages (dirName, 20, 37);
+    FeatureCache::FinalCleanUp ();
+
+    RunLog  log;
+    kkuint32  computed = 0;
+    FeatureVectorListPtr  before = ReSink (dirName, 2, computed, log);
+    Assert (computed == 20, "Rename", "First run computed: " + StrFromUint32 (computed));
+
+    std::error_code  ec;
+    std::filesystem::rename ((osAddSlash (dirName) + "Image_005.bmp").Str (), (osAddSlash (dirName) + "Renamed_005.bmp").Str (), ec);
+    FeatureVectorListPtr  renamed = ReSink (dirName, 2, computed, log);
+    Assert (computed == 0, "Rename", "Renamed image computed: " + StrFromUint32 (computed));
+    FeatureVectorPtr  original   = FindExample (*before,  "Image_005");
+    FeatureVectorPtr  renamedFv  = FindExample (*renamed, "Renamed_005");
+    Assert ((original != NULL)  &&  (renamedFv != NULL)  &&  SameFeatures (*original, *renamedFv), "Rename", "Renamed image did not keep its features.");
+    Assert (FindExample (*renamed, "Image_005") == NULL, "Rename", "Old name is still in the list.");
+    Assert (renamed->QueueSize () == 20, "Rename", "Examples: " + StrFromUint32 (renamed->QueueSize ()));
+
+    // A different size guarantees the side car's size and time check can not take the old entry.
+    RasterPtr  modifiedImage = RandomImage (71, 83, 991);
+    KKStr  modifiedFileName = osAddSlash (dirName) + "Image_010.bmp";
+    SaveImage (*modifiedImage, modifiedFileName);
+    delete  modifiedImage;
+    modifiedImage = NULL;
+
+    FeatureVectorListPtr  modified = ReSink (dirName, 2, computed, log);
+    Assert (computed == 1, "Modify", "Modified image computed: " + StrFromUint32 (computed));
+
+    FactoryFVProducerPtr  factory = GrayScaleImagesFVProducerFactory::Factory (&log);
+    FeatureVectorProducerPtr  producer = factory->ManufactureInstance (log);
+    FeatureVectorPtr  direct = producer->ComputeFeatureVectorFromImage (modifiedFileName, mlClasses.GetMLClassPtr ("ReSinkClass"), NULL, log);
+    FeatureVectorPtr  modifiedFv = FindExample (*modified, "Image_010");
+    Assert ((direct != NULL)  &&  (modifiedFv != NULL)  &&  SameFeatures (*direct, *modifiedFv), "Modify", "Features differ from computing the image directly.");
+
+    bool  othersSame = true;
+    for  (auto  example: *modified)
+    {
+      KKStr  rootName = osGetRootName (example->ExampleFileName ());
+      if  (rootName == "Image_010")
+        continue;
+      FeatureVectorPtr  prior = FindExample (*renamed, rootName);
+      othersSame = othersSame  &&  (prior != NULL)  &&  SameFeatures (*prior, *example);
+    }
+    Assert (othersSame, "Modify", "Unmodified images changed.");
+
+    delete  direct;
+    delete  producer;
+    delete  before;
+    delete  renamed;
+    delete  modified;
+  }  /* TestRenameAndModify */
+
+
+
+  void  ReSinkTest::TestCrossDirectory ()
+  {
+    KKStr  sourceDir = osAddSlash (rootDir) + "CrossSource";
+    KKStr  copyDir   = osAddSlash (rootDir) + "CrossCopy";
+    WriteImages (sourceDir, 15, 51);
+    FeatureCache::FinalCleanUp ();
+
+    RunLog  log;
+    kkuint32  computed = 0;
+    FeatureVectorListPtr  source = ReSink (sourceDir, 2, computed, log);
+
+    // The copies are found by content in the index, only the two new images are computed.
+    osCreateDirectoryPath (copyDir);
+    std::error_code  ec;
+    for  (kkuint32 x = 0;  x < 15;  x += 2)
+    {
+      KKStr  name = "Image_" + StrFormatInt ((kkint32)x, "000") + ".bmp";
+      std::filesystem::copy_file ((osAddSlash (sourceDir) + name).Str (), (osAddSlash (copyDir) + "Copy_" + name).Str (), ec);
+    }
+    for  (kkuint32 x = 0;  x < 2;  ++x)
+    {
+      RasterPtr  image = RandomImage (33 + (kkint32)x, 45, 7000 + x);
+      SaveImage (*image, osAddSlash (copyDir) + "New_" + StrFormatInt ((kkint32)x, "000") + ".bmp");
+      delete  image;
+    }
+
+    FeatureVectorListPtr  copies = ReSink (copyDir, 2, computed, log);
+    Assert (computed == 2, "CrossDirectory", "Computed: " + StrFromUint32 (computed));
+    Assert (copies->QueueSize () == 10, "CrossDirectory", "Examples: " + StrFromUint32 (copies->QueueSize ()));
+
+    bool  copiesSame = true;
+    for  (kkuint32 x = 0;  x < 15;  x += 2)
+    {
+      KKStr  name = "Image_" + StrFormatInt ((kkint32)x, "000");
+      FeatureVectorPtr  original = FindExample (*source, name);
+      FeatureVectorPtr  copy     = FindExample (*copies, "Copy_" + name);
+      copiesSame = copiesSame  &&  (original != NULL)  &&  (copy != NULL)  &&  SameFeatures (*original, *copy);
+    }
+    Assert (copiesSame, "CrossDirectory", "Copied images do not have the features of the originals.");
+
+    delete  source;
+    delete  copies;
+  }  /* TestCrossDirectory */
+
+
+
+  bool  ReSinkTest::RunTests ()
+  {
+    TestOrder ();
+    TestSideCar ();
+    TestRenameAndModify ();
+    TestCrossDirectory ();
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "FeatureVector.h"
+#include "MLClass.h"
+#include "Raster.h"
+#include "RunLog.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks 'FeatureFileIO::FeatureDataReSink' on directories of generated images.
+   *@details  The list returned has to be in the same order with the same features however many 'LoadThreads'
+   * are used.  The side car has to let an unchanged directory be read without computing or parsing anything, a
+   * renamed image or one copied to another directory has to get its features back, and a modified one has to
+   * be computed again.
+   */
+  class ReSinkTest : public KKTest
+  {
+  public:
+    ReSinkTest ();
+
+    virtual ~ReSinkTest ();
+
+    virtual const char*  TestName () const { return "ReSink"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  Gray-scale image with a few random blobs so that its features are not all zero. */
+    static  RasterPtr  RandomImage (kkint32   height,
+                                    kkint32   width,
+                                    kkuint32  seed
+                                   );
+
+    static  void  SaveImage (const Raster&  image,
+                             const KKStr&   fileName
+                            );
+
+    /** @brief  Writes 'count' images to 'dirName' named "Image_000.bmp" ... */
+    static  void  WriteImages (const KKStr&  dirName,
+                               kkuint32      count,
+                               kkuint32      seed
+                              );
+
+    /** @brief  Returns 'FeatureDataReSink' on 'dirName';  'numComputed' is set to the number of images it computed features for. */
+    FeatureVectorListPtr  ReSink (const KKStr&  dirName,
+                                  kkuint32      loadThreads,
+                                  kkuint32&     numComputed,
+                                  RunLog&       log
+                                 );
+
+    /** @brief  The example in 'examples' whose file name has root name 'rootName';  NULL if there is none. */
+    static  FeatureVectorPtr  FindExample (FeatureVectorList&  examples,
+                                           const KKStr&        rootName
+                                          );
+
+    /** @brief  True when both lists have the same examples, by name, in the same order with identical features. */
+    static  bool  SameExamples (const FeatureVectorList&  left,
+                                const FeatureVectorList&  right,
+                                KKStr&                    diff
+                               );
+
+    static  bool  SameFeatures (const FeatureVector&  left,
+                                const FeatureVector&  right
+                               );
+
+    void  TestCrossDirectory ();
+
+    void  TestOrder ();
+
+    void  TestRenameAndModify ();
+
+    void  TestSideCar ();
+
+    MLClassList  mlClasses;
+    KKStr        rootDir;
+  };
+}
@@ -0,0 +1,303 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <atomic>
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+using namespace KKB;
+
+#include "svm.h"
+using namespace KKMLL;
+
+#include "SvmTrainingTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+      /** @brief  Uniform in [-scale, scale). */
+      double  Symmetric (double  scale)  {return  (NextDouble () * 2.0 - 1.0) * scale;}
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const  kkint32  numFeatures = 6;
+  }
+
+
+
+  SvmTrainingTest::SvmTrainingTest ():
+    nodes (),
+    x     (),
+    y     (),
+    index (),
+    prob  (),
+    param ()
+  {
+    param.svm_type    = SVM233::C_SVC;
+    param.kernel_type = SVM233::RBF;
+    param.gamma       = 0.2;
+    param.C           = 10.0;
+    param.cache_size  = 1.0;
+  }
+
+
+
+  SvmTrainingTest::~SvmTrainingTest ()
+  {
+  }
+
+
+
+  void  SvmTrainingTest::BuildProblem (kkint32  count,
+                                       kkint32  numClasses,
+                                       kkuint32 seed
+                                      )
+  {
+    TestRandom  r (seed);
+
+    vector<vector<double>>  centers (numClasses);
+    for  (auto&  center: centers)
+      for  (kkint32 f = 0;  f < numFeatures;  ++f)
+        center.push_back (r.Symmetric (2.0));
+
+    nodes.assign (count, vector<SVM233::svm_node> ());
+    x.assign (count, NULL);
+    y.assign (count, 0.0);
+    index.assign (count, 0);
+    for  (kkint32 i = 0;  i < count;  ++i)
+    {
+      kkint32  classIdx = (kkint32)(r.Next () % (kkuint32)numClasses);
+      for  (kkint32 f = 0;  f < numFeatures;  ++f)
+      {
+        SVM233::svm_node  n;
+        n.index = (kkint16)(f + 1);
+        n.value = centers[classIdx][f] + r.Symmetric (1.5);
+        nodes[i].push_back (n);
+      }
+      nodes[i].push_back (SVM233::svm_node ());
+      x[i]     = nodes[i].data ();
+      y[i]     = (double)classIdx;
+      index[i] = i;
+    }
+
+    prob.l     = count;
+    prob.x     = x.data ();
+    prob.y     = y.data ();
+    prob.index = index.data ();
+    prob.W     = NULL;
+  }  /* BuildProblem */
+
+
+
+  bool  SvmTrainingTest::SameModel (const SVM233::SvmModel233&  left,
+                                    const SVM233::SvmModel233&  right
+                                   )
+  {
+    if  ((left.nr_class != right.nr_class)  ||  (left.l != right.l))
+      return  false;
+
+    kkuint32  numPairs = left.nr_class * (left.nr_class - 1) / 2;
+    for  (kkuint32 p = 0;  p < numPairs;  ++p)
+    {
+      if  (left.rho[p] != right.rho[p])
+        return  false;
+    }
+
+    for  (kkuint32 c = 0;  c < left.nr_class;  ++c)
+    {
+      if  ((left.label[c] != right.label[c])  ||  (left.nSV[c] != right.nSV[c]))
+        return  false;
+    }
+
+    for  (kkint32 i = 0;  i < left.l;  ++i)
+    {
+      // Both were trained from the same 'svm_problem' so the same support vector is the same pointer.
+      if  (left.SV[i] != right.SV[i])
+        return  false;
+      for  (kkuint32 c = 0;  c + 1 < left.nr_class;  ++c)
+      {
+        if  (left.sv_coef[c][i] != right.sv_coef[c][i])
+          return  false;
+      }
+    }
+    return  true;
+  }  /* SameModel */
+
+
+
+  void  SvmTrainingTest::TestThreads ()
+  {
+    BuildProblem (800, 5, 1);
+
+    SVM233::SvmModel233*  serial = SVM233::svm_train (&prob, &param, 1);
+    Assert (serial != NULL, "Threads", "svm_train returned NULL for 1 thread");
+
+    kkuint32  threadCounts[] = {2, 4};
+    for  (kkuint32 numThreads: threadCounts)
+    {
+      // Each pair has about 320 examples, a 400K kernel matrix;  a 1 MB budget lets only 2 train at the same time.
+      SVM233::SvmModel233*  parallel = SVM233::svm_train (&prob, &param, numThreads, 1);
+      KKStr  section = "Threads: " + StrFromUint32 (numThreads);
+      Assert (parallel != NULL, section, "svm_train returned NULL");
+      if  (serial  &&  parallel)
+        Assert (SameModel (*serial, *parallel), section, "Model differs from the one trained on 1 thread");
+      SVM233::svm_destroy_model (parallel);
+    }
+
+    SVM233::svm_destroy_model (serial);
+  }  /* TestThreads */
+
+
+
+  void  SvmTrainingTest::TestScheduled ()
+  {
+    vector<kkint32>  problemSizes = {5, 50, 20, 80, 10, 30, 60};
+    kkint32  numProblems = (kkint32)problemSizes.size ();
+
+    kkuint32  threadCounts[] = {1, 3};
+    for  (kkuint32 numThreads: threadCounts)
+    {
+      KKStr  section = "Scheduled threads: " + StrFromUint32 (numThreads);
+
+      // Cancelled once the last problem has started;  nothing was skipped.
+      {
+        vector<atomic<kkint32>>  calls (numProblems);
+        for  (auto&  c: calls)
+          c = 0;
+        atomic<kkint32>  started (0);
+        volatile bool    cancelFlag = false;
+
+        kkint32  numTrained = SVM233::svm_train_scheduled (problemSizes, 1.0, numThreads, 0, &cancelFlag, [&](kkint32 idx)
+          {
+            ++calls[idx];
+            if  (++started == numProblems)
+              cancelFlag = true;
+          }
+        );
+
+        kkint32  calledOnce = 0;
+        for  (auto&  c: calls)
+          if  (c == 1)  ++calledOnce;
+
+        Assert (calledOnce == numProblems, section, "Each problem has to be trained once;  trained once: " + StrFromInt32 (calledOnce));
+        Assert (numTrained == numProblems, section, "Cancelled after the last problem started;  reported trained: " + StrFromInt32 (numTrained));
+      }
+
+      // Cancelled by the first problem;  the ones that had not started yet are skipped.
+      {
+        atomic<kkint32>  started (0);
+        volatile bool    cancelFlag = false;
+
+        kkint32  numTrained = SVM233::svm_train_scheduled (problemSizes, 1.0, numThreads, 0, &cancelFlag, [&](kkint32)
+          {
+            ++started;
+            cancelFlag = true;
+          }
+        );
+
+        Assert (numTrained == started, section, "Reported trained: " + StrFromInt32 (numTrained) + "  called: " + StrFromInt32 (started));
+        Assert (numTrained < numProblems, section, "Cancelled by the first problem yet every problem was trained");
+      }
+    }
+  }  /* TestScheduled */
+
+
+
+  void  SvmTrainingTest::TestSharedCache ()
+  {
+    BuildProblem (400, 5, 3);
+
+    SVM233::SvmModel233*  reference = SVM233::svm_train (&prob, &param, 1);
+
+    kkuint32  threadCounts[] = {1, 3};
+    for  (kkuint32 numThreads: threadCounts)
+    {
+      KKStr  section = "SharedCache threads: " + StrFromUint32 (numThreads);
+
+      SVM233::SharedKernelCache  kernelCache (prob.l, 16.0);
+      SVM233::SvmModel233*  model = SVM233::svm_train (&prob, &param, numThreads, 0, &kernelCache);
+
+      Assert ((reference != NULL)  &&  (model != NULL), section, "svm_train returned NULL");
+      if  (reference  &&  model)
+      {
+        Assert (SameModel (*reference, *model), section, "Model differs from the one trained without the shared cache");
+
+        // 'svm_predict' fills in one distance per class pair without sizing 'dist'.
+        kkint32  numPairs = (kkint32)(model->nr_class * (model->nr_class - 1) / 2);
+        kkint32  differences = 0;
+        vector<double>   refDist (numPairs), dist (numPairs);
+        vector<kkint32>  refWinners, winners;
+        for  (kkint32 i = 0;  i < prob.l;  ++i)
+        {
+          SVM233::svm_predict (reference, prob.x[i], refDist, refWinners, -1);
+          SVM233::svm_predict (model,     prob.x[i], dist,    winners,    -1);
+          if  (refDist != dist)
+            ++differences;
+        }
+        Assert (differences == 0, section, StrFromInt32 (differences) + " examples with different decision values");
+      }
+
+      // Every example is in 4 of the 10 class pairs so some of the values one pair needs were computed for another.
+      // No row was dropped so no value was computed twice.
+      kkint64  maxMisses = (kkint64)prob.l * (kkint64)prob.l;
+      Assert (kernelCache.Evictions () == 0, section, "Evictions: " + StrFromInt64 (kernelCache.Evictions ()));
+      Assert ((kernelCache.Misses () > 0)  &&  (kernelCache.Misses () <= maxMisses), section, "Misses: " + StrFromInt64 (kernelCache.Misses ()));
+      Assert (kernelCache.Hits () > 0, section, "Hits: " + StrFromInt64 (kernelCache.Hits ()) + "  Misses: " + StrFromInt64 (kernelCache.Misses ()));
+
+      SVM233::svm_destroy_model (model);
+    }
+
+    SVM233::svm_destroy_model (reference);
+  }  /* TestSharedCache */
+
+
+
+  void  SvmTrainingTest::TestCancel ()
+  {
+    BuildProblem (120, 4, 2);
+
+    volatile bool  cancelFlag = true;
+    SVM233::SvmModel233*  model = SVM233::svm_train (&prob, &param, 2, 0, NULL, NULL, &cancelFlag);
+    Assert (model == NULL, "Cancel", "svm_train cancelled before it started returned a model");
+    SVM233::svm_destroy_model (model);
+
+    cancelFlag = false;
+    model = SVM233::svm_train (&prob, &param, 2, 0, NULL, NULL, &cancelFlag);
+    Assert (model != NULL, "Cancel", "svm_train that was never cancelled returned NULL");
+    SVM233::svm_destroy_model (model);
+  }  /* TestCancel */
+
+
+
+  bool  SvmTrainingTest::RunTests ()
+  {
+    TestThreads ();
+    TestScheduled ();
+    TestSharedCache ();
+    TestCancel ();
+    return  FailedCount () == 0;
+  }
+}
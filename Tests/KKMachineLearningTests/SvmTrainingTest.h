@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "svm.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks that SVM233 trains the same model no matter how many binary classifiers it trains at a time.
+   *@details  'svm_train' is run on 1 and several threads and the support vectors, coefficients and 'rho' of the
+   * two models have to be exactly the same.  'svm_train_scheduled' has to call every problem once and report
+   * them all as trained when 'cancelFlag' is only set after the last one has started;  'svm_train' has to return
+   * NULL when cancelled before it starts.  A model trained with a 'SharedKernelCache' has to give exactly the
+   * decision values of one trained without it and the cache has to have found some kernel values computed for
+   * other binary classifiers.
+   */
+  class SvmTrainingTest : public KKTest
+  {
+  public:
+    SvmTrainingTest ();
+
+    virtual ~SvmTrainingTest ();
+
+    virtual const char*  TestName () const { return "SvmTraining"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  'count' dense examples over 'numClasses' classes, each class a cloud around its own center. */
+    void  BuildProblem (kkint32  count,
+                        kkint32  numClasses,
+                        kkuint32 seed
+                       );
+
+    /** @brief  True when 'left' and 'right' have the same support vectors, coefficients and 'rho'. */
+    static  bool  SameModel (const SVM233::SvmModel233&  left,
+                             const SVM233::SvmModel233&  right
+                            );
+
+    void  TestCancel ();
+
+    void  TestScheduled ();
+
+    void  TestSharedCache ();
+
+    void  TestThreads ();
+
+    std::vector<std::vector<SVM233::svm_node>>  nodes;
+    std::vector<SVM233::svm_node*>              x;
+    std::vector<double>                         y;
+    std::vector<kkint32>                        index;
+    SVM233::svm_problem                         prob;
+    SVM233::svm_parameter                       param;
+  };
+}
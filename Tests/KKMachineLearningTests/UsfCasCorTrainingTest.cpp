@@ -0,0 +1,251 @@
+#include "FirstIncludes.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include "MemoryDebug.h"
+using namespace std;
+
+#include "KKBaseTypes.h"
+#include "KKStr.h"
+#include "RunLog.h"
+using namespace KKB;
+
+#include "FeatureNumList.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "ModelParamUsfCasCor.h"
+#include "UsfCasCor.h"
+using namespace KKMLL;
+
+#include "UsfCasCorTrainingTest.h"
+
+
+namespace  KKMachineLearningTest
+{
+  namespace
+  {
+    class  TestRandom
+    {
+    public:
+      TestRandom (kkuint32  seed): state (seed * 2654435761u + 1u)  {}
+
+      kkuint32  Next ()
+      {
+        state = state * 1664525u + 1013904223u;
+        return  state >> 8;
+      }
+
+      /** @brief  Uniform in [0, 1). */
+      double  NextDouble ()  {return  (double)Next () / (double)(1u << 24);}
+
+      /** @brief  Uniform in [-scale, scale). */
+      double  Symmetric (double  scale)  {return  (NextDouble () * 2.0 - 1.0) * scale;}
+
+    private:
+      kkuint32  state;
+    };
+
+
+    const  kkuint32  numFeatures = 6;
+
+    /** @brief  Several of the 256 case shards 'UsfCasCor' splits a pass over the training examples into. */
+    const  kkuint32  numTrainExamples = 1100;
+
+    const  kkuint32  numTestExamples = 300;
+
+    const  kkuint32  numThreads = 4;
+  }
+
+
+
+  UsfCasCorTrainingTest::UsfCasCorTrainingTest ():
+    fileDesc  (NULL),
+    mlClasses ()
+  {
+    VectorKKStr  fieldNames;
+    for  (kkuint32 x = 0;  x < numFeatures;  ++x)
+      fieldNames.push_back ("Field_" + StrFromUint32 (x));
+    fileDesc = FileDesc::NewContinuousDataOnly (fieldNames);
+
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("UsfCasCorTraining_A"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("UsfCasCorTraining_B"));
+    mlClasses.PushOnBack (MLClass::CreateNewMLClass ("UsfCasCorTraining_C"));
+  }
+
+
+
+  UsfCasCorTrainingTest::~UsfCasCorTrainingTest ()
+  {
+  }
+
+
+
+  FeatureVectorListPtr  UsfCasCorTrainingTest::RandomExamples (kkuint32  count,
+                                                               kkuint32  seed
+                                                              )
+  {
+    TestRandom  r (seed);
+    kkuint32  numClasses = mlClasses.QueueSize ();
+
+    FeatureVectorListPtr  examples = new FeatureVectorList (fileDesc, true);
+    for  (kkuint32 x = 0;  x < count;  ++x)
+    {
+      kkuint32  classIdx = x % numClasses;
+      FeatureVectorPtr  fv = new FeatureVector (numFeatures);
+      float*  featureData = fv->FeatureDataAlter ();
+      // The clouds overlap so that the network needs hidden units and the probabilities stay away from 0 and 1.
+      for  (kkuint32 f = 0;  f < numFeatures;  ++f)
+        featureData[f] = (float)(((f % numClasses) == classIdx ? 1.5 : 0.0) + r.Symmetric (2.0));
+      fv->MLClass (mlClasses.IdxToPtr (classIdx));
+      fv->ExampleFileName ("Example_" + StrFromUint32 (seed) + "_" + StrFromUint32 (x) + ".bmp");
+      examples->PushOnBack (fv);
+    }
+    return  examples;
+  }
+
+
+
+  ModelParamUsfCasCorPtr  UsfCasCorTrainingTest::ParseParameters (const KKStr&  cmdLine,
+                                                                  RunLog&       log
+                                                                 )
+  {
+    bool  validFormat = false;
+    ModelParamUsfCasCor  parsed;
+    parsed.ParseCmdLine (cmdLine, validFormat, log);
+    if  (!validFormat)
+      return  NULL;
+
+    ModelParamUsfCasCorPtr  reparsed = new ModelParamUsfCasCor ();
+    reparsed->ParseCmdLine (parsed.ToCmdLineStr (), validFormat, log);
+    if  ((!validFormat)  ||  (reparsed->NumThreads () != parsed.NumThreads ()))
+    {
+      delete  reparsed;
+      reparsed = NULL;
+    }
+    return  reparsed;
+  }  /* ParseParameters */
+
+
+
+  void  UsfCasCorTrainingTest::TestNumThreadsParameter (RunLog&  log)
+  {
+    struct  {const char*  cmdLine;  kkuint32  expected;}  cases[] =
+    {
+      {"-InLimit 20 -OutLimit 20",                  1},
+      {"-InLimit 20 -OutLimit 20 -NumThreads 4",    4},
+      {"-InLimit 20 -OutLimit 20 -Threads 3",       3},
+      {"-InLimit 20 -OutLimit 20 -numthreads 0",    0},
+    };
+
+    for  (auto&  c: cases)
+    {
+      ModelParamUsfCasCorPtr  param = ParseParameters (c.cmdLine, log);
+      KKStr  msg;
+      msg << "CmdLine[" << c.cmdLine << "]";
+      if  (param)
+        msg << "  NumThreads[" << param->NumThreads () << "]  ToCmdLineStr[" << param->ToCmdLineStr () << "]";
+      Assert ((param != NULL)  &&  (param->NumThreads () == c.expected), "NumThreadsParameter", msg);
+      delete  param;
+      param = NULL;
+    }
+  }  /* TestNumThreadsParameter */
+
+
+
+  void  UsfCasCorTrainingTest::TestThreads (RunLog&  log)
+  {
+    ModelParamUsfCasCorPtr  serialParam   = ParseParameters ("-InLimit 30 -OutLimit 30 -R 4 -T 1 -S 17 -UseCache Yes", log);
+    ModelParamUsfCasCorPtr  parallelParam = ParseParameters ("-InLimit 30 -OutLimit 30 -R 4 -T 1 -S 17 -UseCache Yes -NumThreads " + StrFromUint32 (numThreads), log);
+    Assert ((serialParam != NULL)  &&  (parallelParam != NULL), "Threads", "Parameters not valid");
+    if  ((!serialParam)  ||  (!parallelParam))
+    {
+      delete  serialParam;
+      delete  parallelParam;
+      return;
+    }
+
+    bool  cancelFlag = false;
+    FeatureNumList  selectedFeatures = FeatureNumList::AllFeatures (fileDesc);
+
+    // 'TrainNewClassifier' keeps pointers into the training examples;  each network gets its own.
+    FeatureVectorListPtr  trainSerial   = RandomExamples (numTrainExamples, 1);
+    FeatureVectorListPtr  trainParallel = RandomExamples (numTrainExamples, 1);
+
+    vector<UsfCasCorPtr>           networks;
+    vector<ModelParamUsfCasCorPtr> params = {serialParam, parallelParam};
+    vector<FeatureVectorListPtr>   trainData = {trainSerial, trainParallel};
+    for  (kkuint32 x = 0;  x < params.size ();  ++x)
+    {
+      UsfCasCorPtr  network = new UsfCasCor ();
+      network->TrainNewClassifier (params[x]->In_limit         (),
+                                   params[x]->Out_limit        (),
+                                   params[x]->Number_of_rounds (),
+                                   params[x]->Number_of_trials (),
+                                   params[x]->Random_seed      (),
+                                   params[x]->UseCache         (),
+                                   params[x]->NumThreads       (),
+                                   trainData[x],
+                                   &selectedFeatures,
+                                   cancelFlag,
+                                   log
+                                  );
+      networks.push_back (network);
+    }
+
+    VectorFloat  weights1 = networks[0]->NetworkWeights ();
+    VectorFloat  weightsN = networks[1]->NetworkWeights ();
+    KKStr  msg;
+    msg << "Weights  1 thread[" << (kkuint32)weights1.size () << "]  " << numThreads << " threads[" << (kkuint32)weightsN.size () << "]";
+    Assert ((!weights1.empty ())  &&  (weights1 == weightsN), "Threads", msg);
+
+    FeatureVectorListPtr  testExamples = RandomExamples (numTestExamples, 2);
+    kkuint32  classMismatches = 0, probMismatches = 0, correct = 0;
+    for  (kkuint32 x = 0;  x < numTestExamples;  ++x)
+    {
+      FeatureVectorPtr  example = testExamples->IdxToPtr (x);
+      MLClassPtr    predClass1[2] = {NULL, NULL};
+      MLClassPtr    predClass2[2] = {NULL, NULL};
+      float         predClass1Prob[2], predClass2Prob[2], knownClassProb[2];
+      VectorFloat   probabilities[2];
+      for  (kkuint32 n = 0;  n < 2;  ++n)
+        networks[n]->PredictConfidences (example, example->MLClass (), predClass1[n], predClass1Prob[n], predClass2[n],
+                                         predClass2Prob[n], knownClassProb[n], mlClasses, probabilities[n]
+                                        );
+
+      if  ((predClass1[0] != predClass1[1])  ||  (predClass2[0] != predClass2[1]))
+        ++classMismatches;
+      if  ((probabilities[0] != probabilities[1])  ||  (knownClassProb[0] != knownClassProb[1]))
+        ++probMismatches;
+      if  (predClass1[0] == example->MLClass ())
+        ++correct;
+    }
+    Assert (classMismatches == 0, "Threads", StrFromUint32 (classMismatches) + " predictions differ between 1 and " + StrFromUint32 (numThreads) + " threads");
+    Assert (probMismatches  == 0, "Threads", StrFromUint32 (probMismatches)  + " probabilities differ between 1 and " + StrFromUint32 (numThreads) + " threads");
+
+    // A network that predicts nothing useful would pass the comparisons trivially.
+    Assert (correct * 2 > numTestExamples, "Threads", "Only " + StrFromUint32 (correct) + " of " + StrFromUint32 (numTestExamples) + " predicted correctly");
+
+    for  (auto  network: networks)
+      delete  network;
+    delete  testExamples;   testExamples  = NULL;
+    delete  trainSerial;    trainSerial   = NULL;
+    delete  trainParallel;  trainParallel = NULL;
+    delete  serialParam;    serialParam   = NULL;
+    delete  parallelParam;  parallelParam = NULL;
+  }  /* TestThreads */
+
+
+
+  bool  UsfCasCorTrainingTest::RunTests ()
+  {
+    RunLog  log;
+    log.SetLoggingLevel (-1);
+
+    TestNumThreadsParameter (log);
+    TestThreads (log);
+
+    return  FailedCount () == 0;
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include "KKTest.h"
+#include "FeatureVector.h"
+#include "FileDesc.h"
+#include "MLClass.h"
+#include "ModelParamUsfCasCor.h"
+#include "RunLog.h"
+using namespace KKMLL;
+
+namespace  KKMachineLearningTest
+{
+  using  KKBaseTest::KKTest;
+
+  /**
+   *@brief  Checks that 'UsfCasCor' trains the same network no matter how many threads share the passes.
+   *@details  The parameters are parsed from a command line with '-NumThreads' and have to come back the same
+   * through 'ToCmdLineStr'.  A network trained on 1 thread and one trained on several from the same seed have to
+   * have exactly the same weights and give exactly the same predictions and probabilities on examples that were
+   * not trained on.
+   */
+  class UsfCasCorTrainingTest : public KKTest
+  {
+  public:
+    UsfCasCorTrainingTest ();
+
+    virtual ~UsfCasCorTrainingTest ();
+
+    virtual const char*  TestName () const { return "UsfCasCorTraining"; }
+
+    bool  RunTests () override;
+
+  private:
+    /** @brief  'count' examples spread over 'mlClasses', each class a cloud of points around its own center. */
+    FeatureVectorListPtr  RandomExamples (kkuint32  count,
+                                          kkuint32  seed
+                                         );
+
+    /** @brief  Parses 'cmdLine' and then parses what 'ToCmdLineStr' writes for it;  NULL if either is not valid. */
+    ModelParamUsfCasCorPtr  ParseParameters (const KKStr&  cmdLine,
+                                             RunLog&       log
+                                            );
+
+    void  TestNumThreadsParameter (RunLog&  log);
+
+    void  TestThreads (RunLog&  log);
+
+    FileDescConstPtr  fileDesc;
+    MLClassList       mlClasses;
+  };
+}